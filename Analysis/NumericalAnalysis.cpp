@@ -28,11 +28,60 @@ namespace NumericalAnalysis {
         if (linearSystem->solution == nullptr) {
             throw runtime_error("Linear System has not been solved");
         }
+        auto &permutation = linearSystem->permutation;
         for (auto i = 0; i < degreesOfFreedom->freeDegreesOfFreedom->size(); i++) {
-            degreesOfFreedom->freeDegreesOfFreedom->at(i)->setValue(linearSystem->solution->at(i));
+            //The i-th unknown of a reordered system belongs to the permutation[i]-th free degree of freedom
+            auto dofIndex = (permutation == nullptr) ? i : permutation->at(i);
+            degreesOfFreedom->freeDegreesOfFreedom->at(dofIndex)->setValue(linearSystem->solution->at(i));
         }
     }
 
+    void NumericalAnalysis::reorderLinearSystem(NumericalMatrixReorderingType reorderingType, bool printReport) {
+        if (linearSystem == nullptr) {
+            throw runtime_error("Linear System has not been initialized");
+        }
+        if (reorderingType == NoReordering) {
+            return;
+        }
+        auto availableThreads = std::max(1u, std::thread::hardware_concurrency());
+        auto csrMatrix = linearSystem->getCSRMatrix(availableThreads);
+        
+        vector<unsigned> permutation;
+        switch (reorderingType) {
+            case ReverseCuthillMcKee:
+                permutation = NumericalMatrixReordering<double>::reverseCuthillMcKee(*csrMatrix);
+                break;
+            case Morton: {
+                //Free DOFs in the current numbering of the system
+                auto coordinates = vector<vector<double>>(linearSystem->rhs->size());
+                for (unsigned i = 0; i < coordinates.size(); i++) {
+                    auto dofIndex = (linearSystem->permutation == nullptr) ? i : linearSystem->permutation->at(i);
+                    auto node = mesh->nodeFromID(degreesOfFreedom->freeDegreesOfFreedom->at(dofIndex)->parentNode());
+                    coordinates[i] = node->coordinates.positionVector();
+                }
+                permutation = NumericalMatrixReordering<double>::morton(coordinates);
+                break;
+            }
+            default:
+                throw invalid_argument("Unknown reordering type");
+        }
+        
+        if (printReport) {
+            auto reorderedMatrix = NumericalMatrixReordering<double>::permute(*csrMatrix, permutation);
+            auto bandwidthBefore = NumericalMatrixReordering<double>::bandwidth(*csrMatrix);
+            auto bandwidthAfter = NumericalMatrixReordering<double>::bandwidth(*reorderedMatrix);
+            auto spmvTimeBefore = NumericalMatrixReordering<double>::spmvTime(*csrMatrix);
+            auto spmvTimeAfter = NumericalMatrixReordering<double>::spmvTime(*reorderedMatrix);
+            cout << " " << endl;
+            cout << "----------------------------------------" << endl;
+            cout << (reorderingType == ReverseCuthillMcKee ? "Reverse Cuthill-McKee" : "Morton") << " Reordering" << endl;
+            cout << "Bandwidth : " << bandwidthBefore << " -> " << bandwidthAfter << endl;
+            cout << "CSR SpMV time : " << spmvTimeBefore << " μs -> " << spmvTimeAfter << " μs" << endl;
+            cout << "----------------------------------------" << endl;
+        }
+        linearSystem->reorder(permutation);
+    }
+
     vector<double> NumericalAnalysis::getSolutionAtNode(vector<double> &nodeCoordinates, double tolerance) const {
         switch (nodeCoordinates.size()) {
             case 1:
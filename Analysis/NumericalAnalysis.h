@@ -11,6 +11,7 @@
 #include "AnalysisDOFs/AnalysisDegreesOfFreedom.h"
 #include "../LinearAlgebra/Solvers/Solver.h"
 #include "../Utility/Exporters/Exporters.h"
+#include "../LinearAlgebra/ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrixReordering/NumericalMatrixReordering.h"
 
 
 using namespace LinearAlgebra;
@@ -40,6 +41,19 @@ namespace NumericalAnalysis {
         
         void applySolutionToDegreesOfFreedom() const;
         
+        /**
+         * @brief Renumbers the free degrees of freedom of the linear system with a symmetric permutation.
+         * 
+         * Reverse Cuthill-McKee is computed from the graph of the matrix, Morton from the coordinates of the parent
+         * nodes of the free degrees of freedom. The permutation is stored in the linear system and undone in
+         * applySolutionToDegreesOfFreedom(). The solution of the system is permuted with it; an initial solution given
+         * to an iterative solver is not, so set it after reordering.
+         * 
+         * @param reorderingType The reordering algorithm.
+         * @param printReport If true, the bandwidth and the CSR SpMV time before and after the reordering are printed.
+         */
+        void reorderLinearSystem(NumericalMatrixReorderingType reorderingType, bool printReport = true);
+        
         vector<double> getSolutionAtNode(vector<double>& nodeCoordinates, double tolerance = 1E-4) const;
         
     protected:
@@ -0,0 +1,246 @@
+//
+// Created by hal9000 on 11/1/23.
+//
+
+#ifndef UNTITLED_BLOCKEDLU_H
+#define UNTITLED_BLOCKEDLU_H
+
+#include <cmath>
+#include <vector>
+#include "../../../ThreadingOperations/ThreadingOperations.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Blocked right-looking LU factorization with partial pivoting, P A = L U, of a dense row major matrix
+    * stored in place.
+    *
+    * For every block of blockSize columns:
+    * 1. Panel factorization: unblocked LU with partial pivoting of the columns of the block, all the rows below.
+    * 2. Row block of U: unit lower triangular solve L11 U12 = A12, the columns split among the threads.
+    * 3. Trailing update A22 = A22 - L21 U12, a GEMM in column tiles of U12 that stay in cache and register blocks of
+    *    four rows and 32 bytes of columns of A22 (4 doubles, 8 floats), so that float factorizations use twice the
+    *    SIMD lanes. The groups of four rows are split among the threads.
+    *
+    * Rows are never swapped during the factorization: the rows are addressed through a vector of row pointers and
+    * pivoting swaps two pointers and two entries of the permutation vector. The rows are moved once at the end, so
+    * that row i of the array holds row i of L (strictly lower part, unit diagonal implied) and of U.
+    *
+    * @tparam T The datatype of the matrix elements.
+    */
+    template<typename T>
+    class BlockedLU {
+    public:
+        /**
+        * @brief Factorizes the n x n row major matrix a with leading dimension lda in place.
+        *
+        * @param permutation Output. permutation[i] is the row of A that became row i of P A.
+        * @param numberOfSwaps Output. Number of transpositions of P, whose parity is the sign of det(P).
+        * @param pivotTolerance A pivot with absolute value below the tolerance stops the factorization.
+        * @param blockSize Columns of a panel. A block size of at least n gives the unblocked factorization.
+        * @return n on success, otherwise the column of the first pivot below the tolerance. The columns after it are
+        * not factorized and the rows are left in pivoted order.
+        */
+        static unsigned factorize(T* a, unsigned n, unsigned lda, vector<unsigned> &permutation, unsigned &numberOfSwaps,
+                                  double pivotTolerance = 0, unsigned availableThreads = 1, unsigned blockSize = 32) {
+            vector<T*> rows(n);
+            permutation.resize(n);
+            for (unsigned i = 0; i < n; i++) {
+                rows[i] = a + static_cast<size_t>(i) * lda;
+                permutation[i] = i;
+            }
+            numberOfSwaps = 0;
+            blockSize = std::max(1u, blockSize);
+            unsigned failedColumn = n;
+            for (unsigned first = 0; first < n && failedColumn == n; first += blockSize) {
+                unsigned last = std::min(n, first + blockSize);
+                failedColumn = _factorizePanel(rows, permutation, numberOfSwaps, n, first, last, pivotTolerance);
+                if (failedColumn != n || last == n)
+                    break;
+                _solveRowBlock(rows, n, first, last, availableThreads);
+                _updateTrailingMatrix(rows, n, first, last, availableThreads);
+            }
+            _permuteRows(a, n, lda, permutation);
+            return failedColumn;
+        }
+
+        /**
+        * @brief Solves A x = rhs with the factors of factorize(). rhs and x must not alias.
+        */
+        static void solve(const T* lu, unsigned n, unsigned lda, const vector<unsigned> &permutation, const T* rhs, T* x) {
+            //L y = P b
+            for (unsigned i = 0; i < n; i++) {
+                const T* row = lu + static_cast<size_t>(i) * lda;
+                T sum = rhs[permutation[i]];
+                for (unsigned j = 0; j < i; j++)
+                    sum -= row[j] * x[j];
+                x[i] = sum;
+            }
+            //U x = y
+            for (unsigned i = n; i-- > 0;) {
+                const T* row = lu + static_cast<size_t>(i) * lda;
+                T sum = x[i];
+                for (unsigned j = i + 1; j < n; j++)
+                    sum -= row[j] * x[j];
+                x[i] = sum / row[i];
+            }
+        }
+
+        /**
+        * @brief Floating point operations of the LU factorization of an n x n matrix, 2n³/3.
+        */
+        static double flops(unsigned n) {
+            return 2.0 * n * n * n / 3.0;
+        }
+
+    private:
+        //Columns of a tile of the trailing update, the 32 x 256 doubles of a tile of U12 stay in cache
+        static constexpr unsigned _tileColumns = 256;
+
+        static constexpr unsigned _registerColumns = 32 / sizeof(T);
+
+        static unsigned _factorizePanel(vector<T*> &rows, vector<unsigned> &permutation, unsigned &numberOfSwaps,
+                                        unsigned n, unsigned first, unsigned last, double pivotTolerance) {
+            for (unsigned j = first; j < last; j++) {
+                unsigned pivot = j;
+                T maximum = std::abs(rows[j][j]);
+                for (unsigned i = j + 1; i < n; i++)
+                    if (std::abs(rows[i][j]) > maximum) {
+                        maximum = std::abs(rows[i][j]);
+                        pivot = i;
+                    }
+                if (!(maximum > pivotTolerance) || maximum == static_cast<T>(0))
+                    return j;
+                if (pivot != j) {
+                    std::swap(rows[j], rows[pivot]);
+                    std::swap(permutation[j], permutation[pivot]);
+                    numberOfSwaps++;
+                }
+                const T* pivotRow = rows[j];
+                T inverse = 1 / pivotRow[j];
+                for (unsigned i = j + 1; i < n; i++) {
+                    T* row = rows[i];
+                    T multiplier = row[j] *= inverse;
+                    for (unsigned column = j + 1; column < last; column++)
+                        row[column] -= multiplier * pivotRow[column];
+                }
+            }
+            return n;
+        }
+
+        /**
+        * @brief U12 = L11^-1 A12 for the rows [first, last) and the columns [last, n).
+        */
+        static void _solveRowBlock(vector<T*> &rows, unsigned n, unsigned first, unsigned last, unsigned availableThreads) {
+            auto columnsJob = [&](unsigned start, unsigned end) {
+                for (unsigned i = first + 1; i < last; i++) {
+                    T* row = rows[i] + last;
+                    for (unsigned p = first; p < i; p++) {
+                        T multiplier = rows[i][p];
+                        const T* upper = rows[p] + last;
+                        for (unsigned column = start; column < end; column++)
+                            row[column] -= multiplier * upper[column];
+                    }
+                }
+            };
+            ThreadingOperations<T>::executeParallelJob(columnsJob, n - last, availableThreads);
+        }
+
+        /**
+        * @brief A22 = A22 - L21 U12 for the rows and columns [last, n).
+        *
+        * Every group of four rows of L21 is packed column by column, and each 4 x _registerColumns block of A22 is
+        * accumulated in registers over the columns of the panel before it is written back once. The fixed width
+        * inner loops vectorize.
+        */
+        static void _updateTrailingMatrix(vector<T*> &rows, unsigned n, unsigned first, unsigned last,
+                                          unsigned availableThreads) {
+            unsigned width = last - first;
+            unsigned numberOfGroups = (n - last + 3) / 4;
+            auto groupsJob = [&](unsigned startGroup, unsigned endGroup) {
+                vector<T> packed(4 * static_cast<size_t>(width));
+                for (unsigned tile = last; tile < n; tile += _tileColumns) {
+                    unsigned tileEnd = std::min(n, tile + _tileColumns);
+                    for (unsigned group = startGroup; group < endGroup; group++) {
+                        unsigned i = last + 4 * group;
+                        if (i + 4 > n) {
+                            for (; i < n; i++)
+                                for (unsigned p = first; p < last; p++) {
+                                    T multiplier = rows[i][p];
+                                    const T* upper = rows[p];
+                                    T* row = rows[i];
+                                    for (unsigned column = tile; column < tileEnd; column++)
+                                        row[column] -= multiplier * upper[column];
+                                }
+                            continue;
+                        }
+                        T* row0 = rows[i], *row1 = rows[i + 1], *row2 = rows[i + 2], *row3 = rows[i + 3];
+                        for (unsigned p = 0; p < width; p++) {
+                            packed[4 * p] = row0[first + p];
+                            packed[4 * p + 1] = row1[first + p];
+                            packed[4 * p + 2] = row2[first + p];
+                            packed[4 * p + 3] = row3[first + p];
+                        }
+                        unsigned column = tile;
+                        for (; column + _registerColumns <= tileEnd; column += _registerColumns) {
+                            T c[4][_registerColumns] = {};
+                            const T* l = packed.data();
+                            for (unsigned p = first; p < last; p++, l += 4) {
+                                const T* u = rows[p] + column;
+                                for (unsigned k = 0; k < _registerColumns; k++) {
+                                    c[0][k] += l[0] * u[k];
+                                    c[1][k] += l[1] * u[k];
+                                    c[2][k] += l[2] * u[k];
+                                    c[3][k] += l[3] * u[k];
+                                }
+                            }
+                            for (unsigned k = 0; k < _registerColumns; k++) {
+                                row0[column + k] -= c[0][k];
+                                row1[column + k] -= c[1][k];
+                                row2[column + k] -= c[2][k];
+                                row3[column + k] -= c[3][k];
+                            }
+                        }
+                        for (; column < tileEnd; column++) {
+                            const T* l = packed.data();
+                            for (unsigned p = first; p < last; p++, l += 4) {
+                                T u = rows[p][column];
+                                row0[column] -= l[0] * u;
+                                row1[column] -= l[1] * u;
+                                row2[column] -= l[2] * u;
+                                row3[column] -= l[3] * u;
+                            }
+                        }
+                    }
+                }
+            };
+            //Ranges of whole groups, without the cache line rounding
+            ThreadingOperations<T>::executeParallelJob(groupsJob, numberOfGroups, availableThreads, sizeof(T));
+        }
+
+        /**
+        * @brief Moves row permutation[i] of a to row i, following the cycles of the permutation with one row buffer.
+        */
+        static void _permuteRows(T* a, unsigned n, unsigned lda, const vector<unsigned> &permutation) {
+            vector<char> placed(n, 0);
+            vector<T> buffer(n);
+            for (unsigned start = 0; start < n; start++) {
+                if (placed[start] || permutation[start] == start)
+                    continue;
+                std::copy(a + static_cast<size_t>(start) * lda, a + static_cast<size_t>(start) * lda + n, buffer.begin());
+                unsigned i = start;
+                while (permutation[i] != start) {
+                    T* source = a + static_cast<size_t>(permutation[i]) * lda;
+                    std::copy(source, source + n, a + static_cast<size_t>(i) * lda);
+                    placed[i] = 1;
+                    i = permutation[i];
+                }
+                std::copy(buffer.begin(), buffer.end(), a + static_cast<size_t>(i) * lda);
+                placed[i] = 1;
+            }
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_BLOCKEDLU_H
@@ -6,6 +6,7 @@
 #define UNTITLED_DECOMPOSITIONLUP_H
 
 #include "MatrixDecomposition.h"
+#include "BlockedLU.h"
 
 namespace LinearAlgebra {
     /**
@@ -14,6 +15,9 @@ namespace LinearAlgebra {
     * Performs the SolverLUP decomposition on a matrix. This is a numerical algorithm used to solve linear systems of
     * equations, calculate the inverse of a matrix, and compute the determinant of a matrix.
     *
+    * The factorization is the blocked, multithreaded BlockedLU on the storage of the matrix. L (unit diagonal implied)
+    * and U overwrite the matrix in both decompose() and decomposeOnMatrix(), and P is kept as a permutation vector.
+    *
     * @tparam T The type of the matrix elements
     */
     class DecompositionLUP : public MatrixDecomposition {
@@ -31,14 +35,15 @@ namespace LinearAlgebra {
          * @param pivotTolerance The tolerance for pivoting the matrix
          * @param throwExceptionOnSingularMatrix (can be excluded) If true, throws an exception when a singular matrix is detected.
          *                                      If false, prints a warning message and continues.
+         * @param availableThreads (can be excluded) The threads of the panel solves and the trailing matrix updates.
          */
-        explicit DecompositionLUP(const shared_ptr<Array<double>>& matrix, double pivotTolerance = 1e-10, bool throwExceptionOnSingularMatrix = true);
+        explicit DecompositionLUP(const shared_ptr<Array<double>>& matrix, double pivotTolerance = 1e-10,
+                                  bool throwExceptionOnSingularMatrix = true, unsigned availableThreads = 1);
         
 
         /**
-        * Performs the SolverLUP decomposition and creates new Array* for the L, U matrices.
-        *
-        * @param deleteMatrixAfterDecomposition If true, deletes the original matrix after decomposition.
+        * Performs the SolverLUP decomposition. Same as decomposeOnMatrix(); getL() and getU() return copies of the
+        * factors.
         */
         void decompose() override;
         
@@ -83,6 +88,13 @@ namespace LinearAlgebra {
         */
         shared_ptr<vector<unsigned>> _p;
         
+        /**
+        * Number of row transpositions of P, the parity of the sign of the determinant
+        */
+        unsigned _numberOfSwaps = 0;
+
+        unsigned _availableThreads;
+
         /**
         * Pivot tolerance
         */
@@ -22,7 +22,7 @@ namespace LinearAlgebra {
             _l = make_shared<Array<double>>(n, n);
             for (unsigned i = 0; i < n; i++) {
                 _l->at(i, i) = 1.0;
-                for (unsigned j = 0; j <= i; j++) {
+                for (unsigned j = 0; j < i; j++) {
                     _l->at(i, j) = _matrix->at(i, j);
                 }
             }
@@ -25,8 +25,9 @@ namespace LinearAlgebra {
         explicit CSRStorageDataProvider(shared_ptr<NumericalVector<T>> values,
                                         shared_ptr<NumericalVector<unsigned>> columnIndices,
                                         shared_ptr<NumericalVector<unsigned>> rowOffsets,
-                                        unsigned numberOfRows, unsigned numberOfColumns, unsigned numberOfThreads)
-                : SparseMatrixDataStorageProvider<T>(numberOfRows, numberOfColumns, numberOfThreads) {
+                                        unsigned numberOfRows, unsigned numberOfColumns, unsigned numberOfThreads,
+                                        NumericalMatrixFormType formType = General)
+                : SparseMatrixDataStorageProvider<T>(numberOfRows, numberOfColumns, formType, numberOfThreads) {
             this->_storageType = NumericalMatrixStorageType::CSR;
             this->_values = std::move(values);
             _columnIndices = std::move(columnIndices);
@@ -128,6 +129,31 @@ namespace LinearAlgebra {
             }
         }
 
+        /**
+        * @brief Adds a value to the element at the specified row and column of the sparse matrix.
+        *
+        * While element assignment is running, the call is thread-safe: every thread appends to its own coordinate
+        * buffer and the duplicates are summed in parallel at finalizeElementAssignment(). This is the intended way to
+        * assemble large systems, e.g. from a ThreadingOperations job over the nodes or elements of a mesh.
+        * Otherwise the value is added to the stored element, or inserted as in setElement().
+        *
+        * @param row The row index.
+        * @param column The column index.
+        * @param value The value to be added.
+        *
+        * @throws runtime_error if the row or column indices are out of bounds.
+        */
+        void addElement(unsigned int row, unsigned int column, T value) override {
+            if (row >= this->_numberOfRows || column >= this->_numberOfColumns)
+                throw runtime_error("Row or column index out of bounds.");
+
+            if (this->_elementAssignmentRunning) {
+                this->_builder.addElement(row, column, value);
+                return;
+            }
+            setElement(row, column, getElement(row, column) + value);
+        }
+
         void eraseElement(unsigned int row, unsigned int column) override {
 
             if (row >= this->_numberOfRows || column >= this->_numberOfColumns)
@@ -203,6 +229,7 @@ namespace LinearAlgebra {
                     }
                 }
             }
+            return columnVector;
         }
 
         void initializeElementAssignment() override {
@@ -0,0 +1,288 @@
+//
+// Created by hal9000 on 10/20/23.
+//
+
+#ifndef UNTITLED_COMPRESSEDINDEXCSRSTORAGEDATAPROVIDER_H
+#define UNTITLED_COMPRESSEDINDEXCSRSTORAGEDATAPROVIDER_H
+
+#include <cstdint>
+#include <limits>
+#include "NumericalMatrixStorageDataProvider.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Read-only CSR storage with compressed column indices.
+    *
+    * The column index of every non-zero element is replaced by an 8-bit or 16-bit unsigned delta:
+    * - the first element of a row stores the difference from the first column of the previous row,
+    * - every other element stores the difference from the previous column of the same row.
+    * For finite difference stencils both differences are small and constant, so a 4-byte index shrinks to 1 or 2 bytes.
+    *
+    * Deltas that are negative or do not fit in the delta type are stored as the escape value (the maximum of the type)
+    * and the absolute column is appended to the exception columns. The rows are split in segments of
+    * rowsPerSegment rows. The previous first column is reset to 0 at the beginning of each segment and the position of
+    * the first exception of each segment is stored, so segments can be decoded independently and in parallel.
+    *
+    * The delta width that minimizes the total index bytes (deltas + exceptions) is selected at construction.
+    *
+    * @tparam T The datatype of the matrix elements.
+    */
+    template <typename T>
+    class CompressedIndexCSRStorageDataProvider : public NumericalMatrixStorageDataProvider<T> {
+    public:
+        /**
+        * @brief Compresses the column indices of a CSR storage. The values of the CSR storage are shared, not copied.
+        *
+        * @param csrStorage The CSR storage (regular or memory mapped).
+        * @param numberOfRows The number of rows of the matrix.
+        * @param numberOfColumns The number of columns of the matrix.
+        * @param rowsPerSegment The number of rows of each independently decodable segment.
+        */
+        CompressedIndexCSRStorageDataProvider(const shared_ptr<NumericalMatrixStorageDataProvider<T>> &csrStorage,
+                                              unsigned numberOfRows, unsigned numberOfColumns, unsigned rowsPerSegment = 64) :
+                NumericalMatrixStorageDataProvider<T>(numberOfRows, numberOfColumns, csrStorage->getFormType(),
+                                                      csrStorage->getAvailableThreads()),
+                _rowsPerSegment(rowsPerSegment), _zero(static_cast<T>(0)) {
+            if (csrStorage->getStorageType() != CSR)
+                throw invalid_argument("Index compression requires a matrix stored in CSR format.");
+            if (rowsPerSegment == 0)
+                throw invalid_argument("The number of rows per segment must be positive.");
+            this->_storageType = NumericalMatrixStorageType::CompressedIndexCSR;
+
+            auto supplementaryDataPointers = csrStorage->getSupplementaryDataPointers();
+            unsigned* columnIndices = supplementaryDataPointers[0];
+            unsigned* rowOffsets = supplementaryDataPointers[1];
+            _numberOfNonZeros = rowOffsets[numberOfRows];
+            this->_values = _numberOfNonZeros > 0 ? csrStorage->getValues() : make_shared<NumericalVector<T>>(0, 0, this->_availableThreads);
+            _rowOffsets = make_shared<NumericalVector<unsigned>>(numberOfRows + 1, 0, this->_availableThreads);
+            std::copy(rowOffsets, rowOffsets + numberOfRows + 1, _rowOffsets->getDataPointer());
+
+            if (_numberOfExceptions<uint8_t>(columnIndices, rowOffsets) * sizeof(unsigned) + _numberOfNonZeros * sizeof(uint8_t) <=
+                _numberOfExceptions<uint16_t>(columnIndices, rowOffsets) * sizeof(unsigned) + _numberOfNonZeros * sizeof(uint16_t))
+                _encode<uint8_t>(columnIndices, rowOffsets);
+            else
+                _encode<uint16_t>(columnIndices, rowOffsets);
+        }
+
+        vector<shared_ptr<NumericalVector<unsigned>>> getSupplementaryVectors() override {
+            return {_rowOffsets, _exceptionColumns, _segmentExceptionOffsets};
+        }
+
+        /**
+        * @brief Returns the size of each delta in bytes (1 or 2).
+        */
+        unsigned getDeltaSize() const {
+            return _deltaSize;
+        }
+
+        /**
+        * @brief Returns a pointer to the delta bytes. Reinterpret as uint8_t or uint16_t according to getDeltaSize().
+        */
+        const uint8_t* getDeltas() const {
+            return _deltas.data();
+        }
+
+        unsigned getRowsPerSegment() const {
+            return _rowsPerSegment;
+        }
+
+        unsigned getNumberOfSegments() const {
+            return (this->_numberOfRows + _rowsPerSegment - 1) / _rowsPerSegment;
+        }
+
+        /**
+        * @brief Returns the average number of bytes stored per non-zero element (values, row offsets, deltas,
+        * exception columns and segment exception offsets).
+        */
+        double bytesPerNonZero() const {
+            if (_numberOfNonZeros == 0)
+                return 0;
+            double bytes = _numberOfNonZeros * (sizeof(T) + _deltaSize) +
+                           (this->_numberOfRows + 1 + _exceptionColumns->size() + _segmentExceptionOffsets->size()) * sizeof(unsigned);
+            return bytes / _numberOfNonZeros;
+        }
+
+        /**
+        * @brief Returns the average number of bytes per non-zero element of the equivalent uncompressed CSR storage.
+        */
+        double uncompressedBytesPerNonZero() const {
+            if (_numberOfNonZeros == 0)
+                return 0;
+            double bytes = _numberOfNonZeros * (sizeof(T) + sizeof(unsigned)) + (this->_numberOfRows + 1) * sizeof(unsigned);
+            return bytes / _numberOfNonZeros;
+        }
+
+        /**
+        * @brief Returns a reference to the element. Missing elements return a zero that is reset on every call, so a
+        * write through it does not change later reads.
+        */
+        T& getElement(unsigned int row, unsigned int column) override {
+            if (row >= this->_numberOfRows || column >= this->_numberOfColumns)
+                throw runtime_error("Row or column index out of bounds.");
+            vector<unsigned> rowColumns;
+            unsigned rowStart = _decodeRowColumns(row, rowColumns);
+            for (unsigned i = 0; i < rowColumns.size(); i++) {
+                if (rowColumns[i] == column)
+                    return (*this->_values)[rowStart + i];
+            }
+            _zero = static_cast<T>(0);
+            return _zero;
+        }
+
+        void setElement(unsigned int, unsigned int, T) override {
+            throw runtime_error("Compressed index CSR matrices are read-only.");
+        }
+
+        void eraseElement(unsigned int, unsigned int) override {
+            throw runtime_error("Compressed index CSR matrices are read-only.");
+        }
+
+        void initializeElementAssignment() override {
+            throw runtime_error("Compressed index CSR matrices are read-only.");
+        }
+
+        void finalizeElementAssignment() override {
+            throw runtime_error("Compressed index CSR matrices are read-only.");
+        }
+
+        shared_ptr<NumericalVector<T>> getRowSharedPtr(unsigned row) override {
+            if (row >= this->_numberOfRows)
+                throw runtime_error("Row index out of bounds.");
+            auto rowVector = make_shared<NumericalVector<T>>(this->_numberOfColumns, static_cast<T>(0));
+            vector<unsigned> rowColumns;
+            unsigned rowStart = _decodeRowColumns(row, rowColumns);
+            for (unsigned i = 0; i < rowColumns.size(); i++)
+                (*rowVector)[rowColumns[i]] = (*this->_values)[rowStart + i];
+            return rowVector;
+        }
+
+    private:
+
+        unsigned _rowsPerSegment;
+
+        unsigned _numberOfNonZeros;
+
+        unsigned _deltaSize;
+
+        vector<uint8_t> _deltas;
+
+        shared_ptr<NumericalVector<unsigned>> _rowOffsets;
+
+        shared_ptr<NumericalVector<unsigned>> _exceptionColumns;
+
+        shared_ptr<NumericalVector<unsigned>> _segmentExceptionOffsets;
+
+        T _zero;
+
+        /**
+        * @brief Visits the non-zero elements in storage order and calls visitor(k, delta, isException) for each one.
+        * delta is the difference from the reference column (see class description), isException is true when it is
+        * negative or does not fit below the escape value of DeltaType.
+        */
+        template<typename DeltaType, typename Visitor>
+        void _visitDeltas(const unsigned* columnIndices, const unsigned* rowOffsets, Visitor &visitor) const {
+            const int64_t escape = numeric_limits<DeltaType>::max();
+            unsigned firstColumn = 0;
+            for (unsigned row = 0; row < this->_numberOfRows; row++) {
+                if (row % _rowsPerSegment == 0) {
+                    visitor.segmentStart(row / _rowsPerSegment);
+                    firstColumn = 0;
+                }
+                int64_t reference = firstColumn;
+                for (unsigned k = rowOffsets[row]; k < rowOffsets[row + 1]; k++) {
+                    int64_t delta = static_cast<int64_t>(columnIndices[k]) - reference;
+                    visitor(k, delta, delta < 0 || delta >= escape);
+                    if (k == rowOffsets[row])
+                        firstColumn = columnIndices[k];
+                    reference = columnIndices[k];
+                }
+            }
+        }
+
+        struct ExceptionCounter {
+            unsigned count = 0;
+            void segmentStart(unsigned) { }
+            void operator()(unsigned, int64_t, bool isException) { count += isException; }
+        };
+
+        template<typename DeltaType>
+        unsigned _numberOfExceptions(const unsigned* columnIndices, const unsigned* rowOffsets) const {
+            ExceptionCounter counter;
+            _visitDeltas<DeltaType>(columnIndices, rowOffsets, counter);
+            return counter.count;
+        }
+
+        template<typename DeltaType>
+        struct Encoder {
+            DeltaType* deltas;
+            const unsigned* columnIndices;
+            vector<unsigned> &exceptionColumns;
+            vector<unsigned> &segmentExceptionOffsets;
+            void segmentStart(unsigned segment) {
+                segmentExceptionOffsets[segment] = exceptionColumns.size();
+            }
+            void operator()(unsigned k, int64_t delta, bool isException) {
+                if (isException) {
+                    deltas[k] = numeric_limits<DeltaType>::max();
+                    exceptionColumns.push_back(columnIndices[k]);
+                }
+                else {
+                    deltas[k] = static_cast<DeltaType>(delta);
+                }
+            }
+        };
+
+        template<typename DeltaType>
+        void _encode(const unsigned* columnIndices, const unsigned* rowOffsets) {
+            _deltaSize = sizeof(DeltaType);
+            _deltas.assign(_numberOfNonZeros * sizeof(DeltaType), 0);
+            vector<unsigned> exceptionColumns;
+            vector<unsigned> segmentExceptionOffsets(getNumberOfSegments() + 1, 0);
+            Encoder<DeltaType> encoder{reinterpret_cast<DeltaType*>(_deltas.data()), columnIndices, exceptionColumns,
+                                       segmentExceptionOffsets};
+            _visitDeltas<DeltaType>(columnIndices, rowOffsets, encoder);
+            segmentExceptionOffsets[getNumberOfSegments()] = exceptionColumns.size();
+
+            _exceptionColumns = make_shared<NumericalVector<unsigned>>(exceptionColumns.size(), 0, this->_availableThreads);
+            std::copy(exceptionColumns.begin(), exceptionColumns.end(), _exceptionColumns->getDataPointer());
+            _segmentExceptionOffsets = make_shared<NumericalVector<unsigned>>(segmentExceptionOffsets.size(), 0, this->_availableThreads);
+            std::copy(segmentExceptionOffsets.begin(), segmentExceptionOffsets.end(), _segmentExceptionOffsets->getDataPointer());
+        }
+
+        /**
+        * @brief Decodes the column indices of a row by decoding its segment up to the row.
+        * @return The position of the first element of the row in the values vector.
+        */
+        unsigned _decodeRowColumns(unsigned row, vector<unsigned> &rowColumns) const {
+            if (_deltaSize == sizeof(uint8_t))
+                return _decodeRowColumns<uint8_t>(row, rowColumns);
+            return _decodeRowColumns<uint16_t>(row, rowColumns);
+        }
+
+        template<typename DeltaType>
+        unsigned _decodeRowColumns(unsigned row, vector<unsigned> &rowColumns) const {
+            auto deltas = reinterpret_cast<const DeltaType*>(_deltas.data());
+            const DeltaType escape = numeric_limits<DeltaType>::max();
+            const unsigned* rowOffsets = _rowOffsets->getDataPointer();
+            const unsigned* exceptionColumns = _exceptionColumns->getDataPointer();
+            unsigned segment = row / _rowsPerSegment;
+            unsigned exception = (*_segmentExceptionOffsets)[segment];
+            unsigned firstColumn = 0;
+            for (unsigned currentRow = segment * _rowsPerSegment; currentRow <= row; currentRow++) {
+                rowColumns.clear();
+                unsigned column = firstColumn;
+                for (unsigned k = rowOffsets[currentRow]; k < rowOffsets[currentRow + 1]; k++) {
+                    column = deltas[k] == escape ? exceptionColumns[exception++] : column + deltas[k];
+                    if (k == rowOffsets[currentRow])
+                        firstColumn = column;
+                    rowColumns.push_back(column);
+                }
+            }
+            return rowOffsets[row];
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_COMPRESSEDINDEXCSRSTORAGEDATAPROVIDER_H
@@ -0,0 +1,208 @@
+//
+// Created by hal9000 on 10/23/23.
+//
+
+#ifndef UNTITLED_DIASTORAGEDATAPROVIDER_H
+#define UNTITLED_DIASTORAGEDATAPROVIDER_H
+
+#include <mutex>
+#include "NumericalMatrixStorageDataProvider.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Read-only diagonal (DIA) storage for banded matrices with a small, fixed set of diagonals.
+    *
+    * Finite difference matrices of structured grids (e.g. the meshes of DomainBoundaryFactory::parallelepiped and
+    * parallelogram in lexicographic order) only have non-zero elements on the diagonals j - i = offset of the stencil.
+    * Each of these diagonals is stored as a dense array of numberOfRows values indexed by the row, so the storage
+    * keeps no column indices and the SpMV streams every diagonal and the matching shifted range of x contiguously.
+    *
+    * The values of diagonal d for row i are stored at values[d * numberOfRows + i]. Positions of a diagonal that
+    * fall outside the matrix or are zero in the source matrix are stored as explicit zeros.
+    *
+    * @tparam T The datatype of the matrix elements.
+    */
+    template <typename T>
+    class DIAStorageDataProvider : public NumericalMatrixStorageDataProvider<T> {
+    public:
+        /**
+        * @brief Detects the diagonal offsets of a CSR storage and copies its values to diagonal storage.
+        *
+        * @param csrStorage The CSR storage (regular or memory mapped).
+        * @param numberOfRows The number of rows of the matrix.
+        * @param numberOfColumns The number of columns of the matrix.
+        */
+        DIAStorageDataProvider(const shared_ptr<NumericalMatrixStorageDataProvider<T>> &csrStorage,
+                               unsigned numberOfRows, unsigned numberOfColumns) :
+                NumericalMatrixStorageDataProvider<T>(numberOfRows, numberOfColumns, csrStorage->getFormType(),
+                                                      csrStorage->getAvailableThreads()),
+                _zero(static_cast<T>(0)) {
+            if (csrStorage->getStorageType() != CSR)
+                throw invalid_argument("Diagonal storage requires a matrix stored in CSR format.");
+            this->_storageType = NumericalMatrixStorageType::DIA;
+
+            auto supplementaryDataPointers = csrStorage->getSupplementaryDataPointers();
+            const unsigned* columnIndices = supplementaryDataPointers[0];
+            const unsigned* rowOffsets = supplementaryDataPointers[1];
+            _diagonalOffsets = diagonalOffsets(columnIndices, rowOffsets, numberOfRows, numberOfColumns, this->_availableThreads);
+
+            //Position of each offset in _diagonalOffsets, shifted by numberOfRows - 1 so that it can be indexed
+            vector<int> diagonalIndices(numberOfRows + numberOfColumns, -1);
+            for (unsigned d = 0; d < _diagonalOffsets.size(); d++)
+                diagonalIndices[_diagonalOffsets[d] + numberOfRows - 1] = static_cast<int>(d);
+
+            this->_values = make_shared<NumericalVector<T>>(_diagonalOffsets.size() * numberOfRows, 0, this->_availableThreads);
+            T* diagonalValues = this->_values->getDataPointer();
+            const T* csrValues = rowOffsets[numberOfRows] > 0 ? csrStorage->getValuesDataPointer() : nullptr;
+            auto copyJob = [&](unsigned startRow, unsigned endRow) {
+                for (unsigned row = startRow; row < endRow; row++) {
+                    for (unsigned k = rowOffsets[row]; k < rowOffsets[row + 1]; k++) {
+                        unsigned diagonal = diagonalIndices[columnIndices[k] + numberOfRows - 1 - row];
+                        diagonalValues[diagonal * numberOfRows + row] = csrValues[k];
+                    }
+                }
+            };
+            if (numberOfRows > 0)
+                ThreadingOperations<T>::executeParallelJob(copyJob, numberOfRows, this->_availableThreads);
+            _numberOfNonZeros = rowOffsets[numberOfRows];
+        }
+
+        /**
+        * @brief Returns the sorted offsets (column - row) of the diagonals that contain at least one stored element
+        * of a CSR matrix. The rows are scanned in parallel.
+        */
+        static vector<int> diagonalOffsets(const unsigned* columnIndices, const unsigned* rowOffsets,
+                                           unsigned numberOfRows, unsigned numberOfColumns, unsigned availableThreads) {
+            vector<char> occupied(numberOfRows + numberOfColumns, 0);
+            mutex occupiedMutex;
+            auto detectionJob = [&](unsigned startRow, unsigned endRow) {
+                vector<char> localOccupied(numberOfRows + numberOfColumns, 0);
+                for (unsigned row = startRow; row < endRow; row++)
+                    for (unsigned k = rowOffsets[row]; k < rowOffsets[row + 1]; k++)
+                        localOccupied[columnIndices[k] + numberOfRows - 1 - row] = 1;
+                lock_guard<mutex> lock(occupiedMutex);
+                for (unsigned i = 0; i < occupied.size(); i++)
+                    occupied[i] |= localOccupied[i];
+            };
+            if (numberOfRows > 0)
+                ThreadingOperations<T>::executeParallelJob(detectionJob, numberOfRows, availableThreads);
+            vector<int> offsets;
+            for (unsigned i = 0; i < occupied.size(); i++)
+                if (occupied[i])
+                    offsets.push_back(static_cast<int>(i) - static_cast<int>(numberOfRows) + 1);
+            return offsets;
+        }
+
+        /**
+        * @brief Returns the number of bytes that an SpMV reads from the DIA storage of a CSR matrix divided by the
+        * bytes it reads from the CSR storage. Only the offsets are detected, no values are copied.
+        */
+        static double storageRatio(const shared_ptr<NumericalMatrixStorageDataProvider<T>> &csrStorage,
+                                   unsigned numberOfRows, unsigned numberOfColumns) {
+            auto supplementaryDataPointers = csrStorage->getSupplementaryDataPointers();
+            const unsigned* columnIndices = supplementaryDataPointers[0];
+            const unsigned* rowOffsets = supplementaryDataPointers[1];
+            auto offsets = diagonalOffsets(columnIndices, rowOffsets, numberOfRows, numberOfColumns,
+                                           csrStorage->getAvailableThreads());
+            double diagonalBytes = static_cast<double>(offsets.size()) * numberOfRows * sizeof(T);
+            double csrBytes = static_cast<double>(rowOffsets[numberOfRows]) * (sizeof(T) + sizeof(unsigned)) +
+                              (numberOfRows + 1) * sizeof(unsigned);
+            return diagonalBytes / csrBytes;
+        }
+
+        /**
+        * @brief Converts a CSR storage to diagonal storage if the diagonal storage moves at most maximumStorageRatio
+        * times the bytes of the CSR storage. Otherwise (too many or too sparsely populated diagonals) the CSR
+        * storage itself is returned.
+        *
+        * @return The new DIA storage, or csrStorage.
+        */
+        static shared_ptr<NumericalMatrixStorageDataProvider<T>>
+        fromCSROrFallback(const shared_ptr<NumericalMatrixStorageDataProvider<T>> &csrStorage,
+                          unsigned numberOfRows, unsigned numberOfColumns, double maximumStorageRatio = 1.0) {
+            if (csrStorage->getStorageType() != CSR)
+                throw invalid_argument("Diagonal storage requires a matrix stored in CSR format.");
+            if (storageRatio(csrStorage, numberOfRows, numberOfColumns) > maximumStorageRatio)
+                return csrStorage;
+            return make_shared<DIAStorageDataProvider<T>>(csrStorage, numberOfRows, numberOfColumns);
+        }
+
+        /**
+        * @brief Returns the sorted offsets (column - row) of the stored diagonals.
+        */
+        const vector<int> &getDiagonalOffsets() const {
+            return _diagonalOffsets;
+        }
+
+        unsigned getNumberOfDiagonals() const {
+            return static_cast<unsigned>(_diagonalOffsets.size());
+        }
+
+        /**
+        * @brief Returns the average number of bytes stored per non-zero element of the source matrix (values and
+        * offsets, explicit zeros included).
+        */
+        double bytesPerNonZero() const {
+            if (_numberOfNonZeros == 0)
+                return 0;
+            double bytes = static_cast<double>(_diagonalOffsets.size()) * (this->_numberOfRows * sizeof(T) + sizeof(int));
+            return bytes / _numberOfNonZeros;
+        }
+
+        /**
+        * @brief Returns a reference to the element. Elements off the stored diagonals return a zero that is reset on
+        * every call.
+        */
+        T& getElement(unsigned int row, unsigned int column) override {
+            if (row >= this->_numberOfRows || column >= this->_numberOfColumns)
+                throw runtime_error("Row or column index out of bounds.");
+            int offset = static_cast<int>(column) - static_cast<int>(row);
+            auto diagonal = std::lower_bound(_diagonalOffsets.begin(), _diagonalOffsets.end(), offset);
+            if (diagonal == _diagonalOffsets.end() || *diagonal != offset) {
+                _zero = static_cast<T>(0);
+                return _zero;
+            }
+            return (*this->_values)[(diagonal - _diagonalOffsets.begin()) * this->_numberOfRows + row];
+        }
+
+        void setElement(unsigned int, unsigned int, T) override {
+            throw runtime_error("Diagonal storage matrices are read-only.");
+        }
+
+        void eraseElement(unsigned int, unsigned int) override {
+            throw runtime_error("Diagonal storage matrices are read-only.");
+        }
+
+        void initializeElementAssignment() override {
+            throw runtime_error("Diagonal storage matrices are read-only.");
+        }
+
+        void finalizeElementAssignment() override {
+            throw runtime_error("Diagonal storage matrices are read-only.");
+        }
+
+        shared_ptr<NumericalVector<T>> getRowSharedPtr(unsigned row) override {
+            if (row >= this->_numberOfRows)
+                throw runtime_error("Row index out of bounds.");
+            auto rowVector = make_shared<NumericalVector<T>>(this->_numberOfColumns, static_cast<T>(0));
+            for (unsigned d = 0; d < _diagonalOffsets.size(); d++) {
+                long column = static_cast<long>(row) + _diagonalOffsets[d];
+                if (column >= 0 && column < this->_numberOfColumns)
+                    (*rowVector)[column] = (*this->_values)[d * this->_numberOfRows + row];
+            }
+            return rowVector;
+        }
+
+    private:
+
+        vector<int> _diagonalOffsets;
+
+        unsigned _numberOfNonZeros;
+
+        T _zero;
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_DIASTORAGEDATAPROVIDER_H
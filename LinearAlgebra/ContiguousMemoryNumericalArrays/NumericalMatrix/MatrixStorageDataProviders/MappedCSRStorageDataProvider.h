@@ -0,0 +1,145 @@
+//
+// Created by hal9000 on 10/19/23.
+//
+
+#ifndef UNTITLED_MAPPEDCSRSTORAGEDATAPROVIDER_H
+#define UNTITLED_MAPPEDCSRSTORAGEDATAPROVIDER_H
+
+#include "NumericalMatrixStorageDataProvider.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Read-only CSR storage whose arrays live in externally owned memory (typically a memory mapped binary CSR
+    * file written by NumericalMatrixIO).
+    *
+    * The mathematical operations access the arrays through getValuesDataPointer() and getSupplementaryDataPointers(),
+    * so no data is copied. getValues() and getSupplementaryVectors() are kept for compatibility with the code that
+    * expects NumericalVectors; they copy the arrays once on first use.
+    * Any attempt to modify the matrix throws a runtime_error.
+    *
+    * @tparam T The datatype of the matrix elements.
+    */
+    template <typename T>
+    class MappedCSRStorageDataProvider : public NumericalMatrixStorageDataProvider<T> {
+    public:
+        /**
+        * @param memory Keeps the memory that holds the arrays alive (e.g. a mapping released by munmap in its deleter).
+        * @param values Pointer to the numberOfNonZeroElements values.
+        * @param columnIndices Pointer to the numberOfNonZeroElements column indices.
+        * @param rowOffsets Pointer to the numberOfRows + 1 row offsets.
+        */
+        MappedCSRStorageDataProvider(shared_ptr<const void> memory, const T* values, const unsigned* columnIndices,
+                                     const unsigned* rowOffsets, unsigned numberOfRows, unsigned numberOfColumns,
+                                     unsigned numberOfNonZeroElements, NumericalMatrixFormType formType = General,
+                                     unsigned availableThreads = 1) :
+                NumericalMatrixStorageDataProvider<T>(numberOfRows, numberOfColumns, formType, availableThreads),
+                _memory(std::move(memory)), _mappedValues(const_cast<T*>(values)),
+                _mappedColumnIndices(const_cast<unsigned*>(columnIndices)), _mappedRowOffsets(const_cast<unsigned*>(rowOffsets)),
+                _numberOfNonZeros(numberOfNonZeroElements), _zero(static_cast<T>(0)) {
+            this->_storageType = NumericalMatrixStorageType::CSR;
+            this->_values = make_shared<NumericalVector<T>>(0, 0, availableThreads);
+        }
+
+        shared_ptr<NumericalVector<T>>& getValues() override {
+            if (this->_values->empty() && _numberOfNonZeros > 0) {
+                this->_values = make_shared<NumericalVector<T>>(_numberOfNonZeros, 0, this->_availableThreads);
+                std::copy(_mappedValues, _mappedValues + _numberOfNonZeros, this->_values->getDataPointer());
+            }
+            return NumericalMatrixStorageDataProvider<T>::getValues();
+        }
+
+        vector<shared_ptr<NumericalVector<unsigned>>> getSupplementaryVectors() override {
+            if (_columnIndices == nullptr) {
+                _columnIndices = make_shared<NumericalVector<unsigned>>(_numberOfNonZeros, 0, this->_availableThreads);
+                _rowOffsets = make_shared<NumericalVector<unsigned>>(this->_numberOfRows + 1, 0, this->_availableThreads);
+                std::copy(_mappedColumnIndices, _mappedColumnIndices + _numberOfNonZeros, _columnIndices->getDataPointer());
+                std::copy(_mappedRowOffsets, _mappedRowOffsets + this->_numberOfRows + 1, _rowOffsets->getDataPointer());
+            }
+            return {_columnIndices, _rowOffsets};
+        }
+
+        T* getValuesDataPointer() override {
+            return _mappedValues;
+        }
+
+        vector<unsigned*> getSupplementaryDataPointers() override {
+            return {_mappedColumnIndices, _mappedRowOffsets};
+        }
+
+        /**
+        * @brief Returns a reference to the element. The reference points to read-only memory and must not be written.
+        * Missing elements return a zero that is reset on every call, so a write through it does not change later reads.
+        */
+        T& getElement(unsigned int row, unsigned int column) override {
+            if (row >= this->_numberOfRows || column >= this->_numberOfColumns)
+                throw runtime_error("Row or column index out of bounds.");
+            for (unsigned i = _mappedRowOffsets[row]; i < _mappedRowOffsets[row + 1]; i++) {
+                if (_mappedColumnIndices[i] == column)
+                    return _mappedValues[i];
+            }
+            _zero = static_cast<T>(0);
+            return _zero;
+        }
+
+        void setElement(unsigned int, unsigned int, T) override {
+            throw runtime_error("Memory mapped CSR matrices are read-only.");
+        }
+
+        void eraseElement(unsigned int, unsigned int) override {
+            throw runtime_error("Memory mapped CSR matrices are read-only.");
+        }
+
+        void initializeElementAssignment() override {
+            throw runtime_error("Memory mapped CSR matrices are read-only.");
+        }
+
+        void finalizeElementAssignment() override {
+            throw runtime_error("Memory mapped CSR matrices are read-only.");
+        }
+
+        shared_ptr<NumericalVector<T>> getRowSharedPtr(unsigned row) override {
+            if (row >= this->_numberOfRows)
+                throw runtime_error("Row index out of bounds.");
+            auto rowVector = make_shared<NumericalVector<T>>(this->_numberOfColumns, static_cast<T>(0));
+            for (unsigned i = _mappedRowOffsets[row]; i < _mappedRowOffsets[row + 1]; i++)
+                (*rowVector)[_mappedColumnIndices[i]] = _mappedValues[i];
+            return rowVector;
+        }
+
+        shared_ptr<NumericalVector<T>> getColumnSharedPtr(unsigned column) override {
+            if (column >= this->_numberOfColumns)
+                throw runtime_error("Column index out of bounds.");
+            auto columnVector = make_shared<NumericalVector<T>>(this->_numberOfRows, static_cast<T>(0));
+            for (unsigned row = 0; row < this->_numberOfRows; row++) {
+                for (unsigned i = _mappedRowOffsets[row]; i < _mappedRowOffsets[row + 1]; i++) {
+                    if (_mappedColumnIndices[i] == column) {
+                        (*columnVector)[row] = _mappedValues[i];
+                        break;
+                    }
+                }
+            }
+            return columnVector;
+        }
+
+    private:
+        shared_ptr<const void> _memory;
+
+        T* _mappedValues;
+
+        unsigned* _mappedColumnIndices;
+
+        unsigned* _mappedRowOffsets;
+
+        unsigned _numberOfNonZeros;
+
+        shared_ptr<NumericalVector<unsigned>> _columnIndices;
+
+        shared_ptr<NumericalVector<unsigned>> _rowOffsets;
+
+        T _zero;
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_MAPPEDCSRSTORAGEDATAPROVIDER_H
@@ -7,6 +7,10 @@
 
 #include <map>
 #include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <algorithm>
 #include "../NumericalMatrixEnums.h"
 namespace LinearAlgebra{
     
@@ -24,18 +28,35 @@ namespace LinearAlgebra{
     * and the matrix is built incrementally. It uses a map to store non-zero elements along with their row 
     * and column indices.
     *
+    * For large systems the map becomes the bottleneck of the assembly. addElement() instead appends
+    * (row, column, value) triplets to a buffer owned by the calling thread, so any number of threads can assemble
+    * concurrently without locks. The buffers are merged, sorted and their duplicates summed in parallel when the
+    * CSR data vectors are retrieved.
+    *
     * @tparam T The datatype of matrix elements. It should support basic arithmetic operations.
     */
     template <typename T>
     class NumericalMatrixStorageDataBuilder{
     public:
 
-        NumericalMatrixStorageDataBuilder(unsigned numberOfRows, unsigned numberOfColumns) :
+        NumericalMatrixStorageDataBuilder(unsigned numberOfRows, unsigned numberOfColumns, unsigned availableThreads = 1) :
         _numberOfRows(numberOfRows), _numberOfColumns(numberOfColumns), _elementAssignmentRunning(false),
         _cooMapRowMajor(make_unique<map<tuple<unsigned, unsigned>, T>>()), 
-        _cooMapColumnMajor(make_unique<map<tuple<unsigned, unsigned>, T, _compareForColumnMajor>>()) {
+        _cooMapColumnMajor(make_unique<map<tuple<unsigned, unsigned>, T, _compareForColumnMajor>>()),
+        _threadBuffers(make_unique<map<thread::id, unique_ptr<vector<COOElement>>>>()),
+        _threadBuffersMutex(make_unique<mutex>()), _assignmentGeneration(0),
+        _availableThreads(std::max(1u, availableThreads)) {
             _zero = static_cast<T>(0);  
         }
+
+        /**
+         * @brief A (row, column, value) triplet of the thread assembly buffers.
+         */
+        struct COOElement {
+            unsigned row;
+            unsigned column;
+            T value;
+        };
         
 
         /**
@@ -47,7 +68,8 @@ namespace LinearAlgebra{
         * - The columnIndices array stores the column indices of each element in the values array.
         * 
         * This function converts the matrix from the COO format, stored in the _cooMap, 
-        * to the CSR format and returns the three arrays as shared pointers.
+        * to the CSR format and returns the three arrays as shared pointers. If elements were added through
+        * addElement(), the thread buffers and the map are merged in parallel by _mergeThreadBuffersToCSR().
         * 
         * @return A tuple containing three shared pointers:
         *         1. A pointer to the values array.
@@ -60,15 +82,18 @@ namespace LinearAlgebra{
         shared_ptr<NumericalVector<unsigned>>,
         shared_ptr<NumericalVector<unsigned>>>
         getCSRDataVectors() {
+            if(!_cooMapColumnMajor->empty())
+                throw runtime_error("Column major map is not empty. Error at matrix construction.");
+            if (!_threadBuffers->empty()) {
+                return _mergeThreadBuffersToCSR();
+            }
             if (_cooMapRowMajor->empty()) {
                 throw runtime_error("Matrix is empty.");
             }
-            if(!_cooMapColumnMajor->empty())
-                throw runtime_error("Column major map is not empty. Error at matrix construction.");
             
             auto values = make_shared<NumericalVector<T>>(_cooMapRowMajor->size());
             auto columnIndices = make_shared<NumericalVector<unsigned>>(_cooMapRowMajor->size());
-            auto rowOffsets = make_shared<NumericalVector<unsigned>>(_cooMapRowMajor->size() + 1);
+            auto rowOffsets = make_shared<NumericalVector<unsigned>>(_numberOfRows + 1, 0);
 
             unsigned currentIndex = 0;
             // Iterate through the entries in the COO map to build the CSR format.
@@ -79,14 +104,16 @@ namespace LinearAlgebra{
                 (*values)[currentIndex] = element.second;
                 (*columnIndices)[currentIndex] = col;
 
-                // Increment the rowOffsets for the current row and all subsequent rows
-                for (unsigned r = row + 1; r <= _numberOfRows; r++) {
-                    (*rowOffsets)[r]++;
-                }
+                // Count the non-zero elements of the current row
+                (*rowOffsets)[row + 1]++;
 
                 // Move to the next position in values and columnIndices
                 ++currentIndex;
             }
+            // Prefix sum of the row counts gives the starting index of each row
+            for (unsigned r = 0; r < _numberOfRows; r++) {
+                (*rowOffsets)[r + 1] += (*rowOffsets)[r];
+            }
             _cooMapRowMajor->clear();
             return make_tuple(values, columnIndices, rowOffsets);
         }
@@ -246,6 +273,32 @@ namespace LinearAlgebra{
             }
         }
 
+        /**
+        * @brief Adds a value to the element at the specified row and column. Unlike insertElement(), it can be called
+        * concurrently from any number of threads while element assignment is running.
+        *
+        * The triplet is appended to the buffer of the calling thread, which is looked up once per thread and
+        * assignment. Triplets with the same indices are summed when the CSR data vectors are built, together with the
+        * value inserted through insertElement() if there is one. getElement() and removeElement() only see the
+        * inserted values.
+        *
+        * @param row The row index.
+        * @param column The column index.
+        * @param value The value to be added.
+        *
+        * @throws out_of_range If the row or column index is out of the matrix's range.
+        * @throws runtime_error If element assignment is not running.
+        */
+        void addElement(unsigned row, unsigned column, const T &value) {
+            if (!_elementAssignmentRunning){
+                throw runtime_error("Element assignment is not running. Call enableElementAssignment() first.");
+            }
+            if (row >= this->_numberOfRows || column >= this->_numberOfColumns) {
+                throw out_of_range("Row or column index out of range.");
+            }
+            _threadBuffer().push_back({row, column, value});
+        }
+
         /**
         * @brief Retrieves a reference to the value at the specified row and column.
         * 
@@ -327,6 +380,8 @@ namespace LinearAlgebra{
          */
         void enableElementAssignment(){
             _elementAssignmentRunning = true;
+            _assignmentGeneration = _nextAssignmentGeneration();
+            _threadBuffers->clear();
         }
         
         /**
@@ -359,9 +414,165 @@ namespace LinearAlgebra{
         
         T _zero;
 
+        unique_ptr<map<thread::id, unique_ptr<vector<COOElement>>>> _threadBuffers;
 
+        unique_ptr<mutex> _threadBuffersMutex;
 
- 
+        unsigned long _assignmentGeneration;
+
+        unsigned _availableThreads;
+
+        /**
+         * @brief Unique id of every element assignment of every builder. Lets the threads cache the buffer they
+         * append to without comparing builder addresses, which may be reused.
+         */
+        static unsigned long _nextAssignmentGeneration(){
+            static atomic<unsigned long> generation(0);
+            return ++generation;
+        }
+
+        /**
+         * @brief Returns the assembly buffer of the calling thread. The mutex is only taken the first time a thread
+         * adds to this assignment, or when it alternates between assembling different matrices.
+         */
+        vector<COOElement> &_threadBuffer(){
+            thread_local unsigned long cachedGeneration = 0;
+            thread_local vector<COOElement> *cachedBuffer = nullptr;
+            if (cachedGeneration != _assignmentGeneration) {
+                lock_guard<mutex> lock(*_threadBuffersMutex);
+                auto &buffer = (*_threadBuffers)[this_thread::get_id()];
+                if (buffer == nullptr)
+                    buffer = make_unique<vector<COOElement>>();
+                cachedBuffer = buffer.get();
+                cachedGeneration = _assignmentGeneration;
+            }
+            return *cachedBuffer;
+        }
+
+        template<typename ThreadJob>
+        void _parallelFor(ThreadJob job, unsigned size, unsigned cacheLineSize = 64){
+            if (size > 0)
+                ThreadingOperations<unsigned>::executeParallelJob(job, size, _availableThreads, cacheLineSize);
+        }
+
+        /**
+         * @brief Builds the CSR data vectors from the row major map and the thread buffers in parallel.
+         *
+         * 1. Every source (the map and each thread buffer) counts its elements per row.
+         * 2. The per row totals are prefix summed and each row is split into one slot range per source, so that the
+         *    sources scatter their triplets without synchronization.
+         * 3. Every row is sorted by column and its duplicates are summed in place.
+         * 4. The compacted rows are prefix summed again and copied to the CSR vectors.
+         *
+         * Duplicates are summed in source order, the map first.
+         */
+        tuple<shared_ptr<NumericalVector<T>>,
+        shared_ptr<NumericalVector<unsigned>>,
+        shared_ptr<NumericalVector<unsigned>>>
+        _mergeThreadBuffersToCSR(){
+            auto mapElements = make_unique<vector<COOElement>>();
+            mapElements->reserve(_cooMapRowMajor->size());
+            for (const auto &element: *_cooMapRowMajor)
+                mapElements->push_back({std::get<0>(element.first), std::get<1>(element.first), element.second});
+            _cooMapRowMajor->clear();
+
+            vector<vector<COOElement>*> sources = {mapElements.get()};
+            for (auto &buffer: *_threadBuffers)
+                sources.push_back(buffer.second.get());
+            auto numberOfSources = static_cast<unsigned>(sources.size());
+            size_t numberOfTriplets = 0;
+            for (auto source: sources)
+                numberOfTriplets += source->size();
+            if (numberOfTriplets == 0) {
+                _threadBuffers->clear();
+                throw runtime_error("Matrix is empty.");
+            }
+            if (numberOfTriplets > numeric_limits<unsigned>::max())
+                throw runtime_error("Number of assembled elements exceeds the range of the CSR offsets.");
+
+            //One source per thread
+            vector<vector<unsigned>> sourceRowCounts(numberOfSources);
+            _parallelFor([&](unsigned start, unsigned end){
+                for (unsigned source = start; source < end; source++) {
+                    sourceRowCounts[source].assign(_numberOfRows, 0);
+                    for (const auto &element: *sources[source])
+                        sourceRowCounts[source][element.row]++;
+                }
+            }, numberOfSources, sizeof(unsigned));
+
+            vector<unsigned> tripletOffsets(_numberOfRows + 1, 0);
+            _parallelFor([&](unsigned start, unsigned end){
+                for (unsigned row = start; row < end; row++)
+                    for (unsigned source = 0; source < numberOfSources; source++)
+                        tripletOffsets[row + 1] += sourceRowCounts[source][row];
+            }, _numberOfRows);
+            for (unsigned row = 0; row < _numberOfRows; row++)
+                tripletOffsets[row + 1] += tripletOffsets[row];
+
+            //The counts become the next free slot of each source in each row
+            _parallelFor([&](unsigned start, unsigned end){
+                for (unsigned row = start; row < end; row++) {
+                    unsigned slot = tripletOffsets[row];
+                    for (unsigned source = 0; source < numberOfSources; source++) {
+                        unsigned count = sourceRowCounts[source][row];
+                        sourceRowCounts[source][row] = slot;
+                        slot += count;
+                    }
+                }
+            }, _numberOfRows);
+
+            vector<pair<unsigned, T>> triplets(numberOfTriplets);
+            _parallelFor([&](unsigned start, unsigned end){
+                for (unsigned source = start; source < end; source++) {
+                    auto &slots = sourceRowCounts[source];
+                    for (const auto &element: *sources[source])
+                        triplets[slots[element.row]++] = {element.column, element.value};
+                    vector<COOElement>().swap(*sources[source]);
+                    vector<unsigned>().swap(slots);
+                }
+            }, numberOfSources, sizeof(unsigned));
+            _threadBuffers->clear();
+
+            auto rowOffsets = make_shared<NumericalVector<unsigned>>(_numberOfRows + 1, 0);
+            auto &rowOffsetsData = *rowOffsets->getData();
+            _parallelFor([&](unsigned start, unsigned end){
+                for (unsigned row = start; row < end; row++) {
+                    auto rowBegin = triplets.begin() + tripletOffsets[row];
+                    auto rowEnd = triplets.begin() + tripletOffsets[row + 1];
+                    if (rowBegin == rowEnd)
+                        continue;
+                    std::stable_sort(rowBegin, rowEnd, [](const pair<unsigned, T> &a, const pair<unsigned, T> &b){
+                        return a.first < b.first;
+                    });
+                    auto unique = rowBegin;
+                    for (auto triplet = rowBegin + 1; triplet != rowEnd; ++triplet) {
+                        if (triplet->first == unique->first)
+                            unique->second += triplet->second;
+                        else
+                            *(++unique) = *triplet;
+                    }
+                    rowOffsetsData[row + 1] = static_cast<unsigned>(unique - rowBegin + 1);
+                }
+            }, _numberOfRows);
+            for (unsigned row = 0; row < _numberOfRows; row++)
+                rowOffsetsData[row + 1] += rowOffsetsData[row];
+
+            auto numberOfNonZeros = rowOffsetsData[_numberOfRows];
+            auto values = make_shared<NumericalVector<T>>(numberOfNonZeros);
+            auto columnIndices = make_shared<NumericalVector<unsigned>>(numberOfNonZeros);
+            T* valuesData = values->getDataPointer();
+            unsigned* columnIndicesData = columnIndices->getDataPointer();
+            _parallelFor([&](unsigned start, unsigned end){
+                for (unsigned row = start; row < end; row++) {
+                    unsigned source = tripletOffsets[row];
+                    for (unsigned k = rowOffsetsData[row]; k < rowOffsetsData[row + 1]; k++, source++) {
+                        columnIndicesData[k] = triplets[source].first;
+                        valuesData[k] = triplets[source].second;
+                    }
+                }
+            }, _numberOfRows);
+            return make_tuple(values, columnIndices, rowOffsets);
+        }
     };
 }
 
@@ -24,7 +24,7 @@ namespace LinearAlgebra {
         
         virtual ~NumericalMatrixStorageDataProvider() = default;
         
-        shared_ptr<NumericalVector<T>>& getValues(){
+        virtual shared_ptr<NumericalVector<T>>& getValues(){
             if (_values->empty())
                 throw runtime_error("Values vector is empty.");
             return _values;
@@ -32,6 +32,24 @@ namespace LinearAlgebra {
         
         virtual vector<shared_ptr<NumericalVector<unsigned>>> getSupplementaryVectors(){ return {}; }
         
+        /**
+        * @brief Returns a raw pointer to the stored values. Providers that do not keep their values in a NumericalVector
+        * (e.g. memory mapped files) override this so that the mathematical operations run without copying the data.
+        */
+        virtual T* getValuesDataPointer(){
+            return getValues()->getDataPointer();
+        }
+        
+        /**
+        * @brief Returns raw pointers to the supplementary vectors, in the same order as getSupplementaryVectors().
+        */
+        virtual vector<unsigned*> getSupplementaryDataPointers(){
+            vector<unsigned*> dataPointers;
+            for (auto &supplementaryVector : getSupplementaryVectors())
+                dataPointers.push_back(supplementaryVector->getDataPointer());
+            return dataPointers;
+        }
+        
         const NumericalMatrixStorageType& getStorageType(){
             return _storageType;
         }
@@ -43,6 +61,14 @@ namespace LinearAlgebra {
 
         virtual void eraseElement(unsigned row, unsigned column) {}
 
+        /**
+         * @brief Adds a value to the element at the specified row and column. Storage types that support concurrent
+         * assembly override it; the default reads and sets the element and is not thread-safe.
+         */
+        virtual void addElement(unsigned row, unsigned column, T value) {
+            setElement(row, column, getElement(row, column) + value);
+        }
+
         virtual shared_ptr<NumericalVector<T>> getRowSharedPtr(unsigned row) {}
         
         virtual shared_ptr<NumericalVector<T>> getColumnSharedPtr(unsigned column) {}
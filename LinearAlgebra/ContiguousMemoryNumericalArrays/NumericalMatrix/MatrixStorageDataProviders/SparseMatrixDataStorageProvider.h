@@ -15,10 +15,10 @@ namespace LinearAlgebra {
     public:
         SparseMatrixDataStorageProvider(unsigned numberOfRows, unsigned numberOfColumns, NumericalMatrixFormType formType, unsigned availableThreads) :
                 NumericalMatrixStorageDataProvider<T>(numberOfRows, numberOfColumns, formType, availableThreads),
-                _builder(numberOfRows, numberOfColumns),
+                _builder(numberOfRows, numberOfColumns, availableThreads),
                 _zero(static_cast<T>(0)) {
             this->_storageType = NumericalMatrixStorageType::CoordinateList;
-            this->_values = make_shared<NumericalVector<T>>(numberOfRows * numberOfColumns, 0, availableThreads);
+            this->_values = make_shared<NumericalVector<T>>(0, 0, availableThreads);
         }
 
     protected:
@@ -11,6 +11,8 @@
 #include "MatrixStorageDataProviders/FullMatrixStorageDataProvider.h"
 #include "NumericalMatrixMathematicalOperations/FullMatrixMathematicalOperationsProvider.h"
 #include "NumericalMatrixMathematicalOperations/CSRMathematicalOperationsProvider.h"
+#include "NumericalMatrixMathematicalOperations/CompressedIndexCSRMathematicalOperationsProvider.h"
+#include "NumericalMatrixMathematicalOperations/DIAMathematicalOperationsProvider.h"
 #include "NumericalMatrixMathematicalOperations/EigendecompositionProvider.h"
 using namespace std;
 
@@ -44,6 +46,22 @@ namespace LinearAlgebra {
             _math = _initializeMath();
         }
 
+        /**
+         * @brief Constructs a new NumericalMatrix object around an already populated storage provider.
+         * 
+         * Used when the storage vectors are produced outside the element assignment process (e.g. a permuted copy
+         * of a CSR matrix or a matrix read from a file). The storage is shared, not copied.
+         * 
+         * @param rows Number of rows for the matrix.
+         * @param columns Number of columns for the matrix.
+         * @param storage The storage provider holding the matrix data.
+         */
+        explicit NumericalMatrix(unsigned int rows, unsigned int columns, shared_ptr<NumericalMatrixStorageDataProvider<T>> storage) :
+                dataStorage(storage), _numberOfRows(rows), _numberOfColumns(columns),
+                _availableThreads(storage->getAvailableThreads()), _formType(storage->getFormType()) {
+            _math = _initializeMath();
+        }
+
         //TODO FIX THIS
         /**
         * Copy constructor for NumericalMatrix.
@@ -151,6 +169,14 @@ namespace LinearAlgebra {
             dataStorage->setElement(row, column, value);
         }
         
+        /**
+         * @brief Adds a value to the element at the specified row and column. For sparse storage it is thread-safe
+         * while element assignment is running and duplicates are summed when the assignment is finalized.
+         */
+        void addElement(unsigned row, unsigned column, const T &value){
+            dataStorage->addElement(row, column, value);
+        }
+
         void eraseElement(unsigned row, unsigned column, const T &value){
             dataStorage->eraseElement(row, column, value);
         }
@@ -356,8 +382,8 @@ namespace LinearAlgebra {
             _checkInputVectorDataType(resultVector);
             if (_numberOfColumns != dereference_trait_vector<InputVectorType1>::size(inputVector))
                 throw invalid_argument("Input vector must have the same number of columns as the current matrix.");
-            if (dereference_trait_vector<InputVectorType1>::size(inputVector) != dereference_trait_vector<InputVectorType2>::size(resultVector))
-                throw invalid_argument("Input vector must have the same number of rows as the result vector.");
+            if (_numberOfRows != dereference_trait_vector<InputVectorType2>::size(resultVector))
+                throw invalid_argument("Result vector must have the same number of rows as the current matrix.");
             auto inputVectorData = dereference_trait_vector<InputVectorType1>::dereference(inputVector);
             auto resultVectorData = dereference_trait_vector<InputVectorType2>::dereference(resultVector);
             
@@ -517,13 +543,19 @@ namespace LinearAlgebra {
             }
         }
         
-        unique_ptr<FullMatrixMathematicalOperationsProvider<T>> _initializeMath(){
+        unique_ptr<NumericalMatrixMathematicalOperationsProvider<T>> _initializeMath(){
             switch (dataStorage->getStorageType()) {
                 case FullMatrix:
                     return make_unique<FullMatrixMathematicalOperationsProvider<T>>(_numberOfRows, _numberOfColumns, dataStorage);
                     break;
                 case CSR:
-                    return make_unique<FullMatrixMathematicalOperationsProvider<T>>(_numberOfRows, _numberOfColumns, dataStorage);
+                    return make_unique<CSRMathematicalOperationsProvider<T>>(_numberOfRows, _numberOfColumns, dataStorage);
+                    break;
+                case CompressedIndexCSR:
+                    return make_unique<CompressedIndexCSRMathematicalOperationsProvider<T>>(_numberOfRows, _numberOfColumns, dataStorage);
+                    break;
+                case DIA:
+                    return make_unique<DIAMathematicalOperationsProvider<T>>(_numberOfRows, _numberOfColumns, dataStorage);
                     break;
                 default:
                     throw std::invalid_argument("Invalid storage type.");
@@ -17,6 +17,8 @@ namespace LinearAlgebra{
         FullMatrix,
         CoordinateList,
         CSR,
+        CompressedIndexCSR,
+        DIA,
     };
 
     enum NumericalMatrixFormType{
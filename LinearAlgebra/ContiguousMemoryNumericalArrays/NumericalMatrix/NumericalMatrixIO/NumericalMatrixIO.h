@@ -0,0 +1,464 @@
+//
+// Created by hal9000 on 10/19/23.
+//
+
+#ifndef UNTITLED_NUMERICALMATRIXIO_H
+#define UNTITLED_NUMERICALMATRIXIO_H
+
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../NumericalMatrix.h"
+#include "../MatrixStorageDataProviders/MappedCSRStorageDataProvider.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Reads and writes CSR NumericalMatrices in the Matrix Market coordinate format and in a native binary CSR
+    * format.
+    *
+    * The Matrix Market reader and writer stream the entries and never form the dense matrix.
+    *
+    * The binary format consists of a fixed size BinaryCSRHeader followed by the row offsets, the column indices and the
+    * values. Each array starts at a 64 byte aligned file position recorded in the header, so the file can be memory
+    * mapped and handed to a MappedCSRStorageDataProvider without copying.
+    *
+    * @tparam T The datatype of the matrix elements.
+    */
+    template<typename T>
+    class NumericalMatrixIO {
+    public:
+
+        /**
+        * @brief Writes a CSR matrix in the Matrix Market coordinate format (1-based indices, full precision).
+        * Matrices with the Symmetric form type are written as "symmetric" and only their lower triangle is stored.
+        *
+        * @param matrix The CSR matrix.
+        * @param filePath The path of the .mtx file.
+        */
+        static void writeMatrixMarket(NumericalMatrix<T> &matrix, const string &filePath) {
+            _checkCSRMatrix(matrix);
+            ofstream outputFile(filePath);
+            if (!outputFile.is_open())
+                throw runtime_error("Could not open file " + filePath + " for writing.");
+
+            T* values = matrix.dataStorage->getValuesDataPointer();
+            auto supplementaryDataPointers = matrix.dataStorage->getSupplementaryDataPointers();
+            unsigned* columnIndices = supplementaryDataPointers[0];
+            unsigned* rowOffsets = supplementaryDataPointers[1];
+            unsigned n = matrix.numberOfRows();
+            bool symmetric = matrix.dataStorage->getFormType() == Symmetric;
+
+            unsigned numberOfEntries = 0;
+            for (unsigned row = 0; row < n; row++)
+                for (unsigned k = rowOffsets[row]; k < rowOffsets[row + 1]; k++)
+                    if (!symmetric || columnIndices[k] <= row)
+                        numberOfEntries++;
+
+            outputFile << "%%MatrixMarket matrix coordinate real " << (symmetric ? "symmetric" : "general") << "\n";
+            outputFile << matrix.numberOfRows() << " " << matrix.numberOfColumns() << " " << numberOfEntries << "\n";
+            outputFile.precision(numeric_limits<T>::max_digits10);
+            for (unsigned row = 0; row < n; row++) {
+                for (unsigned k = rowOffsets[row]; k < rowOffsets[row + 1]; k++) {
+                    if (!symmetric || columnIndices[k] <= row)
+                        outputFile << row + 1 << " " << columnIndices[k] + 1 << " " << values[k] << "\n";
+                }
+            }
+            if (!outputFile.good())
+                throw runtime_error("Error while writing file " + filePath + ".");
+        }
+
+        /**
+        * @brief Reads a Matrix Market coordinate file (real, integer or pattern; general, symmetric or skew-symmetric)
+        * into a CSR matrix. The entries are streamed into coordinate arrays and converted to CSR with a counting sort.
+        * Duplicate entries are summed.
+        *
+        * @param filePath The path of the .mtx file.
+        * @param availableThreads The number of threads of the returned matrix.
+        * @return The CSR matrix. Symmetric files produce a matrix with the Symmetric form type that stores both triangles.
+        */
+        static shared_ptr<NumericalMatrix<T>> readMatrixMarket(const string &filePath, unsigned availableThreads = 1) {
+            ifstream inputFile(filePath);
+            if (!inputFile.is_open())
+                throw runtime_error("Could not open file " + filePath + " for reading.");
+
+            string line, banner, object, format, field, symmetry;
+            getline(inputFile, line);
+            istringstream bannerStream(line);
+            bannerStream >> banner >> object >> format >> field >> symmetry;
+            _toLower(object); _toLower(format); _toLower(field); _toLower(symmetry);
+            if (banner != "%%MatrixMarket" || object != "matrix" || format != "coordinate")
+                throw runtime_error("File " + filePath + " is not a Matrix Market coordinate matrix.");
+            if (field != "real" && field != "double" && field != "integer" && field != "pattern")
+                throw runtime_error("Unsupported Matrix Market field " + field + ".");
+            if (symmetry != "general" && symmetry != "symmetric" && symmetry != "skew-symmetric")
+                throw runtime_error("Unsupported Matrix Market symmetry " + symmetry + ".");
+            bool pattern = field == "pattern";
+            bool mirrored = symmetry != "general";
+            T mirrorSign = symmetry == "skew-symmetric" ? static_cast<T>(-1) : static_cast<T>(1);
+
+            while (getline(inputFile, line) && (line.empty() || line[0] == '%')) {}
+            unsigned numberOfRows, numberOfColumns, numberOfEntries;
+            istringstream sizeStream(line);
+            if (!(sizeStream >> numberOfRows >> numberOfColumns >> numberOfEntries))
+                throw runtime_error("Invalid Matrix Market size line in file " + filePath + ".");
+
+            vector<unsigned> rowIndices, columnIndices;
+            vector<T> values;
+            unsigned capacity = mirrored ? 2 * numberOfEntries : numberOfEntries;
+            rowIndices.reserve(capacity);
+            columnIndices.reserve(capacity);
+            values.reserve(capacity);
+            for (unsigned entry = 0; entry < numberOfEntries; entry++) {
+                unsigned row, column;
+                T value = static_cast<T>(1);
+                if (!(inputFile >> row >> column) || (!pattern && !(inputFile >> value)))
+                    throw runtime_error("Unexpected end of Matrix Market data in file " + filePath + ".");
+                if (row == 0 || column == 0 || row > numberOfRows || column > numberOfColumns)
+                    throw out_of_range("Matrix Market entry out of bounds in file " + filePath + ".");
+                rowIndices.push_back(row - 1);
+                columnIndices.push_back(column - 1);
+                values.push_back(value);
+                if (mirrored && row != column) {
+                    rowIndices.push_back(column - 1);
+                    columnIndices.push_back(row - 1);
+                    values.push_back(mirrorSign * value);
+                }
+            }
+            auto formType = symmetry == "symmetric" ? Symmetric : General;
+            return _coordinatesToCSR(rowIndices, columnIndices, values, numberOfRows, numberOfColumns, formType, availableThreads);
+        }
+
+        /**
+        * @brief Writes a vector in the Matrix Market array format.
+        */
+        static void writeMatrixMarketVector(const NumericalVector<T> &vector, const string &filePath) {
+            ofstream outputFile(filePath);
+            if (!outputFile.is_open())
+                throw runtime_error("Could not open file " + filePath + " for writing.");
+            outputFile << "%%MatrixMarket matrix array real general\n";
+            outputFile << vector.size() << " 1\n";
+            outputFile.precision(numeric_limits<T>::max_digits10);
+            const T* data = vector.getDataPointer();
+            for (unsigned i = 0; i < vector.size(); i++)
+                outputFile << data[i] << "\n";
+            if (!outputFile.good())
+                throw runtime_error("Error while writing file " + filePath + ".");
+        }
+
+        /**
+        * @brief Reads a single column Matrix Market array file into a vector.
+        */
+        static shared_ptr<NumericalVector<T>> readMatrixMarketVector(const string &filePath, unsigned availableThreads = 1) {
+            ifstream inputFile(filePath);
+            if (!inputFile.is_open())
+                throw runtime_error("Could not open file " + filePath + " for reading.");
+            string line, banner, object, format;
+            getline(inputFile, line);
+            istringstream bannerStream(line);
+            bannerStream >> banner >> object >> format;
+            _toLower(format);
+            if (banner != "%%MatrixMarket" || format != "array")
+                throw runtime_error("File " + filePath + " is not a Matrix Market array.");
+            while (getline(inputFile, line) && (line.empty() || line[0] == '%')) {}
+            unsigned numberOfRows, numberOfColumns;
+            istringstream sizeStream(line);
+            if (!(sizeStream >> numberOfRows >> numberOfColumns) || numberOfColumns != 1)
+                throw runtime_error("Matrix Market array in file " + filePath + " is not a column vector.");
+            auto vector = make_shared<NumericalVector<T>>(numberOfRows, 0, availableThreads);
+            T* data = vector->getDataPointer();
+            for (unsigned i = 0; i < numberOfRows; i++) {
+                if (!(inputFile >> data[i]))
+                    throw runtime_error("Unexpected end of Matrix Market data in file " + filePath + ".");
+            }
+            return vector;
+        }
+
+        /**
+        * @brief Writes a CSR matrix in the native binary CSR format.
+        *
+        * @param matrix The CSR matrix.
+        * @param filePath The path of the binary file.
+        */
+        static void writeBinaryCSR(NumericalMatrix<T> &matrix, const string &filePath) {
+            _checkCSRMatrix(matrix);
+            T* values = matrix.dataStorage->getValuesDataPointer();
+            auto supplementaryDataPointers = matrix.dataStorage->getSupplementaryDataPointers();
+            unsigned* columnIndices = supplementaryDataPointers[0];
+            unsigned* rowOffsets = supplementaryDataPointers[1];
+            uint64_t numberOfNonZeros = rowOffsets[matrix.numberOfRows()];
+
+            BinaryCSRHeader header = _header(matrix.numberOfRows(), matrix.numberOfColumns(), numberOfNonZeros,
+                                             matrix.dataStorage->getFormType());
+            ofstream outputFile(filePath, ios::binary);
+            if (!outputFile.is_open())
+                throw runtime_error("Could not open file " + filePath + " for writing.");
+            outputFile.write(reinterpret_cast<const char*>(&header), sizeof(BinaryCSRHeader));
+            _writeArray(outputFile, header.rowOffsetsPosition, rowOffsets, header.numberOfRows + 1);
+            _writeArray(outputFile, header.columnIndicesPosition, columnIndices, numberOfNonZeros);
+            _writeArray(outputFile, header.valuesPosition, values, numberOfNonZeros);
+            if (!outputFile.good())
+                throw runtime_error("Error while writing file " + filePath + ".");
+        }
+
+        /**
+        * @brief Reads a native binary CSR file.
+        *
+        * @param filePath The path of the binary file.
+        * @param availableThreads The number of threads of the returned matrix.
+        * @param memoryMap If true the file is memory mapped read-only and the returned matrix uses the mapped arrays
+        * directly (MappedCSRStorageDataProvider). The mapping is released when the matrix storage is destroyed.
+        * If false the arrays are read into a regular, modifiable CSRStorageDataProvider.
+        * @return The CSR matrix.
+        */
+        static shared_ptr<NumericalMatrix<T>> readBinaryCSR(const string &filePath, unsigned availableThreads = 1,
+                                                            bool memoryMap = true) {
+            if (memoryMap)
+                return _mapBinaryCSR(filePath, availableThreads);
+
+            ifstream inputFile(filePath, ios::binary);
+            if (!inputFile.is_open())
+                throw runtime_error("Could not open file " + filePath + " for reading.");
+            inputFile.seekg(0, ios::end);
+            uint64_t fileSize = static_cast<uint64_t>(inputFile.tellg());
+            inputFile.seekg(0, ios::beg);
+            BinaryCSRHeader header;
+            if (fileSize < sizeof(BinaryCSRHeader) || !inputFile.read(reinterpret_cast<char*>(&header), sizeof(BinaryCSRHeader)))
+                throw runtime_error("File " + filePath + " is too small to be a binary CSR file.");
+            _checkHeader(header, fileSize, filePath);
+
+            auto rowOffsets = make_shared<NumericalVector<unsigned>>(header.numberOfRows + 1, 0, availableThreads);
+            auto columnIndices = make_shared<NumericalVector<unsigned>>(header.numberOfNonZeros, 0, availableThreads);
+            auto values = make_shared<NumericalVector<T>>(header.numberOfNonZeros, 0, availableThreads);
+            _readArray(inputFile, header.rowOffsetsPosition, rowOffsets->getDataPointer(), header.numberOfRows + 1);
+            _readArray(inputFile, header.columnIndicesPosition, columnIndices->getDataPointer(), header.numberOfNonZeros);
+            _readArray(inputFile, header.valuesPosition, values->getDataPointer(), header.numberOfNonZeros);
+            if (!inputFile.good())
+                throw runtime_error("Error while reading file " + filePath + ".");
+            _checkStructure(rowOffsets->getDataPointer(), columnIndices->getDataPointer(), header, filePath);
+
+            auto storage = make_shared<CSRStorageDataProvider<T>>(values, columnIndices, rowOffsets, header.numberOfRows,
+                                                                  header.numberOfColumns, availableThreads,
+                                                                  static_cast<NumericalMatrixFormType>(header.formType));
+            return make_shared<NumericalMatrix<T>>(header.numberOfRows, header.numberOfColumns, storage);
+        }
+
+    private:
+
+        /**
+        * @brief Header of the binary CSR format. All positions are byte offsets from the beginning of the file.
+        */
+        struct BinaryCSRHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t byteOrderMark;
+            uint32_t valueSize;
+            uint32_t indexSize;
+            uint32_t formType;
+            uint32_t reserved;
+            uint64_t numberOfRows;
+            uint64_t numberOfColumns;
+            uint64_t numberOfNonZeros;
+            uint64_t rowOffsetsPosition;
+            uint64_t columnIndicesPosition;
+            uint64_t valuesPosition;
+        };
+
+        static const char* _magic() {
+            return "BGMCSR\0";
+        }
+
+        static constexpr uint32_t _version = 1;
+
+        static constexpr uint32_t _byteOrderMark = 0x01020304;
+
+        static constexpr uint64_t _alignment = 64;
+
+        static uint64_t _aligned(uint64_t position) {
+            return (position + _alignment - 1) / _alignment * _alignment;
+        }
+
+        static BinaryCSRHeader _header(uint64_t numberOfRows, uint64_t numberOfColumns, uint64_t numberOfNonZeros,
+                                       NumericalMatrixFormType formType) {
+            BinaryCSRHeader header;
+            memset(&header, 0, sizeof(BinaryCSRHeader));
+            memcpy(header.magic, _magic(), sizeof(header.magic));
+            header.version = _version;
+            header.byteOrderMark = _byteOrderMark;
+            header.valueSize = sizeof(T);
+            header.indexSize = sizeof(unsigned);
+            header.formType = static_cast<uint32_t>(formType);
+            header.numberOfRows = numberOfRows;
+            header.numberOfColumns = numberOfColumns;
+            header.numberOfNonZeros = numberOfNonZeros;
+            header.rowOffsetsPosition = _aligned(sizeof(BinaryCSRHeader));
+            header.columnIndicesPosition = _aligned(header.rowOffsetsPosition + (numberOfRows + 1) * sizeof(unsigned));
+            header.valuesPosition = _aligned(header.columnIndicesPosition + numberOfNonZeros * sizeof(unsigned));
+            return header;
+        }
+
+        static void _checkHeader(const BinaryCSRHeader &header, uint64_t fileSize, const string &filePath) {
+            if (memcmp(header.magic, _magic(), sizeof(header.magic)) != 0)
+                throw runtime_error("File " + filePath + " is not a binary CSR file.");
+            if (header.version != _version)
+                throw runtime_error("Unsupported binary CSR version in file " + filePath + ".");
+            if (header.byteOrderMark != _byteOrderMark)
+                throw runtime_error("Binary CSR file " + filePath + " was written with a different byte order.");
+            if (header.valueSize != sizeof(T) || header.indexSize != sizeof(unsigned))
+                throw runtime_error("Binary CSR file " + filePath + " was written with different value or index types.");
+            if (header.numberOfRows > numeric_limits<unsigned>::max() || header.numberOfColumns > numeric_limits<unsigned>::max() ||
+                header.numberOfNonZeros > numeric_limits<unsigned>::max())
+                throw runtime_error("Binary CSR file " + filePath + " is too large for 32 bit indices.");
+            if (header.rowOffsetsPosition % _alignment != 0 || header.columnIndicesPosition % _alignment != 0 ||
+                header.valuesPosition % _alignment != 0 ||
+                !_fits(header.rowOffsetsPosition, (header.numberOfRows + 1) * sizeof(unsigned), fileSize) ||
+                !_fits(header.columnIndicesPosition, header.numberOfNonZeros * sizeof(unsigned), fileSize) ||
+                !_fits(header.valuesPosition, header.numberOfNonZeros * sizeof(T), fileSize))
+                throw runtime_error("Binary CSR file " + filePath + " is truncated or corrupted.");
+        }
+
+        /**
+        * @brief Whether [position, position + bytes) lies in the file. Written without position + bytes, which wraps
+        * for a corrupted position near 2^64. bytes cannot wrap since the counts were checked against 32 bit indices.
+        */
+        static bool _fits(uint64_t position, uint64_t bytes, uint64_t fileSize) {
+            return position <= fileSize && bytes <= fileSize - position;
+        }
+
+        /**
+        * @brief Checks that the row offsets start at 0, end at nnz and never decrease, and that every column index is
+        * in range, so that the SpMV kernels cannot read outside the arrays of a corrupted file.
+        */
+        static void _checkStructure(const unsigned* rowOffsets, const unsigned* columnIndices, const BinaryCSRHeader &header,
+                                    const string &filePath) {
+            if (rowOffsets[0] != 0 || rowOffsets[header.numberOfRows] != header.numberOfNonZeros)
+                throw runtime_error("Binary CSR file " + filePath + " has inconsistent row offsets.");
+            for (uint64_t row = 0; row < header.numberOfRows; row++)
+                if (rowOffsets[row] > rowOffsets[row + 1])
+                    throw runtime_error("Binary CSR file " + filePath + " has decreasing row offsets at row " + to_string(row) + ".");
+            for (uint64_t k = 0; k < header.numberOfNonZeros; k++)
+                if (columnIndices[k] >= header.numberOfColumns)
+                    throw runtime_error("Binary CSR file " + filePath + " has an out of range column index at position " +
+                                        to_string(k) + ".");
+        }
+
+        static shared_ptr<NumericalMatrix<T>> _mapBinaryCSR(const string &filePath, unsigned availableThreads) {
+            int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+            if (fileDescriptor < 0)
+                throw runtime_error("Could not open file " + filePath + " for reading.");
+            struct stat fileStatus;
+            if (fstat(fileDescriptor, &fileStatus) != 0 || static_cast<uint64_t>(fileStatus.st_size) < sizeof(BinaryCSRHeader)) {
+                close(fileDescriptor);
+                throw runtime_error("File " + filePath + " is too small to be a binary CSR file.");
+            }
+            size_t fileSize = static_cast<size_t>(fileStatus.st_size);
+            void* address = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+            close(fileDescriptor);
+            if (address == MAP_FAILED)
+                throw runtime_error("Could not memory map file " + filePath + ".");
+            auto mapping = shared_ptr<const void>(address, [fileSize](const void* mappedAddress) {
+                munmap(const_cast<void*>(mappedAddress), fileSize);
+            });
+
+            auto bytes = static_cast<const char*>(address);
+            auto &header = *reinterpret_cast<const BinaryCSRHeader*>(bytes);
+            _checkHeader(header, fileSize, filePath);
+            auto rowOffsets = reinterpret_cast<const unsigned*>(bytes + header.rowOffsetsPosition);
+            auto columnIndices = reinterpret_cast<const unsigned*>(bytes + header.columnIndicesPosition);
+            _checkStructure(rowOffsets, columnIndices, header, filePath);
+
+            auto storage = make_shared<MappedCSRStorageDataProvider<T>>(
+                    mapping, reinterpret_cast<const T*>(bytes + header.valuesPosition), columnIndices, rowOffsets,
+                    header.numberOfRows, header.numberOfColumns, header.numberOfNonZeros,
+                    static_cast<NumericalMatrixFormType>(header.formType), availableThreads);
+            return make_shared<NumericalMatrix<T>>(header.numberOfRows, header.numberOfColumns, storage);
+        }
+
+        template<typename ArrayType>
+        static void _writeArray(ofstream &outputFile, uint64_t position, const ArrayType* data, uint64_t size) {
+            static const char padding[_alignment] = {};
+            uint64_t currentPosition = static_cast<uint64_t>(outputFile.tellp());
+            outputFile.write(padding, static_cast<streamsize>(position - currentPosition));
+            outputFile.write(reinterpret_cast<const char*>(data), static_cast<streamsize>(size * sizeof(ArrayType)));
+        }
+
+        template<typename ArrayType>
+        static void _readArray(ifstream &inputFile, uint64_t position, ArrayType* data, uint64_t size) {
+            inputFile.seekg(static_cast<streamoff>(position));
+            inputFile.read(reinterpret_cast<char*>(data), static_cast<streamsize>(size * sizeof(ArrayType)));
+        }
+
+        /**
+        * @brief Converts coordinate arrays to a CSR matrix. The entries are bucketed by row with a counting sort,
+        * sorted by column inside each row and duplicates are summed.
+        */
+        static shared_ptr<NumericalMatrix<T>> _coordinatesToCSR(const vector<unsigned> &rowIndices, const vector<unsigned> &columnIndices,
+                                                               const vector<T> &values, unsigned numberOfRows, unsigned numberOfColumns,
+                                                               NumericalMatrixFormType formType, unsigned availableThreads) {
+            unsigned numberOfEntries = rowIndices.size();
+            vector<unsigned> bucketOffsets(numberOfRows + 1, 0);
+            for (unsigned entry = 0; entry < numberOfEntries; entry++)
+                bucketOffsets[rowIndices[entry] + 1]++;
+            for (unsigned row = 0; row < numberOfRows; row++)
+                bucketOffsets[row + 1] += bucketOffsets[row];
+
+            vector<pair<unsigned, T>> bucket(numberOfEntries);
+            vector<unsigned> position(bucketOffsets.begin(), bucketOffsets.end() - 1);
+            for (unsigned entry = 0; entry < numberOfEntries; entry++)
+                bucket[position[rowIndices[entry]]++] = make_pair(columnIndices[entry], values[entry]);
+
+            auto csrRowOffsets = make_shared<NumericalVector<unsigned>>(numberOfRows + 1, 0, availableThreads);
+            auto csrColumnIndices = make_shared<NumericalVector<unsigned>>(numberOfEntries, 0, availableThreads);
+            auto csrValues = make_shared<NumericalVector<T>>(numberOfEntries, 0, availableThreads);
+            unsigned* rowOffsetsData = csrRowOffsets->getDataPointer();
+            unsigned* columnIndicesData = csrColumnIndices->getDataPointer();
+            T* valuesData = csrValues->getDataPointer();
+
+            unsigned numberOfNonZeros = 0;
+            for (unsigned row = 0; row < numberOfRows; row++) {
+                auto rowBegin = bucket.begin() + bucketOffsets[row];
+                auto rowEnd = bucket.begin() + bucketOffsets[row + 1];
+                std::sort(rowBegin, rowEnd, [](const pair<unsigned, T> &a, const pair<unsigned, T> &b) {
+                    return a.first < b.first;
+                });
+                unsigned rowStart = numberOfNonZeros;
+                for (auto entry = rowBegin; entry != rowEnd; ++entry) {
+                    if (numberOfNonZeros > rowStart && columnIndicesData[numberOfNonZeros - 1] == entry->first) {
+                        valuesData[numberOfNonZeros - 1] += entry->second;
+                    }
+                    else {
+                        columnIndicesData[numberOfNonZeros] = entry->first;
+                        valuesData[numberOfNonZeros] = entry->second;
+                        numberOfNonZeros++;
+                    }
+                }
+                rowOffsetsData[row + 1] = numberOfNonZeros;
+            }
+            csrColumnIndices->getData()->resize(numberOfNonZeros);
+            csrValues->getData()->resize(numberOfNonZeros);
+
+            auto storage = make_shared<CSRStorageDataProvider<T>>(csrValues, csrColumnIndices, csrRowOffsets, numberOfRows,
+                                                                  numberOfColumns, availableThreads, formType);
+            return make_shared<NumericalMatrix<T>>(numberOfRows, numberOfColumns, storage);
+        }
+
+        static void _checkCSRMatrix(NumericalMatrix<T> &matrix) {
+            if (matrix.dataStorage->getStorageType() != CSR)
+                throw invalid_argument("Matrix IO requires a matrix stored in CSR format.");
+        }
+
+        static void _toLower(string &text) {
+            std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_NUMERICALMATRIXIO_H
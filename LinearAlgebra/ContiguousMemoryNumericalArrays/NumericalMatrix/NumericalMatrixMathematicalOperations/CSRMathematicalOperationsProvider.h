@@ -5,11 +5,154 @@
 #ifndef UNTITLED_CSRMATHEMATICALOPERATIONSPROVIDER_H
 #define UNTITLED_CSRMATHEMATICALOPERATIONSPROVIDER_H
 
+#include "NumericalMatrixMathematicalOperationsProvider.h"
+
 namespace LinearAlgebra {
 
     template<typename T>
-    class CSRMathematicalOperationsProvider {
+    class CSRMathematicalOperationsProvider : public NumericalMatrixMathematicalOperationsProvider<T> {
+    public:
+        explicit CSRMathematicalOperationsProvider(unsigned numberOfRows, unsigned numberOfColumns,
+                shared_ptr<NumericalMatrixStorageDataProvider<T>>& storageData) :
+                NumericalMatrixMathematicalOperationsProvider<T>(numberOfRows, numberOfColumns, storageData) {
+        }
+
+        /**
+        * @brief Performs the sparse matrix-vector multiplication y = scaleThis * scaleOther * A * x.
+        *
+        * With one thread the rows are multiplied in order. With more threads the work is split by the merge path
+        * (see mergePathPartition()), so every thread gets the same number of rows plus non-zero elements no matter
+        * how the row lengths vary. A thread whose range ends inside a row returns the partial sum of that row as a
+        * carry-out, which is added to y after all threads have finished.
+        *
+        * @param vector Pointer to the input vector x.
+        * @param resultVector Pointer to the result vector y.
+        * @param scaleThis Scaling factor for the matrix.
+        * @param scaleOther Scaling factor for the input vector.
+        * @param availableThreads Number of threads used for the multiplication.
+        */
+        void vectorMultiplication(T *vector, T *resultVector, T scaleThis, T scaleOther, unsigned availableThreads) override {
+
+            T* values = this->_storageData->getValuesDataPointer();
+            auto supplementaryDataPointers = this->_storageData->getSupplementaryDataPointers();
+            unsigned* columnIndices = supplementaryDataPointers[0];
+            unsigned* rowOffsets = supplementaryDataPointers[1];
+
+            unsigned numRows = this->_numberOfRows;
+            T scale = scaleThis * scaleOther;
+
+            if (availableThreads <= 1) {
+                for (unsigned row = 0; row < numRows; ++row) {
+                    T sum = 0;
+                    for (unsigned k = rowOffsets[row]; k < rowOffsets[row + 1]; ++k) {
+                        sum += values[k] * vector[columnIndices[k]];
+                    }
+                    resultVector[row] = scale * sum;
+                }
+                return;
+            }
+
+            const auto &splits = mergePathPartition(availableThreads);
+            auto numberOfPartitions = static_cast<unsigned>(splits.size() - 1);
+            std::vector<T> carryOuts(numberOfPartitions, 0);
+
+            auto multiplyJob = [&](unsigned startPartition, unsigned endPartition) -> void {
+                for (unsigned partition = startPartition; partition < endPartition; ++partition) {
+                    unsigned k = splits[partition].second;
+                    unsigned endRow = splits[partition + 1].first;
+                    unsigned endNonZero = splits[partition + 1].second;
+                    //Rows that end inside the partition. The first one may have started in a previous partition.
+                    for (unsigned row = splits[partition].first; row < endRow; ++row) {
+                        T sum = 0;
+                        for (; k < rowOffsets[row + 1]; ++k) {
+                            sum += values[k] * vector[columnIndices[k]];
+                        }
+                        resultVector[row] = scale * sum;
+                    }
+                    //Partial sum of the row that continues in the next partition
+                    T carryOut = 0;
+                    for (; k < endNonZero; ++k) {
+                        carryOut += values[k] * vector[columnIndices[k]];
+                    }
+                    carryOuts[partition] = scale * carryOut;
+                }
+            };
+            ThreadingOperations<T>::executeParallelJob(multiplyJob, numberOfPartitions, availableThreads, sizeof(T));
+
+            for (unsigned partition = 0; partition < numberOfPartitions; ++partition) {
+                unsigned carryRow = splits[partition + 1].first;
+                if (carryRow < numRows)
+                    resultVector[carryRow] += carryOuts[partition];
+            }
+        }
+
+        /**
+        * @brief Returns the merge path partition of the matrix for the given number of threads.
+        *
+        * The SpMV is seen as the merge of the row end offsets with the sequence 0, 1, ..., nnz - 1 of non-zero
+        * element positions: consuming a row end writes y[row], consuming a position multiplies one element. The path
+        * has numberOfRows + nnz steps and is cut on equally spaced diagonals by a binary search for each cut, so each
+        * partition performs the same amount of work within one step.
+        *
+        * Split p = (row, k) means that partition p starts at non-zero element k of row, with
+        * rowOffsets[row] <= k <= rowOffsets[row + 1]. The last split is (numberOfRows, nnz).
+        *
+        * The partition is cached and reused by every SpMV of the matrix with the same number of threads. Before reuse
+        * every split is checked against the current row offsets, which costs O(threads), and the partition is
+        * recomputed if the storage changed. Not thread-safe: concurrent SpMVs of the same matrix must use the same
+        * number of threads.
+        */
+        const vector<pair<unsigned, unsigned>> &mergePathPartition(unsigned availableThreads) {
+            auto supplementaryDataPointers = this->_storageData->getSupplementaryDataPointers();
+            const unsigned* rowOffsets = supplementaryDataPointers[1];
+            unsigned numRows = this->_numberOfRows;
+            unsigned numberOfPartitions = std::max(1u, availableThreads);
+
+            if (_mergePathSplits.size() != numberOfPartitions + 1 || !_isValidPartition(rowOffsets)) {
+                unsigned numberOfNonZeros = rowOffsets[numRows];
+                unsigned long pathLength = static_cast<unsigned long>(numRows) + numberOfNonZeros;
+                _mergePathSplits.resize(numberOfPartitions + 1);
+                for (unsigned partition = 0; partition <= numberOfPartitions; ++partition) {
+                    unsigned long diagonal = std::min(pathLength, (pathLength * partition + numberOfPartitions - 1) / numberOfPartitions);
+                    _mergePathSplits[partition] = _mergePathSearch(diagonal, rowOffsets, numRows, numberOfNonZeros);
+                }
+            }
+            return _mergePathSplits;
+        }
+
+    private:
+
+        vector<pair<unsigned, unsigned>> _mergePathSplits;
+
+        /**
+        * @brief Finds the point of the merge path on the given diagonal (row + k = diagonal). Row ends are consumed
+        * before the positions they are equal to, so empty rows are consumed without taking a position.
+        */
+        static pair<unsigned, unsigned> _mergePathSearch(unsigned long diagonal, const unsigned* rowOffsets,
+                                                         unsigned numRows, unsigned numberOfNonZeros) {
+            unsigned long low = diagonal > numberOfNonZeros ? diagonal - numberOfNonZeros : 0;
+            unsigned long high = std::min(diagonal, static_cast<unsigned long>(numRows));
+            while (low < high) {
+                unsigned long pivot = (low + high) / 2;
+                if (rowOffsets[pivot + 1] <= diagonal - pivot - 1)
+                    low = pivot + 1;
+                else
+                    high = pivot;
+            }
+            return {static_cast<unsigned>(low), static_cast<unsigned>(diagonal - low)};
+        }
 
+        bool _isValidPartition(const unsigned* rowOffsets) const {
+            unsigned numRows = this->_numberOfRows;
+            if (_mergePathSplits.back() != make_pair(numRows, rowOffsets[numRows]))
+                return false;
+            for (auto &split : _mergePathSplits) {
+                if (split.first < numRows &&
+                    (split.second < rowOffsets[split.first] || split.second > rowOffsets[split.first + 1]))
+                    return false;
+            }
+            return true;
+        }
     };
 
 } // LinearAlgebra
@@ -0,0 +1,87 @@
+//
+// Created by hal9000 on 10/20/23.
+//
+
+#ifndef UNTITLED_COMPRESSEDINDEXCSRMATHEMATICALOPERATIONSPROVIDER_H
+#define UNTITLED_COMPRESSEDINDEXCSRMATHEMATICALOPERATIONSPROVIDER_H
+
+#include "NumericalMatrixMathematicalOperationsProvider.h"
+#include "../MatrixStorageDataProviders/CompressedIndexCSRStorageDataProvider.h"
+
+namespace LinearAlgebra {
+
+    template<typename T>
+    class CompressedIndexCSRMathematicalOperationsProvider : public NumericalMatrixMathematicalOperationsProvider<T> {
+    public:
+        explicit CompressedIndexCSRMathematicalOperationsProvider(unsigned numberOfRows, unsigned numberOfColumns,
+                shared_ptr<NumericalMatrixStorageDataProvider<T>>& storageData) :
+                NumericalMatrixMathematicalOperationsProvider<T>(numberOfRows, numberOfColumns, storageData) {
+            _compressedStorage = dynamic_pointer_cast<CompressedIndexCSRStorageDataProvider<T>>(storageData);
+            if (_compressedStorage == nullptr)
+                throw invalid_argument("Storage is not a compressed index CSR storage.");
+        }
+
+        /**
+        * @brief Performs the sparse matrix-vector multiplication y = scaleThis * scaleOther * A * x, decoding the
+        * column indices on the fly.
+        *
+        * The row segments of the storage are distributed in contiguous blocks among the available threads. Each segment
+        * starts with a known exception position, so it is decoded independently.
+        *
+        * @param vector Pointer to the input vector x.
+        * @param resultVector Pointer to the result vector y.
+        * @param scaleThis Scaling factor for the matrix.
+        * @param scaleOther Scaling factor for the input vector.
+        * @param availableThreads Number of threads used for the multiplication.
+        */
+        void vectorMultiplication(T *vector, T *resultVector, T scaleThis, T scaleOther, unsigned availableThreads) override {
+            if (_compressedStorage->getDeltaSize() == sizeof(uint8_t))
+                _decodingMultiplication<uint8_t>(vector, resultVector, scaleThis * scaleOther, availableThreads);
+            else
+                _decodingMultiplication<uint16_t>(vector, resultVector, scaleThis * scaleOther, availableThreads);
+        }
+
+    private:
+        shared_ptr<CompressedIndexCSRStorageDataProvider<T>> _compressedStorage;
+
+        template<typename DeltaType>
+        void _decodingMultiplication(T *vector, T *resultVector, T scale, unsigned availableThreads) {
+            auto supplementaryDataPointers = _compressedStorage->getSupplementaryDataPointers();
+            const unsigned* rowOffsets = supplementaryDataPointers[0];
+            const unsigned* exceptionColumns = supplementaryDataPointers[1];
+            const unsigned* segmentExceptionOffsets = supplementaryDataPointers[2];
+            const T* values = _compressedStorage->getValuesDataPointer();
+            const auto deltas = reinterpret_cast<const DeltaType*>(_compressedStorage->getDeltas());
+            const DeltaType escape = numeric_limits<DeltaType>::max();
+            unsigned rowsPerSegment = _compressedStorage->getRowsPerSegment();
+            unsigned numRows = this->_numberOfRows;
+
+            auto multiplyJob = [&](unsigned startSegment, unsigned endSegment) -> void {
+                for (unsigned segment = startSegment; segment < endSegment; ++segment) {
+                    unsigned exception = segmentExceptionOffsets[segment];
+                    unsigned firstColumn = 0;
+                    unsigned endRow = std::min(numRows, (segment + 1) * rowsPerSegment);
+                    for (unsigned row = segment * rowsPerSegment; row < endRow; ++row) {
+                        unsigned k = rowOffsets[row];
+                        unsigned rowEnd = rowOffsets[row + 1];
+                        T sum = 0;
+                        if (k < rowEnd) {
+                            unsigned column = deltas[k] == escape ? exceptionColumns[exception++] : firstColumn + deltas[k];
+                            firstColumn = column;
+                            sum += values[k] * vector[column];
+                            for (++k; k < rowEnd; ++k) {
+                                column = deltas[k] == escape ? exceptionColumns[exception++] : column + deltas[k];
+                                sum += values[k] * vector[column];
+                            }
+                        }
+                        resultVector[row] = scale * sum;
+                    }
+                }
+            };
+            ThreadingOperations<T>::executeParallelJob(multiplyJob, _compressedStorage->getNumberOfSegments(), availableThreads);
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_COMPRESSEDINDEXCSRMATHEMATICALOPERATIONSPROVIDER_H
@@ -0,0 +1,80 @@
+//
+// Created by hal9000 on 10/23/23.
+//
+
+#ifndef UNTITLED_DIAMATHEMATICALOPERATIONSPROVIDER_H
+#define UNTITLED_DIAMATHEMATICALOPERATIONSPROVIDER_H
+
+#include "NumericalMatrixMathematicalOperationsProvider.h"
+#include "../MatrixStorageDataProviders/DIAStorageDataProvider.h"
+
+namespace LinearAlgebra {
+
+    template<typename T>
+    class DIAMathematicalOperationsProvider : public NumericalMatrixMathematicalOperationsProvider<T> {
+    public:
+        explicit DIAMathematicalOperationsProvider(unsigned numberOfRows, unsigned numberOfColumns,
+                shared_ptr<NumericalMatrixStorageDataProvider<T>>& storageData) :
+                NumericalMatrixMathematicalOperationsProvider<T>(numberOfRows, numberOfColumns, storageData) {
+            _diagonalStorage = dynamic_pointer_cast<DIAStorageDataProvider<T>>(storageData);
+            if (_diagonalStorage == nullptr)
+                throw invalid_argument("Storage is not a diagonal storage.");
+        }
+
+        /**
+        * @brief Performs the sparse matrix-vector multiplication y = scaleThis * scaleOther * A * x diagonal by diagonal.
+        *
+        * The rows are distributed in contiguous blocks among the available threads and every block is processed in
+        * chunks that keep their part of y in the L1 cache. For each diagonal of offset o the chunk computes
+        * y[i] += diagonal[i] * x[i + o] over the rows where i + o is a column of the matrix. The loop has unit stride
+        * and no indirection, so the compiler vectorizes it.
+        *
+        * @param vector Pointer to the input vector x.
+        * @param resultVector Pointer to the result vector y.
+        * @param scaleThis Scaling factor for the matrix.
+        * @param scaleOther Scaling factor for the input vector.
+        * @param availableThreads Number of threads used for the multiplication.
+        */
+        void vectorMultiplication(T *vector, T *resultVector, T scaleThis, T scaleOther, unsigned availableThreads) override {
+            const T* values = _diagonalStorage->getNumberOfDiagonals() > 0 ? _diagonalStorage->getValuesDataPointer() : nullptr;
+            const auto &offsets = _diagonalStorage->getDiagonalOffsets();
+            auto numberOfDiagonals = static_cast<unsigned>(offsets.size());
+            long numRows = this->_numberOfRows;
+            long numColumns = this->_numberOfColumns;
+            T scale = scaleThis * scaleOther;
+
+            auto multiplyJob = [&](unsigned startRow, unsigned endRow) -> void {
+                for (long chunkStart = startRow; chunkStart < endRow; chunkStart += _rowsPerChunk) {
+                    long chunkEnd = std::min(chunkStart + _rowsPerChunk, static_cast<long>(endRow));
+                    T* y = resultVector;
+                    for (long row = chunkStart; row < chunkEnd; row++)
+                        y[row] = 0;
+                    for (unsigned d = 0; d < numberOfDiagonals; d++) {
+                        long offset = offsets[d];
+                        long first = std::max(chunkStart, -offset);
+                        long last = std::min(chunkEnd, numColumns - offset);
+                        if (first >= last)
+                            continue;
+                        const T* __restrict__ diagonal = values + d * numRows + first;
+                        const T* __restrict__ x = vector + first + offset;
+                        T* __restrict__ yRange = y + first;
+                        for (long i = 0; i < last - first; i++)
+                            yRange[i] += diagonal[i] * x[i];
+                    }
+                    for (long row = chunkStart; row < chunkEnd; row++)
+                        y[row] *= scale;
+                }
+            };
+            if (numRows > 0)
+                ThreadingOperations<T>::executeParallelJob(multiplyJob, numRows, availableThreads);
+        }
+
+    private:
+        shared_ptr<DIAStorageDataProvider<T>> _diagonalStorage;
+
+        static constexpr long _rowsPerChunk = 1024;
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_DIAMATHEMATICALOPERATIONSPROVIDER_H
@@ -0,0 +1,177 @@
+//
+// Created by hal9000 on 10/19/23.
+//
+
+#ifndef UNTITLED_NUMERICALMATRIXCOLORING_H
+#define UNTITLED_NUMERICALMATRIXCOLORING_H
+
+#include <algorithm>
+#include <queue>
+#include "NumericalMatrixReordering.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Colors the adjacency graph of a square CSR matrix so that no two rows of the same color are coupled.
+    *
+    * Rows of the same color only depend on rows of other colors, so a Gauss-Seidel or SOR sweep can update all the
+    * rows of one color concurrently and still be a true Gauss-Seidel sweep (in the multicolor ordering).
+    * The graph of A + A^T is used, so that the coloring is also valid for non-symmetric patterns.
+    *
+    * The result is returned as color classes: colorClasses[c] holds the rows of color c in increasing order.
+    *
+    * @tparam T The datatype of the matrix elements.
+    */
+    template<typename T>
+    class NumericalMatrixColoring {
+    public:
+
+        /**
+        * @brief Colors the matrix graph with as few colors as the structure allows.
+        *
+        * If the graph is bipartite (e.g. 5-point and 7-point finite difference stencils) the red-black 2-coloring is
+        * returned. Otherwise the rows are colored greedily.
+        *
+        * @param matrix The CSR matrix.
+        * @return The color classes.
+        */
+        static vector<vector<unsigned>> colorClasses(NumericalMatrix<T> &matrix) {
+            auto redBlackClasses = redBlack(matrix);
+            if (!redBlackClasses.empty())
+                return redBlackClasses;
+            return greedy(matrix);
+        }
+
+        /**
+        * @brief Computes the red-black (2-color) classes of a bipartite matrix graph by breadth first search.
+        *
+        * @param matrix The CSR matrix.
+        * @return The two color classes, or an empty vector if the graph is not bipartite.
+        */
+        static vector<vector<unsigned>> redBlack(NumericalMatrix<T> &matrix) {
+            _checkCSRMatrix(matrix);
+            unsigned n = matrix.numberOfRows();
+            //Duplicate neighbours are harmless for coloring, so they are not removed
+            auto graph = NumericalMatrixReordering<T>::symmetricGraph(matrix, false);
+            auto &adjacencyOffsets = graph.offsets;
+            auto &adjacency = graph.neighbours;
+
+            vector<int> color(n, -1);
+            for (unsigned seed = 0; seed < n; seed++) {
+                if (color[seed] >= 0)
+                    continue;
+                color[seed] = 0;
+                queue<unsigned> bfsQueue;
+                bfsQueue.push(seed);
+                while (!bfsQueue.empty()) {
+                    unsigned node = bfsQueue.front();
+                    bfsQueue.pop();
+                    for (unsigned k = adjacencyOffsets[node]; k < adjacencyOffsets[node + 1]; k++) {
+                        unsigned neighbour = adjacency[k];
+                        if (color[neighbour] < 0) {
+                            color[neighbour] = 1 - color[node];
+                            bfsQueue.push(neighbour);
+                        }
+                        else if (color[neighbour] == color[node]) {
+                            return {};
+                        }
+                    }
+                }
+            }
+            return _classesFromColors(color, 2);
+        }
+
+        /**
+        * @brief Colors the matrix graph greedily, visiting the rows in decreasing degree (Welsh-Powell).
+        *
+        * Each row gets the smallest color not used by its already colored neighbours. The number of colors is at most
+        * the maximum degree + 1.
+        *
+        * @param matrix The CSR matrix.
+        * @return The color classes.
+        */
+        static vector<vector<unsigned>> greedy(NumericalMatrix<T> &matrix) {
+            _checkCSRMatrix(matrix);
+            unsigned n = matrix.numberOfRows();
+            //Duplicate neighbours are harmless for coloring, so they are not removed
+            auto graph = NumericalMatrixReordering<T>::symmetricGraph(matrix, false);
+            auto &adjacencyOffsets = graph.offsets;
+            auto &adjacency = graph.neighbours;
+
+            vector<unsigned> visitingOrder(n);
+            for (unsigned i = 0; i < n; i++)
+                visitingOrder[i] = i;
+            std::stable_sort(visitingOrder.begin(), visitingOrder.end(), [&](unsigned a, unsigned b) {
+                return adjacencyOffsets[a + 1] - adjacencyOffsets[a] > adjacencyOffsets[b + 1] - adjacencyOffsets[b];
+            });
+
+            vector<int> color(n, -1);
+            //forbidden[c] == row marks color c as used by a neighbour of row
+            vector<unsigned> forbidden;
+            unsigned numberOfColors = 0;
+            for (auto &row : visitingOrder) {
+                for (unsigned k = adjacencyOffsets[row]; k < adjacencyOffsets[row + 1]; k++) {
+                    int neighbourColor = color[adjacency[k]];
+                    if (neighbourColor >= 0)
+                        forbidden[neighbourColor] = row;
+                }
+                unsigned rowColor = 0;
+                while (rowColor < numberOfColors && forbidden[rowColor] == row)
+                    rowColor++;
+                if (rowColor == numberOfColors) {
+                    numberOfColors++;
+                    forbidden.push_back(n);
+                }
+                color[row] = static_cast<int>(rowColor);
+            }
+            return _classesFromColors(color, numberOfColors);
+        }
+
+        /**
+        * @brief Checks that no two coupled rows share a color and that every row has exactly one color.
+        */
+        static bool isValidColoring(NumericalMatrix<T> &matrix, const vector<vector<unsigned>> &colorClasses) {
+            _checkCSRMatrix(matrix);
+            unsigned n = matrix.numberOfRows();
+            vector<int> color(n, -1);
+            for (unsigned c = 0; c < colorClasses.size(); c++) {
+                for (auto &row : colorClasses[c]) {
+                    if (row >= n || color[row] >= 0)
+                        return false;
+                    color[row] = static_cast<int>(c);
+                }
+            }
+            auto supplementaryVectors = matrix.dataStorage->getSupplementaryVectors();
+            unsigned* columnIndices = supplementaryVectors[0]->getDataPointer();
+            unsigned* rowOffsets = supplementaryVectors[1]->getDataPointer();
+            for (unsigned row = 0; row < n; row++) {
+                if (color[row] < 0)
+                    return false;
+                for (unsigned k = rowOffsets[row]; k < rowOffsets[row + 1]; k++) {
+                    if (columnIndices[k] != row && color[columnIndices[k]] == color[row])
+                        return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+
+        static void _checkCSRMatrix(NumericalMatrix<T> &matrix) {
+            if (matrix.dataStorage->getStorageType() != CSR)
+                throw invalid_argument("Coloring requires a matrix stored in CSR format.");
+            if (matrix.numberOfRows() != matrix.numberOfColumns())
+                throw invalid_argument("Coloring requires a square matrix.");
+        }
+
+        static vector<vector<unsigned>> _classesFromColors(const vector<int> &color, unsigned numberOfColors) {
+            vector<vector<unsigned>> classes(numberOfColors);
+            for (unsigned row = 0; row < color.size(); row++)
+                classes[color[row]].push_back(row);
+            return classes;
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_NUMERICALMATRIXCOLORING_H
@@ -0,0 +1,380 @@
+//
+// Created by hal9000 on 10/18/23.
+//
+
+#ifndef UNTITLED_NUMERICALMATRIXREORDERING_H
+#define UNTITLED_NUMERICALMATRIXREORDERING_H
+
+#include <algorithm>
+#include <queue>
+#include <chrono>
+#include "../NumericalMatrix.h"
+#include "SparsityGraph.h"
+
+namespace LinearAlgebra {
+
+    enum NumericalMatrixReorderingType {
+        NoReordering,
+        ReverseCuthillMcKee,
+        Morton
+    };
+
+    /**
+    * @brief Computes and applies symmetric permutations of sparse (CSR) matrices.
+    *
+    * A permutation is stored as a vector p where p[newIndex] = oldIndex. Applying it symmetrically to a matrix A gives
+    * B = P A P^T with B(i, j) = A(p[i], p[j]), and to a vector x gives y[i] = x[p[i]]. The inverse mapping
+    * x[p[i]] = y[i] brings a solution of the reordered system back to the original numbering.
+    *
+    * Two orderings are available:
+    * - Reverse Cuthill-McKee (RCM) works on the graph of the matrix alone and minimizes the bandwidth, so that the
+    *   entries of the input vector touched by neighbouring rows in the SpMV stay close in memory.
+    * - Morton (Z-order space filling curve) works on the coordinates of the entities behind each row (e.g. the nodes
+    *   of the mesh) and groups spatially close unknowns into the same cache lines.
+    *
+    * @tparam T The datatype of the matrix elements.
+    */
+    template<typename T>
+    class NumericalMatrixReordering {
+    public:
+
+        /**
+        * @brief Computes the Reverse Cuthill-McKee permutation of a square CSR matrix.
+        *
+        * The graph of A + A^T is traversed breadth first, starting each connected component from a pseudo-peripheral
+        * node (George-Liu heuristic) and visiting the neighbours of each node in increasing degree. The reversed
+        * visiting order is returned.
+        *
+        * @param matrix The CSR matrix.
+        * @return The permutation vector p (p[newIndex] = oldIndex).
+        * @throws invalid_argument if the matrix is not square or not stored in CSR format.
+        */
+        static vector<unsigned> reverseCuthillMcKee(NumericalMatrix<T> &matrix) {
+            _checkCSRMatrix(matrix);
+            unsigned n = matrix.numberOfRows();
+            auto graph = symmetricGraph(matrix);
+            auto &adjacencyOffsets = graph.offsets;
+            auto &adjacency = graph.neighbours;
+
+            vector<unsigned> degree(n);
+            for (unsigned i = 0; i < n; i++)
+                degree[i] = adjacencyOffsets[i + 1] - adjacencyOffsets[i];
+
+            vector<unsigned> ordering;
+            ordering.reserve(n);
+            vector<bool> visited(n, false);
+            vector<unsigned> neighbours;
+
+            for (unsigned seed = 0; seed < n; seed++) {
+                if (visited[seed])
+                    continue;
+                unsigned root = _pseudoPeripheralNode(seed, adjacencyOffsets, adjacency, degree);
+
+                queue<unsigned> bfsQueue;
+                bfsQueue.push(root);
+                visited[root] = true;
+                while (!bfsQueue.empty()) {
+                    unsigned node = bfsQueue.front();
+                    bfsQueue.pop();
+                    ordering.push_back(node);
+                    neighbours.clear();
+                    for (unsigned k = adjacencyOffsets[node]; k < adjacencyOffsets[node + 1]; k++) {
+                        if (!visited[adjacency[k]]) {
+                            visited[adjacency[k]] = true;
+                            neighbours.push_back(adjacency[k]);
+                        }
+                    }
+                    std::stable_sort(neighbours.begin(), neighbours.end(),
+                                     [&](unsigned a, unsigned b) { return degree[a] < degree[b]; });
+                    for (auto &neighbour : neighbours)
+                        bfsQueue.push(neighbour);
+                }
+            }
+            std::reverse(ordering.begin(), ordering.end());
+            return ordering;
+        }
+
+        /**
+        * @brief Computes the Morton (Z-order) permutation of a set of points.
+        *
+        * Each coordinate is normalized in the bounding box of the points and quantized to 21 bits. The bits of the
+        * quantized coordinates are interleaved into a 63-bit key and the points are stably sorted by key.
+        *
+        * @param coordinates The coordinates of the entity behind each row (1, 2 or 3 components per point).
+        * @return The permutation vector p (p[newIndex] = oldIndex).
+        * @throws invalid_argument if a point has no coordinates or more than 3.
+        */
+        static vector<unsigned> morton(const vector<vector<double>> &coordinates) {
+            unsigned n = coordinates.size();
+            unsigned dimensions = 0;
+            for (auto &point : coordinates) {
+                if (point.empty() || point.size() > 3)
+                    throw invalid_argument("Morton ordering requires points with 1, 2 or 3 coordinates.");
+                dimensions = std::max(dimensions, static_cast<unsigned>(point.size()));
+            }
+
+            vector<double> minimum(dimensions, numeric_limits<double>::max());
+            vector<double> maximum(dimensions, numeric_limits<double>::lowest());
+            for (auto &point : coordinates) {
+                for (unsigned d = 0; d < point.size(); d++) {
+                    minimum[d] = std::min(minimum[d], point[d]);
+                    maximum[d] = std::max(maximum[d], point[d]);
+                }
+            }
+
+            const double maxQuantized = static_cast<double>((1u << 21) - 1);
+            vector<unsigned long long> keys(n, 0);
+            for (unsigned i = 0; i < n; i++) {
+                unsigned long long key = 0;
+                for (unsigned d = 0; d < coordinates[i].size(); d++) {
+                    double range = maximum[d] - minimum[d];
+                    double normalized = range > 0 ? (coordinates[i][d] - minimum[d]) / range : 0.0;
+                    auto quantized = static_cast<unsigned long long>(normalized * maxQuantized);
+                    key |= _spreadBits(quantized, dimensions) << d;
+                }
+                keys[i] = key;
+            }
+
+            vector<unsigned> ordering(n);
+            for (unsigned i = 0; i < n; i++)
+                ordering[i] = i;
+            std::stable_sort(ordering.begin(), ordering.end(),
+                             [&](unsigned a, unsigned b) { return keys[a] < keys[b]; });
+            return ordering;
+        }
+
+        /**
+        * @brief Applies a symmetric permutation to a CSR matrix and returns B = P A P^T as a new CSR matrix.
+        *
+        * The row offsets of B are built serially from the row lengths of A, the rows are then filled in parallel
+        * with their column indices renumbered and sorted.
+        *
+        * @param matrix The CSR matrix A.
+        * @param permutation The permutation vector p (p[newIndex] = oldIndex).
+        * @param availableThreads Number of threads used to fill the rows of B. If 0 the threads of A are used.
+        * @return The permuted matrix.
+        * @throws invalid_argument if the matrix is not square CSR or the permutation size does not match.
+        */
+        static shared_ptr<NumericalMatrix<T>> permute(NumericalMatrix<T> &matrix, const vector<unsigned> &permutation,
+                                                      unsigned availableThreads = 0) {
+            _checkCSRMatrix(matrix);
+            checkPermutation(permutation, matrix.numberOfRows());
+            unsigned n = matrix.numberOfRows();
+            unsigned threads = availableThreads > 0 ? availableThreads : matrix.dataStorage->getAvailableThreads();
+            auto inversePermutation = inverse(permutation);
+
+            T* values = matrix.dataStorage->getValues()->getDataPointer();
+            auto supplementaryVectors = matrix.dataStorage->getSupplementaryVectors();
+            unsigned* columnIndices = supplementaryVectors[0]->getDataPointer();
+            unsigned* rowOffsets = supplementaryVectors[1]->getDataPointer();
+            unsigned numberOfNonZeros = rowOffsets[n];
+
+            auto newValues = make_shared<NumericalVector<T>>(numberOfNonZeros, 0, threads);
+            auto newColumnIndices = make_shared<NumericalVector<unsigned>>(numberOfNonZeros, 0, threads);
+            auto newRowOffsets = make_shared<NumericalVector<unsigned>>(n + 1, 0, threads);
+            T* newValuesData = newValues->getDataPointer();
+            unsigned* newColumnIndicesData = newColumnIndices->getDataPointer();
+            unsigned* newRowOffsetsData = newRowOffsets->getDataPointer();
+
+            for (unsigned row = 0; row < n; row++) {
+                unsigned oldRow = permutation[row];
+                newRowOffsetsData[row + 1] = newRowOffsetsData[row] + rowOffsets[oldRow + 1] - rowOffsets[oldRow];
+            }
+
+            auto permuteJob = [&](unsigned start, unsigned end) -> void {
+                for (unsigned row = start; row < end && row < n; row++) {
+                    unsigned oldRow = permutation[row];
+                    unsigned position = newRowOffsetsData[row];
+                    for (unsigned k = rowOffsets[oldRow]; k < rowOffsets[oldRow + 1]; k++) {
+                        //Insertion sort on the renumbered columns. Rows of stencil matrices are short.
+                        unsigned column = inversePermutation[columnIndices[k]];
+                        T value = values[k];
+                        unsigned j = position;
+                        while (j > newRowOffsetsData[row] && newColumnIndicesData[j - 1] > column) {
+                            newColumnIndicesData[j] = newColumnIndicesData[j - 1];
+                            newValuesData[j] = newValuesData[j - 1];
+                            j--;
+                        }
+                        newColumnIndicesData[j] = column;
+                        newValuesData[j] = value;
+                        position++;
+                    }
+                }
+            };
+            ThreadingOperations<unsigned>::executeParallelJob(permuteJob, n, threads);
+
+            auto storage = make_shared<CSRStorageDataProvider<T>>(newValues, newColumnIndices, newRowOffsets, n, n,
+                                                                   threads, matrix.dataStorage->getFormType());
+            return make_shared<NumericalMatrix<T>>(n, n, storage);
+        }
+
+        /**
+        * @brief Permutes a vector: result[i] = input[p[i]].
+        */
+        static void permuteVector(const T *input, T *result, const vector<unsigned> &permutation) {
+            for (unsigned i = 0; i < permutation.size(); i++)
+                result[i] = input[permutation[i]];
+        }
+
+        /**
+        * @brief Reverts the permutation of a vector: result[p[i]] = input[i].
+        */
+        static void inversePermuteVector(const T *input, T *result, const vector<unsigned> &permutation) {
+            for (unsigned i = 0; i < permutation.size(); i++)
+                result[permutation[i]] = input[i];
+        }
+
+        /**
+        * @brief Returns the inverse permutation q, with q[p[i]] = i.
+        */
+        static vector<unsigned> inverse(const vector<unsigned> &permutation) {
+            vector<unsigned> inversePermutation(permutation.size());
+            for (unsigned i = 0; i < permutation.size(); i++)
+                inversePermutation[permutation[i]] = i;
+            return inversePermutation;
+        }
+
+        /**
+        * @brief Calculates the bandwidth max|i - j| over the non-zero elements A(i, j) of a CSR matrix.
+        */
+        static unsigned bandwidth(NumericalMatrix<T> &matrix, unsigned availableThreads = 0) {
+            _checkCSRMatrix(matrix);
+            unsigned n = matrix.numberOfRows();
+            if (n == 0)
+                return 0;
+            unsigned threads = availableThreads > 0 ? availableThreads : matrix.dataStorage->getAvailableThreads();
+            auto supplementaryVectors = matrix.dataStorage->getSupplementaryVectors();
+            unsigned* columnIndices = supplementaryVectors[0]->getDataPointer();
+            unsigned* rowOffsets = supplementaryVectors[1]->getDataPointer();
+
+            auto bandwidthJob = [&](unsigned start, unsigned end) -> unsigned {
+                unsigned localBandwidth = 0;
+                for (unsigned row = start; row < end && row < n; row++) {
+                    for (unsigned k = rowOffsets[row]; k < rowOffsets[row + 1]; k++) {
+                        unsigned distance = row > columnIndices[k] ? row - columnIndices[k] : columnIndices[k] - row;
+                        localBandwidth = std::max(localBandwidth, distance);
+                    }
+                }
+                return localBandwidth;
+            };
+            auto localBandwidths = ThreadingOperations<unsigned>::executeParallelJobWithIncompleteReduction(bandwidthJob, n, threads);
+            return *std::max_element(localBandwidths.begin(), localBandwidths.end());
+        }
+
+        /**
+        * @brief Measures the average wall time of y = A * x in microseconds.
+        *
+        * @param matrix The matrix A.
+        * @param repetitions Number of timed multiplications. One untimed multiplication warms up the caches.
+        * @param availableThreads Number of threads used for the multiplication. If 0 the threads of A are used.
+        */
+        static double spmvTime(NumericalMatrix<T> &matrix, unsigned repetitions = 100, unsigned availableThreads = 0) {
+            NumericalVector<T> x(matrix.numberOfColumns(), 1);
+            NumericalVector<T> y(matrix.numberOfRows(), 0);
+            matrix.multiplyVector(x, y, 1, 1, availableThreads);
+            auto start = std::chrono::high_resolution_clock::now();
+            for (unsigned i = 0; i < repetitions; i++)
+                matrix.multiplyVector(x, y, 1, 1, availableThreads);
+            auto end = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration<double, std::micro>(end - start).count() / repetitions;
+        }
+
+        /**
+        * @brief The graph of A + A^T of a square CSR matrix, see SparsityGraph::symmetric.
+        */
+        static SparsityGraph symmetricGraph(NumericalMatrix<T> &matrix, bool removeDuplicates = true) {
+            _checkCSRMatrix(matrix);
+            auto supplementaryVectors = matrix.dataStorage->getSupplementaryVectors();
+            return SparsityGraph::symmetric(supplementaryVectors[1]->getDataPointer(), supplementaryVectors[0]->getDataPointer(),
+                                            matrix.numberOfRows(), removeDuplicates);
+        }
+
+        /**
+        * @brief Throws invalid_argument unless the permutation holds every index in [0, size) exactly once.
+        */
+        static void checkPermutation(const vector<unsigned> &permutation, unsigned size) {
+            if (permutation.size() != size)
+                throw invalid_argument("Permutation size does not match the matrix size.");
+            vector<bool> isVisited(size, false);
+            for (auto index : permutation) {
+                if (index >= size)
+                    throw invalid_argument("Permutation index " + to_string(index) + " is out of range.");
+                if (isVisited[index])
+                    throw invalid_argument("Permutation index " + to_string(index) + " appears more than once.");
+                isVisited[index] = true;
+            }
+        }
+
+    private:
+
+        static void _checkCSRMatrix(NumericalMatrix<T> &matrix) {
+            if (matrix.dataStorage->getStorageType() != CSR)
+                throw invalid_argument("Reordering requires a matrix stored in CSR format.");
+            if (matrix.numberOfRows() != matrix.numberOfColumns())
+                throw invalid_argument("Reordering requires a square matrix.");
+        }
+
+        /**
+        * @brief Finds a pseudo-peripheral node of the connected component of the seed node (George-Liu).
+        *
+        * Repeated breadth first searches move the root to a minimum degree node of the last level, as long as the
+        * eccentricity of the root keeps increasing.
+        */
+        static unsigned _pseudoPeripheralNode(unsigned seed, const vector<unsigned> &adjacencyOffsets,
+                                              const vector<unsigned> &adjacency, const vector<unsigned> &degree) {
+            unsigned root = seed;
+            unsigned eccentricity = 0;
+            vector<int> level(degree.size(), -1);
+            vector<unsigned> touched;
+            while (true) {
+                for (auto &node : touched)
+                    level[node] = -1;
+                touched.clear();
+
+                queue<unsigned> bfsQueue;
+                bfsQueue.push(root);
+                level[root] = 0;
+                touched.push_back(root);
+                unsigned lastLevel = 0;
+                while (!bfsQueue.empty()) {
+                    unsigned node = bfsQueue.front();
+                    bfsQueue.pop();
+                    lastLevel = level[node];
+                    for (unsigned k = adjacencyOffsets[node]; k < adjacencyOffsets[node + 1]; k++) {
+                        unsigned neighbour = adjacency[k];
+                        if (level[neighbour] < 0) {
+                            level[neighbour] = level[node] + 1;
+                            touched.push_back(neighbour);
+                            bfsQueue.push(neighbour);
+                        }
+                    }
+                }
+                unsigned candidate = root;
+                unsigned minimumDegree = numeric_limits<unsigned>::max();
+                for (auto &node : touched) {
+                    if (static_cast<unsigned>(level[node]) == lastLevel && degree[node] < minimumDegree) {
+                        minimumDegree = degree[node];
+                        candidate = node;
+                    }
+                }
+                if (lastLevel <= eccentricity)
+                    return root;
+                eccentricity = lastLevel;
+                root = candidate;
+            }
+        }
+
+        /**
+        * @brief Spreads the lowest 21 bits of a value so that consecutive bits are "dimensions" positions apart.
+        */
+        static unsigned long long _spreadBits(unsigned long long value, unsigned dimensions) {
+            unsigned long long result = 0;
+            for (unsigned bit = 0; bit < 21; bit++)
+                result |= ((value >> bit) & 1ull) << (bit * dimensions);
+            return result;
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_NUMERICALMATRIXREORDERING_H
@@ -0,0 +1,83 @@
+//
+// Created by hal9000 on 11/14/23.
+//
+
+#ifndef UNTITLED_SPARSITYGRAPH_H
+#define UNTITLED_SPARSITYGRAPH_H
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Undirected graph of the symmetric sparsity pattern of a matrix in adjacency (CSR) format, without the
+    * diagonal.
+    */
+    struct SparsityGraph {
+        unsigned numberOfNodes = 0;
+
+        vector<unsigned> offsets;
+
+        vector<unsigned> neighbours;
+
+        unsigned degree(unsigned node) const {
+            return offsets[node + 1] - offsets[node];
+        }
+
+        /**
+        * @brief Builds the graph of the pattern of A + A^T from the CSR arrays of a square A.
+        *
+        * Every off-diagonal entry a_ij adds j to the neighbours of i and i to the neighbours of j, so structurally
+        * symmetric entries appear twice. With removeDuplicates the neighbours of each node are sorted and unique;
+        * without it they are kept in insertion order, which is enough for traversals such as coloring.
+        */
+        static SparsityGraph symmetric(const unsigned* rowOffsets, const unsigned* columnIndices, unsigned numberOfRows,
+                                       bool removeDuplicates = true) {
+            SparsityGraph graph;
+            graph.numberOfNodes = numberOfRows;
+            auto &offsets = graph.offsets;
+            offsets.assign(numberOfRows + 1, 0);
+            for (unsigned row = 0; row < numberOfRows; row++)
+                for (unsigned k = rowOffsets[row]; k < rowOffsets[row + 1]; k++)
+                    if (columnIndices[k] != row) {
+                        offsets[row + 1]++;
+                        offsets[columnIndices[k] + 1]++;
+                    }
+            for (unsigned row = 0; row < numberOfRows; row++)
+                offsets[row + 1] += offsets[row];
+            auto &neighbours = graph.neighbours;
+            neighbours.assign(offsets[numberOfRows], 0);
+            vector<unsigned> position(offsets.begin(), offsets.end() - 1);
+            for (unsigned row = 0; row < numberOfRows; row++)
+                for (unsigned k = rowOffsets[row]; k < rowOffsets[row + 1]; k++)
+                    if (columnIndices[k] != row) {
+                        neighbours[position[row]++] = columnIndices[k];
+                        neighbours[position[columnIndices[k]]++] = row;
+                    }
+            if (!removeDuplicates)
+                return graph;
+
+            //Sort each row and compact the structure over the duplicates
+            unsigned compactPosition = 0, rowStart = 0;
+            for (unsigned row = 0; row < numberOfRows; row++) {
+                auto first = neighbours.begin() + rowStart, last = neighbours.begin() + offsets[row + 1];
+                std::sort(first, last);
+                last = std::unique(first, last);
+                rowStart = offsets[row + 1];
+                offsets[row] = compactPosition;
+                for (auto neighbour = first; neighbour != last; ++neighbour)
+                    neighbours[compactPosition++] = *neighbour;
+            }
+            offsets[numberOfRows] = compactPosition;
+            neighbours.resize(compactPosition);
+            neighbours.shrink_to_fit();
+            return graph;
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_SPARSITYGRAPH_H
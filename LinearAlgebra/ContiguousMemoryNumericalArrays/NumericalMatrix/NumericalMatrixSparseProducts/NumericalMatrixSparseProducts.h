@@ -0,0 +1,271 @@
+//
+// Created by hal9000 on 10/21/23.
+//
+
+#ifndef UNTITLED_NUMERICALMATRIXSPARSEPRODUCTS_H
+#define UNTITLED_NUMERICALMATRIXSPARSEPRODUCTS_H
+
+#include <algorithm>
+#include <limits>
+#include "../NumericalMatrix.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Sparse matrix-matrix products of CSR matrices.
+    *
+    * All products are computed in two phases over contiguous row blocks distributed among the available threads:
+    * 1. Symbolic phase: the number of non-zero elements of each result row is counted with a dense marker array of the
+    *    size of the result columns. A prefix sum of the counts gives the row offsets of the result.
+    * 2. Numeric phase: the values of each result row are accumulated in a dense accumulator and written, sorted by
+    *    column, at the position given by the row offsets.
+    * Each thread owns its marker and accumulator, so the threads never write to the same memory.
+    * Structural zeros (entries that cancel numerically) are kept in the result.
+    *
+    * @tparam T The datatype of the matrix elements.
+    */
+    template<typename T>
+    class NumericalMatrixSparseProducts {
+    public:
+
+        /**
+        * @brief Computes C = A * B.
+        *
+        * @param A The left CSR matrix (m x k).
+        * @param B The right CSR matrix (k x n).
+        * @param availableThreads The number of threads. If 0 the threads of A are used.
+        * @return The CSR matrix C (m x n).
+        */
+        static shared_ptr<NumericalMatrix<T>> multiply(NumericalMatrix<T> &A, NumericalMatrix<T> &B, unsigned availableThreads = 0) {
+            _checkCSRMatrix(A);
+            _checkCSRMatrix(B);
+            if (A.numberOfColumns() != B.numberOfRows())
+                throw invalid_argument("The number of columns of A must be equal to the number of rows of B.");
+            availableThreads = availableThreads > 0 ? availableThreads : A.dataStorage->getAvailableThreads();
+            CSRView a(A), b(B);
+            unsigned numberOfRows = A.numberOfRows(), numberOfColumns = B.numberOfColumns();
+
+            auto rowOffsets = make_shared<NumericalVector<unsigned>>(numberOfRows + 1, 0, availableThreads);
+            unsigned* rowOffsetsData = rowOffsets->getDataPointer();
+            auto symbolicJob = [&](unsigned startRow, unsigned endRow) -> void {
+                vector<unsigned> marker(numberOfColumns, numeric_limits<unsigned>::max());
+                for (unsigned row = startRow; row < endRow; row++) {
+                    unsigned count = 0;
+                    for (unsigned ka = a.rowOffsets[row]; ka < a.rowOffsets[row + 1]; ka++) {
+                        unsigned k = a.columnIndices[ka];
+                        for (unsigned kb = b.rowOffsets[k]; kb < b.rowOffsets[k + 1]; kb++) {
+                            unsigned column = b.columnIndices[kb];
+                            if (marker[column] != row) {
+                                marker[column] = row;
+                                count++;
+                            }
+                        }
+                    }
+                    rowOffsetsData[row + 1] = count;
+                }
+            };
+            ThreadingOperations<T>::executeParallelJob(symbolicJob, numberOfRows, availableThreads);
+            unsigned numberOfNonZeros = _prefixSum(rowOffsetsData, numberOfRows);
+
+            auto columnIndices = make_shared<NumericalVector<unsigned>>(numberOfNonZeros, 0, availableThreads);
+            auto values = make_shared<NumericalVector<T>>(numberOfNonZeros, 0, availableThreads);
+            unsigned* columnIndicesData = columnIndices->getDataPointer();
+            T* valuesData = values->getDataPointer();
+            auto numericJob = [&](unsigned startRow, unsigned endRow) -> void {
+                RowAccumulator accumulator(numberOfColumns);
+                for (unsigned row = startRow; row < endRow; row++) {
+                    for (unsigned ka = a.rowOffsets[row]; ka < a.rowOffsets[row + 1]; ka++) {
+                        unsigned k = a.columnIndices[ka];
+                        T aValue = a.values[ka];
+                        for (unsigned kb = b.rowOffsets[k]; kb < b.rowOffsets[k + 1]; kb++)
+                            accumulator.add(row, b.columnIndices[kb], aValue * b.values[kb]);
+                    }
+                    accumulator.write(columnIndicesData + rowOffsetsData[row], valuesData + rowOffsetsData[row]);
+                }
+            };
+            ThreadingOperations<T>::executeParallelJob(numericJob, numberOfRows, availableThreads);
+            return _csrMatrix(values, columnIndices, rowOffsets, numberOfRows, numberOfColumns, availableThreads);
+        }
+
+        /**
+        * @brief Computes the transpose of a CSR matrix with a counting sort of its column indices.
+        *
+        * @param A The CSR matrix (m x n).
+        * @param availableThreads The number of threads of the result. If 0 the threads of A are used.
+        * @return The CSR matrix A^T (n x m).
+        */
+        static shared_ptr<NumericalMatrix<T>> transpose(NumericalMatrix<T> &A, unsigned availableThreads = 0) {
+            _checkCSRMatrix(A);
+            availableThreads = availableThreads > 0 ? availableThreads : A.dataStorage->getAvailableThreads();
+            CSRView a(A);
+            unsigned numberOfRows = A.numberOfColumns(), numberOfColumns = A.numberOfRows();
+            unsigned numberOfNonZeros = a.rowOffsets[A.numberOfRows()];
+
+            auto rowOffsets = make_shared<NumericalVector<unsigned>>(numberOfRows + 1, 0, availableThreads);
+            auto columnIndices = make_shared<NumericalVector<unsigned>>(numberOfNonZeros, 0, availableThreads);
+            auto values = make_shared<NumericalVector<T>>(numberOfNonZeros, 0, availableThreads);
+            unsigned* rowOffsetsData = rowOffsets->getDataPointer();
+            for (unsigned k = 0; k < numberOfNonZeros; k++)
+                rowOffsetsData[a.columnIndices[k] + 1]++;
+            _prefixSum(rowOffsetsData, numberOfRows);
+
+            vector<unsigned> position(rowOffsetsData, rowOffsetsData + numberOfRows);
+            for (unsigned row = 0; row < A.numberOfRows(); row++) {
+                for (unsigned k = a.rowOffsets[row]; k < a.rowOffsets[row + 1]; k++) {
+                    unsigned destination = position[a.columnIndices[k]]++;
+                    (*columnIndices)[destination] = row;
+                    (*values)[destination] = a.values[k];
+                }
+            }
+            return _csrMatrix(values, columnIndices, rowOffsets, numberOfRows, numberOfColumns, availableThreads);
+        }
+
+        /**
+        * @brief Computes the Galerkin triple product R^T * A * P without storing A * P.
+        *
+        * Row i of the result is accumulated as sum_k R_ki * (sum_j A_kj * P_j:), traversing row i of R^T, the rows of A
+        * and the rows of P. Only R^T is formed explicitly. For aggregation prolongators, where every fine row of R
+        * has few non-zero elements, every row of A * P is computed a small number of times.
+        *
+        * @param R The restriction transposed CSR matrix (n x nc). For symmetric Galerkin operators R = P.
+        * @param A The CSR matrix (n x n).
+        * @param P The prolongation CSR matrix (n x nc).
+        * @param availableThreads The number of threads. If 0 the threads of A are used.
+        * @return The CSR matrix R^T A P (nc x nc).
+        */
+        static shared_ptr<NumericalMatrix<T>> galerkinProduct(NumericalMatrix<T> &R, NumericalMatrix<T> &A, NumericalMatrix<T> &P,
+                                                              unsigned availableThreads = 0) {
+            _checkCSRMatrix(R);
+            _checkCSRMatrix(A);
+            _checkCSRMatrix(P);
+            if (R.numberOfRows() != A.numberOfRows() || A.numberOfColumns() != P.numberOfRows())
+                throw invalid_argument("Incompatible dimensions for the product R^T A P.");
+            availableThreads = availableThreads > 0 ? availableThreads : A.dataStorage->getAvailableThreads();
+            auto RTranspose = transpose(R, availableThreads);
+            CSRView r(*RTranspose), a(A), p(P);
+            unsigned numberOfRows = R.numberOfColumns(), numberOfColumns = P.numberOfColumns();
+
+            auto rowOffsets = make_shared<NumericalVector<unsigned>>(numberOfRows + 1, 0, availableThreads);
+            unsigned* rowOffsetsData = rowOffsets->getDataPointer();
+            auto symbolicJob = [&](unsigned startRow, unsigned endRow) -> void {
+                vector<unsigned> marker(numberOfColumns, numeric_limits<unsigned>::max());
+                for (unsigned row = startRow; row < endRow; row++) {
+                    unsigned count = 0;
+                    for (unsigned kr = r.rowOffsets[row]; kr < r.rowOffsets[row + 1]; kr++) {
+                        unsigned k = r.columnIndices[kr];
+                        for (unsigned ka = a.rowOffsets[k]; ka < a.rowOffsets[k + 1]; ka++) {
+                            unsigned j = a.columnIndices[ka];
+                            for (unsigned kp = p.rowOffsets[j]; kp < p.rowOffsets[j + 1]; kp++) {
+                                unsigned column = p.columnIndices[kp];
+                                if (marker[column] != row) {
+                                    marker[column] = row;
+                                    count++;
+                                }
+                            }
+                        }
+                    }
+                    rowOffsetsData[row + 1] = count;
+                }
+            };
+            ThreadingOperations<T>::executeParallelJob(symbolicJob, numberOfRows, availableThreads);
+            unsigned numberOfNonZeros = _prefixSum(rowOffsetsData, numberOfRows);
+
+            auto columnIndices = make_shared<NumericalVector<unsigned>>(numberOfNonZeros, 0, availableThreads);
+            auto values = make_shared<NumericalVector<T>>(numberOfNonZeros, 0, availableThreads);
+            unsigned* columnIndicesData = columnIndices->getDataPointer();
+            T* valuesData = values->getDataPointer();
+            auto numericJob = [&](unsigned startRow, unsigned endRow) -> void {
+                RowAccumulator accumulator(numberOfColumns);
+                for (unsigned row = startRow; row < endRow; row++) {
+                    for (unsigned kr = r.rowOffsets[row]; kr < r.rowOffsets[row + 1]; kr++) {
+                        unsigned k = r.columnIndices[kr];
+                        T rValue = r.values[kr];
+                        for (unsigned ka = a.rowOffsets[k]; ka < a.rowOffsets[k + 1]; ka++) {
+                            unsigned j = a.columnIndices[ka];
+                            T raValue = rValue * a.values[ka];
+                            for (unsigned kp = p.rowOffsets[j]; kp < p.rowOffsets[j + 1]; kp++)
+                                accumulator.add(row, p.columnIndices[kp], raValue * p.values[kp]);
+                        }
+                    }
+                    accumulator.write(columnIndicesData + rowOffsetsData[row], valuesData + rowOffsetsData[row]);
+                }
+            };
+            ThreadingOperations<T>::executeParallelJob(numericJob, numberOfRows, availableThreads);
+            return _csrMatrix(values, columnIndices, rowOffsets, numberOfRows, numberOfColumns, availableThreads);
+        }
+
+    private:
+
+        /**
+        * @brief Raw pointers to the arrays of a CSR matrix.
+        */
+        struct CSRView {
+            explicit CSRView(NumericalMatrix<T> &matrix) {
+                auto supplementaryDataPointers = matrix.dataStorage->getSupplementaryDataPointers();
+                columnIndices = supplementaryDataPointers[0];
+                rowOffsets = supplementaryDataPointers[1];
+                values = rowOffsets[matrix.numberOfRows()] > 0 ? matrix.dataStorage->getValuesDataPointer() : nullptr;
+            }
+            const T* values;
+            const unsigned* columnIndices;
+            const unsigned* rowOffsets;
+        };
+
+        /**
+        * @brief Dense accumulator of a result row. The marker stores the row that last touched each column, so it
+        * never has to be cleared.
+        */
+        struct RowAccumulator {
+            explicit RowAccumulator(unsigned numberOfColumns) :
+                    marker(numberOfColumns, numeric_limits<unsigned>::max()), sums(numberOfColumns, 0) {}
+
+            void add(unsigned row, unsigned column, T value) {
+                if (marker[column] != row) {
+                    marker[column] = row;
+                    sums[column] = value;
+                    rowColumns.push_back(column);
+                }
+                else {
+                    sums[column] += value;
+                }
+            }
+
+            void write(unsigned* columnIndices, T* values) {
+                std::sort(rowColumns.begin(), rowColumns.end());
+                for (unsigned i = 0; i < rowColumns.size(); i++) {
+                    columnIndices[i] = rowColumns[i];
+                    values[i] = sums[rowColumns[i]];
+                }
+                rowColumns.clear();
+            }
+
+            vector<unsigned> marker;
+            vector<T> sums;
+            vector<unsigned> rowColumns;
+        };
+
+        static unsigned _prefixSum(unsigned* rowOffsets, unsigned numberOfRows) {
+            rowOffsets[0] = 0;
+            for (unsigned row = 0; row < numberOfRows; row++)
+                rowOffsets[row + 1] += rowOffsets[row];
+            return rowOffsets[numberOfRows];
+        }
+
+        static shared_ptr<NumericalMatrix<T>> _csrMatrix(shared_ptr<NumericalVector<T>> &values,
+                                                         shared_ptr<NumericalVector<unsigned>> &columnIndices,
+                                                         shared_ptr<NumericalVector<unsigned>> &rowOffsets,
+                                                         unsigned numberOfRows, unsigned numberOfColumns, unsigned availableThreads) {
+            auto storage = make_shared<CSRStorageDataProvider<T>>(values, columnIndices, rowOffsets, numberOfRows,
+                                                                  numberOfColumns, availableThreads);
+            return make_shared<NumericalMatrix<T>>(numberOfRows, numberOfColumns, storage);
+        }
+
+        static void _checkCSRMatrix(NumericalMatrix<T> &matrix) {
+            if (matrix.dataStorage->getStorageType() != CSR)
+                throw invalid_argument("Sparse products require matrices stored in CSR format.");
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_NUMERICALMATRIXSPARSEPRODUCTS_H
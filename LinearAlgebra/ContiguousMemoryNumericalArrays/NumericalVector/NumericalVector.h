@@ -1146,12 +1146,12 @@ namespace LinearAlgebra {
          */
         void scale(T scalar, unsigned userDefinedThreads = 0) {
             auto scaleJob = [&](unsigned start, unsigned end) -> void {
-                for (auto &value: *_values) {
-                    value *= scalar;
+                for (unsigned i = start; i < end; ++i) {
+                    (*_values)[i] *= scalar;
                 }
             };
             unsigned availableThreads = (userDefinedThreads > 0) ? userDefinedThreads : _availableThreads;
-            _threading.executeParallelJob(scaleJob, _values->size(), _availableThreads);
+            _threading.executeParallelJob(scaleJob, _values->size(), availableThreads);
         }
 
 
@@ -6,8 +6,9 @@
 
 namespace LinearAlgebra {
     IterationQR::IterationQR(unsigned maxIterations, double exitError, DecompositionType decompositionType, ParallelizationMethod parallelizationMethod, bool storeOnMatrix) :
-    _maxIterations(maxIterations), _exitError(exitError), _decompositionType(decompositionType),
-    _parallelizationMethod(parallelizationMethod), _storeOnMatrix(storeOnMatrix) {
+    _maxIterations(maxIterations), _iteration(0), _exitError(exitError), _decompositionType(decompositionType),
+    _parallelizationMethod(parallelizationMethod), _matrixSet(false), _storeOnMatrix(storeOnMatrix),
+    _telemetry(make_shared<SolverTelemetry>()) {
         
         switch (_decompositionType) {
             case GramSchmidt:
@@ -25,26 +26,21 @@ namespace LinearAlgebra {
             throw runtime_error("NumericalMatrix not set");
         }
         
-        while (_iteration < _maxIterations) {
+        _iteration = 0;
+        double norm = _lowerTriangleNorm();
+        _telemetry->begin("QR Iteration");
+        _telemetry->record(_iteration, norm);
+        while (_iteration < _maxIterations && norm > _exitError) {
             if (_iteration > 0) {
                 _matrixQRDecomposition->setMatrix(_matrix);
             }
             _matrixQRDecomposition->decompose();
             _matrixQRDecomposition->getRQ(_matrix);
-            //auto eigenvalues = getEigenvalues();
             _iteration++;
-            cout<< "Q" << endl;
-            _matrixQRDecomposition->getQ()->print(4);
-            cout<< ""<< endl;
-            cout<< "R" << endl;
-            _matrixQRDecomposition->getR()->print(4);
-            
-            auto eig = getEigenvalues();
-            cout<<"========== Iteration "<<_iteration<<" =========="<<endl;
-            for (unsigned i = 0; i < eig->size(); i++) {
-                cout<<"Eigenvalue "<<i<<" = "<<eig->at(i)<<endl;
-            }
+            norm = _lowerTriangleNorm();
+            _telemetry->record(_iteration, norm);
         }
+        _telemetry->end(_iteration, norm, norm <= _exitError);
 /*        cout<<"========== Iteration "<<_iteration<<" =========="<<endl;
         cout<<"========== Q =========="<<endl;
         _matrixQRDecomposition->getQ()->print(6);
@@ -86,6 +82,24 @@ namespace LinearAlgebra {
         _matrixQRDecomposition->setMatrix(_matrix);
     }
 
+    void IterationQR::setTelemetry(shared_ptr<SolverTelemetry> telemetry) {
+        if (telemetry == nullptr)
+            throw invalid_argument("Telemetry cannot be null.");
+        _telemetry = std::move(telemetry);
+    }
+
+    const shared_ptr<SolverTelemetry> &IterationQR::getTelemetry() const {
+        return _telemetry;
+    }
+
+    double IterationQR::_lowerTriangleNorm() {
+        double sum = 0;
+        for (unsigned i = 1; i < _matrix->numberOfRows(); i++)
+            for (unsigned j = 0; j < i && j < _matrix->numberOfColumns(); j++)
+                sum += _matrix->at(i, j) * _matrix->at(i, j);
+        return sqrt(sum);
+    }
+
     void IterationQR::_deepCopyMatrix() {
         //R = A TODO : fix this with copy constructor
         _matrixCopy = make_shared<Array<double>>(_matrix->numberOfRows(), _matrix->numberOfColumns());
@@ -8,6 +8,7 @@
 #include "GramSchmidtQR.h"
 #include "HouseHolderQR.h"
 #include "../../ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrix.h"
+#include "../../Solvers/Telemetry/SolverTelemetry.h"
 
 namespace LinearAlgebra {
 
@@ -16,6 +17,10 @@ namespace LinearAlgebra {
         explicit IterationQR(unsigned maxIterations = 20, double exitError = 1E-4, DecompositionType decompositionType = Householder,
                              ParallelizationMethod parallelizationMethod = SingleThread, bool storeOnMatrix = true);
         
+        /**
+        * @brief Runs QR iterations A = R Q until the Frobenius norm of the strictly lower triangle drops below the
+        * exit error or the maximum iterations. The norm of every iteration is recorded in the telemetry.
+        */
         void calculateEigenvalues();
 
         shared_ptr<vector<double>> getEigenvalues();
@@ -24,6 +29,13 @@ namespace LinearAlgebra {
 
         void setMatrix(shared_ptr<Array<double>>&);
         
+        /**
+        * @throws invalid_argument If telemetry is null.
+        */
+        void setTelemetry(shared_ptr<SolverTelemetry> telemetry);
+        
+        const shared_ptr<SolverTelemetry>& getTelemetry() const;
+        
     private:
 
         shared_ptr<Array<double>> _matrix;
@@ -46,6 +58,10 @@ namespace LinearAlgebra {
         
         shared_ptr<DecompositionQR> _matrixQRDecomposition;
         
+        shared_ptr<SolverTelemetry> _telemetry;
+        
+        double _lowerTriangleNorm();
+        
         void _deepCopyMatrix();
     };
 
@@ -0,0 +1,356 @@
+//
+// Created by hal9000 on 11/8/23.
+//
+
+#ifndef UNTITLED_SPECTRALBOUNDSESTIMATOR_H
+#define UNTITLED_SPECTRALBOUNDSESTIMATOR_H
+
+#include <cmath>
+#include <functional>
+#include <map>
+#include <tuple>
+#include "../Solvers/LinearOperators/LinearOperator.h"
+#include "../Solvers/Preconditioners/Preconditioner.h"
+
+namespace LinearAlgebra {
+
+    enum SpectralBoundsMethod {
+        //Extreme Ritz values of a few Lanczos steps, both bounds converge in O(√κ) steps
+        LanczosBounds,
+        //Power iterations on M^-1 A for the largest eigenvalue and on λmax I - M^-1 A for the smallest one
+        PowerMethodBounds
+    };
+
+    /**
+    * @brief Estimates of the extreme eigenvalues of M^-1 A.
+    */
+    struct SpectralBounds {
+        double minimum;
+
+        double maximum;
+
+        /**
+        * @brief The operator applications of the estimate.
+        */
+        unsigned steps;
+
+        /**
+        * @brief The global reductions (dot products) of the estimate.
+        */
+        unsigned reductions;
+    };
+
+    /**
+    * @brief Estimates the extreme eigenvalues of M^-1 A for a symmetric positive definite operator A and
+    * preconditioner M (the identity without one) from the action of the operator only, so it works with assembled and
+    * matrix-free operators alike. LanczosEigenDecomposition works on dense Arrays and computes more of the spectrum
+    * than the bounds that Chebyshev iterations need.
+    *
+    * The Lanczos estimate runs the M-orthogonal Lanczos recurrence of M^-1 A from a fixed pseudo-random vector and
+    * stops when the extreme eigenvalues of the tridiagonal matrix change by less than the tolerance. The Ritz values
+    * lie inside the spectrum, the largest one converges first. The power method needs more steps and only the
+    * largest eigenvalue is accurate, the smallest one converges at the rate 1 - κ^-1.
+    *
+    * @tparam T The datatype of the vector elements.
+    */
+    template<typename T>
+    class SpectralBoundsEstimator {
+    public:
+        /**
+        * @param maxSteps The maximum number of operator applications of an estimate (per bound for the power method).
+        * @param tolerance The relative change of both bounds between two steps that stops the estimate.
+        */
+        explicit SpectralBoundsEstimator(SpectralBoundsMethod method = LanczosBounds, unsigned maxSteps = 200,
+                                         double tolerance = 1E-3, unsigned availableThreads = 1) :
+                _method(method), _maxSteps(std::max(2u, maxSteps)), _tolerance(tolerance),
+                _availableThreads(std::max(1u, availableThreads)) { }
+
+        /**
+        * @brief Estimates the extreme eigenvalues of M^-1 A. preconditioner may be null.
+        *
+        * @param largestOnly Skips the smallest eigenvalue of the power method (minimum = 0), for the smoothers that
+        * target the upper part of the spectrum. The Lanczos estimate computes both bounds regardless.
+        * @throws runtime_error If the operator or the preconditioner is not positive definite.
+        */
+        SpectralBounds estimate(LinearOperator<T> &matrix, Preconditioner<T> *preconditioner = nullptr,
+                                bool largestOnly = false) const {
+            if (matrix.numberOfRows() != matrix.numberOfColumns())
+                throw invalid_argument("The spectral bounds require a square operator.");
+            if (preconditioner != nullptr && !preconditioner->isSetUp())
+                throw runtime_error("The preconditioner is not set up.");
+            return _method == LanczosBounds ? _lanczos(matrix, preconditioner) :
+                   _powerMethod(matrix, preconditioner, largestOnly);
+        }
+
+        SpectralBoundsMethod getMethod() const {
+            return _method;
+        }
+
+        void setAvailableThreads(unsigned availableThreads) {
+            _availableThreads = std::max(1u, availableThreads);
+        }
+
+        /**
+        * @brief The extreme eigenvalues of the symmetric tridiagonal matrix with the given diagonal and sub-diagonal,
+        * computed by bisection with Sturm sequence counts.
+        */
+        static pair<double, double> tridiagonalExtremes(const vector<double> &diagonal, const vector<double> &subDiagonal) {
+            unsigned m = static_cast<unsigned>(diagonal.size());
+            double lower = diagonal[0], upper = diagonal[0];
+            for (unsigned i = 0; i < m; i++) {
+                double radius = (i > 0 ? std::abs(subDiagonal[i - 1]) : 0) + (i + 1 < m ? std::abs(subDiagonal[i]) : 0);
+                lower = std::min(lower, diagonal[i] - radius);
+                upper = std::max(upper, diagonal[i] + radius);
+            }
+            //The eigenvalues below x: the negative pivots of the LDL^T factorization of T - x I
+            auto countBelow = [&](double x) {
+                unsigned count = 0;
+                double pivot = 1;
+                for (unsigned i = 0; i < m; i++) {
+                    double coupling = i > 0 ? subDiagonal[i - 1] * subDiagonal[i - 1] : 0;
+                    pivot = diagonal[i] - x - (i > 0 ? coupling / pivot : 0);
+                    if (pivot == 0)
+                        pivot = -std::numeric_limits<double>::epsilon() * (std::abs(x) + 1);
+                    if (pivot < 0)
+                        count++;
+                }
+                return count;
+            };
+            //The k-th smallest eigenvalue is the smallest x with countBelow(x) >= k
+            auto bisect = [&](unsigned k) {
+                double a = lower, b = upper;
+                for (unsigned i = 0; i < 100 && b - a > 4 * std::numeric_limits<double>::epsilon() * (std::abs(a) + std::abs(b)); i++) {
+                    double middle = 0.5 * (a + b);
+                    if (countBelow(middle) >= k)
+                        b = middle;
+                    else
+                        a = middle;
+                }
+                return 0.5 * (a + b);
+            };
+            return {bisect(1), bisect(m)};
+        }
+
+    private:
+        SpectralBoundsMethod _method;
+
+        unsigned _maxSteps;
+
+        double _tolerance;
+
+        unsigned _availableThreads;
+
+        void _applyPreconditioner(Preconditioner<T> *preconditioner, NumericalVector<T> &r, NumericalVector<T> &z) const {
+            if (preconditioner != nullptr)
+                preconditioner->apply(r, z);
+            else
+                std::copy(r.getDataPointer(), r.getDataPointer() + r.size(), z.getDataPointer());
+        }
+
+        /**
+        * @brief A fixed pseudo-random start vector in [0.5, 1.5), so that the estimates are reproducible and the start
+        * has components along the smooth eigenvectors.
+        */
+        static void _startVector(NumericalVector<T> &vector) {
+            unsigned long long state = 2023;
+            for (unsigned i = 0; i < vector.size(); i++) {
+                state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+                vector[i] = static_cast<T>(0.5 + static_cast<double>(state >> 11) / 9007199254740992.0);
+            }
+        }
+
+        SpectralBounds _lanczos(LinearOperator<T> &matrix, Preconditioner<T> *preconditioner) const {
+            unsigned n = matrix.numberOfRows();
+            unsigned threads = _availableThreads;
+            NumericalVector<T> r(n, 0, threads), z(n, 0, threads), v(n, 0, threads), w(n, 0, threads),
+                               previous(n, 0, threads), product(n, 0, threads);
+            _startVector(r);
+            _applyPreconditioner(preconditioner, r, z);
+            double beta = std::sqrt(static_cast<double>(r.dotProduct(z, threads)));
+            vector<double> diagonal, subDiagonal;
+            SpectralBounds bounds = {0, 0, 0, 1};
+            while (bounds.steps < _maxSteps) {
+                //v = r / β, w = M^-1 v, previous holds the last v
+                std::copy(v.getDataPointer(), v.getDataPointer() + n, previous.getDataPointer());
+                v.add(r, v, 0, static_cast<T>(1 / beta), threads);
+                w.add(z, w, 0, static_cast<T>(1 / beta), threads);
+                matrix.multiply(w, product);
+                bounds.steps++;
+                bounds.reductions++;
+                double alpha = static_cast<double>(w.dotProduct(product, threads));
+                if (!(alpha > 0))
+                    throw runtime_error("The spectral bounds require a positive definite operator.");
+                //r = A w - α v - β v_previous
+                product.subtract(v, r, 1, static_cast<T>(alpha), threads);
+                if (bounds.steps > 1)
+                    r.subtractIntoThis(previous, 1, static_cast<T>(beta), threads);
+                diagonal.push_back(alpha);
+                auto extremes = tridiagonalExtremes(diagonal, subDiagonal);
+                bool converged = bounds.steps > 1 &&
+                                 std::abs(extremes.first - bounds.minimum) <= _tolerance * std::abs(extremes.first) &&
+                                 std::abs(extremes.second - bounds.maximum) <= _tolerance * extremes.second;
+                bounds.minimum = extremes.first;
+                bounds.maximum = extremes.second;
+                if (converged || bounds.steps == n)
+                    break;
+                _applyPreconditioner(preconditioner, r, z);
+                double residualDotPreconditioned = static_cast<double>(r.dotProduct(z, threads));
+                bounds.reductions++;
+                if (residualDotPreconditioned < 0)
+                    throw runtime_error("The spectral bounds require a positive definite preconditioner.");
+                beta = std::sqrt(residualDotPreconditioned);
+                //An invariant subspace: the Ritz values are eigenvalues
+                if (beta <= 1E-12 * alpha)
+                    break;
+                subDiagonal.push_back(beta);
+            }
+            if (!(bounds.minimum > 0))
+                throw runtime_error("The spectral bounds require a positive definite operator.");
+            return bounds;
+        }
+
+        SpectralBounds _powerMethod(LinearOperator<T> &matrix, Preconditioner<T> *preconditioner, bool largestOnly) const {
+            unsigned n = matrix.numberOfRows();
+            unsigned threads = _availableThreads;
+            NumericalVector<T> x(n, 0, threads), product(n, 0, threads), y(n, 0, threads);
+            SpectralBounds bounds = {0, 0, 0, 0};
+            //y = M^-1 A x, or y = shift x - M^-1 A x
+            auto iterate = [&](double shift) {
+                _startVector(x);
+                double estimate = 0;
+                x.scale(static_cast<T>(1 / std::sqrt(static_cast<double>(x.dotProduct(x, threads)))), threads);
+                bounds.reductions++;
+                for (unsigned step = 0; step < _maxSteps; step++) {
+                    matrix.multiply(x, product);
+                    _applyPreconditioner(preconditioner, product, y);
+                    if (shift != 0)
+                        y.subtractIntoThis(x, -1, static_cast<T>(-shift), threads);
+                    bounds.steps++;
+                    bounds.reductions++;
+                    double norm = std::sqrt(static_cast<double>(y.dotProduct(y, threads)));
+                    bool converged = step > 0 && std::abs(norm - estimate) <= _tolerance * norm;
+                    estimate = norm;
+                    if (converged || norm == 0)
+                        break;
+                    x.add(y, x, 0, static_cast<T>(1 / norm), threads);
+                }
+                return estimate;
+            };
+            bounds.maximum = iterate(0);
+            if (!(bounds.maximum > 0))
+                throw runtime_error("The spectral bounds require a positive definite operator.");
+            if (largestOnly)
+                return bounds;
+            //The largest eigenvalue of λmax I - M^-1 A is λmax - λmin
+            bounds.minimum = bounds.maximum - iterate(bounds.maximum);
+            if (!(bounds.minimum > 0))
+                bounds.minimum = bounds.maximum * std::numeric_limits<double>::epsilon();
+            return bounds;
+        }
+    };
+
+    /**
+    * @brief Spectral bounds cached per operator and preconditioner, so that the solves and the smoothers of the same
+    * matrix estimate them once.
+    *
+    * An assembled matrix is identified by its address and guarded by a weak reference and a hash of its values, so an
+    * entry of a destroyed matrix or of values changed in place is never returned. The hash costs one pass over the
+    * values, about the cost of one matrix vector product. A matrix-free operator is identified by its identity, which
+    * a later operator at the same address does not share: call invalidate() if its action changes. A preconditioner
+    * is identified by the identity of its last setup(), so a new setup() is never served the bounds of the previous.
+    */
+    template<typename T>
+    class SpectralBoundsCache {
+    public:
+        /**
+        * @brief The preconditioner identity of the Jacobi scaling D^-1 A, which depends on the matrix alone.
+        */
+        static constexpr unsigned long diagonalScaling = numeric_limits<unsigned long>::max();
+
+        /**
+        * @brief The setup identity of a preconditioner, 0 for none.
+        */
+        static unsigned long identity(const Preconditioner<T> *preconditioner) {
+            return preconditioner != nullptr ? preconditioner->getSetupIdentity() : 0;
+        }
+
+        /**
+        * @brief The cached bounds of the matrix and the preconditioner identity, or null.
+        */
+        const SpectralBounds *find(const shared_ptr<NumericalMatrix<T>> &matrix, unsigned long preconditionerIdentity) {
+            auto entry = _entries.find(EntryKey(matrix.get(), 0, preconditionerIdentity));
+            if (entry == _entries.end())
+                return nullptr;
+            if (entry->second.matrix.lock() != matrix || entry->second.fingerprint != _fingerprint(*matrix)) {
+                _entries.erase(entry);
+                return nullptr;
+            }
+            return &entry->second.bounds;
+        }
+
+        /**
+        * @brief The cached bounds of a matrix-free operator and the preconditioner identity, or null.
+        */
+        const SpectralBounds *find(const LinearOperator<T> &matrixFree, unsigned long preconditionerIdentity) {
+            auto entry = _entries.find(EntryKey(nullptr, matrixFree.getIdentity(), preconditionerIdentity));
+            return entry == _entries.end() ? nullptr : &entry->second.bounds;
+        }
+
+        void store(const shared_ptr<NumericalMatrix<T>> &matrix, unsigned long preconditionerIdentity, const SpectralBounds &bounds) {
+            _entries[EntryKey(matrix.get(), 0, preconditionerIdentity)] = {bounds, matrix, _fingerprint(*matrix)};
+        }
+
+        void store(const LinearOperator<T> &matrixFree, unsigned long preconditionerIdentity, const SpectralBounds &bounds) {
+            _entries[EntryKey(nullptr, matrixFree.getIdentity(), preconditionerIdentity)] = {bounds, weak_ptr<NumericalMatrix<T>>(), 0};
+        }
+
+        /**
+        * @brief Removes the entries of a matrix, given the address of the NumericalMatrix.
+        */
+        void invalidate(const void *matrix) {
+            for (auto entry = _entries.begin(); entry != _entries.end();)
+                entry = std::get<0>(entry->first) == matrix ? _entries.erase(entry) : std::next(entry);
+        }
+
+        /**
+        * @brief Removes the entries of a matrix-free operator.
+        */
+        void invalidate(const LinearOperator<T> &matrixFree) {
+            for (auto entry = _entries.begin(); entry != _entries.end();)
+                entry = std::get<1>(entry->first) == matrixFree.getIdentity() ? _entries.erase(entry) : std::next(entry);
+        }
+
+        void clear() {
+            _entries.clear();
+        }
+
+        unsigned size() const {
+            return static_cast<unsigned>(_entries.size());
+        }
+
+    private:
+        struct Entry {
+            SpectralBounds bounds;
+            weak_ptr<NumericalMatrix<T>> matrix;
+            size_t fingerprint;
+        };
+
+        //The address of the matrix or null, the identity of the operator or 0, and the preconditioner identity
+        typedef tuple<const void *, unsigned long, unsigned long> EntryKey;
+
+        map<EntryKey, Entry> _entries;
+
+        static size_t _fingerprint(NumericalMatrix<T> &matrix) {
+            unsigned size = matrix.dataStorage->getValues()->size();
+            const T* values = matrix.dataStorage->getValuesDataPointer();
+            size_t fingerprint = size;
+            std::hash<T> hash;
+            for (unsigned i = 0; i < size; i++)
+                fingerprint = (fingerprint ^ hash(values[i])) * 1099511628211ULL;
+            return fingerprint;
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_SPECTRALBOUNDSESTIMATOR_H
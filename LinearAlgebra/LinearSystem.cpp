@@ -5,17 +5,80 @@
 #include <fstream>
 #include <utility>
 #include "LinearSystem.h"
+#include "ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrix.h"
+#include "ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrixIO/NumericalMatrixIO.h"
+#include "ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrixReordering/NumericalMatrixReordering.h"
 
 namespace LinearAlgebra {
     
     LinearSystem::LinearSystem(shared_ptr<Array<double>> inputMatrix, shared_ptr<vector<double>> inputRHS) :
             matrix(std::move(inputMatrix)),
             rhs(std::move(inputRHS)),
-            solution(nullptr) {}
+            solution(nullptr),
+            permutation(nullptr) {}
     
+    shared_ptr<NumericalMatrix<double>> LinearSystem::getCSRMatrix(unsigned availableThreads) const {
+        unsigned n = matrix->numberOfRows();
+        unsigned m = matrix->numberOfColumns();
+        auto csrMatrix = make_shared<NumericalMatrix<double>>(n, m, CSR, General, availableThreads);
+        csrMatrix->dataStorage->initializeElementAssignment();
+        for (unsigned i = 0; i < n; i++) {
+            for (unsigned j = 0; j < m; j++) {
+                if (matrix->at(i, j) != 0.0)
+                    csrMatrix->setElement(i, j, matrix->at(i, j));
+            }
+        }
+        csrMatrix->dataStorage->finalizeElementAssignment();
+        return csrMatrix;
+    }
+    
+    void LinearSystem::reorder(const vector<unsigned>& newPermutation) {
+        unsigned n = matrix->numberOfRows();
+        if (newPermutation.size() != n || matrix->numberOfColumns() != n)
+            throw invalid_argument("Permutation size does not match the linear system size.");
+        NumericalMatrixReordering<double>::checkPermutation(newPermutation, n);
+        if (solution != nullptr && solution->size() != n)
+            throw invalid_argument("Solution size does not match the linear system size.");
+        
+        auto reorderedMatrix = vector<double>(n * n);
+        auto reorderedRHS = vector<double>(n);
+        for (unsigned i = 0; i < n; i++) {
+            for (unsigned j = 0; j < n; j++) {
+                reorderedMatrix[i * n + j] = matrix->at(newPermutation[i], newPermutation[j]);
+            }
+            reorderedRHS[i] = rhs->at(newPermutation[i]);
+        }
+        //Copy in place so that the solvers holding the system keep valid references
+        std::copy(reorderedMatrix.begin(), reorderedMatrix.end(), matrix->getArrayPointer());
+        *rhs = reorderedRHS;
+        if (solution != nullptr) {
+            auto reorderedSolution = vector<double>(n);
+            for (unsigned i = 0; i < n; i++)
+                reorderedSolution[i] = solution->at(newPermutation[i]);
+            *solution = reorderedSolution;
+        }
+        
+        if (permutation == nullptr) {
+            permutation = make_shared<vector<unsigned>>(newPermutation);
+        }
+        else {
+            auto composedPermutation = make_shared<vector<unsigned>>(n);
+            for (unsigned i = 0; i < n; i++)
+                composedPermutation->at(i) = permutation->at(newPermutation[i]);
+            permutation = composedPermutation;
+        }
+    }
 
 
 
+
+    void LinearSystem::exportToMatrixMarketFiles(const string& fileName, const string& filePath) const {
+        NumericalMatrixIO<double>::writeMatrixMarket(*getCSRMatrix(), filePath + fileName + ".mtx");
+        NumericalVector<double> rhsVector(rhs->size());
+        std::copy(rhs->begin(), rhs->end(), rhsVector.getDataPointer());
+        NumericalMatrixIO<double>::writeMatrixMarketVector(rhsVector, filePath + fileName + "_rhs.mtx");
+    }
+
     void LinearSystem::exportToMatlabFile(const string& fileName, const string& filePath, bool printSolution) const {
 
         ofstream outputFile(filePath + fileName);
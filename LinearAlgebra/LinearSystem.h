@@ -9,6 +9,9 @@
 
 namespace LinearAlgebra {
 
+    template<typename T>
+    class NumericalMatrix;
+
     class LinearSystem {
         
     public:
@@ -22,7 +25,33 @@ namespace LinearAlgebra {
 
         shared_ptr<vector<double>> solution;
         
+        /**
+         * @brief The symmetric permutation applied to the system (permutation[newIndex] = oldIndex).
+         * nullptr if the system is in the original degree of freedom numbering.
+         */
+        shared_ptr<vector<unsigned>> permutation;
+        
+        /**
+         * @brief Creates a CSR copy of the matrix that contains only its non-zero elements.
+         * @param availableThreads Number of threads assigned to the CSR matrix operations.
+         */
+        shared_ptr<NumericalMatrix<double>> getCSRMatrix(unsigned availableThreads = 1) const;
+        
+        /**
+         * @brief Applies a symmetric permutation to the matrix and the right hand side in place, A = P A P^T, b = P b.
+         * Successive permutations are composed, so that the stored permutation always maps to the original numbering.
+         * An existing solution, which the direct solvers also start from, is permuted with the system, x = P x.
+         * @param newPermutation The permutation vector (newPermutation[newIndex] = oldIndex).
+         */
+        void reorder(const vector<unsigned>& newPermutation);
+        
         void exportToMatlabFile(const string& fileName, const string& filePath, bool printSolution ) const;
+        
+        /**
+         * @brief Exports the non-zero elements of the matrix to filePath + fileName + ".mtx" and the right hand side to
+         * filePath + fileName + "_rhs.mtx" in the Matrix Market format.
+         */
+        void exportToMatrixMarketFiles(const string& fileName, const string& filePath) const;
     };
 
 } // LinearAlgebra
@@ -0,0 +1,154 @@
+//
+// Created by hal9000 on 11/3/23.
+//
+
+#ifndef UNTITLED_FASTFOURIERTRANSFORM_H
+#define UNTITLED_FASTFOURIERTRANSFORM_H
+
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Discrete Fourier transform X_k = Σ_j x_j e^(-2πi jk/n) of complex sequences of a fixed length n in
+    * O(n log n).
+    *
+    * Lengths that are powers of two use the iterative radix-2 Cooley-Tukey algorithm with precomputed twiddle factors
+    * and bit reversal permutation. Any other length uses Bluestein's algorithm: with jk = (j² + k² - (k - j)²) / 2 the
+    * transform becomes a convolution with the chirp e^(iπ j²/n), which is computed with radix-2 transforms of the
+    * next power of two of length at least 2n - 1.
+    *
+    * The plan is immutable after construction, so one instance can transform sequences from many threads, each with
+    * its own work vector.
+    *
+    * @tparam T The floating point type of the real and imaginary parts.
+    */
+    template<typename T>
+    class FastFourierTransform {
+    public:
+        explicit FastFourierTransform(unsigned size) : _size(size) {
+            if (size == 0)
+                throw invalid_argument("The Fourier transform requires a non-zero length.");
+            _radixSize = 1;
+            while (_radixSize < (_isPowerOfTwo(size) ? size : 2 * size - 1))
+                _radixSize *= 2;
+            _bitReversal.resize(_radixSize);
+            unsigned bits = 0;
+            while ((1u << bits) < _radixSize)
+                bits++;
+            for (unsigned i = 0; i < _radixSize; i++) {
+                unsigned reversed = 0;
+                for (unsigned bit = 0; bit < bits; bit++)
+                    reversed |= ((i >> bit) & 1u) << (bits - 1 - bit);
+                _bitReversal[i] = reversed;
+            }
+            _twiddles.resize(_radixSize / 2);
+            for (unsigned k = 0; k < _radixSize / 2; k++)
+                _twiddles[k] = polar(static_cast<T>(1), static_cast<T>(-2 * M_PI * k / _radixSize));
+            if (_isPowerOfTwo(size))
+                return;
+
+            //Chirp e^(-iπ k²/n), with k² reduced modulo 2n to keep the angles small
+            _chirp.resize(size);
+            for (unsigned k = 0; k < size; k++) {
+                auto square = static_cast<unsigned long long>(k) * k % (2ull * size);
+                _chirp[k] = polar(static_cast<T>(1), static_cast<T>(-M_PI * static_cast<double>(square) / size));
+            }
+            _chirpFilter.assign(_radixSize, complex<T>(0));
+            _chirpFilter[0] = conj(_chirp[0]);
+            for (unsigned k = 1; k < size; k++)
+                _chirpFilter[k] = _chirpFilter[_radixSize - k] = conj(_chirp[k]);
+            _radix2(_chirpFilter.data(), false);
+        }
+
+        unsigned size() const {
+            return _size;
+        }
+
+        /**
+        * @brief Transforms the n elements of data in place.
+        *
+        * @param work Scratch space of the Bluestein algorithm, resized if needed. Not used for powers of two.
+        * @param inverse Computes Σ_k X_k e^(2πi jk/n), the inverse transform without the factor 1/n.
+        */
+        void transform(complex<T>* data, vector<complex<T>> &work, bool inverse = false) const {
+            if (_chirp.empty()) {
+                _radix2(data, inverse);
+                return;
+            }
+            //The inverse transform is the conjugate of the forward transform of the conjugate
+            if (inverse)
+                for (unsigned k = 0; k < _size; k++)
+                    data[k] = conj(data[k]);
+            work.assign(_radixSize, complex<T>(0));
+            for (unsigned k = 0; k < _size; k++)
+                work[k] = data[k] * _chirp[k];
+            _radix2(work.data(), false);
+            for (unsigned k = 0; k < _radixSize; k++)
+                work[k] *= _chirpFilter[k];
+            _radix2(work.data(), true);
+            T scale = static_cast<T>(1) / static_cast<T>(_radixSize);
+            for (unsigned k = 0; k < _size; k++)
+                data[k] = work[k] * _chirp[k] * scale;
+            if (inverse)
+                for (unsigned k = 0; k < _size; k++)
+                    data[k] = conj(data[k]);
+        }
+
+        void transform(complex<T>* data, bool inverse = false) const {
+            vector<complex<T>> work;
+            transform(data, work, inverse);
+        }
+
+    private:
+        unsigned _size;
+
+        unsigned _radixSize;
+
+        vector<unsigned> _bitReversal;
+
+        vector<complex<T>> _twiddles;
+
+        vector<complex<T>> _chirp;
+
+        //Transform of the conjugate chirp, wrapped around to a circular convolution of length _radixSize
+        vector<complex<T>> _chirpFilter;
+
+        static bool _isPowerOfTwo(unsigned n) {
+            return (n & (n - 1)) == 0;
+        }
+
+        /**
+        * @brief In place radix-2 transform of length _radixSize. The inverse is not scaled.
+        */
+        void _radix2(complex<T>* data, bool inverse) const {
+            unsigned n = _radixSize;
+            for (unsigned i = 0; i < n; i++)
+                if (i < _bitReversal[i])
+                    std::swap(data[i], data[_bitReversal[i]]);
+            for (unsigned length = 2; length <= n; length *= 2) {
+                unsigned half = length / 2, step = n / length;
+                for (unsigned start = 0; start < n; start += length) {
+                    for (unsigned j = 0; j < half; j++) {
+                        const complex<T> &w = _twiddles[j * step];
+                        T wImaginary = inverse ? -w.imag() : w.imag();
+                        complex<T> u = data[start + j], odd = data[start + j + half];
+                        //Written out, without the NaN and infinity checks of the complex product
+                        complex<T> v(odd.real() * w.real() - odd.imag() * wImaginary,
+                                     odd.real() * wImaginary + odd.imag() * w.real());
+                        data[start + j] = u + v;
+                        data[start + j + half] = u - v;
+                    }
+                }
+            }
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_FASTFOURIERTRANSFORM_H
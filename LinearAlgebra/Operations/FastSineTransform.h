@@ -0,0 +1,86 @@
+//
+// Created by hal9000 on 11/3/23.
+//
+
+#ifndef UNTITLED_FASTSINETRANSFORM_H
+#define UNTITLED_FASTSINETRANSFORM_H
+
+#include "FastFourierTransform.h"
+#include "../../ThreadingOperations/ThreadingOperations.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Discrete sine transform of type I, X_k = Σ_j x_j sin(π (j + 1)(k + 1) / (n + 1)), j, k = 0, ..., n - 1.
+    *
+    * The sine vectors are the eigenvectors of the tridiagonal Toeplitz matrices, i.e. of the finite difference second
+    * derivative with Dirichlet boundaries, and the transform is its own inverse up to the factor 2 / (n + 1).
+    *
+    * It is computed with a complex Fourier transform of length 2(n + 1) of the odd extension
+    * y = (0, x_0, ..., x_{n-1}, 0, -x_{n-1}, ..., -x_0), whose transform is Y_{k+1} = -2i X_k. The transform of
+    * y1 + i y2 is -2i X1 + 2 X2, so two real sequences are transformed with one complex transform.
+    *
+    * @tparam T The floating point type of the sequences.
+    */
+    template<typename T>
+    class FastSineTransform {
+    public:
+        explicit FastSineTransform(unsigned size) : _size(size), _fourier(2 * (size + 1)) { }
+
+        unsigned size() const {
+            return _size;
+        }
+
+        /**
+        * @brief Transforms in place one or two sequences with elements stride apart.
+        *
+        * @param second The second sequence, or nullptr.
+        * @param buffer, work Scratch space of the extended sequence and of the Fourier transform, resized if needed.
+        */
+        void transform(T* first, T* second, size_t stride, vector<complex<T>> &buffer, vector<complex<T>> &work) const {
+            unsigned length = 2 * (_size + 1);
+            buffer.resize(length);
+            buffer[0] = buffer[_size + 1] = complex<T>(0);
+            for (unsigned j = 0; j < _size; j++) {
+                complex<T> value(first[j * stride], second != nullptr ? second[j * stride] : static_cast<T>(0));
+                buffer[j + 1] = value;
+                buffer[length - 1 - j] = -value;
+            }
+            _fourier.transform(buffer.data(), work);
+            for (unsigned k = 0; k < _size; k++) {
+                first[k * stride] = -buffer[k + 1].imag() / 2;
+                if (second != nullptr)
+                    second[k * stride] = buffer[k + 1].real() / 2;
+            }
+        }
+
+        /**
+        * @brief Transforms in place numberOfLines sequences. The elements of line l start at x + lineStart(l) and are
+        * stride apart, e.g. the grid lines of a structured mesh in one direction. The pairs of lines are distributed
+        * among the threads.
+        */
+        template<typename LineStart>
+        void transformLines(T* x, unsigned numberOfLines, LineStart lineStart, size_t stride,
+                            unsigned availableThreads = 1) const {
+            unsigned numberOfPairs = (numberOfLines + 1) / 2;
+            auto pairsJob = [&](unsigned start, unsigned end) {
+                vector<complex<T>> buffer, work;
+                for (unsigned pair = start; pair < end; pair++) {
+                    unsigned line = 2 * pair;
+                    T* second = line + 1 < numberOfLines ? x + lineStart(line + 1) : nullptr;
+                    transform(x + lineStart(line), second, stride, buffer, work);
+                }
+            };
+            //Ranges of whole pairs, without the cache line rounding
+            ThreadingOperations<T>::executeParallelJob(pairsJob, numberOfPairs, availableThreads, sizeof(T));
+        }
+
+    private:
+        unsigned _size;
+
+        FastFourierTransform<T> _fourier;
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_FASTSINETRANSFORM_H
@@ -0,0 +1,165 @@
+//
+// Created by hal9000 on 11/2/23.
+//
+
+#ifndef UNTITLED_BANDEDLU_H
+#define UNTITLED_BANDEDLU_H
+
+#include "BandedMatrix.h"
+#include "../Preconditioners/Preconditioner.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Direct solver for banded systems with the LU factorization with partial pivoting in band storage,
+    * O(n kl (kl + ku)) flops and O(n (2 kl + ku)) memory instead of the O(n³) and O(n²) of the dense LU.
+    *
+    * The pivot of column j is searched in the rows [j, j + kl], so the interchanges widen U to kl + ku diagonals,
+    * which the band storage reserves. The interchanges are applied only to the columns of U and the multipliers stay
+    * where they are computed, so the solve applies the interchanges and the eliminations column by column.
+    *
+    * As a Preconditioner, setup() copies and factorizes a CSR matrix and apply() solves the system exactly. Systems
+    * that are tridiagonal and need no pivoting (diagonally dominant or symmetric positive definite) can use
+    * TridiagonalSolver directly.
+    *
+    * @tparam T The datatype of the matrix and vector elements.
+    */
+    template<typename T>
+    class BandedLU : public Preconditioner<T> {
+    public:
+        /**
+        * @param pivotTolerance A pivot with absolute value below the tolerance is reported as singular.
+        */
+        explicit BandedLU(double pivotTolerance = 0) : _pivotTolerance(pivotTolerance) {
+            this->_name = "Banded LU";
+        }
+
+        /**
+        * @brief Copies the CSR matrix into band storage and factorizes it.
+        * @throws runtime_error If the matrix is singular.
+        */
+        void setup(const shared_ptr<NumericalMatrix<T>> &matrix) override {
+            this->_csrArrays(matrix);
+            this->_numberOfRows = matrix->numberOfRows();
+            this->_availableThreads = matrix->dataStorage->getAvailableThreads();
+            _factors = BandedMatrix<T>::fromCSR(matrix);
+            this->_name = "Banded LU (" + to_string(_factors->lowerBandwidth()) + ", " +
+                          to_string(_factors->upperBandwidth()) + ")";
+            this->_isSetUp = false;
+            unsigned failedColumn = factorize(*_factors, _pivots, _pivotTolerance);
+            if (failedColumn != this->_numberOfRows)
+                throw runtime_error("Banded LU: the matrix is singular. Zero pivot at column " + to_string(failedColumn) + ".");
+            this->_markSetUp();
+        }
+
+        /**
+        * @brief z = A^-1 r.
+        */
+        void apply(NumericalVector<T> &r, NumericalVector<T> &z) override {
+            this->_checkApply(r, z);
+            std::copy(r.getDataPointer(), r.getDataPointer() + r.size(), z.getDataPointer());
+            solve(*_factors, _pivots, z.getDataPointer());
+        }
+
+        /**
+        * @brief Solves A X = B for many right hand sides, distributed among the threads of the matrix.
+        */
+        void solve(const vector<shared_ptr<NumericalVector<T>>> &rhs, vector<shared_ptr<NumericalVector<T>>> &solutions) {
+            if (rhs.size() != solutions.size())
+                throw invalid_argument("The number of right hand sides and solutions must be equal.");
+            for (unsigned column = 0; column < rhs.size(); column++)
+                this->_checkApply(*rhs[column], *solutions[column]);
+            auto columnsJob = [&](unsigned start, unsigned end) {
+                for (unsigned column = start; column < end; column++) {
+                    std::copy(rhs[column]->getDataPointer(), rhs[column]->getDataPointer() + this->_numberOfRows,
+                              solutions[column]->getDataPointer());
+                    solve(*_factors, _pivots, solutions[column]->getDataPointer());
+                }
+            };
+            ThreadingOperations<T>::executeParallelJob(columnsJob, rhs.size(), this->_availableThreads, sizeof(T));
+        }
+
+        /**
+        * @brief Returns the factors in band storage: the multipliers below the diagonal and U on and above it.
+        */
+        const shared_ptr<BandedMatrix<T>> &getFactors() const {
+            return _factors;
+        }
+
+        /**
+        * @brief Factorizes a banded matrix in place.
+        *
+        * @param pivots Output. pivots[j] is the row interchanged with row j at step j.
+        * @return The size of the matrix on success, otherwise the column of the first pivot below the tolerance.
+        */
+        static unsigned factorize(BandedMatrix<T> &a, vector<unsigned> &pivots, double pivotTolerance = 0) {
+            unsigned n = a.size(), kl = a.lowerBandwidth(), ku = a.upperBandwidth();
+            T* data = a.getDataPointer();
+            pivots.resize(n);
+            for (unsigned j = 0; j < n; j++) {
+                unsigned lastRow = std::min(n - 1, j + kl);
+                unsigned lastColumn = std::min(n - 1, j + kl + ku);
+                unsigned pivot = j;
+                T maximum = std::abs(data[a.rowOffset(j) + j]);
+                for (unsigned i = j + 1; i <= lastRow; i++)
+                    if (std::abs(data[a.rowOffset(i) + j]) > maximum) {
+                        maximum = std::abs(data[a.rowOffset(i) + j]);
+                        pivot = i;
+                    }
+                if (!(maximum > pivotTolerance) || maximum == static_cast<T>(0))
+                    return j;
+                pivots[j] = pivot;
+                T* pivotRow = data + a.rowOffset(j);
+                if (pivot != j) {
+                    T* other = data + a.rowOffset(pivot);
+                    for (unsigned column = j; column <= lastColumn; column++)
+                        std::swap(pivotRow[column], other[column]);
+                }
+                T inverse = 1 / pivotRow[j];
+                for (unsigned i = j + 1; i <= lastRow; i++) {
+                    T* row = data + a.rowOffset(i);
+                    T multiplier = row[j] *= inverse;
+                    if (multiplier == static_cast<T>(0))
+                        continue;
+                    for (unsigned column = j + 1; column <= lastColumn; column++)
+                        row[column] -= multiplier * pivotRow[column];
+                }
+            }
+            return n;
+        }
+
+        /**
+        * @brief Solves A x = b in place with the factors of factorize(). x holds b on entry.
+        */
+        static void solve(const BandedMatrix<T> &lu, const vector<unsigned> &pivots, T* x) {
+            unsigned n = lu.size(), kl = lu.lowerBandwidth(), ku = lu.upperBandwidth();
+            const T* data = lu.getDataPointer();
+            for (unsigned j = 0; j < n; j++) {
+                if (pivots[j] != j)
+                    std::swap(x[j], x[pivots[j]]);
+                T xj = x[j];
+                unsigned lastRow = std::min(n - 1, j + kl);
+                for (unsigned i = j + 1; i <= lastRow; i++)
+                    x[i] -= data[lu.rowOffset(i) + j] * xj;
+            }
+            for (unsigned i = n; i-- > 0;) {
+                const T* row = data + lu.rowOffset(i);
+                unsigned lastColumn = std::min(n - 1, i + kl + ku);
+                T sum = x[i];
+                for (unsigned column = i + 1; column <= lastColumn; column++)
+                    sum -= row[column] * x[column];
+                x[i] = sum / row[i];
+            }
+        }
+
+    private:
+        double _pivotTolerance;
+
+        shared_ptr<BandedMatrix<T>> _factors;
+
+        vector<unsigned> _pivots;
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_BANDEDLU_H
@@ -0,0 +1,144 @@
+//
+// Created by hal9000 on 11/2/23.
+//
+
+#ifndef UNTITLED_BANDEDMATRIX_H
+#define UNTITLED_BANDEDMATRIX_H
+
+#include "../../ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrix.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Square matrix with lowerBandwidth diagonals below and upperBandwidth diagonals above the main diagonal,
+    * the systems of the finite difference stencils on 1D meshes (3 diagonals for second order, 5 for fourth order
+    * or upwind schemes) and of the lines of structured grids.
+    *
+    * Row major band storage: row i holds the columns [i - lowerBandwidth, i + lowerBandwidth + upperBandwidth], i.e.
+    * 2 lowerBandwidth + upperBandwidth + 1 elements of which the last lowerBandwidth are zero. They receive the fill
+    * of the row interchanges of the LU factorization with partial pivoting, so that it runs in place (as the band
+    * storage of LAPACK GBTRF). Element (i, j) is data[i (width - 1) + lowerBandwidth + j].
+    *
+    * @tparam T The datatype of the matrix elements.
+    */
+    template<typename T>
+    class BandedMatrix {
+    public:
+        BandedMatrix(unsigned size, unsigned lowerBandwidth, unsigned upperBandwidth) :
+                _size(size), _lowerBandwidth(lowerBandwidth), _upperBandwidth(upperBandwidth),
+                _width(2 * lowerBandwidth + upperBandwidth + 1), _data(static_cast<size_t>(size) * _width, 0) { }
+
+        /**
+        * @brief Copies a square CSR matrix into band storage with the smallest bandwidths that hold its non-zero
+        * elements.
+        */
+        static shared_ptr<BandedMatrix<T>> fromCSR(const shared_ptr<NumericalMatrix<T>> &matrix) {
+            if (matrix->dataStorage->getStorageType() != CSR)
+                throw invalid_argument("The banded matrix requires a matrix stored in CSR format.");
+            if (matrix->numberOfRows() != matrix->numberOfColumns())
+                throw invalid_argument("The banded matrix requires a square matrix.");
+            unsigned n = matrix->numberOfRows();
+            auto values = matrix->dataStorage->getValuesDataPointer();
+            auto columnIndices = matrix->dataStorage->getSupplementaryDataPointers()[0];
+            auto rowOffsets = matrix->dataStorage->getSupplementaryDataPointers()[1];
+            unsigned lower = 0, upper = 0;
+            for (unsigned row = 0; row < n; row++)
+                for (unsigned k = rowOffsets[row]; k < rowOffsets[row + 1]; k++) {
+                    unsigned column = columnIndices[k];
+                    if (values[k] == static_cast<T>(0))
+                        continue;
+                    lower = column < row ? std::max(lower, row - column) : lower;
+                    upper = column > row ? std::max(upper, column - row) : upper;
+                }
+            auto banded = make_shared<BandedMatrix<T>>(n, lower, upper);
+            for (unsigned row = 0; row < n; row++)
+                for (unsigned k = rowOffsets[row]; k < rowOffsets[row + 1]; k++)
+                    if (values[k] != static_cast<T>(0))
+                        banded->at(row, columnIndices[k]) += values[k];
+            return banded;
+        }
+
+        unsigned size() const {
+            return _size;
+        }
+
+        unsigned lowerBandwidth() const {
+            return _lowerBandwidth;
+        }
+
+        unsigned upperBandwidth() const {
+            return _upperBandwidth;
+        }
+
+        /**
+        * @brief Returns true if (row, column) is inside the stored band, including the fill diagonals.
+        */
+        bool isStored(unsigned row, unsigned column) const {
+            return row < _size && column < _size && column + _lowerBandwidth >= row &&
+                   column <= row + _lowerBandwidth + _upperBandwidth;
+        }
+
+        T &at(unsigned row, unsigned column) {
+            if (!isStored(row, column))
+                throw out_of_range("Element (" + to_string(row) + ", " + to_string(column) + ") is outside the band.");
+            return _data[_offset(row) + column];
+        }
+
+        T at(unsigned row, unsigned column) const {
+            return isStored(row, column) ? _data[_offset(row) + column] : static_cast<T>(0);
+        }
+
+        /**
+        * @brief y = A x, with the original band [i - lowerBandwidth, i + upperBandwidth] of every row. Valid only
+        * before the matrix is factorized in place.
+        */
+        void multiply(const T* x, T* y, unsigned availableThreads = 1) const {
+            auto rowsJob = [&](unsigned start, unsigned end) {
+                for (unsigned row = start; row < end; row++) {
+                    unsigned first = row > _lowerBandwidth ? row - _lowerBandwidth : 0;
+                    unsigned last = std::min(_size - 1, row + _upperBandwidth);
+                    const T* values = _data.data() + _offset(row);
+                    T sum = 0;
+                    for (unsigned column = first; column <= last; column++)
+                        sum += values[column] * x[column];
+                    y[row] = sum;
+                }
+            };
+            ThreadingOperations<T>::executeParallelJob(rowsJob, _size, availableThreads);
+        }
+
+        T* getDataPointer() {
+            return _data.data();
+        }
+
+        const T* getDataPointer() const {
+            return _data.data();
+        }
+
+        /**
+        * @brief Index in the data of the (possibly not stored) element (row, 0), so that element (row, column) is at
+        * rowOffset(row) + column. Never negative: it equals row (width - 1) + lowerBandwidth.
+        */
+        size_t rowOffset(unsigned row) const {
+            return _offset(row);
+        }
+
+    private:
+        unsigned _size;
+
+        unsigned _lowerBandwidth;
+
+        unsigned _upperBandwidth;
+
+        unsigned _width;
+
+        vector<T> _data;
+
+        size_t _offset(unsigned row) const {
+            return static_cast<size_t>(row) * (_width - 1) + _lowerBandwidth;
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_BANDEDMATRIX_H
@@ -0,0 +1,222 @@
+//
+// Created by hal9000 on 10/31/23.
+//
+
+#ifndef UNTITLED_DENSEBLOCKKERNELS_H
+#define UNTITLED_DENSEBLOCKKERNELS_H
+
+#include <cmath>
+#include "../../../ThreadingOperations/ThreadingOperations.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Dense kernels on column major blocks with a leading dimension, the BLAS-3 building blocks of the
+    * supernodal factorizations (POTRF, TRSM, SYRK, GEMM).
+    *
+    * The innermost loops run down contiguous columns so that they vectorize, and the symmetric update works on four
+    * columns at a time to reuse every loaded element of A four times. The kernels that take a number of threads split
+    * independent rows or columns of the output among them and fall back to the calling thread for small blocks.
+    *
+    * @tparam T The datatype of the block elements.
+    */
+    template<typename T>
+    class DenseBlockKernels {
+    public:
+        /**
+        * @brief In place Cholesky factorization A = L L^T of the n x n block a. Only the lower triangle is referenced
+        * and overwritten with L.
+        *
+        * Right looking with blocks of _blockSize columns: unblocked factorization of the diagonal block, triangular
+        * solve of the panel below it and symmetric update of the trailing block.
+        *
+        * @return false if a pivot is not positive, i.e. the matrix is not positive definite.
+        */
+        static bool cholesky(T* a, unsigned n, unsigned lda, unsigned availableThreads = 1) {
+            for (unsigned first = 0; first < n; first += _blockSize) {
+                unsigned width = n - first < _blockSize ? n - first : _blockSize;
+                T* diagonalBlock = a + first + static_cast<size_t>(first) * lda;
+                if (!_unblockedCholesky(diagonalBlock, width, lda))
+                    return false;
+                unsigned below = n - first - width;
+                if (below == 0)
+                    break;
+                solveRightLowerTransposed(diagonalBlock, width, lda, diagonalBlock + width, below, lda, availableThreads);
+                subtractSymmetricProduct(diagonalBlock + width, below, width, lda,
+                                         diagonalBlock + width + static_cast<size_t>(width) * lda, lda, availableThreads);
+            }
+            return true;
+        }
+
+        /**
+        * @brief Solves X L^T = B for the m x n block B in place, with L n x n lower triangular (TRSM, right side).
+        * The rows of B are independent and are distributed among the threads.
+        */
+        static void solveRightLowerTransposed(const T* l, unsigned n, unsigned ldl, T* b, unsigned m, unsigned ldb,
+                                              unsigned availableThreads = 1) {
+            auto rowsJob = [&](unsigned start, unsigned end) {
+                for (unsigned j = 0; j < n; j++) {
+                    T* bj = b + static_cast<size_t>(j) * ldb;
+                    for (unsigned p = 0; p < j; p++) {
+                        T ljp = l[j + static_cast<size_t>(p) * ldl];
+                        const T* bp = b + static_cast<size_t>(p) * ldb;
+                        for (unsigned i = start; i < end; i++)
+                            bj[i] -= bp[i] * ljp;
+                    }
+                    T inverse = 1 / l[j + static_cast<size_t>(j) * ldl];
+                    for (unsigned i = start; i < end; i++)
+                        bj[i] *= inverse;
+                }
+            };
+            ThreadingOperations<T>::executeParallelJob(rowsJob, m, _threadsFor(m, availableThreads));
+        }
+
+        /**
+        * @brief C = C - A A^T on the lower triangle of the m x m block C, with A m x k (SYRK). The elements above the
+        * diagonal are not referenced.
+        *
+        * The columns of C are processed in groups of four, and the groups are dealt round robin to the threads to
+        * balance the triangular work.
+        */
+        static void subtractSymmetricProduct(const T* a, unsigned m, unsigned k, unsigned lda, T* c, unsigned ldc,
+                                             unsigned availableThreads = 1) {
+            unsigned numberOfGroups = (m + 3) / 4;
+            unsigned threads = _threadsFor(m, availableThreads);
+            auto groupsJob = [&](unsigned thread, unsigned) {
+                for (unsigned group = thread; group < numberOfGroups; group += threads) {
+                    unsigned j = 4 * group;
+                    unsigned width = std::min(4u, m - j);
+                    T* c0 = c + static_cast<size_t>(j) * ldc;
+                    if (width < 4) {
+                        for (unsigned column = j; column < m; column++)
+                            for (unsigned p = 0; p < k; p++) {
+                                T ajp = a[column + static_cast<size_t>(p) * lda];
+                                const T* ap = a + static_cast<size_t>(p) * lda;
+                                T* cj = c + static_cast<size_t>(column) * ldc;
+                                for (unsigned i = column; i < m; i++)
+                                    cj[i] -= ap[i] * ajp;
+                            }
+                        continue;
+                    }
+                    T* c1 = c0 + ldc, *c2 = c1 + ldc, *c3 = c2 + ldc;
+                    for (unsigned p = 0; p < k; p++) {
+                        const T* ap = a + static_cast<size_t>(p) * lda;
+                        T a0 = ap[j], a1 = ap[j + 1], a2 = ap[j + 2], a3 = ap[j + 3];
+                        //Lower triangle of the 4 x 4 diagonal block
+                        c0[j] -= a0 * a0;
+                        c0[j + 1] -= ap[j + 1] * a0; c1[j + 1] -= ap[j + 1] * a1;
+                        c0[j + 2] -= ap[j + 2] * a0; c1[j + 2] -= ap[j + 2] * a1; c2[j + 2] -= ap[j + 2] * a2;
+                        c0[j + 3] -= ap[j + 3] * a0; c1[j + 3] -= ap[j + 3] * a1; c2[j + 3] -= ap[j + 3] * a2;
+                        c3[j + 3] -= ap[j + 3] * a3;
+                        for (unsigned i = j + 4; i < m; i++) {
+                            T ai = ap[i];
+                            c0[i] -= ai * a0;
+                            c1[i] -= ai * a1;
+                            c2[i] -= ai * a2;
+                            c3[i] -= ai * a3;
+                        }
+                    }
+                }
+            };
+            //One index per thread, without the cache line rounding of the ranges
+            ThreadingOperations<T>::executeParallelJob(groupsJob, threads, threads, sizeof(T));
+        }
+
+        /**
+        * @brief Solves L X = B in place for the n x k block B, with L n x n lower triangular.
+        */
+        static void solveLeftLower(const T* l, unsigned n, unsigned ldl, T* b, unsigned k, unsigned ldb) {
+            for (unsigned column = 0; column < k; column++) {
+                T* x = b + static_cast<size_t>(column) * ldb;
+                for (unsigned j = 0; j < n; j++) {
+                    const T* lj = l + static_cast<size_t>(j) * ldl;
+                    x[j] /= lj[j];
+                    T xj = x[j];
+                    for (unsigned i = j + 1; i < n; i++)
+                        x[i] -= lj[i] * xj;
+                }
+            }
+        }
+
+        /**
+        * @brief Solves L^T X = B in place for the n x k block B, with L n x n lower triangular.
+        */
+        static void solveLeftLowerTransposed(const T* l, unsigned n, unsigned ldl, T* b, unsigned k, unsigned ldb) {
+            for (unsigned column = 0; column < k; column++) {
+                T* x = b + static_cast<size_t>(column) * ldb;
+                for (unsigned j = n; j-- > 0;) {
+                    const T* lj = l + static_cast<size_t>(j) * ldl;
+                    T sum = x[j];
+                    for (unsigned i = j + 1; i < n; i++)
+                        sum -= lj[i] * x[i];
+                    x[j] = sum / lj[j];
+                }
+            }
+        }
+
+        /**
+        * @brief C = A B with A m x n, B n x k and C m x k (GEMM).
+        */
+        static void multiply(const T* a, unsigned m, unsigned n, unsigned lda, const T* b, unsigned k, unsigned ldb,
+                             T* c, unsigned ldc) {
+            for (unsigned column = 0; column < k; column++) {
+                T* cColumn = c + static_cast<size_t>(column) * ldc;
+                std::fill(cColumn, cColumn + m, static_cast<T>(0));
+                for (unsigned p = 0; p < n; p++) {
+                    T bp = b[p + static_cast<size_t>(column) * ldb];
+                    const T* ap = a + static_cast<size_t>(p) * lda;
+                    for (unsigned i = 0; i < m; i++)
+                        cColumn[i] += ap[i] * bp;
+                }
+            }
+        }
+
+        /**
+        * @brief C = C - A^T B with A m x n, B m x k and C n x k (GEMM with the transpose of A).
+        */
+        static void subtractTransposedProduct(const T* a, unsigned m, unsigned n, unsigned lda, const T* b, unsigned k,
+                                              unsigned ldb, T* c, unsigned ldc) {
+            for (unsigned column = 0; column < k; column++) {
+                const T* bColumn = b + static_cast<size_t>(column) * ldb;
+                for (unsigned j = 0; j < n; j++) {
+                    const T* aj = a + static_cast<size_t>(j) * lda;
+                    T sum = 0;
+                    for (unsigned i = 0; i < m; i++)
+                        sum += aj[i] * bColumn[i];
+                    c[j + static_cast<size_t>(column) * ldc] -= sum;
+                }
+            }
+        }
+
+    private:
+        static constexpr unsigned _blockSize = 64;
+
+        static constexpr unsigned _minimumRowsPerThread = 64;
+
+        static unsigned _threadsFor(unsigned rows, unsigned availableThreads) {
+            return std::max(1u, std::min(availableThreads, rows / _minimumRowsPerThread));
+        }
+
+        static bool _unblockedCholesky(T* a, unsigned n, unsigned lda) {
+            for (unsigned j = 0; j < n; j++) {
+                T* aj = a + static_cast<size_t>(j) * lda;
+                for (unsigned p = 0; p < j; p++) {
+                    const T* ap = a + static_cast<size_t>(p) * lda;
+                    T ajp = ap[j];
+                    for (unsigned i = j; i < n; i++)
+                        aj[i] -= ap[i] * ajp;
+                }
+                if (!(aj[j] > 0))
+                    return false;
+                aj[j] = std::sqrt(aj[j]);
+                T inverse = 1 / aj[j];
+                for (unsigned i = j + 1; i < n; i++)
+                    aj[i] *= inverse;
+            }
+            return true;
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_DENSEBLOCKKERNELS_H
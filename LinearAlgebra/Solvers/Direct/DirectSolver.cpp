@@ -8,8 +8,7 @@ namespace LinearAlgebra {
     
     DirectSolver::DirectSolver(bool storeDecompositionOnMatrix) :
                     Solver(),
-                    _storeDecompositionOnMatrix(storeDecompositionOnMatrix),
-                    _linearSystem(nullptr){
+                    _storeDecompositionOnMatrix(storeDecompositionOnMatrix){
         _linearSystemInitialized = false;
         _vectorsInitialized = false;
     }
@@ -29,8 +29,6 @@ namespace LinearAlgebra {
         
         void _initializeVectors() override;
         
-        shared_ptr<LinearSystem> _linearSystem;
-        
         bool _storeDecompositionOnMatrix;
     };
 
@@ -0,0 +1,275 @@
+//
+// Created by hal9000 on 11/3/23.
+//
+
+#ifndef UNTITLED_FASTPOISSONSOLVER_H
+#define UNTITLED_FASTPOISSONSOLVER_H
+
+#include "SupernodalCholesky.h"
+#include "../../Operations/FastSineTransform.h"
+#include "../../../PositioningInSpace/DirectionsPositions.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Direct solver for the constant coefficient Poisson / Helmholtz systems of uniform boxes with Dirichlet
+    * boundaries in O(N log N), with fast sine transforms.
+    *
+    * The unknowns must be the nodes of a nx x ny (x nz) grid in lexicographic order (direction One fastest), as for
+    * GeometricMultigrid, e.g. the internal nodes of a parallelepiped mesh. The system qualifies if every row has the
+    * same diagonal element c and couples only to its neighbours in every direction d with the same element a_d. Then
+    * A = c I + Σ_d a_d S_d, with S_d the shift matrices of the lines in direction d, is diagonalized by the tensor
+    * product of the sine transforms, with eigenvalues λ(k) = c + Σ_d 2 a_d cos(π (k_d + 1) / (n_d + 1)), and
+    * x = S Λ^-1 S b is computed with a DST-I of all the lines in every direction, a scaling and the same transforms.
+    *
+    * setup() checks whether the matrix qualifies. If it does not (variable coefficients, other boundary conditions,
+    * non-uniform spacing in one direction, wider stencils) the system is solved with the fallback solver, by default
+    * a supernodal sparse Cholesky factorization, and getDetectionReport() states the reason. As a Preconditioner,
+    * apply() solves the system exactly.
+    *
+    * @tparam T The datatype of the matrix and vector elements.
+    */
+    template<typename T>
+    class FastPoissonSolver : public Preconditioner<T> {
+    public:
+        /**
+        * @param unknownsPerDirection The number of unknowns in each direction of the grid.
+        * @param relativeTolerance Elements that differ by less than the tolerance times the largest element are equal.
+        */
+        explicit FastPoissonSolver(const map<PositioningInSpace::Direction, unsigned> &unknownsPerDirection,
+                                   double relativeTolerance = 1E-10) :
+                _relativeTolerance(relativeTolerance), _usesFastPath(false),
+                _fallback(make_shared<SupernodalCholesky<T>>()) {
+            for (auto direction : {PositioningInSpace::One, PositioningInSpace::Two, PositioningInSpace::Three}) {
+                auto count = unknownsPerDirection.find(direction);
+                if (count != unknownsPerDirection.end() && count->second > 0)
+                    _dimensions.push_back(count->second);
+            }
+            if (_dimensions.empty())
+                throw invalid_argument("The fast Poisson solver requires at least one direction with unknowns.");
+            this->_name = "Fast Poisson (DST-I)";
+        }
+
+        /**
+        * @brief Sets the solver of the systems that do not qualify, nullptr to throw instead. Call before setup().
+        */
+        void setFallback(shared_ptr<Preconditioner<T>> fallback) {
+            _fallback = std::move(fallback);
+        }
+
+        /**
+        * @brief Checks whether the matrix qualifies and computes the eigenvalues, otherwise sets up the fallback.
+        * @throws invalid_argument If the matrix does not qualify and there is no fallback.
+        */
+        void setup(const shared_ptr<NumericalMatrix<T>> &matrix) override {
+            auto csr = this->_csrArrays(matrix);
+            this->_numberOfRows = csr.numberOfRows;
+            this->_availableThreads = matrix->dataStorage->getAvailableThreads();
+            this->_isSetUp = false;
+            _usesFastPath = _detect(csr);
+            if (_usesFastPath) {
+                _initializeTransforms();
+                this->_name = "Fast Poisson (DST-I)";
+                this->_markSetUp();
+                return;
+            }
+            if (_fallback == nullptr)
+                throw invalid_argument("The fast Poisson solver does not apply: " + _detectionReport);
+            _fallback->setup(matrix);
+            this->_name = "Fast Poisson fallback: " + _fallback->getName();
+            this->_markSetUp();
+        }
+
+        /**
+        * @brief z = A^-1 r.
+        */
+        void apply(NumericalVector<T> &r, NumericalVector<T> &z) override {
+            this->_checkApply(r, z);
+            if (!_usesFastPath) {
+                _fallback->apply(r, z);
+                return;
+            }
+            T* x = z.getDataPointer();
+            std::copy(r.getDataPointer(), r.getDataPointer() + r.size(), x);
+            _transformAllDirections(x);
+            const T* inverseEigenvalues = _inverseEigenvalues.data();
+            this->_parallelFor([&](unsigned start, unsigned end) {
+                for (unsigned i = start; i < end; i++)
+                    x[i] *= inverseEigenvalues[i];
+            }, this->_numberOfRows);
+            _transformAllDirections(x);
+        }
+
+        /**
+        * @brief Returns true if the last setup() found a qualifying system, false if it used the fallback.
+        */
+        bool usesFastPath() const {
+            return _usesFastPath;
+        }
+
+        /**
+        * @brief Returns the coefficients found by the last setup(), or the reason why the system does not qualify.
+        */
+        const string &getDetectionReport() const {
+            return _detectionReport;
+        }
+
+    private:
+        vector<unsigned> _dimensions;
+
+        double _relativeTolerance;
+
+        bool _usesFastPath;
+
+        shared_ptr<Preconditioner<T>> _fallback;
+
+        string _detectionReport;
+
+        T _diagonal = 0;
+
+        //a_d, the coupling of every node to its neighbours in direction d
+        vector<T> _couplings;
+
+        vector<shared_ptr<FastSineTransform<T>>> _transforms;
+
+        //The eigenvalues inverted and scaled with the normalization Π_d 2 / (n_d + 1) of the two transforms
+        vector<T> _inverseEigenvalues;
+
+        bool _detect(const typename Preconditioner<T>::CSRArrays &csr) {
+            unsigned unknowns = 1;
+            for (auto n : _dimensions)
+                unknowns *= n;
+            if (csr.numberOfRows != unknowns) {
+                _detectionReport = "the matrix size does not match the unknowns of the grid.";
+                return false;
+            }
+            unsigned dimensions = static_cast<unsigned>(_dimensions.size());
+            vector<size_t> strides(dimensions, 1);
+            for (unsigned d = 1; d < dimensions; d++)
+                strides[d] = strides[d - 1] * _dimensions[d - 1];
+            double largest = 0;
+            for (unsigned k = 0; k < csr.rowOffsets[unknowns]; k++)
+                largest = std::max(largest, std::abs(static_cast<double>(csr.values[k])));
+            double tolerance = _relativeTolerance * largest;
+
+            //The first row with a neighbour in a direction sets its coupling
+            vector<bool> couplingSet(dimensions, false);
+            _couplings.assign(dimensions, 0);
+            _diagonal = 0;
+            vector<T> lower(dimensions), upper(dimensions);
+            for (unsigned row = 0; row < unknowns; row++) {
+                T diagonal = 0;
+                std::fill(lower.begin(), lower.end(), static_cast<T>(0));
+                std::fill(upper.begin(), upper.end(), static_cast<T>(0));
+                for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++) {
+                    unsigned column = csr.columnIndices[k];
+                    if (column == row) {
+                        diagonal += csr.values[k];
+                        continue;
+                    }
+                    bool neighbour = false;
+                    for (unsigned d = 0; d < dimensions && !neighbour; d++) {
+                        unsigned position = static_cast<unsigned>(row / strides[d] % _dimensions[d]);
+                        if (position > 0 && column + strides[d] == row) {
+                            lower[d] += csr.values[k];
+                            neighbour = true;
+                        }
+                        else if (position + 1 < _dimensions[d] && column == row + strides[d]) {
+                            upper[d] += csr.values[k];
+                            neighbour = true;
+                        }
+                    }
+                    if (!neighbour && std::abs(static_cast<double>(csr.values[k])) > tolerance) {
+                        _detectionReport = "row " + to_string(row) + " couples to " + to_string(column) +
+                                           ", which is not a grid neighbour.";
+                        return false;
+                    }
+                }
+                if (row == 0)
+                    _diagonal = diagonal;
+                else if (std::abs(static_cast<double>(diagonal - _diagonal)) > tolerance) {
+                    _detectionReport = "the diagonal is not constant (row " + to_string(row) + ").";
+                    return false;
+                }
+                for (unsigned d = 0; d < dimensions; d++) {
+                    unsigned position = static_cast<unsigned>(row / strides[d] % _dimensions[d]);
+                    for (int side = 0; side < 2; side++) {
+                        bool exists = side == 0 ? position > 0 : position + 1 < _dimensions[d];
+                        if (!exists)
+                            continue;
+                        T value = side == 0 ? lower[d] : upper[d];
+                        if (!couplingSet[d]) {
+                            _couplings[d] = value;
+                            couplingSet[d] = true;
+                        }
+                        else if (std::abs(static_cast<double>(value - _couplings[d])) > tolerance) {
+                            _detectionReport = "the couplings in direction " + to_string(d + 1) +
+                                               " are not constant (row " + to_string(row) + ").";
+                            return false;
+                        }
+                    }
+                }
+            }
+
+            //λ(k) = c + Σ_d 2 a_d cos(π (k_d + 1) / (n_d + 1)) must not vanish
+            vector<vector<double>> modes(dimensions);
+            for (unsigned d = 0; d < dimensions; d++) {
+                modes[d].resize(_dimensions[d]);
+                for (unsigned k = 0; k < _dimensions[d]; k++)
+                    modes[d][k] = 2 * static_cast<double>(_couplings[d]) * std::cos(M_PI * (k + 1) / (_dimensions[d] + 1));
+            }
+            _inverseEigenvalues.assign(unknowns, 0);
+            double scale = 1;
+            for (auto n : _dimensions)
+                scale *= 2.0 / (n + 1);
+            double smallest = numeric_limits<double>::max();
+            for (unsigned node = 0; node < unknowns; node++) {
+                double eigenvalue = static_cast<double>(_diagonal);
+                for (unsigned d = 0; d < dimensions; d++)
+                    eigenvalue += modes[d][node / strides[d] % _dimensions[d]];
+                smallest = std::min(smallest, std::abs(eigenvalue));
+                _inverseEigenvalues[node] = eigenvalue != 0 ? static_cast<T>(scale / eigenvalue) : static_cast<T>(0);
+            }
+            if (!(smallest > 1E-14 * largest)) {
+                _detectionReport = "the matrix is singular, an eigenvalue of the sine modes is zero.";
+                return false;
+            }
+            _detectionReport = "c = " + to_string(_diagonal);
+            for (unsigned d = 0; d < dimensions; d++)
+                _detectionReport += ", a" + to_string(d + 1) + " = " + to_string(_couplings[d]);
+            return true;
+        }
+
+        void _initializeTransforms() {
+            _transforms.clear();
+            for (auto n : _dimensions) {
+                //Directions of equal length share the transform
+                shared_ptr<FastSineTransform<T>> transform;
+                for (auto &existing : _transforms)
+                    if (existing->size() == n)
+                        transform = existing;
+                _transforms.push_back(transform ? transform : make_shared<FastSineTransform<T>>(n));
+            }
+        }
+
+        /**
+        * @brief DST-I of all the grid lines in every direction, in place.
+        */
+        void _transformAllDirections(T* x) const {
+            size_t stride = 1;
+            for (unsigned d = 0; d < _dimensions.size(); d++) {
+                size_t length = _dimensions[d];
+                //Line l: the coordinates before direction d are l % stride, those after it l / stride
+                auto lineStart = [stride, length](unsigned line) {
+                    return line / stride * stride * length + line % stride;
+                };
+                _transforms[d]->transformLines(x, static_cast<unsigned>(this->_numberOfRows / length), lineStart, stride,
+                                               this->_availableThreads);
+                stride *= length;
+            }
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_FASTPOISSONSOLVER_H
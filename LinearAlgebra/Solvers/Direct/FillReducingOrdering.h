@@ -0,0 +1,373 @@
+//
+// Created by hal9000 on 10/31/23.
+//
+
+#ifndef UNTITLED_FILLREDUCINGORDERING_H
+#define UNTITLED_FILLREDUCINGORDERING_H
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "../../ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrixReordering/SparsityGraph.h"
+
+using namespace std;
+
+namespace LinearAlgebra {
+
+    enum FillReducingOrderingType {
+        NaturalOrdering,
+        ApproximateMinimumDegreeOrdering,
+        NestedDissectionOrdering
+    };
+
+    /**
+    * @brief Symmetric permutations P that reduce the fill of the Cholesky factor of P A P^T.
+    *
+    * An ordering is returned as the vector of the original nodes in elimination order, i.e. ordering[k] is the node
+    * eliminated k-th. Only the pattern of A + A^T, SparsityGraph::symmetric, is used.
+    */
+    class FillReducingOrdering {
+    public:
+        static vector<unsigned> order(const SparsityGraph &graph, FillReducingOrderingType type) {
+            switch (type) {
+                case NaturalOrdering: {
+                    vector<unsigned> ordering(graph.numberOfNodes);
+                    std::iota(ordering.begin(), ordering.end(), 0u);
+                    return ordering;
+                }
+                case ApproximateMinimumDegreeOrdering:
+                    return approximateMinimumDegree(graph);
+                case NestedDissectionOrdering:
+                    return nestedDissection(graph);
+            }
+            throw invalid_argument("Unknown fill reducing ordering.");
+        }
+
+        static string name(FillReducingOrderingType type) {
+            switch (type) {
+                case NaturalOrdering:
+                    return "natural";
+                case ApproximateMinimumDegreeOrdering:
+                    return "AMD";
+                case NestedDissectionOrdering:
+                    return "nested dissection";
+            }
+            throw invalid_argument("Unknown fill reducing ordering.");
+        }
+
+        /**
+        * @brief Approximate minimum degree ordering (Amestoy, Davis, Duff) on the quotient graph of the elimination.
+        *
+        * Every eliminated node becomes an element whose variables are the nodes of its clique in the filled graph, so
+        * the elimination never forms the fill explicitly. The elements adjacent to the pivot are absorbed into the new
+        * element, and so is every element whose variables are all in the new one (aggressive absorption). The degree of
+        * a variable i adjacent to the pivot p is bounded by the AMD approximation
+        * |A_i| + |L_p \ i| + Σ |L_e \ L_p| over the other elements e of i, where |L_e \ L_p| of all the elements is
+        * computed in one pass over the variables of L_p. Indistinguishable variables are not merged into
+        * supervariables, which only costs ordering time on meshes with several degrees of freedom per node.
+        */
+        static vector<unsigned> approximateMinimumDegree(const SparsityGraph &graph) {
+            const unsigned none = numeric_limits<unsigned>::max();
+            unsigned n = graph.numberOfNodes;
+            vector<vector<unsigned>> variables(n), elements(n), elementVariables(n);
+            vector<unsigned> degree(n);
+            vector<char> eliminated(n, 0), absorbed(n, 0);
+            for (unsigned i = 0; i < n; i++) {
+                variables[i].assign(graph.neighbours.begin() + graph.offsets[i],
+                                    graph.neighbours.begin() + graph.offsets[i + 1]);
+                degree[i] = graph.degree(i);
+            }
+
+            //Doubly linked lists of the variables of each degree
+            vector<unsigned> head(n + 1, none), next(n, none), previous(n, none);
+            unsigned minimumDegree = 0;
+            auto insert = [&](unsigned i) {
+                next[i] = head[degree[i]];
+                previous[i] = none;
+                if (head[degree[i]] != none)
+                    previous[head[degree[i]]] = i;
+                head[degree[i]] = i;
+                minimumDegree = std::min(minimumDegree, degree[i]);
+            };
+            auto remove = [&](unsigned i) {
+                if (previous[i] != none)
+                    next[previous[i]] = next[i];
+                else
+                    head[degree[i]] = next[i];
+                if (next[i] != none)
+                    previous[next[i]] = previous[i];
+            };
+            for (unsigned i = 0; i < n; i++)
+                insert(i);
+
+            vector<unsigned> ordering;
+            ordering.reserve(n);
+            vector<unsigned> mark(n, none), weightMark(n, none), weight(n, 0);
+            for (unsigned k = 0; k < n; k++) {
+                while (head[minimumDegree] == none)
+                    minimumDegree++;
+                unsigned pivot = head[minimumDegree];
+                remove(pivot);
+                eliminated[pivot] = 1;
+                ordering.push_back(pivot);
+
+                //L_p: the variables adjacent to the pivot and to the elements it absorbs
+                vector<unsigned> &pivotElement = elementVariables[pivot];
+                pivotElement.clear();
+                mark[pivot] = k;
+                for (unsigned v : variables[pivot])
+                    if (!eliminated[v] && mark[v] != k) {
+                        mark[v] = k;
+                        pivotElement.push_back(v);
+                    }
+                for (unsigned e : elements[pivot]) {
+                    if (absorbed[e])
+                        continue;
+                    for (unsigned v : elementVariables[e])
+                        if (!eliminated[v] && mark[v] != k) {
+                            mark[v] = k;
+                            pivotElement.push_back(v);
+                        }
+                    absorbed[e] = 1;
+                    vector<unsigned>().swap(elementVariables[e]);
+                }
+                vector<unsigned>().swap(variables[pivot]);
+                vector<unsigned>().swap(elements[pivot]);
+                unsigned pivotSize = static_cast<unsigned>(pivotElement.size());
+
+                //|L_e \ L_p| for every element adjacent to L_p
+                for (unsigned i : pivotElement) {
+                    remove(i);
+                    for (unsigned e : elements[i]) {
+                        if (absorbed[e])
+                            continue;
+                        if (weightMark[e] != k) {
+                            weightMark[e] = k;
+                            weight[e] = static_cast<unsigned>(elementVariables[e].size());
+                        }
+                        weight[e]--;
+                    }
+                }
+
+                for (unsigned i : pivotElement) {
+                    unsigned externalDegree = 0, kept = 0;
+                    vector<unsigned> &adjacentElements = elements[i];
+                    for (unsigned e : adjacentElements) {
+                        if (absorbed[e])
+                            continue;
+                        if (weight[e] == 0) {
+                            absorbed[e] = 1;
+                            vector<unsigned>().swap(elementVariables[e]);
+                            continue;
+                        }
+                        adjacentElements[kept++] = e;
+                        externalDegree += weight[e];
+                    }
+                    adjacentElements.resize(kept);
+                    adjacentElements.push_back(pivot);
+                    //The variables of L_p are now reached through the pivot element
+                    vector<unsigned> &adjacentVariables = variables[i];
+                    kept = 0;
+                    for (unsigned v : adjacentVariables)
+                        if (!eliminated[v] && mark[v] != k)
+                            adjacentVariables[kept++] = v;
+                    adjacentVariables.resize(kept);
+                    unsigned approximateDegree = kept + pivotSize - 1 + externalDegree;
+                    degree[i] = std::min(std::min(approximateDegree, degree[i] + pivotSize - 1), n - k - 1);
+                }
+                for (unsigned i : pivotElement)
+                    insert(i);
+            }
+            return ordering;
+        }
+
+        /**
+        * @brief Nested dissection by recursive bisection with level structure vertex separators (George, Liu).
+        *
+        * A breadth first search from a pseudo-peripheral node of each subgraph splits it in levels, and the middle
+        * level, without its nodes that are not adjacent to the next level, is the separator. The two parts are ordered
+        * first and the separator last, so the separators form the upper levels of the elimination tree and the
+        * factorizations of the parts are independent. Disconnected subgraphs are split in their components, and
+        * subgraphs with at most leafSize nodes or without a separator are ordered with approximate minimum degree.
+        * For the d-dimensional grids of finite difference stencils the fill is O(n log n) in 2D and O(n^4/3) in 3D.
+        */
+        static vector<unsigned> nestedDissection(const SparsityGraph &graph, unsigned leafSize = 64) {
+            const unsigned none = numeric_limits<unsigned>::max();
+            unsigned n = graph.numberOfNodes;
+            vector<unsigned> ordering(n);
+            //The subgraph of each node, none for the separator nodes that are already ordered
+            vector<unsigned> subgraphOf(n, 0);
+            vector<unsigned> visited(n, none), levelOf(n, 0), localIndex(n, none);
+            unsigned search = 0, numberOfSubgraphs = 1;
+
+            //Nodes of a subgraph and the position of its first node in the ordering
+            struct Subgraph {
+                vector<unsigned> nodes;
+                unsigned first;
+            };
+            vector<Subgraph> subgraphs;
+            subgraphs.push_back({vector<unsigned>(n), 0});
+            std::iota(subgraphs.back().nodes.begin(), subgraphs.back().nodes.end(), 0u);
+
+            //Breadth first search inside subgraph id. Returns the nodes in visiting order and the level offsets.
+            auto levelStructure = [&](unsigned root, unsigned id, vector<unsigned> &levelOffsets) {
+                vector<unsigned> queue = {root};
+                visited[root] = ++search;
+                levelOf[root] = 0;
+                for (unsigned head = 0; head < queue.size(); head++) {
+                    unsigned node = queue[head];
+                    for (unsigned k = graph.offsets[node]; k < graph.offsets[node + 1]; k++) {
+                        unsigned neighbour = graph.neighbours[k];
+                        if (subgraphOf[neighbour] == id && visited[neighbour] != search) {
+                            visited[neighbour] = search;
+                            levelOf[neighbour] = levelOf[node] + 1;
+                            queue.push_back(neighbour);
+                        }
+                    }
+                }
+                levelOffsets.assign(1, 0);
+                for (unsigned k = 1; k < queue.size(); k++)
+                    if (levelOf[queue[k]] != levelOf[queue[k - 1]])
+                        levelOffsets.push_back(k);
+                levelOffsets.push_back(static_cast<unsigned>(queue.size()));
+                return queue;
+            };
+
+            while (!subgraphs.empty()) {
+                Subgraph subgraph = std::move(subgraphs.back());
+                subgraphs.pop_back();
+                unsigned size = static_cast<unsigned>(subgraph.nodes.size());
+                if (size == 0)
+                    continue;
+                unsigned id = subgraphOf[subgraph.nodes[0]];
+                vector<unsigned> levelOffsets;
+                vector<unsigned> reached;
+                if (size > leafSize) {
+                    //Pseudo-peripheral root: restart from a minimum degree node of the last level while the
+                    //eccentricity grows
+                    unsigned root = subgraph.nodes[0];
+                    reached = levelStructure(root, id, levelOffsets);
+                    unsigned rootDepth = static_cast<unsigned>(levelOffsets.size());
+                    for (unsigned pass = 0; pass < 4 && reached.size() == size; pass++) {
+                        unsigned candidate = reached[levelOffsets[levelOffsets.size() - 2]];
+                        for (unsigned k = levelOffsets[levelOffsets.size() - 2]; k < size; k++)
+                            if (graph.degree(reached[k]) < graph.degree(candidate))
+                                candidate = reached[k];
+                        reached = levelStructure(candidate, id, levelOffsets);
+                        if (levelOffsets.size() <= rootDepth)
+                            break;
+                        root = candidate;
+                        rootDepth = static_cast<unsigned>(levelOffsets.size());
+                    }
+                    //The level structure of the root, which the last candidate may have overwritten
+                    reached = levelStructure(root, id, levelOffsets);
+                    if (reached.size() < size) {
+                        //Disconnected: the reached component and the rest are ordered independently
+                        vector<unsigned> rest;
+                        rest.reserve(size - reached.size());
+                        for (unsigned node : subgraph.nodes)
+                            if (visited[node] != search)
+                                rest.push_back(node);
+                        unsigned componentId = numberOfSubgraphs++, restId = numberOfSubgraphs++;
+                        for (unsigned node : reached)
+                            subgraphOf[node] = componentId;
+                        for (unsigned node : rest)
+                            subgraphOf[node] = restId;
+                        unsigned restFirst = subgraph.first + static_cast<unsigned>(reached.size());
+                        subgraphs.push_back({std::move(reached), subgraph.first});
+                        subgraphs.push_back({std::move(rest), restFirst});
+                        continue;
+                    }
+                }
+
+                unsigned depth = levelOffsets.empty() ? 0 : static_cast<unsigned>(levelOffsets.size()) - 1;
+                if (size <= leafSize || depth < 3) {
+                    _orderLeaf(graph, subgraph.nodes, subgraphOf, id, localIndex, ordering, subgraph.first);
+                    continue;
+                }
+
+                //Middle level as separator, without the nodes that do not touch the level after it
+                unsigned middle = 1;
+                while (middle + 2 < depth && levelOffsets[middle + 1] <= size / 2)
+                    middle++;
+                vector<unsigned> lower, upper, separator;
+                for (unsigned k = 0; k < levelOffsets[middle]; k++)
+                    lower.push_back(reached[k]);
+                for (unsigned k = levelOffsets[middle]; k < levelOffsets[middle + 1]; k++) {
+                    unsigned node = reached[k];
+                    bool touchesUpper = false;
+                    for (unsigned j = graph.offsets[node]; j < graph.offsets[node + 1] && !touchesUpper; j++) {
+                        unsigned neighbour = graph.neighbours[j];
+                        touchesUpper = subgraphOf[neighbour] == id && levelOf[neighbour] == middle + 1;
+                    }
+                    if (touchesUpper)
+                        separator.push_back(node);
+                    else
+                        lower.push_back(node);
+                }
+                for (unsigned k = levelOffsets[middle + 1]; k < size; k++)
+                    upper.push_back(reached[k]);
+
+                unsigned lowerId = numberOfSubgraphs++, upperId = numberOfSubgraphs++;
+                for (unsigned node : lower)
+                    subgraphOf[node] = lowerId;
+                for (unsigned node : upper)
+                    subgraphOf[node] = upperId;
+                unsigned separatorFirst = subgraph.first + static_cast<unsigned>(lower.size() + upper.size());
+                for (unsigned k = 0; k < separator.size(); k++) {
+                    subgraphOf[separator[k]] = none;
+                    ordering[separatorFirst + k] = separator[k];
+                }
+                unsigned upperFirst = subgraph.first + static_cast<unsigned>(lower.size());
+                subgraphs.push_back({std::move(lower), subgraph.first});
+                subgraphs.push_back({std::move(upper), upperFirst});
+            }
+            return ordering;
+        }
+
+        /**
+        * @brief Returns true if ordering contains every node of [0, numberOfNodes) exactly once.
+        */
+        static bool isPermutation(const vector<unsigned> &ordering, unsigned numberOfNodes) {
+            if (ordering.size() != numberOfNodes)
+                return false;
+            vector<char> seen(numberOfNodes, 0);
+            for (unsigned node : ordering) {
+                if (node >= numberOfNodes || seen[node])
+                    return false;
+                seen[node] = 1;
+            }
+            return true;
+        }
+
+    private:
+        /**
+        * @brief Orders the subgraph id with approximate minimum degree on its induced graph and writes it at
+        * ordering[first, first + nodes.size()).
+        */
+        static void _orderLeaf(const SparsityGraph &graph, const vector<unsigned> &nodes,
+                               const vector<unsigned> &subgraphOf, unsigned id, vector<unsigned> &localIndex,
+                               vector<unsigned> &ordering, unsigned first) {
+            SparsityGraph leaf;
+            leaf.numberOfNodes = static_cast<unsigned>(nodes.size());
+            for (unsigned k = 0; k < nodes.size(); k++)
+                localIndex[nodes[k]] = k;
+            leaf.offsets.assign(nodes.size() + 1, 0);
+            for (unsigned k = 0; k < nodes.size(); k++) {
+                for (unsigned j = graph.offsets[nodes[k]]; j < graph.offsets[nodes[k] + 1]; j++)
+                    if (subgraphOf[graph.neighbours[j]] == id)
+                        leaf.neighbours.push_back(localIndex[graph.neighbours[j]]);
+                leaf.offsets[k + 1] = static_cast<unsigned>(leaf.neighbours.size());
+            }
+            auto leafOrdering = approximateMinimumDegree(leaf);
+            for (unsigned k = 0; k < nodes.size(); k++)
+                ordering[first + k] = nodes[leafOrdering[k]];
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_FILLREDUCINGORDERING_H
@@ -0,0 +1,260 @@
+//
+// Created by hal9000 on 11/7/23.
+//
+
+#ifndef UNTITLED_MIXEDPRECISIONLU_H
+#define UNTITLED_MIXEDPRECISIONLU_H
+
+#include <limits>
+#include <sstream>
+#include "../../Array/DecompositionMethods/BlockedLU.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Dense LU solver that factorizes in a low precision (float) and recovers double accuracy by iterative
+    * refinement with double precision residuals.
+    *
+    * The factors take half the memory of the double factors and the factorization runs about twice as fast, its
+    * register blocks hold twice the elements. Every solve computes x = (LU)^-1 b in low precision and then refines
+    * x = x + (LU)^-1 (b - A x) with the residual in double until the normwise backward error
+    * ||b - A x||∞ / (||A||∞ ||x||∞ + ||b||∞) is below √n ε(double). The refinement contracts by about
+    * κ(A) ε(float) per step, so it needs a few steps up to κ ~ 10⁶ and stalls beyond.
+    *
+    * The solver falls back to a double factorization, once and for all the later solves, if the low precision
+    * factorization breaks down (a pivot below the tolerance, entries out of the float range) or if a refinement step
+    * does not reduce the residual by the stall ratio.
+    *
+    * The matrix is not modified and must stay unchanged between factorize() and the solves, its residuals are
+    * computed in double.
+    *
+    * @tparam Low The datatype of the factors.
+    */
+    template<typename Low = float>
+    class MixedPrecisionLU {
+    public:
+        /**
+        * @param maxRefinements Refinement steps before the fallback.
+        * @param stallRatio A step that reduces ||b - A x||∞ by less than this factor triggers the fallback.
+        * @param pivotTolerance A pivot with absolute value below the tolerance is a breakdown of the factorization.
+        */
+        explicit MixedPrecisionLU(unsigned availableThreads = 1, unsigned maxRefinements = 30, double stallRatio = 0.5,
+                                  double pivotTolerance = 0) :
+                _availableThreads(std::max(1u, availableThreads)), _maxRefinements(maxRefinements),
+                _stallRatio(stallRatio), _pivotTolerance(pivotTolerance) { }
+
+        /**
+        * @brief Factorizes the n x n row major matrix a with leading dimension lda in low precision, or in double if
+        * the low precision factorization breaks down.
+        * @throws runtime_error If the double factorization breaks down too.
+        */
+        void factorize(const double* a, unsigned n, unsigned lda) {
+            _matrix = a;
+            _n = n;
+            _lda = lda;
+            _fallback = false;
+            _fallbackReason.clear();
+            _doubleFactors.clear();
+            _refinementSteps = 0;
+            _backwardError = 0;
+            _matrixNorm = 0;
+            double largest = 0;
+            for (unsigned i = 0; i < n; i++) {
+                double rowSum = 0;
+                for (unsigned j = 0; j < n; j++) {
+                    double value = std::abs(a[static_cast<size_t>(i) * lda + j]);
+                    rowSum += value;
+                    largest = std::max(largest, value);
+                }
+                _matrixNorm = std::max(_matrixNorm, rowSum);
+            }
+            if (!(largest <= static_cast<double>(std::numeric_limits<Low>::max()))) {
+                _fallBack("the matrix entries exceed the range of the low precision");
+                return;
+            }
+            _lowFactors.resize(static_cast<size_t>(n) * n);
+            for (unsigned i = 0; i < n; i++)
+                for (unsigned j = 0; j < n; j++)
+                    _lowFactors[static_cast<size_t>(i) * n + j] = static_cast<Low>(a[static_cast<size_t>(i) * lda + j]);
+            unsigned numberOfSwaps;
+            unsigned failedColumn = BlockedLU<Low>::factorize(_lowFactors.data(), n, n, _permutation, numberOfSwaps,
+                                                              _pivotTolerance, _availableThreads);
+            if (failedColumn != n)
+                _fallBack("zero pivot of the low precision factorization at column " + to_string(failedColumn));
+        }
+
+        /**
+        * @brief Solves A x = rhs. rhs and x must not alias.
+        */
+        void solve(const double* rhs, double* x) {
+            if (_matrix == nullptr)
+                throw runtime_error("The matrix is not factorized.");
+            _refinementSteps = 0;
+            if (_fallback) {
+                BlockedLU<double>::solve(_doubleFactors.data(), _n, _n, _permutation, rhs, x);
+                _backwardError = _normwiseBackwardError(rhs, x, _residual(rhs, x, _correction));
+                return;
+            }
+            vector<Low> lowRhs(_n), lowCorrection(_n);
+            _correction.resize(_n);
+            for (unsigned i = 0; i < _n; i++)
+                lowRhs[i] = static_cast<Low>(rhs[i]);
+            BlockedLU<Low>::solve(_lowFactors.data(), _n, _n, _permutation, lowRhs.data(), lowCorrection.data());
+            for (unsigned i = 0; i < _n; i++)
+                x[i] = lowCorrection[i];
+            double tolerance = std::sqrt(static_cast<double>(_n)) * std::numeric_limits<double>::epsilon();
+            double previousNorm = std::numeric_limits<double>::infinity();
+            while (true) {
+                double residualNorm = _residual(rhs, x, _correction);
+                _backwardError = _normwiseBackwardError(rhs, x, residualNorm);
+                if (_backwardError <= tolerance)
+                    return;
+                if (!(residualNorm < _stallRatio * previousNorm) || _refinementSteps >= _maxRefinements) {
+                    ostringstream reason;
+                    reason << "the refinement stalled at the backward error " << _backwardError << " after "
+                           << _refinementSteps << " steps";
+                    _fallBack(reason.str());
+                    solve(rhs, x);
+                    return;
+                }
+                previousNorm = residualNorm;
+                //d = (LU)^-1 r with r scaled to unit size, so that small residuals do not underflow in low precision
+                for (unsigned i = 0; i < _n; i++)
+                    lowRhs[i] = static_cast<Low>(_correction[i] / residualNorm);
+                BlockedLU<Low>::solve(_lowFactors.data(), _n, _n, _permutation, lowRhs.data(), lowCorrection.data());
+                for (unsigned i = 0; i < _n; i++)
+                    x[i] += residualNorm * static_cast<double>(lowCorrection[i]);
+                _refinementSteps++;
+            }
+        }
+
+        /**
+        * @brief true if the solver uses the double factorization.
+        */
+        bool usesFallback() const {
+            return _fallback;
+        }
+
+        const string &getFallbackReason() const {
+            return _fallbackReason;
+        }
+
+        unsigned getAvailableThreads() const {
+            return _availableThreads;
+        }
+
+        /**
+        * @brief The refinement steps of the last solve, 0 for the fallback.
+        */
+        unsigned getRefinementSteps() const {
+            return _refinementSteps;
+        }
+
+        /**
+        * @brief The normwise backward error ||b - A x||∞ / (||A||∞ ||x||∞ + ||b||∞) of the last solve.
+        */
+        double getBackwardError() const {
+            return _backwardError;
+        }
+
+    private:
+        unsigned _availableThreads;
+
+        unsigned _maxRefinements;
+
+        double _stallRatio;
+
+        double _pivotTolerance;
+
+        const double* _matrix = nullptr;
+
+        unsigned _n = 0;
+
+        unsigned _lda = 0;
+
+        double _matrixNorm = 0;
+
+        vector<Low> _lowFactors;
+
+        vector<double> _doubleFactors;
+
+        vector<unsigned> _permutation;
+
+        vector<double> _correction;
+
+        bool _fallback = false;
+
+        string _fallbackReason;
+
+        unsigned _refinementSteps = 0;
+
+        double _backwardError = 0;
+
+        /**
+        * @brief Replaces the low precision factors with the double factorization of the matrix.
+        * @throws runtime_error If the double factorization breaks down.
+        */
+        void _fallBack(const string &reason) {
+            _fallback = true;
+            _fallbackReason = reason;
+            vector<Low>().swap(_lowFactors);
+            _doubleFactors.resize(static_cast<size_t>(_n) * _n);
+            for (unsigned i = 0; i < _n; i++)
+                std::copy(_matrix + static_cast<size_t>(i) * _lda, _matrix + static_cast<size_t>(i) * _lda + _n,
+                          _doubleFactors.begin() + static_cast<size_t>(i) * _n);
+            unsigned numberOfSwaps;
+            unsigned failedColumn = BlockedLU<double>::factorize(_doubleFactors.data(), _n, _n, _permutation, numberOfSwaps,
+                                                                 _pivotTolerance, _availableThreads);
+            if (failedColumn != _n)
+                throw runtime_error("Mixed precision LU: the matrix is singular. Zero pivot at column " +
+                                    to_string(failedColumn) + ".");
+        }
+
+        /**
+        * @brief ||r||∞ / (||A||∞ ||x||∞ + ||b||∞).
+        */
+        double _normwiseBackwardError(const double* rhs, const double* x, double residualNorm) const {
+            double rhsNorm = 0, solutionNorm = 0;
+            for (unsigned i = 0; i < _n; i++) {
+                rhsNorm = std::max(rhsNorm, std::abs(rhs[i]));
+                solutionNorm = std::max(solutionNorm, std::abs(x[i]));
+            }
+            double scale = _matrixNorm * solutionNorm + rhsNorm;
+            return scale > 0 ? residualNorm / scale : 0;
+        }
+
+        /**
+        * @brief r = b - A x in double, the rows split among the threads.
+        * @return ||r||∞.
+        */
+        double _residual(const double* rhs, const double* x, vector<double> &r) {
+            r.resize(_n);
+            const double* a = _matrix;
+            double* residual = r.data();
+            unsigned n = _n, lda = _lda;
+            ThreadingOperations<double>::executeParallelJob([=](unsigned start, unsigned end) {
+                for (unsigned i = start; i < end; i++) {
+                    const double* row = a + static_cast<size_t>(i) * lda;
+                    double sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+                    unsigned j = 0;
+                    for (; j + 4 <= n; j += 4) {
+                        sum0 += row[j] * x[j];
+                        sum1 += row[j + 1] * x[j + 1];
+                        sum2 += row[j + 2] * x[j + 2];
+                        sum3 += row[j + 3] * x[j + 3];
+                    }
+                    for (; j < n; j++)
+                        sum0 += row[j] * x[j];
+                    residual[i] = rhs[i] - ((sum0 + sum1) + (sum2 + sum3));
+                }
+            }, n, _availableThreads);
+            double norm = 0;
+            for (unsigned i = 0; i < n; i++)
+                norm = std::max(norm, std::abs(residual[i]));
+            return norm;
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_MIXEDPRECISIONLU_H
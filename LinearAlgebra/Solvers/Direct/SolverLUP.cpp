@@ -10,13 +10,19 @@ namespace LinearAlgebra {
                 DirectSolver(storeDecompositionOnMatrix),
                 _decomposition(nullptr),
                 _pivotTolerance(pivotTolerance),
-                _throwExceptionOnSingularMatrix(true){}
+                _throwExceptionOnSingularMatrix(true),
+                _mixedPrecision(false),
+                _maxRefinements(30),
+                _availableThreads(1){}
     
     SolverLUP::SolverLUP(double pivotTolerance, bool storeDecompositionOnMatrix, bool throwExceptionOnSingularMatrix) :
                 DirectSolver(storeDecompositionOnMatrix),
                 _decomposition(nullptr),
                 _pivotTolerance(pivotTolerance),
-                _throwExceptionOnSingularMatrix(throwExceptionOnSingularMatrix){}
+                _throwExceptionOnSingularMatrix(throwExceptionOnSingularMatrix),
+                _mixedPrecision(false),
+                _maxRefinements(30),
+                _availableThreads(1){}
                 
     SolverLUP::~SolverLUP() {
         delete _decomposition;
@@ -27,7 +33,27 @@ namespace LinearAlgebra {
         return shared_ptr<MatrixDecomposition>(_decomposition);
     }
     
+    void SolverLUP::setMixedPrecision(bool mixedPrecision, unsigned maxRefinements) {
+        _mixedPrecision = mixedPrecision;
+        _maxRefinements = maxRefinements;
+    }
+
+    const shared_ptr<MixedPrecisionLU<float>> &SolverLUP::getMixedPrecisionSolver() const {
+        return _mixedPrecisionSolver;
+    }
+    
+    void SolverLUP::setAvailableThreads(unsigned availableThreads) {
+        _availableThreads = std::max(1u, availableThreads);
+    }
+    
     void SolverLUP::solve() {
+        if (_mixedPrecision) {
+            auto &matrix = _linearSystem->matrix;
+            _mixedPrecisionSolver = make_shared<MixedPrecisionLU<float>>(_availableThreads, _maxRefinements, 0.5, _pivotTolerance);
+            _mixedPrecisionSolver->factorize(matrix->getArrayPointer(), matrix->numberOfRows(), matrix->numberOfColumns());
+            _mixedPrecisionSolver->solve(_linearSystem->rhs->data(), _linearSystem->solution->data());
+            return;
+        }
         _decomposition = new DecompositionLUP(_linearSystem->matrix, _pivotTolerance, _throwExceptionOnSingularMatrix);
         if (_storeDecompositionOnMatrix) {
             cout<<"Decomposition Initiated..."<<endl;
@@ -7,6 +7,7 @@
 
 #include "DirectSolver.h"
 #include "../../Array/DecompositionMethods/DecompositionLUP.h"
+#include "MixedPrecisionLU.h"
 
 namespace LinearAlgebra {
 
@@ -24,6 +25,23 @@ namespace LinearAlgebra {
         
         void solve() override;
         
+        /**
+        * @brief Factorizes in float and refines the solution to double accuracy with double residuals, falling back
+        * to the double factorization if the refinement stalls (see MixedPrecisionLU). The matrix is kept for the
+        * residuals, so it is never overwritten and storeDecompositionOnMatrix is ignored.
+        */
+        void setMixedPrecision(bool mixedPrecision, unsigned maxRefinements = 30);
+        
+        /**
+        * @brief The mixed precision solver of the last solve(), nullptr without mixed precision.
+        */
+        const shared_ptr<MixedPrecisionLU<float>>& getMixedPrecisionSolver() const;
+        
+        /**
+        * @brief The threads of the mixed precision factorizations and residuals. The double path is serial.
+        */
+        void setAvailableThreads(unsigned availableThreads);
+        
     private:
         
         DecompositionLUP* _decomposition;
@@ -31,6 +49,14 @@ namespace LinearAlgebra {
         double _pivotTolerance;
         
         bool _throwExceptionOnSingularMatrix;
+        
+        bool _mixedPrecision;
+        
+        unsigned _maxRefinements;
+        
+        unsigned _availableThreads;
+        
+        shared_ptr<MixedPrecisionLU<float>> _mixedPrecisionSolver;
 
     };
 
@@ -0,0 +1,708 @@
+//
+// Created by hal9000 on 10/31/23.
+//
+
+#ifndef UNTITLED_SUPERNODALCHOLESKY_H
+#define UNTITLED_SUPERNODALCHOLESKY_H
+
+#include <atomic>
+#include "../Preconditioners/Preconditioner.h"
+#include "FillReducingOrdering.h"
+#include "DenseBlockKernels.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Sparse direct solver for symmetric positive definite CSR matrices: P A P^T = L L^T with a fill reducing
+    * permutation P and a supernodal multifrontal numeric factorization.
+    *
+    * analyze() works on the pattern only:
+    * 1. Fill reducing ordering (nested dissection or approximate minimum degree) of the graph of A + A^T.
+    * 2. Elimination tree of P A P^T (Liu) and its postorder, appended to the ordering so that the columns of every
+    *    subtree are contiguous.
+    * 3. Column counts of L from the row subtrees, and fundamental supernodes: chains of columns j, j + 1 where j + 1 is
+    *    the only child of j and the pattern of column j is the pattern of j + 1 plus j. The columns of a supernode
+    *    share one row pattern and are stored as a dense column major panel.
+    * 4. Relaxed amalgamation: a supernode absorbs its child that ends right before it in the postorder when the union
+    *    of their patterns adds at most relaxedZeros explicit zeros to the panels. Fewer and wider supernodes give the
+    *    dense kernels larger blocks and the assembly tree fewer levels to synchronize.
+    * 5. The assembly tree of the supernodes, its levels (leaves first) and the scatter maps of A and of the update
+    *    matrices of the children into their parents.
+    * analyzeOrdering() runs only steps 1 to 3 without the supernodes, enough for the flops and the non-zeros of L, so
+    * that the cost of a factorization can be estimated before paying for its patterns and maps.
+    *
+    * factorize() computes the panels supernode by supernode: the elements of A and the update matrices of the children
+    * are added into the panel (extend-add), the diagonal block is factorized (POTRF), the rows below it are solved
+    * (TRSM) and the Schur complement of the remaining rows (SYRK) becomes the update matrix passed to the parent.
+    * The supernodes of a level of the assembly tree are independent: the levels near the leaves have many small
+    * supernodes that the threads take one at a time, the few large separators near the root are factorized one after
+    * the other with all the threads inside the dense kernels. factorize() can be called again for a matrix with the
+    * same pattern and new values, and only the elements in the lower triangle of P A P^T are read, so the matrix must
+    * be numerically symmetric.
+    *
+    * The forward and backward solves traverse the supernodes with dense triangular solves and products on the
+    * right-hand sides of a panel, so several right-hand sides are solved with BLAS-3 kernels. Blocks of right-hand
+    * sides are distributed among the threads. As a preconditioner it applies the exact inverse, so a Krylov solver
+    * converges in one iteration; it is meant for SPD systems up to about 10^5 unknowns solved with many right-hand sides.
+    *
+    * @throws runtime_error If the matrix is not positive definite.
+    * @tparam T The datatype of the matrix and vector elements.
+    */
+    template<typename T>
+    class SupernodalCholesky : public Preconditioner<T> {
+    public:
+        /**
+        * @param ordering The fill reducing ordering.
+        * @param relaxedZeros The explicit zeros one amalgamation may add to the panels, 0 for fundamental supernodes.
+        */
+        explicit SupernodalCholesky(FillReducingOrderingType ordering = NestedDissectionOrdering, unsigned relaxedZeros = 64) :
+                _ordering(ordering), _relaxedZeros(relaxedZeros) {
+            this->_name = "Supernodal Cholesky (" + FillReducingOrdering::name(ordering) + ")";
+        }
+
+        /**
+        * @brief Symbolic analysis followed by the numeric factorization.
+        */
+        void setup(const shared_ptr<NumericalMatrix<T>> &matrix) override {
+            analyze(matrix);
+            factorize(matrix);
+        }
+
+        /**
+        * @brief Ordering, elimination tree and column counts of the pattern of the matrix. Sets getFactorizationFlops()
+        * and numberOfFactorNonZeros(); analyze() reuses them for the same pattern.
+        */
+        void analyzeOrdering(const shared_ptr<NumericalMatrix<T>> &matrix) {
+            auto csr = this->_csrArrays(matrix);
+            unsigned n = csr.numberOfRows;
+            this->_isSetUp = false;
+            _isAnalyzed = false;
+            this->_numberOfRows = n;
+            this->_availableThreads = matrix->dataStorage->getAvailableThreads();
+            auto graph = SparsityGraph::symmetric(csr.rowOffsets, csr.columnIndices, n);
+            _permutation = FillReducingOrdering::order(graph, _ordering);
+
+            //Postorder of the elimination tree appended to the ordering
+            vector<unsigned> inverse(n);
+            for (unsigned k = 0; k < n; k++)
+                inverse[_permutation[k]] = k;
+            auto parent = _eliminationTree(graph, inverse);
+            auto postorder = _postorder(parent);
+            vector<unsigned> permutation(n);
+            for (unsigned k = 0; k < n; k++)
+                permutation[k] = _permutation[postorder[k]];
+            _permutation = std::move(permutation);
+            for (unsigned k = 0; k < n; k++)
+                inverse[_permutation[k]] = k;
+            _parent = _eliminationTree(graph, inverse);
+
+            _columnCounts = _countColumns(graph, inverse, _parent);
+            _factorizationFlops = 0;
+            _factorNonZeros = 0;
+            for (unsigned j = 0; j < n; j++) {
+                _factorizationFlops += static_cast<double>(_columnCounts[j]) * _columnCounts[j];
+                _factorNonZeros += _columnCounts[j];
+            }
+            _analyzedRowOffsets.assign(csr.rowOffsets, csr.rowOffsets + n + 1);
+            _analyzedColumnIndices.assign(csr.columnIndices, csr.columnIndices + csr.rowOffsets[n]);
+            _isOrdered = true;
+        }
+
+        /**
+        * @brief Ordering, elimination tree, supernodes and scatter maps of the pattern of the matrix.
+        */
+        void analyze(const shared_ptr<NumericalMatrix<T>> &matrix) {
+            auto csr = this->_csrArrays(matrix);
+            if (!_isOrdered || !_hasAnalyzedPattern(csr))
+                analyzeOrdering(matrix);
+            unsigned n = csr.numberOfRows;
+            this->_isSetUp = false;
+            this->_availableThreads = matrix->dataStorage->getAvailableThreads();
+            auto graph = SparsityGraph::symmetric(csr.rowOffsets, csr.columnIndices, n);
+            vector<unsigned> inverse(n);
+            for (unsigned k = 0; k < n; k++)
+                inverse[_permutation[k]] = k;
+            _buildSupernodes(_parent, _columnCounts);
+            _buildSupernodePatterns(graph, inverse);
+            _buildAssemblyMaps(csr, inverse);
+            _buildLevels();
+            _isAnalyzed = true;
+        }
+
+        /**
+        * @brief Numeric factorization of a matrix with the pattern given to analyze().
+        * @throws invalid_argument If the row offsets or the column indices differ from those of analyze().
+        */
+        void factorize(const shared_ptr<NumericalMatrix<T>> &matrix) {
+            auto csr = this->_csrArrays(matrix);
+            if (!_isAnalyzed || !_hasAnalyzedPattern(csr))
+                throw invalid_argument("The pattern of the matrix differs from the analyzed one. Call analyze() first.");
+            unsigned numberOfNonZeros = _analyzedRowOffsets.back();
+            this->_isSetUp = false;
+            this->_availableThreads = matrix->dataStorage->getAvailableThreads();
+            unsigned threads = this->_availableThreads;
+            _values.assign(_valueOffsets.back(), 0);
+            for (unsigned k = 0; k < numberOfNonZeros; k++)
+                if (_assemblyTargets[k] != _notAssembled)
+                    _values[_assemblyTargets[k]] += csr.values[k];
+            _updates.assign(numberOfSupernodes(), vector<T>());
+
+            atomic<bool> positiveDefinite(true);
+            for (unsigned level = 0; level + 1 < _levelOffsets.size(); level++) {
+                unsigned first = _levelOffsets[level];
+                unsigned levelSize = _levelOffsets[level + 1] - first;
+                if (threads > 1 && levelSize >= threads) {
+                    //The supernodes are sorted by decreasing cost and taken by the first free thread
+                    atomic<unsigned> next(first);
+                    auto workerJob = [&](unsigned, unsigned) {
+                        for (unsigned p = next++; p < first + levelSize && positiveDefinite; p = next++)
+                            if (!_factorizeSupernode(_levelSupernodes[p], 1))
+                                positiveDefinite = false;
+                    };
+                    ThreadingOperations<T>::executeParallelJob(workerJob, threads, threads, sizeof(T));
+                }
+                else {
+                    for (unsigned p = first; p < first + levelSize && positiveDefinite; p++)
+                        if (!_factorizeSupernode(_levelSupernodes[p], threads))
+                            positiveDefinite = false;
+                }
+                if (!positiveDefinite) {
+                    _updates.clear();
+                    throw runtime_error("Supernodal Cholesky: the matrix is not positive definite.");
+                }
+            }
+            _updates.clear();
+            this->_markSetUp();
+        }
+
+        void apply(NumericalVector<T> &r, NumericalVector<T> &z) override {
+            this->_checkApply(r, z);
+            vector<const T*> rhs = {r.getDataPointer()};
+            vector<T*> solutions = {z.getDataPointer()};
+            _solve(rhs, solutions);
+        }
+
+        /**
+        * @brief Solves A x = rhs. rhs and solution may alias.
+        */
+        void solve(NumericalVector<T> &rhs, NumericalVector<T> &solution) {
+            this->_checkApply(rhs, solution);
+            vector<const T*> rhsPointers = {rhs.getDataPointer()};
+            vector<T*> solutionPointers = {solution.getDataPointer()};
+            _solve(rhsPointers, solutionPointers);
+        }
+
+        /**
+        * @brief Solves A X = B for the columns of B at once.
+        */
+        void solve(const vector<shared_ptr<NumericalVector<T>>> &rhs, const vector<shared_ptr<NumericalVector<T>>> &solutions) {
+            if (rhs.size() != solutions.size())
+                throw invalid_argument("The number of right-hand sides and solutions differ.");
+            vector<const T*> rhsPointers;
+            vector<T*> solutionPointers;
+            for (unsigned column = 0; column < rhs.size(); column++) {
+                this->_checkApply(*rhs[column], *solutions[column]);
+                rhsPointers.push_back(rhs[column]->getDataPointer());
+                solutionPointers.push_back(solutions[column]->getDataPointer());
+            }
+            _solve(rhsPointers, solutionPointers);
+        }
+
+        /**
+        * @brief Returns the ordering of the factorization: permutation[k] is the row of A eliminated k-th.
+        */
+        const vector<unsigned> &getPermutation() const {
+            return _permutation;
+        }
+
+        /**
+        * @brief Returns the number of elements of L, diagonal included.
+        */
+        size_t numberOfFactorNonZeros() const {
+            return _factorNonZeros;
+        }
+
+        /**
+        * @brief Returns Σ |L_j|², the order of the floating point operations of the numeric factorization.
+        */
+        double getFactorizationFlops() const {
+            return _factorizationFlops;
+        }
+
+        unsigned numberOfSupernodes() const {
+            return _supernodeColumns.empty() ? 0 : static_cast<unsigned>(_supernodeColumns.size()) - 1;
+        }
+
+        /**
+        * @brief Returns the mean number of columns of a supernode.
+        */
+        double getMeanSupernodeWidth() const {
+            return numberOfSupernodes() > 0 ? static_cast<double>(this->_numberOfRows) / numberOfSupernodes() : 0;
+        }
+
+        /**
+        * @brief Returns the explicit zeros the amalgamated supernodes store in the lower trapezoids of their panels.
+        */
+        size_t numberOfAmalgamationZeros() const {
+            size_t stored = 0;
+            for (unsigned s = 0; s < numberOfSupernodes(); s++) {
+                size_t rows = _rowOffsets[s + 1] - _rowOffsets[s], columns = _supernodeColumns[s + 1] - _supernodeColumns[s];
+                stored += rows * columns - columns * (columns - 1) / 2;
+            }
+            return stored - _factorNonZeros;
+        }
+
+        unsigned numberOfTreeLevels() const {
+            return _levelOffsets.empty() ? 0 : static_cast<unsigned>(_levelOffsets.size()) - 1;
+        }
+
+    private:
+        FillReducingOrderingType _ordering;
+
+        unsigned _relaxedZeros;
+
+        bool _isOrdered = false;
+
+        bool _isAnalyzed = false;
+
+        //The pattern of analyze(), the assembly maps index its non-zeros
+        vector<unsigned> _analyzedRowOffsets;
+
+        vector<unsigned> _analyzedColumnIndices;
+
+        double _factorizationFlops = 0;
+
+        size_t _factorNonZeros = 0;
+
+        vector<unsigned> _permutation;
+
+        //Elimination tree and column counts of L in the elimination order, from analyzeOrdering()
+        vector<unsigned> _parent;
+
+        vector<unsigned> _columnCounts;
+
+        //First column of each supernode, numberOfSupernodes + 1 entries
+        vector<unsigned> _supernodeColumns;
+
+        vector<unsigned> _supernodeParent;
+
+        //Sorted rows of each supernode, its columns first, numberOfSupernodes + 1 offsets
+        vector<unsigned> _rowOffsets;
+
+        vector<unsigned> _rows;
+
+        //Start of the column major panel of each supernode in _values, with leading dimension its number of rows
+        vector<size_t> _valueOffsets;
+
+        vector<T> _values;
+
+        //Children of each supernode in the assembly tree
+        vector<unsigned> _childOffsets;
+
+        vector<unsigned> _children;
+
+        //Position in the rows of the parent of every row of a supernode below its columns
+        vector<unsigned> _parentPositionOffsets;
+
+        vector<unsigned> _parentPositions;
+
+        //Position in _values of every CSR element of A, _notAssembled for the upper triangle of P A P^T
+        vector<size_t> _assemblyTargets;
+
+        //Supernodes sorted by level of the assembly tree and by decreasing cost within a level
+        vector<unsigned> _levelSupernodes;
+
+        vector<unsigned> _levelOffsets;
+
+        //Update matrices of the supernodes, alive until the parent is assembled
+        vector<vector<T>> _updates;
+
+        static constexpr size_t _notAssembled = numeric_limits<size_t>::max();
+
+        bool _hasAnalyzedPattern(const typename Preconditioner<T>::CSRArrays &csr) const {
+            return csr.numberOfRows == this->_numberOfRows &&
+                   std::equal(_analyzedRowOffsets.begin(), _analyzedRowOffsets.end(), csr.rowOffsets) &&
+                   std::equal(_analyzedColumnIndices.begin(), _analyzedColumnIndices.end(), csr.columnIndices);
+        }
+
+        /**
+        * @brief Elimination tree of P A P^T with path compression. parent[j] is n for the roots.
+        */
+        static vector<unsigned> _eliminationTree(const SparsityGraph &graph, const vector<unsigned> &inverse) {
+            unsigned n = graph.numberOfNodes;
+            vector<unsigned> parent(n, n), ancestor(n, n);
+            vector<unsigned> permutation(n);
+            for (unsigned node = 0; node < n; node++)
+                permutation[inverse[node]] = node;
+            for (unsigned i = 0; i < n; i++) {
+                unsigned node = permutation[i];
+                for (unsigned k = graph.offsets[node]; k < graph.offsets[node + 1]; k++) {
+                    unsigned j = inverse[graph.neighbours[k]];
+                    if (j >= i)
+                        continue;
+                    //Climb from j to the root of its current subtree and attach it to i
+                    while (ancestor[j] != n && ancestor[j] != i) {
+                        unsigned next = ancestor[j];
+                        ancestor[j] = i;
+                        j = next;
+                    }
+                    if (ancestor[j] == n) {
+                        ancestor[j] = i;
+                        parent[j] = i;
+                    }
+                }
+            }
+            return parent;
+        }
+
+        /**
+        * @brief Depth first postorder of the forest, children in increasing order. postorder[k] is the k-th node.
+        */
+        static vector<unsigned> _postorder(const vector<unsigned> &parent) {
+            unsigned n = static_cast<unsigned>(parent.size());
+            vector<unsigned> firstChild(n + 1, n), nextSibling(n, n);
+            for (unsigned j = n; j-- > 0;) {
+                nextSibling[j] = firstChild[parent[j]];
+                firstChild[parent[j]] = j;
+            }
+            vector<unsigned> postorder;
+            postorder.reserve(n);
+            vector<unsigned> stack;
+            for (unsigned root = firstChild[n]; root != n; root = nextSibling[root]) {
+                stack.push_back(root);
+                while (!stack.empty()) {
+                    unsigned node = stack.back();
+                    if (firstChild[node] != n) {
+                        //Descend and detach the child, so the node is emitted when it has none left
+                        unsigned child = firstChild[node];
+                        firstChild[node] = nextSibling[child];
+                        stack.push_back(child);
+                    }
+                    else {
+                        postorder.push_back(node);
+                        stack.pop_back();
+                    }
+                }
+            }
+            return postorder;
+        }
+
+        /**
+        * @brief Number of elements of every column of L, diagonal included. Row i of L has an element in every column
+        * of the subtree of the elimination tree spanned by the columns of row i of A below the diagonal and i.
+        */
+        static vector<unsigned> _countColumns(const SparsityGraph &graph, const vector<unsigned> &inverse,
+                                               const vector<unsigned> &parent) {
+            unsigned n = graph.numberOfNodes;
+            vector<unsigned> counts(n, 1), mark(n, n);
+            vector<unsigned> permutation(n);
+            for (unsigned node = 0; node < n; node++)
+                permutation[inverse[node]] = node;
+            for (unsigned i = 0; i < n; i++) {
+                mark[i] = i;
+                unsigned node = permutation[i];
+                for (unsigned k = graph.offsets[node]; k < graph.offsets[node + 1]; k++) {
+                    unsigned j = inverse[graph.neighbours[k]];
+                    if (j >= i)
+                        continue;
+                    for (; mark[j] != i; j = parent[j]) {
+                        counts[j]++;
+                        mark[j] = i;
+                    }
+                }
+            }
+            return counts;
+        }
+
+        /**
+        * @brief Fundamental supernodes merged by the relaxed amalgamation, their row counts and their assembly tree.
+        */
+        void _buildSupernodes(const vector<unsigned> &parent, const vector<unsigned> &columnCounts) {
+            unsigned n = static_cast<unsigned>(parent.size());
+            vector<unsigned> numberOfChildren(n + 1, 0);
+            for (unsigned j = 0; j < n; j++)
+                numberOfChildren[parent[j]]++;
+            //Columns, rows below the columns and explicit zeros of the supernodes built so far
+            struct Panel {
+                unsigned first, columns, rowsBelow;
+                size_t zeros;
+                size_t stored() const {
+                    size_t rows = columns + rowsBelow;
+                    return rows * columns - static_cast<size_t>(columns) * (columns - 1) / 2;
+                }
+            };
+            vector<Panel> panels;
+            for (unsigned first = 0; first < n;) {
+                unsigned last = first + 1;
+                while (last < n && parent[last - 1] == last && numberOfChildren[last] == 1 &&
+                       columnCounts[last - 1] == columnCounts[last] + 1)
+                    last++;
+                Panel panel = {first, last - first, columnCounts[first] - (last - first), 0};
+                //In the postorder the column before the first one of a supernode is its last child, if it has any
+                while (!panels.empty() && parent[panel.first - 1] == panel.first) {
+                    auto &child = panels.back();
+                    Panel merged = {child.first, child.columns + panel.columns, panel.rowsBelow, 0};
+                    merged.zeros = merged.stored() - (child.stored() - child.zeros) - (panel.stored() - panel.zeros);
+                    if (merged.zeros - child.zeros - panel.zeros > _relaxedZeros)
+                        break;
+                    panel = merged;
+                    panels.pop_back();
+                }
+                panels.push_back(panel);
+                first = last;
+            }
+            _supernodeColumns.assign(1, 0);
+            _rowOffsets.assign(1, 0);
+            for (auto &panel : panels) {
+                _supernodeColumns.push_back(panel.first + panel.columns);
+                _rowOffsets.push_back(_rowOffsets.back() + panel.columns + panel.rowsBelow);
+            }
+
+            unsigned numberOfSupernodes = this->numberOfSupernodes();
+            vector<unsigned> supernodeOf(n);
+            for (unsigned s = 0; s < numberOfSupernodes; s++)
+                for (unsigned j = _supernodeColumns[s]; j < _supernodeColumns[s + 1]; j++)
+                    supernodeOf[j] = s;
+            _supernodeParent.assign(numberOfSupernodes, numberOfSupernodes);
+            _childOffsets.assign(numberOfSupernodes + 1, 0);
+            for (unsigned s = 0; s < numberOfSupernodes; s++) {
+                unsigned last = _supernodeColumns[s + 1] - 1;
+                if (parent[last] != n) {
+                    _supernodeParent[s] = supernodeOf[parent[last]];
+                    _childOffsets[_supernodeParent[s] + 1]++;
+                }
+            }
+            for (unsigned s = 0; s < numberOfSupernodes; s++)
+                _childOffsets[s + 1] += _childOffsets[s];
+            _children.resize(_childOffsets[numberOfSupernodes]);
+            vector<unsigned> position(_childOffsets.begin(), _childOffsets.end() - 1);
+            for (unsigned s = 0; s < numberOfSupernodes; s++)
+                if (_supernodeParent[s] != numberOfSupernodes)
+                    _children[position[_supernodeParent[s]]++] = s;
+        }
+
+        /**
+        * @brief The rows of a supernode are its columns, the rows of A below them and the rows of the children below
+        * their own columns. The children precede their parent in the postorder.
+        */
+        void _buildSupernodePatterns(const SparsityGraph &graph, const vector<unsigned> &inverse) {
+            unsigned numberOfSupernodes = this->numberOfSupernodes();
+            unsigned n = graph.numberOfNodes;
+            _valueOffsets.assign(numberOfSupernodes + 1, 0);
+            for (unsigned s = 0; s < numberOfSupernodes; s++) {
+                unsigned rows = _rowOffsets[s + 1] - _rowOffsets[s];
+                _valueOffsets[s + 1] = _valueOffsets[s] + static_cast<size_t>(rows) *
+                                       (_supernodeColumns[s + 1] - _supernodeColumns[s]);
+            }
+            _rows.resize(_rowOffsets[numberOfSupernodes]);
+            vector<unsigned> mark(n, numberOfSupernodes);
+            for (unsigned s = 0; s < numberOfSupernodes; s++) {
+                unsigned first = _supernodeColumns[s], last = _supernodeColumns[s + 1];
+                unsigned* rows = &_rows[_rowOffsets[s]];
+                unsigned size = 0;
+                for (unsigned j = first; j < last; j++) {
+                    rows[size++] = j;
+                    mark[j] = s;
+                }
+                auto append = [&](unsigned row) {
+                    if (row >= last && mark[row] != s) {
+                        mark[row] = s;
+                        rows[size++] = row;
+                    }
+                };
+                for (unsigned j = first; j < last; j++) {
+                    unsigned node = _permutation[j];
+                    for (unsigned k = graph.offsets[node]; k < graph.offsets[node + 1]; k++)
+                        append(inverse[graph.neighbours[k]]);
+                }
+                for (unsigned c = _childOffsets[s]; c < _childOffsets[s + 1]; c++) {
+                    unsigned child = _children[c];
+                    for (unsigned k = _rowOffsets[child]; k < _rowOffsets[child + 1]; k++)
+                        append(_rows[k]);
+                }
+                if (size != _rowOffsets[s + 1] - _rowOffsets[s])
+                    throw runtime_error("Supernodal Cholesky: inconsistent symbolic factorization.");
+                std::sort(rows + (last - first), rows + size);
+            }
+
+            //Positions of the rows of every child below its columns in the rows of its parent
+            _parentPositionOffsets.assign(numberOfSupernodes + 1, 0);
+            for (unsigned s = 0; s < numberOfSupernodes; s++)
+                _parentPositionOffsets[s + 1] = _parentPositionOffsets[s] + (_rowOffsets[s + 1] - _rowOffsets[s]) -
+                                                (_supernodeColumns[s + 1] - _supernodeColumns[s]);
+            _parentPositions.resize(_parentPositionOffsets[numberOfSupernodes]);
+            vector<unsigned> localRow(n);
+            for (unsigned s = 0; s < numberOfSupernodes; s++) {
+                for (unsigned k = _rowOffsets[s]; k < _rowOffsets[s + 1]; k++)
+                    localRow[_rows[k]] = k - _rowOffsets[s];
+                for (unsigned c = _childOffsets[s]; c < _childOffsets[s + 1]; c++) {
+                    unsigned child = _children[c];
+                    unsigned columns = _supernodeColumns[child + 1] - _supernodeColumns[child];
+                    unsigned* positions = &_parentPositions[_parentPositionOffsets[child]];
+                    for (unsigned k = _rowOffsets[child] + columns; k < _rowOffsets[child + 1]; k++)
+                        positions[k - _rowOffsets[child] - columns] = localRow[_rows[k]];
+                }
+            }
+        }
+
+        void _buildAssemblyMaps(const typename Preconditioner<T>::CSRArrays &csr, const vector<unsigned> &inverse) {
+            unsigned n = csr.numberOfRows;
+            vector<unsigned> supernodeOf(n);
+            for (unsigned s = 0; s < numberOfSupernodes(); s++)
+                for (unsigned j = _supernodeColumns[s]; j < _supernodeColumns[s + 1]; j++)
+                    supernodeOf[j] = s;
+            _assemblyTargets.assign(csr.rowOffsets[n], numeric_limits<size_t>::max());
+            for (unsigned row = 0; row < n; row++)
+                for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++) {
+                    unsigned i = inverse[row], j = inverse[csr.columnIndices[k]];
+                    if (i < j)
+                        continue;
+                    unsigned s = supernodeOf[j];
+                    auto first = _rows.begin() + _rowOffsets[s], last = _rows.begin() + _rowOffsets[s + 1];
+                    size_t localRow = std::lower_bound(first, last, i) - first;
+                    size_t leadingDimension = last - first;
+                    _assemblyTargets[k] = _valueOffsets[s] + (j - _supernodeColumns[s]) * leadingDimension + localRow;
+                }
+        }
+
+        /**
+        * @brief Levels of the assembly tree, leaves first, with the supernodes of a level sorted by decreasing cost.
+        */
+        void _buildLevels() {
+            unsigned numberOfSupernodes = this->numberOfSupernodes();
+            vector<unsigned> levels(numberOfSupernodes, 0);
+            unsigned numberOfLevels = numberOfSupernodes > 0 ? 1 : 0;
+            for (unsigned s = 0; s < numberOfSupernodes; s++) {
+                for (unsigned c = _childOffsets[s]; c < _childOffsets[s + 1]; c++)
+                    levels[s] = std::max(levels[s], levels[_children[c]] + 1);
+                numberOfLevels = std::max(numberOfLevels, levels[s] + 1);
+            }
+            _levelOffsets.assign(numberOfLevels + 1, 0);
+            for (unsigned s = 0; s < numberOfSupernodes; s++)
+                _levelOffsets[levels[s] + 1]++;
+            for (unsigned level = 0; level < numberOfLevels; level++)
+                _levelOffsets[level + 1] += _levelOffsets[level];
+            _levelSupernodes.resize(numberOfSupernodes);
+            vector<unsigned> position(_levelOffsets.begin(), _levelOffsets.end() - 1);
+            for (unsigned s = 0; s < numberOfSupernodes; s++)
+                _levelSupernodes[position[levels[s]]++] = s;
+            auto cost = [&](unsigned s) {
+                double rows = _rowOffsets[s + 1] - _rowOffsets[s];
+                double columns = _supernodeColumns[s + 1] - _supernodeColumns[s];
+                return rows * rows * columns;
+            };
+            for (unsigned level = 0; level < numberOfLevels; level++)
+                std::sort(_levelSupernodes.begin() + _levelOffsets[level], _levelSupernodes.begin() + _levelOffsets[level + 1],
+                          [&](unsigned a, unsigned b) { return cost(a) > cost(b); });
+        }
+
+        /**
+        * @brief Extend-add of the children, partial factorization of the panel and update matrix of the supernode.
+        *
+        * @return false if the diagonal block is not positive definite.
+        */
+        bool _factorizeSupernode(unsigned s, unsigned threads) {
+            unsigned columns = _supernodeColumns[s + 1] - _supernodeColumns[s];
+            unsigned rows = _rowOffsets[s + 1] - _rowOffsets[s];
+            unsigned below = rows - columns;
+            T* panel = &_values[_valueOffsets[s]];
+            vector<T> &update = _updates[s];
+            update.assign(static_cast<size_t>(below) * below, 0);
+
+            for (unsigned c = _childOffsets[s]; c < _childOffsets[s + 1]; c++) {
+                unsigned child = _children[c];
+                vector<T> &childUpdate = _updates[child];
+                unsigned childBelow = _parentPositionOffsets[child + 1] - _parentPositionOffsets[child];
+                const unsigned* positions = &_parentPositions[_parentPositionOffsets[child]];
+                for (unsigned b = 0; b < childBelow; b++) {
+                    unsigned column = positions[b];
+                    const T* childColumn = &childUpdate[static_cast<size_t>(b) * childBelow];
+                    if (column < columns) {
+                        T* panelColumn = panel + static_cast<size_t>(column) * rows;
+                        for (unsigned a = b; a < childBelow; a++)
+                            panelColumn[positions[a]] += childColumn[a];
+                    }
+                    else {
+                        T* updateColumn = &update[static_cast<size_t>(column - columns) * below];
+                        for (unsigned a = b; a < childBelow; a++)
+                            updateColumn[positions[a] - columns] += childColumn[a];
+                    }
+                }
+                vector<T>().swap(childUpdate);
+            }
+
+            if (!DenseBlockKernels<T>::cholesky(panel, columns, rows, threads))
+                return false;
+            if (below > 0) {
+                DenseBlockKernels<T>::solveRightLowerTransposed(panel, columns, rows, panel + columns, below, rows, threads);
+                DenseBlockKernels<T>::subtractSymmetricProduct(panel + columns, below, columns, rows, update.data(), below,
+                                                               threads);
+            }
+            return true;
+        }
+
+        /**
+        * @brief Forward and backward substitution of the right-hand sides in blocks of columns, one block per thread.
+        */
+        void _solve(const vector<const T*> &rhs, const vector<T*> &solutions) const {
+            unsigned n = this->_numberOfRows;
+            unsigned numberOfColumns = static_cast<unsigned>(rhs.size());
+            vector<T> work(static_cast<size_t>(n) * numberOfColumns);
+            for (unsigned column = 0; column < numberOfColumns; column++)
+                for (unsigned k = 0; k < n; k++)
+                    work[k + static_cast<size_t>(column) * n] = rhs[column][_permutation[k]];
+
+            unsigned threads = std::min(this->_availableThreads, numberOfColumns);
+            auto columnsJob = [&](unsigned thread, unsigned) {
+                unsigned start = numberOfColumns * thread / threads, end = numberOfColumns * (thread + 1) / threads;
+                if (end > start)
+                    _substitute(&work[static_cast<size_t>(start) * n], end - start);
+            };
+            ThreadingOperations<T>::executeParallelJob(columnsJob, threads, threads, sizeof(T));
+
+            for (unsigned column = 0; column < numberOfColumns; column++)
+                for (unsigned k = 0; k < n; k++)
+                    solutions[column][_permutation[k]] = work[k + static_cast<size_t>(column) * n];
+        }
+
+        /**
+        * @brief Solves L L^T X = B in place for the n x k column major block of permuted right-hand sides.
+        */
+        void _substitute(T* x, unsigned k) const {
+            unsigned n = this->_numberOfRows;
+            vector<T> gathered;
+            for (unsigned s = 0; s < numberOfSupernodes(); s++) {
+                unsigned first = _supernodeColumns[s], columns = _supernodeColumns[s + 1] - first;
+                unsigned rows = _rowOffsets[s + 1] - _rowOffsets[s], below = rows - columns;
+                const T* panel = &_values[_valueOffsets[s]];
+                const unsigned* belowRows = &_rows[_rowOffsets[s] + columns];
+                DenseBlockKernels<T>::solveLeftLower(panel, columns, rows, x + first, k, n);
+                if (below == 0)
+                    continue;
+                gathered.resize(static_cast<size_t>(below) * k);
+                DenseBlockKernels<T>::multiply(panel + columns, below, columns, rows, x + first, k, n, gathered.data(), below);
+                for (unsigned column = 0; column < k; column++)
+                    for (unsigned i = 0; i < below; i++)
+                        x[belowRows[i] + static_cast<size_t>(column) * n] -= gathered[i + static_cast<size_t>(column) * below];
+            }
+            for (unsigned s = numberOfSupernodes(); s-- > 0;) {
+                unsigned first = _supernodeColumns[s], columns = _supernodeColumns[s + 1] - first;
+                unsigned rows = _rowOffsets[s + 1] - _rowOffsets[s], below = rows - columns;
+                const T* panel = &_values[_valueOffsets[s]];
+                const unsigned* belowRows = &_rows[_rowOffsets[s] + columns];
+                if (below > 0) {
+                    gathered.resize(static_cast<size_t>(below) * k);
+                    for (unsigned column = 0; column < k; column++)
+                        for (unsigned i = 0; i < below; i++)
+                            gathered[i + static_cast<size_t>(column) * below] = x[belowRows[i] + static_cast<size_t>(column) * n];
+                    DenseBlockKernels<T>::subtractTransposedProduct(panel + columns, below, columns, rows, gathered.data(),
+                                                                    k, below, x + first, n);
+                }
+                DenseBlockKernels<T>::solveLeftLowerTransposed(panel, columns, rows, x + first, k, n);
+            }
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_SUPERNODALCHOLESKY_H
@@ -0,0 +1,84 @@
+//
+// Created by hal9000 on 11/2/23.
+//
+
+#ifndef UNTITLED_TRIDIAGONALSOLVER_H
+#define UNTITLED_TRIDIAGONALSOLVER_H
+
+#include <cmath>
+#include <vector>
+#include "../../../ThreadingOperations/ThreadingOperations.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Thomas algorithm for tridiagonal systems a_k x_{k-1} + b_k x_k + c_k x_{k+1} = d_k, k = 0, ..., n - 1.
+    *
+    * The elimination is split in a factorization that depends only on the matrix, c'_k = c_k / (b_k - a_k c'_{k-1}),
+    * and a solve of 5n flops per right hand side, so that the factors of fixed lines are computed once and reused in
+    * every sweep of a line relaxation. There is no pivoting: the matrix must be diagonally dominant or symmetric
+    * positive definite, as the finite difference operators along a grid line are.
+    *
+    * @tparam T The datatype of the matrix and vector elements.
+    */
+    template<typename T>
+    class TridiagonalSolver {
+    public:
+        /**
+        * @brief Computes the modified upper diagonal c' and the inverses of the pivots b_k - a_k c'_{k-1}.
+        * lower[0] and upper[n - 1] are not referenced.
+        *
+        * @return false if a pivot is zero.
+        */
+        static bool factorize(const T* lower, const T* diagonal, const T* upper, unsigned n, T* modifiedUpper,
+                              T* inverseDenominator) {
+            T previousUpper = 0;
+            for (unsigned k = 0; k < n; k++) {
+                T denominator = diagonal[k] - (k > 0 ? lower[k] * previousUpper : static_cast<T>(0));
+                if (denominator == static_cast<T>(0) || !std::isfinite(static_cast<double>(denominator)))
+                    return false;
+                inverseDenominator[k] = 1 / denominator;
+                previousUpper = modifiedUpper[k] = k + 1 < n ? upper[k] * inverseDenominator[k] : static_cast<T>(0);
+            }
+            return true;
+        }
+
+        /**
+        * @brief Solves the system in place: x holds the right hand side on entry, with its elements stride apart.
+        */
+        static void solve(const T* lower, const T* modifiedUpper, const T* inverseDenominator, unsigned n, T* x,
+                          size_t stride = 1) {
+            if (n == 0)
+                return;
+            x[0] *= inverseDenominator[0];
+            for (unsigned k = 1; k < n; k++)
+                x[k * stride] = (x[k * stride] - lower[k] * x[(k - 1) * stride]) * inverseDenominator[k];
+            for (unsigned k = n - 1; k-- > 0;)
+                x[k * stride] -= modifiedUpper[k] * x[(k + 1) * stride];
+        }
+
+        /**
+        * @brief Solves numberOfLines independent systems of n unknowns in place, distributed among the threads.
+        *
+        * The coefficients of line l start at l * n in the three arrays. Its unknowns start at x + lineStart(l) and are
+        * stride apart, so that the lines of a structured grid in any direction are solved without copies.
+        */
+        template<typename LineStart>
+        static void solveLines(const T* lower, const T* modifiedUpper, const T* inverseDenominator, unsigned n,
+                               unsigned numberOfLines, T* x, LineStart lineStart, size_t stride,
+                               unsigned availableThreads = 1) {
+            auto linesJob = [&](unsigned start, unsigned end) {
+                for (unsigned line = start; line < end; line++) {
+                    size_t offset = static_cast<size_t>(line) * n;
+                    solve(lower + offset, modifiedUpper + offset, inverseDenominator + offset, n,
+                          x + lineStart(line), stride);
+                }
+            };
+            //Ranges of whole lines, without the cache line rounding
+            ThreadingOperations<T>::executeParallelJob(linesJob, numberOfLines, availableThreads, sizeof(T));
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_TRIDIAGONALSOLVER_H
@@ -66,6 +66,8 @@ namespace LinearAlgebra {
         //r_old = b - A * x_old
         VectorOperations::subtract(_linearSystem->rhs, _matrixVectorMultiplication, _residualOld);
         double normInitial = VectorNorm(_residualOld, _normType).value();
+        _telemetry->countMatrixVectorProducts();
+        _telemetry->countReductions();
         _residualNorms->push_back(normInitial);
         //d_old = r_old
         VectorOperations::deepCopy(_residualOld, _directionVectorOld);
@@ -90,8 +92,13 @@ namespace LinearAlgebra {
             _exitNorm = VectorNorm(_residualNew, _normType).value() / normInitial;
             //_exitNorm = VectorNorm(_residualNew, _normType).value();
             _residualNorms->push_back(_exitNorm);
+            //A d, (r, r), (d, A d) and the norm of the new residual
+            _telemetry->countMatrixVectorProducts();
+            _telemetry->countReductions(3);
+            _recordIteration();
             if (_exitNorm > _tolerance){
                 //Calculate the new direction
+                _telemetry->countReductions();
                 double r_newT_r_new = VectorOperations::dotProductWithTranspose(_residualNew);
                 beta = r_newT_r_new / r_oldT_r_old;
                 //newDirection = r_new + beta * difference
@@ -107,7 +114,6 @@ namespace LinearAlgebra {
             }
             
             //Update the old residual and the old difference
-            _printIterationAndNorm(1) ;
             _iteration++;
         }
         auto end = std::chrono::high_resolution_clock::now();
@@ -130,6 +136,8 @@ namespace LinearAlgebra {
         //r_old = b - A * x_old
         MultiThreadVectorOperations::subtract(_linearSystem->rhs->data(), _matrixVectorMultiplication->data(), _residualOld->data(), n);
         double normInitial = VectorNorm(_residualOld, _normType).value();
+        _telemetry->countMatrixVectorProducts();
+        _telemetry->countReductions();
         _residualNorms->push_back(normInitial);
         //d_old = r_old
         MultiThreadVectorOperations::deepCopy(_residualOld->data(), _directionVectorOld->data(), n);
@@ -155,8 +163,13 @@ namespace LinearAlgebra {
             _exitNorm = VectorNorm(_residualNew, _normType).value() / normInitial;
             //_exitNorm = VectorNorm(_residualNew, _normType).value();
             _residualNorms->push_back(_exitNorm);
+            //A d, (r, r), (d, A d) and the norm of the new residual
+            _telemetry->countMatrixVectorProducts();
+            _telemetry->countReductions(3);
+            _recordIteration();
             if (_exitNorm > _tolerance){
                 //Calculate the new direction
+                _telemetry->countReductions();
                 double r_newT_r_new = MultiThreadVectorOperations::dotProduct(_residualNew->data(), _residualNew->data(), n);
                 beta = r_newT_r_new / r_oldT_r_old;
                 //newDirection = r_new + beta * difference
@@ -173,7 +186,6 @@ namespace LinearAlgebra {
             }
 
             //Update the old residual and the old difference
-            _printIterationAndNorm(10) ;
             _iteration++;
         }
     };
@@ -17,7 +17,7 @@ namespace LinearAlgebra {
             Solver(), _normType(normType), _tolerance(tolerance), _maxIterations(maxIterations),
             _throwExceptionOnMaxFailure(throwExceptionOnMaxFailure), _xNew(nullptr),
             _xOld(nullptr),
-            _residualNorms(make_shared<list<double>>()) {
+            _residualNorms(make_shared<list<double>>()), _telemetry(make_shared<SolverTelemetry>()) {
         _linearSystemInitialized = false;
         _vectorsInitialized = false;
         _parallelization = parallelizationMethod;
@@ -72,10 +72,22 @@ namespace LinearAlgebra {
         return _normType;
     }
 
+    void IterativeSolver::setTelemetry(shared_ptr<SolverTelemetry> telemetry) {
+        if (telemetry == nullptr)
+            throw std::invalid_argument("Telemetry cannot be null.");
+        _telemetry = std::move(telemetry);
+    }
+
+    const shared_ptr<SolverTelemetry> &IterativeSolver::getTelemetry() const {
+        return _telemetry;
+    }
+
     void IterativeSolver::solve() {
         if (!_isLinearSystemSet)
             throw std::invalid_argument("Linear system must be set before solving.");
+        _telemetry->begin(_solverName);
         _iterativeSolution();
+        _telemetry->end(_iteration, _exitNorm, _exitNorm <= _tolerance);
         _linearSystem->solution = std::move(_xNew);
     }
     
@@ -96,12 +108,16 @@ namespace LinearAlgebra {
     }
 
     void IterativeSolver::_printSingleThreadInitializationText() {
+        if (_telemetry->isQuiet())
+            return;
         cout << " " << endl;
         cout << "----------------------------------------" << endl;
         cout << _solverName << " Solver Single Thread - no vtec yo :(" << endl;
     }
 
     void IterativeSolver::_printMultiThreadInitializationText(unsigned short numberOfThreads) {
+        if (_telemetry->isQuiet())
+            return;
         cout << " " << endl;
         cout << "----------------------------------------" << endl;
         cout << _solverName << " Solver Multi Thread - VTEC KICKED IN YO!" << endl;
@@ -114,10 +130,8 @@ namespace LinearAlgebra {
 
     }
 
-    void IterativeSolver::_printIterationAndNorm(unsigned displayFrequency) const {
-        if (_iteration % displayFrequency == 0)
-            cout << "Iteration: " << _iteration << " - Norm: " << _exitNorm << endl;
-
+    void IterativeSolver::_recordIteration() {
+        _telemetry->record(_iteration, _exitNorm);
     }
     
     double IterativeSolver::_calculateNorm() {
@@ -128,6 +142,8 @@ namespace LinearAlgebra {
 
     void IterativeSolver::printAnalysisOutcome(unsigned totalIterations, double exitNorm,  std::chrono::high_resolution_clock::time_point startTime,
                                                    std::chrono::high_resolution_clock::time_point finishTime) const{
+        if (_telemetry->isQuiet())
+            return;
         bool isInMicroSeconds = false;
         auto _elapsedTime = std::chrono::duration_cast<std::chrono::milliseconds>(finishTime - startTime).count();
         if (_elapsedTime == 0) {
@@ -11,6 +11,7 @@
 #include "../../Norms/VectorNorm.h"
 #include "../../Operations/MultiThreadVectorOperations.h"   
 #include "../../ParallelizationMethods.h"
+#include "../Telemetry/SolverTelemetry.h"
 using LinearAlgebra::ParallelizationMethod;
 
 namespace LinearAlgebra {
@@ -34,6 +35,17 @@ namespace LinearAlgebra {
         
         const VectorNormType& getNormType() const;
         
+        /**
+        * @brief Replaces the telemetry that records the iterations of the solver, e.g. to share one between solvers.
+        * @throws invalid_argument If telemetry is null.
+        */
+        void setTelemetry(shared_ptr<SolverTelemetry> telemetry);
+        
+        /**
+        * @brief The telemetry of the solver. Attach sinks or set it quiet before solve().
+        */
+        const shared_ptr<SolverTelemetry>& getTelemetry() const;
+        
         void solve() override;
         
     protected:
@@ -61,6 +73,8 @@ namespace LinearAlgebra {
         string _solverName;
 
         ParallelizationMethod _parallelization;
+        
+        shared_ptr<SolverTelemetry> _telemetry;
 
         
         void setInitialSolution(shared_ptr<vector<double>> initialSolution) override;
@@ -81,7 +95,10 @@ namespace LinearAlgebra {
         
         void _printCUDAInitializationText();
         
-        void _printIterationAndNorm(unsigned displayFrequency = 100) const;
+        /**
+        * @brief Records the iteration and the exit norm in the telemetry. No console output.
+        */
+        void _recordIteration();
         
         double _calculateNorm();
         
@@ -0,0 +1,93 @@
+//
+// Created by hal9000 on 10/29/23.
+//
+
+#ifndef UNTITLED_BICONJUGATEGRADIENTSTABILIZED_H
+#define UNTITLED_BICONJUGATEGRADIENTSTABILIZED_H
+
+#include "KrylovSolver.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Right preconditioned BiCGStab (van der Vorst) for general (non-symmetric) operators.
+    *
+    * Short recurrences with two multiplications with A and two applications of M^-1 per iteration and a fixed set of
+    * seven work vectors, so unlike GMRES the memory does not grow with the iterations and no restart is needed. The
+    * residual is not monotone. The iteration stops early after the BiCG half step if the intermediate residual
+    * already satisfies the tolerance.
+    *
+    * @throws runtime_error On a breakdown of the recurrences (r̂·r = 0 or r̂·A p = 0).
+    */
+    template<typename T>
+    class BiConjugateGradientStabilized : public KrylovSolver<T> {
+    public:
+        explicit BiConjugateGradientStabilized(double tolerance = 1E-9, unsigned maxIterations = 1E4,
+                                               bool throwExceptionOnMaxFailure = true, unsigned availableThreads = 1) :
+                KrylovSolver<T>(tolerance, maxIterations, throwExceptionOnMaxFailure, availableThreads) {
+            this->_solverName = "BiCGStab";
+        }
+
+    protected:
+        void _solve(LinearOperator<T> &matrix, NumericalVector<T> &rhs, NumericalVector<T> &solution) override {
+            unsigned n = rhs.size();
+            unsigned threads = this->_availableThreads;
+            NumericalVector<T> residual(n, 0, threads), shadowResidual(n, 0, threads), direction(n, 0, threads),
+                               matrixTimesDirection(n, 0, threads), preconditionedDirection(n, 0, threads),
+                               preconditionedResidual(n, 0, threads), matrixTimesResidual(n, 0, threads);
+            double referenceNorm = this->_referenceNorm(rhs);
+
+            //r = b - A x, r̂ = r
+            this->_multiply(matrix, solution, residual);
+            residual.subtractIntoThis(rhs, -1, -1, threads);
+            if (this->_recordResidual(std::sqrt(this->_dot(residual, residual)) / referenceNorm))
+                return;
+            std::copy(residual.getDataPointer(), residual.getDataPointer() + n, shadowResidual.getDataPointer());
+            T rho = 1, alpha = 1, omega = 1;
+
+            while (this->_iteration < this->_maxIterations) {
+                this->_iteration++;
+                T newRho = this->_dot(shadowResidual, residual);
+                if (newRho == static_cast<T>(0))
+                    throw runtime_error("BiCGStab breakdown: the residual is orthogonal to the shadow residual.");
+                //p = r + β (p - ω A p̂)
+                T beta = (newRho / rho) * (alpha / omega);
+                rho = newRho;
+                direction.addIntoThis(matrixTimesDirection, 1, -omega, threads);
+                direction.addIntoThis(residual, beta, 1, threads);
+
+                //p̂ = M^-1 p, s = r - α A p̂
+                this->_applyPreconditioner(direction, preconditionedDirection);
+                this->_multiply(matrix, preconditionedDirection, matrixTimesDirection);
+                T projection = this->_dot(shadowResidual, matrixTimesDirection);
+                if (projection == static_cast<T>(0))
+                    throw runtime_error("BiCGStab breakdown: r̂·A p = 0.");
+                alpha = rho / projection;
+                residual.subtractIntoThis(matrixTimesDirection, 1, alpha, threads);
+                double halfStepNorm = std::sqrt(this->_dot(residual, residual)) / referenceNorm;
+                if (halfStepNorm <= this->_tolerance) {
+                    solution.addIntoThis(preconditionedDirection, 1, alpha, threads);
+                    this->_recordResidual(halfStepNorm);
+                    return;
+                }
+
+                //ŝ = M^-1 s, t = A ŝ, ω = t·s / t·t
+                this->_applyPreconditioner(residual, preconditionedResidual);
+                this->_multiply(matrix, preconditionedResidual, matrixTimesResidual);
+                T tDotT = this->_dot(matrixTimesResidual, matrixTimesResidual);
+                omega = tDotT > 0 ? this->_dot(matrixTimesResidual, residual) / tDotT : 0;
+                //x = x + α p̂ + ω ŝ, r = s - ω t
+                solution.addIntoThis(preconditionedDirection, 1, alpha, threads);
+                solution.addIntoThis(preconditionedResidual, 1, omega, threads);
+                residual.subtractIntoThis(matrixTimesResidual, 1, omega, threads);
+                if (this->_recordResidual(std::sqrt(this->_dot(residual, residual)) / referenceNorm))
+                    return;
+                if (omega == static_cast<T>(0))
+                    throw runtime_error("BiCGStab breakdown: ω = 0.");
+            }
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_BICONJUGATEGRADIENTSTABILIZED_H
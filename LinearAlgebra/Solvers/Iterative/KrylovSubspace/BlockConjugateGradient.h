@@ -0,0 +1,88 @@
+//
+// Created by hal9000 on 11/4/23.
+//
+
+#ifndef UNTITLED_BLOCKCONJUGATEGRADIENT_H
+#define UNTITLED_BLOCKCONJUGATEGRADIENT_H
+
+#include "BlockKrylovSolver.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Preconditioned block conjugate gradient (O'Leary) for symmetric positive definite operators and
+    * preconditioners with several right hand sides.
+    *
+    * All the columns share the search space: every iteration moves each x_c in the A-conjugate block of directions P,
+    * which collects the preconditioned residuals of all the active columns, so a column usually needs fewer iterations
+    * than a separate CG and all of them share one block product A P per iteration.
+    *
+    * The directions are orthonormalized with a rank revealing Cholesky QR (breakdown-free block CG, Ji and Li), so
+    * P^T A P stays well conditioned and directions that became linearly dependent are dropped instead of making
+    * P^T A P singular. Converged columns leave the block (variable block CG, Nikishin and Yeremin). With
+    * P = orth(Z + P β), Q = A P:
+    *   α = (P^T Q)^-1 P^T R, X = X + P α, R = R - Q α, Z = M^-1 R, β = -(P^T Q)^-1 Q^T Z.
+    * The gain depends on the right hand sides being independent: when the residual block is nearly rank deficient
+    * (e.g. smooth right hand sides sharing a dominant component) the dropped directions are lost for every column and
+    * the block may need as many iterations as the slowest separate solve, while each iteration costs O(n k^2) more
+    * dense work than k separate CG steps.
+    */
+    template<typename T>
+    class BlockConjugateGradient : public BlockKrylovSolver<T> {
+    public:
+        explicit BlockConjugateGradient(double tolerance = 1E-9, unsigned maxIterations = 1E4,
+                                        bool throwExceptionOnMaxFailure = true, unsigned availableThreads = 1,
+                                        double deflationTolerance = 1E-6) :
+                BlockKrylovSolver<T>(tolerance, maxIterations, throwExceptionOnMaxFailure, availableThreads,
+                                     deflationTolerance) {
+            this->_solverName = "Block Conjugate Gradient";
+        }
+
+    protected:
+        void _solveBlock(LinearOperator<T> &matrix, vector<T> &rhs, vector<T> &solution, unsigned k) override {
+            vector<unsigned> active(k);
+            for (unsigned c = 0; c < k; c++)
+                active[c] = c;
+            //R = B - A X
+            vector<T> residual;
+            this->_multiplyBlock(matrix, solution, residual, k);
+            for (size_t i = 0; i < residual.size(); i++)
+                residual[i] = rhs[i] - residual[i];
+            if (this->_recordResiduals(active, this->_relativeColumnNorms(residual, k, active)))
+                return;
+            unsigned width = this->_deflateConverged(active, {&residual});
+
+            vector<T> preconditioned, directions, matrixTimesDirections, factor, projection, curvature;
+            this->_preconditionBlock(residual, preconditioned, width);
+            directions.swap(preconditioned);
+            unsigned rank = this->_orthonormalize(directions, width, factor);
+
+            while (this->_iteration < this->_maxIterations && rank > 0) {
+                this->_iteration++;
+                this->_multiplyBlock(matrix, directions, matrixTimesDirections, rank);
+                this->_gram(directions, rank, matrixTimesDirections, rank, curvature);
+                if (!this->_cholesky(curvature, rank))
+                    throw runtime_error("Operator or preconditioner is not positive definite.");
+                //α = (P^T A P)^-1 P^T R, X = X + P α, R = R - A P α
+                this->_gram(directions, rank, residual, width, projection);
+                this->_choleskySolve(curvature, rank, projection, width);
+                this->_addProduct(solution, k, active.data(), directions, rank, projection, width);
+                this->_addProduct(residual, width, nullptr, matrixTimesDirections, rank, projection, width, -1);
+                if (this->_recordResiduals(active, this->_relativeColumnNorms(residual, width, active)))
+                    return;
+                width = this->_deflateConverged(active, {&residual});
+
+                //P = orth(Z + P β), β = -(P^T A P)^-1 (A P)^T Z
+                this->_preconditionBlock(residual, preconditioned, width);
+                this->_gram(matrixTimesDirections, rank, preconditioned, width, projection);
+                this->_choleskySolve(curvature, rank, projection, width);
+                this->_addProduct(preconditioned, width, nullptr, directions, rank, projection, width, -1);
+                directions.swap(preconditioned);
+                rank = this->_orthonormalize(directions, width, factor);
+            }
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_BLOCKCONJUGATEGRADIENT_H
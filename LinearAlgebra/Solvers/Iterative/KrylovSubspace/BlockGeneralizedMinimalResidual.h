@@ -0,0 +1,287 @@
+//
+// Created by hal9000 on 11/4/23.
+//
+
+#ifndef UNTITLED_BLOCKGENERALIZEDMINIMALRESIDUAL_H
+#define UNTITLED_BLOCKGENERALIZEDMINIMALRESIDUAL_H
+
+#include "BlockKrylovSolver.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Restarted block GMRES(m) with right preconditioning for general operators and several right hand sides.
+    *
+    * Each cycle orthonormalizes the residual block of the active columns, R = V_0 S, and builds with at most m block
+    * Arnoldi steps (block modified Gram-Schmidt) the orthonormal blocks V_0, ..., V_m of the block Krylov subspace of
+    * A M^-1, one block product per step. Every column minimizes its own residual ||S e_c - H y_c|| over the whole
+    * subspace, so the columns share the basis and the block Hessenberg matrix H, which is reduced to triangular form
+    * with Householder reflections as it grows. The residual estimates of all the columns are available after every
+    * step. At the end of a cycle the true residuals b - A x of the active columns are recomputed, the converged columns
+    * are deflated and the others restart.
+    *
+    * The residual block and every new Arnoldi block are orthonormalized with the rank revealing Cholesky QR of
+    * BlockKrylovSolver: dependent right hand sides shrink the block of the cycle, and a rank deficient Arnoldi block,
+    * i.e. an invariant subspace for some combination of the columns, ends the cycle early.
+    */
+    template<typename T>
+    class BlockGeneralizedMinimalResidual : public BlockKrylovSolver<T> {
+    public:
+        explicit BlockGeneralizedMinimalResidual(double tolerance = 1E-9, unsigned maxIterations = 1E4,
+                                                 bool throwExceptionOnMaxFailure = true, unsigned availableThreads = 1,
+                                                 unsigned restartLength = 30, double deflationTolerance = 1E-6) :
+                BlockKrylovSolver<T>(tolerance, maxIterations, throwExceptionOnMaxFailure, availableThreads,
+                                     deflationTolerance) {
+            setRestartLength(restartLength);
+        }
+
+        /**
+        * @brief Sets m, the maximum number of block Arnoldi steps before a restart.
+        */
+        void setRestartLength(unsigned restartLength) {
+            if (restartLength == 0)
+                throw invalid_argument("The restart length must be positive.");
+            _restartLength = restartLength;
+            this->_solverName = "Block GMRES(" + to_string(restartLength) + ")";
+        }
+
+        unsigned getRestartLength() const {
+            return _restartLength;
+        }
+
+        /**
+        * @brief Returns the number of cycles (restarts + 1) of the last solve().
+        */
+        unsigned getCycles() const {
+            return _cycles;
+        }
+
+    protected:
+        void _solveBlock(LinearOperator<T> &matrix, vector<T> &rhs, vector<T> &solution, unsigned k) override {
+            unsigned n = matrix.numberOfRows();
+            _cycles = 0;
+            vector<unsigned> active(k);
+            for (unsigned c = 0; c < k; c++)
+                active[c] = c;
+            vector<T> residual;
+            unsigned width = k;
+            _trueResidual(matrix, rhs, solution, k, active, residual);
+            if (this->_recordResiduals(active, this->_relativeColumnNorms(residual, width, active)))
+                return;
+            width = this->_deflateConverged(active, {&residual});
+
+            vector<vector<T>> basis(_restartLength + 1);
+            vector<T> preconditioned, work, coefficients, subdiagonal;
+            while (this->_iteration < this->_maxIterations && width > 0) {
+                _cycles++;
+                //R = V_0 S
+                basis[0] = residual;
+                vector<T> s;
+                unsigned p = this->_orthonormalize(basis[0], width, s);
+                if (p == 0)
+                    break;
+                unsigned m = std::min(_restartLength, (n + p - 1) / p);
+                _blockSize = p;
+                _hessenbergRows = (m + 1) * p;
+                _hessenberg.assign(static_cast<size_t>(_hessenbergRows) * m * p, 0);
+                _reflectors.assign(static_cast<size_t>(m) * p * 2 * p, 0);
+                //G = S e_1, (m + 1) p x width row major, rotated with H
+                _leastSquaresRhs.assign(static_cast<size_t>(_hessenbergRows) * width, 0);
+                std::copy(s.begin(), s.end(), _leastSquaresRhs.begin());
+
+                unsigned steps = 0;
+                bool endCycle = false;
+                while (steps < m && this->_iteration < this->_maxIterations && !endCycle) {
+                    unsigned j = steps;
+                    this->_iteration++;
+                    //W = A M^-1 V_j, orthogonalized against V_0 ... V_j
+                    this->_preconditionBlock(basis[j], preconditioned, p);
+                    this->_multiplyBlock(matrix, preconditioned, work, p);
+                    for (unsigned i = 0; i <= j; i++) {
+                        this->_gram(basis[i], p, work, p, coefficients);
+                        this->_addProduct(work, p, nullptr, basis[i], p, coefficients, p, -1);
+                        for (unsigned a = 0; a < p; a++)
+                            for (unsigned b = 0; b < p; b++)
+                                _h(i * p + a, j * p + b) = coefficients[a * p + b];
+                    }
+                    unsigned rank = this->_orthonormalize(work, p, subdiagonal);
+                    for (unsigned a = 0; a < rank; a++)
+                        for (unsigned b = 0; b < p; b++)
+                            _h((j + 1) * p + a, j * p + b) = subdiagonal[a * p + b];
+                    //A rank deficient block cannot extend the basis, the subspace is invariant for some columns
+                    endCycle = rank < p;
+                    if (!endCycle)
+                        basis[j + 1].swap(work);
+                    for (unsigned b = 0; b < p; b++)
+                        _triangularizeColumn(j * p + b, width);
+                    steps++;
+
+                    //The residual of column c is the part of G below the triangle
+                    vector<double> estimates(width, 0);
+                    for (unsigned c = 0; c < width; c++) {
+                        double sum = 0;
+                        for (unsigned row = (j + 1) * p; row < (j + 2) * p; row++)
+                            sum += static_cast<double>(_g(row, c, width) * _g(row, c, width));
+                        estimates[c] = std::sqrt(sum) / this->_referenceNorms[active[c]];
+                    }
+                    endCycle = this->_recordResiduals(active, estimates) || endCycle;
+                }
+
+                _updateSolution(steps, basis, width, active, k, solution);
+                _trueResidual(matrix, rhs, solution, k, active, residual);
+                vector<double> trueNorms = this->_relativeColumnNorms(residual, width, active);
+                for (unsigned c = 0; c < width; c++)
+                    this->_columnExitNorms[active[c]] = trueNorms[c];
+                double largest = *std::max_element(this->_columnExitNorms.begin(), this->_columnExitNorms.end());
+                this->_residualNorms->back() = largest;
+                this->_exitNorm = largest;
+                this->_converged = largest <= this->_tolerance;
+                if (this->_converged)
+                    return;
+                width = this->_deflateConverged(active, {&residual});
+            }
+        }
+
+    private:
+        unsigned _restartLength;
+
+        unsigned _cycles = 0;
+
+        unsigned _blockSize = 0;
+
+        /**
+        * @brief The (m + 1) p x m p block Hessenberg matrix in column major order, upper triangular after the reflections.
+        */
+        vector<T> _hessenberg;
+
+        unsigned _hessenbergRows = 0;
+
+        /**
+        * @brief The unit Householder vectors, 2p elements apart. Reflector l eliminates the elements of column l of H
+        * below the diagonal. The subdiagonal blocks are triangular only up to the pivoting of the orthonormalization,
+        * so it acts on all the rows l, ..., (l / p + 2) p - 1 of the block column.
+        */
+        vector<T> _reflectors;
+
+        /**
+        * @brief The rotated right hand sides S e_1 of the least squares problems, row major.
+        */
+        vector<T> _leastSquaresRhs;
+
+        T &_h(unsigned row, unsigned column) {
+            return _hessenberg[row + static_cast<size_t>(column) * _hessenbergRows];
+        }
+
+        T &_g(unsigned row, unsigned column, unsigned width) {
+            return _leastSquaresRhs[static_cast<size_t>(row) * width + column];
+        }
+
+        /**
+        * @brief R = B - A X for the active columns of the n x k blocks B and X.
+        */
+        void _trueResidual(LinearOperator<T> &matrix, vector<T> &rhs, vector<T> &solution, unsigned k,
+                           const vector<unsigned> &active, vector<T> &residual) {
+            unsigned width = static_cast<unsigned>(active.size());
+            unsigned n = static_cast<unsigned>(rhs.size() / k);
+            vector<T> activeSolution(static_cast<size_t>(n) * width);
+            for (unsigned row = 0; row < n; row++)
+                for (unsigned c = 0; c < width; c++)
+                    activeSolution[static_cast<size_t>(row) * width + c] = solution[static_cast<size_t>(row) * k + active[c]];
+            this->_multiplyBlock(matrix, activeSolution, residual, width);
+            for (unsigned row = 0; row < n; row++)
+                for (unsigned c = 0; c < width; c++)
+                    residual[static_cast<size_t>(row) * width + c] = rhs[static_cast<size_t>(row) * k + active[c]] -
+                                                                      residual[static_cast<size_t>(row) * width + c];
+        }
+
+        unsigned _reflectorLength(unsigned reflector) const {
+            return (reflector / _blockSize + 2) * _blockSize - reflector;
+        }
+
+        /**
+        * @brief x = (I - 2 u u^T) x with the Householder vector of a reflector, for the column x (elements stride apart).
+        */
+        void _reflect(unsigned reflector, T* x, size_t stride) {
+            const T* u = _reflectors.data() + static_cast<size_t>(reflector) * 2 * _blockSize;
+            unsigned length = _reflectorLength(reflector);
+            T projection = 0;
+            for (unsigned i = 0; i < length; i++)
+                projection += u[i] * x[(reflector + i) * stride];
+            projection *= 2;
+            for (unsigned i = 0; i < length; i++)
+                x[(reflector + i) * stride] -= projection * u[i];
+        }
+
+        /**
+        * @brief Applies the previous reflections to column l of H, computes the reflection that eliminates its
+        * subdiagonal elements and applies it to the least squares right hand sides.
+        */
+        void _triangularizeColumn(unsigned l, unsigned width) {
+            T* column = &_h(0, l);
+            for (unsigned i = 0; i < l; i++)
+                _reflect(i, column, 1);
+            //Maps x = column[l, l + length) to α e_1, α = -sign(x_0) ||x||
+            unsigned length = _reflectorLength(l);
+            T norm = 0;
+            for (unsigned i = 0; i < length; i++)
+                norm += column[l + i] * column[l + i];
+            norm = std::sqrt(norm);
+            T* u = _reflectors.data() + static_cast<size_t>(l) * 2 * _blockSize;
+            if (norm == 0)
+                return;
+            T alpha = column[l] >= 0 ? -norm : norm;
+            T scale = 1 / std::sqrt(2 * norm * (norm + std::abs(column[l])));
+            for (unsigned i = 0; i < length; i++)
+                u[i] = scale * column[l + i];
+            u[0] = scale * (column[l] - alpha);
+            column[l] = alpha;
+            for (unsigned i = 1; i < length; i++)
+                column[l + i] = 0;
+            for (unsigned c = 0; c < width; c++)
+                _reflect(l, &_g(0, c, width), width);
+        }
+
+        /**
+        * @brief Solves the triangular systems R y_c = g_c of the cycle and updates x_c = x_c + M^-1 V y_c.
+        */
+        void _updateSolution(unsigned steps, vector<vector<T>> &basis, unsigned width, const vector<unsigned> &active,
+                             unsigned k, vector<T> &solution) {
+            if (steps == 0)
+                return;
+            unsigned p = _blockSize;
+            unsigned size = steps * p;
+            vector<T> y(static_cast<size_t>(size) * width);
+            for (unsigned c = 0; c < width; c++)
+                for (unsigned i = size; i-- > 0;) {
+                    T sum = _g(i, c, width);
+                    for (unsigned l = i + 1; l < size; l++)
+                        sum -= _h(i, l) * y[static_cast<size_t>(l) * width + c];
+                    if (_h(i, i) == 0)
+                        throw runtime_error("Block GMRES breakdown: singular Hessenberg matrix.");
+                    y[static_cast<size_t>(i) * width + c] = sum / _h(i, i);
+                }
+            //U = Σ_j V_j Y_j, X = X + M^-1 U
+            unsigned n = static_cast<unsigned>(solution.size() / k);
+            vector<T> update(static_cast<size_t>(n) * width, 0), blockCoefficients(static_cast<size_t>(p) * width),
+                      preconditioned;
+            for (unsigned j = 0; j < steps; j++) {
+                std::copy(y.begin() + static_cast<size_t>(j) * p * width, y.begin() + static_cast<size_t>(j + 1) * p * width,
+                          blockCoefficients.begin());
+                this->_addProduct(update, width, nullptr, basis[j], p, blockCoefficients, width);
+            }
+            this->_preconditionBlock(update, preconditioned, width);
+            T* solutionData = solution.data();
+            const T* preconditionedData = preconditioned.data();
+            const unsigned* columns = active.data();
+            ThreadingOperations<T>::executeParallelJob([=](unsigned start, unsigned end) {
+                for (unsigned row = start; row < end; row++)
+                    for (unsigned c = 0; c < width; c++)
+                        solutionData[static_cast<size_t>(row) * k + columns[c]] +=
+                                preconditionedData[static_cast<size_t>(row) * width + c];
+            }, n, this->_availableThreads);
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_BLOCKGENERALIZEDMINIMALRESIDUAL_H
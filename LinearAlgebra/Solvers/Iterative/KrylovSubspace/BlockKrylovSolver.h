@@ -0,0 +1,639 @@
+//
+// Created by hal9000 on 11/4/23.
+//
+
+#ifndef UNTITLED_BLOCKKRYLOVSOLVER_H
+#define UNTITLED_BLOCKKRYLOVSOLVER_H
+
+#include "KrylovSolver.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Base class of the block Krylov solvers, which solve A X = B for k right hand sides of one operator together.
+    *
+    * The k columns of B and X are stored as row major n x k blocks, so the block kernels read each row of the operator
+    * once for all the columns: for a CSR matrix the product A P of an n x p block is one pass over the values and the
+    * column indices (SpMM), instead of p SpMVs. Other operators are applied column by column. The preconditioner is
+    * applied column by column.
+    *
+    * Every column converges on its own relative residual ||b_c - A x_c|| / ||b_c||. Converged columns are deflated,
+    * i.e. removed from the block, and the directions of the block that are numerically linearly dependent are dropped
+    * by a rank revealing orthonormalization, so identical, dependent or zero right hand sides do not break the
+    * recurrences. The recorded norm of an iteration (getResidualNorms()) is the largest relative residual of the columns.
+    * An iteration is one block product.
+    *
+    * The single right hand side solve() of KrylovSolver runs the same algorithm with a block of one column.
+    *
+    * @tparam T The datatype of the matrix and vector elements.
+    */
+    template<typename T>
+    class BlockKrylovSolver : public KrylovSolver<T> {
+    public:
+        explicit BlockKrylovSolver(double tolerance = 1E-9, unsigned maxIterations = 1E4,
+                                   bool throwExceptionOnMaxFailure = true, unsigned availableThreads = 1,
+                                   double deflationTolerance = 1E-6) :
+                KrylovSolver<T>(tolerance, maxIterations, throwExceptionOnMaxFailure, availableThreads),
+                _deflationTolerance(deflationTolerance), _blockProducts(0), _matrixVectorProducts(0),
+                _columnIn(0u), _columnOut(0u) { }
+
+        using KrylovSolver<T>::solve;
+
+        /**
+        * @brief Solves A x_c = b_c for all the columns c together. solutions hold the initial guesses on entry and the
+        * solutions on exit.
+        *
+        * @throws runtime_error If a column does not converge within the maximum iterations and
+        * throwExceptionOnMaxFailure is set.
+        */
+        void solve(LinearOperator<T> &matrix, vector<shared_ptr<NumericalVector<T>>> &rhs,
+                   vector<shared_ptr<NumericalVector<T>>> &solutions) {
+            if (matrix.numberOfRows() != matrix.numberOfColumns())
+                throw invalid_argument("Krylov solvers require a square operator.");
+            if (rhs.empty() || rhs.size() != solutions.size())
+                throw invalid_argument("The number of right hand sides and solutions must be equal and positive.");
+            unsigned n = matrix.numberOfRows();
+            for (unsigned c = 0; c < rhs.size(); c++)
+                if (rhs[c] == nullptr || solutions[c] == nullptr || rhs[c]->size() != n || solutions[c]->size() != n)
+                    throw invalid_argument("Vector size does not match the size of the operator.");
+            if (this->_preconditioner != nullptr && !this->_preconditioner->isSetUp())
+                throw runtime_error("The preconditioner is not set up.");
+            this->_iteration = 0;
+            this->_exitNorm = 0;
+            this->_converged = false;
+            this->_residualNorms->clear();
+            unsigned k = static_cast<unsigned>(rhs.size());
+            vector<T> rhsBlock(static_cast<size_t>(n) * k), solutionBlock(static_cast<size_t>(n) * k);
+            for (unsigned c = 0; c < k; c++) {
+                _scatterColumn(*rhs[c], rhsBlock.data(), k, c);
+                _scatterColumn(*solutions[c], solutionBlock.data(), k, c);
+            }
+            auto start = std::chrono::high_resolution_clock::now();
+            _runBlock(matrix, rhsBlock, solutionBlock, k);
+            auto end = std::chrono::high_resolution_clock::now();
+            this->_solutionTime = std::chrono::duration<double, std::milli>(end - start).count();
+            for (unsigned c = 0; c < k; c++)
+                _gatherColumn(solutionBlock.data(), k, c, *solutions[c]);
+            if (!this->_converged && this->_throwExceptionOnMaxFailure)
+                throw runtime_error(this->_solverName + " did not converge in " + to_string(this->_iteration) +
+                                    " iterations. Largest relative residual: " + to_string(this->_exitNorm));
+        }
+
+        /**
+        * @brief Solves A x_c = b_c for an assembled matrix. CSR matrices are multiplied with the block SpMM kernel.
+        */
+        void solve(const shared_ptr<NumericalMatrix<T>> &matrix, vector<shared_ptr<NumericalVector<T>>> &rhs,
+                   vector<shared_ptr<NumericalVector<T>>> &solutions) {
+            NumericalMatrixOperator<T> matrixOperator(matrix, this->_availableThreads);
+            solve(matrixOperator, rhs, solutions);
+        }
+
+        /**
+        * @brief Sets the relative size below which a direction of a block is considered linearly dependent on the
+        * others and is dropped, in units of the largest column norm of the block.
+        */
+        void setDeflationTolerance(double deflationTolerance) {
+            _deflationTolerance = deflationTolerance;
+        }
+
+        double getDeflationTolerance() const {
+            return _deflationTolerance;
+        }
+
+        /**
+        * @brief Returns the number of passes over the operator of the last solve(), the initial residual included.
+        */
+        unsigned getBlockProducts() const {
+            return _blockProducts;
+        }
+
+        /**
+        * @brief Returns the number of matrix-vector products of the last solve(), i.e. the sum of the block widths.
+        */
+        unsigned getMatrixVectorProducts() const {
+            return _matrixVectorProducts;
+        }
+
+        /**
+        * @brief Returns the iteration at which each column converged, or the last iteration of an unconverged column.
+        */
+        const vector<unsigned> &getColumnIterations() const {
+            return _columnIterations;
+        }
+
+        /**
+        * @brief Returns the last relative residual norm of each column.
+        */
+        const vector<double> &getColumnExitNorms() const {
+            return _columnExitNorms;
+        }
+
+    protected:
+        double _deflationTolerance;
+
+        unsigned _blockProducts;
+
+        unsigned _matrixVectorProducts;
+
+        vector<unsigned> _columnIterations;
+
+        vector<double> _columnExitNorms;
+
+        //||b_c||, or 1 if b_c = 0
+        vector<double> _referenceNorms;
+
+        /**
+        * @brief Solves A X = B for the n x k row major blocks B and X. X holds the initial guess on entry.
+        */
+        virtual void _solveBlock(LinearOperator<T> &matrix, vector<T> &rhs, vector<T> &solution, unsigned k) = 0;
+
+        void _solve(LinearOperator<T> &matrix, NumericalVector<T> &rhs, NumericalVector<T> &solution) override {
+            unsigned n = rhs.size();
+            vector<T> rhsBlock(rhs.getDataPointer(), rhs.getDataPointer() + n);
+            vector<T> solutionBlock(solution.getDataPointer(), solution.getDataPointer() + n);
+            _runBlock(matrix, rhsBlock, solutionBlock, 1);
+            std::copy(solutionBlock.begin(), solutionBlock.end(), solution.getDataPointer());
+        }
+
+        /**
+        * @brief Records the relative residual norms of the active columns at the current iteration and the largest
+        * norm of all the columns.
+        * @return true if all the columns satisfy the tolerance.
+        */
+        bool _recordResiduals(const vector<unsigned> &active, const vector<double> &relativeNorms) {
+            for (unsigned j = 0; j < active.size(); j++) {
+                _columnExitNorms[active[j]] = relativeNorms[j];
+                _columnIterations[active[j]] = this->_iteration;
+            }
+            return this->_recordResidual(*std::max_element(_columnExitNorms.begin(), _columnExitNorms.end()));
+        }
+
+        /**
+        * @brief Removes the converged columns from the active columns and from the n x width row major blocks.
+        * @return The number of remaining active columns.
+        */
+        unsigned _deflateConverged(vector<unsigned> &active, const vector<vector<T>*> &blocks) {
+            vector<unsigned> kept;
+            for (unsigned j = 0; j < active.size(); j++)
+                if (!(_columnExitNorms[active[j]] <= this->_tolerance))
+                    kept.push_back(j);
+            if (kept.size() < active.size())
+                for (auto block : blocks)
+                    _selectColumns(*block, static_cast<unsigned>(active.size()), kept);
+            vector<unsigned> remaining;
+            for (auto j : kept)
+                remaining.push_back(active[j]);
+            active = remaining;
+            return static_cast<unsigned>(active.size());
+        }
+
+        /**
+        * @brief Y = A X for n x width row major blocks. For a CSR matrix every row of A is read once for all the columns.
+        *
+        * The row kernels of the block operations capture pointers and sizes by value, so that the stores to the blocks
+        * cannot alias them and they stay in registers.
+        */
+        void _multiplyBlock(LinearOperator<T> &matrix, const vector<T> &x, vector<T> &y, unsigned width) {
+            unsigned n = matrix.numberOfRows();
+            y.resize(static_cast<size_t>(n) * width);
+            _blockProducts++;
+            _matrixVectorProducts += width;
+            this->_telemetry->countMatrixVectorProducts(width);
+            if (width == 0)
+                return;
+            auto matrixOperator = dynamic_cast<NumericalMatrixOperator<T>*>(&matrix);
+            if (matrixOperator != nullptr && matrixOperator->getMatrix()->dataStorage->getStorageType() == CSR) {
+                auto &storage = matrixOperator->getMatrix()->dataStorage;
+                const T* values = storage->getValuesDataPointer();
+                auto supplementaryDataPointers = storage->getSupplementaryDataPointers();
+                const unsigned* columnIndices = supplementaryDataPointers[0];
+                const unsigned* rowOffsets = supplementaryDataPointers[1];
+                const T* xData = x.data();
+                T* yData = y.data();
+                ThreadingOperations<T>::executeParallelJob([=](unsigned start, unsigned end) {
+                    //The row is read from memory once, its tiles of columns from the cache
+                    for (unsigned row = start; row < end; row++) {
+                        unsigned column = 0;
+                        for (; column + 8 <= width; column += 8)
+                            _multiplyRowTile<8>(values, columnIndices, rowOffsets, row, xData, yData, width, column);
+                        if (column + 4 <= width) {
+                            _multiplyRowTile<4>(values, columnIndices, rowOffsets, row, xData, yData, width, column);
+                            column += 4;
+                        }
+                        if (column + 2 <= width) {
+                            _multiplyRowTile<2>(values, columnIndices, rowOffsets, row, xData, yData, width, column);
+                            column += 2;
+                        }
+                        if (column < width)
+                            _multiplyRowTile<1>(values, columnIndices, rowOffsets, row, xData, yData, width, column);
+                    }
+                }, n, this->_availableThreads);
+                return;
+            }
+            _columnIn.resize(n);
+            _columnOut.resize(n);
+            for (unsigned c = 0; c < width; c++) {
+                _gatherColumn(x.data(), width, c, _columnIn);
+                matrix.multiply(_columnIn, _columnOut);
+                _scatterColumn(_columnOut, y.data(), width, c);
+            }
+        }
+
+        /**
+        * @brief Z = M^-1 R column by column, or Z = R without a preconditioner.
+        */
+        void _preconditionBlock(const vector<T> &r, vector<T> &z, unsigned width) {
+            z.resize(r.size());
+            if (this->_preconditioner == nullptr) {
+                std::copy(r.begin(), r.end(), z.begin());
+                return;
+            }
+            unsigned n = width > 0 ? static_cast<unsigned>(r.size() / width) : 0;
+            _columnIn.resize(n);
+            _columnOut.resize(n);
+            for (unsigned c = 0; c < width; c++) {
+                _gatherColumn(r.data(), width, c, _columnIn);
+                this->_preconditioner->apply(_columnIn, _columnOut);
+                _scatterColumn(_columnOut, z.data(), width, c);
+            }
+        }
+
+        /**
+        * @brief G = X^T Y, xWidth x yWidth row major, in one pass over the rows of the n x xWidth and n x yWidth blocks.
+        */
+        void _gram(const vector<T> &x, unsigned xWidth, const vector<T> &y, unsigned yWidth, vector<T> &gram) {
+            gram.assign(static_cast<size_t>(xWidth) * yWidth, 0);
+            if (xWidth == 0 || yWidth == 0)
+                return;
+            const T* xData = x.data();
+            const T* yData = y.data();
+            _reduceRows(static_cast<unsigned>(x.size() / xWidth), gram, [=](unsigned start, unsigned end, T* partial) {
+                for (unsigned tile = start; tile < end; tile += _rowTile) {
+                    unsigned rows = std::min(static_cast<unsigned>(_rowTile), end - tile);
+                    const T* xTile = xData + static_cast<size_t>(tile) * xWidth;
+                    const T* yTile = yData + static_cast<size_t>(tile) * yWidth;
+                    //4 x 4 tiles of G accumulated in registers, the remainders with strided dot products
+                    unsigned i = 0;
+                    for (; i + 4 <= xWidth; i += 4) {
+                        unsigned j = 0;
+                        for (; j + 4 <= yWidth; j += 4)
+                            _gramTile(xTile + i, xWidth, yTile + j, yWidth, rows, partial + i * yWidth + j, yWidth);
+                        for (; j < yWidth; j++)
+                            for (unsigned l = i; l < i + 4; l++)
+                                partial[l * yWidth + j] += _stridedDot(xTile + l, xWidth, yTile + j, yWidth, rows);
+                    }
+                    for (; i < xWidth; i++)
+                        for (unsigned j = 0; j < yWidth; j++)
+                            partial[i * yWidth + j] += _stridedDot(xTile + i, xWidth, yTile + j, yWidth, rows);
+                }
+            });
+        }
+
+        /**
+        * @brief The 2-norms of the columns of an n x width block divided by the reference norms of the active columns.
+        */
+        vector<double> _relativeColumnNorms(const vector<T> &block, unsigned width, const vector<unsigned> &active) {
+            vector<T> squares(width, 0);
+            const T* data = block.data();
+            if (width > 0)
+                _reduceRows(static_cast<unsigned>(block.size() / width), squares, [=](unsigned start, unsigned end, T* partial) {
+                    for (unsigned tile = start; tile < end; tile += _rowTile) {
+                        const T* rows = data + static_cast<size_t>(tile) * width;
+                        for (unsigned j = 0; j < width; j++)
+                            partial[j] += _stridedDot(rows + j, width, rows + j, width, std::min(static_cast<unsigned>(_rowTile), end - tile));
+                    }
+                });
+            vector<double> norms(width);
+            for (unsigned j = 0; j < width; j++)
+                norms[j] = std::sqrt(static_cast<double>(squares[j])) / _referenceNorms[active[j]];
+            return norms;
+        }
+
+        /**
+        * @brief Y[:, yColumns[j]] += scale Σ_i X[:, i] C(i, j) for the columns j < columns of the xWidth x columns row
+        * major matrix C. Y has yWidth columns, yColumns = nullptr maps j to j.
+        */
+        void _addProduct(vector<T> &y, unsigned yWidth, const unsigned* yColumns, const vector<T> &x, unsigned xWidth,
+                         const vector<T> &c, unsigned columns, T scale = 1) {
+            if (xWidth == 0 || columns == 0)
+                return;
+            unsigned n = static_cast<unsigned>(x.size() / xWidth);
+            vector<T> scaled(static_cast<size_t>(xWidth) * columns);
+            vector<unsigned> targets(columns);
+            for (unsigned j = 0; j < columns; j++)
+                targets[j] = yColumns != nullptr ? yColumns[j] : j;
+            for (unsigned i = 0; i < scaled.size(); i++)
+                scaled[i] = scale * c[i];
+            const T* xData = x.data();
+            const T* cData = scaled.data();
+            const unsigned* targetData = targets.data();
+            T* yData = y.data();
+            ThreadingOperations<T>::executeParallelJob([=](unsigned start, unsigned end) {
+                for (unsigned row = start; row < end; row++) {
+                    const T* xRow = xData + static_cast<size_t>(row) * xWidth;
+                    T* yRow = yData + static_cast<size_t>(row) * yWidth;
+                    //Four columns of the row at a time, accumulated in registers
+                    unsigned j = 0;
+                    for (; j + 4 <= columns; j += 4) {
+                        T sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+                        for (unsigned i = 0; i < xWidth; i++) {
+                            T value = xRow[i];
+                            const T* cRow = cData + i * columns + j;
+                            sum0 += value * cRow[0];
+                            sum1 += value * cRow[1];
+                            sum2 += value * cRow[2];
+                            sum3 += value * cRow[3];
+                        }
+                        yRow[targetData[j]] += sum0;
+                        yRow[targetData[j + 1]] += sum1;
+                        yRow[targetData[j + 2]] += sum2;
+                        yRow[targetData[j + 3]] += sum3;
+                    }
+                    for (; j < columns; j++) {
+                        T sum = 0;
+                        for (unsigned i = 0; i < xWidth; i++)
+                            sum += xRow[i] * cData[i * columns + j];
+                        yRow[targetData[j]] += sum;
+                    }
+                }
+            }, n, this->_availableThreads);
+        }
+
+        /**
+        * @brief Rank revealing orthonormalization W = Q R of an n x width block with Cholesky QR with diagonal pivoting.
+        * W is replaced by the n x rank block Q with orthonormal columns and R is rank x width row major. Directions whose
+        * norm orthogonal to the kept ones is below the deflation tolerance times the largest column norm are dropped.
+        *
+        * Cholesky QR loses orthogonality as ε κ(W)², so a second pass (CholQR2) reorthogonalizes Q when the pivots of
+        * the first one spread over more than two orders of magnitude.
+        * @return The rank.
+        */
+        unsigned _orthonormalize(vector<T> &w, unsigned width, vector<T> &r) {
+            vector<T> firstFactor, secondFactor;
+            T spread;
+            unsigned rank = _choleskyQR(w, width, firstFactor, spread);
+            if (!(spread > 100)) {
+                r.swap(firstFactor);
+                return rank;
+            }
+            unsigned secondRank = _choleskyQR(w, rank, secondFactor, spread);
+            //R = R2 R1
+            r.assign(static_cast<size_t>(secondRank) * width, 0);
+            for (unsigned i = 0; i < secondRank; i++)
+                for (unsigned l = 0; l < rank; l++)
+                    for (unsigned j = 0; j < width; j++)
+                        r[i * width + j] += secondFactor[i * rank + l] * firstFactor[l * width + j];
+            return secondRank;
+        }
+
+        /**
+        * @brief In place Cholesky factorization A = L L^T of a size x size row major SPD matrix, L in the lower triangle.
+        * @return false if A is not numerically positive definite.
+        */
+        static bool _cholesky(vector<T> &a, unsigned size) {
+            for (unsigned j = 0; j < size; j++) {
+                T diagonal = a[j * size + j];
+                for (unsigned l = 0; l < j; l++)
+                    diagonal -= a[j * size + l] * a[j * size + l];
+                if (!(diagonal > 0))
+                    return false;
+                diagonal = std::sqrt(diagonal);
+                a[j * size + j] = diagonal;
+                for (unsigned i = j + 1; i < size; i++) {
+                    T sum = a[i * size + j];
+                    for (unsigned l = 0; l < j; l++)
+                        sum -= a[i * size + l] * a[j * size + l];
+                    a[i * size + j] = sum / diagonal;
+                }
+            }
+            return true;
+        }
+
+        /**
+        * @brief B = L^-T L^-1 B for the size x columns row major B with the factor of _cholesky().
+        */
+        static void _choleskySolve(const vector<T> &factor, unsigned size, vector<T> &b, unsigned columns) {
+            for (unsigned c = 0; c < columns; c++) {
+                for (unsigned i = 0; i < size; i++) {
+                    T sum = b[i * columns + c];
+                    for (unsigned l = 0; l < i; l++)
+                        sum -= factor[i * size + l] * b[l * columns + c];
+                    b[i * columns + c] = sum / factor[i * size + i];
+                }
+                for (unsigned i = size; i-- > 0;) {
+                    T sum = b[i * columns + c];
+                    for (unsigned l = i + 1; l < size; l++)
+                        sum -= factor[l * size + i] * b[l * columns + c];
+                    b[i * columns + c] = sum / factor[i * size + i];
+                }
+            }
+        }
+
+        /**
+        * @brief Keeps the columns kept (ascending) of an n x width row major block.
+        */
+        static void _selectColumns(vector<T> &block, unsigned width, const vector<unsigned> &kept) {
+            if (width == 0)
+                return;
+            size_t n = block.size() / width;
+            unsigned newWidth = static_cast<unsigned>(kept.size());
+            //In place, every row moves to a position before or at its old one
+            for (size_t row = 0; row < n; row++)
+                for (unsigned j = 0; j < newWidth; j++)
+                    block[row * newWidth + j] = block[row * width + kept[j]];
+            block.resize(n * newWidth);
+        }
+
+        static void _gatherColumn(const T* block, unsigned width, unsigned column, NumericalVector<T> &vector) {
+            T* data = vector.getDataPointer();
+            for (unsigned i = 0; i < vector.size(); i++)
+                data[i] = block[static_cast<size_t>(i) * width + column];
+        }
+
+        static void _scatterColumn(NumericalVector<T> &vector, T* block, unsigned width, unsigned column) {
+            const T* data = vector.getDataPointer();
+            for (unsigned i = 0; i < vector.size(); i++)
+                block[static_cast<size_t>(i) * width + column] = data[i];
+        }
+
+    private:
+        //Rows of the blocks whose columns are reduced together, small enough to stay in the L1 cache
+        static constexpr unsigned _rowTile = 64;
+
+        //Work vectors of the operators and preconditioners applied column by column
+        NumericalVector<T> _columnIn;
+
+        NumericalVector<T> _columnOut;
+
+        vector<T> _orthonormalBlock;
+
+        void _runBlock(LinearOperator<T> &matrix, vector<T> &rhs, vector<T> &solution, unsigned k) {
+            _blockProducts = 0;
+            _matrixVectorProducts = 0;
+            _columnIterations.assign(k, 0);
+            _columnExitNorms.assign(k, 0);
+            _referenceNorms.assign(k, 1);
+            vector<unsigned> all(k);
+            for (unsigned c = 0; c < k; c++)
+                all[c] = c;
+            vector<double> norms = _relativeColumnNorms(rhs, k, all);
+            for (unsigned c = 0; c < k; c++)
+                _referenceNorms[c] = norms[c] > 0 ? norms[c] : 1;
+            _solveBlock(matrix, rhs, solution, k);
+        }
+
+        /**
+        * @brief y(row, column : column + W) = A(row, :) x(:, column : column + W), accumulated in registers.
+        */
+        template<unsigned W>
+        static void _multiplyRowTile(const T* values, const unsigned* columnIndices, const unsigned* rowOffsets,
+                                     unsigned row, const T* x, T* y, unsigned width, unsigned column) {
+            T sums[W] = {};
+            for (unsigned k = rowOffsets[row]; k < rowOffsets[row + 1]; k++) {
+                T value = values[k];
+                const T* xRow = x + static_cast<size_t>(columnIndices[k]) * width + column;
+                for (unsigned c = 0; c < W; c++)
+                    sums[c] += value * xRow[c];
+            }
+            T* yRow = y + static_cast<size_t>(row) * width + column;
+            for (unsigned c = 0; c < W; c++)
+                yRow[c] = sums[c];
+        }
+
+        /**
+        * @brief G(i, j) += Σ_r x[r xStride + i] y[r yStride + j] for i, j < 4 and r < rows.
+        */
+        static void _gramTile(const T* x, size_t xStride, const T* y, size_t yStride, unsigned rows, T* gram,
+                              unsigned gramWidth) {
+            T sums[4][4] = {};
+            for (unsigned r = 0; r < rows; r++) {
+                const T* xRow = x + r * xStride;
+                const T* yRow = y + r * yStride;
+                for (unsigned i = 0; i < 4; i++)
+                    for (unsigned j = 0; j < 4; j++)
+                        sums[i][j] += xRow[i] * yRow[j];
+            }
+            for (unsigned i = 0; i < 4; i++)
+                for (unsigned j = 0; j < 4; j++)
+                    gram[i * gramWidth + j] += sums[i][j];
+        }
+
+        /**
+        * @brief Σ_r x[r xStride] y[r yStride] for r < count, with four independent partial sums.
+        */
+        static T _stridedDot(const T* x, size_t xStride, const T* y, size_t yStride, unsigned count) {
+            T sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+            unsigned r = 0;
+            for (; r + 4 <= count; r += 4) {
+                sum0 += x[r * xStride] * y[r * yStride];
+                sum1 += x[(r + 1) * xStride] * y[(r + 1) * yStride];
+                sum2 += x[(r + 2) * xStride] * y[(r + 2) * yStride];
+                sum3 += x[(r + 3) * xStride] * y[(r + 3) * yStride];
+            }
+            for (; r < count; r++)
+                sum0 += x[r * xStride] * y[r * yStride];
+            return (sum0 + sum1) + (sum2 + sum3);
+        }
+
+        /**
+        * @brief Adds to result the sums job(start, end, partial) accumulates over the rows [0, n), with one chunk of rows
+        * and one zero initialized partial sum of the size of result per thread.
+        */
+        template<typename RowJob>
+        void _reduceRows(unsigned n, vector<T> &result, RowJob job) {
+            this->_telemetry->countReductions();
+            unsigned chunks = std::max(1u, std::min(this->_availableThreads, n));
+            vector<vector<T>> partials(chunks, vector<T>(result.size(), 0));
+            ThreadingOperations<T>::executeParallelJob([&](unsigned startChunk, unsigned endChunk) {
+                for (unsigned chunk = startChunk; chunk < endChunk; chunk++)
+                    job(static_cast<unsigned>(static_cast<size_t>(n) * chunk / chunks),
+                        static_cast<unsigned>(static_cast<size_t>(n) * (chunk + 1) / chunks), partials[chunk].data());
+            }, chunks, this->_availableThreads, sizeof(T));
+            for (auto &partial : partials)
+                for (unsigned i = 0; i < result.size(); i++)
+                    result[i] += partial[i];
+        }
+
+        /**
+        * @brief One pass of Cholesky QR with diagonal pivoting, see _orthonormalize(). spread is set to the ratio of the
+        * largest to the smallest pivot of R.
+        */
+        unsigned _choleskyQR(vector<T> &w, unsigned width, vector<T> &r, T &spread) {
+            vector<T> gram;
+            _gram(w, width, w, width, gram);
+            vector<unsigned> pivots(width);
+            for (unsigned j = 0; j < width; j++)
+                pivots[j] = j;
+            T largest = 0;
+            for (unsigned j = 0; j < width; j++)
+                largest = std::max(largest, gram[j * width + j]);
+            T threshold = static_cast<T>(_deflationTolerance * _deflationTolerance) * largest;
+            //Outer product Cholesky of the symmetrically permuted Gram matrix, L in its lower triangle
+            unsigned rank = 0;
+            while (rank < width) {
+                unsigned pivot = rank;
+                for (unsigned j = rank + 1; j < width; j++)
+                    if (gram[j * width + j] > gram[pivot * width + pivot])
+                        pivot = j;
+                if (!(gram[pivot * width + pivot] > threshold) || largest == 0)
+                    break;
+                if (pivot != rank) {
+                    for (unsigned j = 0; j < width; j++)
+                        std::swap(gram[rank * width + j], gram[pivot * width + j]);
+                    for (unsigned i = 0; i < width; i++)
+                        std::swap(gram[i * width + rank], gram[i * width + pivot]);
+                    std::swap(pivots[rank], pivots[pivot]);
+                }
+                T diagonal = std::sqrt(gram[rank * width + rank]);
+                gram[rank * width + rank] = diagonal;
+                for (unsigned i = rank + 1; i < width; i++)
+                    gram[i * width + rank] /= diagonal;
+                for (unsigned i = rank + 1; i < width; i++)
+                    for (unsigned j = rank + 1; j <= i; j++) {
+                        gram[i * width + j] -= gram[i * width + rank] * gram[j * width + rank];
+                        gram[j * width + i] = gram[i * width + j];
+                    }
+                rank++;
+            }
+            //R(i, pivots[j]) = L(j, i) for j >= i
+            r.assign(static_cast<size_t>(rank) * width, 0);
+            for (unsigned i = 0; i < rank; i++)
+                for (unsigned j = i; j < width; j++)
+                    r[i * width + pivots[j]] = gram[j * width + i];
+            unsigned n = width > 0 ? static_cast<unsigned>(w.size() / width) : 0;
+            //R1 in pivot order, with the inverted diagonal
+            vector<T> triangle(static_cast<size_t>(rank) * rank, 0);
+            spread = 1;
+            for (unsigned i = 0; i < rank; i++) {
+                for (unsigned l = 0; l < i; l++)
+                    triangle[l * rank + i] = r[l * width + pivots[i]];
+                triangle[i * rank + i] = 1 / r[i * width + pivots[i]];
+                spread = std::max(spread, r[pivots[0]] * triangle[i * rank + i]);
+            }
+            //Q = W(:, pivots[0, rank)) R1^-1 row by row
+            _orthonormalBlock.resize(static_cast<size_t>(n) * rank);
+            const T* wData = w.data();
+            T* qData = _orthonormalBlock.data();
+            const unsigned* pivotData = pivots.data();
+            const T* triangleData = triangle.data();
+            ThreadingOperations<T>::executeParallelJob([=](unsigned start, unsigned end) {
+                for (unsigned row = start; row < end; row++) {
+                    const T* wRow = wData + static_cast<size_t>(row) * width;
+                    T* qRow = qData + static_cast<size_t>(row) * rank;
+                    for (unsigned i = 0; i < rank; i++) {
+                        T sum = wRow[pivotData[i]];
+                        for (unsigned l = 0; l < i; l++)
+                            sum -= qRow[l] * triangleData[l * rank + i];
+                        qRow[i] = sum * triangleData[i * rank + i];
+                    }
+                }
+            }, n, this->_availableThreads);
+            //The storage of W becomes the buffer of the next call
+            w.swap(_orthonormalBlock);
+            return rank;
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_BLOCKKRYLOVSOLVER_H
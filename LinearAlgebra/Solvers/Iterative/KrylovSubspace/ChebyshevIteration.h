@@ -0,0 +1,205 @@
+//
+// Created by hal9000 on 11/8/23.
+//
+
+#ifndef UNTITLED_CHEBYSHEVITERATION_H
+#define UNTITLED_CHEBYSHEVITERATION_H
+
+#include "KrylovSolver.h"
+#include "../../../EigenDecomposition/SpectralBoundsEstimator.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Preconditioned Chebyshev iteration for symmetric positive definite operators and preconditioners.
+    *
+    * Given bounds [λmin, λmax] of the spectrum of M^-1 A, the residual polynomial of iteration k is the scaled
+    * Chebyshev polynomial of the interval, computed with the three term recurrence
+    *   x = x + d, r = r - A d, d = ρ_k ρ_{k-1} d + 2 ρ_k / δ M^-1 r, ρ_k = 1 / (2 σ - ρ_{k-1}),
+    * with θ and δ the center and the half width of the interval and σ = θ / δ. It converges like CG with the
+    * worst case spectrum, O(√κ) iterations, but needs no inner products: the only global reductions are the residual
+    * norms of the convergence checks, every residualCheckFrequency iterations. This makes it attractive when the
+    * reductions dominate, e.g. many threads on small systems.
+    *
+    * Unless fixed with setSpectralBounds(), the bounds are estimated by a SpectralBoundsEstimator (Lanczos by default)
+    * before the first solve of an operator and kept in a SpectralBoundsCache for the next solves of the same operator
+    * and preconditioner. The estimate is counted in the telemetry. The estimated λmax is multiplied by the upper
+    * factor, an interval that misses the top of the spectrum makes the iteration diverge, while a λmin above the
+    * bottom of the spectrum only slows it down.
+    */
+    template<typename T>
+    class ChebyshevIteration : public KrylovSolver<T> {
+    public:
+        /**
+        * @param residualCheckFrequency The iterations between two residual norms (convergence checks).
+        */
+        explicit ChebyshevIteration(double tolerance = 1E-9, unsigned maxIterations = 1E4, bool throwExceptionOnMaxFailure = true,
+                                    unsigned availableThreads = 1, unsigned residualCheckFrequency = 10) :
+                KrylovSolver<T>(tolerance, maxIterations, throwExceptionOnMaxFailure, availableThreads),
+                _residualCheckFrequency(std::max(1u, residualCheckFrequency)), _upperFactor(1.05), _fixedBounds(false),
+                _bounds({0, 0, 0, 0}), _estimator(make_shared<SpectralBoundsEstimator<T>>()),
+                _cache(make_shared<SpectralBoundsCache<T>>()), _estimationSteps(0) {
+            this->_solverName = "Chebyshev Iteration";
+        }
+
+        void setResidualCheckFrequency(unsigned residualCheckFrequency) {
+            _residualCheckFrequency = std::max(1u, residualCheckFrequency);
+        }
+
+        unsigned getResidualCheckFrequency() const {
+            return _residualCheckFrequency;
+        }
+
+        /**
+        * @brief Fixes the bounds of the spectrum of M^-1 A for the next solves, e.g. known analytically. They are used
+        * as given, without the upper factor.
+        * @throws invalid_argument If not 0 < minimum < maximum.
+        */
+        void setSpectralBounds(double minimum, double maximum) {
+            if (!(minimum > 0 && minimum < maximum))
+                throw invalid_argument("The Chebyshev iteration requires 0 < minimum < maximum.");
+            _bounds = {minimum, maximum, 0, 0};
+            _fixedBounds = true;
+        }
+
+        /**
+        * @brief Returns to the estimated bounds.
+        */
+        void clearSpectralBounds() {
+            _fixedBounds = false;
+        }
+
+        /**
+        * @brief The bounds of the last solve, after the upper factor.
+        */
+        const SpectralBounds &getSpectralBounds() const {
+            return _bounds;
+        }
+
+        /**
+        * @brief Sets the safety factor of the estimated λmax. Default 1.05.
+        * @throws invalid_argument If upperFactor <= 1.
+        */
+        void setUpperFactor(double upperFactor) {
+            if (!(upperFactor > 1))
+                throw invalid_argument("The upper factor must be greater than 1.");
+            _upperFactor = upperFactor;
+        }
+
+        /**
+        * @throws invalid_argument If estimator is null.
+        */
+        void setBoundsEstimator(shared_ptr<SpectralBoundsEstimator<T>> estimator) {
+            if (estimator == nullptr)
+                throw invalid_argument("The spectral bounds estimator cannot be null.");
+            _estimator = std::move(estimator);
+        }
+
+        /**
+        * @brief Shares a cache between solvers and smoothers.
+        * @throws invalid_argument If cache is null.
+        */
+        void setBoundsCache(shared_ptr<SpectralBoundsCache<T>> cache) {
+            if (cache == nullptr)
+                throw invalid_argument("The spectral bounds cache cannot be null.");
+            _cache = std::move(cache);
+        }
+
+        const shared_ptr<SpectralBoundsCache<T>> &getBoundsCache() const {
+            return _cache;
+        }
+
+        /**
+        * @brief The operator applications of the estimate of the last solve, 0 if the bounds were fixed or cached.
+        */
+        unsigned getEstimationSteps() const {
+            return _estimationSteps;
+        }
+
+    protected:
+        void _solve(LinearOperator<T> &matrix, NumericalVector<T> &rhs, NumericalVector<T> &solution) override {
+            unsigned n = rhs.size();
+            unsigned threads = this->_availableThreads;
+            _updateBounds(matrix);
+            NumericalVector<T> residual(n, 0, threads), preconditioned(n, 0, threads),
+                               direction(n, 0, threads), matrixTimesDirection(n, 0, threads);
+            double referenceNorm = this->_referenceNorm(rhs);
+
+            //r = b - A x
+            this->_multiply(matrix, solution, matrixTimesDirection);
+            rhs.subtract(matrixTimesDirection, residual, 1, 1, threads);
+            if (this->_recordResidual(std::sqrt(this->_dot(residual, residual)) / referenceNorm))
+                return;
+            double center = 0.5 * (_bounds.maximum + _bounds.minimum), halfWidth = 0.5 * (_bounds.maximum - _bounds.minimum);
+            double sigma = center / halfWidth, rho = 1 / sigma;
+            //d = M^-1 r / θ
+            this->_applyPreconditioner(residual, preconditioned);
+            direction.add(preconditioned, direction, 0, static_cast<T>(1 / center), threads);
+
+            while (this->_iteration < this->_maxIterations) {
+                this->_iteration++;
+                //x = x + d, r = r - A d
+                solution.addIntoThis(direction, 1, 1, threads);
+                this->_multiply(matrix, direction, matrixTimesDirection);
+                residual.subtractIntoThis(matrixTimesDirection, 1, 1, threads);
+                if (this->_iteration % _residualCheckFrequency == 0 || this->_iteration == this->_maxIterations)
+                    if (this->_recordResidual(std::sqrt(this->_dot(residual, residual)) / referenceNorm))
+                        return;
+
+                this->_applyPreconditioner(residual, preconditioned);
+                double nextRho = 1 / (2 * sigma - rho);
+                direction.addIntoThis(preconditioned, static_cast<T>(nextRho * rho), static_cast<T>(2 * nextRho / halfWidth), threads);
+                rho = nextRho;
+            }
+        }
+
+    private:
+        unsigned _residualCheckFrequency;
+
+        double _upperFactor;
+
+        bool _fixedBounds;
+
+        SpectralBounds _bounds;
+
+        shared_ptr<SpectralBoundsEstimator<T>> _estimator;
+
+        shared_ptr<SpectralBoundsCache<T>> _cache;
+
+        unsigned _estimationSteps;
+
+        /**
+        * @brief Takes the bounds of M^-1 A from the cache, or estimates and caches them. An assembled matrix is
+        * cached as the matrix, so that the operators built by solve() for the same matrix share the entry.
+        */
+        void _updateBounds(LinearOperator<T> &matrix) {
+            _estimationSteps = 0;
+            if (_fixedBounds)
+                return;
+            auto matrixOperator = dynamic_cast<NumericalMatrixOperator<T> *>(&matrix);
+            unsigned long preconditionerIdentity = SpectralBoundsCache<T>::identity(this->_preconditioner.get());
+            const SpectralBounds *cached = matrixOperator != nullptr ?
+                                           _cache->find(matrixOperator->getMatrix(), preconditionerIdentity) :
+                                           _cache->find(matrix, preconditionerIdentity);
+            SpectralBounds bounds;
+            if (cached != nullptr)
+                bounds = *cached;
+            else {
+                _estimator->setAvailableThreads(this->_availableThreads);
+                bounds = _estimator->estimate(matrix, this->_preconditioner.get());
+                _estimationSteps = bounds.steps;
+                this->_telemetry->countMatrixVectorProducts(bounds.steps);
+                this->_telemetry->countReductions(bounds.reductions);
+                if (matrixOperator != nullptr)
+                    _cache->store(matrixOperator->getMatrix(), preconditionerIdentity, bounds);
+                else
+                    _cache->store(matrix, preconditionerIdentity, bounds);
+            }
+            _bounds = bounds;
+            _bounds.maximum *= _upperFactor;
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_CHEBYSHEVITERATION_H
@@ -0,0 +1,314 @@
+//
+// Created by hal9000 on 10/29/23.
+//
+
+#ifndef UNTITLED_GENERALIZEDMINIMALRESIDUAL_H
+#define UNTITLED_GENERALIZEDMINIMALRESIDUAL_H
+
+#include "KrylovSolver.h"
+
+namespace LinearAlgebra {
+
+    enum ArnoldiOrthogonalization {
+        ModifiedGramSchmidtArnoldi,
+        HouseholderArnoldi
+    };
+
+    /**
+    * @brief Restarted GMRES(m) with right preconditioning for general (non-symmetric) operators.
+    *
+    * Each cycle builds an orthonormal basis V of the Krylov subspace of A M^-1 with at most m Arnoldi steps and
+    * minimizes ||b - A (x0 + M^-1 V y)|| over y with Givens rotations on the Hessenberg matrix. Right preconditioning
+    * keeps the minimized residual the true (unpreconditioned) residual, so the recorded norm of every Arnoldi step is
+    * the relative residual of the iterate it defines. At the end of a cycle the residual is recomputed from b - A x,
+    * replaces the estimate of the last step and, if it is not converged, restarts the next cycle.
+    *
+    * The basis is orthogonalized with modified Gram-Schmidt or with Householder reflections (Walker). Householder
+    * Arnoldi costs about twice the vector operations, but keeps the basis orthogonal to machine precision for
+    * ill-conditioned operators where modified Gram-Schmidt loses orthogonality.
+    *
+    * All the work vectors, the basis and the Hessenberg matrix are allocated once per solve().
+    * An iteration is one Arnoldi step, i.e. one multiplication with A and one application of M^-1.
+    */
+    template<typename T>
+    class GeneralizedMinimalResidual : public KrylovSolver<T> {
+    public:
+        explicit GeneralizedMinimalResidual(double tolerance = 1E-9, unsigned maxIterations = 1E4,
+                                            bool throwExceptionOnMaxFailure = true, unsigned availableThreads = 1,
+                                            unsigned restartLength = 30,
+                                            ArnoldiOrthogonalization orthogonalization = ModifiedGramSchmidtArnoldi) :
+                KrylovSolver<T>(tolerance, maxIterations, throwExceptionOnMaxFailure, availableThreads),
+                _orthogonalization(orthogonalization) {
+            setRestartLength(restartLength);
+            _updateName();
+        }
+
+        /**
+        * @brief Sets m, the maximum dimension of the Krylov subspace before a restart.
+        */
+        void setRestartLength(unsigned restartLength) {
+            if (restartLength == 0)
+                throw invalid_argument("The restart length must be positive.");
+            _restartLength = restartLength;
+            _updateName();
+        }
+
+        unsigned getRestartLength() const {
+            return _restartLength;
+        }
+
+        void setOrthogonalization(ArnoldiOrthogonalization orthogonalization) {
+            _orthogonalization = orthogonalization;
+            _updateName();
+        }
+
+        ArnoldiOrthogonalization getOrthogonalization() const {
+            return _orthogonalization;
+        }
+
+        /**
+        * @brief Returns the number of cycles (restarts + 1) of the last solve().
+        */
+        unsigned getCycles() const {
+            return _cycles;
+        }
+
+    protected:
+        void _solve(LinearOperator<T> &matrix, NumericalVector<T> &rhs, NumericalVector<T> &solution) override {
+            unsigned n = rhs.size();
+            unsigned threads = this->_availableThreads;
+            unsigned m = std::min(_restartLength, n);
+            _cycles = 0;
+            //Basis vectors (modified Gram-Schmidt) or Householder vectors
+            vector<NumericalVector<T>> basis;
+            basis.reserve(m + 1);
+            for (unsigned j = 0; j <= m; j++)
+                basis.emplace_back(n, 0, threads);
+            NumericalVector<T> residual(n, 0, threads), work(n, 0, threads), preconditioned(n, 0, threads);
+            _hessenbergRows = m + 1;
+            _hessenberg.assign((m + 1) * m, 0);
+            _cosines.assign(m, 0);
+            _sines.assign(m, 0);
+            _leastSquaresRhs.assign(m + 1, 0);
+            double referenceNorm = this->_referenceNorm(rhs);
+
+            _trueResidual(matrix, rhs, solution, residual);
+            if (this->_recordResidual(std::sqrt(this->_dot(residual, residual)) / referenceNorm))
+                return;
+
+            while (this->_iteration < this->_maxIterations) {
+                _cycles++;
+                std::fill(_leastSquaresRhs.begin(), _leastSquaresRhs.end(), 0);
+                if (_orthogonalization == HouseholderArnoldi)
+                    _leastSquaresRhs[0] = _householderVector(residual, basis[0], 0);
+                else {
+                    _leastSquaresRhs[0] = std::sqrt(this->_dot(residual, residual));
+                    _scaledCopy(residual, basis[0], 1 / _leastSquaresRhs[0]);
+                }
+
+                unsigned steps = 0;
+                bool converged = false;
+                while (steps < m && this->_iteration < this->_maxIterations && !converged) {
+                    unsigned j = steps;
+                    this->_iteration++;
+                    T subdiagonal;
+                    if (_orthogonalization == HouseholderArnoldi) {
+                        //v_j = P_0 ... P_j e_j, w = P_j ... P_0 A M^-1 v_j
+                        std::fill(work.getDataPointer(), work.getDataPointer() + n, 0);
+                        work[j] = 1;
+                        for (unsigned i = j + 1; i-- > 0;)
+                            _reflect(basis[i], work, i);
+                        this->_applyPreconditioner(work, preconditioned);
+                        this->_multiply(matrix, preconditioned, work);
+                        for (unsigned i = 0; i <= j; i++)
+                            _reflect(basis[i], work, i);
+                        for (unsigned i = 0; i <= j; i++)
+                            _h(i, j) = work[i];
+                        subdiagonal = j + 1 < n ? _householderVector(work, basis[j + 1], j + 1) : 0;
+                    }
+                    else {
+                        //w = A M^-1 v_j orthogonalized against v_0 ... v_j
+                        this->_applyPreconditioner(basis[j], preconditioned);
+                        this->_multiply(matrix, preconditioned, work);
+                        for (unsigned i = 0; i <= j; i++) {
+                            _h(i, j) = this->_dot(work, basis[i]);
+                            work.subtractIntoThis(basis[i], 1, _h(i, j), threads);
+                        }
+                        subdiagonal = std::sqrt(this->_dot(work, work));
+                        if (subdiagonal > 0)
+                            _scaledCopy(work, basis[j + 1], 1 / subdiagonal);
+                    }
+                    _h(j + 1, j) = subdiagonal;
+                    double estimate = _applyGivensRotations(j);
+                    steps++;
+                    //An invariant subspace (lucky breakdown) contains the exact solution
+                    converged = this->_recordResidual(estimate / referenceNorm) || subdiagonal == 0;
+                }
+
+                _updateSolution(steps, basis, work, preconditioned, solution);
+                _trueResidual(matrix, rhs, solution, residual);
+                double trueNorm = std::sqrt(this->_dot(residual, residual)) / referenceNorm;
+                this->_residualNorms->back() = trueNorm;
+                this->_exitNorm = trueNorm;
+                this->_converged = trueNorm <= this->_tolerance;
+                if (this->_converged)
+                    return;
+            }
+        }
+
+    private:
+        unsigned _restartLength;
+
+        ArnoldiOrthogonalization _orthogonalization;
+
+        unsigned _cycles = 0;
+
+        /**
+        * @brief The (m + 1) x m Hessenberg matrix in column major order, upper triangular after the rotations.
+        */
+        vector<T> _hessenberg;
+
+        unsigned _hessenbergRows = 0;
+
+        vector<T> _cosines;
+
+        vector<T> _sines;
+
+        /**
+        * @brief The rotated right hand side ||r0|| e_1 of the least squares problem.
+        */
+        vector<T> _leastSquaresRhs;
+
+        T &_h(unsigned row, unsigned column) {
+            return _hessenberg[row + column * _hessenbergRows];
+        }
+
+        void _updateName() {
+            this->_solverName = "GMRES(" + to_string(_restartLength) + ") " +
+                                (_orthogonalization == HouseholderArnoldi ? "Householder" : "MGS");
+        }
+
+        /**
+        * @brief r = b - A x.
+        */
+        void _trueResidual(LinearOperator<T> &matrix, NumericalVector<T> &rhs, NumericalVector<T> &solution,
+                           NumericalVector<T> &residual) {
+            this->_multiply(matrix, solution, residual);
+            residual.subtractIntoThis(rhs, -1, -1, this->_availableThreads);
+        }
+
+        void _scaledCopy(NumericalVector<T> &source, NumericalVector<T> &target, T scale) {
+            T* sourceData = source.getDataPointer();
+            T* targetData = target.getDataPointer();
+            ThreadingOperations<T>::executeParallelJob([&](unsigned start, unsigned end) {
+                for (unsigned i = start; i < end; i++)
+                    targetData[i] = scale * sourceData[i];
+            }, source.size(), this->_availableThreads);
+        }
+
+        /**
+        * @brief Builds the unit Householder vector u (zero before index first) of the reflection P = I - 2 u u^T
+        * that maps x[first:] to α e_first, with α = -sign(x_first) ||x[first:]||. u = 0 if x[first:] = 0.
+        * @return α.
+        */
+        T _householderVector(NumericalVector<T> &x, NumericalVector<T> &u, unsigned first) {
+            unsigned n = x.size();
+            T* xData = x.getDataPointer();
+            T* uData = u.getDataPointer();
+            T norm = std::sqrt(ThreadingOperations<T>::executeParallelJobWithReduction([&](unsigned start, unsigned end) {
+                T sum = 0;
+                for (unsigned i = first + start; i < first + end; i++)
+                    sum += xData[i] * xData[i];
+                return sum;
+            }, n - first, this->_availableThreads));
+            std::fill(uData, uData + n, 0);
+            if (norm == 0)
+                return 0;
+            T alpha = xData[first] >= 0 ? -norm : norm;
+            //||x[first:] - α e_first||² = 2 ||x[first:]|| (||x[first:]|| + |x_first|)
+            T scale = 1 / std::sqrt(2 * norm * (norm + std::abs(xData[first])));
+            ThreadingOperations<T>::executeParallelJob([&](unsigned start, unsigned end) {
+                for (unsigned i = first + start; i < first + end; i++)
+                    uData[i] = scale * xData[i];
+            }, n - first, this->_availableThreads);
+            uData[first] = scale * (xData[first] - alpha);
+            return alpha;
+        }
+
+        /**
+        * @brief x = (I - 2 u u^T) x for a Householder vector that is zero before index first.
+        */
+        void _reflect(NumericalVector<T> &u, NumericalVector<T> &x, unsigned first) {
+            unsigned n = x.size();
+            T* xData = x.getDataPointer();
+            T* uData = u.getDataPointer();
+            T projection = 2 * ThreadingOperations<T>::executeParallelJobWithReduction([&](unsigned start, unsigned end) {
+                T sum = 0;
+                for (unsigned i = first + start; i < first + end; i++)
+                    sum += uData[i] * xData[i];
+                return sum;
+            }, n - first, this->_availableThreads);
+            ThreadingOperations<T>::executeParallelJob([&](unsigned start, unsigned end) {
+                for (unsigned i = first + start; i < first + end; i++)
+                    xData[i] -= projection * uData[i];
+            }, n - first, this->_availableThreads);
+        }
+
+        /**
+        * @brief Applies the previous rotations to column j of the Hessenberg matrix, computes the rotation that
+        * eliminates h(j + 1, j) and applies it to the least squares right hand side.
+        * @return The residual norm of the least squares problem, |g_j+1|.
+        */
+        double _applyGivensRotations(unsigned j) {
+            for (unsigned i = 0; i < j; i++) {
+                T upper = _h(i, j), lower = _h(i + 1, j);
+                _h(i, j) = _cosines[i] * upper + _sines[i] * lower;
+                _h(i + 1, j) = -_sines[i] * upper + _cosines[i] * lower;
+            }
+            T diagonal = _h(j, j), subdiagonal = _h(j + 1, j);
+            T radius = std::hypot(diagonal, subdiagonal);
+            _cosines[j] = radius > 0 ? diagonal / radius : 1;
+            _sines[j] = radius > 0 ? subdiagonal / radius : 0;
+            _h(j, j) = radius;
+            _h(j + 1, j) = 0;
+            _leastSquaresRhs[j + 1] = -_sines[j] * _leastSquaresRhs[j];
+            _leastSquaresRhs[j] = _cosines[j] * _leastSquaresRhs[j];
+            return std::abs(static_cast<double>(_leastSquaresRhs[j + 1]));
+        }
+
+        /**
+        * @brief Solves the triangular system R y = g of the cycle and updates x = x + M^-1 V y.
+        */
+        void _updateSolution(unsigned steps, vector<NumericalVector<T>> &basis, NumericalVector<T> &work,
+                             NumericalVector<T> &preconditioned, NumericalVector<T> &solution) {
+            if (steps == 0)
+                return;
+            unsigned n = solution.size();
+            vector<T> y(steps);
+            for (unsigned i = steps; i-- > 0;) {
+                T sum = _leastSquaresRhs[i];
+                for (unsigned k = i + 1; k < steps; k++)
+                    sum -= _h(i, k) * y[k];
+                if (_h(i, i) == 0)
+                    throw runtime_error("GMRES breakdown: singular Hessenberg matrix.");
+                y[i] = sum / _h(i, i);
+            }
+            std::fill(work.getDataPointer(), work.getDataPointer() + n, 0);
+            if (_orthogonalization == HouseholderArnoldi) {
+                //V y = P_0 (y_0 e_0 + P_1 (y_1 e_1 + ... P_k-1 y_k-1 e_k-1))
+                for (unsigned i = steps; i-- > 0;) {
+                    work[i] += y[i];
+                    _reflect(basis[i], work, i);
+                }
+            }
+            else
+                for (unsigned i = 0; i < steps; i++)
+                    work.addIntoThis(basis[i], 1, y[i], this->_availableThreads);
+            this->_applyPreconditioner(work, preconditioned);
+            solution.addIntoThis(preconditioned, 1, 1, this->_availableThreads);
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_GENERALIZEDMINIMALRESIDUAL_H
@@ -0,0 +1,228 @@
+//
+// Created by hal9000 on 10/25/23.
+//
+
+#ifndef UNTITLED_KRYLOVSOLVER_H
+#define UNTITLED_KRYLOVSOLVER_H
+
+#include <list>
+#include <chrono>
+#include "../../LinearOperators/LinearOperator.h"
+#include "../../Preconditioners/Preconditioner.h"
+#include "../../Telemetry/SolverTelemetry.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Base class of the Krylov subspace solvers of NumericalMatrix systems and matrix-free operators.
+    *
+    * Mirrors the tolerance API of IterativeSolver. The iteration stops when the relative residual ||b - A x|| / ||b||
+    * (2-norm, absolute if b = 0) drops below the tolerance. Every relative residual norm is recorded, so the
+    * convergence history is available after solve(). The telemetry records the residuals with their timings and
+    * counts the operator applications and the global reductions, the solvers never write to the console.
+    *
+    * @tparam T The datatype of the matrix and vector elements.
+    */
+    template<typename T>
+    class KrylovSolver {
+    public:
+        explicit KrylovSolver(double tolerance = 1E-9, unsigned maxIterations = 1E4, bool throwExceptionOnMaxFailure = true,
+                              unsigned availableThreads = 1) :
+                _tolerance(tolerance), _maxIterations(maxIterations), _throwExceptionOnMaxFailure(throwExceptionOnMaxFailure),
+                _availableThreads(std::max(1u, availableThreads)), _iteration(0), _exitNorm(0), _converged(false),
+                _solutionTime(0), _residualNorms(make_shared<list<double>>()), _preconditioner(nullptr),
+                _telemetry(make_shared<SolverTelemetry>()) { }
+
+        virtual ~KrylovSolver() = default;
+
+        /**
+        * @brief Solves A x = b. x holds the initial guess on entry and the solution on exit.
+        *
+        * @throws runtime_error If the solver does not converge within the maximum iterations and
+        * throwExceptionOnMaxFailure is set.
+        */
+        void solve(LinearOperator<T> &matrix, NumericalVector<T> &rhs, NumericalVector<T> &solution) {
+            if (matrix.numberOfRows() != matrix.numberOfColumns())
+                throw invalid_argument("Krylov solvers require a square operator.");
+            if (rhs.size() != matrix.numberOfRows() || solution.size() != matrix.numberOfRows())
+                throw invalid_argument("Vector size does not match the size of the operator.");
+            if (_preconditioner != nullptr && !_preconditioner->isSetUp())
+                throw runtime_error("The preconditioner is not set up.");
+            _iteration = 0;
+            _exitNorm = 0;
+            _converged = false;
+            _residualNorms->clear();
+            _telemetry->begin(_solverName);
+            auto start = std::chrono::high_resolution_clock::now();
+            _solve(matrix, rhs, solution);
+            auto end = std::chrono::high_resolution_clock::now();
+            _solutionTime = std::chrono::duration<double, std::milli>(end - start).count();
+            _telemetry->end(_iteration, _exitNorm, _converged);
+            if (!_converged && _throwExceptionOnMaxFailure)
+                throw runtime_error(_solverName + " did not converge in " + to_string(_iteration) +
+                                    " iterations. Relative residual: " + to_string(_exitNorm));
+        }
+
+        /**
+        * @brief Solves A x = b for an assembled matrix. The matrix multiplication uses the threads of the solver.
+        */
+        void solve(const shared_ptr<NumericalMatrix<T>> &matrix, NumericalVector<T> &rhs, NumericalVector<T> &solution) {
+            NumericalMatrixOperator<T> matrixOperator(matrix, _availableThreads);
+            solve(matrixOperator, rhs, solution);
+        }
+
+        /**
+        * @brief Sets the preconditioner M applied by the solver. It must be set up before solve(). nullptr removes it.
+        */
+        void setPreconditioner(shared_ptr<Preconditioner<T>> preconditioner) {
+            _preconditioner = std::move(preconditioner);
+        }
+
+        const shared_ptr<Preconditioner<T>> &getPreconditioner() const {
+            return _preconditioner;
+        }
+
+        void setTolerance(double tolerance) {
+            _tolerance = tolerance;
+        }
+
+        const double &getTolerance() const {
+            return _tolerance;
+        }
+
+        void setMaxIterations(unsigned maxIterations) {
+            _maxIterations = maxIterations;
+        }
+
+        const unsigned &getMaxIterations() const {
+            return _maxIterations;
+        }
+
+        void setAvailableThreads(unsigned availableThreads) {
+            _availableThreads = std::max(1u, availableThreads);
+        }
+
+        unsigned getIterations() const {
+            return _iteration;
+        }
+
+        /**
+        * @brief Returns the relative residual norm of the last iteration.
+        */
+        double getExitNorm() const {
+            return _exitNorm;
+        }
+
+        bool hasConverged() const {
+            return _converged;
+        }
+
+        /**
+        * @brief Returns the wall time of the last solve() in milliseconds.
+        */
+        double getSolutionTime() const {
+            return _solutionTime;
+        }
+
+        const shared_ptr<list<double>> &getResidualNorms() const {
+            return _residualNorms;
+        }
+
+        const string &getSolverName() const {
+            return _solverName;
+        }
+
+        /**
+        * @brief Replaces the telemetry of the solver, e.g. to share one between solvers.
+        * @throws invalid_argument If telemetry is null.
+        */
+        void setTelemetry(shared_ptr<SolverTelemetry> telemetry) {
+            if (telemetry == nullptr)
+                throw invalid_argument("Telemetry cannot be null.");
+            _telemetry = std::move(telemetry);
+        }
+
+        /**
+        * @brief The telemetry of the solver. Attach sinks before solve(), they are written after it.
+        */
+        const shared_ptr<SolverTelemetry> &getTelemetry() const {
+            return _telemetry;
+        }
+
+    protected:
+        string _solverName;
+
+        double _tolerance;
+
+        unsigned _maxIterations;
+
+        bool _throwExceptionOnMaxFailure;
+
+        unsigned _availableThreads;
+
+        unsigned _iteration;
+
+        double _exitNorm;
+
+        bool _converged;
+
+        double _solutionTime;
+
+        shared_ptr<list<double>> _residualNorms;
+
+        shared_ptr<Preconditioner<T>> _preconditioner;
+
+        shared_ptr<SolverTelemetry> _telemetry;
+
+        virtual void _solve(LinearOperator<T> &matrix, NumericalVector<T> &rhs, NumericalVector<T> &solution) = 0;
+
+        /**
+        * @brief Records the relative residual norm of the current iteration.
+        * @return true if it satisfies the tolerance.
+        */
+        bool _recordResidual(double relativeNorm) {
+            _residualNorms->push_back(relativeNorm);
+            _telemetry->record(_iteration, relativeNorm);
+            _exitNorm = relativeNorm;
+            _converged = relativeNorm <= _tolerance;
+            return _converged;
+        }
+
+        /**
+        * @brief y = A x, counted in the telemetry.
+        */
+        void _multiply(LinearOperator<T> &matrix, NumericalVector<T> &x, NumericalVector<T> &y) {
+            matrix.multiply(x, y);
+            _telemetry->countMatrixVectorProducts();
+        }
+
+        /**
+        * @brief (x, y) with the threads of the solver, counted as a reduction in the telemetry.
+        */
+        T _dot(NumericalVector<T> &x, NumericalVector<T> &y) {
+            _telemetry->countReductions();
+            return x.dotProduct(y, _availableThreads);
+        }
+
+        /**
+        * @brief z = M^-1 r, or z = r without a preconditioner.
+        */
+        void _applyPreconditioner(NumericalVector<T> &r, NumericalVector<T> &z) {
+            if (_preconditioner != nullptr)
+                _preconditioner->apply(r, z);
+            else
+                std::copy(r.getDataPointer(), r.getDataPointer() + r.size(), z.getDataPointer());
+        }
+
+        /**
+        * @brief ||b||, or 1 if b = 0 so that the stopping criterion becomes absolute.
+        */
+        double _referenceNorm(NumericalVector<T> &rhs) {
+            double norm = std::sqrt(static_cast<double>(_dot(rhs, rhs)));
+            return norm > 0 ? norm : 1;
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_KRYLOVSOLVER_H
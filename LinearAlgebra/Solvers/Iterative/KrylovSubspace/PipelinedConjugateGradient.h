@@ -0,0 +1,477 @@
+//
+// Created by hal9000 on 10/30/23.
+//
+
+#ifndef UNTITLED_PIPELINEDCONJUGATEGRADIENT_H
+#define UNTITLED_PIPELINEDCONJUGATEGRADIENT_H
+
+#include <mutex>
+#include "KrylovSolver.h"
+#include "../../Preconditioners/JacobiPreconditioner.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Communication reducing conjugate gradient for symmetric positive definite operators.
+    *
+    * Standard CG synchronizes all the threads for the SpMV, for each of its two dot products and for each vector
+    * update. With stepsPerReduction = 1 this solver runs the pipelined CG of Ghysels and Vanroose: the auxiliary
+    * recurrences w = A u, s = A p, z = A q, q = M^-1 s and m = M^-1 w let the three inner products (r,u), (w,u) and
+    * (r,r) of an iteration be accumulated in the same pass as the vector updates, independently of the SpMV
+    * n = A m that follows them. For CSR matrices without a preconditioner or with a Jacobi preconditioner a team of
+    * threads is created once per solve and each thread owns a block of rows. An iteration is the SpMV of the own rows,
+    * the fused update and partial reduction of the own rows and a single barrier; the partial sums of the previous
+    * iteration are read after the barrier, so the reduction is overlapped with the SpMV of the next one. Other
+    * operators and preconditioners use the same recurrences with a fork/join per SpMV, preconditioner application and
+    * fused update.
+    *
+    * With stepsPerReduction = s > 1 the solver runs the s-step CG of Chronopoulos and Gear without a preconditioner.
+    * Each outer step builds the scaled monomial basis r, A r / σ, ..., (A / σ)^s r with s SpMVs, computes all the
+    * inner products of the step (the moments of the basis and the projections on the previous directions) in one
+    * reduction, and advances s CG iterations with s x s Gram matrices. The monomial basis loses rank for large s,
+    * values up to 4 - 5 are safe for the usual discretizations.
+    *
+    * The residual norm of the pipelined recurrences is one iteration behind the update, as the norm of the s-step
+    * method is one outer step behind, so both may run one extra (outer) iteration. The recurrences drift from the
+    * true residual b - A x by roughly the rounding errors amplified by the condition number, so very tight tolerances
+    * can stagnate earlier than standard CG.
+    */
+    template<typename T>
+    class PipelinedConjugateGradient : public KrylovSolver<T> {
+    public:
+        explicit PipelinedConjugateGradient(double tolerance = 1E-9, unsigned maxIterations = 1E4,
+                                            bool throwExceptionOnMaxFailure = true, unsigned availableThreads = 1,
+                                            unsigned stepsPerReduction = 1) :
+                KrylovSolver<T>(tolerance, maxIterations, throwExceptionOnMaxFailure, availableThreads) {
+            setStepsPerReduction(stepsPerReduction);
+        }
+
+        /**
+        * @brief Sets s, the CG iterations per global reduction. 1 is the pipelined CG, s > 1 the s-step CG.
+        */
+        void setStepsPerReduction(unsigned stepsPerReduction) {
+            if (stepsPerReduction == 0)
+                throw invalid_argument("The steps per reduction must be positive.");
+            _stepsPerReduction = stepsPerReduction;
+            this->_solverName = stepsPerReduction == 1 ? "Pipelined Conjugate Gradient" :
+                                to_string(stepsPerReduction) + "-step Conjugate Gradient";
+        }
+
+        unsigned getStepsPerReduction() const {
+            return _stepsPerReduction;
+        }
+
+        /**
+        * @brief Returns the number of thread synchronizations (barriers, fork/joins or reductions) of the last solve().
+        */
+        unsigned getSynchronizations() const {
+            return _synchronizations;
+        }
+
+    protected:
+        void _solve(LinearOperator<T> &matrix, NumericalVector<T> &rhs, NumericalVector<T> &solution) override {
+            _synchronizations = 0;
+            if (_stepsPerReduction > 1) {
+                if (this->_preconditioner != nullptr)
+                    throw invalid_argument("The s-step conjugate gradient does not support preconditioning.");
+                _sStepSolve(matrix, rhs, solution);
+            }
+            else
+                _pipelinedSolve(matrix, rhs, solution);
+        }
+
+    private:
+        unsigned _stepsPerReduction;
+
+        unsigned _synchronizations = 0;
+
+        /**
+        * @brief Partial sums of one thread, padded to a cache line so that the threads do not share lines.
+        */
+        static constexpr unsigned _partialStride = 64 / sizeof(T) > 3 ? 64 / sizeof(T) : 4;
+
+        static constexpr unsigned _reductionChunk = 256;
+
+        /**
+        * @brief The vectors of the pipelined recurrences.
+        */
+        struct PipelineVectors {
+            PipelineVectors(unsigned size, unsigned threads) :
+                    r(size, 0, threads), u(size, 0, threads), w(size, 0, threads), p(size, 0, threads),
+                    s(size, 0, threads), q(size, 0, threads), z(size, 0, threads), n(size, 0, threads),
+                    m(size, 0, threads), nextM(size, 0, threads) { }
+
+            NumericalVector<T> r, u, w, p, s, q, z, n, m, nextM;
+        };
+
+        /**
+        * @brief Step sizes of the pipelined iteration from γ = (r,u), δ = (w,u).
+        * @return false if the operator or the preconditioner is not positive definite.
+        */
+        static bool _stepSizes(T gamma, T delta, T previousGamma, T previousAlpha, bool first, T &alpha, T &beta) {
+            beta = first ? 0 : gamma / previousGamma;
+            T denominator = first ? delta : delta - beta * gamma / previousAlpha;
+            if (denominator <= static_cast<T>(0))
+                return false;
+            alpha = gamma / denominator;
+            return true;
+        }
+
+        void _pipelinedSolve(LinearOperator<T> &matrix, NumericalVector<T> &rhs, NumericalVector<T> &solution) {
+            unsigned size = rhs.size();
+            unsigned threads = this->_availableThreads;
+            PipelineVectors v(size, threads);
+            double referenceNorm = this->_referenceNorm(rhs);
+
+            //r = b - A x, u = M^-1 r, w = A u, m = M^-1 w
+            this->_multiply(matrix, solution, v.r);
+            v.r.subtractIntoThis(rhs, -1, -1, threads);
+            this->_applyPreconditioner(v.r, v.u);
+            this->_multiply(matrix, v.u, v.w);
+            this->_applyPreconditioner(v.w, v.m);
+            T gamma = this->_dot(v.r, v.u), delta = this->_dot(v.w, v.u);
+            T residual = this->_dot(v.r, v.r);
+
+            auto matrixOperator = dynamic_cast<NumericalMatrixOperator<T> *>(&matrix);
+            auto jacobi = dynamic_pointer_cast<JacobiPreconditioner<T>>(this->_preconditioner);
+            bool rowLocalPreconditioner = this->_preconditioner == nullptr || jacobi != nullptr;
+            if (matrixOperator != nullptr && matrixOperator->getMatrix()->dataStorage->getStorageType() == CSR &&
+                rowLocalPreconditioner)
+                _teamIterations(*matrixOperator->getMatrix(), jacobi, v, solution, gamma, delta, residual, referenceNorm);
+            else
+                _forkJoinIterations(matrix, v, solution, gamma, delta, residual, referenceNorm);
+        }
+
+        /**
+        * @brief Pipelined iterations on a persistent team of threads with one barrier per iteration.
+        */
+        void _teamIterations(NumericalMatrix<T> &matrix, const shared_ptr<JacobiPreconditioner<T>> &jacobi,
+                             PipelineVectors &v, NumericalVector<T> &solution, T gamma, T delta, T residual,
+                             double referenceNorm) {
+            auto pointers = matrix.dataStorage->getSupplementaryDataPointers();
+            const unsigned* columnIndices = pointers[0];
+            const unsigned* rowOffsets = pointers[1];
+            const T* values = matrix.dataStorage->getValuesDataPointer();
+            const T* inverseDiagonal = jacobi != nullptr ? jacobi->getInverseDiagonal()->getDataPointer() : nullptr;
+            unsigned threads = this->_availableThreads;
+            //Two generations of partial sums, so that a fast thread never overwrites the sums a slow one still reads
+            vector<T> partials(2 * threads * _partialStride, 0);
+            partials[0] = gamma;
+            partials[1] = delta;
+            partials[2] = residual;
+            NumericalVector<T> *m[2] = {&v.m, &v.nextM};
+            bool indefinite = false;
+            T* x = solution.getDataPointer();
+
+            unsigned teamSize = ThreadingOperations<T>::executeParallelTeamJob(
+                    [&](unsigned thread, unsigned start, unsigned end, ThreadBarrier &barrier) {
+                T previousGamma = 0, previousAlpha = 0;
+                for (unsigned k = 0; ; k++) {
+                    const T* sums = partials.data() + (k % 2) * threads * _partialStride;
+                    T kGamma = 0, kDelta = 0, kResidual = 0;
+                    for (unsigned t = 0; t < threads; t++) {
+                        kGamma += sums[t * _partialStride];
+                        kDelta += sums[t * _partialStride + 1];
+                        kResidual += sums[t * _partialStride + 2];
+                    }
+                    //Every thread takes the same decisions from the same sums
+                    double norm = std::sqrt(static_cast<double>(kResidual)) / referenceNorm;
+                    if (thread == 0) {
+                        //The SpMV and the fused reduction of the previous iteration
+                        if (k > 0) {
+                            this->_telemetry->countMatrixVectorProducts();
+                            this->_telemetry->countReductions();
+                        }
+                        this->_iteration = k;
+                        this->_recordResidual(norm);
+                    }
+                    if (norm <= this->_tolerance || k >= this->_maxIterations)
+                        return;
+                    T alpha, beta;
+                    if (!_stepSizes(kGamma, kDelta, previousGamma, previousAlpha, k == 0, alpha, beta)) {
+                        if (thread == 0)
+                            indefinite = true;
+                        return;
+                    }
+                    previousGamma = kGamma;
+                    previousAlpha = alpha;
+
+                    //n = A m on the own rows, then the fused update, the row-local m and the partial sums
+                    const T* currentM = m[k % 2]->getDataPointer();
+                    T* n = v.n.getDataPointer();
+                    for (unsigned row = start; row < end; row++) {
+                        T sum = 0;
+                        for (unsigned j = rowOffsets[row]; j < rowOffsets[row + 1]; j++)
+                            sum += values[j] * currentM[columnIndices[j]];
+                        n[row] = sum;
+                    }
+                    T* next = partials.data() + ((k + 1) % 2) * threads * _partialStride + thread * _partialStride;
+                    _fusedUpdate(v, currentM, m[(k + 1) % 2]->getDataPointer(), x, inverseDiagonal, alpha, beta, start, end, next);
+                    barrier.wait();
+                }
+            }, solution.size(), threads);
+            _synchronizations = this->_iteration * (teamSize > 1 ? 1 : 0);
+            if (indefinite)
+                throw runtime_error("Operator or preconditioner is not positive definite.");
+        }
+
+        /**
+        * @brief The fused update of rows [start, end) for the step sizes α, β:
+        * z = n + β z, q = m + β q, s = w + β s, p = u + β p, x = x + α p, r = r - α s, u = u - α q, w = w - α z,
+        * the row-local nextM = D^-1 w (D = I without inverseDiagonal) if nextM is given and the partial sums
+        * (r,u), (w,u), (r,r).
+        */
+        static void _fusedUpdate(PipelineVectors &v, const T* m, T* nextM, T* x, const T* inverseDiagonal, T alpha, T beta,
+                                 unsigned start, unsigned end, T* partials) {
+            T* r = v.r.getDataPointer(); T* u = v.u.getDataPointer(); T* w = v.w.getDataPointer();
+            T* p = v.p.getDataPointer(); T* s = v.s.getDataPointer(); T* q = v.q.getDataPointer();
+            T* z = v.z.getDataPointer(); const T* n = v.n.getDataPointer();
+            T gamma = 0, delta = 0, residual = 0;
+            for (unsigned i = start; i < end; i++) {
+                z[i] = n[i] + beta * z[i];
+                q[i] = m[i] + beta * q[i];
+                s[i] = w[i] + beta * s[i];
+                p[i] = u[i] + beta * p[i];
+                x[i] += alpha * p[i];
+                r[i] -= alpha * s[i];
+                u[i] -= alpha * q[i];
+                w[i] -= alpha * z[i];
+                if (nextM != nullptr)
+                    nextM[i] = inverseDiagonal != nullptr ? inverseDiagonal[i] * w[i] : w[i];
+                gamma += r[i] * u[i];
+                delta += w[i] * u[i];
+                residual += r[i] * r[i];
+            }
+            partials[0] = gamma;
+            partials[1] = delta;
+            partials[2] = residual;
+        }
+
+        /**
+        * @brief Pipelined iterations for any operator and preconditioner: a fork/join for the preconditioner, the
+        * SpMV and the fused update with its reduction.
+        */
+        void _forkJoinIterations(LinearOperator<T> &matrix, PipelineVectors &v, NumericalVector<T> &solution,
+                                 T gamma, T delta, T residual, double referenceNorm) {
+            unsigned threads = this->_availableThreads;
+            T previousGamma = 0, previousAlpha = 0;
+            mutex sumsMutex;
+            for (unsigned k = 0; ; k++) {
+                this->_iteration = k;
+                if (this->_recordResidual(std::sqrt(static_cast<double>(residual)) / referenceNorm) || k >= this->_maxIterations)
+                    return;
+                T alpha, beta;
+                if (!_stepSizes(gamma, delta, previousGamma, previousAlpha, k == 0, alpha, beta))
+                    throw runtime_error("Operator or preconditioner is not positive definite.");
+                previousGamma = gamma;
+                previousAlpha = alpha;
+                //n = A m
+                this->_multiply(matrix, v.m, v.n);
+                gamma = delta = residual = 0;
+                ThreadingOperations<T>::executeParallelJob([&](unsigned start, unsigned end) {
+                    T partials[3];
+                    _fusedUpdate(v, v.m.getDataPointer(), nullptr, solution.getDataPointer(), nullptr, alpha, beta,
+                                 start, end, partials);
+                    lock_guard<mutex> lock(sumsMutex);
+                    gamma += partials[0];
+                    delta += partials[1];
+                    residual += partials[2];
+                }, solution.size(), threads);
+                this->_telemetry->countReductions();
+                //m = M^-1 w
+                this->_applyPreconditioner(v.w, v.m);
+                _synchronizations += 3;
+            }
+        }
+
+        /**
+        * @brief Solves the small dense system a x = b (b with several columns, overwritten with x) by Gaussian
+        * elimination with partial pivoting.
+        * @return false if a is numerically singular.
+        */
+        static bool _solveSmall(vector<T> a, unsigned size, vector<T> &b, unsigned columns) {
+            T scale = 0;
+            for (auto value : a)
+                scale = std::max(scale, std::abs(value));
+            for (unsigned k = 0; k < size; k++) {
+                unsigned pivot = k;
+                for (unsigned i = k + 1; i < size; i++)
+                    if (std::abs(a[i * size + k]) > std::abs(a[pivot * size + k]))
+                        pivot = i;
+                if (std::abs(a[pivot * size + k]) <= std::numeric_limits<T>::epsilon() * scale)
+                    return false;
+                if (pivot != k) {
+                    for (unsigned j = 0; j < size; j++)
+                        std::swap(a[k * size + j], a[pivot * size + j]);
+                    for (unsigned j = 0; j < columns; j++)
+                        std::swap(b[k * columns + j], b[pivot * columns + j]);
+                }
+                for (unsigned i = k + 1; i < size; i++) {
+                    T factor = a[i * size + k] / a[k * size + k];
+                    for (unsigned j = k; j < size; j++)
+                        a[i * size + j] -= factor * a[k * size + j];
+                    for (unsigned j = 0; j < columns; j++)
+                        b[i * columns + j] -= factor * b[k * columns + j];
+                }
+            }
+            for (unsigned i = size; i-- > 0;) {
+                for (unsigned j = 0; j < columns; j++) {
+                    T sum = b[i * columns + j];
+                    for (unsigned k = i + 1; k < size; k++)
+                        sum -= a[i * size + k] * b[k * columns + j];
+                    b[i * columns + j] = sum / a[i * size + i];
+                }
+            }
+            return true;
+        }
+
+        /**
+        * @brief s-step CG (Chronopoulos, Gear). Directions P_k = V_k + P_k-1 B_k with the basis V_k of the Krylov
+        * space of r_k and B_k = -W_k-1^-1 Q_k-1^T V_k, Q = A P, W_k = P_k^T A P_k = V_k^T A V_k - C^T W_k-1^-1 C.
+        * The coefficients of x = x + P_k a_k, r = r - Q_k a_k solve W_k a_k = V_k^T r_k.
+        */
+        void _sStepSolve(LinearOperator<T> &matrix, NumericalVector<T> &rhs, NumericalVector<T> &solution) {
+            unsigned size = rhs.size();
+            unsigned threads = this->_availableThreads;
+            unsigned s = _stepsPerReduction;
+            double referenceNorm = this->_referenceNorm(rhs);
+            //basis[j] = A^j r, scaled by σ^-j in the small systems and the updates
+            vector<NumericalVector<T>> basis, directions, products, nextDirections, nextProducts;
+            basis.reserve(s + 1);
+            for (unsigned j = 0; j <= s; j++)
+                basis.emplace_back(size, 0, threads);
+            for (auto vectors : {&directions, &products, &nextDirections, &nextProducts}) {
+                vectors->reserve(s);
+                for (unsigned j = 0; j < s; j++)
+                    vectors->emplace_back(size, 0, threads);
+            }
+            this->_multiply(matrix, solution, basis[0]);
+            basis[0].subtractIntoThis(rhs, -1, -1, threads);
+            //σ ~ ||A r|| / ||r|| keeps the scaled monomial basis vectors (A / σ)^j r at comparable magnitudes
+            this->_multiply(matrix, basis[0], basis[1]);
+            T rNorm = this->_dot(basis[0], basis[0]);
+            T sigma = rNorm > 0 ? std::sqrt(this->_dot(basis[1], basis[1]) / rNorm) : 1;
+            if (sigma == static_cast<T>(0))
+                sigma = 1;
+            for (unsigned j = 2; j <= s; j++)
+                this->_multiply(matrix, basis[j - 1], basis[j]);
+            vector<T> scales(2 * s + 1, 1);
+            for (unsigned l = 1; l < scales.size(); l++)
+                scales[l] = scales[l - 1] / sigma;
+            _synchronizations = 4 + s;
+
+            vector<T> previousGram;
+            mutex sumsMutex;
+            unsigned moments = 2 * s + 1, reductionSize = moments + s * s;
+            for (unsigned outer = 0; ; outer++) {
+                //One reduction: μ_l = (V_i, V_j) with i + j = l, and C_ij = (Q_i, V_j) of the previous directions
+                vector<T> sums(reductionSize, 0);
+                bool first = outer == 0;
+                ThreadingOperations<T>::executeParallelJob([&](unsigned start, unsigned end) {
+                    vector<T> local(reductionSize, 0);
+                    //Chunks that keep the 2s + 1 vectors of the products in the L1 cache
+                    for (unsigned chunkStart = start; chunkStart < end; chunkStart += _reductionChunk) {
+                        unsigned chunkEnd = std::min(chunkStart + _reductionChunk, end);
+                        for (unsigned l = 0; l < moments; l++) {
+                            const T* left = basis[l / 2].getDataPointer();
+                            const T* right = basis[l - l / 2].getDataPointer();
+                            T sum = 0;
+                            for (unsigned i = chunkStart; i < chunkEnd; i++)
+                                sum += left[i] * right[i];
+                            local[l] += sum;
+                        }
+                        if (!first)
+                            for (unsigned a = 0; a < s; a++)
+                                for (unsigned b = 0; b < s; b++) {
+                                    const T* left = products[a].getDataPointer();
+                                    const T* right = basis[b].getDataPointer();
+                                    T sum = 0;
+                                    for (unsigned i = chunkStart; i < chunkEnd; i++)
+                                        sum += left[i] * right[i];
+                                    local[moments + a * s + b] += sum;
+                                }
+                    }
+                    for (unsigned l = 0; l < moments; l++)
+                        local[l] *= scales[l];
+                    for (unsigned l = moments; l < reductionSize; l++)
+                        local[l] *= scales[(l - moments) % s];
+                    lock_guard<mutex> lock(sumsMutex);
+                    for (unsigned l = 0; l < reductionSize; l++)
+                        sums[l] += local[l];
+                }, size, threads);
+                _synchronizations++;
+                this->_telemetry->countReductions();
+
+                this->_iteration = std::min(outer * s, this->_maxIterations);
+                if (this->_recordResidual(std::sqrt(static_cast<double>(std::max(sums[0], static_cast<T>(0)))) / referenceNorm) ||
+                    this->_iteration >= this->_maxIterations)
+                    return;
+
+                //V^T A V = σ μ_i+j+1, V^T r = μ_i
+                vector<T> gram(s * s), coefficients(s);
+                for (unsigned i = 0; i < s; i++) {
+                    coefficients[i] = sums[i];
+                    for (unsigned j = 0; j < s; j++)
+                        gram[i * s + j] = sigma * sums[i + j + 1];
+                }
+                vector<T> directionUpdate;
+                if (!first) {
+                    //B = -W_k-1^-1 C, W_k = V^T A V - C^T W_k-1^-1 C = V^T A V + C^T B
+                    directionUpdate.assign(sums.begin() + moments, sums.end());
+                    if (!_solveSmall(previousGram, s, directionUpdate, s))
+                        throw runtime_error("s-step CG breakdown: singular Gram matrix. Reduce the steps per reduction.");
+                    for (auto &value : directionUpdate)
+                        value = -value;
+                    for (unsigned i = 0; i < s; i++)
+                        for (unsigned j = 0; j < s; j++)
+                            for (unsigned l = 0; l < s; l++)
+                                gram[i * s + j] += sums[moments + l * s + i] * directionUpdate[l * s + j];
+                }
+                if (!_solveSmall(gram, s, coefficients, 1))
+                    throw runtime_error("s-step CG breakdown: singular Gram matrix. Reduce the steps per reduction.");
+                previousGram = gram;
+
+                //P_k = V + P_k-1 B, Q_k = A V + Q_k-1 B, x = x + P_k a, r = r - Q_k a in one pass
+                T* x = solution.getDataPointer();
+                T* r = basis[0].getDataPointer();
+                vector<T*> V(s + 1), P(s), Q(s), nextP(s), nextQ(s);
+                for (unsigned j = 0; j <= s; j++)
+                    V[j] = basis[j].getDataPointer();
+                for (unsigned j = 0; j < s; j++) {
+                    P[j] = directions[j].getDataPointer();
+                    Q[j] = products[j].getDataPointer();
+                    nextP[j] = nextDirections[j].getDataPointer();
+                    nextQ[j] = nextProducts[j].getDataPointer();
+                }
+                ThreadingOperations<T>::executeParallelJob([&](unsigned start, unsigned end) {
+                    for (unsigned i = start; i < end; i++) {
+                        T xUpdate = 0, rUpdate = 0;
+                        for (unsigned j = 0; j < s; j++) {
+                            T direction = scales[j] * V[j][i];
+                            T product = scales[j] * V[j + 1][i];
+                            if (!first)
+                                for (unsigned l = 0; l < s; l++) {
+                                    direction += P[l][i] * directionUpdate[l * s + j];
+                                    product += Q[l][i] * directionUpdate[l * s + j];
+                                }
+                            nextP[j][i] = direction;
+                            nextQ[j][i] = product;
+                            xUpdate += coefficients[j] * direction;
+                            rUpdate += coefficients[j] * product;
+                        }
+                        x[i] += xUpdate;
+                        r[i] -= rUpdate;
+                    }
+                }, size, threads);
+                std::swap(directions, nextDirections);
+                std::swap(products, nextProducts);
+                for (unsigned j = 1; j <= s; j++)
+                    this->_multiply(matrix, basis[j - 1], basis[j]);
+                _synchronizations += 1 + s;
+            }
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_PIPELINEDCONJUGATEGRADIENT_H
@@ -0,0 +1,70 @@
+//
+// Created by hal9000 on 10/25/23.
+//
+
+#ifndef UNTITLED_PRECONDITIONEDCONJUGATEGRADIENT_H
+#define UNTITLED_PRECONDITIONEDCONJUGATEGRADIENT_H
+
+#include "KrylovSolver.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Preconditioned conjugate gradient for symmetric positive definite operators and preconditioners.
+    *
+    * Unlike ConjugateGradientSolver it works on any LinearOperator (CSR, DIA, dense NumericalMatrix or matrix-free)
+    * and applies the preconditioner set with setPreconditioner() once per iteration.
+    */
+    template<typename T>
+    class PreconditionedConjugateGradient : public KrylovSolver<T> {
+    public:
+        explicit PreconditionedConjugateGradient(double tolerance = 1E-9, unsigned maxIterations = 1E4,
+                                                 bool throwExceptionOnMaxFailure = true, unsigned availableThreads = 1) :
+                KrylovSolver<T>(tolerance, maxIterations, throwExceptionOnMaxFailure, availableThreads) {
+            this->_solverName = "Preconditioned Conjugate Gradient";
+        }
+
+    protected:
+        void _solve(LinearOperator<T> &matrix, NumericalVector<T> &rhs, NumericalVector<T> &solution) override {
+            unsigned n = rhs.size();
+            unsigned threads = this->_availableThreads;
+            NumericalVector<T> residual(n, 0, threads), preconditioned(n, 0, threads),
+                               direction(n, 0, threads), matrixTimesDirection(n, 0, threads);
+            double referenceNorm = this->_referenceNorm(rhs);
+
+            //r = b - A x
+            this->_multiply(matrix, solution, matrixTimesDirection);
+            rhs.subtract(matrixTimesDirection, residual, 1, 1, threads);
+            if (this->_recordResidual(std::sqrt(this->_dot(residual, residual)) / referenceNorm))
+                return;
+            //p = z = M^-1 r
+            this->_applyPreconditioner(residual, preconditioned);
+            std::copy(preconditioned.getDataPointer(), preconditioned.getDataPointer() + n, direction.getDataPointer());
+            T residualDotPreconditioned = this->_dot(residual, preconditioned);
+
+            while (this->_iteration < this->_maxIterations) {
+                this->_iteration++;
+                this->_multiply(matrix, direction, matrixTimesDirection);
+                T curvature = this->_dot(direction, matrixTimesDirection);
+                if (curvature <= static_cast<T>(0))
+                    throw runtime_error("Operator or preconditioner is not positive definite.");
+                T alpha = residualDotPreconditioned / curvature;
+                //x = x + α p, r = r - α A p
+                solution.addIntoThis(direction, 1, alpha, threads);
+                residual.subtractIntoThis(matrixTimesDirection, 1, alpha, threads);
+                if (this->_recordResidual(std::sqrt(this->_dot(residual, residual)) / referenceNorm))
+                    return;
+
+                this->_applyPreconditioner(residual, preconditioned);
+                T newResidualDotPreconditioned = this->_dot(residual, preconditioned);
+                T beta = newResidualDotPreconditioned / residualDotPreconditioned;
+                residualDotPreconditioned = newResidualDotPreconditioned;
+                //p = z + β p
+                direction.addIntoThis(preconditioned, beta, 1, threads);
+            }
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_PRECONDITIONEDCONJUGATEGRADIENT_H
@@ -0,0 +1,611 @@
+//
+// Created by hal9000 on 11/5/23.
+//
+
+#ifndef UNTITLED_RECYCLEDCONJUGATEGRADIENT_H
+#define UNTITLED_RECYCLEDCONJUGATEGRADIENT_H
+
+#include "KrylovSolver.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Deflated preconditioned conjugate gradient (Saad, Yeung, Erhel and Guyomarc'h) that recycles a subspace
+    * between the solves of a sequence of related symmetric positive definite systems A_i x_i = b_i.
+    *
+    * The solver keeps an orthonormal basis W of k approximate eigenvectors of the smallest eigenvalues. Every solve
+    * computes A W and the coarse matrix W^T A W for the current operator, so the operator may change between solves,
+    * projects the initial guess x = x + W (W^T A W)^-1 W^T r onto the recycled space and runs CG with the directions
+    * kept A-orthogonal to W:
+    *   p = β p + z - W μ, μ = (W^T A W)^-1 (A W)^T z.
+    * The slow modes of W are solved for by the projection, so the iteration count depends on the remaining spectrum.
+    *
+    * The space passed to the next solve is updated in cycles of s iterations as in recycled CG (Parks, de Sturler et
+    * al.): U, which starts as W, is replaced by the k Ritz vectors of A with the smallest Ritz values in span(U, P),
+    * where P are the s directions of the cycle and A U = A [U, P] C comes without extra products. W itself stays fixed
+    * during a solve. With warm start enabled, the solution of the previous solve is the initial guess of the next one.
+    *
+    * Each solve costs k + 1 more matrix products than PCG and 2 k more vector operations per iteration, plus
+    * O((k + s)^2 n) flops per cycle update. Recycling pays off in wall time when the operator or the preconditioner
+    * dominates the cost of an iteration. The recycled space is cleared when the size of the system changes or W^T A W
+    * is not positive definite.
+    */
+    template<typename T>
+    class RecycledConjugateGradient : public KrylovSolver<T> {
+    public:
+        explicit RecycledConjugateGradient(double tolerance = 1E-9, unsigned maxIterations = 1E4,
+                                           bool throwExceptionOnMaxFailure = true, unsigned availableThreads = 1,
+                                           unsigned recycleDimension = 8, unsigned harvestLength = 20) :
+                KrylovSolver<T>(tolerance, maxIterations, throwExceptionOnMaxFailure, availableThreads),
+                _recycleDimension(recycleDimension), _harvestCycles(1), _warmStart(false), _recycled(0), _deflated(0),
+                _harvested(0), _matrixVectorProducts(0) {
+            setHarvestLength(harvestLength);
+            this->_solverName = "Recycled Conjugate Gradient";
+        }
+
+        /**
+        * @brief Sets k, the dimension of the recycled space kept between solves. 0 turns the solver into PCG.
+        */
+        void setRecycleDimension(unsigned recycleDimension) {
+            _recycleDimension = recycleDimension;
+            if (_recycled > recycleDimension) {
+                _recycled = recycleDimension;
+                _recycledBasis.resize(static_cast<size_t>(_recycled) * _previousSolution.size());
+                _ritzValues.resize(_recycled);
+            }
+        }
+
+        unsigned getRecycleDimension() const {
+            return _recycleDimension;
+        }
+
+        /**
+        * @brief Sets s, the number of search directions of a cycle. The recycled space is updated every s iterations.
+        */
+        void setHarvestLength(unsigned harvestLength) {
+            if (harvestLength == 0)
+                throw invalid_argument("The harvest length must be positive.");
+            _harvestLength = harvestLength;
+        }
+
+        unsigned getHarvestLength() const {
+            return _harvestLength;
+        }
+
+        /**
+        * @brief Sets the number of cycles of each solve that update the recycled space, 0 for all of them. The default
+        * 1 harvests only the first s directions (Saad et al.), which keeps the dense work per solve small.
+        */
+        void setHarvestCycles(unsigned harvestCycles) {
+            _harvestCycles = harvestCycles;
+        }
+
+        unsigned getHarvestCycles() const {
+            return _harvestCycles;
+        }
+
+        /**
+        * @brief If set, solve() starts from the solution of the previous solve instead of the vector passed in.
+        */
+        void setWarmStart(bool warmStart) {
+            _warmStart = warmStart;
+        }
+
+        bool getWarmStart() const {
+            return _warmStart;
+        }
+
+        /**
+        * @brief Discards the recycled space and the previous solution, e.g. before an unrelated sequence.
+        */
+        void clearRecycledSpace() {
+            _recycled = 0;
+            _recycledBasis.clear();
+            _ritzValues.clear();
+            _previousSolution.clear();
+        }
+
+        /**
+        * @brief Returns the dimension of the recycled space the next solve() starts with.
+        */
+        unsigned getRecycledDimension() const {
+            return _recycled;
+        }
+
+        /**
+        * @brief Returns the Ritz values of the recycled basis in ascending order.
+        */
+        const vector<double> &getRitzValues() const {
+            return _ritzValues;
+        }
+
+        /**
+        * @brief Returns the products with A of the last solve(), including the k products of A W.
+        */
+        unsigned getMatrixVectorProducts() const {
+            return _matrixVectorProducts;
+        }
+
+    protected:
+        void _solve(LinearOperator<T> &matrix, NumericalVector<T> &rhs, NumericalVector<T> &solution) override {
+            unsigned n = rhs.size();
+            unsigned threads = this->_availableThreads;
+            if (_recycledBasis.size() != static_cast<size_t>(_recycled) * n) {
+                _recycled = 0;
+                _recycledBasis.clear();
+                _ritzValues.clear();
+            }
+            if (_warmStart && _previousSolution.size() == n)
+                std::copy(_previousSolution.begin(), _previousSolution.end(), solution.getDataPointer());
+            _matrixVectorProducts = 0;
+            _harvested = 0;
+            unsigned cycles = 0;
+            _harvestedDirections.resize(static_cast<size_t>(_harvestLength) * n);
+            _harvestedProducts.resize(static_cast<size_t>(_harvestLength) * n);
+            NumericalVector<T> residual(n, 0, threads), preconditioned(n, 0, threads),
+                               direction(n, 0, threads), matrixTimesDirection(n, 0, threads);
+            double referenceNorm = this->_referenceNorm(rhs);
+
+            //A W and the Cholesky factor of W^T A W for the current operator
+            _setUpCoarseMatrix(matrix, direction, matrixTimesDirection);
+            _deflationBasis = _recycledBasis;
+            _deflationProducts = _recycledProducts;
+            _deflated = _recycled;
+            unsigned k = _deflated;
+            vector<T> coefficients(k);
+
+            //r = b - A x, x = x + W (W^T A W)^-1 W^T r, r = r - A W (W^T A W)^-1 W^T r
+            this->_multiply(matrix, solution, matrixTimesDirection);
+            _matrixVectorProducts++;
+            rhs.subtract(matrixTimesDirection, residual, 1, 1, threads);
+            if (k > 0) {
+                _columnDots(_deflationBasis, k, residual.getDataPointer(), coefficients);
+                _choleskySolve(coefficients);
+                _addColumns(solution.getDataPointer(), _deflationBasis, k, coefficients, 1);
+                _addColumns(residual.getDataPointer(), _deflationProducts, k, coefficients, -1);
+            }
+            if (!this->_recordResidual(std::sqrt(this->_dot(residual, residual)) / referenceNorm)) {
+                //p = z - W μ
+                this->_applyPreconditioner(residual, preconditioned);
+                std::copy(preconditioned.getDataPointer(), preconditioned.getDataPointer() + n, direction.getDataPointer());
+                _deflate(direction, preconditioned, coefficients);
+                T residualDotPreconditioned = this->_dot(residual, preconditioned);
+
+                while (this->_iteration < this->_maxIterations) {
+                    this->_iteration++;
+                    this->_multiply(matrix, direction, matrixTimesDirection);
+                    _matrixVectorProducts++;
+                    T curvature = this->_dot(direction, matrixTimesDirection);
+                    if (curvature <= static_cast<T>(0))
+                        throw runtime_error("Operator or preconditioner is not positive definite.");
+                    if (_harvestCycles == 0 || cycles < _harvestCycles) {
+                        _harvest(direction, matrixTimesDirection, curvature);
+                        if (_harvested == _harvestLength) {
+                            _updateRecycledSpace(n);
+                            cycles++;
+                        }
+                    }
+                    T alpha = residualDotPreconditioned / curvature;
+                    solution.addIntoThis(direction, 1, alpha, threads);
+                    residual.subtractIntoThis(matrixTimesDirection, 1, alpha, threads);
+                    if (this->_recordResidual(std::sqrt(this->_dot(residual, residual)) / referenceNorm))
+                        break;
+
+                    this->_applyPreconditioner(residual, preconditioned);
+                    T newResidualDotPreconditioned = this->_dot(residual, preconditioned);
+                    T beta = newResidualDotPreconditioned / residualDotPreconditioned;
+                    residualDotPreconditioned = newResidualDotPreconditioned;
+                    //p = z + β p - W μ
+                    direction.addIntoThis(preconditioned, beta, 1, threads);
+                    _deflate(direction, preconditioned, coefficients);
+                }
+            }
+            if (_harvested > 0 && (_harvestCycles == 0 || cycles < _harvestCycles))
+                _updateRecycledSpace(n);
+            _previousSolution.assign(solution.getDataPointer(), solution.getDataPointer() + n);
+        }
+
+    private:
+        /**
+        * @brief The rows of the tiles that the dense kernels over the recycled and harvested vectors keep in cache.
+        */
+        static constexpr unsigned _rowTile = 256;
+
+        unsigned _recycleDimension;
+
+        unsigned _harvestLength;
+
+        unsigned _harvestCycles;
+
+        bool _warmStart;
+
+        /**
+        * @brief The dimension of U, the recycled space, and of W, the deflation space of the current solve.
+        */
+        unsigned _recycled;
+
+        unsigned _deflated;
+
+        unsigned _harvested;
+
+        unsigned _matrixVectorProducts;
+
+        /**
+        * @brief U, A U, W, A W and the directions P and A P of the cycle, n x columns in column major order.
+        */
+        vector<T> _recycledBasis;
+
+        vector<T> _recycledProducts;
+
+        vector<T> _deflationBasis;
+
+        vector<T> _deflationProducts;
+
+        vector<T> _harvestedDirections;
+
+        vector<T> _harvestedProducts;
+
+        /**
+        * @brief The lower Cholesky factor of W^T A W, k x k in row major order.
+        */
+        vector<T> _coarseFactor;
+
+        vector<double> _ritzValues;
+
+        vector<T> _previousSolution;
+
+        void _setUpCoarseMatrix(LinearOperator<T> &matrix, NumericalVector<T> &column, NumericalVector<T> &product) {
+            unsigned k = _recycled;
+            if (k == 0)
+                return;
+            unsigned n = column.size();
+            _recycledProducts.resize(static_cast<size_t>(k) * n);
+            for (unsigned j = 0; j < k; j++) {
+                std::copy(_recycledBasis.begin() + static_cast<size_t>(j) * n,
+                          _recycledBasis.begin() + static_cast<size_t>(j + 1) * n, column.getDataPointer());
+                this->_multiply(matrix, column, product);
+                std::copy(product.getDataPointer(), product.getDataPointer() + n,
+                          _recycledProducts.begin() + static_cast<size_t>(j) * n);
+            }
+            _matrixVectorProducts += k;
+            _gram(_columns(_recycledBasis, k, n), _columns(_recycledProducts, k, n), n, _coarseFactor);
+            for (unsigned i = 0; i < k; i++)
+                for (unsigned j = i + 1; j < k; j++)
+                    _coarseFactor[i * k + j] = _coarseFactor[j * k + i] = (_coarseFactor[i * k + j] + _coarseFactor[j * k + i]) / 2;
+            //W from an earlier operator that is not positive definite on span(W): continue without recycling
+            if (!_cholesky(_coarseFactor, k)) {
+                _recycled = 0;
+                _recycledBasis.clear();
+                _ritzValues.clear();
+            }
+        }
+
+        /**
+        * @brief p = p - W μ with μ = (W^T A W)^-1 (A W)^T z, so that p is A-orthogonal to W.
+        */
+        void _deflate(NumericalVector<T> &direction, NumericalVector<T> &preconditioned, vector<T> &coefficients) {
+            unsigned k = _deflated;
+            if (k == 0)
+                return;
+            _columnDots(_deflationProducts, k, preconditioned.getDataPointer(), coefficients);
+            _choleskySolve(coefficients);
+            _addColumns(direction.getDataPointer(), _deflationBasis, k, coefficients, -1);
+        }
+
+        /**
+        * @brief Stores the direction and its product in the cycle, scaled to unit A-norm.
+        */
+        void _harvest(NumericalVector<T> &direction, NumericalVector<T> &matrixTimesDirection, T curvature) {
+            if (_harvested >= _harvestLength || _recycleDimension == 0)
+                return;
+            unsigned n = direction.size();
+            T scale = 1 / std::sqrt(curvature);
+            T* p = direction.getDataPointer();
+            T* ap = matrixTimesDirection.getDataPointer();
+            T* targetP = _harvestedDirections.data() + static_cast<size_t>(_harvested) * n;
+            T* targetAp = _harvestedProducts.data() + static_cast<size_t>(_harvested) * n;
+            for (unsigned i = 0; i < n; i++) {
+                targetP[i] = scale * p[i];
+                targetAp[i] = scale * ap[i];
+            }
+            _harvested++;
+        }
+
+        /**
+        * @brief Replaces U with the Ritz vectors Z C of the smallest Ritz values of Z^T A Z c = θ Z^T Z c in
+        * Z = [U, P] and A U with A Z C. C^T Z^T Z C = I keeps U orthonormal. Starts a new cycle.
+        */
+        void _updateRecycledSpace(unsigned n) {
+            unsigned m = _recycled + _harvested;
+            if (_recycleDimension == 0 || m == 0)
+                return;
+            vector<const T*> basis(m), products(m);
+            for (unsigned j = 0; j < m; j++) {
+                basis[j] = j < _recycled ? _recycledBasis.data() + static_cast<size_t>(j) * n
+                                         : _harvestedDirections.data() + static_cast<size_t>(j - _recycled) * n;
+                products[j] = j < _recycled ? _recycledProducts.data() + static_cast<size_t>(j) * n
+                                            : _harvestedProducts.data() + static_cast<size_t>(j - _recycled) * n;
+            }
+            vector<T> stiffness, mass;
+            _gram(basis, basis, n, mass);
+            _gram(basis, products, n, stiffness);
+            for (unsigned i = 0; i < m; i++)
+                for (unsigned j = i + 1; j < m; j++)
+                    stiffness[i * m + j] = stiffness[j * m + i] = (stiffness[i * m + j] + stiffness[j * m + i]) / 2;
+            //Z^T Z = V D V^T without the directions of the numerical null space, B = D^-1/2 V^T Z^T A Z V D^-1/2
+            vector<T> massVectors;
+            vector<double> massValues = _symmetricEigen(mass, m, massVectors);
+            double largest = massValues.empty() ? 0 : massValues.back();
+            vector<unsigned> kept;
+            for (unsigned j = 0; j < m; j++)
+                if (massValues[j] > 1E-10 * largest)
+                    kept.push_back(j);
+            unsigned rank = static_cast<unsigned>(kept.size());
+            vector<T> transform(static_cast<size_t>(m) * rank);
+            for (unsigned i = 0; i < m; i++)
+                for (unsigned j = 0; j < rank; j++)
+                    transform[i * rank + j] = massVectors[i * m + kept[j]] / static_cast<T>(std::sqrt(massValues[kept[j]]));
+            vector<T> reduced(static_cast<size_t>(rank) * rank, 0), temporary(static_cast<size_t>(m) * rank, 0);
+            for (unsigned i = 0; i < m; i++)
+                for (unsigned l = 0; l < m; l++)
+                    for (unsigned j = 0; j < rank; j++)
+                        temporary[i * rank + j] += stiffness[i * m + l] * transform[l * rank + j];
+            for (unsigned i = 0; i < rank; i++)
+                for (unsigned l = 0; l < m; l++)
+                    for (unsigned j = 0; j < rank; j++)
+                        reduced[i * rank + j] += transform[l * rank + i] * temporary[l * rank + j];
+            vector<T> ritzVectors;
+            vector<double> ritzValues = _symmetricEigen(reduced, rank, ritzVectors);
+
+            //C = V D^-1/2 Y for the k smallest Ritz values, W = Z C
+            unsigned k = std::min(_recycleDimension, rank);
+            vector<T> combination(static_cast<size_t>(m) * k, 0);
+            for (unsigned i = 0; i < m; i++)
+                for (unsigned l = 0; l < rank; l++)
+                    for (unsigned j = 0; j < k; j++)
+                        combination[i * k + j] += transform[i * rank + l] * ritzVectors[l * rank + j];
+            vector<T> recycledBasis(static_cast<size_t>(k) * n), recycledProducts(static_cast<size_t>(k) * n);
+            T* target = recycledBasis.data();
+            T* productTarget = recycledProducts.data();
+            const T* weights = combination.data();
+            const T* const* columns = basis.data();
+            const T* const* productColumns = products.data();
+            ThreadingOperations<T>::executeParallelJob([=](unsigned start, unsigned end) {
+                for (unsigned tile = start; tile < end; tile += _rowTile) {
+                    unsigned tileEnd = std::min(end, tile + static_cast<unsigned>(_rowTile));
+                    for (unsigned j = 0; j < k; j++) {
+                        T* column = target + static_cast<size_t>(j) * n;
+                        T* productColumn = productTarget + static_cast<size_t>(j) * n;
+                        std::fill(column + tile, column + tileEnd, 0);
+                        std::fill(productColumn + tile, productColumn + tileEnd, 0);
+                        for (unsigned l = 0; l < m; l++) {
+                            T weight = weights[l * k + j];
+                            const T* source = columns[l];
+                            const T* productSource = productColumns[l];
+                            for (unsigned i = tile; i < tileEnd; i++) {
+                                column[i] += weight * source[i];
+                                productColumn[i] += weight * productSource[i];
+                            }
+                        }
+                    }
+                }
+            }, n, this->_availableThreads);
+            _recycledBasis.swap(recycledBasis);
+            _recycledProducts.swap(recycledProducts);
+            _harvested = 0;
+            _recycled = k;
+            _ritzValues.assign(ritzValues.begin(), ritzValues.begin() + k);
+        }
+
+        /**
+        * @brief result(i, j) = x_i^T y_j in row major order, in one pass over the rows with tiles of rows of all the
+        * columns and 4 x 4 register blocks of dot products.
+        */
+        void _gram(const vector<const T*> &x, const vector<const T*> &y, unsigned n, vector<T> &result) {
+            this->_telemetry->countReductions();
+            unsigned xCount = static_cast<unsigned>(x.size()), yCount = static_cast<unsigned>(y.size());
+            size_t size = static_cast<size_t>(xCount) * yCount;
+            unsigned chunks = std::max(1u, std::min(this->_availableThreads, n));
+            vector<T> partials(chunks * size, 0);
+            const T* const* xColumns = x.data();
+            const T* const* yColumns = y.data();
+            T* partialData = partials.data();
+            ThreadingOperations<T>::executeParallelJob([=](unsigned startChunk, unsigned endChunk) {
+                for (unsigned chunk = startChunk; chunk < endChunk; chunk++) {
+                    T* partial = partialData + chunk * size;
+                    unsigned end = static_cast<unsigned>(static_cast<size_t>(n) * (chunk + 1) / chunks);
+                    for (unsigned tile = static_cast<unsigned>(static_cast<size_t>(n) * chunk / chunks); tile < end;
+                         tile += _rowTile) {
+                        unsigned tileEnd = std::min(end, tile + static_cast<unsigned>(_rowTile));
+                        for (unsigned i = 0; i < xCount; i += 4)
+                            for (unsigned j = 0; j < yCount; j += 4) {
+                                T* block = partial + static_cast<size_t>(i) * yCount + j;
+                                bool fullRows = i + 4 <= xCount, fullColumns = j + 4 <= yCount;
+                                if (fullRows && fullColumns)
+                                    _dotTile<4, 4>(xColumns + i, yColumns + j, tile, tileEnd, block, yCount);
+                                else if (fullRows)
+                                    for (unsigned l = j; l < yCount; l++)
+                                        _dotTile<4, 1>(xColumns + i, yColumns + l, tile, tileEnd, block + l - j, yCount);
+                                else
+                                    for (unsigned l = i; l < xCount; l++)
+                                        for (unsigned c = j; c < std::min(j + 4, yCount); c++)
+                                            _dotTile<1, 1>(xColumns + l, yColumns + c, tile, tileEnd,
+                                                           partial + static_cast<size_t>(l) * yCount + c, yCount);
+                            }
+                    }
+                }
+            }, chunks, this->_availableThreads, sizeof(T));
+            result.assign(size, 0);
+            for (unsigned chunk = 0; chunk < chunks; chunk++)
+                for (size_t i = 0; i < size; i++)
+                    result[i] += partials[chunk * size + i];
+        }
+
+        template<unsigned Rows, unsigned Columns>
+        static void _dotTile(const T* const* x, const T* const* y, unsigned start, unsigned end, T* result,
+                             unsigned stride) {
+            const T* xs[Rows];
+            const T* ys[Columns];
+            for (unsigned i = 0; i < Rows; i++)
+                xs[i] = x[i];
+            for (unsigned j = 0; j < Columns; j++)
+                ys[j] = y[j];
+            T sums[Rows][Columns] = {};
+            for (unsigned row = start; row < end; row++)
+                for (unsigned i = 0; i < Rows; i++) {
+                    T xValue = xs[i][row];
+                    for (unsigned j = 0; j < Columns; j++)
+                        sums[i][j] += xValue * ys[j][row];
+                }
+            for (unsigned i = 0; i < Rows; i++)
+                for (unsigned j = 0; j < Columns; j++)
+                    result[i * stride + j] += sums[i][j];
+        }
+
+        /**
+        * @brief Pointers to the width columns of the column major block B of n rows.
+        */
+        static vector<const T*> _columns(const vector<T> &block, unsigned width, unsigned n) {
+            vector<const T*> columns(width);
+            for (unsigned j = 0; j < width; j++)
+                columns[j] = block.data() + static_cast<size_t>(j) * n;
+            return columns;
+        }
+
+        /**
+        * @brief result_j = B_j^T x for the width columns of the column major block B.
+        */
+        void _columnDots(const vector<T> &block, unsigned width, const T* x, vector<T> &result) {
+            unsigned n = static_cast<unsigned>(block.size() / width);
+            _gram(_columns(block, width, n), {x}, n, result);
+        }
+
+        /**
+        * @brief y = y + scale B c for the column major block B.
+        */
+        void _addColumns(T* y, const vector<T> &block, unsigned width, const vector<T> &coefficients, T scale) {
+            unsigned n = static_cast<unsigned>(block.size() / width);
+            const T* data = block.data();
+            const T* c = coefficients.data();
+            ThreadingOperations<T>::executeParallelJob([=](unsigned start, unsigned end) {
+                unsigned j = 0;
+                for (; j + 4 <= width; j += 4) {
+                    const T* first = data + static_cast<size_t>(j) * n;
+                    const T *second = first + n, *third = second + n, *fourth = third + n;
+                    T w0 = scale * c[j], w1 = scale * c[j + 1], w2 = scale * c[j + 2], w3 = scale * c[j + 3];
+                    for (unsigned i = start; i < end; i++)
+                        y[i] += w0 * first[i] + w1 * second[i] + w2 * third[i] + w3 * fourth[i];
+                }
+                for (; j < width; j++) {
+                    const T* column = data + static_cast<size_t>(j) * n;
+                    T weight = scale * c[j];
+                    for (unsigned i = start; i < end; i++)
+                        y[i] += weight * column[i];
+                }
+            }, n, this->_availableThreads);
+        }
+
+        /**
+        * @brief In place Cholesky factorization L L^T of the row major size x size matrix a.
+        * @return false if a is not positive definite.
+        */
+        static bool _cholesky(vector<T> &a, unsigned size) {
+            for (unsigned j = 0; j < size; j++) {
+                T diagonal = a[j * size + j];
+                for (unsigned l = 0; l < j; l++)
+                    diagonal -= a[j * size + l] * a[j * size + l];
+                if (!(diagonal > 0))
+                    return false;
+                a[j * size + j] = std::sqrt(diagonal);
+                for (unsigned i = j + 1; i < size; i++) {
+                    T sum = a[i * size + j];
+                    for (unsigned l = 0; l < j; l++)
+                        sum -= a[i * size + l] * a[j * size + l];
+                    a[i * size + j] = sum / a[j * size + j];
+                }
+            }
+            return true;
+        }
+
+        /**
+        * @brief b = (W^T A W)^-1 b with the factor of _setUpCoarseMatrix().
+        */
+        void _choleskySolve(vector<T> &b) {
+            unsigned k = _deflated;
+            for (unsigned i = 0; i < k; i++) {
+                for (unsigned l = 0; l < i; l++)
+                    b[i] -= _coarseFactor[i * k + l] * b[l];
+                b[i] /= _coarseFactor[i * k + i];
+            }
+            for (unsigned i = k; i-- > 0;) {
+                for (unsigned l = i + 1; l < k; l++)
+                    b[i] -= _coarseFactor[l * k + i] * b[l];
+                b[i] /= _coarseFactor[i * k + i];
+            }
+        }
+
+        /**
+        * @brief Cyclic Jacobi eigenvalue algorithm for the row major symmetric size x size matrix a, which is destroyed.
+        * @return The eigenvalues in ascending order. Column j of the row major eigenvectors belongs to eigenvalue j.
+        */
+        static vector<double> _symmetricEigen(vector<T> &a, unsigned size, vector<T> &eigenvectors) {
+            eigenvectors.assign(static_cast<size_t>(size) * size, 0);
+            for (unsigned i = 0; i < size; i++)
+                eigenvectors[i * size + i] = 1;
+            T norm = 0;
+            for (auto value : a)
+                norm += value * value;
+            for (unsigned sweep = 0; sweep < 50; sweep++) {
+                T offDiagonal = 0;
+                for (unsigned i = 0; i < size; i++)
+                    for (unsigned j = i + 1; j < size; j++)
+                        offDiagonal += a[i * size + j] * a[i * size + j];
+                if (offDiagonal <= static_cast<T>(1E-30) * norm)
+                    break;
+                for (unsigned p = 0; p < size; p++)
+                    for (unsigned q = p + 1; q < size; q++) {
+                        T apq = a[p * size + q];
+                        if (apq == 0)
+                            continue;
+                        //The rotation that annihilates a_pq
+                        T theta = (a[q * size + q] - a[p * size + p]) / (2 * apq);
+                        T t = (theta >= 0 ? 1 : -1) / (std::abs(theta) + std::sqrt(theta * theta + 1));
+                        T c = 1 / std::sqrt(t * t + 1), s = t * c;
+                        for (unsigned l = 0; l < size; l++) {
+                            T alp = a[l * size + p], alq = a[l * size + q];
+                            a[l * size + p] = c * alp - s * alq;
+                            a[l * size + q] = s * alp + c * alq;
+                        }
+                        for (unsigned l = 0; l < size; l++) {
+                            T apl = a[p * size + l], aql = a[q * size + l];
+                            a[p * size + l] = c * apl - s * aql;
+                            a[q * size + l] = s * apl + c * aql;
+                        }
+                        for (unsigned l = 0; l < size; l++) {
+                            T vlp = eigenvectors[l * size + p], vlq = eigenvectors[l * size + q];
+                            eigenvectors[l * size + p] = c * vlp - s * vlq;
+                            eigenvectors[l * size + q] = s * vlp + c * vlq;
+                        }
+                    }
+            }
+            vector<unsigned> order(size);
+            for (unsigned i = 0; i < size; i++)
+                order[i] = i;
+            std::sort(order.begin(), order.end(), [&](unsigned i, unsigned j) {
+                return a[i * size + i] < a[j * size + j];
+            });
+            vector<double> eigenvalues(size);
+            vector<T> sorted(static_cast<size_t>(size) * size);
+            for (unsigned j = 0; j < size; j++) {
+                eigenvalues[j] = static_cast<double>(a[order[j] * size + order[j]]);
+                for (unsigned i = 0; i < size; i++)
+                    sorted[i * size + j] = eigenvectors[i * size + order[j]];
+            }
+            eigenvectors.swap(sorted);
+            return eigenvalues;
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_RECYCLEDCONJUGATEGRADIENT_H
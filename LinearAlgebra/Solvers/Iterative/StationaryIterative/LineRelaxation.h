@@ -0,0 +1,298 @@
+//
+// Created by hal9000 on 11/2/23.
+//
+
+#ifndef UNTITLED_LINERELAXATION_H
+#define UNTITLED_LINERELAXATION_H
+
+#include <list>
+#include "../../Preconditioners/Preconditioner.h"
+#include "../../Direct/TridiagonalSolver.h"
+#include "../../../../PositioningInSpace/DirectionsPositions.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Line Gauss-Seidel and alternating direction (ADI) line relaxation for the systems of logically structured
+    * meshes.
+    *
+    * The unknowns must be the nodes of a nx x ny (x nz) grid in lexicographic order (direction One fastest), as for
+    * GeometricMultigrid. A sweep in one direction solves exactly, with the Thomas algorithm, the tridiagonal system
+    * of every grid line in that direction, with the couplings to the other lines moved to the right hand side. The
+    * lines are colored by the parities of their coordinates in the other directions (2 colors in 2D, 4 in 3D), so
+    * that the lines of a color do not couple to each other for any stencil that reaches only the neighbouring lines
+    * (5, 9, 7 and 27 point stencils and their Galerkin coarse operators). The lines of a color are solved in
+    * parallel and the colors in sequence (zebra line Gauss-Seidel).
+    *
+    * Point relaxation smooths only the error that is smooth in the directions of strong coupling, so it stalls on the
+    * anisotropic operators of stretched meshes, where the metric terms of the thin cells dominate in one direction.
+    * Line relaxation in that direction removes the error along the lines exactly. With several directions the sweeps
+    * alternate among them, which handles anisotropies that change direction inside the mesh.
+    *
+    * As a Preconditioner, apply() performs a forward sweep (directions and colors in order) and a backward sweep (in
+    * reverse order) from z = 0. For symmetric A this is a symmetric positive definite M, so it can precondition PCG.
+    * solve() iterates forward sweeps as a standalone solver and sweep() is the smoother step of multigrid.
+    *
+    * @tparam T The datatype of the matrix and vector elements.
+    */
+    template<typename T>
+    class LineRelaxation : public Preconditioner<T> {
+    public:
+        /**
+        * @param unknownsPerDirection The number of unknowns in each direction of the grid.
+        * @param sweptDirections The directions of the lines, in the order of the sweeps. Empty for all the directions
+        * with more than one unknown.
+        */
+        explicit LineRelaxation(const map<PositioningInSpace::Direction, unsigned> &unknownsPerDirection,
+                                const vector<PositioningInSpace::Direction> &sweptDirections = {}) :
+                _iterations(0), _residualNorms(make_shared<list<double>>()) {
+            map<PositioningInSpace::Direction, unsigned> directionIndices;
+            for (auto direction : {PositioningInSpace::One, PositioningInSpace::Two, PositioningInSpace::Three}) {
+                auto count = unknownsPerDirection.find(direction);
+                if (count != unknownsPerDirection.end() && count->second > 0) {
+                    directionIndices[direction] = static_cast<unsigned>(_dimensions.size());
+                    _dimensions.push_back(count->second);
+                }
+            }
+            if (_dimensions.empty())
+                throw invalid_argument("Line relaxation requires at least one direction with unknowns.");
+            for (auto direction : sweptDirections) {
+                auto index = directionIndices.find(direction);
+                if (index == directionIndices.end())
+                    throw invalid_argument("Line relaxation: a swept direction has no unknowns.");
+                _sweptDirections.push_back(index->second);
+            }
+            if (_sweptDirections.empty()) {
+                for (unsigned d = 0; d < _dimensions.size(); d++)
+                    if (_dimensions[d] > 1)
+                        _sweptDirections.push_back(d);
+                if (_sweptDirections.empty())
+                    _sweptDirections.push_back(0);
+            }
+            const string directionNames[] = {"One", "Two", "Three"};
+            string names;
+            for (auto d : _sweptDirections)
+                names += (names.empty() ? "" : ", ") + directionNames[d];
+            this->_name = (_sweptDirections.size() > 1 ? "ADI line GS (" : "Line GS (") + names + ")";
+        }
+
+        /**
+        * @brief Extracts and factorizes the tridiagonal systems of all the lines of the swept directions.
+        *
+        * @throws invalid_argument If the matrix does not match the grid or couples lines that are not neighbours.
+        * @throws runtime_error If the system of a line is singular.
+        */
+        void setup(const shared_ptr<NumericalMatrix<T>> &matrix) override {
+            auto csr = this->_csrArrays(matrix);
+            unsigned unknowns = 1;
+            for (auto n : _dimensions)
+                unknowns *= n;
+            if (csr.numberOfRows != unknowns)
+                throw invalid_argument("The matrix size does not match the unknowns of the grid.");
+            _matrix = matrix;
+            this->_numberOfRows = unknowns;
+            this->_availableThreads = matrix->dataStorage->getAvailableThreads();
+            this->_isSetUp = false;
+
+            unsigned dimensions = static_cast<unsigned>(_dimensions.size());
+            vector<size_t> strides(dimensions, 1);
+            for (unsigned d = 1; d < dimensions; d++)
+                strides[d] = strides[d - 1] * _dimensions[d - 1];
+            auto coordinate = [&](size_t node, unsigned d) { return static_cast<unsigned>(node / strides[d] % _dimensions[d]); };
+
+            //Largest coordinate distance of a coupling in every direction
+            vector<unsigned> reach(dimensions, 0);
+            for (unsigned row = 0; row < unknowns; row++)
+                for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++)
+                    for (unsigned d = 0; d < dimensions; d++) {
+                        unsigned a = coordinate(row, d), b = coordinate(csr.columnIndices[k], d);
+                        reach[d] = std::max(reach[d], a > b ? a - b : b - a);
+                    }
+
+            _families.clear();
+            for (auto d : _sweptDirections) {
+                for (unsigned e = 0; e < dimensions; e++)
+                    if (e != d && reach[e] > 1)
+                        throw invalid_argument("Line relaxation requires couplings only to the neighbouring lines.");
+                LineFamily family;
+                family.length = _dimensions[d];
+                family.stride = strides[d];
+                unsigned numberOfLines = unknowns / family.length;
+                family.colorLines.resize(1u << (dimensions - 1));
+                for (unsigned node = 0; node < unknowns; node++) {
+                    if (coordinate(node, d) != 0)
+                        continue;
+                    unsigned color = 0, bit = 0;
+                    for (unsigned e = 0; e < dimensions; e++)
+                        if (e != d)
+                            color |= (coordinate(node, e) % 2) << bit++;
+                    family.colorLines[color].push_back(static_cast<unsigned>(family.lineStarts.size()));
+                    family.lineStarts.push_back(node);
+                }
+                size_t size = static_cast<size_t>(numberOfLines) * family.length;
+                family.lower.assign(size, 0);
+                family.modifiedUpper.assign(size, 0);
+                family.inverseDenominator.assign(size, 0);
+                atomic<bool> singular(false);
+                this->_parallelFor([&](unsigned start, unsigned end) {
+                    vector<T> diagonal(family.length), upper(family.length);
+                    for (unsigned line = start; line < end; line++) {
+                        size_t offset = static_cast<size_t>(line) * family.length;
+                        for (unsigned position = 0; position < family.length; position++) {
+                            size_t row = family.lineStarts[line] + position * family.stride;
+                            diagonal[position] = upper[position] = 0;
+                            for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++) {
+                                size_t column = csr.columnIndices[k];
+                                if (column == row)
+                                    diagonal[position] += csr.values[k];
+                                else if (position > 0 && column + family.stride == row)
+                                    family.lower[offset + position] += csr.values[k];
+                                else if (position + 1 < family.length && column == row + family.stride)
+                                    upper[position] += csr.values[k];
+                            }
+                        }
+                        if (!TridiagonalSolver<T>::factorize(family.lower.data() + offset, diagonal.data(), upper.data(),
+                                                             family.length, family.modifiedUpper.data() + offset,
+                                                             family.inverseDenominator.data() + offset))
+                            singular = true;
+                    }
+                }, numberOfLines);
+                if (singular)
+                    throw runtime_error("Line relaxation: the system of a grid line is singular.");
+                _families.push_back(std::move(family));
+            }
+            _residual = make_shared<NumericalVector<T>>(unknowns, 0, this->_availableThreads);
+            this->_markSetUp();
+        }
+
+        /**
+        * @brief Computes z = M^-1 r with a forward and a backward sweep from z = 0.
+        */
+        void apply(NumericalVector<T> &r, NumericalVector<T> &z) override {
+            this->_checkApply(r, z);
+            std::fill(z.getDataPointer(), z.getDataPointer() + z.size(), static_cast<T>(0));
+            sweep(r, z, false);
+            sweep(r, z, true);
+        }
+
+        /**
+        * @brief Performs one line relaxation sweep on A x = b in place, in every swept direction.
+        * @param reverse Sweeps the directions and the colors in reverse order.
+        */
+        void sweep(NumericalVector<T> &rhs, NumericalVector<T> &solution, bool reverse = false) {
+            this->_checkApply(rhs, solution);
+            auto csr = this->_csrArrays(_matrix);
+            const T* b = rhs.getDataPointer();
+            T* x = solution.getDataPointer();
+            unsigned numberOfFamilies = static_cast<unsigned>(_families.size());
+            for (unsigned f = 0; f < numberOfFamilies; f++) {
+                auto &family = _families[reverse ? numberOfFamilies - 1 - f : f];
+                unsigned numberOfColors = static_cast<unsigned>(family.colorLines.size());
+                for (unsigned c = 0; c < numberOfColors; c++) {
+                    const auto &lines = family.colorLines[reverse ? numberOfColors - 1 - c : c];
+                    this->_parallelFor([&](unsigned start, unsigned end) {
+                        vector<T> line(family.length);
+                        for (unsigned p = start; p < end; p++) {
+                            size_t offset = static_cast<size_t>(lines[p]) * family.length;
+                            size_t first = family.lineStarts[lines[p]];
+                            //Right hand side of the line with the couplings to the other lines
+                            for (unsigned position = 0; position < family.length; position++) {
+                                size_t row = first + position * family.stride;
+                                T sum = b[row];
+                                for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++) {
+                                    size_t column = csr.columnIndices[k];
+                                    if (column == row || (position > 0 && column + family.stride == row) ||
+                                        (position + 1 < family.length && column == row + family.stride))
+                                        continue;
+                                    sum -= csr.values[k] * x[column];
+                                }
+                                line[position] = sum;
+                            }
+                            TridiagonalSolver<T>::solve(family.lower.data() + offset, family.modifiedUpper.data() + offset,
+                                                        family.inverseDenominator.data() + offset, family.length,
+                                                        line.data());
+                            for (unsigned position = 0; position < family.length; position++)
+                                x[first + position * family.stride] = line[position];
+                        }
+                    }, static_cast<unsigned>(lines.size()));
+                }
+            }
+        }
+
+        /**
+        * @brief Solves A x = b with forward sweeps until ||b - A x|| / ||b|| <= tolerance. x holds the initial
+        * guess on entry.
+        *
+        * @return The number of sweeps.
+        * @throws runtime_error If the tolerance is not reached in maxIterations and throwExceptionOnMaxFailure is set.
+        */
+        unsigned solve(NumericalVector<T> &rhs, NumericalVector<T> &solution, double tolerance = 1E-9,
+                       unsigned maxIterations = 1000, bool throwExceptionOnMaxFailure = true) {
+            this->_checkApply(rhs, solution);
+            double rhsNorm = std::sqrt(static_cast<double>(rhs.dotProduct(rhs, this->_availableThreads)));
+            rhsNorm = rhsNorm > 0 ? rhsNorm : 1;
+            _residualNorms->clear();
+            for (_iterations = 0; ; _iterations++) {
+                _matrix->multiplyVector(solution, *_residual);
+                _residual->subtractIntoThis(rhs, -1, -1, this->_availableThreads);
+                double norm = std::sqrt(static_cast<double>(_residual->dotProduct(*_residual, this->_availableThreads)));
+                _residualNorms->push_back(norm / rhsNorm);
+                if (norm / rhsNorm <= tolerance)
+                    return _iterations;
+                if (_iterations == maxIterations)
+                    break;
+                sweep(rhs, solution);
+            }
+            if (throwExceptionOnMaxFailure)
+                throw runtime_error(this->_name + " did not converge in " + to_string(maxIterations) +
+                                    " sweeps. Relative residual: " + to_string(_residualNorms->back()));
+            return _iterations;
+        }
+
+        /**
+        * @brief Returns the number of sweeps of the last solve().
+        */
+        unsigned getIterations() const {
+            return _iterations;
+        }
+
+        /**
+        * @brief Returns the relative residual norms before every sweep of the last solve() and after the last one.
+        */
+        const shared_ptr<list<double>> &getResidualNorms() const {
+            return _residualNorms;
+        }
+
+    private:
+        /**
+        * @brief The factorized tridiagonal systems of all the lines in one direction. The coefficients of line l start
+        * at l * length and its unknowns are lineStarts[l] + k * stride, k < length.
+        */
+        struct LineFamily {
+            unsigned length = 0;
+            size_t stride = 1;
+            vector<size_t> lineStarts;
+            vector<vector<unsigned>> colorLines;
+            vector<T> lower;
+            vector<T> modifiedUpper;
+            vector<T> inverseDenominator;
+        };
+
+        vector<unsigned> _dimensions;
+
+        vector<unsigned> _sweptDirections;
+
+        vector<LineFamily> _families;
+
+        shared_ptr<NumericalMatrix<T>> _matrix;
+
+        shared_ptr<NumericalVector<T>> _residual;
+
+        unsigned _iterations;
+
+        shared_ptr<list<double>> _residualNorms;
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_LINERELAXATION_H
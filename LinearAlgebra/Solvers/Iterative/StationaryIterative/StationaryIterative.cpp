@@ -26,13 +26,18 @@ namespace LinearAlgebra {
         unsigned n = _linearSystem->matrix->numberOfRows();
         _exitNorm = 1.0;
         _difference = make_shared<vector<double>>(n);
+        //The linear system may have been reordered since the last solution
+        _csrMatrix = nullptr;
         
         if (_parallelization == SingleThread) {
             _printSingleThreadInitializationText();
             while (_iteration < _maxIterations && _exitNorm >= _tolerance) {
                 _singleThreadSolution();
                 _exitNorm = _calculateNorm();
-                _printIterationAndNorm();
+                //One sweep over the matrix and the norm of the difference
+                _telemetry->countMatrixVectorProducts();
+                _telemetry->countReductions();
+                _recordIteration();
                 _iteration++;
             }
         }
@@ -42,7 +47,10 @@ namespace LinearAlgebra {
             while (_iteration < _maxIterations && _exitNorm >= _tolerance) {
                 _multiThreadSolution(numberOfThreads, n);
                 _exitNorm = _calculateNorm();
-                _printIterationAndNorm();
+                //One sweep over the matrix and the norm of the difference
+                _telemetry->countMatrixVectorProducts();
+                _telemetry->countReductions();
+                _recordIteration();
                 _iteration++;
             }
 
@@ -68,11 +76,9 @@ namespace LinearAlgebra {
                 //norm = _stationaryIterativeCuda->getNorm();
                 // Add the norm to the list of norms
                 _residualNorms->push_back(_exitNorm);
-
-                if (_iteration % 100 == 0) {
-                    cout << "Iteration: " << _iteration << " - Norm: " << _exitNorm << endl;
-                }
-
+                _telemetry->countMatrixVectorProducts();
+                _telemetry->countReductions();
+                _recordIteration();
                 _iteration++;
             }
             _stationaryIterativeCuda->getSolutionVector(_xNew->data());
@@ -85,8 +91,48 @@ namespace LinearAlgebra {
         
     }
 
-    void StationaryIterative::_multiThreadSolution(const unsigned short &availableThreads,
-                                                   const unsigned short &numberOfRows) {
+    void StationaryIterative::_multiColorSweep(double relaxationParameter, unsigned availableThreads) {
+        if (_csrMatrix == nullptr) {
+            _csrMatrix = _linearSystem->getCSRMatrix(availableThreads);
+            _colorClasses = NumericalMatrixColoring<double>::colorClasses(*_csrMatrix);
+            if (!_telemetry->isQuiet())
+                cout << "Multicolor ordering with " << _colorClasses.size() << " colors" << endl;
+        }
+        double* values = _csrMatrix->dataStorage->getValues()->getDataPointer();
+        auto supplementaryVectors = _csrMatrix->dataStorage->getSupplementaryVectors();
+        unsigned* columnIndices = supplementaryVectors[0]->getDataPointer();
+        unsigned* rowOffsets = supplementaryVectors[1]->getDataPointer();
+        double* rhs = _linearSystem->rhs->data();
+        double* xNew = _xNew->data();
+        double* xOld = _xOld->data();
+        double* difference = _difference->data();
+
+        for (auto &colorClass : _colorClasses) {
+            if (colorClass.empty())
+                continue;
+            unsigned* rows = colorClass.data();
+            //Rows of the same color only read values of other colors, so they can be updated concurrently
+            auto sweepJob = [&](unsigned start, unsigned end) -> void {
+                for (unsigned i = start; i < end; i++) {
+                    unsigned row = rows[i];
+                    double sum = 0.0, diagonal = 0.0;
+                    for (unsigned k = rowOffsets[row]; k < rowOffsets[row + 1]; k++) {
+                        if (columnIndices[k] == row)
+                            diagonal = values[k];
+                        else
+                            sum += values[k] * xNew[columnIndices[k]];
+                    }
+                    // xNew_i = (1 - w) * xOld_i + w * (b_i - sum) / A_ii
+                    xNew[row] = (1.0 - relaxationParameter) * xOld[row] + relaxationParameter * (rhs[row] - sum) / diagonal;
+                    difference[row] = xNew[row] - xOld[row];
+                    xOld[row] = xNew[row];
+                }
+            };
+            ThreadingOperations<double>::executeParallelJob(sweepJob, colorClass.size(), availableThreads);
+        }
+    }
+
+    void StationaryIterative::_multiThreadSolution(const unsigned short &, const unsigned short &) {
     }
 
     void StationaryIterative::_cudaSolution() {
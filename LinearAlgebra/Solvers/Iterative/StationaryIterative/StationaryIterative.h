@@ -9,6 +9,7 @@
 #include <cuda_runtime.h>
 #include "../IterativeSolver.h"
 #include "StationaryIterrativeCuda/StationaryIterativeCuda.cuh"
+#include "../../../ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrixReordering/NumericalMatrixColoring.h"
 
 namespace LinearAlgebra {
     
@@ -32,6 +33,24 @@ namespace LinearAlgebra {
         
         
     protected:
+        
+        /**
+        * @brief Performs one multicolor SOR sweep (Gauss-Seidel for relaxationParameter = 1) on the CSR copy of the
+        * linear system.
+        *
+        * The rows are colored so that rows of the same color are not coupled. The colors are swept one after the other
+        * and the rows of each color are updated concurrently in place, so the result is a true Gauss-Seidel/SOR sweep
+        * in the multicolor ordering and does not depend on the number of threads. The CSR copy and the coloring are
+        * built once per solution.
+        *
+        * @param relaxationParameter The SOR relaxation parameter.
+        * @param availableThreads The number of threads that update the rows of each color.
+        */
+        void _multiColorSweep(double relaxationParameter, unsigned availableThreads);
+        
+        shared_ptr<NumericalMatrix<double>> _csrMatrix;
+        
+        vector<vector<unsigned>> _colorClasses;
 
     private:
         unique_ptr<StationaryIterativeCuda> _stationaryIterativeCuda;
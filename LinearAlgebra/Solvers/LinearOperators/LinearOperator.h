@@ -0,0 +1,126 @@
+//
+// Created by hal9000 on 10/25/23.
+//
+
+#ifndef UNTITLED_LINEAROPERATOR_H
+#define UNTITLED_LINEAROPERATOR_H
+
+#include <atomic>
+#include <functional>
+#include "../../ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrix.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief A linear map y = A x. The Krylov solvers only need the action of the matrix, so they accept assembled
+    * matrices and matrix-free operators (e.g. stencils applied on the fly) through this interface.
+    *
+    * @tparam T The datatype of the vector elements.
+    */
+    template<typename T>
+    class LinearOperator {
+    public:
+        LinearOperator() : _identity(_nextIdentity()) { }
+
+        LinearOperator(const LinearOperator &) : _identity(_nextIdentity()) { }
+
+        LinearOperator &operator=(const LinearOperator &) {
+            return *this;
+        }
+
+        virtual ~LinearOperator() = default;
+
+        /**
+        * @brief Identifies the operator among all the operators ever constructed, unlike its address which a later
+        * operator may reuse.
+        */
+        unsigned long getIdentity() const {
+            return _identity;
+        }
+
+        virtual unsigned numberOfRows() const = 0;
+
+        virtual unsigned numberOfColumns() const = 0;
+
+        /**
+        * @brief Computes y = A x. x and y never alias.
+        */
+        virtual void multiply(NumericalVector<T> &x, NumericalVector<T> &y) = 0;
+
+    private:
+        unsigned long _identity;
+
+        static unsigned long _nextIdentity() {
+            static atomic<unsigned long> operators(0);
+            return ++operators;
+        }
+    };
+
+    /**
+    * @brief Linear operator of an assembled NumericalMatrix of any storage type.
+    */
+    template<typename T>
+    class NumericalMatrixOperator : public LinearOperator<T> {
+    public:
+        /**
+        * @param matrix The matrix.
+        * @param availableThreads The number of threads of the multiplication. 0 uses the threads of the matrix.
+        */
+        explicit NumericalMatrixOperator(shared_ptr<NumericalMatrix<T>> matrix, unsigned availableThreads = 0) :
+                _matrix(std::move(matrix)), _availableThreads(availableThreads) { }
+
+        unsigned numberOfRows() const override {
+            return _matrix->numberOfRows();
+        }
+
+        unsigned numberOfColumns() const override {
+            return _matrix->numberOfColumns();
+        }
+
+        void multiply(NumericalVector<T> &x, NumericalVector<T> &y) override {
+            _matrix->multiplyVector(x, y, 1, 1, _availableThreads);
+        }
+
+        const shared_ptr<NumericalMatrix<T>> &getMatrix() const {
+            return _matrix;
+        }
+
+    private:
+        shared_ptr<NumericalMatrix<T>> _matrix;
+
+        unsigned _availableThreads;
+    };
+
+    /**
+    * @brief Matrix-free linear operator defined by a function that computes y = A x.
+    */
+    template<typename T>
+    class FunctionLinearOperator : public LinearOperator<T> {
+    public:
+        FunctionLinearOperator(unsigned numberOfRows, unsigned numberOfColumns,
+                               function<void(NumericalVector<T> &x, NumericalVector<T> &y)> multiplication) :
+                _numberOfRows(numberOfRows), _numberOfColumns(numberOfColumns), _multiplication(std::move(multiplication)) { }
+
+        unsigned numberOfRows() const override {
+            return _numberOfRows;
+        }
+
+        unsigned numberOfColumns() const override {
+            return _numberOfColumns;
+        }
+
+        void multiply(NumericalVector<T> &x, NumericalVector<T> &y) override {
+            _multiplication(x, y);
+        }
+
+    private:
+        unsigned _numberOfRows;
+
+        unsigned _numberOfColumns;
+
+        function<void(NumericalVector<T> &x, NumericalVector<T> &y)> _multiplication;
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_LINEAROPERATOR_H
@@ -0,0 +1,205 @@
+//
+// Created by hal9000 on 10/27/23.
+//
+
+#ifndef UNTITLED_GEOMETRICMULTIGRID_H
+#define UNTITLED_GEOMETRICMULTIGRID_H
+
+#include <functional>
+#include "Multigrid.h"
+#include "../../../PositioningInSpace/DirectionsPositions.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Geometric multigrid for the systems of logically structured meshes.
+    *
+    * The unknowns must be the nodes of a nx x ny (x nz) grid in lexicographic order (direction One fastest), e.g.
+    * the internal nodes of a Mesh2D / Mesh3D with Dirichlet boundaries, where the unknowns per direction are
+    * nodesPerDirection - 2. Every direction with at least 3 unknowns is coarsened from n to (n - 1) / 2 unknowns by
+    * keeping the odd nodes, and the prolongation is the tensor product of the 1D linear interpolations with zero
+    * boundary values. Coarsening stops when a level has at most maximumCoarsestUnknowns unknowns or when no direction
+    * can be coarsened.
+    *
+    * The coarse operators are the Galerkin products P^T A P with restriction P^T, unless a re-discretization function
+    * is set. Then the coarse operators are the discretizations of the same differential operator on the coarse grids
+    * and the restriction is the full weighting 2^-d P^T, d the number of coarsened directions.
+    *
+    * With the AlternatingLineSmoother every level except the coarsest is smoothed with the LineRelaxation of its grid
+    * in all the directions, which keeps the convergence of the full coarsening on anisotropic operators.
+    *
+    * @tparam T The datatype of the matrix and vector elements.
+    */
+    template<typename T>
+    class GeometricMultigrid : public Multigrid<T> {
+    public:
+        /**
+        * @param unknownsPerDirection The number of unknowns in each direction of the finest grid.
+        * @param cycle The recursion pattern of a cycle.
+        * @param smoother The smoother of all levels except the coarsest.
+        * @param preSmoothingSteps The smoothing steps before the coarse grid correction.
+        * @param postSmoothingSteps The smoothing steps after the coarse grid correction.
+        */
+        explicit GeometricMultigrid(const map<PositioningInSpace::Direction, unsigned> &unknownsPerDirection, MultigridCycle cycle = VCycle,
+                                    MultigridSmoother smoother = DampedJacobiSmoother, unsigned preSmoothingSteps = 2,
+                                    unsigned postSmoothingSteps = 2) :
+                Multigrid<T>(cycle, smoother, preSmoothingSteps, postSmoothingSteps), _coarseOperator(nullptr) {
+            for (auto direction : {PositioningInSpace::One, PositioningInSpace::Two, PositioningInSpace::Three}) {
+                auto count = unknownsPerDirection.find(direction);
+                if (count != unknownsPerDirection.end() && count->second > 0)
+                    _finestDimensions.push_back(count->second);
+            }
+            if (_finestDimensions.empty())
+                throw invalid_argument("Geometric multigrid requires at least one direction with unknowns.");
+            this->_name = "GMG " + this->_cycleDescription();
+        }
+
+        /**
+        * @brief Sets the function that discretizes the operator on a coarse grid, given its unknowns per direction
+        * (in the order One, Two, Three). It replaces the Galerkin coarse operators. Call before setup().
+        */
+        void setCoarseOperatorFunction(function<shared_ptr<NumericalMatrix<T>>(const vector<unsigned> &)> coarseOperator) {
+            _coarseOperator = std::move(coarseOperator);
+        }
+
+        /**
+        * @brief Builds the grid hierarchy, the coarse operators and the smoother data of every level.
+        */
+        void setup(const shared_ptr<NumericalMatrix<T>> &matrix) override {
+            this->_csrArrays(matrix);
+            unsigned unknowns = 1;
+            for (auto n : _finestDimensions)
+                unknowns *= n;
+            if (matrix->numberOfRows() != unknowns)
+                throw invalid_argument("The matrix size does not match the unknowns of the grid.");
+            this->_numberOfRows = unknowns;
+            this->_availableThreads = matrix->dataStorage->getAvailableThreads();
+
+            this->_levels.clear();
+            this->_levels.emplace_back();
+            this->_levels[0].matrix = matrix;
+            _levelDimensions.assign(1, _finestDimensions);
+            while (true) {
+                auto &fine = this->_levels.back();
+                auto fineDimensions = _levelDimensions.back();
+                auto coarseDimensions = _coarseDimensions(fineDimensions);
+                if (fine.matrix->numberOfRows() <= this->_maximumCoarsestUnknowns || coarseDimensions == fineDimensions)
+                    break;
+                fine.prolongation = _prolongation(fineDimensions, coarseDimensions);
+                fine.restriction = NumericalMatrixSparseProducts<T>::transpose(*fine.prolongation, this->_availableThreads);
+                unsigned coarsenedDirections = 0;
+                for (unsigned d = 0; d < coarseDimensions.size(); d++)
+                    coarsenedDirections += coarseDimensions[d] != fineDimensions[d];
+
+                typename Multigrid<T>::Level coarse;
+                if (_coarseOperator) {
+                    fine.restrictionScale = static_cast<T>(1) / static_cast<T>(1u << coarsenedDirections);
+                    coarse.matrix = _coarseOperator(coarseDimensions);
+                    if (coarse.matrix->numberOfRows() != fine.prolongation->numberOfColumns())
+                        throw runtime_error("The re-discretized operator does not match the coarse grid.");
+                }
+                else
+                    coarse.matrix = NumericalMatrixSparseProducts<T>::galerkinProduct(
+                            *fine.prolongation, *fine.matrix, *fine.prolongation, this->_availableThreads);
+                this->_levels.push_back(std::move(coarse));
+                _levelDimensions.push_back(coarseDimensions);
+            }
+            if (this->_smoother == AlternatingLineSmoother)
+                for (unsigned l = 0; l + 1 < this->_levels.size(); l++) {
+                    map<PositioningInSpace::Direction, unsigned> levelUnknowns;
+                    const PositioningInSpace::Direction directions[] = {PositioningInSpace::One, PositioningInSpace::Two,
+                                                                        PositioningInSpace::Three};
+                    for (unsigned d = 0; d < _levelDimensions[l].size(); d++)
+                        levelUnknowns[directions[d]] = _levelDimensions[l][d];
+                    this->_levels[l].lineSmoother = make_shared<LineRelaxation<T>>(levelUnknowns);
+                    this->_levels[l].lineSmoother->setup(this->_levels[l].matrix);
+                }
+            this->_initializeLevels();
+        }
+
+        /**
+        * @brief Returns the unknowns per direction of a level (0 is the finest).
+        */
+        const vector<unsigned> &getLevelDimensions(unsigned level) const {
+            return _levelDimensions.at(level);
+        }
+
+    private:
+        function<shared_ptr<NumericalMatrix<T>>(const vector<unsigned> &)> _coarseOperator;
+
+        vector<unsigned> _finestDimensions;
+
+        vector<vector<unsigned>> _levelDimensions;
+
+        static vector<unsigned> _coarseDimensions(const vector<unsigned> &dimensions) {
+            vector<unsigned> coarse(dimensions);
+            for (auto &n : coarse)
+                if (n >= 3)
+                    n = (n - 1) / 2;
+            return coarse;
+        }
+
+        /**
+        * @brief Linear interpolation weights (coarse index, weight) of every fine node of one direction. Coarse node i
+        * is fine node 2i + 1 and the boundary nodes at the fine positions -1 and n have zero values.
+        */
+        static vector<vector<pair<unsigned, T>>> _interpolation1D(unsigned n, unsigned nc) {
+            vector<vector<pair<unsigned, T>>> weights(n);
+            if (nc == n) {
+                for (unsigned j = 0; j < n; j++)
+                    weights[j].emplace_back(j, 1);
+                return weights;
+            }
+            for (unsigned j = 0; j < n; j++) {
+                if (j % 2 == 1 && j / 2 < nc) {
+                    weights[j].emplace_back(j / 2, 1);
+                    continue;
+                }
+                int left = j % 2 == 0 ? static_cast<int>(j / 2) - 1 : static_cast<int>(nc) - 1;
+                int right = left + 1;
+                T leftPosition = 2 * left + 1;
+                T rightPosition = right < static_cast<int>(nc) ? 2 * right + 1 : n;
+                if (left >= 0)
+                    weights[j].emplace_back(left, (rightPosition - j) / (rightPosition - leftPosition));
+                if (right < static_cast<int>(nc))
+                    weights[j].emplace_back(right, (j - leftPosition) / (rightPosition - leftPosition));
+            }
+            return weights;
+        }
+
+        /**
+        * @brief Assembles the tensor product of the 1D interpolations in parallel.
+        */
+        shared_ptr<NumericalMatrix<T>> _prolongation(const vector<unsigned> &fine, const vector<unsigned> &coarse) {
+            unsigned dimensions = static_cast<unsigned>(fine.size());
+            vector<vector<vector<pair<unsigned, T>>>> weights(3);
+            vector<unsigned> fineCount(3, 1), coarseCount(3, 1);
+            for (unsigned d = 0; d < 3; d++) {
+                if (d < dimensions) {
+                    fineCount[d] = fine[d];
+                    coarseCount[d] = coarse[d];
+                }
+                weights[d] = _interpolation1D(fineCount[d], coarseCount[d]);
+            }
+            unsigned fineUnknowns = fineCount[0] * fineCount[1] * fineCount[2];
+            unsigned coarseUnknowns = coarseCount[0] * coarseCount[1] * coarseCount[2];
+            auto prolongation = make_shared<NumericalMatrix<T>>(fineUnknowns, coarseUnknowns, CSR, General, this->_availableThreads);
+            prolongation->dataStorage->initializeElementAssignment();
+            this->_parallelFor([&](unsigned start, unsigned end) {
+                for (unsigned row = start; row < end; row++) {
+                    unsigned i = row % fineCount[0], j = (row / fineCount[0]) % fineCount[1], k = row / (fineCount[0] * fineCount[1]);
+                    for (auto &wk : weights[2][k])
+                        for (auto &wj : weights[1][j])
+                            for (auto &wi : weights[0][i])
+                                prolongation->addElement(row, (wk.first * coarseCount[1] + wj.first) * coarseCount[0] + wi.first,
+                                                         wk.second * wj.second * wi.second);
+                }
+            }, fineUnknowns);
+            prolongation->dataStorage->finalizeElementAssignment();
+            return prolongation;
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_GEOMETRICMULTIGRID_H
@@ -0,0 +1,406 @@
+//
+// Created by hal9000 on 10/28/23.
+//
+
+#ifndef UNTITLED_MULTIGRID_H
+#define UNTITLED_MULTIGRID_H
+
+#include <cmath>
+#include "../Preconditioners/BlockJacobiPreconditioner.h"
+#include "../Preconditioners/ChebyshevPreconditioner.h"
+#include "../Iterative/StationaryIterative/LineRelaxation.h"
+#include "../../ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrixSparseProducts/NumericalMatrixSparseProducts.h"
+#include "../../ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrixReordering/NumericalMatrixColoring.h"
+
+namespace LinearAlgebra {
+
+    enum MultigridCycle {
+        VCycle,
+        WCycle,
+        FCycle
+    };
+
+    enum MultigridSmoother {
+        DampedJacobiSmoother,
+        ColoredGaussSeidelSmoother,
+        //Alternating direction zebra line Gauss-Seidel, requires the grid of every level (GeometricMultigrid)
+        AlternatingLineSmoother,
+        //Jacobi preconditioned Chebyshev polynomial, a step is one sweep of ChebyshevPreconditioner
+        ChebyshevSmoother
+    };
+
+    /**
+    * @brief Base class of the multigrid methods. It performs the cycles on a hierarchy of CSR operators and transfer
+    * operators that the derived classes build in setup().
+    *
+    * Used as a Preconditioner, apply() performs one cycle with a zero initial guess. With equal pre and post smoothing
+    * steps (the colors are swept in reverse order in post smoothing) the cycle is a symmetric operator, so it can
+    * precondition PCG. solve() iterates cycles as a standalone solver. The coarsest level is solved with a dense LU
+    * factorization, or smoothed with damped Jacobi if the coarsening stalled above the dense size limit.
+    *
+    * @tparam T The datatype of the matrix and vector elements.
+    */
+    template<typename T>
+    class Multigrid : public Preconditioner<T> {
+    public:
+        /**
+        * @param cycle The recursion pattern of a cycle.
+        * @param smoother The smoother of all levels except the coarsest.
+        * @param preSmoothingSteps The smoothing steps before the coarse grid correction.
+        * @param postSmoothingSteps The smoothing steps after the coarse grid correction.
+        */
+        Multigrid(MultigridCycle cycle, MultigridSmoother smoother, unsigned preSmoothingSteps, unsigned postSmoothingSteps) :
+                _cycle(cycle), _smoother(smoother), _preSmoothingSteps(preSmoothingSteps),
+                _postSmoothingSteps(postSmoothingSteps), _jacobiWeight(static_cast<T>(2) / 3),
+                _maximumCoarsestUnknowns(64), _maximumDirectCoarsestUnknowns(2048), _chebyshevDegree(2), _spectralBoundsCache(make_shared<SpectralBoundsCache<T>>()),
+                _iterations(0), _residualNorms(make_shared<list<double>>()) { }
+
+        /**
+        * @brief Sets the weight ω of the damped Jacobi smoother x = x + ω D^-1 (b - A x). Default 2/3.
+        */
+        void setJacobiWeight(T weight) {
+            _jacobiWeight = weight;
+        }
+
+        /**
+        * @brief Sets the degree of the Chebyshev smoother, the matrix vector products of a smoothing step. Default 2.
+        */
+        void setChebyshevDegree(unsigned degree) {
+            _chebyshevDegree = std::max(1u, degree);
+        }
+
+        /**
+        * @brief Sets the cache of the λmax estimates of the Chebyshev smoother, e.g. shared with other hierarchies or
+        * ChebyshevPreconditioners of the same matrix. A setup() for the same finest matrix with unchanged values does
+        * not estimate it again, the coarse operators are rebuilt and estimated by every setup().
+        * @throws invalid_argument If cache is null.
+        */
+        void setSpectralBoundsCache(shared_ptr<SpectralBoundsCache<T>> cache) {
+            if (cache == nullptr)
+                throw invalid_argument("The spectral bounds cache cannot be null.");
+            _spectralBoundsCache = std::move(cache);
+        }
+
+        const shared_ptr<SpectralBoundsCache<T>> &getSpectralBoundsCache() const {
+            return _spectralBoundsCache;
+        }
+
+        void setMaximumCoarsestUnknowns(unsigned maximumCoarsestUnknowns) {
+            _maximumCoarsestUnknowns = std::max(1u, maximumCoarsestUnknowns);
+        }
+
+        /**
+        * @brief Sets the size up to which the coarsest operator is factorized densely (O(n²) memory, O(n³) flops).
+        * A larger coarsest operator, left when the coarsening stalls, is smoothed with damped Jacobi instead.
+        * Default 2048, never below the maximum coarsest unknowns.
+        */
+        void setMaximumDirectCoarsestUnknowns(unsigned maximumDirectCoarsestUnknowns) {
+            _maximumDirectCoarsestUnknowns = std::max(1u, maximumDirectCoarsestUnknowns);
+        }
+
+        /**
+        * @brief Returns true if the coarsest operator was too large to factorize and is smoothed instead.
+        */
+        bool isCoarsestSmoothed() const {
+            return this->_isSetUp && _coarsestSolver == nullptr;
+        }
+
+        /**
+        * @brief Computes z = M^-1 r with one cycle from z = 0.
+        */
+        void apply(NumericalVector<T> &r, NumericalVector<T> &z) override {
+            this->_checkApply(r, z);
+            std::fill(z.getDataPointer(), z.getDataPointer() + z.size(), static_cast<T>(0));
+            _cycleLevel(0, r, z, _cycle);
+        }
+
+        /**
+        * @brief Solves A x = b with multigrid cycles until ||b - A x|| / ||b|| <= tolerance. x holds the initial
+        * guess on entry.
+        *
+        * @return The number of cycles.
+        * @throws runtime_error If the tolerance is not reached in maxCycles and throwExceptionOnMaxFailure is set.
+        */
+        unsigned solve(NumericalVector<T> &rhs, NumericalVector<T> &solution, double tolerance = 1E-9,
+                       unsigned maxCycles = 100, bool throwExceptionOnMaxFailure = true) {
+            this->_checkApply(rhs, solution);
+            auto &finest = _levels[0];
+            double rhsNorm = std::sqrt(static_cast<double>(rhs.dotProduct(rhs, this->_availableThreads)));
+            rhsNorm = rhsNorm > 0 ? rhsNorm : 1;
+            _residualNorms->clear();
+            for (_iterations = 0; ; _iterations++) {
+                _residual(finest, rhs, solution);
+                double norm = std::sqrt(static_cast<double>(finest.residual->dotProduct(*finest.residual, this->_availableThreads)));
+                _residualNorms->push_back(norm / rhsNorm);
+                if (norm / rhsNorm <= tolerance)
+                    return _iterations;
+                if (_iterations == maxCycles)
+                    break;
+                _cycleLevel(0, rhs, solution, _cycle);
+            }
+            if (throwExceptionOnMaxFailure)
+                throw runtime_error(this->_name + " did not converge in " + to_string(maxCycles) +
+                                    " cycles. Relative residual: " + to_string(_residualNorms->back()));
+            return _iterations;
+        }
+
+        unsigned getNumberOfLevels() const {
+            return static_cast<unsigned>(_levels.size());
+        }
+
+        /**
+        * @brief Returns the operator of a level (0 is the finest).
+        */
+        const shared_ptr<NumericalMatrix<T>> &getLevelMatrix(unsigned level) const {
+            return _levels.at(level).matrix;
+        }
+
+        /**
+        * @brief Returns the prolongation from level + 1 to level.
+        */
+        const shared_ptr<NumericalMatrix<T>> &getProlongation(unsigned level) const {
+            return _levels.at(level).prolongation;
+        }
+
+        /**
+        * @brief Returns the non-zero elements of the operators of all levels divided by those of the finest.
+        */
+        double operatorComplexity() const {
+            double total = 0;
+            for (auto &level : _levels)
+                total += level.matrix->dataStorage->getValues()->size();
+            return total / _levels[0].matrix->dataStorage->getValues()->size();
+        }
+
+        /**
+        * @brief Returns the number of cycles of the last solve().
+        */
+        unsigned getIterations() const {
+            return _iterations;
+        }
+
+        /**
+        * @brief Returns the relative residual norms before every cycle of the last solve() and after the last one.
+        */
+        const shared_ptr<list<double>> &getResidualNorms() const {
+            return _residualNorms;
+        }
+
+    protected:
+        struct Level {
+            shared_ptr<NumericalMatrix<T>> matrix;
+            //Transfer operators to and from the next coarser level
+            shared_ptr<NumericalMatrix<T>> prolongation;
+            shared_ptr<NumericalMatrix<T>> restriction;
+            T restrictionScale = 1;
+            vector<T> inverseDiagonal;
+            vector<vector<unsigned>> colorClasses;
+            shared_ptr<LineRelaxation<T>> lineSmoother;
+            shared_ptr<ChebyshevPreconditioner<T>> chebyshevSmoother;
+            shared_ptr<NumericalVector<T>> rhs;
+            shared_ptr<NumericalVector<T>> solution;
+            shared_ptr<NumericalVector<T>> residual;
+            shared_ptr<NumericalVector<T>> correction;
+        };
+
+        MultigridCycle _cycle;
+
+        MultigridSmoother _smoother;
+
+        unsigned _preSmoothingSteps;
+
+        unsigned _postSmoothingSteps;
+
+        T _jacobiWeight;
+
+        unsigned _maximumCoarsestUnknowns;
+
+        unsigned _maximumDirectCoarsestUnknowns;
+
+        unsigned _chebyshevDegree;
+
+        shared_ptr<SpectralBoundsCache<T>> _spectralBoundsCache;
+
+        vector<Level> _levels;
+
+        /**
+        * @brief Returns the description of the cycle, e.g. "V(2,2) Jacobi", for the names of the derived classes.
+        */
+        string _cycleDescription() const {
+            const string cycleNames[] = {"V", "W", "F"};
+            const string smootherNames[] = {" Jacobi", " colored GS", " ADI line GS", " Chebyshev"};
+            return cycleNames[_cycle] + "(" + to_string(_preSmoothingSteps) + "," + to_string(_postSmoothingSteps) + ")" +
+                   smootherNames[_smoother];
+        }
+
+        /**
+        * @brief Allocates the work vectors, computes the smoother data of every level and factorizes the coarsest
+        * operator. Called by setup() once the operators and the transfer operators of all levels are set, and for
+        * the line smoother the line relaxations of all levels except the coarsest.
+        */
+        void _initializeLevels() {
+            for (unsigned l = 0; l < _levels.size(); l++) {
+                auto &level = _levels[l];
+                unsigned n = level.matrix->numberOfRows();
+                level.residual = make_shared<NumericalVector<T>>(n, 0, this->_availableThreads);
+                if (l > 0) {
+                    level.rhs = make_shared<NumericalVector<T>>(n, 0, this->_availableThreads);
+                    level.solution = make_shared<NumericalVector<T>>(n, 0, this->_availableThreads);
+                }
+                if (l + 1 < _levels.size()) {
+                    level.correction = make_shared<NumericalVector<T>>(n, 0, this->_availableThreads);
+                    _initializeSmoother(level);
+                }
+            }
+            auto &coarsest = _levels.back();
+            unsigned coarsestRows = coarsest.matrix->numberOfRows();
+            if (coarsestRows <= std::max(_maximumCoarsestUnknowns, _maximumDirectCoarsestUnknowns)) {
+                _coarsestSolver = make_shared<BlockJacobiPreconditioner<T>>(coarsestRows);
+                _coarsestSolver->setup(coarsest.matrix);
+            }
+            else {
+                //The coarsening stalled above the dense factorization limit
+                _coarsestSolver = nullptr;
+                coarsest.inverseDiagonal = _inverseDiagonal(coarsest.matrix);
+            }
+            this->_markSetUp();
+        }
+
+        /**
+        * @brief Returns D^-1 of a CSR matrix.
+        * @throws runtime_error If a diagonal element is zero or not stored.
+        */
+        vector<T> _inverseDiagonal(const shared_ptr<NumericalMatrix<T>> &matrix) const {
+            auto csr = this->_csrArrays(matrix);
+            vector<T> inverseDiagonal(csr.numberOfRows, 0);
+            atomic<bool> zeroDiagonal(false);
+            this->_parallelFor([&](unsigned start, unsigned end) {
+                for (unsigned row = start; row < end; row++) {
+                    for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++)
+                        if (csr.columnIndices[k] == row && csr.values[k] != static_cast<T>(0))
+                            inverseDiagonal[row] = 1 / csr.values[k];
+                    if (inverseDiagonal[row] == static_cast<T>(0))
+                        zeroDiagonal = true;
+                }
+            }, csr.numberOfRows);
+            if (zeroDiagonal)
+                throw runtime_error("Multigrid requires non-zero diagonal elements.");
+            return inverseDiagonal;
+        }
+
+    private:
+        shared_ptr<BlockJacobiPreconditioner<T>> _coarsestSolver;
+
+        unsigned _iterations;
+
+        shared_ptr<list<double>> _residualNorms;
+
+        void _cycleLevel(unsigned l, NumericalVector<T> &rhs, NumericalVector<T> &solution, MultigridCycle cycle) {
+            if (l + 1 == _levels.size()) {
+                if (_coarsestSolver != nullptr)
+                    _coarsestSolver->apply(rhs, solution);
+                else
+                    for (unsigned step = 0; step < std::max(1u, _preSmoothingSteps + _postSmoothingSteps); step++)
+                        _jacobiSweep(_levels[l], rhs, solution);
+                return;
+            }
+            auto &level = _levels[l];
+            auto &coarse = _levels[l + 1];
+            for (unsigned step = 0; step < _preSmoothingSteps; step++)
+                _smooth(level, rhs, solution, false);
+
+            _residual(level, rhs, solution);
+            level.restriction->multiplyVector(*level.residual, *coarse.rhs, level.restrictionScale, 1);
+            std::fill(coarse.solution->getDataPointer(), coarse.solution->getDataPointer() + coarse.solution->size(), static_cast<T>(0));
+            switch (cycle) {
+                case VCycle:
+                    _cycleLevel(l + 1, *coarse.rhs, *coarse.solution, VCycle);
+                    break;
+                case WCycle:
+                    _cycleLevel(l + 1, *coarse.rhs, *coarse.solution, WCycle);
+                    _cycleLevel(l + 1, *coarse.rhs, *coarse.solution, WCycle);
+                    break;
+                case FCycle:
+                    _cycleLevel(l + 1, *coarse.rhs, *coarse.solution, FCycle);
+                    _cycleLevel(l + 1, *coarse.rhs, *coarse.solution, VCycle);
+                    break;
+            }
+            level.prolongation->multiplyVector(*coarse.solution, *level.correction);
+            solution.addIntoThis(*level.correction, 1, 1, this->_availableThreads);
+
+            for (unsigned step = 0; step < _postSmoothingSteps; step++)
+                _smooth(level, rhs, solution, true);
+        }
+
+        /**
+        * @brief level.residual = b - A x
+        */
+        void _residual(Level &level, NumericalVector<T> &rhs, NumericalVector<T> &solution) {
+            level.matrix->multiplyVector(solution, *level.residual);
+            level.residual->subtractIntoThis(rhs, -1, -1, this->_availableThreads);
+        }
+
+        void _smooth(Level &level, NumericalVector<T> &rhs, NumericalVector<T> &solution, bool reverseColors) {
+            if (_smoother == AlternatingLineSmoother) {
+                level.lineSmoother->sweep(rhs, solution, reverseColors);
+                return;
+            }
+            if (_smoother == ChebyshevSmoother) {
+                level.chebyshevSmoother->smooth(rhs, solution);
+                return;
+            }
+            if (_smoother == DampedJacobiSmoother) {
+                _jacobiSweep(level, rhs, solution);
+                return;
+            }
+            T* x = solution.getDataPointer();
+            const T* b = rhs.getDataPointer();
+            auto csr = this->_csrArrays(level.matrix);
+            unsigned numberOfColors = static_cast<unsigned>(level.colorClasses.size());
+            for (unsigned c = 0; c < numberOfColors; c++) {
+                const auto &rows = level.colorClasses[reverseColors ? numberOfColors - 1 - c : c];
+                this->_parallelFor([&](unsigned start, unsigned end) {
+                    for (unsigned p = start; p < end; p++) {
+                        unsigned row = rows[p];
+                        T sum = b[row];
+                        for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++)
+                            if (csr.columnIndices[k] != row)
+                                sum -= csr.values[k] * x[csr.columnIndices[k]];
+                        x[row] = sum * level.inverseDiagonal[row];
+                    }
+                }, static_cast<unsigned>(rows.size()));
+            }
+        }
+
+        /**
+        * @brief x = x + ω D^-1 (b - A x)
+        */
+        void _jacobiSweep(Level &level, NumericalVector<T> &rhs, NumericalVector<T> &solution) {
+            _residual(level, rhs, solution);
+            T* x = solution.getDataPointer();
+            const T* r = level.residual->getDataPointer();
+            const T* inverseDiagonal = level.inverseDiagonal.data();
+            T weight = _jacobiWeight;
+            this->_parallelFor([&](unsigned start, unsigned end) {
+                for (unsigned i = start; i < end; i++)
+                    x[i] += weight * inverseDiagonal[i] * r[i];
+            }, solution.size());
+        }
+
+        void _initializeSmoother(Level &level) {
+            level.inverseDiagonal = _inverseDiagonal(level.matrix);
+            if (_smoother == ColoredGaussSeidelSmoother)
+                level.colorClasses = NumericalMatrixColoring<T>::colorClasses(*level.matrix);
+            if (_smoother == ChebyshevSmoother) {
+                level.chebyshevSmoother = make_shared<ChebyshevPreconditioner<T>>(_chebyshevDegree);
+                level.chebyshevSmoother->setBoundsCache(_spectralBoundsCache);
+                level.chebyshevSmoother->setup(level.matrix);
+            }
+            if (_smoother == AlternatingLineSmoother && !level.lineSmoother)
+                throw invalid_argument("The line smoother requires the grid of every level. Use GeometricMultigrid.");
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_MULTIGRID_H
@@ -0,0 +1,363 @@
+//
+// Created by hal9000 on 10/28/23.
+//
+
+#ifndef UNTITLED_SMOOTHEDAGGREGATIONMULTIGRID_H
+#define UNTITLED_SMOOTHEDAGGREGATIONMULTIGRID_H
+
+#include <numeric>
+#include "Multigrid.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Smoothed aggregation algebraic multigrid (Vaněk, Mandel, Brezina) for CSR matrices without a grid
+    * structure, e.g. systems after degree of freedom elimination or strongly anisotropic curvilinear operators.
+    *
+    * The hierarchy of each level is built from its operator A:
+    * 1. Strength of connection: j is strongly coupled to i if |a_ij| >= θ sqrt(|a_ii a_jj|).
+    * 2. Aggregation of the strong graph in three greedy passes: root nodes whose strong neighbours are all free form
+    *    an aggregate with them, the remaining nodes join a neighbouring aggregate, and the rest form new aggregates.
+    *    Isolated nodes are not aggregated; their rows of P are empty and only the smoother corrects them.
+    * 3. Tentative prolongator: the normalized piecewise constant vector of each aggregate (constant near null space).
+    * 4. Prolongator smoothing: P = (I - ω D_F^-1 A_F) P_tentative with ω = 4 / (3 ρ(D_F^-1 A_F)), ρ estimated with
+    *    the power method. A_F is the filtered matrix with the strong connections of A and the weak ones added to the
+    *    diagonal, so that anisotropic operators do not spread P across the weak couplings.
+    * 5. Galerkin coarse operator P^T A P with restriction P^T.
+    *
+    * All the steps are multithreaded with the threads of the matrix. The aggregation runs the greedy passes on the
+    * rows of every thread, so the aggregates depend on the number of threads. Otherwise they depend only on the
+    * pattern and the relative magnitudes of the operators, so updateValues() rebuilds the prolongators and the coarse
+    * operators of a matrix with the same pattern and reuses the aggregates of setup().
+    *
+    * @tparam T The datatype of the matrix and vector elements.
+    */
+    template<typename T>
+    class SmoothedAggregationMultigrid : public Multigrid<T> {
+    public:
+        /**
+        * @param strengthThreshold θ of the strength of connection criterion.
+        * @param cycle The recursion pattern of a cycle.
+        * @param smoother The smoother of all levels except the coarsest.
+        * @param preSmoothingSteps The smoothing steps before the coarse grid correction.
+        * @param postSmoothingSteps The smoothing steps after the coarse grid correction.
+        */
+        explicit SmoothedAggregationMultigrid(T strengthThreshold = 0.08, MultigridCycle cycle = VCycle,
+                                              MultigridSmoother smoother = DampedJacobiSmoother,
+                                              unsigned preSmoothingSteps = 1, unsigned postSmoothingSteps = 1) :
+                Multigrid<T>(cycle, smoother, preSmoothingSteps, postSmoothingSteps),
+                _strengthThreshold(strengthThreshold), _maximumLevels(12) {
+            this->_name = "SA-AMG " + this->_cycleDescription();
+        }
+
+        void setMaximumLevels(unsigned maximumLevels) {
+            _maximumLevels = std::max(1u, maximumLevels);
+        }
+
+        /**
+        * @brief Builds the aggregates, the transfer operators and the coarse operators of all levels.
+        */
+        void setup(const shared_ptr<NumericalMatrix<T>> &matrix) override {
+            this->_csrArrays(matrix);
+            this->_numberOfRows = matrix->numberOfRows();
+            this->_availableThreads = matrix->dataStorage->getAvailableThreads();
+            this->_levels.clear();
+            this->_levels.emplace_back();
+            this->_levels[0].matrix = matrix;
+            _aggregates.clear();
+            _numberOfAggregates.clear();
+
+            while (this->_levels.size() < _maximumLevels) {
+                auto &fine = this->_levels.back();
+                unsigned n = fine.matrix->numberOfRows();
+                if (n <= this->_maximumCoarsestUnknowns)
+                    break;
+                auto filtered = _filteredMatrix(fine.matrix);
+                vector<unsigned> aggregates;
+                unsigned numberOfAggregates = _aggregate(filtered, aggregates);
+                //No coarsening progress, e.g. a diagonal matrix
+                if (numberOfAggregates == 0 || static_cast<uint64_t>(numberOfAggregates) * 10 > static_cast<uint64_t>(n) * 9)
+                    break;
+                _aggregates.push_back(std::move(aggregates));
+                _numberOfAggregates.push_back(numberOfAggregates);
+                this->_levels.emplace_back();
+                _buildTransfer(static_cast<unsigned>(this->_levels.size()) - 2, filtered);
+            }
+            this->_initializeLevels();
+        }
+
+        /**
+        * @brief Rebuilds the hierarchy of a matrix with the same size and pattern as the matrix of setup(), e.g. the
+        * next time step or nonlinear iteration, reusing the aggregates.
+        */
+        void updateValues(const shared_ptr<NumericalMatrix<T>> &matrix) {
+            if (!this->_isSetUp)
+                throw runtime_error("updateValues() requires a hierarchy built with setup().");
+            if (matrix->numberOfRows() != this->_numberOfRows)
+                throw invalid_argument("The matrix size does not match the hierarchy.");
+            this->_csrArrays(matrix);
+            this->_levels[0].matrix = matrix;
+            for (unsigned l = 0; l < _aggregates.size(); l++)
+                _buildTransfer(l, _filteredMatrix(this->_levels[l].matrix));
+            this->_initializeLevels();
+        }
+
+        /**
+        * @brief The aggregate of the isolated unknowns, which are not represented on the coarser level.
+        */
+        static constexpr unsigned unaggregated = numeric_limits<unsigned>::max();
+
+        /**
+        * @brief Returns the aggregate of every unknown of a level, unaggregated for the isolated unknowns.
+        */
+        const vector<unsigned> &getAggregates(unsigned level) const {
+            return _aggregates.at(level);
+        }
+
+    private:
+        T _strengthThreshold;
+
+        unsigned _maximumLevels;
+
+        vector<vector<unsigned>> _aggregates;
+
+        vector<unsigned> _numberOfAggregates;
+
+        /**
+        * @brief Builds the filtered matrix A_F of a CSR operator in two parallel passes. It keeps the diagonal and the
+        * strong connections of every row and adds the weak ones to the diagonal, preserving the row sums.
+        */
+        shared_ptr<NumericalMatrix<T>> _filteredMatrix(const shared_ptr<NumericalMatrix<T>> &matrix) const {
+            auto csr = this->_csrArrays(matrix);
+            unsigned n = csr.numberOfRows;
+            unsigned threads = this->_availableThreads;
+            vector<T> diagonal(n, 0);
+            this->_parallelFor([&](unsigned start, unsigned end) {
+                for (unsigned row = start; row < end; row++)
+                    for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++)
+                        if (csr.columnIndices[k] == row)
+                            diagonal[row] = csr.values[k];
+            }, n);
+            T threshold = _strengthThreshold * _strengthThreshold;
+            auto isKept = [&](unsigned row, unsigned k) {
+                unsigned column = csr.columnIndices[k];
+                return column == row || csr.values[k] * csr.values[k] >= threshold * std::abs(diagonal[row] * diagonal[column]);
+            };
+            auto rowOffsets = make_shared<NumericalVector<unsigned>>(n + 1, 0, threads);
+            unsigned* offsets = rowOffsets->getDataPointer();
+            this->_parallelFor([&](unsigned start, unsigned end) {
+                for (unsigned row = start; row < end; row++)
+                    for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++)
+                        offsets[row + 1] += isKept(row, k);
+            }, n);
+            for (unsigned row = 0; row < n; row++)
+                offsets[row + 1] += offsets[row];
+            auto values = make_shared<NumericalVector<T>>(offsets[n], 0, threads);
+            auto columnIndices = make_shared<NumericalVector<unsigned>>(offsets[n], 0, threads);
+            T* filteredValues = values->getDataPointer();
+            unsigned* filteredColumns = columnIndices->getDataPointer();
+            this->_parallelFor([&](unsigned start, unsigned end) {
+                for (unsigned row = start; row < end; row++) {
+                    unsigned position = offsets[row], diagonalPosition = numeric_limits<unsigned>::max();
+                    T lumped = 0;
+                    for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++) {
+                        if (!isKept(row, k)) {
+                            lumped += csr.values[k];
+                            continue;
+                        }
+                        if (csr.columnIndices[k] == row)
+                            diagonalPosition = position;
+                        filteredColumns[position] = csr.columnIndices[k];
+                        filteredValues[position++] = csr.values[k];
+                    }
+                    if (diagonalPosition != numeric_limits<unsigned>::max())
+                        filteredValues[diagonalPosition] += lumped;
+                }
+            }, n);
+            auto storage = make_shared<CSRStorageDataProvider<T>>(values, columnIndices, rowOffsets, n, n, threads);
+            return make_shared<NumericalMatrix<T>>(n, n, storage);
+        }
+
+        /**
+        * @brief Greedy aggregation of the strong graph, the off-diagonal pattern of the filtered matrix. Isolated
+        * nodes, without strong connections, are left out of the aggregates (value unaggregated) and are only smoothed,
+        * otherwise they would survive as singletons on every level and stall the coarsening.
+        *
+        * Every thread aggregates its own range of rows. In passes 1 and 3 the neighbours of other threads neither block
+        * a root nor join its aggregates, and each thread numbers its aggregates locally until the barrier gives the
+        * offsets of the previous threads. Pass 2 fixes up the boundaries: a node left over by its own thread joins any
+        * neighbouring aggregate of pass 1, including those of other threads. With one thread the passes are the
+        * sequential greedy aggregation.
+        * @return The number of aggregates.
+        */
+        unsigned _aggregate(const shared_ptr<NumericalMatrix<T>> &filtered, vector<unsigned> &aggregates) const {
+            auto csr = this->_csrArrays(filtered);
+            unsigned n = csr.numberOfRows;
+            const unsigned* strongOffsets = csr.rowOffsets;
+            const unsigned* strongNeighbours = csr.columnIndices;
+            const unsigned free = unaggregated - 1;
+            aggregates.assign(n, free);
+            vector<unsigned> firstPass(n);
+            vector<unsigned> firstPassCounts(this->_availableThreads, 0), thirdPassCounts(this->_availableThreads, 0);
+            ThreadingOperations<T>::executeParallelTeamJob([&](unsigned thread, unsigned start, unsigned end, ThreadBarrier &barrier) {
+                auto isOwn = [&](unsigned row) { return row >= start && row < end; };
+                for (unsigned row = start; row < end; row++) {
+                    bool isolated = true;
+                    for (unsigned k = strongOffsets[row]; k < strongOffsets[row + 1] && isolated; k++)
+                        isolated = strongNeighbours[k] == row;
+                    if (isolated)
+                        aggregates[row] = unaggregated;
+                }
+                //Pass 1: roots with free strong neighbourhoods
+                unsigned count = 0;
+                for (unsigned row = start; row < end; row++) {
+                    if (aggregates[row] != free)
+                        continue;
+                    bool neighbourhoodFree = true;
+                    for (unsigned k = strongOffsets[row]; k < strongOffsets[row + 1] && neighbourhoodFree; k++) {
+                        unsigned neighbour = strongNeighbours[k];
+                        neighbourhoodFree = !isOwn(neighbour) || aggregates[neighbour] == free || aggregates[neighbour] == unaggregated;
+                    }
+                    if (!neighbourhoodFree)
+                        continue;
+                    aggregates[row] = count;
+                    for (unsigned k = strongOffsets[row]; k < strongOffsets[row + 1]; k++)
+                        if (isOwn(strongNeighbours[k]) && aggregates[strongNeighbours[k]] == free)
+                            aggregates[strongNeighbours[k]] = count;
+                    count++;
+                }
+                firstPassCounts[thread] = count;
+                barrier.wait();
+                unsigned offset = std::accumulate(firstPassCounts.begin(), firstPassCounts.begin() + thread, 0u);
+                unsigned firstPassAggregates = std::accumulate(firstPassCounts.begin(), firstPassCounts.end(), 0u);
+                for (unsigned row = start; row < end; row++) {
+                    if (aggregates[row] < free)
+                        aggregates[row] += offset;
+                    firstPass[row] = aggregates[row];
+                }
+                barrier.wait();
+                //Pass 2: join an aggregate of pass 1 through a strong connection
+                for (unsigned row = start; row < end; row++) {
+                    if (aggregates[row] != free)
+                        continue;
+                    for (unsigned k = strongOffsets[row]; k < strongOffsets[row + 1]; k++) {
+                        if (firstPass[strongNeighbours[k]] < firstPassAggregates) {
+                            aggregates[row] = firstPass[strongNeighbours[k]];
+                            break;
+                        }
+                    }
+                }
+                //Pass 3: new aggregates of the remaining nodes and their free strong neighbours
+                count = 0;
+                for (unsigned row = start; row < end; row++) {
+                    if (aggregates[row] != free)
+                        continue;
+                    aggregates[row] = firstPassAggregates + count;
+                    for (unsigned k = strongOffsets[row]; k < strongOffsets[row + 1]; k++)
+                        if (isOwn(strongNeighbours[k]) && aggregates[strongNeighbours[k]] == free)
+                            aggregates[strongNeighbours[k]] = firstPassAggregates + count;
+                    count++;
+                }
+                thirdPassCounts[thread] = count;
+                barrier.wait();
+                offset = std::accumulate(thirdPassCounts.begin(), thirdPassCounts.begin() + thread, 0u);
+                for (unsigned row = start; row < end; row++)
+                    if (aggregates[row] >= firstPassAggregates && aggregates[row] < free)
+                        aggregates[row] += offset;
+            }, n, this->_availableThreads);
+            return std::accumulate(firstPassCounts.begin(), firstPassCounts.end(), 0u) +
+                   std::accumulate(thirdPassCounts.begin(), thirdPassCounts.end(), 0u);
+        }
+
+        /**
+        * @brief Builds the smoothed prolongator, the restriction and the Galerkin operator between level l and l + 1.
+        */
+        void _buildTransfer(unsigned l, const shared_ptr<NumericalMatrix<T>> &filtered) {
+            auto &fine = this->_levels[l];
+            auto &A = fine.matrix;
+            unsigned n = A->numberOfRows();
+            unsigned threads = this->_availableThreads;
+            const auto &aggregates = _aggregates[l];
+            unsigned numberOfAggregates = _numberOfAggregates[l];
+
+            //Tentative prolongator with one normalized element per row
+            vector<unsigned> aggregateSizes(numberOfAggregates, 0);
+            auto tentativeOffsets = make_shared<NumericalVector<unsigned>>(n + 1, 0, threads);
+            for (unsigned row = 0; row < n; row++) {
+                bool aggregated = aggregates[row] != unaggregated;
+                if (aggregated)
+                    aggregateSizes[aggregates[row]]++;
+                (*tentativeOffsets)[row + 1] = (*tentativeOffsets)[row] + aggregated;
+            }
+            unsigned tentativeNonZeros = (*tentativeOffsets)[n];
+            auto tentativeValues = make_shared<NumericalVector<T>>(tentativeNonZeros, 0, threads);
+            auto tentativeColumns = make_shared<NumericalVector<unsigned>>(tentativeNonZeros, 0, threads);
+            this->_parallelFor([&](unsigned start, unsigned end) {
+                for (unsigned row = start; row < end; row++) {
+                    if (aggregates[row] == unaggregated)
+                        continue;
+                    unsigned k = (*tentativeOffsets)[row];
+                    (*tentativeValues)[k] = 1 / std::sqrt(static_cast<T>(aggregateSizes[aggregates[row]]));
+                    (*tentativeColumns)[k] = aggregates[row];
+                }
+            }, n);
+            auto tentativeStorage = make_shared<CSRStorageDataProvider<T>>(tentativeValues, tentativeColumns, tentativeOffsets,
+                                                                           n, numberOfAggregates, threads);
+            NumericalMatrix<T> tentative(n, numberOfAggregates, tentativeStorage);
+
+            //Smoother S = I - ω D_F^-1 A_F on the pattern of A_F
+            auto inverseDiagonal = this->_inverseDiagonal(filtered);
+            T weight = static_cast<T>(4) / (3 * _spectralRadiusEstimate(filtered, inverseDiagonal));
+            auto csr = this->_csrArrays(filtered);
+            auto smootherValues = make_shared<NumericalVector<T>>(csr.rowOffsets[n], 0, threads);
+            auto smootherColumns = make_shared<NumericalVector<unsigned>>(csr.rowOffsets[n], 0, threads);
+            auto smootherOffsets = make_shared<NumericalVector<unsigned>>(n + 1, 0, threads);
+            std::copy(csr.rowOffsets, csr.rowOffsets + n + 1, smootherOffsets->getDataPointer());
+            std::copy(csr.columnIndices, csr.columnIndices + csr.rowOffsets[n], smootherColumns->getDataPointer());
+            T* smootherData = smootherValues->getDataPointer();
+            this->_parallelFor([&](unsigned start, unsigned end) {
+                for (unsigned row = start; row < end; row++)
+                    for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++)
+                        smootherData[k] = (csr.columnIndices[k] == row ? 1 : 0) - weight * inverseDiagonal[row] * csr.values[k];
+            }, n);
+            auto smootherStorage = make_shared<CSRStorageDataProvider<T>>(smootherValues, smootherColumns, smootherOffsets,
+                                                                          n, n, threads);
+            NumericalMatrix<T> smoother(n, n, smootherStorage);
+
+            fine.prolongation = NumericalMatrixSparseProducts<T>::multiply(smoother, tentative, threads);
+            fine.restriction = NumericalMatrixSparseProducts<T>::transpose(*fine.prolongation, threads);
+            this->_levels[l + 1].matrix = NumericalMatrixSparseProducts<T>::galerkinProduct(
+                    *fine.prolongation, *A, *fine.prolongation, threads);
+        }
+
+        /**
+        * @brief Estimates ρ(D^-1 A) with 10 power iterations.
+        */
+        T _spectralRadiusEstimate(const shared_ptr<NumericalMatrix<T>> &A, const vector<T> &inverseDiagonal) const {
+            unsigned n = A->numberOfRows();
+            unsigned threads = this->_availableThreads;
+            NumericalVector<T> x(n, 0, threads), y(n, 0, threads);
+            for (unsigned i = 0; i < n; i++)
+                x[i] = 1 + static_cast<T>(i % 7) / 7;
+            x.scale(1 / std::sqrt(x.dotProduct(x, threads)), threads);
+            T radius = 1;
+            for (unsigned iteration = 0; iteration < 10; iteration++) {
+                A->multiplyVector(x, y);
+                T* yData = y.getDataPointer();
+                this->_parallelFor([&](unsigned start, unsigned end) {
+                    for (unsigned i = start; i < end; i++)
+                        yData[i] *= inverseDiagonal[i];
+                }, n);
+                radius = std::sqrt(y.dotProduct(y, threads));
+                if (radius == static_cast<T>(0))
+                    return 1;
+                std::copy(yData, yData + n, x.getDataPointer());
+                x.scale(1 / radius, threads);
+            }
+            return radius;
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_SMOOTHEDAGGREGATIONMULTIGRID_H
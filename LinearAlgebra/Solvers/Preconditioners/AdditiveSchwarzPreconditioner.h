@@ -0,0 +1,463 @@
+//
+// Created by hal9000 on 11/9/23.
+//
+
+#ifndef UNTITLED_ADDITIVESCHWARZPRECONDITIONER_H
+#define UNTITLED_ADDITIVESCHWARZPRECONDITIONER_H
+
+#include <exception>
+#include <functional>
+#include "IncompleteLUPreconditioner.h"
+#include "../Direct/BandedLU.h"
+#include "../../Array/DecompositionMethods/BlockedLU.h"
+#include "../../../PositioningInSpace/DirectionsPositions.h"
+
+namespace LinearAlgebra {
+
+    enum SchwarzSubdomainSolver {
+        //Banded LU of the subdomain matrix, an exact subdomain solve
+        DirectSubdomainSolver,
+        //ILU(0) of the subdomain matrix
+        IncompleteLUSubdomainSolver
+    };
+
+    /**
+    * @brief Overlapping additive Schwarz domain decomposition preconditioner, one subdomain per thread.
+    *
+    * The unknowns are partitioned into non-overlapping cores, which are extended by overlap layers of neighbours in
+    * the graph of the matrix. Each subdomain matrix A_i = R_i A R_i^T keeps the couplings inside the subdomain
+    * (homogeneous Dirichlet conditions on its boundary) and is factorized once by its own solver. apply() computes
+    *   z = M r, M = Σ R_i^T A_i^-1 R_i
+    * with the subdomain solves running concurrently, every thread working on the rows of its own subdomains, which
+    * stay in its cache, instead of sweeping the whole vector in every kernel. The subdomain solves are serial, so the
+    * preconditioner scales with the subdomains, not with the parallelism of a triangular solve.
+    *
+    * The cores are boxes of the structured grid if its dimensions are set (lexicographic order, direction One
+    * fastest), splitting the directions so that the interface is smallest, otherwise contiguous ranges of rows with
+    * balanced non-zeros. The optional coarse correction Q = R_0^T A_0^-1 R_0 uses the Nicolaides space of the
+    * indicator vectors of the cores, A_0 = R_0 A R_0^T is a dense p x p matrix. It carries the global information
+    * that the local solves lack, so that the iterations grow less with the number of subdomains. It is combined in the
+    * balanced form z = Q r + (I - Q A) M (I - A Q) r, which stays symmetric and removes the coarse components from the
+    * local solves, at the cost of two matrix vector products per apply(). Added to M instead, the coarse correction
+    * barely helps.
+    *
+    * The additive preconditioner is symmetric for a symmetric matrix and preconditions PCG. The restricted variant
+    * (RAS) adds only the core rows of every subdomain solve, which needs no accumulation and usually converges
+    * faster, but is non-symmetric and requires GMRES or BiCGStab.
+    *
+    * @tparam T The datatype of the matrix and vector elements.
+    */
+    template<typename T>
+    class AdditiveSchwarzPreconditioner : public Preconditioner<T> {
+    public:
+        /**
+        * @param numberOfSubdomains The number of subdomains, 0 for one per thread of the matrix.
+        * @param overlap The layers of neighbours added to every core.
+        * @param subdomainSolver The solver of the subdomain matrices.
+        * @param coarseCorrection Adds the coarse correction of the Nicolaides space.
+        */
+        explicit AdditiveSchwarzPreconditioner(unsigned numberOfSubdomains = 0, unsigned overlap = 1,
+                                               SchwarzSubdomainSolver subdomainSolver = IncompleteLUSubdomainSolver,
+                                               bool coarseCorrection = false) :
+                _requestedSubdomains(numberOfSubdomains), _overlap(overlap), _subdomainSolver(subdomainSolver),
+                _coarseCorrection(coarseCorrection), _restricted(false) {
+            _updateName();
+        }
+
+        /**
+        * @brief Partitions the unknowns of a nx x ny (x nz) grid into boxes. Call before setup().
+        */
+        void setGridDimensions(const map<PositioningInSpace::Direction, unsigned> &unknownsPerDirection) {
+            _gridDimensions.clear();
+            for (auto direction : {PositioningInSpace::One, PositioningInSpace::Two, PositioningInSpace::Three}) {
+                auto count = unknownsPerDirection.find(direction);
+                if (count != unknownsPerDirection.end() && count->second > 0)
+                    _gridDimensions.push_back(count->second);
+            }
+        }
+
+        /**
+        * @brief Uses the restricted additive Schwarz variant. Non-symmetric, for GMRES and BiCGStab.
+        */
+        void setRestricted(bool restricted) {
+            _restricted = restricted;
+            _updateName();
+        }
+
+        void setup(const shared_ptr<NumericalMatrix<T>> &matrix) override {
+            auto csr = this->_csrArrays(matrix);
+            unsigned n = csr.numberOfRows;
+            this->_numberOfRows = n;
+            this->_availableThreads = matrix->dataStorage->getAvailableThreads();
+            this->_isSetUp = false;
+            unsigned p = _requestedSubdomains > 0 ? _requestedSubdomains : this->_availableThreads;
+            p = std::max(1u, std::min(p, n));
+
+            _owner.assign(n, 0);
+            _partition.clear();
+            if (!_gridDimensions.empty())
+                _boxPartition(n, p);
+            if (_partition.empty())
+                _rowPartition(csr, p);
+            _subdomains.assign(p, Subdomain());
+            for (unsigned row = 0; row < n; row++)
+                _subdomains[_owner[row]].core.push_back(row);
+
+            _parallelForSubdomains([&](unsigned s) {
+                _extend(csr, _subdomains[s]);
+                _factorize(csr, _subdomains[s]);
+            });
+            _buildAccumulation(n);
+            _matrix = _coarseCorrection ? matrix : nullptr;
+            if (_coarseCorrection)
+                _factorizeCoarseMatrix(csr);
+            this->_markSetUp();
+        }
+
+        /**
+        * @brief z = M r with M = Σ R_i^T A_i^-1 R_i, or z = Q r + (I - Q A) M (I - A Q) r with the coarse correction.
+        */
+        void apply(NumericalVector<T> &r, NumericalVector<T> &z) override {
+            this->_checkApply(r, z);
+            if (!_coarseCorrection) {
+                _localSolves(r.getDataPointer(), z.getDataPointer());
+                return;
+            }
+            auto csr = this->_csrArrays(_matrix);
+            const T* residual = r.getDataPointer();
+            T* result = z.getDataPointer();
+            T* projected = _projectedResidual->getDataPointer();
+            //q = Q r, t = r - A q
+            _coarseSolve([&](unsigned row) { return residual[row]; }, _coarseSolution);
+            this->_parallelFor([&](unsigned start, unsigned end) {
+                for (unsigned row = start; row < end; row++) {
+                    T sum = residual[row];
+                    for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++)
+                        sum -= csr.values[k] * _coarseSolution[_owner[csr.columnIndices[k]]];
+                    projected[row] = sum;
+                }
+            }, this->_numberOfRows);
+            //y = M t, z = y + q - Q A y
+            _localSolves(projected, result);
+            _coarseSolve([&](unsigned row) {
+                T sum = 0;
+                for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++)
+                    sum += csr.values[k] * result[csr.columnIndices[k]];
+                return sum;
+            }, _coarseCorrectionOfLocal);
+            this->_parallelFor([&](unsigned start, unsigned end) {
+                for (unsigned row = start; row < end; row++)
+                    result[row] += _coarseSolution[_owner[row]] - _coarseCorrectionOfLocal[_owner[row]];
+            }, this->_numberOfRows);
+        }
+
+        unsigned getNumberOfSubdomains() const {
+            return static_cast<unsigned>(_subdomains.size());
+        }
+
+        /**
+        * @brief The subdomains per direction of the box partition, empty for the partition into rows.
+        */
+        const vector<unsigned> &getPartition() const {
+            return _partition;
+        }
+
+        /**
+        * @brief The rows of a subdomain with its overlap, sorted.
+        */
+        const vector<unsigned> &getSubdomainRows(unsigned subdomain) const {
+            return _subdomains.at(subdomain).rows;
+        }
+
+        /**
+        * @brief The non-overlapping rows of a subdomain.
+        */
+        const vector<unsigned> &getSubdomainCore(unsigned subdomain) const {
+            return _subdomains.at(subdomain).core;
+        }
+
+    private:
+        struct Subdomain {
+            vector<unsigned> core;
+            vector<unsigned> rows;
+            shared_ptr<NumericalMatrix<T>> matrix;
+            shared_ptr<Preconditioner<T>> solver;
+            shared_ptr<NumericalVector<T>> rhs;
+            shared_ptr<NumericalVector<T>> solution;
+        };
+
+        unsigned _requestedSubdomains;
+
+        unsigned _overlap;
+
+        SchwarzSubdomainSolver _subdomainSolver;
+
+        bool _coarseCorrection;
+
+        bool _restricted;
+
+        vector<unsigned> _gridDimensions;
+
+        vector<unsigned> _partition;
+
+        vector<unsigned> _owner;
+
+        vector<Subdomain> _subdomains;
+
+        //The (subdomain, local row) pairs that add to every row of z
+        vector<unsigned> _contributionOffsets;
+
+        vector<unsigned> _contributionSubdomains;
+
+        vector<unsigned> _contributionPositions;
+
+        vector<T> _coarseFactors;
+
+        vector<unsigned> _coarsePermutation;
+
+        vector<T> _coarseRhs;
+
+        vector<T> _coarseSolution;
+
+        vector<T> _coarseCorrectionOfLocal;
+
+        shared_ptr<NumericalVector<T>> _projectedResidual;
+
+        shared_ptr<NumericalMatrix<T>> _matrix;
+
+        void _updateName() {
+            this->_name = string(_restricted ? "RAS" : "ASM") + "(" + to_string(_overlap) + ", " +
+                          (_subdomainSolver == DirectSubdomainSolver ? "LU" : "ILU(0)") + (_coarseCorrection ? ", coarse" : "") + ")";
+        }
+
+        /**
+        * @brief Runs job(subdomain) for all the subdomains, one or more per thread. The first exception of a job is
+        * rethrown after all the threads are joined.
+        */
+        template<typename SubdomainJob>
+        void _parallelForSubdomains(SubdomainJob job) {
+            vector<exception_ptr> errors(_subdomains.size());
+            ThreadingOperations<T>::executeParallelJob([&](unsigned start, unsigned end) {
+                for (unsigned s = start; s < end; s++) {
+                    try { job(s); } catch (...) { errors[s] = current_exception(); }
+                }
+            }, _subdomains.size(), this->_availableThreads, sizeof(T));
+            for (auto &error : errors)
+                if (error)
+                    rethrow_exception(error);
+        }
+
+        /**
+        * @brief result = Σ R_i^T A_i^-1 R_i residual, the subdomain solves in parallel.
+        */
+        void _localSolves(const T* residual, T* result) {
+            _parallelForSubdomains([&](unsigned s) {
+                auto &subdomain = _subdomains[s];
+                T* localRhs = subdomain.rhs->getDataPointer();
+                for (unsigned i = 0; i < subdomain.rows.size(); i++)
+                    localRhs[i] = residual[subdomain.rows[i]];
+                subdomain.solver->apply(*subdomain.rhs, *subdomain.solution);
+            });
+            this->_parallelFor([&](unsigned start, unsigned end) {
+                for (unsigned row = start; row < end; row++) {
+                    T sum = 0;
+                    for (unsigned k = _contributionOffsets[row]; k < _contributionOffsets[row + 1]; k++)
+                        sum += _subdomains[_contributionSubdomains[k]].solution->getDataPointer()[_contributionPositions[k]];
+                    result[row] = sum;
+                }
+            }, this->_numberOfRows);
+        }
+
+        /**
+        * @brief coarseSolution = A_0^-1 R_0 v, the restriction summing entry(row) over the core of every subdomain.
+        */
+        template<typename Entry>
+        void _coarseSolve(Entry entry, vector<T> &coarseSolution) {
+            unsigned p = getNumberOfSubdomains();
+            _parallelForSubdomains([&](unsigned s) {
+                T sum = 0;
+                for (unsigned row : _subdomains[s].core)
+                    sum += entry(row);
+                _coarseRhs[s] = sum;
+            });
+            BlockedLU<T>::solve(_coarseFactors.data(), p, p, _coarsePermutation, _coarseRhs.data(), coarseSolution.data());
+        }
+
+        /**
+        * @brief Contiguous ranges of rows with about nnz / p non-zeros each.
+        */
+        void _rowPartition(const typename Preconditioner<T>::CSRArrays &csr, unsigned p) {
+            unsigned n = csr.numberOfRows;
+            double nonZerosPerSubdomain = static_cast<double>(csr.rowOffsets[n]) / p;
+            unsigned subdomain = 0;
+            for (unsigned row = 0; row < n; row++) {
+                //Close the subdomain at its share of the non-zeros, leaving at least one row for each of the next ones
+                while (subdomain + 1 < p && (csr.rowOffsets[row] >= (subdomain + 1) * nonZerosPerSubdomain || n - row <= p - 1 - subdomain) &&
+                       (row == 0 || _owner[row - 1] == subdomain))
+                    subdomain++;
+                _owner[row] = subdomain;
+            }
+        }
+
+        /**
+        * @brief Boxes of the grid. The p subdomains are split among the directions as p_1 p_2 p_3 = p with p_d <= n_d
+        * and the smallest interface Σ (p_d - 1) Π_{e != d} n_e. Leaves the partition empty if no split exists.
+        */
+        void _boxPartition(unsigned n, unsigned p) {
+            unsigned dimensions = static_cast<unsigned>(_gridDimensions.size());
+            unsigned unknowns = 1;
+            for (auto count : _gridDimensions)
+                unknowns *= count;
+            if (unknowns != n)
+                throw invalid_argument("The grid dimensions do not match the size of the matrix.");
+            vector<unsigned> split(dimensions, 1);
+            double bestInterface = -1;
+            function<void(unsigned, unsigned)> search = [&](unsigned d, unsigned remaining) {
+                if (d + 1 == dimensions) {
+                    if (remaining > _gridDimensions[d])
+                        return;
+                    split[d] = remaining;
+                    double interface = 0;
+                    for (unsigned e = 0; e < dimensions; e++)
+                        interface += static_cast<double>(split[e] - 1) * n / _gridDimensions[e];
+                    if (bestInterface < 0 || interface < bestInterface) {
+                        bestInterface = interface;
+                        _partition = split;
+                    }
+                    return;
+                }
+                for (unsigned count = 1; count <= std::min(remaining, _gridDimensions[d]); count++)
+                    if (remaining % count == 0) {
+                        split[d] = count;
+                        search(d + 1, remaining / count);
+                    }
+            };
+            search(0, p);
+            if (_partition.empty())
+                return;
+            for (unsigned row = 0; row < n; row++) {
+                unsigned index = row, box = 0, stride = 1;
+                for (unsigned d = 0; d < dimensions; d++) {
+                    unsigned coordinate = index % _gridDimensions[d];
+                    index /= _gridDimensions[d];
+                    box += static_cast<unsigned>(static_cast<unsigned long>(coordinate) * _partition[d] / _gridDimensions[d]) * stride;
+                    stride *= _partition[d];
+                }
+                _owner[row] = box;
+            }
+        }
+
+        /**
+        * @brief Adds the overlap layers to the core by breadth first search in the graph of the matrix.
+        */
+        void _extend(const typename Preconditioner<T>::CSRArrays &csr, Subdomain &subdomain) {
+            vector<bool> added(csr.numberOfRows, false);
+            subdomain.rows = subdomain.core;
+            for (unsigned row : subdomain.core)
+                added[row] = true;
+            unsigned layerStart = 0;
+            for (unsigned layer = 0; layer < _overlap; layer++) {
+                unsigned layerEnd = static_cast<unsigned>(subdomain.rows.size());
+                for (unsigned position = layerStart; position < layerEnd; position++) {
+                    unsigned row = subdomain.rows[position];
+                    for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++)
+                        if (!added[csr.columnIndices[k]]) {
+                            added[csr.columnIndices[k]] = true;
+                            subdomain.rows.push_back(csr.columnIndices[k]);
+                        }
+                }
+                layerStart = layerEnd;
+            }
+            std::sort(subdomain.rows.begin(), subdomain.rows.end());
+        }
+
+        /**
+        * @brief Extracts A_i = R_i A R_i^T, rows and columns in increasing global order, and sets up its solver.
+        */
+        void _factorize(const typename Preconditioner<T>::CSRArrays &csr, Subdomain &subdomain) {
+            unsigned m = static_cast<unsigned>(subdomain.rows.size());
+            auto &rows = subdomain.rows;
+            auto rowOffsets = make_shared<NumericalVector<unsigned>>(m + 1, 0u, 1);
+            unsigned* offsets = rowOffsets->getDataPointer();
+            //Merges the sorted columns of every row with the sorted rows of the subdomain
+            auto localColumns = [&](unsigned row, auto visit) {
+                unsigned position = 0;
+                for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++) {
+                    unsigned column = csr.columnIndices[k];
+                    position = static_cast<unsigned>(std::lower_bound(rows.begin() + position, rows.end(), column) - rows.begin());
+                    if (position < m && rows[position] == column)
+                        visit(position, csr.values[k]);
+                }
+            };
+            for (unsigned i = 0; i < m; i++) {
+                offsets[i + 1] = offsets[i];
+                localColumns(rows[i], [&](unsigned, T) { offsets[i + 1]++; });
+            }
+            auto values = make_shared<NumericalVector<T>>(offsets[m], 0, 1);
+            auto columnIndices = make_shared<NumericalVector<unsigned>>(offsets[m], 0u, 1);
+            for (unsigned i = 0; i < m; i++) {
+                unsigned position = offsets[i];
+                localColumns(rows[i], [&](unsigned column, T value) {
+                    (*columnIndices)[position] = column;
+                    (*values)[position++] = value;
+                });
+            }
+            auto storage = make_shared<CSRStorageDataProvider<T>>(values, columnIndices, rowOffsets, m, m, 1);
+            subdomain.matrix = make_shared<NumericalMatrix<T>>(m, m, storage);
+            if (_subdomainSolver == DirectSubdomainSolver)
+                subdomain.solver = make_shared<BandedLU<T>>();
+            else
+                subdomain.solver = make_shared<IncompleteLUPreconditioner<T>>();
+            subdomain.solver->setup(subdomain.matrix);
+            subdomain.rhs = make_shared<NumericalVector<T>>(m, 0, 1);
+            subdomain.solution = make_shared<NumericalVector<T>>(m, 0, 1);
+        }
+
+        /**
+        * @brief The (subdomain, local row) pairs of every row: all the subdomains that contain it, or only the owner
+        * for the restricted variant.
+        */
+        void _buildAccumulation(unsigned n) {
+            _contributionOffsets.assign(n + 1, 0);
+            for (unsigned s = 0; s < _subdomains.size(); s++)
+                for (unsigned row : _subdomains[s].rows)
+                    if (!_restricted || _owner[row] == s)
+                        _contributionOffsets[row + 1]++;
+            for (unsigned row = 0; row < n; row++)
+                _contributionOffsets[row + 1] += _contributionOffsets[row];
+            _contributionSubdomains.assign(_contributionOffsets[n], 0);
+            _contributionPositions.assign(_contributionOffsets[n], 0);
+            vector<unsigned> next(_contributionOffsets.begin(), _contributionOffsets.end() - 1);
+            for (unsigned s = 0; s < _subdomains.size(); s++) {
+                auto &rows = _subdomains[s].rows;
+                for (unsigned i = 0; i < rows.size(); i++)
+                    if (!_restricted || _owner[rows[i]] == s) {
+                        _contributionSubdomains[next[rows[i]]] = s;
+                        _contributionPositions[next[rows[i]]++] = i;
+                    }
+            }
+        }
+
+        /**
+        * @brief A_0 = R_0 A R_0^T with R_0 the indicators of the cores, factorized with partial pivoting.
+        * @throws runtime_error If A_0 is singular.
+        */
+        void _factorizeCoarseMatrix(const typename Preconditioner<T>::CSRArrays &csr) {
+            unsigned p = getNumberOfSubdomains();
+            _coarseFactors.assign(static_cast<size_t>(p) * p, 0);
+            for (unsigned row = 0; row < csr.numberOfRows; row++)
+                for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++)
+                    _coarseFactors[static_cast<size_t>(_owner[row]) * p + _owner[csr.columnIndices[k]]] += csr.values[k];
+            unsigned numberOfSwaps;
+            if (BlockedLU<T>::factorize(_coarseFactors.data(), p, p, _coarsePermutation, numberOfSwaps) != p)
+                throw runtime_error("The coarse matrix of the additive Schwarz preconditioner is singular.");
+            _coarseRhs.assign(p, 0);
+            _coarseSolution.assign(p, 0);
+            _coarseCorrectionOfLocal.assign(p, 0);
+            _projectedResidual = make_shared<NumericalVector<T>>(csr.numberOfRows, 0, this->_availableThreads);
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_ADDITIVESCHWARZPRECONDITIONER_H
@@ -0,0 +1,133 @@
+//
+// Created by hal9000 on 10/25/23.
+//
+
+#ifndef UNTITLED_BLOCKJACOBIPRECONDITIONER_H
+#define UNTITLED_BLOCKJACOBIPRECONDITIONER_H
+
+#include <atomic>
+#include "Preconditioner.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Block diagonal preconditioner with contiguous diagonal blocks of blockSize rows (the last one may be
+    * smaller).
+    *
+    * Each block is extracted as a dense matrix and factorized in place with partial pivoting LU. With blockSize equal to
+    * the degrees of freedom per node it couples the unknowns of each node, with blockSize equal to the nodes of a grid
+    * line it becomes a line Jacobi preconditioner. The blocks are independent, so setup and apply run in parallel.
+    */
+    template<typename T>
+    class BlockJacobiPreconditioner : public Preconditioner<T> {
+    public:
+        explicit BlockJacobiPreconditioner(unsigned blockSize = 4) : _blockSize(blockSize) {
+            if (blockSize == 0)
+                throw invalid_argument("Block size must be positive.");
+            this->_name = "Block Jacobi (" + to_string(blockSize) + ")";
+        }
+
+        void setup(const shared_ptr<NumericalMatrix<T>> &matrix) override {
+            auto csr = this->_csrArrays(matrix);
+            unsigned n = csr.numberOfRows;
+            this->_numberOfRows = n;
+            this->_availableThreads = matrix->dataStorage->getAvailableThreads();
+            unsigned numberOfBlocks = (n + _blockSize - 1) / _blockSize;
+            _factors.assign(static_cast<size_t>(numberOfBlocks) * _blockSize * _blockSize, 0);
+            _pivots.assign(static_cast<size_t>(numberOfBlocks) * _blockSize, 0);
+
+            atomic<bool> singular(false);
+            this->_parallelFor([&](unsigned startBlock, unsigned endBlock) {
+                for (unsigned block = startBlock; block < endBlock; block++) {
+                    unsigned first = block * _blockSize;
+                    unsigned size = std::min(_blockSize, n - first);
+                    T* factor = _blockFactor(block);
+                    for (unsigned i = 0; i < size; i++)
+                        for (unsigned k = csr.rowOffsets[first + i]; k < csr.rowOffsets[first + i + 1]; k++)
+                            if (csr.columnIndices[k] >= first && csr.columnIndices[k] < first + size)
+                                factor[i * size + csr.columnIndices[k] - first] = csr.values[k];
+                    if (!_factorize(factor, _blockPivots(block), size))
+                        singular = true;
+                }
+            }, numberOfBlocks);
+            if (singular)
+                throw runtime_error("Singular diagonal block.");
+            this->_markSetUp();
+        }
+
+        void apply(NumericalVector<T> &r, NumericalVector<T> &z) override {
+            this->_checkApply(r, z);
+            unsigned n = this->_numberOfRows;
+            const T* residual = r.getDataPointer();
+            T* result = z.getDataPointer();
+            this->_parallelFor([&](unsigned startBlock, unsigned endBlock) {
+                for (unsigned block = startBlock; block < endBlock; block++) {
+                    unsigned first = block * _blockSize;
+                    unsigned size = std::min(_blockSize, n - first);
+                    const T* factor = _blockFactor(block);
+                    const unsigned* pivots = _blockPivots(block);
+                    T* x = result + first;
+                    for (unsigned i = 0; i < size; i++)
+                        x[i] = residual[first + pivots[i]];
+                    for (unsigned i = 0; i < size; i++)
+                        for (unsigned j = 0; j < i; j++)
+                            x[i] -= factor[i * size + j] * x[j];
+                    for (unsigned i = size; i-- > 0;) {
+                        for (unsigned j = i + 1; j < size; j++)
+                            x[i] -= factor[i * size + j] * x[j];
+                        x[i] /= factor[i * size + i];
+                    }
+                }
+            }, (n + _blockSize - 1) / _blockSize);
+        }
+
+        unsigned getBlockSize() const {
+            return _blockSize;
+        }
+
+    private:
+        unsigned _blockSize;
+
+        vector<T> _factors;
+
+        vector<unsigned> _pivots;
+
+        T* _blockFactor(unsigned block) {
+            return _factors.data() + static_cast<size_t>(block) * _blockSize * _blockSize;
+        }
+
+        unsigned* _blockPivots(unsigned block) {
+            return _pivots.data() + static_cast<size_t>(block) * _blockSize;
+        }
+
+        /**
+        * @brief In place LU with partial pivoting of a dense size x size row major block. pivots[i] is the original
+        * row of row i.
+        */
+        static bool _factorize(T* factor, unsigned* pivots, unsigned size) {
+            for (unsigned i = 0; i < size; i++)
+                pivots[i] = i;
+            for (unsigned k = 0; k < size; k++) {
+                unsigned pivot = k;
+                for (unsigned i = k + 1; i < size; i++)
+                    if (abs(factor[i * size + k]) > abs(factor[pivot * size + k]))
+                        pivot = i;
+                if (factor[pivot * size + k] == static_cast<T>(0))
+                    return false;
+                if (pivot != k) {
+                    std::swap_ranges(factor + k * size, factor + (k + 1) * size, factor + pivot * size);
+                    std::swap(pivots[k], pivots[pivot]);
+                }
+                for (unsigned i = k + 1; i < size; i++) {
+                    T multiplier = factor[i * size + k] /= factor[k * size + k];
+                    for (unsigned j = k + 1; j < size; j++)
+                        factor[i * size + j] -= multiplier * factor[k * size + j];
+                }
+            }
+            return true;
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_BLOCKJACOBIPRECONDITIONER_H
@@ -0,0 +1,228 @@
+//
+// Created by hal9000 on 11/8/23.
+//
+
+#ifndef UNTITLED_CHEBYSHEVPRECONDITIONER_H
+#define UNTITLED_CHEBYSHEVPRECONDITIONER_H
+
+#include "JacobiPreconditioner.h"
+#include "../../EigenDecomposition/SpectralBoundsEstimator.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Jacobi preconditioned Chebyshev polynomial smoother M^-1 = p(D^-1 A) D^-1 of a fixed degree.
+    *
+    * The polynomial damps the eigenvalues of D^-1 A in [lowerFraction λmax, upperFactor λmax], the upper part of the
+    * spectrum that a multigrid smoother has to remove, with λmax estimated once per matrix by the SpectralBoundsCache.
+    * A sweep of degree k costs k matrix vector products (k - 1 from a zero guess) and no inner products, so unlike
+    * Gauss-Seidel it parallelizes as well as the matrix vector product and unlike damped Jacobi it needs no tuned
+    * weight. The polynomial is fixed, so apply() is a symmetric operator and preconditions PCG.
+    *
+    * Works with CSR matrices and, given the diagonal, with matrix-free operators.
+    *
+    * @tparam T The datatype of the matrix and vector elements.
+    */
+    template<typename T>
+    class ChebyshevPreconditioner : public Preconditioner<T> {
+    public:
+        /**
+        * @param degree The matrix vector products of a sweep.
+        * @param lowerFraction The lower end of the damped interval as a fraction of λmax.
+        * @param upperFactor The safety factor of the estimated λmax, the Ritz values underestimate it.
+        */
+        explicit ChebyshevPreconditioner(unsigned degree = 2, double lowerFraction = 0.1, double upperFactor = 1.1) :
+                _degree(std::max(1u, degree)), _lowerFraction(lowerFraction), _upperFactor(upperFactor),
+                _estimator(make_shared<SpectralBoundsEstimator<T>>(LanczosBounds, 10, 1E-2)),
+                _cache(make_shared<SpectralBoundsCache<T>>()), _bounds({0, 0, 0, 0}), _estimationSteps(0) {
+            if (!(lowerFraction > 0 && lowerFraction < 1) || !(upperFactor >= 1))
+                throw invalid_argument("The Chebyshev interval requires 0 < lowerFraction < 1 <= upperFactor.");
+            this->_name = "Chebyshev(" + to_string(_degree) + ")";
+        }
+
+        void setup(const shared_ptr<NumericalMatrix<T>> &matrix) override {
+            _jacobi.setup(matrix);
+            _operator = make_shared<NumericalMatrixOperator<T>>(matrix);
+            _initialize(matrix->dataStorage->getAvailableThreads());
+            auto cached = _cache->find(matrix, SpectralBoundsCache<T>::diagonalScaling);
+            _estimationSteps = 0;
+            if (cached != nullptr)
+                _bounds = *cached;
+            else {
+                _bounds = _estimate();
+                _cache->store(matrix, SpectralBoundsCache<T>::diagonalScaling, _bounds);
+            }
+            this->_markSetUp();
+        }
+
+        /**
+        * @brief Builds the smoother of a matrix-free operator from its diagonal. The operator must outlive the
+        * smoother.
+        */
+        void setup(const shared_ptr<LinearOperator<T>> &matrixFree, const NumericalVector<T> &diagonal, unsigned availableThreads = 1) {
+            if (matrixFree->numberOfRows() != diagonal.size() || matrixFree->numberOfColumns() != diagonal.size())
+                throw invalid_argument("The diagonal does not match the size of the operator.");
+            _jacobi.setup(diagonal, availableThreads);
+            _operator = matrixFree;
+            _initialize(availableThreads);
+            auto cached = _cache->find(*matrixFree, SpectralBoundsCache<T>::diagonalScaling);
+            _estimationSteps = 0;
+            if (cached != nullptr)
+                _bounds = *cached;
+            else {
+                _bounds = _estimate();
+                _cache->store(*matrixFree, SpectralBoundsCache<T>::diagonalScaling, _bounds);
+            }
+            this->_markSetUp();
+        }
+
+        /**
+        * @brief z = p(D^-1 A) D^-1 r, one sweep from z = 0.
+        */
+        void apply(NumericalVector<T> &r, NumericalVector<T> &z) override {
+            this->_checkApply(r, z);
+            std::copy(r.getDataPointer(), r.getDataPointer() + r.size(), _residual->getDataPointer());
+            std::fill(z.getDataPointer(), z.getDataPointer() + z.size(), static_cast<T>(0));
+            _sweep(z);
+        }
+
+        /**
+        * @brief One sweep x = x + p(D^-1 A) D^-1 (b - A x) from the current x.
+        */
+        void smooth(NumericalVector<T> &rhs, NumericalVector<T> &solution) {
+            this->_checkApply(rhs, solution);
+            _operator->multiply(solution, *_residual);
+            _residual->subtractIntoThis(rhs, -1, -1, this->_availableThreads);
+            _sweep(solution);
+        }
+
+        void setDegree(unsigned degree) {
+            _degree = std::max(1u, degree);
+            this->_name = "Chebyshev(" + to_string(_degree) + ")";
+        }
+
+        unsigned getDegree() const {
+            return _degree;
+        }
+
+        /**
+        * @brief Sets the estimator of λmax. Call before setup().
+        * @throws invalid_argument If estimator is null.
+        */
+        void setBoundsEstimator(shared_ptr<SpectralBoundsEstimator<T>> estimator) {
+            if (estimator == nullptr)
+                throw invalid_argument("The spectral bounds estimator cannot be null.");
+            _estimator = std::move(estimator);
+        }
+
+        /**
+        * @brief Shares a cache, e.g. between the smoothers of several hierarchies of the same matrix. Call before
+        * setup().
+        * @throws invalid_argument If cache is null.
+        */
+        void setBoundsCache(shared_ptr<SpectralBoundsCache<T>> cache) {
+            if (cache == nullptr)
+                throw invalid_argument("The spectral bounds cache cannot be null.");
+            _cache = std::move(cache);
+        }
+
+        const shared_ptr<SpectralBoundsCache<T>> &getBoundsCache() const {
+            return _cache;
+        }
+
+        /**
+        * @brief The estimated bounds of D^-1 A, before the lower fraction and the upper factor.
+        */
+        const SpectralBounds &getSpectralBounds() const {
+            return _bounds;
+        }
+
+        /**
+        * @brief The operator applications of the estimate of the last setup(), 0 if the bounds were cached.
+        */
+        unsigned getEstimationSteps() const {
+            return _estimationSteps;
+        }
+
+    private:
+        unsigned _degree;
+
+        double _lowerFraction;
+
+        double _upperFactor;
+
+        JacobiPreconditioner<T> _jacobi;
+
+        shared_ptr<LinearOperator<T>> _operator;
+
+        shared_ptr<SpectralBoundsEstimator<T>> _estimator;
+
+        shared_ptr<SpectralBoundsCache<T>> _cache;
+
+        SpectralBounds _bounds;
+
+        unsigned _estimationSteps;
+
+        shared_ptr<NumericalVector<T>> _residual;
+
+        shared_ptr<NumericalVector<T>> _direction;
+
+        shared_ptr<NumericalVector<T>> _product;
+
+        void _initialize(unsigned availableThreads) {
+            unsigned n = _operator->numberOfRows();
+            this->_numberOfRows = n;
+            this->_availableThreads = std::max(1u, availableThreads);
+            _residual = make_shared<NumericalVector<T>>(n, 0, this->_availableThreads);
+            _direction = make_shared<NumericalVector<T>>(n, 0, this->_availableThreads);
+            _product = make_shared<NumericalVector<T>>(n, 0, this->_availableThreads);
+        }
+
+        SpectralBounds _estimate() {
+            _estimator->setAvailableThreads(this->_availableThreads);
+            auto bounds = _estimator->estimate(*_operator, &_jacobi, true);
+            _estimationSteps = bounds.steps;
+            return bounds;
+        }
+
+        /**
+        * @brief x = x + p(D^-1 A) D^-1 r for the residual r = b - A x in _residual, by the three term recurrence
+        * d_0 = D^-1 r / θ, d_k = ρ_k ρ_{k-1} d_{k-1} + 2 ρ_k / δ D^-1 r_k with θ and δ the center and the half width
+        * of the interval.
+        */
+        void _sweep(NumericalVector<T> &solution) {
+            double upper = _upperFactor * _bounds.maximum, lower = _lowerFraction * _bounds.maximum;
+            double center = 0.5 * (upper + lower), halfWidth = 0.5 * (upper - lower);
+            double sigma = center / halfWidth, rho = 1 / sigma;
+            T* x = solution.getDataPointer();
+            T* r = _residual->getDataPointer();
+            T* d = _direction->getDataPointer();
+            const T* inverseDiagonal = _jacobi.getInverseDiagonal()->getDataPointer();
+            T scale = static_cast<T>(1 / center);
+            this->_parallelFor([&](unsigned start, unsigned end) {
+                for (unsigned i = start; i < end; i++) {
+                    d[i] = scale * inverseDiagonal[i] * r[i];
+                    x[i] += d[i];
+                }
+            }, this->_numberOfRows);
+            for (unsigned k = 1; k < _degree; k++) {
+                //r = r - A d
+                _operator->multiply(*_direction, *_product);
+                const T* product = _product->getDataPointer();
+                double nextRho = 1 / (2 * sigma - rho);
+                T directionScale = static_cast<T>(nextRho * rho), residualScale = static_cast<T>(2 * nextRho / halfWidth);
+                this->_parallelFor([&](unsigned start, unsigned end) {
+                    for (unsigned i = start; i < end; i++) {
+                        r[i] -= product[i];
+                        d[i] = directionScale * d[i] + residualScale * inverseDiagonal[i] * r[i];
+                        x[i] += d[i];
+                    }
+                }, this->_numberOfRows);
+                rho = nextRho;
+            }
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_CHEBYSHEVPRECONDITIONER_H
@@ -0,0 +1,140 @@
+//
+// Created by hal9000 on 10/25/23.
+//
+
+#ifndef UNTITLED_INCOMPLETECHOLESKYPRECONDITIONER_H
+#define UNTITLED_INCOMPLETECHOLESKYPRECONDITIONER_H
+
+#include <cmath>
+#include "Preconditioner.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Zero fill-in incomplete Cholesky preconditioner IC(0), M = L L^T with L restricted to the pattern of the
+    * lower triangle of A.
+    *
+    * Only the lower triangle and the diagonal of the (symmetric) matrix are read. If a pivot is not positive, which
+    * can happen for SPD matrices that are not M-matrices (e.g. skewed curvilinear grids), the factorization is
+    * repeated for A + α diag(A) with α doubled from 1E-3 until it succeeds (Manteuffel shift).
+    * The triangular solves of apply() are sequential.
+    */
+    template<typename T>
+    class IncompleteCholeskyPreconditioner : public Preconditioner<T> {
+    public:
+        IncompleteCholeskyPreconditioner() : _diagonalShift(0) {
+            this->_name = "IC(0)";
+        }
+
+        void setup(const shared_ptr<NumericalMatrix<T>> &matrix) override {
+            auto csr = this->_csrArrays(matrix);
+            unsigned n = csr.numberOfRows;
+            this->_numberOfRows = n;
+            this->_availableThreads = matrix->dataStorage->getAvailableThreads();
+
+            //Lower triangle with the diagonal last in each row
+            _rowOffsets.assign(n + 1, 0);
+            _columnIndices.clear();
+            vector<T> lowerValues;
+            for (unsigned row = 0; row < n; row++) {
+                T diagonal = 0;
+                for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++) {
+                    if (csr.columnIndices[k] < row) {
+                        _columnIndices.push_back(csr.columnIndices[k]);
+                        lowerValues.push_back(csr.values[k]);
+                    }
+                    else if (csr.columnIndices[k] == row)
+                        diagonal = csr.values[k];
+                }
+                if (diagonal <= static_cast<T>(0))
+                    throw runtime_error("IC(0) requires positive diagonal elements. Row " + to_string(row) + ".");
+                _columnIndices.push_back(row);
+                lowerValues.push_back(diagonal);
+                _rowOffsets[row + 1] = _columnIndices.size();
+            }
+
+            _diagonalShift = 0;
+            while (!_factorize(lowerValues, _diagonalShift)) {
+                _diagonalShift = _diagonalShift == 0 ? static_cast<T>(1E-3) : 2 * _diagonalShift;
+                if (_diagonalShift > 1E3)
+                    throw runtime_error("IC(0) factorization failed.");
+            }
+            this->_markSetUp();
+        }
+
+        void apply(NumericalVector<T> &r, NumericalVector<T> &z) override {
+            this->_checkApply(r, z);
+            unsigned n = this->_numberOfRows;
+            const T* residual = r.getDataPointer();
+            T* result = z.getDataPointer();
+            //L y = r
+            for (unsigned row = 0; row < n; row++) {
+                T sum = residual[row];
+                unsigned diagonal = _rowOffsets[row + 1] - 1;
+                for (unsigned k = _rowOffsets[row]; k < diagonal; k++)
+                    sum -= _values[k] * result[_columnIndices[k]];
+                result[row] = sum / _values[diagonal];
+            }
+            //L^T z = y, column oriented over the rows of L
+            for (unsigned row = n; row-- > 0;) {
+                unsigned diagonal = _rowOffsets[row + 1] - 1;
+                result[row] /= _values[diagonal];
+                for (unsigned k = _rowOffsets[row]; k < diagonal; k++)
+                    result[_columnIndices[k]] -= _values[k] * result[row];
+            }
+        }
+
+        /**
+        * @brief Returns the α of the factorized A + α diag(A). 0 if no shift was needed.
+        */
+        T getDiagonalShift() const {
+            return _diagonalShift;
+        }
+
+    private:
+        vector<T> _values;
+
+        vector<unsigned> _columnIndices;
+
+        vector<unsigned> _rowOffsets;
+
+        T _diagonalShift;
+
+        /**
+        * @brief Row oriented IC(0): L_ik = (A_ik - Σ_{j<k} L_ij L_kj) / L_kk and L_ii = sqrt(A_ii - Σ_{j<i} L_ij²),
+        * with the sums over the common pattern of rows i and k.
+        */
+        bool _factorize(const vector<T> &lowerValues, T shift) {
+            unsigned n = this->_numberOfRows;
+            _values = lowerValues;
+            for (unsigned row = 0; row < n; row++) {
+                unsigned diagonal = _rowOffsets[row + 1] - 1;
+                _values[diagonal] *= 1 + shift;
+                for (unsigned p = _rowOffsets[row]; p < diagonal; p++) {
+                    unsigned column = _columnIndices[p];
+                    unsigned q = _rowOffsets[column], columnDiagonal = _rowOffsets[column + 1] - 1;
+                    T sum = _values[p];
+                    for (unsigned k = _rowOffsets[row]; k < p && q < columnDiagonal;) {
+                        if (_columnIndices[k] == _columnIndices[q])
+                            sum -= _values[k++] * _values[q++];
+                        else if (_columnIndices[k] < _columnIndices[q])
+                            k++;
+                        else
+                            q++;
+                    }
+                    _values[p] = sum / _values[columnDiagonal];
+                }
+                T pivot = _values[diagonal];
+                for (unsigned k = _rowOffsets[row]; k < diagonal; k++)
+                    pivot -= _values[k] * _values[k];
+                if (!(pivot > static_cast<T>(0)))
+                    return false;
+                _values[diagonal] = std::sqrt(pivot);
+            }
+            return true;
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_INCOMPLETECHOLESKYPRECONDITIONER_H
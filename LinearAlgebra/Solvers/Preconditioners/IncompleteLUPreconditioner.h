@@ -0,0 +1,112 @@
+//
+// Created by hal9000 on 10/26/23.
+//
+
+#ifndef UNTITLED_INCOMPLETELUPRECONDITIONER_H
+#define UNTITLED_INCOMPLETELUPRECONDITIONER_H
+
+#include "Preconditioner.h"
+#include "SparseTriangularFactor.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Zero fill-in incomplete LU preconditioner ILU(0), M = L U with L unit lower triangular and the pattern
+    * of L + U equal to the pattern of A.
+    *
+    * Unlike IC(0) it does not require a symmetric matrix, so it applies to the non-symmetric systems of
+    * convection-diffusion problems (non-zero first order coefficients) that are solved with GMRES or BiCGStab.
+    * The columns of each CSR row must be sorted, as produced by the CSR builder. apply() solves L y = r and U z = y
+    * with level scheduled triangular solves that use the threads of the matrix.
+    */
+    template<typename T>
+    class IncompleteLUPreconditioner : public Preconditioner<T> {
+    public:
+        IncompleteLUPreconditioner() {
+            this->_name = "ILU(0)";
+        }
+
+        void setup(const shared_ptr<NumericalMatrix<T>> &matrix) override {
+            auto csr = this->_csrArrays(matrix);
+            unsigned n = csr.numberOfRows;
+            this->_numberOfRows = n;
+            this->_availableThreads = matrix->dataStorage->getAvailableThreads();
+
+            vector<T> values(csr.values, csr.values + csr.rowOffsets[n]);
+            vector<unsigned> diagonalPositions(n);
+            for (unsigned row = 0; row < n; row++) {
+                auto first = csr.columnIndices + csr.rowOffsets[row], last = csr.columnIndices + csr.rowOffsets[row + 1];
+                auto diagonal = std::lower_bound(first, last, row);
+                if (diagonal == last || *diagonal != row)
+                    throw runtime_error("ILU(0) requires a stored diagonal element at row " + to_string(row) + ".");
+                diagonalPositions[row] = static_cast<unsigned>(diagonal - csr.columnIndices);
+            }
+
+            //IKJ variant: row i is eliminated with the already factorized rows k < i, dropping all fill-in
+            vector<int> positionInRow(n, -1);
+            for (unsigned row = 0; row < n; row++) {
+                for (unsigned p = csr.rowOffsets[row]; p < csr.rowOffsets[row + 1]; p++)
+                    positionInRow[csr.columnIndices[p]] = static_cast<int>(p);
+                for (unsigned p = csr.rowOffsets[row]; p < diagonalPositions[row]; p++) {
+                    unsigned k = csr.columnIndices[p];
+                    values[p] /= values[diagonalPositions[k]];
+                    for (unsigned q = diagonalPositions[k] + 1; q < csr.rowOffsets[k + 1]; q++) {
+                        int position = positionInRow[csr.columnIndices[q]];
+                        if (position >= 0)
+                            values[position] -= values[p] * values[q];
+                    }
+                }
+                if (values[diagonalPositions[row]] == static_cast<T>(0))
+                    throw runtime_error("Zero pivot in ILU(0) at row " + to_string(row) + ".");
+                for (unsigned p = csr.rowOffsets[row]; p < csr.rowOffsets[row + 1]; p++)
+                    positionInRow[csr.columnIndices[p]] = -1;
+            }
+
+            vector<unsigned> lowerOffsets(n + 1, 0), upperOffsets(n + 1, 0), lowerColumns, upperColumns;
+            vector<T> lowerValues, upperValues, diagonal(n);
+            for (unsigned row = 0; row < n; row++) {
+                for (unsigned p = csr.rowOffsets[row]; p < csr.rowOffsets[row + 1]; p++) {
+                    if (p < diagonalPositions[row]) {
+                        lowerColumns.push_back(csr.columnIndices[p]);
+                        lowerValues.push_back(values[p]);
+                    }
+                    else if (p > diagonalPositions[row]) {
+                        upperColumns.push_back(csr.columnIndices[p]);
+                        upperValues.push_back(values[p]);
+                    }
+                }
+                diagonal[row] = values[diagonalPositions[row]];
+                lowerOffsets[row + 1] = lowerColumns.size();
+                upperOffsets[row + 1] = upperColumns.size();
+            }
+            _lower.build(true, std::move(lowerOffsets), std::move(lowerColumns), std::move(lowerValues), {});
+            _upper.build(false, std::move(upperOffsets), std::move(upperColumns), std::move(upperValues), diagonal);
+            this->_markSetUp();
+        }
+
+        void apply(NumericalVector<T> &r, NumericalVector<T> &z) override {
+            this->_checkApply(r, z);
+            _lower.solve(r.getDataPointer(), z.getDataPointer(), this->_availableThreads);
+            _upper.solve(z.getDataPointer(), z.getDataPointer(), this->_availableThreads);
+        }
+
+        /**
+        * @brief Returns the unit lower triangular factor L (the unit diagonal is not stored).
+        */
+        const SparseTriangularFactor<T> &getLowerFactor() const {
+            return _lower;
+        }
+
+        const SparseTriangularFactor<T> &getUpperFactor() const {
+            return _upper;
+        }
+
+    protected:
+        SparseTriangularFactor<T> _lower;
+
+        SparseTriangularFactor<T> _upper;
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_INCOMPLETELUPRECONDITIONER_H
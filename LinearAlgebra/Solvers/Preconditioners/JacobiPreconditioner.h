@@ -0,0 +1,77 @@
+//
+// Created by hal9000 on 10/25/23.
+//
+
+#ifndef UNTITLED_JACOBIPRECONDITIONER_H
+#define UNTITLED_JACOBIPRECONDITIONER_H
+
+#include "Preconditioner.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Diagonal preconditioner M = diag(A).
+    */
+    template<typename T>
+    class JacobiPreconditioner : public Preconditioner<T> {
+    public:
+        JacobiPreconditioner() {
+            this->_name = "Jacobi";
+        }
+
+        void setup(const shared_ptr<NumericalMatrix<T>> &matrix) override {
+            if (matrix->numberOfRows() != matrix->numberOfColumns())
+                throw invalid_argument("The preconditioner requires a square matrix.");
+            unsigned n = matrix->numberOfRows();
+            NumericalVector<T> diagonal(n);
+            if (matrix->dataStorage->getStorageType() == CSR) {
+                auto csr = this->_csrArrays(matrix);
+                for (unsigned row = 0; row < n; row++)
+                    for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++)
+                        if (csr.columnIndices[k] == row)
+                            diagonal[row] = csr.values[k];
+            }
+            else {
+                for (unsigned row = 0; row < n; row++)
+                    diagonal[row] = matrix->getElement(row, row);
+            }
+            setup(diagonal, matrix->dataStorage->getAvailableThreads());
+        }
+
+        /**
+        * @brief Builds the preconditioner from the diagonal of a matrix-free operator.
+        */
+        void setup(const NumericalVector<T> &diagonal, unsigned availableThreads = 1) {
+            this->_numberOfRows = diagonal.size();
+            this->_availableThreads = availableThreads;
+            _inverseDiagonal = make_shared<NumericalVector<T>>(diagonal.size(), 0, availableThreads);
+            for (unsigned row = 0; row < diagonal.size(); row++) {
+                if (diagonal[row] == static_cast<T>(0))
+                    throw runtime_error("Zero diagonal element at row " + to_string(row) + ".");
+                (*_inverseDiagonal)[row] = static_cast<T>(1) / diagonal[row];
+            }
+            this->_markSetUp();
+        }
+
+        void apply(NumericalVector<T> &r, NumericalVector<T> &z) override {
+            this->_checkApply(r, z);
+            const T* inverseDiagonal = _inverseDiagonal->getDataPointer();
+            const T* residual = r.getDataPointer();
+            T* result = z.getDataPointer();
+            this->_parallelFor([&](unsigned start, unsigned end) {
+                for (unsigned i = start; i < end; i++)
+                    result[i] = inverseDiagonal[i] * residual[i];
+            }, this->_numberOfRows);
+        }
+
+        const shared_ptr<NumericalVector<T>> &getInverseDiagonal() const {
+            return _inverseDiagonal;
+        }
+
+    private:
+        shared_ptr<NumericalVector<T>> _inverseDiagonal;
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_JACOBIPRECONDITIONER_H
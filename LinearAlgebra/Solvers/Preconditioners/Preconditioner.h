@@ -0,0 +1,110 @@
+//
+// Created by hal9000 on 10/25/23.
+//
+
+#ifndef UNTITLED_PRECONDITIONER_H
+#define UNTITLED_PRECONDITIONER_H
+
+#include <atomic>
+#include "../../ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrix.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Base class of the preconditioners M of the Krylov solvers.
+    *
+    * setup() builds M from an assembled matrix once per matrix (factorizations, inverted diagonals, hierarchies),
+    * apply() computes z = M^-1 r once or twice per iteration and must be cheap.
+    *
+    * @tparam T The datatype of the matrix elements.
+    */
+    template<typename T>
+    class Preconditioner {
+    public:
+        virtual ~Preconditioner() = default;
+
+        /**
+        * @brief Builds the preconditioner. Must be called again if the values of the matrix change.
+        */
+        virtual void setup(const shared_ptr<NumericalMatrix<T>> &matrix) = 0;
+
+        /**
+        * @brief Computes z = M^-1 r. r and z never alias.
+        */
+        virtual void apply(NumericalVector<T> &r, NumericalVector<T> &z) = 0;
+
+        bool isSetUp() const {
+            return _isSetUp;
+        }
+
+        /**
+        * @brief Identifies the last setup() among those of all the preconditioners, 0 before the first one. A new
+        * setup() of the same object, or a new object at the address of a destroyed one, gets a new identity.
+        */
+        unsigned long getSetupIdentity() const {
+            return _setupIdentity;
+        }
+
+        const string &getName() const {
+            return _name;
+        }
+
+    protected:
+        bool _isSetUp = false;
+
+        unsigned long _setupIdentity = 0;
+
+        string _name;
+
+        unsigned _numberOfRows = 0;
+
+        unsigned _availableThreads = 1;
+
+        /**
+        * @brief Raw pointers to the CSR vectors of a matrix.
+        */
+        struct CSRArrays {
+            const T* values;
+            const unsigned* columnIndices;
+            const unsigned* rowOffsets;
+            unsigned numberOfRows;
+        };
+
+        static CSRArrays _csrArrays(const shared_ptr<NumericalMatrix<T>> &matrix) {
+            if (matrix->dataStorage->getStorageType() != CSR)
+                throw invalid_argument("The preconditioner requires a matrix stored in CSR format.");
+            if (matrix->numberOfRows() != matrix->numberOfColumns())
+                throw invalid_argument("The preconditioner requires a square matrix.");
+            auto supplementaryDataPointers = matrix->dataStorage->getSupplementaryDataPointers();
+            return {matrix->dataStorage->getValuesDataPointer(), supplementaryDataPointers[0],
+                    supplementaryDataPointers[1], matrix->numberOfRows()};
+        }
+
+        /**
+        * @brief Ends a setup(): marks the preconditioner set up and gives it a new setup identity.
+        */
+        void _markSetUp() {
+            static atomic<unsigned long> setups(0);
+            _isSetUp = true;
+            _setupIdentity = ++setups;
+        }
+
+        void _checkApply(NumericalVector<T> &r, NumericalVector<T> &z) const {
+            if (!_isSetUp)
+                throw runtime_error("Preconditioner " + _name + " is not set up. Call setup() first.");
+            if (r.size() != _numberOfRows || z.size() != _numberOfRows)
+                throw invalid_argument("Vector size does not match the size of the preconditioner.");
+        }
+
+        /**
+        * @brief Runs job(start, end) over [0, size) with the threads of the preconditioner.
+        */
+        template<typename ThreadJob>
+        void _parallelFor(ThreadJob job, unsigned size) const {
+            ThreadingOperations<T>::executeParallelJob(job, size, _availableThreads);
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_PRECONDITIONER_H
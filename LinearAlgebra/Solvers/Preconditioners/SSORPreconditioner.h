@@ -0,0 +1,83 @@
+//
+// Created by hal9000 on 10/25/23.
+//
+
+#ifndef UNTITLED_SSORPRECONDITIONER_H
+#define UNTITLED_SSORPRECONDITIONER_H
+
+#include "Preconditioner.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Symmetric successive over-relaxation preconditioner
+    * M = ω / (2 - ω) (D / ω + L) (D / ω)^-1 (D / ω + U), with A = L + D + U.
+    *
+    * apply() performs one forward and one backward SOR sweep with a zero initial guess. For symmetric A, M is
+    * symmetric positive definite for 0 < ω < 2, so it can be used with PCG. The sweeps are sequential.
+    */
+    template<typename T>
+    class SSORPreconditioner : public Preconditioner<T> {
+    public:
+        explicit SSORPreconditioner(T relaxationParameter = 1) : _relaxationParameter(relaxationParameter) {
+            if (relaxationParameter <= 0 || relaxationParameter >= 2)
+                throw invalid_argument("SSOR relaxation parameter must be in (0, 2).");
+            this->_name = "SSOR (" + to_string(relaxationParameter).substr(0, 4) + ")";
+        }
+
+        void setup(const shared_ptr<NumericalMatrix<T>> &matrix) override {
+            auto csr = this->_csrArrays(matrix);
+            _matrix = matrix;
+            this->_numberOfRows = csr.numberOfRows;
+            this->_availableThreads = matrix->dataStorage->getAvailableThreads();
+            _diagonalPositions.assign(csr.numberOfRows, 0);
+            for (unsigned row = 0; row < csr.numberOfRows; row++) {
+                bool found = false;
+                for (unsigned k = csr.rowOffsets[row]; k < csr.rowOffsets[row + 1]; k++) {
+                    if (csr.columnIndices[k] == row && csr.values[k] != static_cast<T>(0)) {
+                        _diagonalPositions[row] = k;
+                        found = true;
+                    }
+                }
+                if (!found)
+                    throw runtime_error("Zero diagonal element at row " + to_string(row) + ".");
+            }
+            this->_markSetUp();
+        }
+
+        void apply(NumericalVector<T> &r, NumericalVector<T> &z) override {
+            this->_checkApply(r, z);
+            auto csr = this->_csrArrays(_matrix);
+            const T omega = _relaxationParameter;
+            const T* residual = r.getDataPointer();
+            T* result = z.getDataPointer();
+            //(D / ω + L) y = r
+            for (unsigned row = 0; row < csr.numberOfRows; row++) {
+                T sum = residual[row];
+                for (unsigned k = csr.rowOffsets[row]; k < _diagonalPositions[row]; k++)
+                    sum -= csr.values[k] * result[csr.columnIndices[k]];
+                result[row] = omega * sum / csr.values[_diagonalPositions[row]];
+            }
+            //y <- (2 - ω) / ω * D / ω * y
+            for (unsigned row = 0; row < csr.numberOfRows; row++)
+                result[row] *= (2 - omega) / omega * csr.values[_diagonalPositions[row]] / omega;
+            //(D / ω + U) z = y
+            for (unsigned row = csr.numberOfRows; row-- > 0;) {
+                T sum = result[row];
+                for (unsigned k = _diagonalPositions[row] + 1; k < csr.rowOffsets[row + 1]; k++)
+                    sum -= csr.values[k] * result[csr.columnIndices[k]];
+                result[row] = omega * sum / csr.values[_diagonalPositions[row]];
+            }
+        }
+
+    private:
+        T _relaxationParameter;
+
+        shared_ptr<NumericalMatrix<T>> _matrix;
+
+        vector<unsigned> _diagonalPositions;
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_SSORPRECONDITIONER_H
@@ -0,0 +1,144 @@
+//
+// Created by hal9000 on 10/26/23.
+//
+
+#ifndef UNTITLED_SPARSETRIANGULARFACTOR_H
+#define UNTITLED_SPARSETRIANGULARFACTOR_H
+
+#include "../../ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrix.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Sparse lower or upper triangular factor in CSR format with a level schedule for parallel solves.
+    *
+    * Only the strictly triangular elements are stored in the CSR arrays, the diagonal is stored separately (inverted)
+    * or omitted for unit triangular factors. The level of a row is one more than the highest level of the rows it
+    * depends on, so all the rows of a level can be solved concurrently once the previous levels are done. For the
+    * 5-point stencil of a nx x ny grid in lexicographic order the levels are the nx + ny - 1 anti-diagonals.
+    *
+    * @tparam T The datatype of the factor elements.
+    */
+    template<typename T>
+    class SparseTriangularFactor {
+    public:
+        SparseTriangularFactor() : _isLower(true), _numberOfRows(0) { }
+
+        /**
+        * @brief Stores the factor and computes its level schedule.
+        *
+        * @param isLower true for a lower triangular factor (forward substitution), false for upper (backward).
+        * @param rowOffsets, columnIndices, values The CSR arrays of the strictly triangular part.
+        * @param diagonal The diagonal elements. Empty for a unit diagonal.
+        */
+        void build(bool isLower, vector<unsigned> rowOffsets, vector<unsigned> columnIndices, vector<T> values,
+                   const vector<T> &diagonal) {
+            _isLower = isLower;
+            _numberOfRows = static_cast<unsigned>(rowOffsets.size()) - 1;
+            _rowOffsets = std::move(rowOffsets);
+            _columnIndices = std::move(columnIndices);
+            _values = std::move(values);
+            _inverseDiagonal.resize(diagonal.size());
+            for (unsigned row = 0; row < diagonal.size(); row++) {
+                if (diagonal[row] == static_cast<T>(0))
+                    throw runtime_error("Zero diagonal element in triangular factor at row " + to_string(row) + ".");
+                _inverseDiagonal[row] = 1 / diagonal[row];
+            }
+            _buildLevels();
+        }
+
+        /**
+        * @brief Solves F x = rhs. rhs and x may alias.
+        *
+        * With more than one thread the rows are solved level by level and the rows of each level are distributed
+        * among the threads. Levels with too few rows to amortize the threads are solved by the calling thread.
+        */
+        void solve(const T* rhs, T* x, unsigned availableThreads) const {
+            auto solveRow = [&](unsigned row) {
+                T sum = rhs[row];
+                for (unsigned k = _rowOffsets[row]; k < _rowOffsets[row + 1]; k++)
+                    sum -= _values[k] * x[_columnIndices[k]];
+                x[row] = _inverseDiagonal.empty() ? sum : sum * _inverseDiagonal[row];
+            };
+            if (availableThreads <= 1) {
+                if (_isLower)
+                    for (unsigned row = 0; row < _numberOfRows; row++)
+                        solveRow(row);
+                else
+                    for (unsigned row = _numberOfRows; row-- > 0;)
+                        solveRow(row);
+                return;
+            }
+            for (unsigned level = 0; level + 1 < _levelOffsets.size(); level++) {
+                unsigned first = _levelOffsets[level];
+                unsigned levelSize = _levelOffsets[level + 1] - first;
+                auto levelJob = [&](unsigned start, unsigned end) {
+                    for (unsigned p = first + start; p < first + end; p++)
+                        solveRow(_levelRows[p]);
+                };
+                unsigned threads = std::min(availableThreads, std::max(1u, levelSize / _minimumRowsPerThread));
+                ThreadingOperations<T>::executeParallelJob(levelJob, levelSize, threads);
+            }
+        }
+
+        unsigned numberOfRows() const {
+            return _numberOfRows;
+        }
+
+        unsigned numberOfLevels() const {
+            return _levelOffsets.empty() ? 0 : static_cast<unsigned>(_levelOffsets.size()) - 1;
+        }
+
+        /**
+        * @brief Returns the number of stored elements, diagonal included.
+        */
+        unsigned numberOfNonZeros() const {
+            return static_cast<unsigned>(_values.size() + _inverseDiagonal.size());
+        }
+
+    private:
+        bool _isLower;
+
+        unsigned _numberOfRows;
+
+        vector<unsigned> _rowOffsets;
+
+        vector<unsigned> _columnIndices;
+
+        vector<T> _values;
+
+        vector<T> _inverseDiagonal;
+
+        //Rows sorted by level and the start of each level in _levelRows
+        vector<unsigned> _levelRows;
+
+        vector<unsigned> _levelOffsets;
+
+        static constexpr unsigned _minimumRowsPerThread = 256;
+
+        void _buildLevels() {
+            vector<unsigned> levels(_numberOfRows, 0);
+            unsigned numberOfLevels = _numberOfRows > 0 ? 1 : 0;
+            for (unsigned i = 0; i < _numberOfRows; i++) {
+                unsigned row = _isLower ? i : _numberOfRows - 1 - i;
+                unsigned level = 0;
+                for (unsigned k = _rowOffsets[row]; k < _rowOffsets[row + 1]; k++)
+                    level = std::max(level, levels[_columnIndices[k]] + 1);
+                levels[row] = level;
+                numberOfLevels = std::max(numberOfLevels, level + 1);
+            }
+            _levelOffsets.assign(numberOfLevels + 1, 0);
+            for (unsigned row = 0; row < _numberOfRows; row++)
+                _levelOffsets[levels[row] + 1]++;
+            for (unsigned level = 0; level < numberOfLevels; level++)
+                _levelOffsets[level + 1] += _levelOffsets[level];
+            _levelRows.resize(_numberOfRows);
+            vector<unsigned> position(_levelOffsets.begin(), _levelOffsets.end() - 1);
+            for (unsigned row = 0; row < _numberOfRows; row++)
+                _levelRows[position[levels[row]]++] = row;
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_SPARSETRIANGULARFACTOR_H
@@ -0,0 +1,156 @@
+//
+// Created by hal9000 on 10/26/23.
+//
+
+#ifndef UNTITLED_THRESHOLDINCOMPLETELUPRECONDITIONER_H
+#define UNTITLED_THRESHOLDINCOMPLETELUPRECONDITIONER_H
+
+#include <queue>
+#include <cmath>
+#include "IncompleteLUPreconditioner.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Dual threshold incomplete LU preconditioner ILUT(τ, p) (Saad).
+    *
+    * Each row is eliminated with fill-in allowed at any position. An element of row i is dropped if its magnitude is
+    * below τ ||a_i||_2, and of the remaining elements only the p largest of the L part and the p largest of the U
+    * part are kept, so the memory of the factors is bounded by (2p + 1) n. A zero pivot is replaced by
+    * (1E-4 + τ) ||a_i||_2. With τ = 0 and p >= n it computes the exact LU factorization without pivoting.
+    * The factors are solved with the same level scheduled triangular solves as ILU(0).
+    */
+    template<typename T>
+    class ThresholdIncompleteLUPreconditioner : public IncompleteLUPreconditioner<T> {
+    public:
+        /**
+        * @param dropTolerance τ, relative to the 2-norm of each row.
+        * @param maximumFillPerRow p, the maximum number of elements kept in each row of L and of U (diagonal excluded).
+        */
+        explicit ThresholdIncompleteLUPreconditioner(T dropTolerance = 1E-3, unsigned maximumFillPerRow = 10) :
+                _dropTolerance(dropTolerance), _maximumFillPerRow(maximumFillPerRow) {
+            if (dropTolerance < 0)
+                throw invalid_argument("ILUT drop tolerance must be non-negative.");
+            ostringstream name;
+            name << "ILUT(" << dropTolerance << ", " << maximumFillPerRow << ")";
+            this->_name = name.str();
+        }
+
+        void setup(const shared_ptr<NumericalMatrix<T>> &matrix) override {
+            auto csr = this->_csrArrays(matrix);
+            unsigned n = csr.numberOfRows;
+            this->_numberOfRows = n;
+            this->_availableThreads = matrix->dataStorage->getAvailableThreads();
+
+            vector<unsigned> lowerOffsets(n + 1, 0), upperOffsets(n + 1, 0), lowerColumns, upperColumns;
+            vector<T> lowerValues, upperValues, diagonal(n);
+            //Dense work row, its non-zero pattern and the pending lower columns in increasing order
+            vector<T> work(n, 0);
+            vector<char> inPattern(n, 0);
+            vector<unsigned> pattern;
+            priority_queue<unsigned, std::vector<unsigned>, greater<unsigned>> pendingLower;
+            vector<pair<T, unsigned>> kept;
+
+            for (unsigned row = 0; row < n; row++) {
+                T rowNorm = 0;
+                for (unsigned p = csr.rowOffsets[row]; p < csr.rowOffsets[row + 1]; p++) {
+                    unsigned column = csr.columnIndices[p];
+                    rowNorm += csr.values[p] * csr.values[p];
+                    if (!inPattern[column]) {
+                        inPattern[column] = 1;
+                        pattern.push_back(column);
+                        if (column < row)
+                            pendingLower.push(column);
+                    }
+                    work[column] += csr.values[p];
+                }
+                rowNorm = std::sqrt(rowNorm);
+                if (rowNorm == static_cast<T>(0))
+                    throw runtime_error("ILUT: row " + to_string(row) + " is empty.");
+                T dropThreshold = _dropTolerance * rowNorm;
+
+                while (!pendingLower.empty()) {
+                    unsigned k = pendingLower.top();
+                    pendingLower.pop();
+                    work[k] /= diagonal[k];
+                    if (std::abs(work[k]) < dropThreshold) {
+                        work[k] = 0;
+                        continue;
+                    }
+                    for (unsigned q = upperOffsets[k]; q < upperOffsets[k + 1]; q++) {
+                        unsigned column = upperColumns[q];
+                        if (!inPattern[column]) {
+                            inPattern[column] = 1;
+                            pattern.push_back(column);
+                            if (column < row)
+                                pendingLower.push(column);
+                        }
+                        work[column] -= work[k] * upperValues[q];
+                    }
+                }
+
+                _keepLargest(work, pattern, [row](unsigned column) { return column < row; }, dropThreshold, kept);
+                for (auto &element : kept) {
+                    lowerColumns.push_back(element.second);
+                    lowerValues.push_back(element.first);
+                }
+                _keepLargest(work, pattern, [row](unsigned column) { return column > row; }, dropThreshold, kept);
+                for (auto &element : kept) {
+                    upperColumns.push_back(element.second);
+                    upperValues.push_back(element.first);
+                }
+                diagonal[row] = work[row] != static_cast<T>(0) ? work[row] : (static_cast<T>(1E-4) + _dropTolerance) * rowNorm;
+                lowerOffsets[row + 1] = lowerColumns.size();
+                upperOffsets[row + 1] = upperColumns.size();
+
+                for (unsigned column : pattern) {
+                    work[column] = 0;
+                    inPattern[column] = 0;
+                }
+                pattern.clear();
+            }
+            this->_lower.build(true, std::move(lowerOffsets), std::move(lowerColumns), std::move(lowerValues), {});
+            this->_upper.build(false, std::move(upperOffsets), std::move(upperColumns), std::move(upperValues), diagonal);
+            this->_markSetUp();
+        }
+
+        /**
+        * @brief Returns the number of elements of L + U divided by the number of elements of A.
+        */
+        double fillRatio(const shared_ptr<NumericalMatrix<T>> &matrix) const {
+            double matrixNonZeros = matrix->dataStorage->getValues()->size();
+            return (this->_lower.numberOfNonZeros() + this->_upper.numberOfNonZeros()) / matrixNonZeros;
+        }
+
+    private:
+        T _dropTolerance;
+
+        unsigned _maximumFillPerRow;
+
+        /**
+        * @brief Collects the (value, column) pairs of the work row that satisfy the side predicate and the drop
+        * threshold, keeps the p largest in magnitude and sorts them by column.
+        */
+        template<typename Side>
+        void _keepLargest(const vector<T> &work, const vector<unsigned> &pattern, Side side, T dropThreshold,
+                          vector<pair<T, unsigned>> &kept) const {
+            kept.clear();
+            for (unsigned column : pattern)
+                if (side(column) && work[column] != static_cast<T>(0) && std::abs(work[column]) >= dropThreshold)
+                    kept.emplace_back(work[column], column);
+            if (kept.size() > _maximumFillPerRow) {
+                std::nth_element(kept.begin(), kept.begin() + _maximumFillPerRow, kept.end(),
+                                 [](const pair<T, unsigned> &a, const pair<T, unsigned> &b) {
+                                     return std::abs(a.first) > std::abs(b.first);
+                                 });
+                kept.resize(_maximumFillPerRow);
+            }
+            std::sort(kept.begin(), kept.end(), [](const pair<T, unsigned> &a, const pair<T, unsigned> &b) {
+                return a.second < b.second;
+            });
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_THRESHOLDINCOMPLETELUPRECONDITIONER_H
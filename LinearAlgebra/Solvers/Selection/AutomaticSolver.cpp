@@ -0,0 +1,62 @@
+//
+// Created by hal9000 on 11/10/23.
+//
+
+#include "AutomaticSolver.h"
+
+namespace LinearAlgebra {
+
+    AutomaticSolver::AutomaticSolver(double tolerance, unsigned maxIterations, bool printReport, unsigned availableThreads) :
+            Solver(), _printReport(printReport),
+            _availableThreads(availableThreads > 0 ? availableThreads : std::max(1u, std::thread::hardware_concurrency())) {
+        _selector = make_shared<SolverSelector<double>>(tolerance, maxIterations, _availableThreads);
+        _linearSystemInitialized = false;
+        _vectorsInitialized = false;
+        _solutionSet = false;
+        _solverType = PreconditionedIterative;
+    }
+
+    void AutomaticSolver::solve() {
+        if (!_isLinearSystemSet)
+            throw std::invalid_argument("Linear system must be set before solving.");
+        auto matrix = _linearSystem->getCSRMatrix(_availableThreads);
+        auto &selection = _selector->select(matrix);
+        _solverType = selection.isDirect() ? Direct : PreconditionedIterative;
+
+        unsigned n = _linearSystem->rhs->size();
+        NumericalVector<double> rhs(n, 0, _availableThreads), solution(n, 0, _availableThreads);
+        std::copy(_linearSystem->rhs->begin(), _linearSystem->rhs->end(), rhs.getDataPointer());
+        std::copy(_linearSystem->solution->begin(), _linearSystem->solution->end(), solution.getDataPointer());
+        _selector->solve(rhs, solution);
+        std::copy(solution.getDataPointer(), solution.getDataPointer() + n, _linearSystem->solution->begin());
+        if (_printReport)
+            cout << _selector->report();
+    }
+
+    void AutomaticSolver::setInitialSolution(shared_ptr<vector<double>> initialValue) {
+        if (!_vectorsInitialized)
+            throw runtime_error("Vectors must be initialized before setting the initial solution.");
+        if (initialValue->size() != _linearSystem->solution->size())
+            throw std::invalid_argument("Initial value vector must have the same size as the solution vector.");
+        _linearSystem->solution = std::move(initialValue);
+        _solutionSet = true;
+    }
+
+    void AutomaticSolver::setInitialSolution(double initialValue) {
+        if (!_vectorsInitialized)
+            throw runtime_error("Vectors must be initialized before setting the initial solution.");
+        std::fill(_linearSystem->solution->begin(), _linearSystem->solution->end(), initialValue);
+        _solutionSet = true;
+    }
+
+    const shared_ptr<SolverSelector<double>> &AutomaticSolver::getSelector() const {
+        return _selector;
+    }
+
+    void AutomaticSolver::_initializeVectors() {
+        if (_linearSystem->solution == nullptr)
+            _linearSystem->solution = make_shared<vector<double>>(_linearSystem->rhs->size(), 0);
+        _vectorsInitialized = true;
+    }
+
+} // LinearAlgebra
@@ -0,0 +1,58 @@
+//
+// Created by hal9000 on 11/10/23.
+//
+
+#ifndef UNTITLED_AUTOMATICSOLVER_H
+#define UNTITLED_AUTOMATICSOLVER_H
+
+#include "../Solver.h"
+#include "SolverSelector.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief Solves the linear system of an analysis with the solver that a SolverSelector chooses from the properties
+    * of its matrix, instead of a solver picked by hand.
+    *
+    * solve() copies the matrix to CSR, selects, solves and copies the solution back. The tolerance is relative to
+    * ||b||, the same as the Krylov solvers, not absolute like the L2 norm of the stationary and CG solvers. The report
+    * of the selection, with the reasons of every choice and fallback, is printed after the solution if enabled, and
+    * stays available from the selector.
+    */
+    class AutomaticSolver : public Solver {
+
+    public:
+        /**
+        * @param availableThreads The threads of the CSR matrix and the iterative solvers, 0 for all the hardware threads.
+        */
+        explicit AutomaticSolver(double tolerance = 1E-9, unsigned maxIterations = 1E4, bool printReport = false,
+                                 unsigned availableThreads = 0);
+
+        void solve() override;
+
+        /**
+        * @brief Used as the initial guess of the iterative solvers.
+        */
+        void setInitialSolution(shared_ptr<vector<double>> initialValue) override;
+
+        void setInitialSolution(double initialValue) override;
+
+        /**
+        * @brief The selector, to adjust its limits before solve() or to read the selection after it.
+        */
+        const shared_ptr<SolverSelector<double>>& getSelector() const;
+
+    protected:
+
+        void _initializeVectors() override;
+
+        shared_ptr<SolverSelector<double>> _selector;
+
+        bool _printReport;
+
+        unsigned _availableThreads;
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_AUTOMATICSOLVER_H
@@ -0,0 +1,670 @@
+//
+// Created by hal9000 on 11/10/23.
+//
+
+#ifndef UNTITLED_SOLVERSELECTOR_H
+#define UNTITLED_SOLVERSELECTOR_H
+
+#include <sstream>
+#include <iomanip>
+#include "../Direct/SupernodalCholesky.h"
+#include "../Direct/BandedLU.h"
+#include "../Iterative/KrylovSubspace/PreconditionedConjugateGradient.h"
+#include "../Iterative/KrylovSubspace/BiConjugateGradientStabilized.h"
+#include "../Iterative/KrylovSubspace/GeneralizedMinimalResidual.h"
+#include "../Preconditioners/JacobiPreconditioner.h"
+#include "../Preconditioners/IncompleteCholeskyPreconditioner.h"
+#include "../Preconditioners/IncompleteLUPreconditioner.h"
+#include "../Multigrid/SmoothedAggregationMultigrid.h"
+#include "../../EigenDecomposition/SpectralBoundsEstimator.h"
+
+namespace LinearAlgebra {
+
+    enum SelectedSolver {
+        SupernodalCholeskySelection,
+        BandedLUSelection,
+        ConjugateGradientSelection,
+        BiCGStabSelection,
+        GMRESSelection
+    };
+
+    enum SelectedPreconditioner {
+        NoPreconditionerSelection,
+        JacobiSelection,
+        IncompleteCholeskySelection,
+        IncompleteLUSelection,
+        AlgebraicMultigridSelection
+    };
+
+    /**
+    * @brief The properties of a square CSR matrix that decide its solver.
+    */
+    struct MatrixProperties {
+        unsigned numberOfRows;
+
+        unsigned numberOfNonZeros;
+
+        unsigned lowerBandwidth;
+
+        unsigned upperBandwidth;
+
+        //Every a_ij has a stored a_ji
+        bool structurallySymmetric;
+
+        //|a_ij - a_ji| <= symmetryTolerance max |a|
+        bool symmetric;
+
+        bool nonZeroDiagonal;
+
+        bool positiveDiagonal;
+
+        bool negativeDiagonal;
+
+        //The fraction of the rows with |a_ii| >= Σ_{j != i} |a_ij|
+        double dominantRowFraction;
+
+        //All the rows weakly dominant and at least one strictly
+        bool diagonallyDominant;
+
+        //Confirmed by the Lanczos estimate, which is run only for symmetric matrices with a positive diagonal
+        bool positiveDefinite;
+
+        //-A confirmed positive definite, for symmetric matrices with a negative diagonal (e.g. the assembled Laplacian)
+        bool negativeDefinite;
+
+        //The Lanczos bounds of D^-1 A (equal to those of (-D)^-1 (-A)), zero if not estimated
+        SpectralBounds spectralBounds;
+
+        //λmax / λmin of D^-1 A from the Ritz values: a lower bound of the condition number, zero if not estimated
+        double conditionEstimate;
+    };
+
+    /**
+    * @brief The solver chosen for a matrix, its set up components and the reasons of every choice.
+    */
+    template<typename T>
+    struct SolverSelection {
+        MatrixProperties properties;
+
+        SelectedSolver solver;
+
+        SelectedPreconditioner preconditioner;
+
+        //The factorization of a direct selection. As a preconditioner it applies the exact inverse
+        shared_ptr<Preconditioner<T>> factorization;
+
+        shared_ptr<KrylovSolver<T>> iterativeSolver;
+
+        shared_ptr<Preconditioner<T>> iterativePreconditioner;
+
+        vector<string> reasons;
+
+        //The solvers that replaced a failed choice during solve()
+        unsigned fallbacks;
+
+        bool isDirect() const {
+            return solver == SupernodalCholeskySelection || solver == BandedLUSelection;
+        }
+    };
+
+    /**
+    * @brief Chooses the solver and the preconditioner of an assembled matrix from its properties, records why, and
+    * solves with the choice, falling back to more robust solvers if it fails.
+    *
+    * analyze() costs a few passes over the non-zeros (bandwidths, diagonal dominance, symmetry by a binary search of
+    * the transposed element in its row) and, for a symmetric matrix with a positive diagonal, a short Lanczos estimate
+    * of the spectrum of D^-1 A, which confirms positive definiteness and bounds the condition number from below. A
+    * symmetric matrix with a negative diagonal is estimated as -A; if -A is SPD the selection factorizes or iterates
+    * on -A and solve() negates the right hand side. select() then decides:
+    *   - SPD: supernodal Cholesky if its symbolic flop count is below the direct limit and below the estimated cost
+    *     of Jacobi PCG, ½ √κ ln(2 / tolerance) iterations of 2 nnz + 10 n flops. Otherwise PCG with Jacobi if the
+    *     condition number is below the well conditioned limit, smoothed aggregation AMG for large ill conditioned
+    *     systems, IC(0) for the small ones.
+    *   - Otherwise: banded LU with partial pivoting if a diagonal element is zero (ILU(0) and Jacobi break down) or
+    *     the flops of the banded factorization are below the direct limit. Otherwise ILU(0) with BiCGStab for a
+    *     diagonally dominant matrix (short recurrences, stable ILU) and with GMRES for the rest.
+    * A failed factorization in select() moves to the next choice. solve() falls back to GMRES with ILU(0) and then
+    * to banded LU if the iterative choice does not converge. Banded LU is only used within the direct flop and memory
+    * limits, above them the selection or the fallback throws with the recorded reasons. Every decision and fallback is
+    * appended to the reasons, report() formats them.
+    *
+    * @tparam T The datatype of the matrix and vector elements.
+    */
+    template<typename T>
+    class SolverSelector {
+    public:
+        explicit SolverSelector(double tolerance = 1E-9, unsigned maxIterations = 1E4, unsigned availableThreads = 1) :
+                _tolerance(tolerance), _maxIterations(maxIterations), _availableThreads(std::max(1u, availableThreads)),
+                _directFlopLimit(1E9), _directMemoryLimit(2E9), _wellConditionedLimit(100), _multigridRowLimit(50000), _estimationSteps(50),
+                _symmetryTolerance(1E-12), _isSelected(false) { }
+
+        /**
+        * @brief The flops above which a direct factorization is not considered. Default 1E9.
+        */
+        void setDirectFlopLimit(double directFlopLimit) {
+            _directFlopLimit = directFlopLimit;
+        }
+
+        /**
+        * @brief The bytes of band storage above which banded LU is not used. Default 2E9.
+        */
+        void setDirectMemoryLimit(double directMemoryLimit) {
+            _directMemoryLimit = directMemoryLimit;
+        }
+
+        /**
+        * @brief The condition number of D^-1 A below which SPD systems use Jacobi PCG. Default 100.
+        */
+        void setWellConditionedLimit(double wellConditionedLimit) {
+            _wellConditionedLimit = wellConditionedLimit;
+        }
+
+        /**
+        * @brief The rows from which ill conditioned SPD systems use AMG instead of IC(0). Default 50000.
+        */
+        void setMultigridRowLimit(unsigned multigridRowLimit) {
+            _multigridRowLimit = multigridRowLimit;
+        }
+
+        /**
+        * @brief The maximum Lanczos steps of the spectral estimate. Default 50.
+        */
+        void setEstimationSteps(unsigned estimationSteps) {
+            _estimationSteps = std::max(2u, estimationSteps);
+        }
+
+        /**
+        * @brief The relative tolerance of the numerical symmetry test. Default 1E-12.
+        */
+        void setSymmetryTolerance(double symmetryTolerance) {
+            _symmetryTolerance = symmetryTolerance;
+        }
+
+        void setAvailableThreads(unsigned availableThreads) {
+            _availableThreads = std::max(1u, availableThreads);
+        }
+
+        /**
+        * @throws invalid_argument If the matrix is not square or not stored in CSR format.
+        */
+        MatrixProperties analyze(const shared_ptr<NumericalMatrix<T>> &matrix) const {
+            if (matrix->dataStorage->getStorageType() != CSR)
+                throw invalid_argument("The solver selection requires a matrix stored in CSR format.");
+            if (matrix->numberOfRows() != matrix->numberOfColumns())
+                throw invalid_argument("The solver selection requires a square matrix.");
+            unsigned n = matrix->numberOfRows();
+            const T* values = matrix->dataStorage->getValuesDataPointer();
+            auto supplementaryDataPointers = matrix->dataStorage->getSupplementaryDataPointers();
+            const unsigned* columnIndices = supplementaryDataPointers[0];
+            const unsigned* rowOffsets = supplementaryDataPointers[1];
+
+            MatrixProperties properties = {n, rowOffsets[n], 0, 0, true, true, true, true, true, 0, false, false, false,
+                                            {0, 0, 0, 0}, 0};
+            double maximumValue = 0;
+            for (unsigned k = 0; k < rowOffsets[n]; k++)
+                maximumValue = std::max(maximumValue, static_cast<double>(std::abs(values[k])));
+            unsigned dominantRows = 0, strictlyDominantRows = 0;
+            vector<double> diagonals(n, 0);
+            for (unsigned row = 0; row < n; row++) {
+                double diagonal = 0, offDiagonalSum = 0;
+                for (unsigned k = rowOffsets[row]; k < rowOffsets[row + 1]; k++) {
+                    unsigned column = columnIndices[k];
+                    double value = static_cast<double>(values[k]);
+                    if (column == row) {
+                        diagonal = value;
+                        continue;
+                    }
+                    offDiagonalSum += std::abs(value);
+                    if (column < row)
+                        properties.lowerBandwidth = std::max(properties.lowerBandwidth, row - column);
+                    else
+                        properties.upperBandwidth = std::max(properties.upperBandwidth, column - row);
+                    //The transposed element a_ji in the sorted columns of row j
+                    auto first = columnIndices + rowOffsets[column], last = columnIndices + rowOffsets[column + 1];
+                    auto transposed = std::lower_bound(first, last, row);
+                    double transposedValue = 0;
+                    if (transposed != last && *transposed == row)
+                        transposedValue = static_cast<double>(values[transposed - columnIndices]);
+                    else
+                        properties.structurallySymmetric = false;
+                    if (std::abs(value - transposedValue) > _symmetryTolerance * maximumValue)
+                        properties.symmetric = false;
+                }
+                properties.nonZeroDiagonal = properties.nonZeroDiagonal && diagonal != 0;
+                properties.positiveDiagonal = properties.positiveDiagonal && diagonal > 0;
+                properties.negativeDiagonal = properties.negativeDiagonal && diagonal < 0;
+                diagonals[row] = diagonal;
+                if (std::abs(diagonal) >= offDiagonalSum) {
+                    dominantRows++;
+                    if (std::abs(diagonal) > offDiagonalSum)
+                        strictlyDominantRows++;
+                }
+            }
+            properties.dominantRowFraction = n > 0 ? static_cast<double>(dominantRows) / n : 1;
+            properties.diagonallyDominant = dominantRows == n && strictlyDominantRows > 0;
+
+            properties.negativeDiagonal = properties.negativeDiagonal && n > 0;
+
+            if (properties.symmetric && (properties.positiveDiagonal || properties.negativeDiagonal)) {
+                //The SPD candidate is A or -A, with the Jacobi preconditioner of its (positive) diagonal
+                T sign = properties.positiveDiagonal ? 1 : -1;
+                NumericalVector<T> candidateDiagonal(n);
+                for (unsigned row = 0; row < n; row++)
+                    candidateDiagonal[row] = sign * static_cast<T>(diagonals[row]);
+                JacobiPreconditioner<T> jacobi;
+                jacobi.setup(candidateDiagonal, _availableThreads);
+                NumericalMatrixOperator<T> matrixOperator(matrix, _availableThreads);
+                unsigned availableThreads = _availableThreads;
+                FunctionLinearOperator<T> candidate(n, n, [&](NumericalVector<T> &x, NumericalVector<T> &y) {
+                    matrixOperator.multiply(x, y);
+                    if (sign < 0)
+                        y.scale(sign, availableThreads);
+                });
+                SpectralBoundsEstimator<T> estimator(LanczosBounds, _estimationSteps, 1E-3, _availableThreads);
+                try {
+                    properties.spectralBounds = estimator.estimate(candidate, &jacobi);
+                    properties.positiveDefinite = sign > 0;
+                    properties.negativeDefinite = sign < 0;
+                    properties.conditionEstimate = properties.spectralBounds.maximum / properties.spectralBounds.minimum;
+                } catch (runtime_error &) {
+                    properties.positiveDefinite = false;
+                    properties.negativeDefinite = false;
+                }
+            }
+            return properties;
+        }
+
+        /**
+        * @brief Analyzes the matrix, chooses its solver and sets it up. The matrix must outlive the selection.
+        * @throws runtime_error If no direct or iterative choice can be set up, or if the diagonal has zeros and banded
+        * LU is above the direct limits.
+        */
+        const SolverSelection<T> &select(const shared_ptr<NumericalMatrix<T>> &matrix) {
+            _isSelected = false;
+            _selection = SolverSelection<T>();
+            _selection.properties = analyze(matrix);
+            _selection.fallbacks = 0;
+            _matrix = _selection.properties.negativeDefinite ? _negate(matrix) : matrix;
+            _negatedRhs = nullptr;
+            _describeProperties();
+            if (_selection.properties.positiveDefinite || _selection.properties.negativeDefinite)
+                _selectSymmetricPositiveDefinite();
+            else
+                _selectGeneral();
+            _isSelected = true;
+            return _selection;
+        }
+
+        /**
+        * @brief Solves with the selection of the last select(). solution holds the initial guess of the iterative
+        * solvers on entry. Falls back to GMRES with ILU(0) and then to banded LU if the iterative solver does not
+        * converge.
+        * @throws runtime_error If select() was not called, or if the iterative solvers do not converge and banded LU is
+        * above the direct limits.
+        */
+        void solve(NumericalVector<T> &rhs, NumericalVector<T> &solution) {
+            if (!_isSelected)
+                throw runtime_error("No solver selected. Call select() first.");
+            if (!_selection.properties.negativeDefinite) {
+                _solve(rhs, solution);
+                return;
+            }
+            //The selection holds -A: solve -A x = -b
+            if (_negatedRhs == nullptr || _negatedRhs->size() != rhs.size())
+                _negatedRhs = make_shared<NumericalVector<T>>(rhs.size());
+            for (unsigned i = 0; i < rhs.size(); i++)
+                (*_negatedRhs)[i] = -rhs[i];
+            _solve(*_negatedRhs, solution);
+        }
+
+        /**
+        * @throws runtime_error If select() was not called.
+        */
+        const SolverSelection<T> &getSelection() const {
+            if (!_isSelected)
+                throw runtime_error("No solver selected. Call select() first.");
+            return _selection;
+        }
+
+        /**
+        * @brief The solver, the properties of the matrix and the reasons of the last selection.
+        */
+        string report() const {
+            auto &selection = getSelection();
+            auto &properties = selection.properties;
+            std::ostringstream stream;
+            stream << "Solver selection : " << name(selection.solver);
+            if (!selection.isDirect())
+                stream << " + " << name(selection.preconditioner);
+            stream << endl << "  n = " << properties.numberOfRows << ", nnz = " << properties.numberOfNonZeros
+                   << ", bandwidth (" << properties.lowerBandwidth << ", " << properties.upperBandwidth << ")" << endl;
+            for (auto &reason : selection.reasons)
+                stream << "  - " << reason << endl;
+            return stream.str();
+        }
+
+        static string name(SelectedSolver solver) {
+            switch (solver) {
+                case SupernodalCholeskySelection: return "Supernodal Cholesky";
+                case BandedLUSelection: return "Banded LU";
+                case ConjugateGradientSelection: return "PCG";
+                case BiCGStabSelection: return "BiCGStab";
+                case GMRESSelection: return "GMRES(30)";
+                default: throw invalid_argument("Unknown selected solver.");
+            }
+        }
+
+        static string name(SelectedPreconditioner preconditioner) {
+            switch (preconditioner) {
+                case NoPreconditionerSelection: return "no preconditioner";
+                case JacobiSelection: return "Jacobi";
+                case IncompleteCholeskySelection: return "IC(0)";
+                case IncompleteLUSelection: return "ILU(0)";
+                case AlgebraicMultigridSelection: return "SA-AMG";
+                default: throw invalid_argument("Unknown selected preconditioner.");
+            }
+        }
+
+    private:
+        double _tolerance;
+
+        unsigned _maxIterations;
+
+        unsigned _availableThreads;
+
+        double _directFlopLimit;
+
+        double _directMemoryLimit;
+
+        double _wellConditionedLimit;
+
+        unsigned _multigridRowLimit;
+
+        unsigned _estimationSteps;
+
+        double _symmetryTolerance;
+
+        bool _isSelected;
+
+        //The analyzed matrix, or its negation if it is negative definite
+        shared_ptr<NumericalMatrix<T>> _matrix;
+
+        shared_ptr<NumericalVector<T>> _negatedRhs;
+
+        SolverSelection<T> _selection;
+
+        static string _format(double value) {
+            std::ostringstream stream;
+            stream << std::setprecision(3) << value;
+            return stream.str();
+        }
+
+        void _reason(const string &reason) {
+            _selection.reasons.push_back(reason);
+        }
+
+        void _describeProperties() {
+            auto &properties = _selection.properties;
+            string symmetry = properties.symmetric ? "Symmetric" :
+                              properties.structurallySymmetric ? "Non-symmetric values on a symmetric pattern" : "Non-symmetric pattern";
+            _reason(symmetry + ", " + _format(100 * properties.dominantRowFraction) + "% diagonally dominant rows" +
+                    (properties.diagonallyDominant ? " (diagonally dominant)" : "") +
+                    (properties.positiveDiagonal ? ", positive diagonal." :
+                     properties.negativeDiagonal ? ", negative diagonal." :
+                     properties.nonZeroDiagonal ? ", diagonal with negative elements." : ", zero or missing diagonal elements."));
+            if (properties.positiveDefinite)
+                _reason("Lanczos on D^-1 A (" + to_string(properties.spectralBounds.steps) + " steps): positive definite, spectrum in [" +
+                        _format(properties.spectralBounds.minimum) + ", " + _format(properties.spectralBounds.maximum) +
+                        "], condition number >= " + _format(properties.conditionEstimate) + ".");
+            else if (properties.negativeDefinite)
+                _reason("Lanczos on (-D)^-1 (-A) (" + to_string(properties.spectralBounds.steps) + " steps): negative definite, " +
+                        "the selection solves -A x = -b, spectrum in [" + _format(properties.spectralBounds.minimum) + ", " +
+                        _format(properties.spectralBounds.maximum) + "], condition number >= " + _format(properties.conditionEstimate) + ".");
+            else if (properties.symmetric && (properties.positiveDiagonal || properties.negativeDiagonal))
+                _reason("Lanczos on D^-1 A found a non-positive curvature: indefinite.");
+        }
+
+        void _selectSymmetricPositiveDefinite() {
+            auto &properties = _selection.properties;
+            double n = properties.numberOfRows;
+            double iterations = std::ceil(0.5 * std::sqrt(properties.conditionEstimate) * std::log(2 / _tolerance));
+            double iterativeFlops = iterations * (2.0 * properties.numberOfNonZeros + 10 * n);
+            //Only the ordering and the column counts until the factorization is chosen
+            auto cholesky = make_shared<SupernodalCholesky<T>>();
+            cholesky->analyzeOrdering(_matrix);
+            double directFlops = cholesky->getFactorizationFlops() + 4.0 * cholesky->numberOfFactorNonZeros();
+            if (directFlops <= _directFlopLimit && directFlops <= iterativeFlops) {
+                try {
+                    cholesky->analyze(_matrix);
+                    cholesky->factorize(_matrix);
+                    _selection.solver = SupernodalCholeskySelection;
+                    _selection.factorization = cholesky;
+                    _reason("Supernodal Cholesky: ~" + _format(directFlops) + " flops, below the limit " + _format(_directFlopLimit) +
+                            " and the ~" + _format(iterativeFlops) + " flops of ~" + _format(iterations) + " Jacobi PCG iterations.");
+                    return;
+                } catch (runtime_error &exception) {
+                    _reason("Supernodal Cholesky failed (" + string(exception.what()) + "), iterative instead.");
+                }
+            }
+            else
+                _reason("Iterative: the Cholesky factorization takes ~" + _format(directFlops) + " flops, above " +
+                        (directFlops > _directFlopLimit ? "the limit " + _format(_directFlopLimit) :
+                         "the ~" + _format(iterativeFlops) + " flops of ~" + _format(iterations) + " Jacobi PCG iterations") + ".");
+
+            if (properties.conditionEstimate <= _wellConditionedLimit) {
+                _reason("PCG with Jacobi: condition number below " + _format(_wellConditionedLimit) +
+                        ", the cheapest fully parallel preconditioner suffices.");
+                if (_useIterative(ConjugateGradientSelection, JacobiSelection))
+                    return;
+            }
+            else if (properties.numberOfRows >= _multigridRowLimit) {
+                _reason("PCG with SA-AMG: ill conditioned with at least " + to_string(_multigridRowLimit) +
+                        " rows, multigrid keeps the iterations independent of the size.");
+                if (_useIterative(ConjugateGradientSelection, AlgebraicMultigridSelection))
+                    return;
+            }
+            else {
+                _reason("PCG with IC(0): ill conditioned with less than " + to_string(_multigridRowLimit) +
+                        " rows, the incomplete factorization is cheaper to set up than multigrid.");
+                if (_useIterative(ConjugateGradientSelection, IncompleteCholeskySelection))
+                    return;
+            }
+            _reason("PCG with Jacobi as the fallback preconditioner.");
+            if (!_useIterative(ConjugateGradientSelection, JacobiSelection))
+                throw runtime_error("No preconditioner of the SPD matrix could be set up.");
+        }
+
+        void _selectGeneral() {
+            auto &properties = _selection.properties;
+            if (!properties.nonZeroDiagonal) {
+                _reason("Banded LU with partial pivoting: ILU(0) and Jacobi break down on zero diagonal elements (" +
+                        _bandedLUCost() + ").");
+                _useBandedLU();
+                return;
+            }
+            if (_isBandedLUAffordable()) {
+                _reason("Banded LU with partial pivoting: " + _bandedLUCost() + ", below " + _directLimits() + ".");
+                try {
+                    _useBandedLU();
+                    return;
+                } catch (runtime_error &exception) {
+                    _reason("Banded LU failed (" + string(exception.what()) + "), iterative instead.");
+                }
+            }
+            else
+                _reason("Iterative: the banded LU factorization takes " + _bandedLUCost() + ", above " + _directLimits() + ".");
+            if (properties.diagonallyDominant) {
+                _reason("BiCGStab with ILU(0): diagonally dominant, so ILU(0) is stable and the short recurrences of "
+                        "BiCGStab need less memory and work per iteration than GMRES.");
+                if (_useIterative(BiCGStabSelection, IncompleteLUSelection))
+                    return;
+            }
+            else {
+                _reason("GMRES with ILU(0): not diagonally dominant, GMRES minimizes the residual where BiCGStab may break down.");
+                if (_useIterative(GMRESSelection, IncompleteLUSelection))
+                    return;
+            }
+            _reason("GMRES with Jacobi as the fallback preconditioner.");
+            if (!_useIterative(GMRESSelection, JacobiSelection))
+                throw runtime_error("No preconditioner of the matrix could be set up.");
+        }
+
+        /**
+        * @brief Solves with _matrix, falling back if the iterative solver does not converge.
+        */
+        void _solve(NumericalVector<T> &rhs, NumericalVector<T> &solution) {
+            if (_selection.isDirect()) {
+                _selection.factorization->apply(rhs, solution);
+                return;
+            }
+            _selection.iterativeSolver->solve(_matrix, rhs, solution);
+            if (_selection.iterativeSolver->hasConverged())
+                return;
+            if (!(_selection.solver == GMRESSelection && _selection.preconditioner == IncompleteLUSelection)) {
+                _fallback("GMRES with ILU(0)");
+                if (_useIterative(GMRESSelection, IncompleteLUSelection)) {
+                    _selection.iterativeSolver->solve(_matrix, rhs, solution);
+                    if (_selection.iterativeSolver->hasConverged())
+                        return;
+                    _fallback("banded LU");
+                }
+                else
+                    _fallback("banded LU", "ILU(0) could not be set up");
+            }
+            else
+                _fallback("banded LU");
+            _useBandedLU();
+            _selection.factorization->apply(rhs, solution);
+        }
+
+        /**
+        * @brief -A with the sparsity pattern of A.
+        */
+        shared_ptr<NumericalMatrix<T>> _negate(const shared_ptr<NumericalMatrix<T>> &matrix) const {
+            unsigned n = matrix->numberOfRows();
+            const T* values = matrix->dataStorage->getValuesDataPointer();
+            auto supplementaryDataPointers = matrix->dataStorage->getSupplementaryDataPointers();
+            unsigned numberOfNonZeros = supplementaryDataPointers[1][n];
+            auto negatedValues = make_shared<NumericalVector<T>>(numberOfNonZeros);
+            auto columnIndices = make_shared<NumericalVector<unsigned>>(numberOfNonZeros);
+            auto rowOffsets = make_shared<NumericalVector<unsigned>>(n + 1);
+            for (unsigned k = 0; k < numberOfNonZeros; k++) {
+                (*negatedValues)[k] = -values[k];
+                (*columnIndices)[k] = supplementaryDataPointers[0][k];
+            }
+            for (unsigned row = 0; row <= n; row++)
+                (*rowOffsets)[row] = supplementaryDataPointers[1][row];
+            auto storage = make_shared<CSRStorageDataProvider<T>>(negatedValues, columnIndices, rowOffsets, n, n, _availableThreads);
+            return make_shared<NumericalMatrix<T>>(n, n, storage);
+        }
+
+        double _bandedLUFlops() const {
+            auto &properties = _selection.properties;
+            return 2.0 * properties.numberOfRows * properties.lowerBandwidth *
+                   (properties.lowerBandwidth + properties.upperBandwidth + 1);
+        }
+
+        /**
+        * @brief The band storage of the factors, 2 kl + ku + 1 diagonals because the interchanges widen U.
+        */
+        double _bandedLUBytes() const {
+            auto &properties = _selection.properties;
+            return static_cast<double>(properties.numberOfRows) *
+                   (2.0 * properties.lowerBandwidth + properties.upperBandwidth + 1) * sizeof(T);
+        }
+
+        bool _isBandedLUAffordable() const {
+            return _bandedLUFlops() <= _directFlopLimit && _bandedLUBytes() <= _directMemoryLimit;
+        }
+
+        string _bandedLUCost() const {
+            return "~" + _format(_bandedLUFlops()) + " flops and ~" + _format(_bandedLUBytes()) + " bytes";
+        }
+
+        string _directLimits() const {
+            return "the limits " + _format(_directFlopLimit) + " flops and " + _format(_directMemoryLimit) + " bytes";
+        }
+
+        /**
+        * @throws runtime_error With the recorded reasons if banded LU is above the direct flop or memory limit.
+        */
+        void _useBandedLU() {
+            if (!_isBandedLUAffordable()) {
+                string message = "Banded LU takes " + _bandedLUCost() + ", above " + _directLimits() + ". Reasons:";
+                for (auto &reason : _selection.reasons)
+                    message += "\n  - " + reason;
+                throw runtime_error(message);
+            }
+            auto bandedLU = make_shared<BandedLU<T>>();
+            bandedLU->setup(_matrix);
+            _selection.solver = BandedLUSelection;
+            _selection.preconditioner = NoPreconditionerSelection;
+            _selection.factorization = bandedLU;
+            _selection.iterativeSolver = nullptr;
+            _selection.iterativePreconditioner = nullptr;
+        }
+
+        /**
+        * @brief Builds and sets up the solver and the preconditioner.
+        * @return false, with the reason recorded, if the preconditioner cannot be set up.
+        */
+        bool _useIterative(SelectedSolver solver, SelectedPreconditioner preconditioner) {
+            shared_ptr<Preconditioner<T>> iterativePreconditioner;
+            switch (preconditioner) {
+                case JacobiSelection: iterativePreconditioner = make_shared<JacobiPreconditioner<T>>(); break;
+                case IncompleteCholeskySelection: iterativePreconditioner = make_shared<IncompleteCholeskyPreconditioner<T>>(); break;
+                case IncompleteLUSelection: iterativePreconditioner = make_shared<IncompleteLUPreconditioner<T>>(); break;
+                case AlgebraicMultigridSelection: iterativePreconditioner = make_shared<SmoothedAggregationMultigrid<T>>(); break;
+                default: break;
+            }
+            if (iterativePreconditioner != nullptr) {
+                try {
+                    iterativePreconditioner->setup(_matrix);
+                } catch (runtime_error &exception) {
+                    _reason(name(preconditioner) + " setup failed (" + string(exception.what()) + ").");
+                    return false;
+                }
+            }
+            shared_ptr<KrylovSolver<T>> iterativeSolver;
+            switch (solver) {
+                case ConjugateGradientSelection:
+                    iterativeSolver = make_shared<PreconditionedConjugateGradient<T>>(_tolerance, _maxIterations, false, _availableThreads);
+                    break;
+                case BiCGStabSelection:
+                    iterativeSolver = make_shared<BiConjugateGradientStabilized<T>>(_tolerance, _maxIterations, false, _availableThreads);
+                    break;
+                case GMRESSelection:
+                    iterativeSolver = make_shared<GeneralizedMinimalResidual<T>>(_tolerance, _maxIterations, false, _availableThreads);
+                    break;
+                default:
+                    throw invalid_argument("Not an iterative solver.");
+            }
+            iterativeSolver->setPreconditioner(iterativePreconditioner);
+            _selection.solver = solver;
+            _selection.preconditioner = preconditioner;
+            _selection.factorization = nullptr;
+            _selection.iterativeSolver = iterativeSolver;
+            _selection.iterativePreconditioner = iterativePreconditioner;
+            return true;
+        }
+
+        void _fallback(const string &next) {
+            auto &failed = _selection.iterativeSolver;
+            _reason(name(_selection.solver) + " with " + name(_selection.preconditioner) + " did not converge in " +
+                    to_string(failed->getIterations()) + " iterations (relative residual " + _format(failed->getExitNorm()) +
+                    "), falling back to " + next + ".");
+            _selection.fallbacks++;
+        }
+
+        /**
+        * @brief A fallback that skips a choice which could not be set up, the previous reason says why.
+        */
+        void _fallback(const string &next, const string &cause) {
+            _reason(cause + ", falling back to " + next + ".");
+            _selection.fallbacks++;
+        }
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_SOLVERSELECTOR_H
@@ -0,0 +1,274 @@
+//
+// Created by hal9000 on 11/6/23.
+//
+
+#ifndef UNTITLED_SOLVERTELEMETRY_H
+#define UNTITLED_SOLVERTELEMETRY_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+using namespace std;
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief The state of an iterative solver at one iteration. The counters are cumulative since the start of the solve.
+    */
+    struct TelemetryRecord {
+        unsigned iteration;
+
+        double residual;
+
+        /**
+        * @brief Milliseconds since the start of the solve.
+        */
+        double elapsedTime;
+
+        unsigned long matrixVectorProducts;
+
+        unsigned long reductions;
+    };
+
+    /**
+    * @brief The outcome of a solve.
+    */
+    struct TelemetrySummary {
+        string solverName;
+
+        unsigned iterations;
+
+        double exitNorm;
+
+        bool converged;
+
+        /**
+        * @brief Wall time of the solve in milliseconds.
+        */
+        double elapsedTime;
+
+        unsigned long matrixVectorProducts;
+
+        unsigned long reductions;
+
+        /**
+        * @brief Records overwritten in the ring buffer before the end of the solve.
+        */
+        unsigned long droppedRecords;
+    };
+
+    class SolverTelemetry;
+
+    /**
+    * @brief Consumer of the telemetry of a solve. Sinks run once after the solve, never inside the iteration loop.
+    */
+    class TelemetrySink {
+    public:
+        virtual ~TelemetrySink() = default;
+
+        virtual void write(const SolverTelemetry &telemetry) = 0;
+    };
+
+    /**
+    * @brief Records the convergence history of an iterative solver without any I/O in the iteration loop.
+    *
+    * The records go to a ring buffer allocated once, so record() neither allocates nor locks. When the buffer is full
+    * the oldest records are overwritten and counted as dropped, keeping the end of the history. A capacity of 0 keeps
+    * the counters and the summary only. The solver thread is the single producer. Another thread may call records()
+    * during the solve, it gets a consistent snapshot of the records that were not overwritten while it copied them:
+    * every slot carries a sequence number, odd while the producer writes it, that the reader checks around its copy.
+    *
+    * The matrix vector products count every application of the operator, relaxation sweeps included. The reductions
+    * count the global reductions (dot products, norms, fused sums), each a synchronization point of a parallel solve.
+    *
+    * The attached sinks are called by end() after the solve. The quiet flag asks the solvers to write nothing to the
+    * console, the sinks are called regardless.
+    */
+    class SolverTelemetry {
+    public:
+        explicit SolverTelemetry(unsigned capacity = 4096) :
+                _buffer(capacity), _written(0), _matrixVectorProducts(0), _reductions(0), _quiet(false) {
+            _summary = {"", 0, 0, false, 0, 0, 0, 0};
+        }
+
+        /**
+        * @brief Clears the records and the counters and starts the clock.
+        */
+        void begin(const string &solverName) {
+            _written.store(0, memory_order_release);
+            _matrixVectorProducts.store(0, memory_order_relaxed);
+            _reductions.store(0, memory_order_relaxed);
+            _summary = {solverName, 0, 0, false, 0, 0, 0, 0};
+            _start = chrono::steady_clock::now();
+        }
+
+        /**
+        * @brief Records the residual of an iteration. Called from the iteration loop.
+        */
+        void record(unsigned iteration, double residual) {
+            unsigned long written = _written.load(memory_order_relaxed);
+            if (!_buffer.empty()) {
+                TelemetrySlot &slot = _buffer[written % _buffer.size()];
+                //Odd while the fields are written, a reader that sees any of the field stores sees it too
+                slot.sequence.store(2 * written + 1, memory_order_relaxed);
+                atomic_thread_fence(memory_order_release);
+                slot.iteration.store(iteration, memory_order_relaxed);
+                slot.residual.store(residual, memory_order_relaxed);
+                slot.elapsedTime.store(chrono::duration<double, milli>(chrono::steady_clock::now() - _start).count(),
+                                       memory_order_relaxed);
+                slot.matrixVectorProducts.store(_matrixVectorProducts.load(memory_order_relaxed), memory_order_relaxed);
+                slot.reductions.store(_reductions.load(memory_order_relaxed), memory_order_relaxed);
+                slot.sequence.store(2 * written + 2, memory_order_release);
+            }
+            _written.store(written + 1, memory_order_release);
+        }
+
+        /**
+        * @brief Adds count applications of the operator. Called from the solver thread only.
+        */
+        void countMatrixVectorProducts(unsigned long count = 1) {
+            _matrixVectorProducts.store(_matrixVectorProducts.load(memory_order_relaxed) + count, memory_order_relaxed);
+        }
+
+        /**
+        * @brief Adds count global reductions. Called from the solver thread only.
+        */
+        void countReductions(unsigned long count = 1) {
+            _reductions.store(_reductions.load(memory_order_relaxed) + count, memory_order_relaxed);
+        }
+
+        /**
+        * @brief Closes the solve and writes it to the attached sinks.
+        */
+        void end(unsigned iterations, double exitNorm, bool converged) {
+            _summary.iterations = iterations;
+            _summary.exitNorm = exitNorm;
+            _summary.converged = converged;
+            _summary.elapsedTime = chrono::duration<double, milli>(chrono::steady_clock::now() - _start).count();
+            _summary.matrixVectorProducts = _matrixVectorProducts.load(memory_order_relaxed);
+            _summary.reductions = _reductions.load(memory_order_relaxed);
+            _summary.droppedRecords = droppedRecords();
+            for (auto &sink : _sinks)
+                sink->write(*this);
+        }
+
+        /**
+        * @brief The records kept in the ring buffer, oldest first.
+        */
+        vector<TelemetryRecord> records() const {
+            unsigned long capacity = _buffer.size();
+            unsigned long written = _written.load(memory_order_acquire);
+            unsigned long first = written > capacity ? written - capacity : 0;
+            vector<TelemetryRecord> snapshot;
+            snapshot.reserve(written - first);
+            for (unsigned long i = first; i < written; i++) {
+                const TelemetrySlot &slot = _buffer[i % capacity];
+                unsigned long before = slot.sequence.load(memory_order_acquire);
+                TelemetryRecord record = {slot.iteration.load(memory_order_relaxed), slot.residual.load(memory_order_relaxed),
+                                          slot.elapsedTime.load(memory_order_relaxed),
+                                          slot.matrixVectorProducts.load(memory_order_relaxed),
+                                          slot.reductions.load(memory_order_relaxed)};
+                atomic_thread_fence(memory_order_acquire);
+                unsigned long after = slot.sequence.load(memory_order_relaxed);
+                //Record i is being or was overwritten: drop it with the older copies to keep the history contiguous
+                if (before != 2 * i + 2 || after != before) {
+                    snapshot.clear();
+                    continue;
+                }
+                snapshot.push_back(record);
+            }
+            return snapshot;
+        }
+
+        /**
+        * @brief The number of record() calls since begin().
+        */
+        unsigned long recordedIterations() const {
+            return _written.load(memory_order_acquire);
+        }
+
+        unsigned long droppedRecords() const {
+            unsigned long written = _written.load(memory_order_acquire);
+            return written > _buffer.size() ? written - _buffer.size() : 0;
+        }
+
+        unsigned long getMatrixVectorProducts() const {
+            return _matrixVectorProducts.load(memory_order_relaxed);
+        }
+
+        unsigned long getReductions() const {
+            return _reductions.load(memory_order_relaxed);
+        }
+
+        /**
+        * @brief The outcome of the last solve, complete after end().
+        */
+        const TelemetrySummary &getSummary() const {
+            return _summary;
+        }
+
+        unsigned getCapacity() const {
+            return static_cast<unsigned>(_buffer.size());
+        }
+
+        void attachSink(shared_ptr<TelemetrySink> sink) {
+            if (sink == nullptr)
+                throw invalid_argument("The telemetry sink is null.");
+            _sinks.push_back(std::move(sink));
+        }
+
+        void clearSinks() {
+            _sinks.clear();
+        }
+
+        void setQuiet(bool quiet) {
+            _quiet = quiet;
+        }
+
+        bool isQuiet() const {
+            return _quiet;
+        }
+
+    private:
+        /**
+        * @brief A TelemetryRecord in the ring buffer, with fields that records() may read during record().
+        */
+        struct TelemetrySlot {
+            //2 i + 1 while record i is written, 2 i + 2 once it is complete
+            atomic<unsigned long> sequence;
+
+            atomic<unsigned> iteration;
+
+            atomic<double> residual;
+
+            atomic<double> elapsedTime;
+
+            atomic<unsigned long> matrixVectorProducts;
+
+            atomic<unsigned long> reductions;
+        };
+
+        vector<TelemetrySlot> _buffer;
+
+        atomic<unsigned long> _written;
+
+        atomic<unsigned long> _matrixVectorProducts;
+
+        atomic<unsigned long> _reductions;
+
+        chrono::steady_clock::time_point _start;
+
+        TelemetrySummary _summary;
+
+        vector<shared_ptr<TelemetrySink>> _sinks;
+
+        bool _quiet;
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_SOLVERTELEMETRY_H
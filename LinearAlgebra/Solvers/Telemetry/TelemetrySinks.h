@@ -0,0 +1,189 @@
+//
+// Created by hal9000 on 11/6/23.
+//
+
+#ifndef UNTITLED_TELEMETRYSINKS_H
+#define UNTITLED_TELEMETRYSINKS_H
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include "SolverTelemetry.h"
+
+namespace LinearAlgebra {
+
+    /**
+    * @brief The summary and the records of a solve kept by a MemoryTelemetrySink.
+    */
+    struct TelemetryRun {
+        TelemetrySummary summary;
+
+        vector<TelemetryRecord> records;
+    };
+
+    /**
+    * @brief Keeps a copy of every solve in memory.
+    */
+    class MemoryTelemetrySink : public TelemetrySink {
+    public:
+        void write(const SolverTelemetry &telemetry) override {
+            _runs.push_back({telemetry.getSummary(), telemetry.records()});
+        }
+
+        const vector<TelemetryRun> &getRuns() const {
+            return _runs;
+        }
+
+        void clear() {
+            _runs.clear();
+        }
+
+    private:
+        vector<TelemetryRun> _runs;
+    };
+
+    /**
+    * @brief Base class of the sinks that write to an output stream, borrowed or owned.
+    */
+    class StreamTelemetrySink : public TelemetrySink {
+    protected:
+        /**
+        * @brief Writes to a stream owned by the caller, which must outlive the sink.
+        */
+        explicit StreamTelemetrySink(ostream &stream) : _stream(&stream) { }
+
+        /**
+        * @brief Writes to a file, appended to if it exists.
+        * @throws runtime_error If the file cannot be opened.
+        */
+        explicit StreamTelemetrySink(const string &filePath) : _file(make_shared<ofstream>(filePath, ios::app)) {
+            if (!_file->is_open())
+                throw runtime_error("Cannot open the telemetry file " + filePath + ".");
+            _stream = _file.get();
+        }
+
+        ostream &_output() {
+            return *_stream;
+        }
+
+    private:
+        shared_ptr<ofstream> _file;
+
+        ostream *_stream;
+    };
+
+    /**
+    * @brief One CSV row per record: solver, iteration, residual, time (ms), matrix vector products, reductions.
+    * The header row is written before the first solve.
+    */
+    class CSVTelemetrySink : public StreamTelemetrySink {
+    public:
+        explicit CSVTelemetrySink(ostream &stream) : StreamTelemetrySink(stream) { }
+
+        explicit CSVTelemetrySink(const string &filePath) : StreamTelemetrySink(filePath) { }
+
+        void write(const SolverTelemetry &telemetry) override {
+            auto &output = _output();
+            //Round trip precision, restored for a borrowed stream
+            auto precision = output.precision(numeric_limits<double>::max_digits10);
+            if (!_headerWritten)
+                output << "solver,iteration,residual,time_ms,matrix_vector_products,reductions\n";
+            _headerWritten = true;
+            auto &name = telemetry.getSummary().solverName;
+            for (auto &record : telemetry.records())
+                output << name << "," << record.iteration << "," << record.residual << "," << record.elapsedTime << ","
+                       << record.matrixVectorProducts << "," << record.reductions << "\n";
+            output.precision(precision);
+            output.flush();
+        }
+
+    private:
+        bool _headerWritten = false;
+    };
+
+    /**
+    * @brief One JSON object per solve and line with the summary and the array of the records. Non finite residuals
+    * are written as null.
+    */
+    class JSONTelemetrySink : public StreamTelemetrySink {
+    public:
+        explicit JSONTelemetrySink(ostream &stream) : StreamTelemetrySink(stream) { }
+
+        explicit JSONTelemetrySink(const string &filePath) : StreamTelemetrySink(filePath) { }
+
+        void write(const SolverTelemetry &telemetry) override {
+            auto &output = _output();
+            auto precision = output.precision(numeric_limits<double>::max_digits10);
+            auto &summary = telemetry.getSummary();
+            output << "{\"solver\":\"" << _escape(summary.solverName) << "\",\"converged\":"
+                   << (summary.converged ? "true" : "false") << ",\"iterations\":" << summary.iterations
+                   << ",\"exitNorm\":" << _number(summary.exitNorm) << ",\"timeMs\":" << summary.elapsedTime
+                   << ",\"matrixVectorProducts\":" << summary.matrixVectorProducts << ",\"reductions\":"
+                   << summary.reductions << ",\"droppedRecords\":" << summary.droppedRecords << ",\"records\":[";
+            bool first = true;
+            for (auto &record : telemetry.records()) {
+                output << (first ? "" : ",") << "{\"iteration\":" << record.iteration << ",\"residual\":"
+                       << _number(record.residual) << ",\"timeMs\":" << record.elapsedTime
+                       << ",\"matrixVectorProducts\":" << record.matrixVectorProducts << ",\"reductions\":"
+                       << record.reductions << "}";
+                first = false;
+            }
+            output << "]}\n";
+            output.precision(precision);
+            output.flush();
+        }
+
+    private:
+        static string _escape(const string &text) {
+            string escaped;
+            for (char c : text) {
+                if (c == '"' || c == '\\')
+                    escaped += '\\';
+                if (static_cast<unsigned char>(c) < 0x20)
+                    continue;
+                escaped += c;
+            }
+            return escaped;
+        }
+
+        static string _number(double value) {
+            if (!std::isfinite(value))
+                return "null";
+            ostringstream text;
+            text << setprecision(numeric_limits<double>::max_digits10) << value;
+            return text.str();
+        }
+    };
+
+    /**
+    * @brief Prints the outcome of the solve and, for a display frequency > 0, every displayFrequency-th record.
+    * Writes nothing if the telemetry is quiet.
+    */
+    class ConsoleTelemetrySink : public TelemetrySink {
+    public:
+        explicit ConsoleTelemetrySink(unsigned displayFrequency = 0) : _displayFrequency(displayFrequency) { }
+
+        void write(const SolverTelemetry &telemetry) override {
+            if (telemetry.isQuiet())
+                return;
+            if (_displayFrequency > 0)
+                for (auto &record : telemetry.records())
+                    if (record.iteration % _displayFrequency == 0)
+                        cout << "Iteration: " << record.iteration << " - Norm: " << record.residual << endl;
+            auto &summary = telemetry.getSummary();
+            cout << summary.solverName << (summary.converged ? " converged" : " did not converge") << " in "
+                 << summary.iterations << " iterations, exit norm " << summary.exitNorm << ", " << summary.elapsedTime
+                 << " ms, " << summary.matrixVectorProducts << " matrix vector products, " << summary.reductions
+                 << " reductions" << endl;
+        }
+
+    private:
+        unsigned _displayFrequency;
+    };
+
+} // LinearAlgebra
+
+#endif //UNTITLED_TELEMETRYSINKS_H
@@ -20,7 +20,8 @@ namespace StructuredMeshGenerator{
         _calculatePDEPropertiesFromMetrics();
     }
     
-    void MeshFactory::buildMesh(unsigned short schemeOrder, shared_ptr<DomainBoundaryConditions> boundaryConditions) const {
+    void MeshFactory::buildMesh(unsigned short schemeOrder, shared_ptr<DomainBoundaryConditions> boundaryConditions,
+                                shared_ptr<Solver> solver) const {
         
         auto start = chrono::steady_clock::now();
         
@@ -55,7 +56,10 @@ namespace StructuredMeshGenerator{
         //auto solver = make_shared<GaussSeidelSolver>(turboVTechKickInYoo , VectorNormType::L2, 1E-9);
         //auto solver = make_shared<GaussSeidelSolver>(VectorNormType::L2, 1E-9, 1E4, true, SingleThread);
         //auto solver = make_shared<ConjugateGradientSolver>(VectorNormType::L2, 1E-10, 1E4, true);
-        auto solver = make_shared<ConjugateGradientSolver>(VectorNormType::L2, 1E-12, 1E4, true, MultiThread);
+        //auto solver = make_shared<ConjugateGradientSolver>(VectorNormType::L2, 1E-12, 1E4, true, MultiThread);
+        //The tolerance is relative to ||b||, where the CG above used an absolute one
+        if (solver == nullptr)
+            solver = make_shared<AutomaticSolver>(1E-12, 1E4, false);
 
 
         auto analysis = make_shared<SteadyStateFiniteDifferenceAnalysis>(problem, mesh, solver, specs, Template);
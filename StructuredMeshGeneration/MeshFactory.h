@@ -18,6 +18,7 @@
 #include "../LinearAlgebra/Solvers/Direct/SolverLUP.h"
 #include "../LinearAlgebra/Solvers/Iterative/StationaryIterative/JacobiSolver.h"
 #include "../LinearAlgebra/Solvers/Iterative/StationaryIterative/GaussSeidelSolver.h"
+#include "../LinearAlgebra/Solvers/Selection/AutomaticSolver.h"
 
 
 using namespace PartialDifferentialEquations;
@@ -31,7 +32,11 @@ namespace StructuredMeshGenerator {
 
         shared_ptr<map<unsigned, SpaceFieldProperties>> pdePropertiesFromMetrics;
         
-        void buildMesh(unsigned short schemeOrder, shared_ptr<DomainBoundaryConditions>) const;
+        /**
+        * @brief Solves the Laplace equations of the coordinates with the boundary coordinates of the conditions.
+        * @param solver The solver of the linear systems. nullptr for an AutomaticSolver that does not print its report.
+        */
+        void buildMesh(unsigned short schemeOrder, shared_ptr<DomainBoundaryConditions>, shared_ptr<Solver> solver = nullptr) const;
         
     private:
         shared_ptr<MeshSpecs>_meshSpecs;
@@ -0,0 +1,217 @@
+//
+// Created by hal9000 on 11/9/23.
+//
+
+#ifndef UNTITLED_ADDITIVESCHWARZTEST_H
+#define UNTITLED_ADDITIVESCHWARZTEST_H
+
+#include <cassert>
+#include <chrono>
+#include "../LinearAlgebra/Solvers/Preconditioners/AdditiveSchwarzPreconditioner.h"
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/PreconditionedConjugateGradient.h"
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/GeneralizedMinimalResidual.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class AdditiveSchwarzTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testPartition();
+            testSingleSubdomain();
+            testConvergence();
+            testRestrictedSchwarz();
+            testAdditiveSchwarzReport();
+        }
+
+        static void testPartition(){
+            logTestStart("testPartition");
+            //30 x 20 grid into 6 boxes: 3 x 2 has the smallest interface, 10 x 10 cores
+            auto matrix = _laplacian(30, 20, 1, 2);
+            AdditiveSchwarzPreconditioner<double> schwarz(6, 1);
+            schwarz.setGridDimensions(_unknowns({30, 20}));
+            schwarz.setup(matrix);
+            assert(schwarz.getNumberOfSubdomains() == 6);
+            assert(schwarz.getPartition() == vector<unsigned>({3, 2}));
+            vector<bool> covered(600, false);
+            for (unsigned s = 0; s < 6; s++) {
+                assert(schwarz.getSubdomainCore(s).size() == 100);
+                for (unsigned row : schwarz.getSubdomainCore(s)) {
+                    assert(!covered[row]);
+                    covered[row] = true;
+                }
+            }
+            //The corner box grows by one layer on its two interior sides, the middle one on three
+            assert(schwarz.getSubdomainRows(0).size() == 120 && schwarz.getSubdomainRows(1).size() == 100 + 10 + 10 + 10);
+            const auto &rows = schwarz.getSubdomainRows(0);
+            assert(std::is_sorted(rows.begin(), rows.end()) && std::find(rows.begin(), rows.end(), 10u) != rows.end());
+
+            //Without the grid: contiguous ranges of rows with balanced non-zeros
+            AdditiveSchwarzPreconditioner<double> rows4(4, 2);
+            rows4.setup(matrix);
+            assert(rows4.getPartition().empty() && rows4.getNumberOfSubdomains() == 4);
+            unsigned first = 0;
+            for (unsigned s = 0; s < 4; s++) {
+                const auto &core = rows4.getSubdomainCore(s);
+                assert(core.front() == first && core.back() - core.front() + 1 == core.size());
+                assert(core.size() > 140 && core.size() < 160);
+                //Two layers of the 5-point stencil: two grid lines on each interior side
+                unsigned sides = (s == 0 || s == 3) ? 1 : 2;
+                assert(rows4.getSubdomainRows(s).size() == core.size() + sides * 2 * 30);
+                first += static_cast<unsigned>(core.size());
+            }
+
+            //No split of 7 subdomains fits a 5 x 5 grid: falls back to the rows
+            auto small = _laplacian(5, 5, 1, 1);
+            AdditiveSchwarzPreconditioner<double> prime(7, 1);
+            prime.setGridDimensions(_unknowns({5, 5}));
+            prime.setup(small);
+            assert(prime.getPartition().empty() && prime.getNumberOfSubdomains() == 7);
+
+            bool thrown = false;
+            AdditiveSchwarzPreconditioner<double> mismatch(2, 1);
+            mismatch.setGridDimensions(_unknowns({10, 10}));
+            try { mismatch.setup(small); } catch (invalid_argument &) { thrown = true; }
+            assert(thrown);
+            logTestEnd();
+        }
+
+        static void testSingleSubdomain(){
+            logTestStart("testSingleSubdomain");
+            auto matrix = _laplacian(12, 9, 1, 2);
+            unsigned n = matrix->numberOfRows();
+            auto rhs = _rhs(n);
+
+            //One subdomain solved directly is the exact inverse
+            AdditiveSchwarzPreconditioner<double> direct(1, 0, DirectSubdomainSolver);
+            direct.setup(matrix);
+            NumericalVector<double> z(n);
+            direct.apply(*rhs, z);
+            assert(_relativeResidual(*matrix, *rhs, z) < 1E-12);
+
+            //One subdomain with ILU(0) is the global ILU(0)
+            AdditiveSchwarzPreconditioner<double> incomplete(1, 0, IncompleteLUSubdomainSolver);
+            incomplete.setup(matrix);
+            IncompleteLUPreconditioner<double> ilu;
+            ilu.setup(matrix);
+            NumericalVector<double> schwarzZ(n), iluZ(n);
+            incomplete.apply(*rhs, schwarzZ);
+            ilu.apply(*rhs, iluZ);
+            for (unsigned i = 0; i < n; i++)
+                assert(std::abs(schwarzZ[i] - iluZ[i]) < 1E-12 * std::abs(iluZ[i]) + 1E-14);
+
+            bool thrown = false;
+            AdditiveSchwarzPreconditioner<double> notSetUp;
+            try { notSetUp.apply(*rhs, z); } catch (runtime_error &) { thrown = true; }
+            assert(thrown);
+            logTestEnd();
+        }
+
+        static void testConvergence(){
+            logTestStart("testConvergence");
+            auto matrix = _laplacian(64, 64, 1, 4);
+            unsigned n = matrix->numberOfRows();
+            auto rhs = _rhs(n);
+            auto iterations = [&](unsigned subdomains, unsigned overlap, SchwarzSubdomainSolver solver, bool coarse) {
+                auto schwarz = make_shared<AdditiveSchwarzPreconditioner<double>>(subdomains, overlap, solver, coarse);
+                schwarz->setGridDimensions(_unknowns({64, 64}));
+                schwarz->setup(matrix);
+                PreconditionedConjugateGradient<double> pcg(1E-8, 2000, true, 4);
+                pcg.setPreconditioner(schwarz);
+                NumericalVector<double> solution(n);
+                pcg.solve(matrix, *rhs, solution);
+                assert(_relativeResidual(*matrix, *rhs, solution) <= 1E-8);
+                return pcg.getIterations();
+            };
+            PreconditionedConjugateGradient<double> cg(1E-8, 2000, true, 4);
+            NumericalVector<double> solution(n);
+            cg.solve(matrix, *rhs, solution);
+            unsigned unpreconditioned = cg.getIterations();
+
+            //The overlap couples the subdomains: fewer iterations than the block Jacobi of overlap 0
+            unsigned blockJacobi = iterations(4, 0, DirectSubdomainSolver, false);
+            unsigned overlapping = iterations(4, 2, DirectSubdomainSolver, false);
+            assert(blockJacobi < unpreconditioned && overlapping < blockJacobi);
+            assert(iterations(4, 2, IncompleteLUSubdomainSolver, false) < unpreconditioned);
+
+            //The coarse space carries the global information the 64 local solves lack: fewer iterations than 16 subdomains
+            //without it
+            unsigned oneLevel = iterations(64, 1, DirectSubdomainSolver, false);
+            unsigned twoLevel = iterations(64, 1, DirectSubdomainSolver, true);
+            assert(twoLevel < oneLevel && twoLevel <= iterations(16, 1, DirectSubdomainSolver, false));
+            logTestEnd();
+        }
+
+        static void testRestrictedSchwarz(){
+            logTestStart("testRestrictedSchwarz");
+            auto matrix = _convectionDiffusion(40, 40, 20, 0, UpwindConvection, 4);
+            unsigned n = matrix->numberOfRows();
+            auto rhs = _rhs(n);
+            unsigned iterations[2];
+            for (unsigned restricted = 0; restricted < 2; restricted++) {
+                auto schwarz = make_shared<AdditiveSchwarzPreconditioner<double>>(4, 2, DirectSubdomainSolver, true);
+                schwarz->setGridDimensions(_unknowns({40, 40}));
+                schwarz->setRestricted(restricted == 1);
+                schwarz->setup(matrix);
+                GeneralizedMinimalResidual<double> gmres(1E-8, 1000, true, 4);
+                gmres.setPreconditioner(schwarz);
+                NumericalVector<double> solution(n);
+                gmres.solve(matrix, *rhs, solution);
+                assert(_relativeResidual(*matrix, *rhs, solution) <= 1E-7);
+                iterations[restricted] = gmres.getIterations();
+            }
+            //The restricted variant does not add the overlap twice
+            assert(iterations[1] <= iterations[0]);
+            logTestEnd();
+        }
+
+        static void testAdditiveSchwarzReport(){
+            logTestStart("testAdditiveSchwarzReport");
+            unsigned threads = _reportThreads();
+            cout << endl << "  5-point Laplacian, PCG with global ILU(0) (level scheduled) against ASM(1, ILU(0)) with one subdomain per thread, "
+                 << threads << " threads. The sizes stop when a solve took longer than " << _maximumReportSeconds << " s" << endl;
+            for (unsigned grid = 64; grid <= 1024; grid *= 2) {
+                auto matrix = _laplacian(grid, grid, 1, threads);
+                unsigned n = matrix->numberOfRows();
+                auto rhs = _rhs(n);
+                auto ilu = make_shared<IncompleteLUPreconditioner<double>>();
+                auto schwarz = make_shared<AdditiveSchwarzPreconditioner<double>>(0, 1, IncompleteLUSubdomainSolver, threads > 1);
+                schwarz->setGridDimensions(_unknowns({grid, grid}));
+                shared_ptr<Preconditioner<double>> preconditioners[2] = {ilu, schwarz};
+                double setupTimes[2], solutionTimes[2];
+                unsigned iterations[2];
+                for (unsigned p = 0; p < 2; p++) {
+                    auto start = std::chrono::high_resolution_clock::now();
+                    preconditioners[p]->setup(matrix);
+                    setupTimes[p] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+                    PreconditionedConjugateGradient<double> pcg(1E-8, 10 * grid, true, threads);
+                    pcg.setPreconditioner(preconditioners[p]);
+                    NumericalVector<double> solution(n);
+                    pcg.solve(matrix, *rhs, solution);
+                    assert(_relativeResidual(*matrix, *rhs, solution) <= 1E-8);
+                    iterations[p] = pcg.getIterations();
+                    solutionTimes[p] = pcg.getSolutionTime();
+                }
+                cout << "    " << grid << "x" << grid << " : ILU(0) " << iterations[0] << " iterations, setup "
+                     << setupTimes[0] << " ms, solve " << solutionTimes[0] << " ms | " << schwarz->getName() << " "
+                     << schwarz->getNumberOfSubdomains() << " subdomains " << iterations[1] << " iterations, setup "
+                     << setupTimes[1] << " ms, solve " << solutionTimes[1] << " ms" << endl;
+                if (_isLastReportSize(std::max(solutionTimes[0], solutionTimes[1]) / 1000))
+                    break;
+            }
+            logTestEnd();
+        }
+
+    private:
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_ADDITIVESCHWARZTEST_H
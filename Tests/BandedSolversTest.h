@@ -0,0 +1,376 @@
+//
+// Created by hal9000 on 11/2/23.
+//
+
+#ifndef UNTITLED_BANDEDSOLVERSTEST_H
+#define UNTITLED_BANDEDSOLVERSTEST_H
+
+#include <cassert>
+#include <chrono>
+#include "../LinearAlgebra/Solvers/Direct/BandedLU.h"
+#include "../LinearAlgebra/Solvers/Multigrid/GeometricMultigrid.h"
+#include "../LinearAlgebra/Solvers/Multigrid/SmoothedAggregationMultigrid.h"
+#include "../LinearAlgebra/Solvers/Preconditioners/SSORPreconditioner.h"
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/PreconditionedConjugateGradient.h"
+#include "../LinearAlgebra/Array/DecompositionMethods/BlockedLU.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class BandedSolversTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testTridiagonalLines();
+            testBandedLU();
+            testLineRelaxation();
+            testAlternatingLineSmoother();
+            testStructuredGridSolversReport();
+        }
+
+        static void testTridiagonalLines(){
+            logTestStart("testTridiagonalLines");
+            //Interleaved lines: unknown k of line l is x[k * numberOfLines + l]
+            unsigned n = 60, numberOfLines = 150;
+            vector<double> lower(n * numberOfLines), diagonal(n * numberOfLines), upper(n * numberOfLines);
+            vector<double> modifiedUpper(n * numberOfLines), inverseDenominator(n * numberOfLines);
+            vector<double> rhs(n * numberOfLines), x(n * numberOfLines);
+            for (unsigned l = 0; l < numberOfLines; l++) {
+                for (unsigned k = 0; k < n; k++) {
+                    unsigned i = l * n + k;
+                    lower[i] = -1 - 0.3 * std::sin(i);
+                    upper[i] = -1 + 0.2 * std::cos(i);
+                    diagonal[i] = 2.6 + 0.1 * l;
+                    rhs[k * numberOfLines + l] = std::sin(0.1 * i) + 1;
+                }
+                assert(TridiagonalSolver<double>::factorize(lower.data() + l * n, diagonal.data() + l * n, upper.data() + l * n,
+                                                            n, modifiedUpper.data() + l * n, inverseDenominator.data() + l * n));
+            }
+            x = rhs;
+            TridiagonalSolver<double>::solveLines(lower.data(), modifiedUpper.data(), inverseDenominator.data(), n,
+                                                  numberOfLines, x.data(), [](unsigned line) { return line; },
+                                                  numberOfLines, 3);
+            double error = 0;
+            for (unsigned l = 0; l < numberOfLines; l++)
+                for (unsigned k = 0; k < n; k++) {
+                    unsigned i = l * n + k;
+                    double product = diagonal[i] * x[k * numberOfLines + l];
+                    if (k > 0) product += lower[i] * x[(k - 1) * numberOfLines + l];
+                    if (k + 1 < n) product += upper[i] * x[(k + 1) * numberOfLines + l];
+                    error = std::max(error, std::abs(product - rhs[k * numberOfLines + l]));
+                }
+            assert(error < 1E-13);
+            //Zero pivot
+            vector<double> singular = {1, 1, 1};
+            vector<double> unit = {1, 1, 1};
+            assert(!TridiagonalSolver<double>::factorize(unit.data(), singular.data(), unit.data(), 3,
+                                                         modifiedUpper.data(), inverseDenominator.data()));
+            logTestEnd();
+        }
+
+        static void testBandedLU(){
+            logTestStart("testBandedLU");
+            //Non-symmetric pentadiagonal matrix with small diagonal elements: needs the row interchanges
+            unsigned n = 500;
+            auto matrix = _pentadiagonal(n, 30, 2);
+            auto banded = BandedMatrix<double>::fromCSR(matrix);
+            assert(banded->lowerBandwidth() == 2 && banded->upperBandwidth() == 2);
+            NumericalVector<double> x(n), product(n);
+            for (unsigned i = 0; i < n; i++)
+                x[i] = std::cos(0.2 * i);
+            banded->multiply(x.getDataPointer(), product.getDataPointer(), 2);
+            NumericalVector<double> reference(n);
+            matrix->multiplyVector(x, reference);
+            for (unsigned i = 0; i < n; i++)
+                assert(std::abs(product[i] - reference[i]) < 1E-13);
+
+            BandedLU<double> solver;
+            solver.setup(matrix);
+            assert(solver.getName() == "Banded LU (2, 2)");
+            auto rhs = _rhs(n);
+            NumericalVector<double> solution(n);
+            solver.apply(*rhs, solution);
+            assert(_relativeResidual(*matrix, *rhs, solution) < 1E-12);
+            //Same factors for many right hand sides
+            vector<shared_ptr<NumericalVector<double>>> rhsColumns, solutions;
+            for (unsigned column = 0; column < 6; column++) {
+                rhsColumns.push_back(make_shared<NumericalVector<double>>(n));
+                for (unsigned i = 0; i < n; i++)
+                    (*rhsColumns.back())[i] = std::sin(0.1 * (column + 1) * i) + column;
+                solutions.push_back(make_shared<NumericalVector<double>>(n));
+            }
+            solver.solve(rhsColumns, solutions);
+            for (unsigned column = 0; column < 6; column++)
+                assert(_relativeResidual(*matrix, *rhsColumns[column], *solutions[column]) < 1E-12);
+
+            //Singular: a zero row
+            auto singular = make_shared<NumericalMatrix<double>>(4, 4, CSR, General, 1);
+            singular->dataStorage->initializeElementAssignment();
+            singular->setElement(0, 0, 2); singular->setElement(0, 1, 1);
+            singular->setElement(1, 0, 1); singular->setElement(1, 1, 2);
+            singular->setElement(3, 3, 1); singular->setElement(3, 2, 1);
+            singular->dataStorage->finalizeElementAssignment();
+            bool exceptionThrown = false;
+            try {
+                BandedLU<double> singularSolver;
+                singularSolver.setup(singular);
+            }
+            catch (const runtime_error &) {
+                exceptionThrown = true;
+            }
+            assert(exceptionThrown);
+            logTestEnd();
+        }
+
+        static void testLineRelaxation(){
+            logTestStart("testLineRelaxation");
+            //Lines in the only direction of a 1D grid are an exact solve
+            unsigned n = 300;
+            auto matrix1D = _stretchedDiffusion({n}, 1.02, 1);
+            LineRelaxation<double> exact({{PositioningInSpace::One, n}});
+            exact.setup(matrix1D);
+            auto rhs1D = _rhs(n);
+            NumericalVector<double> solution1D(n);
+            assert(exact.solve(*rhs1D, solution1D, 1E-12) == 1);
+
+            //Strong coupling in direction Two: lines in direction Two converge fast, point relaxation does not
+            unsigned nx = 63, ny = 63;
+            map<PositioningInSpace::Direction, unsigned> unknowns = {{PositioningInSpace::One, nx}, {PositioningInSpace::Two, ny}};
+            auto anisotropic = _anisotropicDiffusion(nx, ny, 1E-3, 2);
+            auto rhs = _rhs(nx * ny);
+            LineRelaxation<double> lines(unknowns, {PositioningInSpace::Two});
+            lines.setup(anisotropic);
+            assert(lines.getName() == "Line GS (Two)");
+            NumericalVector<double> solution(nx * ny);
+            auto sweeps = lines.solve(*rhs, solution, 1E-8, 100);
+            assert(sweeps < 50);
+            assert(_relativeResidual(*anisotropic, *rhs, solution) <= 1E-8);
+
+            //Symmetric preconditioner of PCG, ADI in both directions
+            auto adi = make_shared<LineRelaxation<double>>(unknowns);
+            adi->setup(anisotropic);
+            assert(adi->getName() == "ADI line GS (One, Two)");
+            PreconditionedConjugateGradient<double> solver(1E-10, 2000, true, 2);
+            solver.setPreconditioner(adi);
+            std::fill(solution.getDataPointer(), solution.getDataPointer() + solution.size(), 0.0);
+            solver.solve(anisotropic, *rhs, solution);
+            unsigned adiIterations = solver.getIterations();
+            assert(_relativeResidual(*anisotropic, *rhs, solution) <= 1E-9);
+            auto ssor = make_shared<SSORPreconditioner<double>>(1.0);
+            ssor->setup(anisotropic);
+            solver.setPreconditioner(ssor);
+            std::fill(solution.getDataPointer(), solution.getDataPointer() + solution.size(), 0.0);
+            solver.solve(anisotropic, *rhs, solution);
+            assert(2 * adiIterations < solver.getIterations());
+
+            //Couplings beyond the neighbouring lines
+            bool exceptionThrown = false;
+            try {
+                LineRelaxation<double> wrongGrid({{PositioningInSpace::One, 9}, {PositioningInSpace::Two, 7 * ny}});
+                wrongGrid.setup(anisotropic);
+            }
+            catch (const invalid_argument &) {
+                exceptionThrown = true;
+            }
+            assert(exceptionThrown);
+            logTestEnd();
+        }
+
+        static void testAlternatingLineSmoother(){
+            logTestStart("testAlternatingLineSmoother");
+            //Cells stretched towards opposite walls in x and y, the strong direction changes inside the mesh
+            unsigned n = 63;
+            map<PositioningInSpace::Direction, unsigned> unknowns = {{PositioningInSpace::One, n}, {PositioningInSpace::Two, n}};
+            auto matrix = _stretchedDiffusion({n, n}, 1.08, 2);
+            auto rhs = _rhs(n * n);
+            GeometricMultigrid<double> lineMultigrid(unknowns, VCycle, AlternatingLineSmoother, 1, 1);
+            lineMultigrid.setup(matrix);
+            assert(lineMultigrid.getName() == "GMG V(1,1) ADI line GS");
+            NumericalVector<double> solution(n * n);
+            auto lineCycles = lineMultigrid.solve(*rhs, solution, 1E-8, 100);
+            assert(_relativeResidual(*matrix, *rhs, solution) <= 1E-8);
+
+            GeometricMultigrid<double> pointMultigrid(unknowns, VCycle, ColoredGaussSeidelSmoother, 1, 1);
+            pointMultigrid.setup(matrix);
+            std::fill(solution.getDataPointer(), solution.getDataPointer() + solution.size(), 0.0);
+            auto pointCycles = pointMultigrid.solve(*rhs, solution, 1E-8, 500, false);
+            assert(2 * lineCycles < pointCycles);
+
+            //The line smoother needs the grids of the levels
+            bool exceptionThrown = false;
+            try {
+                SmoothedAggregationMultigrid<double> algebraic(0.08, VCycle, AlternatingLineSmoother);
+                algebraic.setup(matrix);
+            }
+            catch (const invalid_argument &) {
+                exceptionThrown = true;
+            }
+            assert(exceptionThrown);
+            logTestEnd();
+        }
+
+        static void testStructuredGridSolversReport(){
+            logTestStart("testStructuredGridSolversReport");
+            unsigned threads = _reportThreads();
+            cout << endl << "  1D fourth order convection-diffusion (pentadiagonal), " << threads << " threads" << endl;
+            for (unsigned n : {1000u, 100000u, 1000000u}) {
+                auto matrix = _pentadiagonal(n, 30, threads);
+                auto rhs = _rhs(n);
+                NumericalVector<double> solution(n);
+                BandedLU<double> banded;
+                auto start = chrono::high_resolution_clock::now();
+                banded.setup(matrix);
+                banded.apply(*rhs, solution);
+                auto end = chrono::high_resolution_clock::now();
+                cout << "    n = " << n << " : banded LU " << chrono::duration<double, std::milli>(end - start).count()
+                     << " ms, residual " << _relativeResidual(*matrix, *rhs, solution);
+                if (n <= 1000) {
+                    vector<double> dense(static_cast<size_t>(n) * n, 0);
+                    for (unsigned i = 0; i < n; i++)
+                        for (unsigned j = (i > 2 ? i - 2 : 0); j < std::min(n, i + 3); j++)
+                            dense[static_cast<size_t>(i) * n + j] = matrix->getElement(i, j);
+                    vector<unsigned> permutation;
+                    unsigned swaps = 0;
+                    vector<double> denseSolution(n);
+                    start = chrono::high_resolution_clock::now();
+                    BlockedLU<double>::factorize(dense.data(), n, n, permutation, swaps, 0, threads);
+                    BlockedLU<double>::solve(dense.data(), n, n, permutation, rhs->getDataPointer(), denseSolution.data());
+                    end = chrono::high_resolution_clock::now();
+                    cout << ", dense LU " << chrono::duration<double, std::milli>(end - start).count() << " ms";
+                }
+                cout << endl;
+            }
+
+            cout << "  2D diffusion on meshes stretched towards opposite walls (growth 1.05), to 1E-8" << endl;
+            for (unsigned n : {127u, 255u}) {
+                map<PositioningInSpace::Direction, unsigned> unknowns = {{PositioningInSpace::One, n}, {PositioningInSpace::Two, n}};
+                auto matrix = _stretchedDiffusion({n, n}, 1.05, threads);
+                auto rhs = _rhs(n * n);
+                cout << "    " << n << " x " << n << endl;
+                vector<pair<string, shared_ptr<Preconditioner<double>>>> preconditioners = {
+                        {"SSOR", make_shared<SSORPreconditioner<double>>(1.0)},
+                        {"ADI line GS", make_shared<LineRelaxation<double>>(unknowns)},
+                        {"GMG V(1,1) colored GS", make_shared<GeometricMultigrid<double>>(unknowns, VCycle, ColoredGaussSeidelSmoother, 1, 1)},
+                        {"GMG V(1,1) ADI line GS", make_shared<GeometricMultigrid<double>>(unknowns, VCycle, AlternatingLineSmoother, 1, 1)}};
+                for (auto &preconditioner : preconditioners) {
+                    NumericalVector<double> solution(n * n);
+                    auto start = chrono::high_resolution_clock::now();
+                    preconditioner.second->setup(matrix);
+                    auto end = chrono::high_resolution_clock::now();
+                    PreconditionedConjugateGradient<double> solver(1E-8, 5000, false, threads);
+                    solver.setPreconditioner(preconditioner.second);
+                    solver.solve(matrix, *rhs, solution);
+                    cout << "      PCG + " << preconditioner.first << " : setup "
+                         << chrono::duration<double, std::milli>(end - start).count() << " ms, "
+                         << solver.getIterations() << " iterations, solve " << solver.getSolutionTime() << " ms" << endl;
+                }
+            }
+            logTestEnd();
+        }
+
+    private:
+
+        /**
+         * Diffusion on the internal nodes of the unit interval / square with Dirichlet boundaries, finite volume
+         * discretization on nodes with geometrically growing spacing: towards 0 in direction One, towards 1 in direction
+         * Two. The couplings are the face length over the node distance, so the thin cells are strongly coupled across
+         * their thin side.
+         */
+        static shared_ptr<NumericalMatrix<double>> _stretchedDiffusion(const vector<unsigned> &dimensions, double growth,
+                                                                       unsigned availableThreads){
+            vector<vector<double>> gaps;
+            for (unsigned d = 0; d < dimensions.size(); d++) {
+                //gaps[k] is the distance between the nodes k - 1 and k, the nodes -1 and n are the boundaries
+                vector<double> gap(dimensions[d] + 1);
+                double sum = 0;
+                for (unsigned k = 0; k <= dimensions[d]; k++)
+                    sum += gap[k] = std::pow(growth, k);
+                for (auto &g : gap)
+                    g /= sum;
+                if (d == 1)
+                    std::reverse(gap.begin(), gap.end());
+                gaps.push_back(gap);
+            }
+            unsigned nx = dimensions[0], ny = dimensions.size() > 1 ? dimensions[1] : 1;
+            auto width = [&](unsigned d, unsigned k) { return d < gaps.size() ? (gaps[d][k] + gaps[d][k + 1]) / 2 : 1.0; };
+            auto matrix = make_shared<NumericalMatrix<double>>(nx * ny, nx * ny, CSR, General, availableThreads);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned j = 0; j < ny; j++) {
+                for (unsigned i = 0; i < nx; i++) {
+                    unsigned row = j * nx + i;
+                    double west = width(1, j) / gaps[0][i], east = width(1, j) / gaps[0][i + 1];
+                    double diagonal = west + east;
+                    if (i > 0) matrix->setElement(row, row - 1, -west);
+                    if (i < nx - 1) matrix->setElement(row, row + 1, -east);
+                    if (gaps.size() > 1) {
+                        double south = width(0, i) / gaps[1][j], north = width(0, i) / gaps[1][j + 1];
+                        diagonal += south + north;
+                        if (j > 0) matrix->setElement(row, row - nx, -south);
+                        if (j < ny - 1) matrix->setElement(row, row + nx, -north);
+                    }
+                    matrix->setElement(row, row, diagonal);
+                }
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        /**
+         * Finite difference -ε u_xx - u_yy on the internal nodes of the unit square with Dirichlet boundaries, scaled
+         * by h².
+         */
+        static shared_ptr<NumericalMatrix<double>> _anisotropicDiffusion(unsigned nx, unsigned ny, double epsilon,
+                                                                         unsigned availableThreads){
+            auto matrix = make_shared<NumericalMatrix<double>>(nx * ny, nx * ny, CSR, General, availableThreads);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned j = 0; j < ny; j++) {
+                for (unsigned i = 0; i < nx; i++) {
+                    unsigned row = j * nx + i;
+                    matrix->setElement(row, row, 2 * epsilon + 2);
+                    if (i > 0) matrix->setElement(row, row - 1, -epsilon);
+                    if (i < nx - 1) matrix->setElement(row, row + 1, -epsilon);
+                    if (j > 0) matrix->setElement(row, row - nx, -1);
+                    if (j < ny - 1) matrix->setElement(row, row + nx, -1);
+                }
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        /**
+         * Fourth order finite difference -u'' + c u' on the internal nodes of a uniform 1D mesh with Dirichlet
+         * boundaries, scaled by h², second order next to the boundaries. c h = peclet: a large Péclet number makes the
+         * diagonal small compared to the convection terms.
+         */
+        static shared_ptr<NumericalMatrix<double>> _pentadiagonal(unsigned n, double peclet, unsigned availableThreads){
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, availableThreads);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned i = 0; i < n; i++) {
+                if (i == 0 || i + 1 == n) {
+                    matrix->setElement(i, i, 2);
+                    if (i > 0) matrix->setElement(i, i - 1, -1 - peclet / 2);
+                    if (i + 1 < n) matrix->setElement(i, i + 1, -1 + peclet / 2);
+                    continue;
+                }
+                //-(-1, 16, -30, 16, -1) / 12 + peclet (1, -8, 0, 8, -1) / 12
+                matrix->setElement(i, i, 30.0 / 12);
+                matrix->setElement(i, i - 1, (-16 - 8 * peclet) / 12);
+                matrix->setElement(i, i + 1, (-16 + 8 * peclet) / 12);
+                if (i > 1) matrix->setElement(i, i - 2, (1 + peclet) / 12);
+                if (i + 2 < n) matrix->setElement(i, i + 2, (1 - peclet) / 12);
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_BANDEDSOLVERSTEST_H
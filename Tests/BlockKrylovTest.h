@@ -0,0 +1,239 @@
+//
+// Created by hal9000 on 11/4/23.
+//
+
+#ifndef UNTITLED_BLOCKKRYLOVTEST_H
+#define UNTITLED_BLOCKKRYLOVTEST_H
+
+#include <cassert>
+#include <chrono>
+#include <random>
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/BlockConjugateGradient.h"
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/BlockGeneralizedMinimalResidual.h"
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/PreconditionedConjugateGradient.h"
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/GeneralizedMinimalResidual.h"
+#include "../LinearAlgebra/Solvers/Preconditioners/JacobiPreconditioner.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class BlockKrylovTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testBlockConjugateGradient();
+            testBlockGeneralizedMinimalResidual();
+            testDeflation();
+            testSingleRightHandSide();
+            testBlockKrylovReport();
+        }
+
+        static void testBlockConjugateGradient(){
+            logTestStart("testBlockConjugateGradient");
+            auto matrix = _convectionDiffusion(40, 40, 0, 0, CentralConvection, 2);
+            auto jacobi = make_shared<JacobiPreconditioner<double>>();
+            jacobi->setup(matrix);
+            auto rhs = _rhs(matrix->numberOfRows(), 6);
+            auto solutions = _zeros(matrix->numberOfRows(), 6);
+            BlockConjugateGradient<double> solver(1E-10, 1000, true, 2);
+            solver.setPreconditioner(jacobi);
+            solver.solve(matrix, rhs, solutions);
+            assert(solver.hasConverged());
+            //The shared search space: fewer iterations than any separate CG, one block product per iteration
+            PreconditionedConjugateGradient<double> single(1E-10, 1000, true, 2);
+            single.setPreconditioner(jacobi);
+            unsigned fewestSingleIterations = 1000;
+            for (unsigned c = 0; c < 6; c++) {
+                assert(_relativeResidual(*matrix, *rhs[c], *solutions[c]) < 1E-9);
+                NumericalVector<double> solution(matrix->numberOfRows());
+                single.solve(matrix, *rhs[c], solution);
+                fewestSingleIterations = std::min(fewestSingleIterations, single.getIterations());
+                assert(solver.getColumnIterations()[c] <= solver.getIterations());
+                assert(solver.getColumnExitNorms()[c] <= 1E-10);
+            }
+            assert(solver.getIterations() < fewestSingleIterations);
+            assert(solver.getBlockProducts() == solver.getIterations() + 1);
+            assert(solver.getMatrixVectorProducts() <= 6 * solver.getBlockProducts());
+            logTestEnd();
+        }
+
+        static void testBlockGeneralizedMinimalResidual(){
+            logTestStart("testBlockGeneralizedMinimalResidual");
+            auto matrix = _convectionDiffusion(30, 30, 20, 0, CentralConvection, 2);
+            auto rhs = _rhs(matrix->numberOfRows(), 4);
+            //Long and short restarts, with and without preconditioner
+            for (unsigned restart : {50u, 5u}) {
+                for (bool precondition : {false, true}) {
+                    auto solutions = _zeros(matrix->numberOfRows(), 4);
+                    BlockGeneralizedMinimalResidual<double> solver(1E-10, 5000, true, 2, restart);
+                    if (precondition) {
+                        auto jacobi = make_shared<JacobiPreconditioner<double>>();
+                        jacobi->setup(matrix);
+                        solver.setPreconditioner(jacobi);
+                    }
+                    solver.solve(matrix, rhs, solutions);
+                    assert(solver.hasConverged());
+                    assert(restart == 5u ? solver.getCycles() > 1 : solver.getCycles() >= 1);
+                    for (unsigned c = 0; c < 4; c++)
+                        assert(_relativeResidual(*matrix, *rhs[c], *solutions[c]) < 1E-9);
+                }
+            }
+            //Matrix-free operators are applied column by column
+            NumericalMatrixOperator<double> assembled(matrix, 1);
+            FunctionLinearOperator<double> matrixFree(matrix->numberOfRows(), matrix->numberOfColumns(),
+                                                      [&](NumericalVector<double> &x, NumericalVector<double> &y) {
+                                                          assembled.multiply(x, y);
+                                                      });
+            auto solutions = _zeros(matrix->numberOfRows(), 4);
+            BlockGeneralizedMinimalResidual<double> solver(1E-10, 5000, true, 1, 30);
+            solver.solve(matrixFree, rhs, solutions);
+            for (unsigned c = 0; c < 4; c++)
+                assert(_relativeResidual(*matrix, *rhs[c], *solutions[c]) < 1E-9);
+            logTestEnd();
+        }
+
+        static void testDeflation(){
+            logTestStart("testDeflation");
+            auto symmetric = _convectionDiffusion(25, 25, 0, 0, CentralConvection, 2);
+            auto nonsymmetric = _convectionDiffusion(25, 25, 10, 0, CentralConvection, 2);
+            unsigned n = symmetric->numberOfRows();
+            //A duplicate, a linear combination, a zero right hand side and one that starts at its solution
+            auto rhs = _rhs(n, 3);
+            rhs.push_back(make_shared<NumericalVector<double>>(n));
+            rhs.push_back(make_shared<NumericalVector<double>>(n));
+            for (unsigned i = 0; i < n; i++) {
+                (*rhs[3])[i] = (*rhs[0])[i];
+                (*rhs[4])[i] = 2 * (*rhs[1])[i] - (*rhs[2])[i];
+            }
+            rhs.push_back(make_shared<NumericalVector<double>>(n));
+            for (auto &matrix : {symmetric, nonsymmetric}) {
+                auto exact = make_shared<NumericalVector<double>>(n);
+                for (unsigned i = 0; i < n; i++)
+                    (*exact)[i] = std::cos(0.1 * i);
+                auto exactRhs = make_shared<NumericalVector<double>>(n);
+                matrix->multiplyVector(*exact, *exactRhs);
+                auto allRhs = rhs;
+                allRhs.push_back(exactRhs);
+                auto solutions = _zeros(n, static_cast<unsigned>(allRhs.size()));
+                std::copy(exact->getDataPointer(), exact->getDataPointer() + n, solutions.back()->getDataPointer());
+
+                shared_ptr<BlockKrylovSolver<double>> solver;
+                if (matrix == symmetric)
+                    solver = make_shared<BlockConjugateGradient<double>>(1E-10, 1000, true, 2);
+                else
+                    solver = make_shared<BlockGeneralizedMinimalResidual<double>>(1E-10, 5000, true, 2, 40);
+                solver->solve(matrix, allRhs, solutions);
+                assert(solver->hasConverged());
+                for (unsigned c = 0; c < allRhs.size(); c++)
+                    assert(_relativeResidual(*matrix, *allRhs[c], *solutions[c]) < 1E-9);
+                //The zero right hand side and the exact initial guess converge at the initial residual
+                assert(solver->getColumnIterations()[5] == 0 && solver->getColumnIterations()[6] == 0);
+                //The dependent columns never widen the block beyond the 3 independent ones
+                assert(solver->getMatrixVectorProducts() <= 7 + 3 * (solver->getBlockProducts() - 1) +
+                                                            (matrix == symmetric ? 0 : 3 * solver->getBlockProducts()));
+            }
+            logTestEnd();
+        }
+
+        static void testSingleRightHandSide(){
+            logTestStart("testSingleRightHandSide");
+            //With one column block CG is PCG and block GMRES is GMRES
+            auto symmetric = _convectionDiffusion(30, 30, 0, 0, CentralConvection, 1);
+            auto nonsymmetric = _convectionDiffusion(30, 30, 20, 0, CentralConvection, 1);
+            auto rhs = _rhs(symmetric->numberOfRows(), 1);
+            NumericalVector<double> solution(symmetric->numberOfRows());
+
+            BlockConjugateGradient<double> blockCG(1E-10, 1000, true, 1);
+            blockCG.solve(symmetric, *rhs[0], solution);
+            PreconditionedConjugateGradient<double> cg(1E-10, 1000, true, 1);
+            std::fill(solution.getDataPointer(), solution.getDataPointer() + solution.size(), 0.0);
+            cg.solve(symmetric, *rhs[0], solution);
+            assert(blockCG.getIterations() + 1 >= cg.getIterations() && blockCG.getIterations() <= cg.getIterations() + 1);
+
+            BlockGeneralizedMinimalResidual<double> blockGMRES(1E-10, 5000, true, 1, 30);
+            std::fill(solution.getDataPointer(), solution.getDataPointer() + solution.size(), 0.0);
+            blockGMRES.solve(nonsymmetric, *rhs[0], solution);
+            assert(_relativeResidual(*nonsymmetric, *rhs[0], solution) < 1E-9);
+            GeneralizedMinimalResidual<double> gmres(1E-10, 5000, true, 1, 30);
+            std::fill(solution.getDataPointer(), solution.getDataPointer() + solution.size(), 0.0);
+            gmres.solve(nonsymmetric, *rhs[0], solution);
+            assert(blockGMRES.getIterations() == gmres.getIterations());
+            logTestEnd();
+        }
+
+        static void testBlockKrylovReport(){
+            logTestStart("testBlockKrylovReport");
+            unsigned threads = _reportThreads();
+            unsigned grid = 150;
+            auto matrix = _convectionDiffusion(grid, grid, 0, 0, CentralConvection, threads);
+            unsigned n = matrix->numberOfRows();
+            auto jacobi = make_shared<JacobiPreconditioner<double>>();
+            jacobi->setup(matrix);
+            cout << endl << "  " << grid << " x " << grid << " Poisson, Jacobi preconditioner, " << threads
+                 << " threads, to 1E-8. k separate PCG solves vs one block CG solve" << endl;
+            for (unsigned k : {1u, 4u, 8u, 16u}) {
+                auto rhs = _randomRhs(n, k, 17);
+                PreconditionedConjugateGradient<double> single(1E-8, 5000, true, threads);
+                single.setPreconditioner(jacobi);
+                unsigned singleProducts = 0;
+                double singleTime = 0;
+                for (unsigned c = 0; c < k; c++) {
+                    NumericalVector<double> solution(n, 0, threads);
+                    single.solve(matrix, *rhs[c], solution);
+                    singleProducts += single.getIterations() + 1;
+                    singleTime += single.getSolutionTime();
+                }
+                auto solutions = _zeros(n, k);
+                BlockConjugateGradient<double> block(1E-8, 5000, true, threads);
+                block.setPreconditioner(jacobi);
+                block.solve(matrix, rhs, solutions);
+                cout << "    k = " << k << " : PCG " << singleProducts << " matrix reads, " << singleTime
+                     << " ms | block CG " << block.getIterations() << " iterations, " << block.getBlockProducts()
+                     << " matrix reads (" << block.getMatrixVectorProducts() << " products), "
+                     << block.getSolutionTime() << " ms" << endl;
+            }
+            logTestEnd();
+        }
+
+    private:
+
+        static vector<shared_ptr<NumericalVector<double>>> _rhs(unsigned n, unsigned k){
+            vector<shared_ptr<NumericalVector<double>>> rhs;
+            for (unsigned c = 0; c < k; c++) {
+                rhs.push_back(make_shared<NumericalVector<double>>(n));
+                for (unsigned i = 0; i < n; i++)
+                    (*rhs[c])[i] = 1.0 + std::sin(0.37 * i + 1.3 * c) + (c % 2 == 1 ? 0.01 * (i % (c + 7)) : 0.0);
+            }
+            return rhs;
+        }
+
+        static vector<shared_ptr<NumericalVector<double>>> _randomRhs(unsigned n, unsigned k, unsigned seed){
+            std::mt19937 generator(seed);
+            std::uniform_real_distribution<double> distribution(-1, 1);
+            vector<shared_ptr<NumericalVector<double>>> rhs;
+            for (unsigned c = 0; c < k; c++) {
+                rhs.push_back(make_shared<NumericalVector<double>>(n));
+                for (unsigned i = 0; i < n; i++)
+                    (*rhs[c])[i] = distribution(generator);
+            }
+            return rhs;
+        }
+
+        static vector<shared_ptr<NumericalVector<double>>> _zeros(unsigned n, unsigned k){
+            vector<shared_ptr<NumericalVector<double>>> vectors;
+            for (unsigned c = 0; c < k; c++)
+                vectors.push_back(make_shared<NumericalVector<double>>(n));
+            return vectors;
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_BLOCKKRYLOVTEST_H
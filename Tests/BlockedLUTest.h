@@ -0,0 +1,216 @@
+//
+// Created by hal9000 on 11/1/23.
+//
+
+#ifndef UNTITLED_BLOCKEDLUTEST_H
+#define UNTITLED_BLOCKEDLUTEST_H
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include "../LinearAlgebra/Array/DecompositionMethods/DecompositionLUP.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class BlockedLUTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testFactorizationReconstructsMatrix();
+            testDecompositionLUP();
+            testSingularMatrix();
+            testLUFlopsReport();
+        }
+
+        static void testFactorizationReconstructsMatrix(){
+            logTestStart("testFactorizationReconstructsMatrix");
+            unsigned n = 301;
+            auto original = _matrix(n);
+            for (unsigned threads : {1u, 3u}) {
+                for (unsigned blockSize : {16u, 64u, n}) {
+                    vector<double> lu(original);
+                    vector<unsigned> permutation;
+                    unsigned swaps = 0;
+                    auto failedColumn = BlockedLU<double>::factorize(lu.data(), n, n, permutation, swaps, 0, threads, blockSize);
+                    assert(failedColumn == n);
+                    assert(swaps > 0);
+                    //Partial pivoting bounds the multipliers
+                    for (unsigned i = 0; i < n; i++)
+                        for (unsigned j = 0; j < i; j++)
+                            assert(std::abs(lu[i * n + j]) <= 1.0);
+                    //P A = L U
+                    double error = 0, norm = 0;
+                    for (unsigned i = 0; i < n; i++)
+                        for (unsigned j = 0; j < n; j++) {
+                            double product = 0;
+                            for (unsigned k = 0; k <= std::min(i, j); k++)
+                                product += (k == i ? 1.0 : lu[i * n + k]) * lu[k * n + j];
+                            error = std::max(error, std::abs(product - original[permutation[i] * n + j]));
+                            norm = std::max(norm, std::abs(original[i * n + j]));
+                        }
+                    assert(error < 1E-12 * n * norm);
+                    //A x = b
+                    vector<double> rhs(n), solution(n);
+                    for (unsigned i = 0; i < n; i++)
+                        rhs[i] = std::cos(0.3 * i);
+                    BlockedLU<double>::solve(lu.data(), n, n, permutation, rhs.data(), solution.data());
+                    assert(_relativeResidual(original, n, rhs, solution) < 1E-12);
+                }
+            }
+            logTestEnd();
+        }
+
+        static void testDecompositionLUP(){
+            logTestStart("testDecompositionLUP");
+            //Needs pivoting: zero leading element
+            auto matrix = make_shared<Array<double>>(3, 3);
+            double values[3][3] = {{0, 2, 1}, {1, 1, 1}, {4, 3, 2}};
+            for (unsigned i = 0; i < 3; i++)
+                for (unsigned j = 0; j < 3; j++)
+                    matrix->at(i, j) = values[i][j];
+            DecompositionLUP decomposition(matrix, 1E-12, true, 2);
+            decomposition.decomposeOnMatrix();
+            //det = 0 (2 - 3) - 2 (2 - 4) + 1 (3 - 4) = 3
+            assert(std::abs(decomposition.determinant() - 3) < 1E-12);
+            auto rhs = make_shared<vector<double>>(vector<double>{3, 3, 9});
+            auto solution = make_shared<vector<double>>(3);
+            decomposition.solve(rhs, solution);
+            for (unsigned i = 0; i < 3; i++)
+                assert(std::abs((*solution)[i] - 1) < 1E-12);
+            auto inverse = decomposition.invertMatrix();
+            for (unsigned i = 0; i < 3; i++)
+                for (unsigned j = 0; j < 3; j++) {
+                    double product = 0;
+                    for (unsigned k = 0; k < 3; k++)
+                        product += values[i][k] * inverse->at(k, j);
+                    assert(std::abs(product - (i == j ? 1 : 0)) < 1E-12);
+                }
+            //L U = P A from the copies of the factors
+            auto l = decomposition.getL();
+            auto u = decomposition.getU();
+            auto p = decomposition.getP();
+            for (unsigned i = 0; i < 3; i++)
+                for (unsigned j = 0; j < 3; j++) {
+                    double product = 0;
+                    for (unsigned k = 0; k < 3; k++)
+                        product += l->at(i, k) * u->at(k, j);
+                    assert(std::abs(product - values[(*p)[i]][j]) < 1E-12);
+                }
+
+            //Larger system through the Array interface
+            unsigned n = 200;
+            auto original = _matrix(n);
+            auto large = make_shared<Array<double>>(n, n);
+            std::copy(original.begin(), original.end(), large->getArrayPointer());
+            DecompositionLUP largeDecomposition(large, 1E-12, true, 3);
+            largeDecomposition.decompose();
+            auto largeRhs = make_shared<vector<double>>(n, 1.0);
+            auto largeSolution = make_shared<vector<double>>(n);
+            largeDecomposition.solve(largeRhs, largeSolution);
+            assert(_relativeResidual(original, n, *largeRhs, *largeSolution) < 1E-12);
+            logTestEnd();
+        }
+
+        static void testSingularMatrix(){
+            logTestStart("testSingularMatrix");
+            unsigned n = 100;
+            auto matrix = make_shared<Array<double>>(n, n);
+            auto original = _matrix(n);
+            std::copy(original.begin(), original.end(), matrix->getArrayPointer());
+            //Row 70 is the sum of rows 3 and 40
+            for (unsigned j = 0; j < n; j++)
+                matrix->at(70, j) = matrix->at(3, j) + matrix->at(40, j);
+            bool exceptionThrown = false;
+            try {
+                DecompositionLUP decomposition(matrix, 1E-10, true, 2);
+                decomposition.decomposeOnMatrix();
+            }
+            catch (const runtime_error &) {
+                exceptionThrown = true;
+            }
+            assert(exceptionThrown);
+            logTestEnd();
+        }
+
+        static void testLUFlopsReport(){
+            logTestStart("testLUFlopsReport");
+            unsigned threads = _reportThreads();
+            cout << endl << "  Dense LU with partial pivoting, " << threads << " threads. The sizes stop when the previous"
+                 << " one took longer than " << _maximumReportSeconds << " s" << endl;
+            double previousSeconds = 0;
+            for (unsigned n = 256; n <= 8192; n *= 2) {
+                //The next size costs 8 times more
+                if (_isLastReportSize(previousSeconds)) {
+                    previousSeconds *= 8;
+                    cout << "    n = " << n << " skipped (estimated " << previousSeconds << " s)" << endl;
+                    continue;
+                }
+                auto original = _matrix(n);
+                cout << "    n = " << n;
+                for (unsigned blockSize : {n, 32u}) {
+                    //The unblocked factorization only for the small sizes
+                    if (blockSize == n && n > 1024)
+                        continue;
+                    vector<double> lu(original);
+                    vector<unsigned> permutation;
+                    unsigned swaps = 0;
+                    auto start = chrono::high_resolution_clock::now();
+                    BlockedLU<double>::factorize(lu.data(), n, n, permutation, swaps, 0, threads, blockSize);
+                    auto end = chrono::high_resolution_clock::now();
+                    double seconds = chrono::duration<double>(end - start).count();
+                    cout << (blockSize == n ? " : unblocked " : ", blocked ") << seconds * 1000 << " ms ("
+                         << BlockedLU<double>::flops(n) / seconds * 1E-9 << " GFlop/s)";
+                    if (blockSize != n) {
+                        previousSeconds = seconds;
+                        vector<double> rhs(n, 1.0), solution(n);
+                        BlockedLU<double>::solve(lu.data(), n, n, permutation, rhs.data(), solution.data());
+                        cout << ", residual " << _relativeResidual(original, n, rhs, solution);
+                    }
+                }
+                cout << endl;
+            }
+            logTestEnd();
+        }
+
+    private:
+        /**
+         * Dense non-symmetric matrix with pseudo-random elements in [-1, 1) and small diagonal elements, so that partial
+         * pivoting is needed.
+         */
+        static vector<double> _matrix(unsigned n){
+            vector<double> matrix(static_cast<size_t>(n) * n);
+            unsigned long long state = 12345;
+            for (unsigned i = 0; i < n; i++)
+                for (unsigned j = 0; j < n; j++) {
+                    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+                    double random = static_cast<double>(state >> 11) / 9007199254740992.0;
+                    matrix[static_cast<size_t>(i) * n + j] = i == j ? 0.01 : 2 * random - 1;
+                }
+            return matrix;
+        }
+
+        static double _relativeResidual(const vector<double> &matrix, unsigned n, const vector<double> &rhs,
+                                        const vector<double> &solution){
+            double residual = 0, rhsNorm = 0;
+            for (unsigned i = 0; i < n; i++) {
+                double sum = rhs[i];
+                for (unsigned j = 0; j < n; j++)
+                    sum -= matrix[static_cast<size_t>(i) * n + j] * solution[j];
+                residual += sum * sum;
+                rhsNorm += rhs[i] * rhs[i];
+            }
+            return std::sqrt(residual / rhsNorm);
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_BLOCKEDLUTEST_H
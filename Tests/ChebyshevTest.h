@@ -0,0 +1,318 @@
+//
+// Created by hal9000 on 11/8/23.
+//
+
+#ifndef UNTITLED_CHEBYSHEVTEST_H
+#define UNTITLED_CHEBYSHEVTEST_H
+
+#include <cassert>
+#include <chrono>
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/ChebyshevIteration.h"
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/PreconditionedConjugateGradient.h"
+#include "../LinearAlgebra/Solvers/Multigrid/GeometricMultigrid.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class ChebyshevTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testSpectralBounds();
+            testChebyshevIteration();
+            testBoundsCache();
+            testChebyshevSmoother();
+            testChebyshevReport();
+        }
+
+        static void testSpectralBounds(){
+            logTestStart("testSpectralBounds");
+            //Known extremes of a tridiagonal matrix
+            auto extremes = SpectralBoundsEstimator<double>::tridiagonalExtremes({2, 2, 2}, {-1, -1});
+            assert(std::abs(extremes.first - (2 - std::sqrt(2))) < 1E-13 && std::abs(extremes.second - (2 + std::sqrt(2))) < 1E-13);
+
+            unsigned grid = 20;
+            auto matrix = _laplacian(grid, grid, 1, 2);
+            double minimum = _exactMinimum(grid), maximum = _exactMaximum(grid);
+            NumericalMatrixOperator<double> matrixOperator(matrix);
+            SpectralBoundsEstimator<double> lanczos(LanczosBounds, 100, 1E-6, 2);
+            auto bounds = lanczos.estimate(matrixOperator);
+            //The Ritz values lie inside the spectrum
+            assert(bounds.maximum <= maximum * (1 + 1E-12) && bounds.maximum > maximum * (1 - 1E-4));
+            assert(bounds.minimum >= minimum * (1 - 1E-12) && bounds.minimum < minimum * (1 + 1E-2));
+            assert(bounds.steps < 100 && bounds.reductions == 2 * bounds.steps);
+
+            //The same estimate from the action of a matrix-free operator
+            FunctionLinearOperator<double> matrixFree(matrix->numberOfRows(), matrix->numberOfColumns(),
+                                                      [&](NumericalVector<double> &x, NumericalVector<double> &y) {
+                                                          matrix->multiplyVector(x, y);
+                                                      });
+            auto matrixFreeBounds = lanczos.estimate(matrixFree);
+            assert(matrixFreeBounds.steps == bounds.steps && std::abs(matrixFreeBounds.maximum - bounds.maximum) < 1E-10);
+
+            //D = 4 I: the bounds of D^-1 A are a quarter
+            JacobiPreconditioner<double> jacobi;
+            jacobi.setup(matrix);
+            auto scaled = lanczos.estimate(matrixOperator, &jacobi);
+            assert(std::abs(scaled.maximum - bounds.maximum / 4) < 1E-6 && std::abs(scaled.minimum - bounds.minimum / 4) < 1E-6);
+
+            //The power method converges for the largest eigenvalue
+            SpectralBoundsEstimator<double> power(PowerMethodBounds, 2000, 1E-7, 2);
+            auto powerBounds = power.estimate(matrixOperator, nullptr, true);
+            assert(std::abs(powerBounds.maximum - maximum) < 1E-2 * maximum && powerBounds.minimum == 0);
+            assert(powerBounds.steps > bounds.steps);
+            powerBounds = power.estimate(matrixOperator);
+            assert(powerBounds.minimum > 0 && powerBounds.minimum < powerBounds.maximum);
+
+            //Not positive definite
+            FunctionLinearOperator<double> negative(10, 10, [](NumericalVector<double> &x, NumericalVector<double> &y) {
+                for (unsigned i = 0; i < 10; i++)
+                    y[i] = -x[i];
+            });
+            bool thrown = false;
+            try { lanczos.estimate(negative); } catch (runtime_error &) { thrown = true; }
+            assert(thrown);
+            logTestEnd();
+        }
+
+        static void testChebyshevIteration(){
+            logTestStart("testChebyshevIteration");
+            unsigned grid = 30;
+            auto matrix = _laplacian(grid, grid, 1, 2);
+            unsigned n = matrix->numberOfRows();
+            auto rhs = _rhs(n);
+            ChebyshevIteration<double> chebyshev(1E-8, 2000, true, 2);
+            NumericalVector<double> solution(n);
+            chebyshev.solve(matrix, *rhs, solution);
+            assert(_relativeResidual(*matrix, *rhs, solution) <= 1E-8);
+            unsigned estimationSteps = chebyshev.getEstimationSteps();
+            assert(estimationSteps > 0);
+            assert(chebyshev.getSpectralBounds().maximum >= _exactMaximum(grid));
+
+            PreconditionedConjugateGradient<double> pcg(1E-8, 2000, true, 2);
+            NumericalVector<double> pcgSolution(n);
+            pcg.solve(matrix, *rhs, pcgSolution);
+            //O(√κ) iterations like CG
+            assert(chebyshev.getIterations() <= 3 * pcg.getIterations());
+
+            //The second solve takes the bounds from the cache. A x0 and A d per iteration, ||b|| and ||r0|| and one norm
+            //per check, no inner products in the iteration
+            NumericalVector<double> secondSolution(n);
+            chebyshev.solve(matrix, *rhs, secondSolution);
+            auto &summary = chebyshev.getTelemetry()->getSummary();
+            unsigned iterations = chebyshev.getIterations();
+            unsigned checks = static_cast<unsigned>(chebyshev.getResidualNorms()->size()) - 1;
+            assert(chebyshev.getEstimationSteps() == 0);
+            assert(summary.matrixVectorProducts == iterations + 1);
+            assert(summary.reductions == 2 + checks && checks == (iterations + 9) / 10);
+            assert(summary.reductions * 10 < pcg.getTelemetry()->getSummary().reductions);
+
+            //Matrix-free operators are cached by their identity
+            FunctionLinearOperator<double> matrixFree(n, n, [&](NumericalVector<double> &x, NumericalVector<double> &y) {
+                matrix->multiplyVector(x, y);
+            });
+            NumericalVector<double> matrixFreeSolution(n);
+            chebyshev.solve(matrixFree, *rhs, matrixFreeSolution);
+            assert(chebyshev.getEstimationSteps() == estimationSteps && chebyshev.getIterations() == iterations);
+            chebyshev.solve(matrixFree, *rhs, matrixFreeSolution);
+            assert(chebyshev.getEstimationSteps() == 0);
+            //A new operator, possibly at the address of a destroyed one, is estimated again
+            double matrixFreeMaximum = chebyshev.getSpectralBounds().maximum;
+            for (double scale : {2.0, 3.0}) {
+                auto scaled = make_shared<FunctionLinearOperator<double>>(n, n, [&](NumericalVector<double> &x, NumericalVector<double> &y) {
+                    matrix->multiplyVector(x, y);
+                    for (unsigned i = 0; i < y.size(); i++)
+                        y[i] *= scale;
+                });
+                std::fill(matrixFreeSolution.getDataPointer(), matrixFreeSolution.getDataPointer() + n, 0.0);
+                chebyshev.solve(*scaled, *rhs, matrixFreeSolution);
+                assert(chebyshev.getEstimationSteps() > 0);
+                assert(std::abs(chebyshev.getSpectralBounds().maximum - scale * matrixFreeMaximum) < 1E-6 * scale * matrixFreeMaximum);
+            }
+
+            //Jacobi preconditioned, with its own cache entry
+            auto jacobi = make_shared<JacobiPreconditioner<double>>();
+            jacobi->setup(matrix);
+            chebyshev.setPreconditioner(jacobi);
+            NumericalVector<double> preconditionedSolution(n);
+            chebyshev.solve(matrix, *rhs, preconditionedSolution);
+            assert(chebyshev.getEstimationSteps() > 0 && chebyshev.getBoundsCache()->size() == 5);
+            assert(_relativeResidual(*matrix, *rhs, preconditionedSolution) <= 1E-8);
+            //A new setup() of the same preconditioner, from 2 A, halves the bounds of M^-1 A
+            double preconditionedMaximum = chebyshev.getSpectralBounds().maximum;
+            auto doubled = _laplacian(grid, grid, 1, 2);
+            for (unsigned i = 0; i < doubled->dataStorage->getValues()->size(); i++)
+                doubled->dataStorage->getValuesDataPointer()[i] *= 2;
+            jacobi->setup(doubled);
+            std::fill(preconditionedSolution.getDataPointer(), preconditionedSolution.getDataPointer() + n, 0.0);
+            chebyshev.solve(matrix, *rhs, preconditionedSolution);
+            assert(chebyshev.getEstimationSteps() > 0);
+            assert(std::abs(chebyshev.getSpectralBounds().maximum - 0.5 * preconditionedMaximum) < 1E-6 * preconditionedMaximum);
+            assert(_relativeResidual(*matrix, *rhs, preconditionedSolution) <= 1E-8);
+            chebyshev.setPreconditioner(nullptr);
+
+            //Fixed exact bounds
+            chebyshev.setSpectralBounds(_exactMinimum(grid), _exactMaximum(grid));
+            NumericalVector<double> fixedSolution(n);
+            chebyshev.solve(matrix, *rhs, fixedSolution);
+            assert(chebyshev.getEstimationSteps() == 0 && _relativeResidual(*matrix, *rhs, fixedSolution) <= 1E-8);
+
+            //An upper bound below λmax diverges
+            chebyshev.setSpectralBounds(_exactMinimum(grid), 0.8 * _exactMaximum(grid));
+            chebyshev.setMaxIterations(500);
+            bool thrown = false;
+            NumericalVector<double> divergentSolution(n);
+            try { chebyshev.solve(matrix, *rhs, divergentSolution); } catch (runtime_error &) { thrown = true; }
+            assert(thrown && !(chebyshev.getExitNorm() < 1));
+            thrown = false;
+            try { chebyshev.setSpectralBounds(2, 1); } catch (invalid_argument &) { thrown = true; }
+            assert(thrown);
+            logTestEnd();
+        }
+
+        static void testBoundsCache(){
+            logTestStart("testBoundsCache");
+            auto matrix = _laplacian(15, 15, 1, 1);
+            unsigned n = matrix->numberOfRows();
+            auto rhs = _rhs(n);
+            ChebyshevIteration<double> chebyshev(1E-8, 2000, true, 1);
+            NumericalVector<double> solution(n);
+            chebyshev.solve(matrix, *rhs, solution);
+            double maximum = chebyshev.getSpectralBounds().maximum;
+
+            //Values changed in place are detected by the hash of the values
+            for (unsigned i = 0; i < matrix->dataStorage->getValues()->size(); i++)
+                matrix->dataStorage->getValuesDataPointer()[i] *= 2;
+            std::fill(solution.getDataPointer(), solution.getDataPointer() + n, 0.0);
+            chebyshev.solve(matrix, *rhs, solution);
+            assert(chebyshev.getEstimationSteps() > 0 && std::abs(chebyshev.getSpectralBounds().maximum - 2 * maximum) < 1E-6 * maximum);
+            assert(chebyshev.getBoundsCache()->size() == 1);
+
+            //One entry per matrix and preconditioner, removed per matrix
+            auto cache = chebyshev.getBoundsCache();
+            auto other = _laplacian(15, 15, 1, 1);
+            cache->store(other, 0, {1, 2, 0, 0});
+            assert(cache->find(other, 0)->maximum == 2 && cache->find(other, 1) == nullptr);
+            cache->invalidate(matrix.get());
+            assert(cache->size() == 1 && cache->find(matrix, 0) == nullptr);
+            cache->invalidate(other.get());
+            assert(cache->size() == 0);
+            logTestEnd();
+        }
+
+        static void testChebyshevSmoother(){
+            logTestStart("testChebyshevSmoother");
+            unsigned grid = 63;
+            auto matrix = _laplacian(grid, grid, 1, 2);
+            unsigned n = matrix->numberOfRows();
+            auto rhs = _rhs(n);
+
+            //A fixed polynomial: symmetric, it preconditions PCG better than Jacobi
+            auto chebyshev = make_shared<ChebyshevPreconditioner<double>>(4);
+            chebyshev->setup(matrix);
+            assert(chebyshev->getEstimationSteps() > 0 && std::abs(chebyshev->getSpectralBounds().maximum - 2) < 0.05);
+            auto jacobi = make_shared<JacobiPreconditioner<double>>();
+            jacobi->setup(matrix);
+            unsigned iterations[2];
+            shared_ptr<Preconditioner<double>> preconditioners[2] = {jacobi, chebyshev};
+            for (unsigned p = 0; p < 2; p++) {
+                PreconditionedConjugateGradient<double> pcg(1E-8, 2000, true, 2);
+                pcg.setPreconditioner(preconditioners[p]);
+                NumericalVector<double> solution(n);
+                pcg.solve(matrix, *rhs, solution);
+                assert(_relativeResidual(*matrix, *rhs, solution) <= 1E-8);
+                iterations[p] = pcg.getIterations();
+            }
+            assert(2 * iterations[1] < iterations[0]);
+
+            //A second smoother of the same matrix and cache does not estimate again
+            auto second = make_shared<ChebyshevPreconditioner<double>>(2);
+            second->setBoundsCache(chebyshev->getBoundsCache());
+            second->setup(matrix);
+            assert(second->getEstimationSteps() == 0 && second->getSpectralBounds().maximum == chebyshev->getSpectralBounds().maximum);
+
+            //Matrix-free setup from the diagonal
+            auto matrixFree = make_shared<FunctionLinearOperator<double>>(n, n, [&](NumericalVector<double> &x, NumericalVector<double> &y) {
+                matrix->multiplyVector(x, y);
+            });
+            ChebyshevPreconditioner<double> matrixFreeSmoother(4);
+            matrixFreeSmoother.setup(matrixFree, NumericalVector<double>(n, 4.0, 2), 2);
+            NumericalVector<double> z(n), matrixFreeZ(n);
+            chebyshev->apply(*rhs, z);
+            matrixFreeSmoother.apply(*rhs, matrixFreeZ);
+            for (unsigned i = 0; i < n; i++)
+                assert(std::abs(z[i] - matrixFreeZ[i]) < 1E-12 * std::abs(z[i]) + 1E-14);
+
+            //Multigrid smoother: mesh independent cycles
+            unsigned previousCycles = 0;
+            for (unsigned size : {31u, 63u, 127u}) {
+                auto levelMatrix = _laplacian(size, size, 1, 2);
+                auto levelRhs = _rhs(levelMatrix->numberOfRows());
+                GeometricMultigrid<double> multigrid(_unknowns({size, size}), VCycle, ChebyshevSmoother, 1, 1);
+                multigrid.setup(levelMatrix);
+                NumericalVector<double> solution(levelMatrix->numberOfRows());
+                unsigned cycles = multigrid.solve(*levelRhs, solution, 1E-8, 40);
+                assert(_relativeResidual(*levelMatrix, *levelRhs, solution) <= 1E-8);
+                assert(cycles <= 15 && (previousCycles == 0 || cycles <= previousCycles + 2));
+                previousCycles = cycles;
+                //A second hierarchy sharing the cache estimates only its new coarse operators
+                GeometricMultigrid<double> shared(_unknowns({size, size}), VCycle, ChebyshevSmoother, 1, 1);
+                shared.setSpectralBoundsCache(multigrid.getSpectralBoundsCache());
+                shared.setup(levelMatrix);
+                unsigned smoothedLevels = multigrid.getNumberOfLevels() - 1;
+                assert(multigrid.getSpectralBoundsCache()->size() == 2 * smoothedLevels - 1);
+            }
+            logTestEnd();
+        }
+
+        static void testChebyshevReport(){
+            logTestStart("testChebyshevReport");
+            unsigned threads = _reportThreads();
+            cout << endl << "  5-point Laplacian, PCG against Chebyshev iteration (cached bounds, norm every 10 iterations), "
+                 << threads << " threads. The sizes stop when a solve took longer than " << _maximumReportSeconds << " s" << endl;
+            for (unsigned grid = 32; grid <= 512; grid *= 2) {
+                auto matrix = _laplacian(grid, grid, 1, threads);
+                unsigned n = matrix->numberOfRows();
+                auto rhs = _rhs(n);
+                PreconditionedConjugateGradient<double> pcg(1E-8, 10 * grid, true, threads);
+                NumericalVector<double> pcgSolution(n);
+                pcg.solve(matrix, *rhs, pcgSolution);
+                ChebyshevIteration<double> chebyshev(1E-8, 10 * grid, true, threads);
+                NumericalVector<double> solution(n);
+                chebyshev.solve(matrix, *rhs, solution);
+                unsigned estimationSteps = chebyshev.getEstimationSteps();
+                std::fill(solution.getDataPointer(), solution.getDataPointer() + n, 0.0);
+                chebyshev.solve(matrix, *rhs, solution);
+                assert(_relativeResidual(*matrix, *rhs, solution) <= 1E-8);
+                auto &pcgSummary = pcg.getTelemetry()->getSummary();
+                auto &summary = chebyshev.getTelemetry()->getSummary();
+                cout << "    " << grid << "x" << grid << " : PCG " << pcg.getIterations() << " iterations, "
+                     << pcgSummary.reductions << " reductions, " << pcg.getSolutionTime() << " ms | Chebyshev "
+                     << chebyshev.getIterations() << " iterations, " << summary.reductions << " reductions, "
+                     << chebyshev.getSolutionTime() << " ms (bounds estimate " << estimationSteps << " products)" << endl;
+                if (_isLastReportSize(std::max(pcg.getSolutionTime(), chebyshev.getSolutionTime()) / 1000))
+                    break;
+            }
+            logTestEnd();
+        }
+
+    private:
+        static double _exactMinimum(unsigned grid){
+            return 4 - 4 * std::cos(M_PI / (grid + 1));
+        }
+
+        static double _exactMaximum(unsigned grid){
+            return 4 + 4 * std::cos(M_PI / (grid + 1));
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_CHEBYSHEVTEST_H
@@ -0,0 +1,148 @@
+//
+// Created by hal9000 on 10/20/23.
+//
+
+#ifndef UNTITLED_COMPRESSEDINDEXCSRTEST_H
+#define UNTITLED_COMPRESSEDINDEXCSRTEST_H
+
+#include <cassert>
+#include <random>
+#include "../LinearAlgebra/ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrixReordering/NumericalMatrixReordering.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class CompressedIndexCSRTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testFivePointStencilCompression();
+            testSevenPointStencilCompression();
+            testLongJumpExceptions();
+            testCompressedSpMVPerformanceReport();
+        }
+
+        static void testFivePointStencilCompression(){
+            logTestStart("testFivePointStencilCompression");
+            auto matrix = _laplacian(30, 20, 1, 2);
+            auto compressed = _compress(*matrix, 16);
+            auto &storage = _storage(*compressed);
+            assert(storage.getDeltaSize() == 1);
+            //Apart from the first column of each segment, all the deltas of the stencil fit in 8 bits
+            assert(storage.bytesPerNonZero() < storage.uncompressedBytesPerNonZero() - 2.5);
+            assert(_equalElements(*matrix, *compressed));
+            assert(_equalProducts(*matrix, *compressed));
+            //A write through the reference of a missing element does not leak into later reads
+            compressed->getElement(0, 2) = 1;
+            assert(compressed->getElement(0, 2) == 0 && compressed->getElement(5, 9) == 0);
+            logTestEnd();
+        }
+
+        static void testSevenPointStencilCompression(){
+            logTestStart("testSevenPointStencilCompression");
+            auto matrix = _laplacian(20, 20, 20, 4);
+            auto compressed = _compress(*matrix);
+            //The +-nx*ny jumps do not fit in 8 bits, so 16-bit deltas store fewer bytes than 8-bit deltas with exceptions
+            assert(_storage(*compressed).getDeltaSize() == 2);
+            assert(_equalProducts(*matrix, *compressed));
+            logTestEnd();
+        }
+
+        static void testLongJumpExceptions(){
+            logTestStart("testLongJumpExceptions");
+            unsigned n = 3000;
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, 2);
+            std::mt19937 generator(7);
+            std::uniform_int_distribution<unsigned> column(0, n - 1);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned row = 0; row < n; row++) {
+                matrix->setElement(row, row, 10);
+                if (row > 0) matrix->setElement(row, row - 1, -1);
+                if (row % 3 == 0) matrix->setElement(row, column(generator), 0.5);
+            }
+            //A few empty rows
+            for (unsigned row = 100; row < 105; row++) {
+                matrix->dataStorage->eraseElement(row, row);
+                matrix->dataStorage->eraseElement(row, row - 1);
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            auto compressed = _compress(*matrix, 32);
+            assert(_storage(*compressed).getSupplementaryVectors()[1]->size() > 0);
+            assert(_equalElements(*matrix, *compressed));
+            assert(_equalProducts(*matrix, *compressed));
+
+            bool exceptionThrown = false;
+            try {
+                compressed->setElement(0, 0, 1);
+            }
+            catch (const runtime_error &) {
+                exceptionThrown = true;
+            }
+            assert(exceptionThrown);
+            logTestEnd();
+        }
+
+        static void testCompressedSpMVPerformanceReport(){
+            logTestStart("testCompressedSpMVPerformanceReport");
+            cout << endl;
+            _report("2D 5-point 400x400", _laplacian(400, 400, 1, 1));
+            _report("3D 7-point 50x50x50", _laplacian(50, 50, 50, 1));
+            logTestEnd();
+        }
+
+    private:
+
+        static shared_ptr<NumericalMatrix<double>> _compress(NumericalMatrix<double> &matrix, unsigned rowsPerSegment = 64){
+            auto storage = make_shared<CompressedIndexCSRStorageDataProvider<double>>(
+                    matrix.dataStorage, matrix.numberOfRows(), matrix.numberOfColumns(), rowsPerSegment);
+            return make_shared<NumericalMatrix<double>>(matrix.numberOfRows(), matrix.numberOfColumns(), storage);
+        }
+
+        static CompressedIndexCSRStorageDataProvider<double> &_storage(NumericalMatrix<double> &compressed){
+            return *dynamic_pointer_cast<CompressedIndexCSRStorageDataProvider<double>>(compressed.dataStorage);
+        }
+
+        static bool _equalElements(NumericalMatrix<double> &a, NumericalMatrix<double> &b){
+            for (unsigned i = 0; i < a.numberOfRows(); i++)
+                for (unsigned j = 0; j < a.numberOfColumns(); j++)
+                    if (a.getElement(i, j) != b.getElement(i, j))
+                        return false;
+            return true;
+        }
+
+        static bool _equalProducts(NumericalMatrix<double> &a, NumericalMatrix<double> &b){
+            NumericalVector<double> x(a.numberOfColumns()), y(a.numberOfRows()), z(a.numberOfRows());
+            for (unsigned i = 0; i < x.size(); i++)
+                x[i] = static_cast<double>(i % 11) - 5.0;
+            a.multiplyVector(x, y);
+            b.multiplyVector(x, z);
+            return y == z;
+        }
+
+        static void _report(const string &name, const shared_ptr<NumericalMatrix<double>> &matrix){
+            auto compressed = _compress(*matrix);
+            auto &storage = _storage(*compressed);
+            double nonZeros = storage.getValues()->size();
+            double vectorBytes = (matrix->numberOfRows() + matrix->numberOfColumns()) * sizeof(double);
+            double csrTime = NumericalMatrixReordering<double>::spmvTime(*matrix, 20);
+            double compressedTime = NumericalMatrixReordering<double>::spmvTime(*compressed, 20);
+            //GB/s from the bytes that an SpMV has to move at least once: the matrix, x and y
+            double csrBandwidth = (nonZeros * storage.uncompressedBytesPerNonZero() + vectorBytes) / csrTime * 1E-3;
+            double compressedBandwidth = (nonZeros * storage.bytesPerNonZero() + vectorBytes) / compressedTime * 1E-3;
+            cout << "  " << name << " (" << storage.getDeltaSize() * 8 << "-bit deltas)" << endl;
+            cout << "    bytes/nnz  CSR / compressed : " << storage.uncompressedBytesPerNonZero() << " / " << storage.bytesPerNonZero() << endl;
+            cout << "    SpMV time  CSR / compressed : " << csrTime << " μs / " << compressedTime << " μs" << endl;
+            cout << "    SpMV GB/s  CSR / compressed : " << csrBandwidth << " / " << compressedBandwidth << endl;
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_COMPRESSEDINDEXCSRTEST_H
@@ -0,0 +1,186 @@
+//
+// Created by hal9000 on 10/23/23.
+//
+
+#ifndef UNTITLED_DIASTORAGETEST_H
+#define UNTITLED_DIASTORAGETEST_H
+
+#include <cassert>
+#include <random>
+#include "../LinearAlgebra/ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrixReordering/NumericalMatrixReordering.h"
+
+namespace Tests {
+
+    class DIAStorageTest {
+    public:
+        static void runTests(){
+            testFivePointStencilDiagonals();
+            testNinePointRectangularDiagonals();
+            testFallbackToCSR();
+            testDiagonalSpMVPerformanceReport();
+        }
+
+        static void testFivePointStencilDiagonals(){
+            logTestStart("testFivePointStencilDiagonals");
+            auto matrix = _stencilMatrix(30, 20, 1, false, 2);
+            auto diagonal = _toDIA(*matrix);
+            assert(diagonal->dataStorage->getStorageType() == DIA);
+            auto &storage = _storage(*diagonal);
+            assert((storage.getDiagonalOffsets() == vector<int>{-30, -1, 0, 1, 30}));
+            assert(_equalElements(*matrix, *diagonal));
+            assert(_equalProducts(*matrix, *diagonal, 3));
+            bool exceptionThrown = false;
+            try {
+                diagonal->setElement(0, 0, 1);
+            }
+            catch (const runtime_error &) {
+                exceptionThrown = true;
+            }
+            assert(exceptionThrown);
+            diagonal->getElement(0, 2) = 1;
+            assert(diagonal->getElement(0, 2) == 0 && diagonal->getElement(5, 9) == 0);
+            logTestEnd();
+        }
+
+        static void testNinePointRectangularDiagonals(){
+            logTestStart("testNinePointRectangularDiagonals");
+            //9-point stencil restricted to the first 17 columns: offsets near the corner leave the matrix
+            auto square = _stencilMatrix(7, 5, 1, true, 1);
+            auto matrix = make_shared<NumericalMatrix<double>>(35, 17, CSR, General, 2);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned row = 0; row < 35; row++)
+                for (unsigned column = 0; column < 17; column++)
+                    if (square->getElement(row, column) != 0)
+                        matrix->setElement(row, column, square->getElement(row, column) + 0.01 * row);
+            matrix->dataStorage->finalizeElementAssignment();
+            auto diagonal = _toDIA(*matrix, 2);
+            assert(diagonal->dataStorage->getStorageType() == DIA);
+            assert(_storage(*diagonal).getNumberOfDiagonals() == 9);
+            assert(_equalElements(*matrix, *diagonal));
+            assert(_equalProducts(*matrix, *diagonal, 2));
+            logTestEnd();
+        }
+
+        static void testFallbackToCSR(){
+            logTestStart("testFallbackToCSR");
+            unsigned n = 500;
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, 2);
+            std::mt19937 generator(11);
+            std::uniform_int_distribution<unsigned> column(0, n - 1);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned row = 0; row < n; row++) {
+                matrix->setElement(row, row, 4);
+                matrix->setElement(row, column(generator), -1);
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            assert(DIAStorageDataProvider<double>::storageRatio(matrix->dataStorage, n, n) > 1);
+            auto storage = DIAStorageDataProvider<double>::fromCSROrFallback(matrix->dataStorage, n, n);
+            assert(storage == matrix->dataStorage);
+            logTestEnd();
+        }
+
+        static void testDiagonalSpMVPerformanceReport(){
+            logTestStart("testDiagonalSpMVPerformanceReport");
+            cout << endl;
+            _report("2D 5-point 400x400", _stencilMatrix(400, 400, 1, false, 1));
+            _report("2D 9-point 400x400", _stencilMatrix(400, 400, 1, true, 1));
+            _report("3D 7-point 50x50x50", _stencilMatrix(50, 50, 50, false, 1));
+            logTestEnd();
+        }
+
+    private:
+
+        /**
+         * Assembles the 7-point (5-point if nz = 1, 9-point if nz = 1 and crossTerms) finite difference matrix of a
+         * nx x ny x nz grid in lexicographic order, with distinct values on the boundary rows.
+         */
+        static shared_ptr<NumericalMatrix<double>> _stencilMatrix(unsigned nx, unsigned ny, unsigned nz, bool crossTerms,
+                                                                  unsigned availableThreads){
+            unsigned n = nx * ny * nz;
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, availableThreads);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned k = 0; k < nz; k++) {
+                for (unsigned j = 0; j < ny; j++) {
+                    for (unsigned i = 0; i < nx; i++) {
+                        unsigned row = (k * ny + j) * nx + i;
+                        bool boundary = i == 0 || j == 0 || i == nx - 1 || j == ny - 1;
+                        matrix->setElement(row, row, (nz > 1 ? 6 : 4) + (boundary ? 1 : 0));
+                        if (i > 0) matrix->setElement(row, row - 1, -1);
+                        if (i < nx - 1) matrix->setElement(row, row + 1, -1.5);
+                        if (j > 0) matrix->setElement(row, row - nx, -1);
+                        if (j < ny - 1) matrix->setElement(row, row + nx, -0.5);
+                        if (k > 0) matrix->setElement(row, row - nx * ny, -1);
+                        if (k < nz - 1) matrix->setElement(row, row + nx * ny, -1);
+                        if (crossTerms) {
+                            if (i > 0 && j > 0) matrix->setElement(row, row - nx - 1, 0.25);
+                            if (i < nx - 1 && j > 0) matrix->setElement(row, row - nx + 1, -0.25);
+                            if (i > 0 && j < ny - 1) matrix->setElement(row, row + nx - 1, -0.25);
+                            if (i < nx - 1 && j < ny - 1) matrix->setElement(row, row + nx + 1, 0.25);
+                        }
+                    }
+                }
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        static shared_ptr<NumericalMatrix<double>> _toDIA(NumericalMatrix<double> &matrix, double maximumStorageRatio = 1.0){
+            auto storage = DIAStorageDataProvider<double>::fromCSROrFallback(
+                    matrix.dataStorage, matrix.numberOfRows(), matrix.numberOfColumns(), maximumStorageRatio);
+            return make_shared<NumericalMatrix<double>>(matrix.numberOfRows(), matrix.numberOfColumns(), storage);
+        }
+
+        static DIAStorageDataProvider<double> &_storage(NumericalMatrix<double> &diagonal){
+            return *dynamic_pointer_cast<DIAStorageDataProvider<double>>(diagonal.dataStorage);
+        }
+
+        static bool _equalElements(NumericalMatrix<double> &a, NumericalMatrix<double> &b){
+            for (unsigned i = 0; i < a.numberOfRows(); i++)
+                for (unsigned j = 0; j < a.numberOfColumns(); j++)
+                    if (a.getElement(i, j) != b.getElement(i, j))
+                        return false;
+            return true;
+        }
+
+        static bool _equalProducts(NumericalMatrix<double> &a, NumericalMatrix<double> &b, unsigned availableThreads){
+            NumericalVector<double> x(a.numberOfColumns()), y(a.numberOfRows()), z(a.numberOfRows());
+            for (unsigned i = 0; i < x.size(); i++)
+                x[i] = static_cast<double>(i % 11) - 5.0;
+            a.multiplyVector(x, y, 2, 0.5, availableThreads);
+            b.multiplyVector(x, z, 2, 0.5, availableThreads);
+            for (unsigned i = 0; i < y.size(); i++)
+                if (abs(y[i] - z[i]) > 1E-12)
+                    return false;
+            return true;
+        }
+
+        static void _report(const string &name, const shared_ptr<NumericalMatrix<double>> &matrix){
+            auto diagonal = _toDIA(*matrix);
+            auto &storage = _storage(*diagonal);
+            double nonZeros = matrix->dataStorage->getValues()->size();
+            double csrBytesPerNonZero = (nonZeros * (sizeof(double) + sizeof(unsigned)) +
+                                         (matrix->numberOfRows() + 1) * sizeof(unsigned)) / nonZeros;
+            double vectorBytes = (matrix->numberOfRows() + matrix->numberOfColumns()) * sizeof(double);
+            double csrTime = NumericalMatrixReordering<double>::spmvTime(*matrix, 20);
+            double diagonalTime = NumericalMatrixReordering<double>::spmvTime(*diagonal, 20);
+            //GB/s from the bytes that an SpMV has to move at least once: the matrix, x and y
+            double csrBandwidth = (nonZeros * csrBytesPerNonZero + vectorBytes) / csrTime * 1E-3;
+            double diagonalBandwidth = (nonZeros * storage.bytesPerNonZero() + vectorBytes) / diagonalTime * 1E-3;
+            cout << "  " << name << " (" << storage.getNumberOfDiagonals() << " diagonals)" << endl;
+            cout << "    bytes/nnz  CSR / DIA : " << csrBytesPerNonZero << " / " << storage.bytesPerNonZero() << endl;
+            cout << "    SpMV time  CSR / DIA : " << csrTime << " μs / " << diagonalTime << " μs" << endl;
+            cout << "    SpMV GB/s  CSR / DIA : " << csrBandwidth << " / " << diagonalBandwidth << endl;
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_DIASTORAGETEST_H
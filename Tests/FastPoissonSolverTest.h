@@ -0,0 +1,228 @@
+//
+// Created by hal9000 on 11/3/23.
+//
+
+#ifndef UNTITLED_FASTPOISSONSOLVERTEST_H
+#define UNTITLED_FASTPOISSONSOLVERTEST_H
+
+#include <cassert>
+#include <chrono>
+#include "../LinearAlgebra/Solvers/Direct/FastPoissonSolver.h"
+#include "../LinearAlgebra/Solvers/Multigrid/GeometricMultigrid.h"
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/PreconditionedConjugateGradient.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class FastPoissonSolverTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testFourierTransform();
+            testSineTransform();
+            testFastPoissonSolver();
+            testDetectionAndFallback();
+            testFastPoissonReport();
+        }
+
+        static void testFourierTransform(){
+            logTestStart("testFourierTransform");
+            //Radix-2 and Bluestein lengths
+            for (unsigned n : {1u, 2u, 16u, 64u, 12u, 37u, 100u}) {
+                FastFourierTransform<double> fourier(n);
+                vector<complex<double>> x(n), transformed(n);
+                for (unsigned j = 0; j < n; j++)
+                    x[j] = complex<double>(std::sin(0.7 * j) + 0.1 * j, std::cos(1.3 * j));
+                transformed = x;
+                fourier.transform(transformed.data());
+                for (unsigned k = 0; k < n; k++) {
+                    complex<double> sum = 0;
+                    for (unsigned j = 0; j < n; j++)
+                        sum += x[j] * std::polar(1.0, -2 * M_PI * ((static_cast<unsigned long>(j) * k) % n) / n);
+                    assert(std::abs(sum - transformed[k]) < 1E-11 * n);
+                }
+                //The inverse without the factor 1 / n
+                fourier.transform(transformed.data(), true);
+                for (unsigned j = 0; j < n; j++)
+                    assert(std::abs(transformed[j] / static_cast<double>(n) - x[j]) < 1E-12 * n);
+            }
+            logTestEnd();
+        }
+
+        static void testSineTransform(){
+            logTestStart("testSineTransform");
+            for (unsigned n : {1u, 7u, 10u, 31u}) {
+                FastSineTransform<double> sine(n);
+                //Two interleaved sequences transformed together, and a third one alone
+                vector<double> pair(2 * n), single(n);
+                for (unsigned j = 0; j < n; j++) {
+                    pair[2 * j] = std::sin(0.4 * j) + 1;
+                    pair[2 * j + 1] = std::cos(0.9 * j);
+                    single[j] = 0.5 * j;
+                }
+                vector<double> originalPair(pair), originalSingle(single);
+                vector<complex<double>> buffer, work;
+                sine.transform(pair.data(), pair.data() + 1, 2, buffer, work);
+                sine.transform(single.data(), nullptr, 1, buffer, work);
+                for (unsigned k = 0; k < n; k++) {
+                    double first = 0, second = 0, third = 0;
+                    for (unsigned j = 0; j < n; j++) {
+                        double s = std::sin(M_PI * (j + 1) * (k + 1) / (n + 1));
+                        first += originalPair[2 * j] * s;
+                        second += originalPair[2 * j + 1] * s;
+                        third += originalSingle[j] * s;
+                    }
+                    assert(std::abs(first - pair[2 * k]) < 1E-12 * n);
+                    assert(std::abs(second - pair[2 * k + 1]) < 1E-12 * n);
+                    assert(std::abs(third - single[k]) < 1E-12 * n);
+                }
+                //Self inverse up to 2 / (n + 1), for many lines in parallel
+                sine.transformLines(pair.data(), 2, [](unsigned line) { return line; }, 2, 2);
+                for (unsigned j = 0; j < 2 * n; j++)
+                    assert(std::abs(pair[j] * 2 / (n + 1) - originalPair[j]) < 1E-12 * n);
+            }
+            logTestEnd();
+        }
+
+        static void testFastPoissonSolver(){
+            logTestStart("testFastPoissonSolver");
+            //Different spacing per direction and a Helmholtz shift, odd and even lengths, 1D to 3D
+            vector<vector<unsigned>> grids = {{50}, {31, 24}, {15, 20, 9}};
+            for (auto &grid : grids) {
+                vector<double> couplings = {-1, -4, -0.25};
+                couplings.resize(grid.size());
+                for (double shift : {0.0, 0.5}) {
+                    auto matrix = _separable(grid, couplings, shift, 3);
+                    FastPoissonSolver<double> solver(_unknowns(grid));
+                    solver.setup(matrix);
+                    assert(solver.usesFastPath());
+                    assert(solver.getName() == "Fast Poisson (DST-I)");
+                    auto rhs = _rhs(matrix->numberOfRows());
+                    NumericalVector<double> solution(matrix->numberOfRows());
+                    solver.apply(*rhs, solution);
+                    assert(_relativeResidual(*matrix, *rhs, solution) < 1E-12);
+                }
+            }
+            logTestEnd();
+        }
+
+        static void testDetectionAndFallback(){
+            logTestStart("testDetectionAndFallback");
+            vector<unsigned> grid = {20, 18};
+            auto rhs = _rhs(20 * 18);
+            NumericalVector<double> solution(20 * 18);
+
+            //Variable coefficient: solved by the fallback
+            auto variable = _separable(grid, {-1, -1}, 0, 2, [](unsigned row) { return row == 45 ? 0.5 : 0.0; });
+            FastPoissonSolver<double> solver(_unknowns(grid));
+            solver.setup(variable);
+            assert(!solver.usesFastPath());
+            assert(solver.getDetectionReport().find("diagonal is not constant") != string::npos);
+            assert(solver.getName().find("fallback") != string::npos);
+            solver.apply(*rhs, solution);
+            assert(_relativeResidual(*variable, *rhs, solution) < 1E-12);
+
+            //Coupling to a node that is not a neighbour of the grid, e.g. the grid dimensions are wrong
+            auto matrix = _separable(grid, {-1, -1}, 0, 2);
+            FastPoissonSolver<double> wrongGrid({{PositioningInSpace::One, 18}, {PositioningInSpace::Two, 20}});
+            wrongGrid.setup(matrix);
+            assert(!wrongGrid.usesFastPath());
+            assert(wrongGrid.getDetectionReport().find("not a grid neighbour") != string::npos);
+
+            //Singular: a Helmholtz shift that cancels the eigenvalue of the first sine mode
+            auto singular = _separable({5}, {-1}, 2 * std::cos(M_PI / 6) - 2, 1);
+            FastPoissonSolver<double> singularSolver({{PositioningInSpace::One, 5}});
+            singularSolver.setFallback(nullptr);
+            bool exceptionThrown = false;
+            try {
+                singularSolver.setup(singular);
+            }
+            catch (const invalid_argument &) {
+                exceptionThrown = true;
+            }
+            assert(exceptionThrown && singularSolver.getDetectionReport().find("singular") != string::npos);
+            logTestEnd();
+        }
+
+        static void testFastPoissonReport(){
+            logTestStart("testFastPoissonReport");
+            unsigned threads = _reportThreads();
+            cout << endl << "  Constant coefficient Poisson with Dirichlet walls, " << threads << " threads. Fast Poisson"
+                 << " solve vs PCG + GMG V(1,1) to 1E-10" << endl;
+            vector<vector<unsigned>> grids = {{255, 255}, {300, 300}, {1023, 1023}, {63, 63, 63}, {95, 95, 95}};
+            for (auto &grid : grids) {
+                auto matrix = _separable(grid, vector<double>(grid.size(), -1), 0, threads);
+                auto rhs = _rhs(matrix->numberOfRows());
+                NumericalVector<double> solution(matrix->numberOfRows());
+                FastPoissonSolver<double> fast(_unknowns(grid));
+                auto start = chrono::high_resolution_clock::now();
+                fast.setup(matrix);
+                auto end = chrono::high_resolution_clock::now();
+                double setupTime = chrono::duration<double, std::milli>(end - start).count();
+                start = chrono::high_resolution_clock::now();
+                fast.apply(*rhs, solution);
+                end = chrono::high_resolution_clock::now();
+                string name;
+                for (auto n : grid)
+                    name += (name.empty() ? "" : " x ") + to_string(n);
+                cout << "    " << name << " : fast Poisson setup " << setupTime << " ms, solve "
+                     << chrono::duration<double, std::milli>(end - start).count() << " ms, residual "
+                     << _relativeResidual(*matrix, *rhs, solution);
+
+                auto multigrid = make_shared<GeometricMultigrid<double>>(_unknowns(grid), VCycle, DampedJacobiSmoother, 1, 1);
+                start = chrono::high_resolution_clock::now();
+                multigrid->setup(matrix);
+                end = chrono::high_resolution_clock::now();
+                PreconditionedConjugateGradient<double> solver(1E-10, 500, false, threads);
+                solver.setPreconditioner(multigrid);
+                std::fill(solution.getDataPointer(), solution.getDataPointer() + solution.size(), 0.0);
+                solver.solve(matrix, *rhs, solution);
+                cout << " | PCG + GMG setup " << chrono::duration<double, std::milli>(end - start).count() << " ms, "
+                     << solver.getIterations() << " iterations, solve " << solver.getSolutionTime() << " ms" << endl;
+            }
+            logTestEnd();
+        }
+
+    private:
+
+        /**
+         * Finite difference operator shift I - Σ_d a_d (u_{i-1} - 2 u_i + u_{i+1}) in direction d on the internal
+         * nodes of a box with Dirichlet walls, i.e. the couplings are a_d and the diagonal shift - 2 Σ_d a_d, plus
+         * extraDiagonal(row).
+         */
+        static shared_ptr<NumericalMatrix<double>> _separable(const vector<unsigned> &grid, const vector<double> &couplings,
+                                                              double shift, unsigned availableThreads,
+                                                              const function<double(unsigned)> &extraDiagonal = [](unsigned) { return 0.0; }){
+            unsigned n = 1;
+            for (auto count : grid)
+                n *= count;
+            double diagonal = shift;
+            for (auto coupling : couplings)
+                diagonal -= 2 * coupling;
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, availableThreads);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned row = 0; row < n; row++) {
+                matrix->setElement(row, row, diagonal + extraDiagonal(row));
+                unsigned stride = 1;
+                for (unsigned d = 0; d < grid.size(); d++) {
+                    unsigned position = row / stride % grid[d];
+                    if (position > 0) matrix->setElement(row, row - stride, couplings[d]);
+                    if (position + 1 < grid[d]) matrix->setElement(row, row + stride, couplings[d]);
+                    stride *= grid[d];
+                }
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_FASTPOISSONSOLVERTEST_H
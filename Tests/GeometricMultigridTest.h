@@ -0,0 +1,192 @@
+//
+// Created by hal9000 on 10/27/23.
+//
+
+#ifndef UNTITLED_GEOMETRICMULTIGRIDTEST_H
+#define UNTITLED_GEOMETRICMULTIGRIDTEST_H
+
+#include <cassert>
+#include "../LinearAlgebra/Solvers/Multigrid/GeometricMultigrid.h"
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/PreconditionedConjugateGradient.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class GeometricMultigridTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testHierarchyAndProlongation();
+            testStandaloneCycles();
+            testRediscretizedCoarseOperators();
+            testMultigridPreconditionedConjugateGradient();
+            testMeshIndependentConvergenceReport();
+        }
+
+        static void testHierarchyAndProlongation(){
+            logTestStart("testHierarchyAndProlongation");
+            auto matrix = _scaledLaplacian({31, 15}, 1);
+            GeometricMultigrid<double> multigrid(_unknowns({31, 15}));
+            multigrid.setup(matrix);
+            //31x15 -> 15x7 -> 7x3 (21 unknowns)
+            assert(multigrid.getNumberOfLevels() == 3);
+            assert(multigrid.getLevelDimensions(1) == vector<unsigned>({15, 7}));
+            assert(multigrid.getLevelDimensions(2) == vector<unsigned>({7, 3}));
+
+            //Bilinear interpolation reproduces bilinear functions away from the last fine nodes of each direction
+            auto &P = *multigrid.getProlongation(0);
+            NumericalVector<double> coarse(15 * 7), fine(31 * 15);
+            auto f = [](double x, double y) { return 2 * x + 3 * y + 0.5 * x * y; };
+            for (unsigned j = 0; j < 7; j++)
+                for (unsigned i = 0; i < 15; i++)
+                    coarse[j * 15 + i] = f(2 * i + 1, 2 * j + 1);
+            P.multiplyVector(coarse, fine);
+            for (unsigned j = 1; j < 14; j++)
+                for (unsigned i = 1; i < 30; i++)
+                    assert(abs(fine[j * 31 + i] - f(i, j)) < 1E-12);
+            logTestEnd();
+        }
+
+        static void testStandaloneCycles(){
+            logTestStart("testStandaloneCycles");
+            vector<unsigned> dimensions = {63, 63};
+            auto matrix = _scaledLaplacian(dimensions, 2);
+            auto rhs = _rhs(matrix->numberOfRows());
+            unsigned vCycles = 0;
+            for (auto smoother : {DampedJacobiSmoother, ColoredGaussSeidelSmoother}) {
+                for (auto cycle : {VCycle, WCycle, FCycle}) {
+                    GeometricMultigrid<double> multigrid(_unknowns(dimensions), cycle, smoother);
+                    multigrid.setup(matrix);
+                    NumericalVector<double> solution(matrix->numberOfRows());
+                    unsigned cycles = multigrid.solve(*rhs, solution, 1E-8, 50);
+                    assert(_relativeResidual(*matrix, *rhs, solution) <= 1E-8);
+                    assert(multigrid.getResidualNorms()->size() == cycles + 1);
+                    assert(cycles <= 15);
+                    if (cycle == VCycle)
+                        vCycles = cycles;
+                    else
+                        assert(cycles <= vCycles);
+                }
+            }
+            logTestEnd();
+        }
+
+        static void testRediscretizedCoarseOperators(){
+            logTestStart("testRediscretizedCoarseOperators");
+            vector<unsigned> dimensions = {15, 15, 15};
+            auto matrix = _scaledLaplacian(dimensions, 2);
+            auto rhs = _rhs(matrix->numberOfRows());
+            GeometricMultigrid<double> multigrid(_unknowns(dimensions), VCycle, ColoredGaussSeidelSmoother);
+            multigrid.setCoarseOperatorFunction([](const vector<unsigned> &coarseDimensions) {
+                return _scaledLaplacian(coarseDimensions, 2);
+            });
+            multigrid.setup(matrix);
+            assert(multigrid.getLevelMatrix(1)->numberOfRows() == 7 * 7 * 7);
+            NumericalVector<double> solution(matrix->numberOfRows());
+            unsigned cycles = multigrid.solve(*rhs, solution, 1E-8, 30);
+            assert(cycles <= 15);
+            assert(_relativeResidual(*matrix, *rhs, solution) <= 1E-8);
+            logTestEnd();
+        }
+
+        static void testMultigridPreconditionedConjugateGradient(){
+            logTestStart("testMultigridPreconditionedConjugateGradient");
+            vector<unsigned> dimensions = {127, 127};
+            auto matrix = _scaledLaplacian(dimensions, 2);
+            auto rhs = _rhs(matrix->numberOfRows());
+            for (auto smoother : {DampedJacobiSmoother, ColoredGaussSeidelSmoother}) {
+                auto multigrid = make_shared<GeometricMultigrid<double>>(_unknowns(dimensions), VCycle, smoother, 1, 1);
+                multigrid->setup(matrix);
+                PreconditionedConjugateGradient<double> solver(1E-10, 100, true, 2);
+                solver.setPreconditioner(multigrid);
+                NumericalVector<double> solution(matrix->numberOfRows());
+                solver.solve(matrix, *rhs, solution);
+                assert(solver.getIterations() <= 15);
+                assert(_relativeResidual(*matrix, *rhs, solution) <= 1E-9);
+            }
+            logTestEnd();
+        }
+
+        static void testMeshIndependentConvergenceReport(){
+            logTestStart("testMeshIndependentConvergenceReport");
+            unsigned threads = _reportThreads();
+            cout << endl << "  Cycles / PCG iterations to a relative residual of 1E-8 (" << threads << " threads)" << endl;
+            vector<vector<unsigned>> meshes = {{31, 31}, {63, 63}, {127, 127}, {255, 255}, {15, 15, 15}, {31, 31, 31}, {63, 63, 63}};
+            unsigned minimum = 1000, maximum = 0;
+            for (auto &dimensions : meshes) {
+                auto matrix = _scaledLaplacian(dimensions, threads);
+                auto rhs = _rhs(matrix->numberOfRows());
+                string name;
+                for (unsigned d = 0; d < dimensions.size(); d++)
+                    name += (d > 0 ? "x" : "") + to_string(dimensions[d]);
+                cout << "    " << name << " (" << matrix->numberOfRows() << " unknowns) :";
+                for (auto cycle : {VCycle, WCycle, FCycle}) {
+                    GeometricMultigrid<double> multigrid(_unknowns(dimensions), cycle, ColoredGaussSeidelSmoother);
+                    multigrid.setup(matrix);
+                    NumericalVector<double> solution(matrix->numberOfRows());
+                    auto start = std::chrono::high_resolution_clock::now();
+                    unsigned cycles = multigrid.solve(*rhs, solution, 1E-8, 50);
+                    auto end = std::chrono::high_resolution_clock::now();
+                    cout << " " << multigrid.getName() << " " << cycles << " ("
+                         << std::chrono::duration<double, std::milli>(end - start).count() << " ms),";
+                    if (cycle == VCycle) {
+                        minimum = std::min(minimum, cycles);
+                        maximum = std::max(maximum, cycles);
+                    }
+                }
+                auto multigrid = make_shared<GeometricMultigrid<double>>(_unknowns(dimensions), VCycle, DampedJacobiSmoother, 1, 1);
+                multigrid->setup(matrix);
+                PreconditionedConjugateGradient<double> solver(1E-8, 1000, true, threads);
+                solver.setPreconditioner(multigrid);
+                NumericalVector<double> solution(matrix->numberOfRows());
+                solver.solve(matrix, *rhs, solution);
+                cout << " PCG " << multigrid->getName() << " " << solver.getIterations() << " ("
+                     << solver.getSolutionTime() << " ms)" << endl;
+            }
+            //The convergence rate does not depend on the mesh size
+            assert(maximum - minimum <= 2);
+            logTestEnd();
+        }
+
+    private:
+
+        /**
+         * The finite difference Laplacian -Δu of the internal nodes of the unit square (cube) with Dirichlet
+         * boundaries, scaled by 1/h² in each direction.
+         */
+        static shared_ptr<NumericalMatrix<double>> _scaledLaplacian(const vector<unsigned> &dimensions, unsigned availableThreads){
+            unsigned nx = dimensions[0], ny = dimensions.size() > 1 ? dimensions[1] : 1, nz = dimensions.size() > 2 ? dimensions[2] : 1;
+            double hx = 1.0 / (nx + 1), hy = 1.0 / (ny + 1), hz = 1.0 / (nz + 1);
+            double cx = 1 / (hx * hx), cy = ny > 1 ? 1 / (hy * hy) : 0, cz = nz > 1 ? 1 / (hz * hz) : 0;
+            unsigned n = nx * ny * nz;
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, availableThreads);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned k = 0; k < nz; k++) {
+                for (unsigned j = 0; j < ny; j++) {
+                    for (unsigned i = 0; i < nx; i++) {
+                        unsigned row = (k * ny + j) * nx + i;
+                        matrix->setElement(row, row, 2 * (cx + cy + cz));
+                        if (i > 0) matrix->setElement(row, row - 1, -cx);
+                        if (i < nx - 1) matrix->setElement(row, row + 1, -cx);
+                        if (j > 0) matrix->setElement(row, row - nx, -cy);
+                        if (j < ny - 1) matrix->setElement(row, row + nx, -cy);
+                        if (k > 0) matrix->setElement(row, row - nx * ny, -cz);
+                        if (k < nz - 1) matrix->setElement(row, row + nx * ny, -cz);
+                    }
+                }
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_GEOMETRICMULTIGRIDTEST_H
@@ -0,0 +1,187 @@
+//
+// Created by hal9000 on 10/26/23.
+//
+
+#ifndef UNTITLED_INCOMPLETELUPRECONDITIONERTEST_H
+#define UNTITLED_INCOMPLETELUPRECONDITIONERTEST_H
+
+#include <cassert>
+#include "../LinearAlgebra/Solvers/Preconditioners/ThresholdIncompleteLUPreconditioner.h"
+#include "../LinearAlgebra/Solvers/Preconditioners/JacobiPreconditioner.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class IncompleteLUPreconditionerTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testIncompleteLUExactWithoutFill();
+            testLevelScheduledSolve();
+            testThresholdIncompleteLUExactFactorization();
+            testThresholdFillLimit();
+            testIncompleteLUPerformanceReport();
+        }
+
+        static void testIncompleteLUExactWithoutFill(){
+            logTestStart("testIncompleteLUExactWithoutFill");
+            //The LU factors of a tridiagonal matrix have no fill-in, so ILU(0) is the exact factorization
+            unsigned n = 300;
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, 1);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned i = 0; i < n; i++) {
+                matrix->setElement(i, i, 3.0 + 0.01 * i);
+                if (i > 0) matrix->setElement(i, i - 1, -1.7);
+                if (i < n - 1) matrix->setElement(i, i + 1, -0.4);
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            IncompleteLUPreconditioner<double> ilu;
+            ilu.setup(matrix);
+            assert(_inverseError(ilu, *matrix) < 1E-12);
+            assert(ilu.getLowerFactor().numberOfLevels() == n && ilu.getUpperFactor().numberOfLevels() == n);
+            logTestEnd();
+        }
+
+        static void testLevelScheduledSolve(){
+            logTestStart("testLevelScheduledSolve");
+            unsigned nx = 60, ny = 50;
+            auto sequentialMatrix = _convectionDiffusion(nx, ny, 50, M_PI / 6, UpwindConvection, 1);
+            auto parallelMatrix = _convectionDiffusion(nx, ny, 50, M_PI / 6, UpwindConvection, 4);
+            for (bool threshold : {false, true}) {
+                shared_ptr<IncompleteLUPreconditioner<double>> sequential, parallel;
+                if (threshold) {
+                    sequential = make_shared<ThresholdIncompleteLUPreconditioner<double>>(1E-4, 20);
+                    parallel = make_shared<ThresholdIncompleteLUPreconditioner<double>>(1E-4, 20);
+                }
+                else {
+                    sequential = make_shared<IncompleteLUPreconditioner<double>>();
+                    parallel = make_shared<IncompleteLUPreconditioner<double>>();
+                    //The levels of the 5-point stencil are the anti-diagonals of the grid
+                    parallel->setup(parallelMatrix);
+                    assert(parallel->getLowerFactor().numberOfLevels() == nx + ny - 1);
+                    assert(parallel->getUpperFactor().numberOfLevels() == nx + ny - 1);
+                }
+                sequential->setup(sequentialMatrix);
+                parallel->setup(parallelMatrix);
+                NumericalVector<double> r(nx * ny), sequentialResult(nx * ny), parallelResult(nx * ny);
+                for (unsigned i = 0; i < r.size(); i++)
+                    r[i] = std::cos(0.3 * i);
+                sequential->apply(r, sequentialResult);
+                parallel->apply(r, parallelResult);
+                //Every row performs the same operations in the same order
+                assert(sequentialResult == parallelResult);
+            }
+            logTestEnd();
+        }
+
+        static void testThresholdIncompleteLUExactFactorization(){
+            logTestStart("testThresholdIncompleteLUExactFactorization");
+            unsigned n = 80;
+            auto matrix = _randomNonSymmetric(n, 0.08, 3, 4);
+            ThresholdIncompleteLUPreconditioner<double> ilut(0, n);
+            ilut.setup(matrix);
+            assert(_inverseError(ilut, *matrix) < 1E-10);
+
+            IncompleteLUPreconditioner<double> ilu;
+            ilu.setup(matrix);
+            assert(_inverseError(ilu, *matrix) > 1E-6);
+            logTestEnd();
+        }
+
+        static void testThresholdFillLimit(){
+            logTestStart("testThresholdFillLimit");
+            auto matrix = _convectionDiffusion(40, 40, 20, M_PI / 6, UpwindConvection, 1);
+            unsigned n = matrix->numberOfRows();
+            double previousError = 1E30;
+            for (unsigned fill : {2u, 5u, 10u, 20u}) {
+                ThresholdIncompleteLUPreconditioner<double> ilut(1E-6, fill);
+                ilut.setup(matrix);
+                assert(ilut.getLowerFactor().numberOfNonZeros() <= fill * n);
+                assert(ilut.getUpperFactor().numberOfNonZeros() <= (fill + 1) * n);
+                //More fill gives a better approximation of A^-1
+                double error = _inverseError(ilut, *matrix);
+                assert(error < previousError);
+                previousError = error;
+            }
+            logTestEnd();
+        }
+
+        static void testIncompleteLUPerformanceReport(){
+            logTestStart("testIncompleteLUPerformanceReport");
+            unsigned nx = 200, ny = 200;
+            unsigned threads = _reportThreads();
+            auto matrix = _convectionDiffusion(nx, ny, 200, M_PI / 6, UpwindConvection, threads);
+            auto sequentialMatrix = _convectionDiffusion(nx, ny, 200, M_PI / 6, UpwindConvection, 1);
+            cout << endl << "  Upwind convection-diffusion " << nx << "x" << ny << ", cell Peclet 0.5, "
+                 << threads << " threads" << endl;
+            vector<shared_ptr<Preconditioner<double>>> preconditioners = {
+                    make_shared<JacobiPreconditioner<double>>(),
+                    make_shared<IncompleteLUPreconditioner<double>>(),
+                    make_shared<ThresholdIncompleteLUPreconditioner<double>>(1E-3, 5),
+                    make_shared<ThresholdIncompleteLUPreconditioner<double>>(1E-4, 15)};
+            for (auto &preconditioner : preconditioners) {
+                double setupTime = _time([&] { preconditioner->setup(matrix); });
+                unsigned iterations = _richardsonIterations(*preconditioner, *matrix, 1E-8, 5000);
+                cout << "    " << preconditioner->getName() << " : setup " << setupTime << " ms, "
+                     << iterations << " Richardson iterations";
+                auto ilu = dynamic_pointer_cast<IncompleteLUPreconditioner<double>>(preconditioner);
+                if (ilu != nullptr) {
+                    NumericalVector<double> r(matrix->numberOfRows(), 1), z(matrix->numberOfRows());
+                    double parallelApply = _time([&] { for (unsigned i = 0; i < 20; i++) preconditioner->apply(r, z); }) / 20;
+                    preconditioner->setup(sequentialMatrix);
+                    double sequentialApply = _time([&] { for (unsigned i = 0; i < 20; i++) preconditioner->apply(r, z); }) / 20;
+                    cout << ", " << ilu->getLowerFactor().numberOfLevels() << " / " << ilu->getUpperFactor().numberOfLevels()
+                         << " levels, apply 1 / " << threads << " threads " << sequentialApply << " / " << parallelApply << " ms";
+                }
+                cout << endl;
+            }
+            logTestEnd();
+        }
+
+    private:
+
+        /**
+         * Returns ||M^-1 A x - x|| / ||x|| for a fixed x.
+         */
+        static double _inverseError(Preconditioner<double> &preconditioner, NumericalMatrix<double> &matrix){
+            unsigned n = matrix.numberOfRows();
+            NumericalVector<double> x(n), product(n), result(n);
+            for (unsigned i = 0; i < n; i++)
+                x[i] = std::sin(0.7 * i) + 0.5;
+            matrix.multiplyVector(x, product);
+            preconditioner.apply(product, result);
+            result.subtractIntoThis(x);
+            return std::sqrt(result.dotProduct(result) / x.dotProduct(x));
+        }
+
+        /**
+         * Preconditioned Richardson iteration x = x + M^-1 (b - A x) from x = 0 with b = 1.
+         */
+        static unsigned _richardsonIterations(Preconditioner<double> &preconditioner, NumericalMatrix<double> &matrix,
+                                              double tolerance, unsigned maxIterations){
+            unsigned n = matrix.numberOfRows();
+            NumericalVector<double> rhs(n, 1), x(n), residual(n), correction(n);
+            double rhsNorm = std::sqrt(rhs.dotProduct(rhs));
+            for (unsigned iteration = 0; iteration < maxIterations; iteration++) {
+                //r = b - A x
+                matrix.multiplyVector(x, residual);
+                residual.subtractIntoThis(rhs, -1, -1);
+                if (std::sqrt(residual.dotProduct(residual)) / rhsNorm < tolerance)
+                    return iteration;
+                preconditioner.apply(residual, correction);
+                x.addIntoThis(correction);
+            }
+            return maxIterations;
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_INCOMPLETELUPRECONDITIONERTEST_H
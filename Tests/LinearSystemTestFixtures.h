@@ -0,0 +1,204 @@
+//
+// Created by hal9000 on 10/25/23.
+//
+
+#ifndef UNTITLED_LINEARSYSTEMTESTFIXTURES_H
+#define UNTITLED_LINEARSYSTEMTESTFIXTURES_H
+
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <thread>
+#include "../LinearAlgebra/ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrix.h"
+#include "../PositioningInSpace/DirectionsPositions.h"
+
+namespace Tests {
+
+    /**
+    * @brief Model problems and checks shared by the linear solver tests. The tests derive from it to call the
+    * fixtures unqualified.
+    */
+    class LinearSystemTestFixtures {
+    protected:
+        /**
+        * 5-point (nz = 1) or 7-point stencil of the Laplacian with unit coefficients on a nx x ny x nz grid, lexicographic
+        * numbering with x fastest.
+        */
+        static shared_ptr<NumericalMatrix<double>> _laplacian(unsigned nx, unsigned ny, unsigned nz, unsigned availableThreads){
+            unsigned n = nx * ny * nz;
+            double diagonal = nz > 1 ? 6 : ny > 1 ? 4 : 2;
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, availableThreads);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned k = 0; k < nz; k++) {
+                for (unsigned j = 0; j < ny; j++) {
+                    for (unsigned i = 0; i < nx; i++) {
+                        unsigned row = (k * ny + j) * nx + i;
+                        matrix->setElement(row, row, diagonal);
+                        if (i > 0) matrix->setElement(row, row - 1, -1);
+                        if (i < nx - 1) matrix->setElement(row, row + 1, -1);
+                        if (j > 0) matrix->setElement(row, row - nx, -1);
+                        if (j < ny - 1) matrix->setElement(row, row + nx, -1);
+                        if (k > 0) matrix->setElement(row, row - nx * ny, -1);
+                        if (k < nz - 1) matrix->setElement(row, row + nx * ny, -1);
+                    }
+                }
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        /**
+        * 5-point stencil with constant couplings on a nx x ny grid, lexicographic numbering with x fastest.
+        */
+        static shared_ptr<NumericalMatrix<double>> _fivePointStencil(unsigned nx, unsigned ny, double diagonal, double west,
+                                                                     double east, double south, double north,
+                                                                     unsigned availableThreads){
+            unsigned n = nx * ny;
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, availableThreads);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned j = 0; j < ny; j++) {
+                for (unsigned i = 0; i < nx; i++) {
+                    unsigned row = j * nx + i;
+                    matrix->setElement(row, row, diagonal);
+                    if (i > 0) matrix->setElement(row, row - 1, west);
+                    if (i < nx - 1) matrix->setElement(row, row + 1, east);
+                    if (j > 0) matrix->setElement(row, row - nx, south);
+                    if (j < ny - 1) matrix->setElement(row, row + nx, north);
+                }
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        enum ConvectionScheme { UpwindConvection, CentralConvection };
+
+        /**
+        * -Δu + velocity (cos angle, sin angle)·∇u on the internal nodes of a nx x ny grid of the unit square with
+        * Dirichlet walls, h = 1 / (max(nx, ny) + 1), scaled by h². The upwind scheme assumes angles in [0, π/2] and
+        * gives an M-matrix; the central one is not an M-matrix for cell Peclet numbers above 2.
+        */
+        static shared_ptr<NumericalMatrix<double>> _convectionDiffusion(unsigned nx, unsigned ny, double velocity,
+                                                                        double angle, ConvectionScheme scheme,
+                                                                        unsigned availableThreads){
+            double h = 1.0 / (std::max(nx, ny) + 1);
+            double bx = velocity * std::cos(angle) * h, by = velocity * std::sin(angle) * h;
+            if (scheme == UpwindConvection)
+                return _fivePointStencil(nx, ny, 4 + bx + by, -1 - bx, -1, -1 - by, -1, availableThreads);
+            return _fivePointStencil(nx, ny, 4, -1 - 0.5 * bx, -1 + 0.5 * bx, -1 - 0.5 * by, -1 + 0.5 * by, availableThreads);
+        }
+
+        /**
+        * Random sparse n x n matrix with off-diagonal elements in [-0.5, 0.5) at the given density. The diagonal is
+        * the given value, or random in [1, 2) for 0.
+        */
+        static shared_ptr<NumericalMatrix<double>> _randomNonSymmetric(unsigned n, double density, unsigned seed,
+                                                                       double diagonal = 0){
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, 1);
+            std::mt19937 generator(seed);
+            std::uniform_real_distribution<double> distribution(0, 1);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned i = 0; i < n; i++) {
+                matrix->setElement(i, i, diagonal != 0 ? diagonal : 1 + distribution(generator));
+                for (unsigned j = 0; j < n; j++)
+                    if (j != i && distribution(generator) < density)
+                        matrix->setElement(i, j, distribution(generator) - 0.5);
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        /**
+        * 7-point diffusion stencil with coefficient 1 in the lower half of the layers (k < nz / 2) and contrast in the
+        * upper half, harmonic mean at the faces normal to z.
+        */
+        static shared_ptr<NumericalMatrix<double>> _layeredLaplacian(unsigned nx, unsigned ny, unsigned nz, double contrast,
+                                                                     unsigned availableThreads){
+            unsigned n = nx * ny * nz;
+            auto coefficient = [&](unsigned k) { return k >= nz / 2 ? contrast : 1.0; };
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, availableThreads);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned k = 0; k < nz; k++) {
+                for (unsigned j = 0; j < ny; j++) {
+                    for (unsigned i = 0; i < nx; i++) {
+                        unsigned row = (k * ny + j) * nx + i;
+                        double c = coefficient(k);
+                        //Harmonic mean of the coefficients at the faces normal to z
+                        double below = 2 * c * coefficient(k > 0 ? k - 1 : k) / (c + coefficient(k > 0 ? k - 1 : k));
+                        double above = 2 * c * coefficient(k + 1) / (c + coefficient(k + 1));
+                        matrix->setElement(row, row, 4 * c + below + above);
+                        if (i > 0) matrix->setElement(row, row - 1, -c);
+                        if (i < nx - 1) matrix->setElement(row, row + 1, -c);
+                        if (j > 0) matrix->setElement(row, row - nx, -c);
+                        if (j < ny - 1) matrix->setElement(row, row + nx, -c);
+                        if (k > 0) matrix->setElement(row, row - nx * ny, -below);
+                        if (k < nz - 1) matrix->setElement(row, row + nx * ny, -above);
+                    }
+                }
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        /**
+        * The unknowns per direction of a structured grid, in the order One, Two, Three.
+        */
+        static map<PositioningInSpace::Direction, unsigned> _unknowns(const vector<unsigned> &dimensions){
+            map<PositioningInSpace::Direction, unsigned> unknowns;
+            for (unsigned d = 0; d < dimensions.size(); d++)
+                unknowns[PositioningInSpace::unsignedToSpatialDirection[d]] = dimensions[d];
+            return unknowns;
+        }
+
+        static shared_ptr<NumericalVector<double>> _rhs(unsigned n){
+            auto rhs = make_shared<NumericalVector<double>>(n);
+            for (unsigned i = 0; i < n; i++)
+                (*rhs)[i] = 1.0 + std::sin(0.37 * i);
+            return rhs;
+        }
+
+        /**
+        * ||b - A x|| / ||b||, or ||b - A x|| for b = 0.
+        */
+        static double _relativeResidual(NumericalMatrix<double> &matrix, NumericalVector<double> &rhs, NumericalVector<double> &solution){
+            NumericalVector<double> residual(rhs.size());
+            matrix.multiplyVector(solution, residual);
+            residual.subtractIntoThis(rhs);
+            double rhsNorm = std::sqrt(rhs.dotProduct(rhs));
+            return std::sqrt(residual.dotProduct(residual)) / (rhsNorm > 0 ? rhsNorm : 1);
+        }
+
+        /**
+        * The reports grow their sizes until the next one is estimated to take longer than this.
+        */
+        static constexpr double _maximumReportSeconds = 2;
+
+        /**
+        * The threads of the reports, all the hardware threads or 1 if they are not known.
+        */
+        static unsigned _reportThreads(){
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        /**
+        * True if the next size, growth times the cost of the last one that took the given seconds, exceeds
+        * _maximumReportSeconds.
+        */
+        static bool _isLastReportSize(double seconds, double growth = 8){
+            return growth * seconds > _maximumReportSeconds;
+        }
+
+        /**
+        * Wall time of job() in ms.
+        */
+        template<typename Job>
+        static double _time(Job job){
+            auto start = std::chrono::high_resolution_clock::now();
+            job();
+            auto end = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration<double, std::milli>(end - start).count();
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_LINEARSYSTEMTESTFIXTURES_H
@@ -0,0 +1,157 @@
+//
+// Created by hal9000 on 10/24/23.
+//
+
+#ifndef UNTITLED_MERGEPATHSPMVTEST_H
+#define UNTITLED_MERGEPATHSPMVTEST_H
+
+#include <cassert>
+#include <random>
+#include "../LinearAlgebra/ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrixReordering/NumericalMatrixReordering.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class MergePathSpMVTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testImbalancedRowsProduct();
+            testMergePathPartitionBalance();
+            testCachedPartitionInvalidation();
+            testMergePathPerformanceReport();
+        }
+
+        static void testImbalancedRowsProduct(){
+            logTestStart("testImbalancedRowsProduct");
+            auto matrix = _imbalancedMatrix(3000, 20, 2500, 1);
+            NumericalVector<double> x(matrix->numberOfColumns()), serial(matrix->numberOfRows()), parallel(matrix->numberOfRows());
+            for (unsigned i = 0; i < x.size(); i++)
+                x[i] = static_cast<double>(i % 13) - 6.0;
+            matrix->multiplyVector(x, serial, 2, 0.5, 1);
+            for (unsigned threads : {2u, 3u, 7u, 16u, 64u}) {
+                matrix->multiplyVector(x, parallel, 2, 0.5, threads);
+                for (unsigned i = 0; i < serial.size(); i++)
+                    assert(abs(serial[i] - parallel[i]) < 1E-9 * (1 + abs(serial[i])));
+            }
+            logTestEnd();
+        }
+
+        static void testMergePathPartitionBalance(){
+            logTestStart("testMergePathPartitionBalance");
+            auto matrix = _imbalancedMatrix(2000, 10, 1500, 2);
+            CSRMathematicalOperationsProvider<double> math(matrix->numberOfRows(), matrix->numberOfColumns(), matrix->dataStorage);
+            auto &rowOffsets = *matrix->dataStorage->getSupplementaryVectors()[1];
+            unsigned threads = 8;
+            auto splits = math.mergePathPartition(threads);
+            assert(splits.size() == threads + 1);
+            assert(splits.front() == make_pair(0u, 0u));
+            assert(splits.back() == make_pair(2000u, rowOffsets[2000]));
+            unsigned long pathLength = 2000 + rowOffsets[2000];
+            for (unsigned p = 0; p < threads; p++) {
+                auto start = splits[p], end = splits[p + 1];
+                assert(start.first <= end.first && start.second <= end.second);
+                if (end.first < 2000)
+                    assert(rowOffsets[end.first] <= end.second && end.second <= rowOffsets[end.first + 1]);
+                unsigned long work = (end.first - start.first) + (end.second - start.second);
+                assert(work <= pathLength / threads + 1 && work + 1 >= pathLength / threads);
+            }
+            logTestEnd();
+        }
+
+        static void testCachedPartitionInvalidation(){
+            logTestStart("testCachedPartitionInvalidation");
+            auto matrix = _imbalancedMatrix(500, 4, 400, 3);
+            CSRMathematicalOperationsProvider<double> math(matrix->numberOfRows(), matrix->numberOfColumns(), matrix->dataStorage);
+            auto &first = math.mergePathPartition(4);
+            auto cached = first;
+            assert(&math.mergePathPartition(4) == &first && math.mergePathPartition(4) == cached);
+            //Inserting elements in the dense rows changes the number of non-zeros and invalidates the partition
+            for (unsigned column = 0; column < 500; column += 2)
+                matrix->setElement(0, column, 1);
+            auto &recomputed = math.mergePathPartition(4);
+            assert(recomputed.back().second == matrix->dataStorage->getSupplementaryVectors()[1]->getDataPointer()[500]);
+            NumericalVector<double> x(500, 1), serial(500), parallel(500);
+            matrix->multiplyVector(x, serial, 1, 1, 1);
+            matrix->multiplyVector(x, parallel, 1, 1, 4);
+            for (unsigned i = 0; i < 500; i++)
+                assert(abs(serial[i] - parallel[i]) < 1E-9 * (1 + abs(serial[i])));
+            logTestEnd();
+        }
+
+        static void testMergePathPerformanceReport(){
+            logTestStart("testMergePathPerformanceReport");
+            unsigned threads = _reportThreads();
+            auto matrix = _imbalancedMatrix(200000, 2000, 4000, 4);
+            auto &rowOffsets = *matrix->dataStorage->getSupplementaryVectors()[1];
+            cout << endl;
+            cout << "  200000 rows, 2000 rows with 4000 non-zeros, " << rowOffsets[200000] << " non-zeros" << endl;
+            cout << "  max / mean work of 16 threads  row blocks / merge path : "
+                 << _rowBlockImbalance(rowOffsets, 16) << " / " << _mergePathImbalance(*matrix, 16) << endl;
+            cout << "  SpMV time 1 / " << threads << " threads : " << NumericalMatrixReordering<double>::spmvTime(*matrix, 10, 1)
+                 << " μs / " << NumericalMatrixReordering<double>::spmvTime(*matrix, 10, threads) << " μs ";
+            logTestEnd();
+        }
+
+    private:
+
+        /**
+         * Tridiagonal-like rows of length 1 to 3, a few empty rows and numberOfDenseRows rows with denseRowLength
+         * random columns clustered at the beginning of the matrix, like Neumann rows or wide boundary stencils.
+         */
+        static shared_ptr<NumericalMatrix<double>> _imbalancedMatrix(unsigned n, unsigned numberOfDenseRows, unsigned denseRowLength,
+                                                                     unsigned seed){
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, 1);
+            std::mt19937 generator(seed);
+            std::uniform_int_distribution<unsigned> column(0, n - 1);
+            std::uniform_real_distribution<double> value(-1, 1);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned row = 0; row < n; row++) {
+                if (row % 97 == 5)
+                    continue;
+                if (row < numberOfDenseRows) {
+                    for (unsigned k = 0; k < denseRowLength; k++)
+                        matrix->addElement(row, column(generator), value(generator));
+                    continue;
+                }
+                matrix->addElement(row, row, 4);
+                if (row > 0) matrix->addElement(row, row - 1, value(generator));
+                if (row < n - 1 && row % 3 == 0) matrix->addElement(row, row + 1, value(generator));
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        static double _rowBlockImbalance(NumericalVector<unsigned> &rowOffsets, unsigned threads){
+            unsigned n = rowOffsets.size() - 1;
+            //Blocks of ThreadingOperations::executeParallelJob for doubles
+            unsigned blockSize = ((n + threads - 1) / threads + 7) / 8 * 8;
+            double maximum = 0;
+            for (unsigned start = 0; start < n; start += blockSize) {
+                unsigned end = std::min(n, start + blockSize);
+                maximum = std::max(maximum, static_cast<double>(end - start + rowOffsets[end] - rowOffsets[start]));
+            }
+            return maximum / ((n + rowOffsets[n]) / static_cast<double>(threads));
+        }
+
+        static double _mergePathImbalance(NumericalMatrix<double> &matrix, unsigned threads){
+            CSRMathematicalOperationsProvider<double> math(matrix.numberOfRows(), matrix.numberOfColumns(), matrix.dataStorage);
+            auto &splits = math.mergePathPartition(threads);
+            double maximum = 0;
+            for (unsigned p = 0; p < threads; p++)
+                maximum = std::max(maximum, static_cast<double>(splits[p + 1].first - splits[p].first +
+                                                                  splits[p + 1].second - splits[p].second));
+            return maximum / ((splits.back().first + splits.back().second) / static_cast<double>(threads));
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_MERGEPATHSPMVTEST_H
@@ -0,0 +1,221 @@
+//
+// Created by hal9000 on 11/7/23.
+//
+
+#ifndef UNTITLED_MIXEDPRECISIONLUTEST_H
+#define UNTITLED_MIXEDPRECISIONLUTEST_H
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include "../LinearAlgebra/Solvers/Direct/SolverLUP.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class MixedPrecisionLUTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testRefinementAccuracy();
+            testFallback();
+            testSolverLUP();
+            testMixedPrecisionReport();
+        }
+
+        static void testRefinementAccuracy(){
+            logTestStart("testRefinementAccuracy");
+            unsigned n = 301;
+            auto matrix = _matrix(n);
+            vector<double> exact(n), rhs(n), solution(n), reference(n);
+            for (unsigned i = 0; i < n; i++)
+                exact[i] = std::sin(0.1 * i) + 2;
+            _multiply(matrix, n, exact, rhs);
+            for (unsigned threads : {1u, 3u}) {
+                MixedPrecisionLU<float> solver(threads);
+                solver.factorize(matrix.data(), n, n);
+                solver.solve(rhs.data(), solution.data());
+                assert(!solver.usesFallback() && solver.getFallbackReason().empty());
+                //κ ε(float) << 1: a few steps to the double backward error
+                assert(solver.getRefinementSteps() >= 1 && solver.getRefinementSteps() <= 6);
+                assert(solver.getBackwardError() <= std::sqrt(n) * std::numeric_limits<double>::epsilon());
+                //The forward error of the double LU
+                _doubleSolve(matrix, n, rhs, reference);
+                double error = _maximumDifference(solution, exact), doubleError = _maximumDifference(reference, exact);
+                assert(error <= 10 * doubleError + 1E-14);
+            }
+            //A leading dimension larger than n
+            unsigned lda = n + 5;
+            vector<double> padded(static_cast<size_t>(n) * lda, 1E30);
+            for (unsigned i = 0; i < n; i++)
+                std::copy(matrix.begin() + i * n, matrix.begin() + (i + 1) * n, padded.begin() + i * lda);
+            MixedPrecisionLU<float> solver;
+            solver.factorize(padded.data(), n, lda);
+            solver.solve(rhs.data(), solution.data());
+            assert(!solver.usesFallback() && _maximumDifference(solution, exact) < 1E-11);
+            logTestEnd();
+        }
+
+        static void testFallback(){
+            logTestStart("testFallback");
+            //Hilbert matrix, κ ~ 1E13: the float factors do not contract the error
+            unsigned n = 10;
+            vector<double> hilbert(n * n), rhs(n, 1.0), solution(n), reference(n);
+            for (unsigned i = 0; i < n; i++)
+                for (unsigned j = 0; j < n; j++)
+                    hilbert[i * n + j] = 1.0 / (i + j + 1);
+            MixedPrecisionLU<float> solver;
+            solver.factorize(hilbert.data(), n, n);
+            assert(!solver.usesFallback());
+            solver.solve(rhs.data(), solution.data());
+            assert(solver.usesFallback() && solver.getFallbackReason().find("stalled") != string::npos);
+            //The fallback is the double LU
+            _doubleSolve(hilbert, n, rhs, reference);
+            assert(_maximumDifference(solution, reference) == 0);
+            assert(solver.getBackwardError() < 1E-14);
+            //and serves the next solves without refinement
+            solver.solve(rhs.data(), solution.data());
+            assert(solver.getRefinementSteps() == 0 && _maximumDifference(solution, reference) == 0);
+
+            //Entries out of the float range
+            vector<double> large = {1E300, 1, 1, 2E300}, largeRhs = {1E300, 2E300}, largeSolution(2);
+            MixedPrecisionLU<float> range;
+            range.factorize(large.data(), 2, 2);
+            assert(range.usesFallback() && range.getFallbackReason().find("range") != string::npos);
+            range.solve(largeRhs.data(), largeSolution.data());
+            assert(std::abs(largeSolution[0] - 1) < 1E-12 && std::abs(largeSolution[1] - 1) < 1E-12);
+
+            //A pivot lost in float (1 + 1E-9 rounds to 1) but not in double
+            vector<double> nearlySingular = {1, 1, 1, 1 + 1E-9}, nearlyRhs = {2, 2 + 1E-9}, nearlySolution(2);
+            MixedPrecisionLU<float> pivot;
+            pivot.factorize(nearlySingular.data(), 2, 2);
+            assert(pivot.usesFallback() && pivot.getFallbackReason().find("zero pivot") == 0);
+            pivot.solve(nearlyRhs.data(), nearlySolution.data());
+            assert(std::abs(nearlySolution[0] - 1) < 1E-6 && std::abs(nearlySolution[1] - 1) < 1E-6);
+
+            //Singular in double too
+            vector<double> singular = {1, 2, 2, 4};
+            bool thrown = false;
+            try { pivot.factorize(singular.data(), 2, 2); } catch (runtime_error &) { thrown = true; }
+            assert(thrown);
+            logTestEnd();
+        }
+
+        static void testSolverLUP(){
+            logTestStart("testSolverLUP");
+            unsigned n = 64;
+            auto values = _matrix(n);
+            auto matrix = make_shared<Array<double>>(n, n);
+            std::copy(values.begin(), values.end(), matrix->getArrayPointer());
+            vector<double> exact(n);
+            auto rhs = make_shared<vector<double>>(n);
+            for (unsigned i = 0; i < n; i++)
+                exact[i] = 1.0 / (i + 1);
+            _multiply(values, n, exact, *rhs);
+            SolverLUP solver(1E-12, true);
+            solver.setMixedPrecision(true);
+            solver.setAvailableThreads(2);
+            auto linearSystem = make_shared<LinearSystem>(matrix, rhs);
+            solver.setLinearSystem(linearSystem);
+            solver.solve();
+            assert(!solver.getMixedPrecisionSolver()->usesFallback());
+            assert(solver.getMixedPrecisionSolver()->getAvailableThreads() == 2);
+            assert(_maximumDifference(*linearSystem->solution, exact) < 1E-12);
+            //The matrix is kept for the residuals
+            assert(std::equal(values.begin(), values.end(), matrix->getArrayPointer()));
+            logTestEnd();
+        }
+
+        static void testMixedPrecisionReport(){
+            logTestStart("testMixedPrecisionReport");
+            unsigned threads = _reportThreads();
+            cout << endl << "  Dense pivoted LU, double against float factors with double refinement, " << threads
+                 << " threads, pseudo-random matrices. The sizes stop when the double solve took longer than "
+                 << _maximumReportSeconds << " s" << endl;
+            double previousSeconds = 0;
+            for (unsigned n = 256; n <= 4096; n *= 2) {
+                if (_isLastReportSize(previousSeconds)) {
+                    cout << "    n = " << n << " skipped (estimated " << 8 * previousSeconds << " s)" << endl;
+                    previousSeconds *= 8;
+                    continue;
+                }
+                auto matrix = _matrix(n);
+                vector<double> exact(n), rhs(n), solution(n), reference(n);
+                for (unsigned i = 0; i < n; i++)
+                    exact[i] = std::cos(0.01 * i);
+                _multiply(matrix, n, exact, rhs);
+
+                auto start = chrono::high_resolution_clock::now();
+                vector<double> lu(matrix);
+                vector<unsigned> permutation;
+                unsigned swaps;
+                BlockedLU<double>::factorize(lu.data(), n, n, permutation, swaps, 0, threads);
+                BlockedLU<double>::solve(lu.data(), n, n, permutation, rhs.data(), reference.data());
+                double doubleSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+                start = chrono::high_resolution_clock::now();
+                MixedPrecisionLU<float> solver(threads);
+                solver.factorize(matrix.data(), n, n);
+                solver.solve(rhs.data(), solution.data());
+                double mixedSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+                assert(!solver.usesFallback());
+                assert(solver.getBackwardError() <= std::sqrt(n) * std::numeric_limits<double>::epsilon());
+                double doubleError = _maximumDifference(reference, exact), mixedError = _maximumDifference(solution, exact);
+                cout << "    n = " << n << " : double " << doubleSeconds * 1000 << " ms, error " << doubleError
+                     << " | mixed " << mixedSeconds * 1000 << " ms (" << doubleSeconds / mixedSeconds << "x), "
+                     << solver.getRefinementSteps() << " refinement steps, error " << mixedError << ", backward error "
+                     << solver.getBackwardError() << endl;
+                previousSeconds = doubleSeconds;
+            }
+            logTestEnd();
+        }
+
+    private:
+        /**
+         * Dense non-symmetric matrix with pseudo-random elements in [-1, 1), so that partial pivoting is needed.
+         */
+        static vector<double> _matrix(unsigned n){
+            vector<double> matrix(static_cast<size_t>(n) * n);
+            unsigned long long state = 2023;
+            for (auto &value : matrix) {
+                state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+                value = 2 * static_cast<double>(state >> 11) / 9007199254740992.0 - 1;
+            }
+            return matrix;
+        }
+
+        static void _multiply(const vector<double> &matrix, unsigned n, const vector<double> &x, vector<double> &y){
+            for (unsigned i = 0; i < n; i++) {
+                double sum = 0;
+                for (unsigned j = 0; j < n; j++)
+                    sum += matrix[static_cast<size_t>(i) * n + j] * x[j];
+                y[i] = sum;
+            }
+        }
+
+        static void _doubleSolve(const vector<double> &matrix, unsigned n, const vector<double> &rhs, vector<double> &x){
+            vector<double> lu(matrix);
+            vector<unsigned> permutation;
+            unsigned swaps;
+            BlockedLU<double>::factorize(lu.data(), n, n, permutation, swaps);
+            BlockedLU<double>::solve(lu.data(), n, n, permutation, rhs.data(), x.data());
+        }
+
+        static double _maximumDifference(const vector<double> &x, const vector<double> &y){
+            double difference = 0;
+            for (unsigned i = 0; i < x.size(); i++)
+                difference = std::max(difference, std::abs(x[i] - y[i]));
+            return difference;
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_MIXEDPRECISIONLUTEST_H
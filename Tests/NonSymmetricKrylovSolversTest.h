@@ -0,0 +1,196 @@
+//
+// Created by hal9000 on 10/29/23.
+//
+
+#ifndef UNTITLED_NONSYMMETRICKRYLOVSOLVERSTEST_H
+#define UNTITLED_NONSYMMETRICKRYLOVSOLVERSTEST_H
+
+#include <cassert>
+#include <cmath>
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/GeneralizedMinimalResidual.h"
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/BiConjugateGradientStabilized.h"
+#include "../LinearAlgebra/Solvers/Preconditioners/IncompleteLUPreconditioner.h"
+#include "../LinearAlgebra/Solvers/Multigrid/SmoothedAggregationMultigrid.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class NonSymmetricKrylovSolversTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testFullGMRESTerminates();
+            testConvectionDiffusionConvergence();
+            testMatrixFreeOneSidedBoundary();
+            testNonConvergenceException();
+            testNonSymmetricSolversPerformanceReport();
+        }
+
+        static void testFullGMRESTerminates(){
+            logTestStart("testFullGMRESTerminates");
+            //Without restarts GMRES minimizes over the whole space after n steps
+            unsigned n = 40;
+            auto matrix = _randomNonSymmetric(n, 0.2, 7);
+            auto rhs = _rhs(n);
+            vector<list<double>> histories;
+            for (auto orthogonalization : {ModifiedGramSchmidtArnoldi, HouseholderArnoldi}) {
+                GeneralizedMinimalResidual<double> solver(1E-11, 1000, true, 1, n, orthogonalization);
+                NumericalVector<double> solution(n);
+                solver.solve(matrix, *rhs, solution);
+                assert(solver.hasConverged() && solver.getCycles() == 1);
+                assert(solver.getIterations() <= n);
+                assert(solver.getResidualNorms()->size() == solver.getIterations() + 1);
+                assert(_relativeResidual(*matrix, *rhs, solution) < 1E-10);
+                //The minimal residuals never increase
+                double previous = 1;
+                for (auto norm : *solver.getResidualNorms()) {
+                    assert(norm <= previous * (1 + 1E-12));
+                    previous = norm;
+                }
+                histories.push_back(*solver.getResidualNorms());
+            }
+            //Both orthogonalizations span the same subspaces
+            assert(histories[0].size() == histories[1].size());
+            for (auto mgs = histories[0].begin(), householder = histories[1].begin(); mgs != histories[0].end(); ++mgs, ++householder)
+                assert(std::abs(*mgs - *householder) < 1E-8);
+            logTestEnd();
+        }
+
+        static void testConvectionDiffusionConvergence(){
+            logTestStart("testConvectionDiffusionConvergence");
+            auto matrix = _convectionDiffusion(40, 40, 60, M_PI / 6, CentralConvection, 2);
+            auto rhs = _rhs(matrix->numberOfRows());
+            auto ilu = make_shared<IncompleteLUPreconditioner<double>>();
+            ilu->setup(matrix);
+            for (auto &solver : _solvers(1E-10, 2)) {
+                unsigned unpreconditionedIterations = 0;
+                for (auto &preconditioner : vector<shared_ptr<Preconditioner<double>>>{nullptr, ilu}) {
+                    solver->setPreconditioner(preconditioner);
+                    NumericalVector<double> solution(matrix->numberOfRows());
+                    solver->solve(matrix, *rhs, solution);
+                    assert(solver->hasConverged());
+                    assert(solver->getResidualNorms()->size() == solver->getIterations() + 1);
+                    assert(std::abs(solver->getExitNorm() - _relativeResidual(*matrix, *rhs, solution)) < 1E-11);
+                    assert(_relativeResidual(*matrix, *rhs, solution) < 1E-10);
+                    if (preconditioner == nullptr)
+                        unpreconditionedIterations = solver->getIterations();
+                    else
+                        assert(solver->getIterations() < unpreconditionedIterations / 2);
+                }
+            }
+            logTestEnd();
+        }
+
+        static void testMatrixFreeOneSidedBoundary(){
+            logTestStart("testMatrixFreeOneSidedBoundary");
+            //-u'' + c u' = f on (0, 1) with u(0) = 0 and the second order one-sided Neumann condition
+            //(3 u_n - 4 u_n-1 + u_n-2) / 2h = 0 at x = 1, applied without assembling a matrix
+            unsigned n = 200;
+            double h = 1.0 / n, c = 20;
+            FunctionLinearOperator<double> stencil(n, n, [&](NumericalVector<double> &x, NumericalVector<double> &y) {
+                for (unsigned i = 0; i < n - 1; i++) {
+                    double west = i > 0 ? x[i - 1] : 0;
+                    y[i] = (-west + 2 * x[i] - x[i + 1]) / (h * h) + c * (x[i + 1] - west) / (2 * h);
+                }
+                y[n - 1] = (3 * x[n - 1] - 4 * x[n - 2] + x[n - 3]) / (2 * h);
+            });
+            auto rhs = _rhs(n);
+            (*rhs)[n - 1] = 0;
+            //Restarts stagnate on this ill-conditioned 1D operator, so GMRES keeps the whole Krylov space
+            vector<shared_ptr<KrylovSolver<double>>> solvers = {
+                    make_shared<GeneralizedMinimalResidual<double>>(1E-9, 1E4, true, 1, n, ModifiedGramSchmidtArnoldi),
+                    make_shared<GeneralizedMinimalResidual<double>>(1E-9, 1E4, true, 1, n, HouseholderArnoldi),
+                    make_shared<BiConjugateGradientStabilized<double>>(1E-9, 1E4)};
+            for (auto &solver : solvers) {
+                NumericalVector<double> solution(n), check(n);
+                solver->solve(stencil, *rhs, solution);
+                assert(solver->hasConverged());
+                stencil.multiply(solution, check);
+                check.subtractIntoThis(*rhs);
+                //The recursive residual of BiCGStab drifts from the true residual on this ill-conditioned operator
+                assert(std::sqrt(check.dotProduct(check) / rhs->dotProduct(*rhs)) < 1E-8);
+            }
+            logTestEnd();
+        }
+
+        static void testNonConvergenceException(){
+            logTestStart("testNonConvergenceException");
+            auto matrix = _convectionDiffusion(30, 30, 60, M_PI / 6, CentralConvection, 1);
+            auto rhs = _rhs(matrix->numberOfRows());
+            for (auto &solver : _solvers(1E-14, 1)) {
+                solver->setMaxIterations(5);
+                bool exceptionThrown = false;
+                NumericalVector<double> solution(matrix->numberOfRows());
+                try {
+                    solver->solve(matrix, *rhs, solution);
+                }
+                catch (const runtime_error &) {
+                    exceptionThrown = true;
+                }
+                assert(exceptionThrown && !solver->hasConverged() && solver->getIterations() == 5);
+            }
+            GeneralizedMinimalResidual<double> quietSolver(1E-14, 12, false, 1, 5);
+            NumericalVector<double> solution(matrix->numberOfRows());
+            quietSolver.solve(matrix, *rhs, solution);
+            assert(!quietSolver.hasConverged() && quietSolver.getIterations() == 12 && quietSolver.getCycles() == 3);
+            assert(std::abs(quietSolver.getExitNorm() - _relativeResidual(*matrix, *rhs, solution)) < 1E-12);
+            logTestEnd();
+        }
+
+        static void testNonSymmetricSolversPerformanceReport(){
+            logTestStart("testNonSymmetricSolversPerformanceReport");
+            unsigned threads = _reportThreads();
+            unsigned nx = 120, ny = 120;
+            cout << endl;
+            for (double velocity : {30.0, 240.0}) {
+                auto matrix = _convectionDiffusion(nx, ny, velocity, M_PI / 6, CentralConvection, threads);
+                auto rhs = _rhs(matrix->numberOfRows());
+                cout << "  Central convection-diffusion " << nx << "x" << ny << ", cell Peclet " << velocity / (nx + 1)
+                     << " (" << threads << " threads)" << endl;
+                vector<shared_ptr<Preconditioner<double>>> preconditioners = {
+                        nullptr,
+                        make_shared<IncompleteLUPreconditioner<double>>(),
+                        make_shared<SmoothedAggregationMultigrid<double>>()};
+                for (auto &preconditioner : preconditioners) {
+                    double setupTime = 0;
+                    if (preconditioner != nullptr) {
+                        auto start = std::chrono::high_resolution_clock::now();
+                        preconditioner->setup(matrix);
+                        auto end = std::chrono::high_resolution_clock::now();
+                        setupTime = std::chrono::duration<double, std::milli>(end - start).count();
+                    }
+                    cout << "    " << (preconditioner == nullptr ? string("None") : preconditioner->getName())
+                         << ", setup " << setupTime << " ms" << endl;
+                    for (auto &solver : _solvers(1E-8, threads)) {
+                        solver->setPreconditioner(preconditioner);
+                        solver->setMaxIterations(3000);
+                        NumericalVector<double> solution(matrix->numberOfRows());
+                        solver->solve(matrix, *rhs, solution);
+                        cout << "      " << solver->getSolverName() << " : " << solver->getIterations() << " iterations, "
+                             << solver->getSolutionTime() << " ms" << endl;
+                    }
+                }
+            }
+            logTestEnd();
+        }
+
+    private:
+
+        static vector<shared_ptr<KrylovSolver<double>>> _solvers(double tolerance, unsigned threads){
+            return {make_shared<GeneralizedMinimalResidual<double>>(tolerance, 1E4, true, threads, 30, ModifiedGramSchmidtArnoldi),
+                    make_shared<GeneralizedMinimalResidual<double>>(tolerance, 1E4, true, threads, 30, HouseholderArnoldi),
+                    make_shared<GeneralizedMinimalResidual<double>>(tolerance, 1E4, true, threads, 10, ModifiedGramSchmidtArnoldi),
+                    make_shared<BiConjugateGradientStabilized<double>>(tolerance, 1E4, true, threads)};
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_NONSYMMETRICKRYLOVSOLVERSTEST_H
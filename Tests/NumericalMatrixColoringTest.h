@@ -0,0 +1,126 @@
+//
+// Created by hal9000 on 10/19/23.
+//
+
+#ifndef UNTITLED_NUMERICALMATRIXCOLORINGTEST_H
+#define UNTITLED_NUMERICALMATRIXCOLORINGTEST_H
+
+#include <cassert>
+#include "../LinearAlgebra/ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrixReordering/NumericalMatrixColoring.h"
+#include "../LinearAlgebra/Solvers/Iterative/StationaryIterative/GaussSeidelSolver.h"
+#include "../LinearAlgebra/Solvers/Iterative/StationaryIterative/SORSolver.h"
+
+namespace Tests {
+
+    class NumericalMatrixColoringTest {
+    public:
+        static void runTests(){
+            testRedBlackColoringOfFivePointStencil();
+            testGreedyColoringOfNinePointStencil();
+            testMultiColorGaussSeidel();
+            testMultiColorSOR();
+        }
+
+        static void testRedBlackColoringOfFivePointStencil(){
+            logTestStart("testRedBlackColoringOfFivePointStencil");
+            auto linearSystem = _poissonSystem2D(9, 7, false);
+            auto matrix = linearSystem->getCSRMatrix();
+            auto colorClasses = NumericalMatrixColoring<double>::colorClasses(*matrix);
+            assert(colorClasses.size() == 2);
+            assert(NumericalMatrixColoring<double>::isValidColoring(*matrix, colorClasses));
+            //Node (i, j) is red if i + j is even
+            for (auto &row : colorClasses[0])
+                assert((row % 9 + row / 9) % 2 == 0);
+            logTestEnd();
+        }
+
+        static void testGreedyColoringOfNinePointStencil(){
+            logTestStart("testGreedyColoringOfNinePointStencil");
+            auto linearSystem = _poissonSystem2D(9, 7, true);
+            auto matrix = linearSystem->getCSRMatrix();
+            assert(NumericalMatrixColoring<double>::redBlack(*matrix).empty());
+            auto colorClasses = NumericalMatrixColoring<double>::colorClasses(*matrix);
+            assert(NumericalMatrixColoring<double>::isValidColoring(*matrix, colorClasses));
+            //The 9-point stencil graph contains 4-cliques, so it needs at least 4 colors and at most maxDegree + 1
+            assert(colorClasses.size() >= 4 && colorClasses.size() <= 9);
+            logTestEnd();
+        }
+
+        static void testMultiColorGaussSeidel(){
+            logTestStart("testMultiColorGaussSeidel");
+            auto serialSystem = _poissonSystem2D(12, 10, true);
+            auto serialSolver = make_shared<GaussSeidelSolver>(L2, 1E-10, 1E4, true, SingleThread);
+            serialSolver->setLinearSystem(serialSystem);
+            serialSolver->solve();
+
+            auto multiColorSystem = _poissonSystem2D(12, 10, true);
+            auto multiColorSolver = make_shared<GaussSeidelSolver>(L2, 1E-10, 1E4, true, MultiThread);
+            multiColorSolver->setLinearSystem(multiColorSystem);
+            multiColorSolver->solve();
+
+            for (unsigned i = 0; i < serialSystem->rhs->size(); i++) {
+                assert(abs(serialSystem->solution->at(i) - _exactSolution(i)) < 1E-6);
+                assert(abs(multiColorSystem->solution->at(i) - _exactSolution(i)) < 1E-6);
+            }
+            logTestEnd();
+        }
+
+        static void testMultiColorSOR(){
+            logTestStart("testMultiColorSOR");
+            auto linearSystem = _poissonSystem2D(12, 10, false);
+            auto solver = make_shared<SORSolver>(1.5, L2, 1E-10, 1E4, true, MultiThread);
+            solver->setLinearSystem(linearSystem);
+            solver->solve();
+            for (unsigned i = 0; i < linearSystem->rhs->size(); i++)
+                assert(abs(linearSystem->solution->at(i) - _exactSolution(i)) < 1E-6);
+            logTestEnd();
+        }
+
+    private:
+
+        static double _exactSolution(unsigned i){
+            return 1.0 + static_cast<double>(i % 5) * 0.25;
+        }
+
+        /**
+         * Assembles the 5-point (or 9-point) Laplacian of a nx x ny grid in lexicographic order and a right hand side
+         * that corresponds to _exactSolution.
+         */
+        static shared_ptr<LinearSystem> _poissonSystem2D(unsigned nx, unsigned ny, bool ninePoint){
+            unsigned n = nx * ny;
+            auto matrix = make_shared<Array<double>>(n, n);
+            for (unsigned j = 0; j < ny; j++) {
+                for (unsigned i = 0; i < nx; i++) {
+                    unsigned row = j * nx + i;
+                    for (int dj = -1; dj <= 1; dj++) {
+                        for (int di = -1; di <= 1; di++) {
+                            int ni = static_cast<int>(i) + di, nj = static_cast<int>(j) + dj;
+                            if ((di == 0 && dj == 0) || ni < 0 || nj < 0 || ni >= static_cast<int>(nx) || nj >= static_cast<int>(ny))
+                                continue;
+                            if (di != 0 && dj != 0 && !ninePoint)
+                                continue;
+                            matrix->at(row, nj * nx + ni) = -1;
+                        }
+                    }
+                    matrix->at(row, row) = ninePoint ? 8 : 4;
+                }
+            }
+            auto rhs = make_shared<vector<double>>(n, 0);
+            for (unsigned row = 0; row < n; row++)
+                for (unsigned column = 0; column < n; column++)
+                    (*rhs)[row] += matrix->at(row, column) * _exactSolution(column);
+            return make_shared<LinearSystem>(matrix, rhs);
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_NUMERICALMATRIXCOLORINGTEST_H
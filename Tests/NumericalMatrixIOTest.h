@@ -0,0 +1,203 @@
+//
+// Created by hal9000 on 10/19/23.
+//
+
+#ifndef UNTITLED_NUMERICALMATRIXIOTEST_H
+#define UNTITLED_NUMERICALMATRIXIOTEST_H
+
+#include <cassert>
+#include <cstdio>
+#include "../LinearAlgebra/ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrixIO/NumericalMatrixIO.h"
+
+namespace Tests {
+
+    class NumericalMatrixIOTest {
+    public:
+        static void runTests(){
+            testMatrixMarketRoundTrip();
+            testMatrixMarketSymmetricRead();
+            testMemoryMappedBinaryCSR();
+            testCopiedBinaryCSR();
+            testCorruptedBinaryCSR();
+        }
+
+        static void testMatrixMarketRoundTrip(){
+            logTestStart("testMatrixMarketRoundTrip");
+            auto matrix = _testMatrix();
+            NumericalMatrixIO<double>::writeMatrixMarket(*matrix, "NumericalMatrixIOTest.mtx");
+            auto readMatrix = NumericalMatrixIO<double>::readMatrixMarket("NumericalMatrixIOTest.mtx", 2);
+            assert(readMatrix->dataStorage->getStorageType() == CSR);
+            assert(_equalElements(*matrix, *readMatrix));
+
+            NumericalVector<double> vector = {1.0 / 3.0, -2.5, 7, 0, 1E-12};
+            NumericalMatrixIO<double>::writeMatrixMarketVector(vector, "NumericalMatrixIOTest_rhs.mtx");
+            auto readVector = NumericalMatrixIO<double>::readMatrixMarketVector("NumericalMatrixIOTest_rhs.mtx");
+            assert(*readVector == vector);
+            std::remove("NumericalMatrixIOTest.mtx");
+            std::remove("NumericalMatrixIOTest_rhs.mtx");
+            logTestEnd();
+        }
+
+        static void testMatrixMarketSymmetricRead(){
+            logTestStart("testMatrixMarketSymmetricRead");
+            ofstream file("NumericalMatrixIOTest.mtx");
+            file << "%%MatrixMarket matrix coordinate real symmetric\n"
+                 << "% lower triangle of a 3x3 matrix, the (3,1) entry is split in two duplicates\n"
+                 << "3 3 5\n"
+                 << "1 1 4\n"
+                 << "2 1 -1\n"
+                 << "3 1 -0.5\n"
+                 << "3 1 -0.5\n"
+                 << "3 3 2\n";
+            file.close();
+            auto matrix = NumericalMatrixIO<double>::readMatrixMarket("NumericalMatrixIOTest.mtx");
+            assert(matrix->dataStorage->getFormType() == Symmetric);
+            assert(matrix->getElement(0, 0) == 4 && matrix->getElement(1, 0) == -1 && matrix->getElement(0, 1) == -1);
+            assert(matrix->getElement(2, 0) == -1 && matrix->getElement(0, 2) == -1 && matrix->getElement(2, 2) == 2);
+            assert(matrix->getElement(1, 1) == 0);
+            assert(matrix->dataStorage->getValues()->size() == 6);
+
+            //Symmetric matrices are written back as their lower triangle
+            NumericalMatrixIO<double>::writeMatrixMarket(*matrix, "NumericalMatrixIOTest.mtx");
+            auto readMatrix = NumericalMatrixIO<double>::readMatrixMarket("NumericalMatrixIOTest.mtx");
+            assert(_equalElements(*matrix, *readMatrix));
+            std::remove("NumericalMatrixIOTest.mtx");
+            logTestEnd();
+        }
+
+        static void testMemoryMappedBinaryCSR(){
+            logTestStart("testMemoryMappedBinaryCSR");
+            auto matrix = _testMatrix();
+            NumericalMatrixIO<double>::writeBinaryCSR(*matrix, "NumericalMatrixIOTest.csr");
+            {
+                auto mappedMatrix = NumericalMatrixIO<double>::readBinaryCSR("NumericalMatrixIOTest.csr", 2);
+                assert(_equalElements(*matrix, *mappedMatrix));
+
+                NumericalVector<double> x = {1, 2, 3, 4, 5};
+                NumericalVector<double> expected(5), result(5);
+                matrix->multiplyVector(x, expected);
+                mappedMatrix->multiplyVector(x, result);
+                assert(result == expected);
+
+                bool exceptionThrown = false;
+                try {
+                    mappedMatrix->setElement(0, 0, 1);
+                }
+                catch (const runtime_error &) {
+                    exceptionThrown = true;
+                }
+                assert(exceptionThrown);
+
+                //A write through the reference of a missing element does not leak into later reads
+                mappedMatrix->getElement(2, 2) = 1;
+                assert(mappedMatrix->getElement(2, 2) == 0 && mappedMatrix->getElement(0, 1) == 0);
+            }
+            std::remove("NumericalMatrixIOTest.csr");
+            logTestEnd();
+        }
+
+        static void testCopiedBinaryCSR(){
+            logTestStart("testCopiedBinaryCSR");
+            auto matrix = _testMatrix();
+            NumericalMatrixIO<double>::writeBinaryCSR(*matrix, "NumericalMatrixIOTest.csr");
+            auto readMatrix = NumericalMatrixIO<double>::readBinaryCSR("NumericalMatrixIOTest.csr", 1, false);
+            assert(_equalElements(*matrix, *readMatrix));
+            readMatrix->setElement(1, 1, 9);
+            assert(readMatrix->getElement(1, 1) == 9);
+            std::remove("NumericalMatrixIOTest.csr");
+            logTestEnd();
+        }
+
+        static void testCorruptedBinaryCSR(){
+            logTestStart("testCorruptedBinaryCSR");
+            auto matrix = _testMatrix();
+            NumericalMatrixIO<double>::writeBinaryCSR(*matrix, "NumericalMatrixIOTest.csr");
+            //Truncate the values array
+            ifstream inputFile("NumericalMatrixIOTest.csr", ios::binary);
+            string contents((istreambuf_iterator<char>(inputFile)), istreambuf_iterator<char>());
+            inputFile.close();
+            ofstream outputFile("NumericalMatrixIOTest.csr", ios::binary);
+            outputFile.write(contents.data(), static_cast<streamsize>(contents.size() - 8));
+            outputFile.close();
+            _assertReadFails("NumericalMatrixIOTest.csr");
+
+            //Complete files with a decreasing row offset or an out of range column index
+            vector<unsigned> rowOffsets = {0, 2, 4, 4, 6, 8}, columnIndices = {0, 2, 1, 4, 0, 3, 1, 4};
+            auto rowOffsetsPosition = contents.find(string(reinterpret_cast<char*>(rowOffsets.data()), rowOffsets.size() * sizeof(unsigned)));
+            auto columnIndicesPosition = contents.find(string(reinterpret_cast<char*>(columnIndices.data()), columnIndices.size() * sizeof(unsigned)));
+            assert(rowOffsetsPosition != string::npos && columnIndicesPosition != string::npos);
+            unsigned decreasingOffset = 5, outOfRangeColumn = 5;
+            for (auto corruption : {make_pair(rowOffsetsPosition + sizeof(unsigned), decreasingOffset),
+                                    make_pair(columnIndicesPosition + 3 * sizeof(unsigned), outOfRangeColumn)}) {
+                string corrupted = contents;
+                memcpy(&corrupted[corruption.first], &corruption.second, sizeof(unsigned));
+                outputFile.open("NumericalMatrixIOTest.csr", ios::binary);
+                outputFile.write(corrupted.data(), static_cast<streamsize>(corrupted.size()));
+                outputFile.close();
+                _assertReadFails("NumericalMatrixIOTest.csr");
+            }
+
+            //An aligned values position near 2^64, for which position + size wraps around to a small number
+            uint64_t wrappingPosition = numeric_limits<uint64_t>::max() - 63, valuesPositionOffset = 72;
+            string corrupted = contents;
+            memcpy(&corrupted[valuesPositionOffset], &wrappingPosition, sizeof(uint64_t));
+            outputFile.open("NumericalMatrixIOTest.csr", ios::binary);
+            outputFile.write(corrupted.data(), static_cast<streamsize>(corrupted.size()));
+            outputFile.close();
+            _assertReadFails("NumericalMatrixIOTest.csr");
+            std::remove("NumericalMatrixIOTest.csr");
+            logTestEnd();
+        }
+
+    private:
+
+        static void _assertReadFails(const string &filePath){
+            for (auto memoryMap : {true, false}) {
+                bool exceptionThrown = false;
+                try {
+                    NumericalMatrixIO<double>::readBinaryCSR(filePath, 1, memoryMap);
+                }
+                catch (const runtime_error &) {
+                    exceptionThrown = true;
+                }
+                assert(exceptionThrown);
+            }
+        }
+
+        static shared_ptr<NumericalMatrix<double>> _testMatrix(){
+            auto matrix = make_shared<NumericalMatrix<double>>(5, 5, CSR, General, 1);
+            matrix->dataStorage->initializeElementAssignment();
+            matrix->setElement(0, 0, 3);
+            matrix->setElement(0, 2, 1.0 / 3.0);
+            matrix->setElement(1, 1, 4);
+            matrix->setElement(1, 4, -2E-8);
+            matrix->setElement(3, 0, 1);
+            matrix->setElement(3, 3, 5);
+            matrix->setElement(4, 1, 6.02214076E23);
+            matrix->setElement(4, 4, 7);
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        static bool _equalElements(NumericalMatrix<double> &a, NumericalMatrix<double> &b){
+            if (a.numberOfRows() != b.numberOfRows() || a.numberOfColumns() != b.numberOfColumns())
+                return false;
+            for (unsigned i = 0; i < a.numberOfRows(); i++)
+                for (unsigned j = 0; j < a.numberOfColumns(); j++)
+                    if (a.getElement(i, j) != b.getElement(i, j))
+                        return false;
+            return true;
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_NUMERICALMATRIXIOTEST_H
@@ -0,0 +1,275 @@
+//
+// Created by hal9000 on 10/18/23.
+//
+
+#ifndef UNTITLED_NUMERICALMATRIXREORDERINGTEST_H
+#define UNTITLED_NUMERICALMATRIXREORDERINGTEST_H
+
+#include <random>
+#include <cassert>
+#include "../LinearAlgebra/ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrixReordering/NumericalMatrixReordering.h"
+#include "../StructuredMeshGeneration/MeshFactory.h"
+
+namespace Tests {
+
+    class NumericalMatrixReorderingTest {
+    public:
+        static void runTests(){
+            testReverseCuthillMcKeeReducesBandwidth();
+            testMortonOrderingReducesBandwidth();
+            testPermutedMatrixVectorMultiplication();
+            testSymmetricGraph();
+            testLinearSystemReordering();
+            testReorderedAnalysis();
+            testReorderingPerformanceReport();
+        }
+
+        static void testReverseCuthillMcKeeReducesBandwidth(){
+            logTestStart("testReverseCuthillMcKeeReducesBandwidth");
+            unsigned nx = 20, ny = 30;
+            auto numbering = _scrambledNumbering(nx * ny);
+            auto matrix = _laplacian2D(nx, ny, numbering, 1);
+
+            auto permutation = NumericalMatrixReordering<double>::reverseCuthillMcKee(*matrix);
+            assert(_isPermutation(permutation));
+            auto reorderedMatrix = NumericalMatrixReordering<double>::permute(*matrix, permutation);
+
+            //The RCM bandwidth of a grid graph is bounded by the number of nodes of its shortest grid line + 1
+            assert(NumericalMatrixReordering<double>::bandwidth(*reorderedMatrix) <= nx + 1);
+            assert(NumericalMatrixReordering<double>::bandwidth(*reorderedMatrix) < NumericalMatrixReordering<double>::bandwidth(*matrix));
+            logTestEnd();
+        }
+
+        static void testMortonOrderingReducesBandwidth(){
+            logTestStart("testMortonOrderingReducesBandwidth");
+            unsigned nx = 32, ny = 32;
+            auto numbering = _scrambledNumbering(nx * ny);
+            auto matrix = _laplacian2D(nx, ny, numbering, 1);
+
+            auto coordinates = vector<vector<double>>(nx * ny);
+            for (unsigned j = 0; j < ny; j++)
+                for (unsigned i = 0; i < nx; i++)
+                    coordinates[numbering[j * nx + i]] = {static_cast<double>(i), static_cast<double>(j)};
+
+            auto permutation = NumericalMatrixReordering<double>::morton(coordinates);
+            assert(_isPermutation(permutation));
+            //The first four points of the Z-curve form the lower left 2x2 cell of the grid
+            for (unsigned k = 0; k < 4; k++) {
+                assert(coordinates[permutation[k]][0] < 2 && coordinates[permutation[k]][1] < 2);
+            }
+            auto reorderedMatrix = NumericalMatrixReordering<double>::permute(*matrix, permutation);
+            assert(NumericalMatrixReordering<double>::bandwidth(*reorderedMatrix) < NumericalMatrixReordering<double>::bandwidth(*matrix));
+            logTestEnd();
+        }
+
+        static void testPermutedMatrixVectorMultiplication(){
+            logTestStart("testPermutedMatrixVectorMultiplication");
+            unsigned nx = 15, ny = 10;
+            unsigned n = nx * ny;
+            auto numbering = _scrambledNumbering(n);
+            auto matrix = _laplacian2D(nx, ny, numbering, 4);
+
+            auto permutation = NumericalMatrixReordering<double>::reverseCuthillMcKee(*matrix);
+            auto reorderedMatrix = NumericalMatrixReordering<double>::permute(*matrix, permutation, 4);
+
+            // (P A P^T) (P x) = P (A x)
+            NumericalVector<double> x(n), y(n), permutedX(n), permutedY(n), restoredY(n);
+            for (unsigned i = 0; i < n; i++)
+                x[i] = static_cast<double>(i % 7) - 3.0;
+            matrix->multiplyVector(x, y);
+            NumericalMatrixReordering<double>::permuteVector(x.getDataPointer(), permutedX.getDataPointer(), permutation);
+            reorderedMatrix->multiplyVector(permutedX, permutedY);
+            NumericalMatrixReordering<double>::inversePermuteVector(permutedY.getDataPointer(), restoredY.getDataPointer(), permutation);
+            assert(restoredY == y);
+
+            //Out of range and repeated indices are rejected
+            for (unsigned invalidIndex : {n, permutation[1]}) {
+                auto invalidPermutation = permutation;
+                invalidPermutation[0] = invalidIndex;
+                bool thrown = false;
+                try { NumericalMatrixReordering<double>::permute(*matrix, invalidPermutation); } catch (invalid_argument &) { thrown = true; }
+                assert(thrown);
+            }
+            NumericalMatrix<double> empty(0, 0, make_shared<CSRStorageDataProvider<double>>(
+                    make_shared<NumericalVector<double>>(0u), make_shared<NumericalVector<unsigned>>(0u),
+                    make_shared<NumericalVector<unsigned>>(1u, 0u), 0, 0, 1));
+            assert(NumericalMatrixReordering<double>::bandwidth(empty) == 0);
+            logTestEnd();
+        }
+
+        static void testSymmetricGraph(){
+            logTestStart("testSymmetricGraph");
+            //a_01, a_10 and a_12 off the diagonal: 0 - 1 is structurally symmetric, 1 - 2 is not
+            auto matrix = make_shared<NumericalMatrix<double>>(3, 3, CSR, General, 1);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned i = 0; i < 3; i++)
+                matrix->setElement(i, i, 4);
+            matrix->setElement(0, 1, -1);
+            matrix->setElement(1, 0, -1);
+            matrix->setElement(1, 2, -1);
+            matrix->dataStorage->finalizeElementAssignment();
+
+            auto graph = NumericalMatrixReordering<double>::symmetricGraph(*matrix);
+            assert(graph.numberOfNodes == 3 && (graph.offsets == vector<unsigned>{0, 1, 3, 4}));
+            assert((graph.neighbours == vector<unsigned>{1, 0, 2, 1}));
+            //The symmetric pair is kept twice without the deduplication
+            auto duplicated = NumericalMatrixReordering<double>::symmetricGraph(*matrix, false);
+            assert((duplicated.offsets == vector<unsigned>{0, 2, 5, 6}) && duplicated.degree(1) == 3);
+            vector<unsigned> neighboursOfOne(duplicated.neighbours.begin() + 2, duplicated.neighbours.begin() + 5);
+            std::sort(neighboursOfOne.begin(), neighboursOfOne.end());
+            assert((neighboursOfOne == vector<unsigned>{0, 0, 2}));
+            logTestEnd();
+        }
+
+        static void testLinearSystemReordering(){
+            logTestStart("testLinearSystemReordering");
+            //Tridiagonal [-1, 2 + i, -1] with b = 10 i and x = i
+            unsigned n = 5;
+            auto matrix = make_shared<Array<double>>(n, n);
+            auto rhs = make_shared<vector<double>>(n);
+            for (unsigned i = 0; i < n; i++) {
+                matrix->at(i, i) = 2 + i;
+                if (i > 0) matrix->at(i, i - 1) = -1;
+                if (i < n - 1) matrix->at(i, i + 1) = -1;
+                (*rhs)[i] = 10 * i;
+            }
+            LinearSystem linearSystem(matrix, rhs);
+            linearSystem.solution = make_shared<vector<double>>(n);
+            for (unsigned i = 0; i < n; i++)
+                (*linearSystem.solution)[i] = i;
+
+            //Out of range and repeated indices are rejected and leave the system untouched
+            for (auto invalidPermutation : {vector<unsigned>{0, 1, 2, 3, 5}, vector<unsigned>{0, 1, 2, 3, 3}, vector<unsigned>{0, 1, 2}}) {
+                bool thrown = false;
+                try { linearSystem.reorder(invalidPermutation); } catch (invalid_argument &) { thrown = true; }
+                assert(thrown && linearSystem.permutation == nullptr && (*rhs)[4] == 40 && (*linearSystem.solution)[4] == 4);
+            }
+
+            //Two successive permutations compose, and each entry keeps the unknown of the original numbering
+            linearSystem.reorder({4, 3, 2, 1, 0});
+            linearSystem.reorder({1, 3, 0, 4, 2});
+            auto &permutation = *linearSystem.permutation;
+            assert((permutation == vector<unsigned>{3, 1, 4, 0, 2}));
+            for (unsigned i = 0; i < n; i++) {
+                assert((*rhs)[i] == 10 * permutation[i] && (*linearSystem.solution)[i] == permutation[i]);
+                for (unsigned j = 0; j < n; j++) {
+                    double original = permutation[i] == permutation[j] ? 2.0 + permutation[i] :
+                                      permutation[i] + 1 == permutation[j] || permutation[j] + 1 == permutation[i] ? -1 : 0;
+                    assert(matrix->at(i, j) == original);
+                }
+            }
+            logTestEnd();
+        }
+
+        static void testReorderedAnalysis(){
+            logTestStart("testReorderedAnalysis");
+            //Steady heat conduction solved in the original numbering, then after RCM followed by Morton
+            map<Direction, unsigned> nodesPerDirection = {{One, 7}, {Two, 6}};
+            vector<double> temperatures[2];
+            for (auto isReordered : {false, true}) {
+                auto specs = make_shared<MeshSpecs>(nodesPerDirection, 1, 1, 0, 0, 0);
+                //Kept alive like the other mesh builders: ~Mesh2D deletes the nodes twice
+                auto meshFactory = new MeshFactory(specs);
+                auto boundaries = make_shared<DomainBoundaryFactory>(meshFactory->mesh);
+                meshFactory->buildMesh(2, boundaries->parallelogram(nodesPerDirection, 6, 5));
+                auto mesh = meshFactory->mesh;
+
+                auto boundaryConditions = make_shared<map<Position, shared_ptr<BoundaryCondition>>>();
+                double wallTemperatures[4] = {100, 20, 0, 50};
+                Position walls[4] = {Position::Left, Position::Right, Position::Top, Position::Bottom};
+                for (unsigned wall = 0; wall < 4; wall++)
+                    boundaryConditions->insert({walls[wall], make_shared<BoundaryCondition>(Dirichlet, shared_ptr<map<DOFType, double>>(
+                            new map<DOFType, double>({{Temperature, wallTemperatures[wall]}})))});
+                auto pdeProperties = make_shared<SecondOrderLinearPDEProperties>(2, false, Isotropic);
+                pdeProperties->setIsotropicProperties(1, 0, 0, 0);
+                auto pde = make_shared<PartialDifferentialEquation>(pdeProperties, Laplace);
+                auto problem = make_shared<SteadyStateMathematicalProblem>(
+                        pde, make_shared<DomainBoundaryConditions>(boundaryConditions), new TemperatureScalar_DOFType());
+                auto solver = make_shared<AutomaticSolver>(1E-12, 1E4, false);
+                auto analysis = make_shared<SteadyStateFiniteDifferenceAnalysis>(
+                        problem, mesh, solver, make_shared<FDSchemeSpecs>(2, 2, mesh->directions()));
+                if (isReordered) {
+                    analysis->reorderLinearSystem(ReverseCuthillMcKee, false);
+                    analysis->reorderLinearSystem(Morton, false);
+                    assert(analysis->linearSystem->permutation != nullptr);
+                }
+                analysis->solve();
+                analysis->applySolutionToDegreesOfFreedom();
+                for (auto &node : *mesh->totalNodesVector)
+                    temperatures[isReordered].push_back(node->degreesOfFreedom->front()->value());
+            }
+            assert(temperatures[0].size() == 42 && temperatures[1].size() == temperatures[0].size());
+            for (unsigned i = 0; i < temperatures[0].size(); i++)
+                assert(std::abs(temperatures[0][i] - temperatures[1][i]) < 1E-8);
+            logTestEnd();
+        }
+
+        static void testReorderingPerformanceReport(){
+            logTestStart("testReorderingPerformanceReport");
+            unsigned nx = 200, ny = 200;
+            auto numbering = _scrambledNumbering(nx * ny);
+            auto matrix = _laplacian2D(nx, ny, numbering, 1);
+            auto rcm = NumericalMatrixReordering<double>::permute(
+                    *matrix, NumericalMatrixReordering<double>::reverseCuthillMcKee(*matrix));
+            cout << endl;
+            cout << "  Bandwidth scrambled / RCM : " << NumericalMatrixReordering<double>::bandwidth(*matrix) << " / "
+                 << NumericalMatrixReordering<double>::bandwidth(*rcm) << endl;
+            cout << "  SpMV time scrambled / RCM : " << NumericalMatrixReordering<double>::spmvTime(*matrix, 20) << " μs / "
+                 << NumericalMatrixReordering<double>::spmvTime(*rcm, 20) << " μs ";
+            logTestEnd();
+        }
+
+    private:
+
+        /**
+         * Assembles the 5-point Laplacian of a nx x ny grid. Node (i, j) is stored in row numbering[j * nx + i].
+         */
+        static shared_ptr<NumericalMatrix<double>> _laplacian2D(unsigned nx, unsigned ny, const vector<unsigned> &numbering,
+                                                                unsigned availableThreads){
+            unsigned n = nx * ny;
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, availableThreads);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned j = 0; j < ny; j++) {
+                for (unsigned i = 0; i < nx; i++) {
+                    unsigned row = numbering[j * nx + i];
+                    matrix->setElement(row, row, 4);
+                    if (i > 0) matrix->setElement(row, numbering[j * nx + i - 1], -1);
+                    if (i < nx - 1) matrix->setElement(row, numbering[j * nx + i + 1], -1);
+                    if (j > 0) matrix->setElement(row, numbering[(j - 1) * nx + i], -1);
+                    if (j < ny - 1) matrix->setElement(row, numbering[(j + 1) * nx + i], -1);
+                }
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        static vector<unsigned> _scrambledNumbering(unsigned n){
+            vector<unsigned> numbering(n);
+            for (unsigned i = 0; i < n; i++)
+                numbering[i] = i;
+            std::shuffle(numbering.begin(), numbering.end(), std::mt19937(42));
+            return numbering;
+        }
+
+        static bool _isPermutation(const vector<unsigned> &permutation){
+            vector<bool> found(permutation.size(), false);
+            for (auto &index : permutation) {
+                if (index >= permutation.size() || found[index])
+                    return false;
+                found[index] = true;
+            }
+            return true;
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_NUMERICALMATRIXREORDERINGTEST_H
@@ -0,0 +1,177 @@
+//
+// Created by hal9000 on 10/21/23.
+//
+
+#ifndef UNTITLED_NUMERICALMATRIXSPARSEPRODUCTSTEST_H
+#define UNTITLED_NUMERICALMATRIXSPARSEPRODUCTSTEST_H
+
+#include <cassert>
+#include <random>
+#include <chrono>
+#include "../LinearAlgebra/ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrixSparseProducts/NumericalMatrixSparseProducts.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class NumericalMatrixSparseProductsTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testSparseMatrixMultiplication();
+            testSparseMatrixTranspose();
+            testGalerkinProduct();
+            testSparseProductsPerformanceReport();
+        }
+
+        static void testSparseMatrixMultiplication(){
+            logTestStart("testSparseMatrixMultiplication");
+            auto A = _randomSparse(30, 20, 0.15, 1);
+            auto B = _randomSparse(20, 25, 0.2, 2);
+            auto C = NumericalMatrixSparseProducts<double>::multiply(*A, *B, 3);
+            assert(C->numberOfRows() == 30 && C->numberOfColumns() == 25);
+            for (unsigned i = 0; i < 30; i++) {
+                for (unsigned j = 0; j < 25; j++) {
+                    double expected = 0;
+                    for (unsigned k = 0; k < 20; k++)
+                        expected += A->getElement(i, k) * B->getElement(k, j);
+                    assert(abs(C->getElement(i, j) - expected) < 1E-12);
+                }
+            }
+            assert(_columnsSorted(*C));
+            logTestEnd();
+        }
+
+        static void testSparseMatrixTranspose(){
+            logTestStart("testSparseMatrixTranspose");
+            auto A = _randomSparse(17, 40, 0.1, 3);
+            auto transpose = NumericalMatrixSparseProducts<double>::transpose(*A);
+            assert(transpose->numberOfRows() == 40 && transpose->numberOfColumns() == 17);
+            for (unsigned i = 0; i < 17; i++)
+                for (unsigned j = 0; j < 40; j++)
+                    assert(transpose->getElement(j, i) == A->getElement(i, j));
+            assert(_columnsSorted(*transpose));
+            logTestEnd();
+        }
+
+        static void testGalerkinProduct(){
+            logTestStart("testGalerkinProduct");
+            auto A = _laplacian(16, 16, 1, 2);
+            auto tentative = _aggregationProlongator(16, 16, 2);
+            auto P = _smoothedProlongator(*A, *tentative, 2);
+
+            auto fused = NumericalMatrixSparseProducts<double>::galerkinProduct(*P, *A, *P, 4);
+            auto AP = NumericalMatrixSparseProducts<double>::multiply(*A, *P);
+            auto PT = NumericalMatrixSparseProducts<double>::transpose(*P);
+            auto twoStep = NumericalMatrixSparseProducts<double>::multiply(*PT, *AP);
+
+            assert(fused->numberOfRows() == 64 && fused->numberOfColumns() == 64);
+            for (unsigned i = 0; i < 64; i++) {
+                for (unsigned j = 0; j < 64; j++) {
+                    assert(abs(fused->getElement(i, j) - twoStep->getElement(i, j)) < 1E-12);
+                    //Galerkin operators of symmetric matrices are symmetric
+                    assert(abs(fused->getElement(i, j) - fused->getElement(j, i)) < 1E-12);
+                }
+            }
+            logTestEnd();
+        }
+
+        static void testSparseProductsPerformanceReport(){
+            logTestStart("testSparseProductsPerformanceReport");
+            unsigned nx = 300, ny = 300;
+            unsigned threads = _reportThreads();
+            auto A = _laplacian(nx, ny, 1, 1);
+            auto tentative = _aggregationProlongator(nx, ny, 1);
+            auto P = _smoothedProlongator(*A, *tentative, 1);
+            cout << endl;
+            cout << "  A (" << nx * ny << " rows), P smoothed aggregation (" << P->numberOfColumns() << " columns), "
+                 << threads << " threads" << endl;
+            cout << "  A * A                 1 / " << threads << " threads : "
+                 << _time([&] { NumericalMatrixSparseProducts<double>::multiply(*A, *A, 1); }) << " / "
+                 << _time([&] { NumericalMatrixSparseProducts<double>::multiply(*A, *A, threads); }) << " ms" << endl;
+            cout << "  P^T A P tentative     1 / " << threads << " threads : "
+                 << _time([&] { NumericalMatrixSparseProducts<double>::galerkinProduct(*tentative, *A, *tentative, 1); }) << " / "
+                 << _time([&] { NumericalMatrixSparseProducts<double>::galerkinProduct(*tentative, *A, *tentative, threads); }) << " ms" << endl;
+            cout << "  P^T A P smoothed fused / two products          : "
+                 << _time([&] { NumericalMatrixSparseProducts<double>::galerkinProduct(*P, *A, *P, threads); }) << " / "
+                 << _time([&] {
+                        auto AP = NumericalMatrixSparseProducts<double>::multiply(*A, *P, threads);
+                        auto PT = NumericalMatrixSparseProducts<double>::transpose(*P, threads);
+                        NumericalMatrixSparseProducts<double>::multiply(*PT, *AP, threads);
+                    }) << " ms ";
+            logTestEnd();
+        }
+
+    private:
+
+        static shared_ptr<NumericalMatrix<double>> _randomSparse(unsigned rows, unsigned columns, double density, unsigned seed){
+            auto matrix = make_shared<NumericalMatrix<double>>(rows, columns, CSR, General, 1);
+            std::mt19937 generator(seed);
+            std::uniform_real_distribution<double> distribution(0, 1);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned i = 0; i < rows; i++)
+                for (unsigned j = 0; j < columns; j++)
+                    if (distribution(generator) < density)
+                        matrix->setElement(i, j, distribution(generator) - 0.5);
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        /**
+         * Piecewise constant prolongator of 2x2 node aggregates.
+         */
+        static shared_ptr<NumericalMatrix<double>> _aggregationProlongator(unsigned nx, unsigned ny, unsigned availableThreads){
+            unsigned ncx = (nx + 1) / 2, ncy = (ny + 1) / 2;
+            auto prolongator = make_shared<NumericalMatrix<double>>(nx * ny, ncx * ncy, CSR, General, availableThreads);
+            prolongator->dataStorage->initializeElementAssignment();
+            for (unsigned j = 0; j < ny; j++)
+                for (unsigned i = 0; i < nx; i++)
+                    prolongator->setElement(j * nx + i, (j / 2) * ncx + i / 2, 1);
+            prolongator->dataStorage->finalizeElementAssignment();
+            return prolongator;
+        }
+
+        /**
+         * P = (I - 2/3 D^-1 A) P_tentative
+         */
+        static shared_ptr<NumericalMatrix<double>> _smoothedProlongator(NumericalMatrix<double> &A, NumericalMatrix<double> &tentative,
+                                                                        unsigned availableThreads){
+            unsigned n = A.numberOfRows();
+            NumericalMatrix<double> smoother(n, n, CSR, General, availableThreads);
+            smoother.dataStorage->initializeElementAssignment();
+            auto supplementaryVectors = A.dataStorage->getSupplementaryVectors();
+            auto &columnIndices = *supplementaryVectors[0];
+            auto &rowOffsets = *supplementaryVectors[1];
+            auto &values = *A.dataStorage->getValues();
+            for (unsigned row = 0; row < n; row++) {
+                double diagonal = A.getElement(row, row);
+                for (unsigned k = rowOffsets[row]; k < rowOffsets[row + 1]; k++) {
+                    unsigned column = columnIndices[k];
+                    smoother.setElement(row, column, (column == row ? 1.0 : 0.0) - 2.0 / 3.0 * values[k] / diagonal);
+                }
+            }
+            smoother.dataStorage->finalizeElementAssignment();
+            return NumericalMatrixSparseProducts<double>::multiply(smoother, tentative, availableThreads);
+        }
+
+        static bool _columnsSorted(NumericalMatrix<double> &matrix){
+            auto supplementaryVectors = matrix.dataStorage->getSupplementaryVectors();
+            auto &columnIndices = *supplementaryVectors[0];
+            auto &rowOffsets = *supplementaryVectors[1];
+            for (unsigned row = 0; row < matrix.numberOfRows(); row++)
+                for (unsigned k = rowOffsets[row] + 1; k < rowOffsets[row + 1]; k++)
+                    if (columnIndices[k - 1] >= columnIndices[k])
+                        return false;
+            return true;
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_NUMERICALMATRIXSPARSEPRODUCTSTEST_H
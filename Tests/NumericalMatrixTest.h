@@ -20,6 +20,8 @@ namespace Tests {
             testMatrixSubtraction();
             testMatrixMultiplication();
             testMatrixVectorMultiplication();
+            testCSRMatrixVectorMultiplication();
+            testRectangularCSRMatrixVectorMultiplication();
             testMatrixVectorRowWisePartialMultiplication();
             testMatrixVectorColumnWisePartialMultiplication();
             testMatrixAdditionMultiThread();
@@ -149,6 +151,76 @@ namespace Tests {
             logTestEnd();
         }
 
+        static void testCSRMatrixVectorMultiplication() {
+            logTestStart("testCSRMatrixVectorMultiplication");
+
+            // matrix = [3 0 0 0 0;
+            //           0 0 0 7 0;
+            //           0 0 0 0 0;
+            //           0 4 0 0 0;
+            //           0 0 0 2 5]
+            NumericalMatrix<double> matrixCSR = NumericalMatrix<double>(5, 5, CSR, General, 2);
+            matrixCSR.dataStorage->initializeElementAssignment();
+            matrixCSR.setElement(0, 0, 3);
+            matrixCSR.setElement(1, 3, 7);
+            matrixCSR.setElement(3, 1, 4);
+            matrixCSR.setElement(4, 3, 2);
+            matrixCSR.setElement(4, 4, 5);
+            matrixCSR.dataStorage->finalizeElementAssignment();
+
+            NumericalVector<double> vector = {1, 2, 3, 4, 5};
+            NumericalVector<double> resultVector = NumericalVector<double>(5);
+
+            matrixCSR.multiplyVector(vector, resultVector);
+
+            NumericalVector<double> expectedValues = {3, 28, 0, 8, 33};
+            assert(expectedValues == resultVector);
+
+            logTestEnd();
+        }
+
+        static void testRectangularCSRMatrixVectorMultiplication() {
+            logTestStart("testRectangularCSRMatrixVectorMultiplication");
+
+            // matrix = [3 0 0 1 0;
+            //           0 0 0 7 0;
+            //           0 4 0 0 2]
+            NumericalMatrix<double> matrixCSR = NumericalMatrix<double>(3, 5, CSR, General, 2);
+            matrixCSR.dataStorage->initializeElementAssignment();
+            matrixCSR.setElement(0, 0, 3);
+            matrixCSR.setElement(0, 3, 1);
+            matrixCSR.setElement(1, 3, 7);
+            matrixCSR.setElement(2, 1, 4);
+            matrixCSR.setElement(2, 4, 2);
+            matrixCSR.dataStorage->finalizeElementAssignment();
+
+            NumericalVector<double> vector = {1, 2, 3, 4, 5};
+            NumericalVector<double> resultVector = NumericalVector<double>(3);
+            matrixCSR.multiplyVector(vector, resultVector);
+            NumericalVector<double> expectedValues = {7, 28, 18};
+            assert(expectedValues == resultVector);
+
+            //The input vector has the size of the columns and the result vector the size of the rows
+            NumericalVector<double> shortVector = {1, 2, 3};
+            NumericalVector<double> longResult = NumericalVector<double>(5);
+            bool shortInputThrown = false, longResultThrown = false;
+            try {
+                matrixCSR.multiplyVector(shortVector, resultVector);
+            }
+            catch (const invalid_argument &) {
+                shortInputThrown = true;
+            }
+            try {
+                matrixCSR.multiplyVector(vector, longResult);
+            }
+            catch (const invalid_argument &) {
+                longResultThrown = true;
+            }
+            assert(shortInputThrown && longResultThrown);
+
+            logTestEnd();
+        }
+
         static void testMatrixVectorRowWisePartialMultiplication() {
             logTestStart("testMatrixVectorRowWisePartialMultiplication");
 
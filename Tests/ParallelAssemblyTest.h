@@ -0,0 +1,163 @@
+//
+// Created by hal9000 on 10/22/23.
+//
+
+#ifndef UNTITLED_PARALLELASSEMBLYTEST_H
+#define UNTITLED_PARALLELASSEMBLYTEST_H
+
+#include <cassert>
+#include "../LinearAlgebra/ContiguousMemoryNumericalArrays/NumericalMatrix/NumericalMatrix.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class ParallelAssemblyTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testConcurrentEdgeAssembly();
+            testInsertedAndAddedElements();
+            testAddElementAfterAssignment();
+            testParallelAssemblyPerformanceReport();
+        }
+
+        static void testConcurrentEdgeAssembly(){
+            logTestStart("testConcurrentEdgeAssembly");
+            auto serial = _insertedLaplacian(23, 17, 1);
+            auto concurrent = _edgeAssembledLaplacian(23, 17, 4);
+            auto supplementarySerial = serial->dataStorage->getSupplementaryVectors();
+            auto supplementaryConcurrent = concurrent->dataStorage->getSupplementaryVectors();
+            //The edge contributions are integers, so the summation order does not change the result
+            assert(*serial->dataStorage->getValues() == *concurrent->dataStorage->getValues());
+            assert(*supplementarySerial[0] == *supplementaryConcurrent[0]);
+            assert(*supplementarySerial[1] == *supplementaryConcurrent[1]);
+            logTestEnd();
+        }
+
+        static void testInsertedAndAddedElements(){
+            logTestStart("testInsertedAndAddedElements");
+            NumericalMatrix<double> matrix(6, 6, CSR, General, 2);
+            matrix.dataStorage->initializeElementAssignment();
+            matrix.setElement(0, 0, 1);
+            matrix.setElement(2, 3, 5);
+            matrix.dataStorage->eraseElement(2, 3);
+            auto addJob = [&](unsigned start, unsigned end){
+                for (unsigned i = start; i < end; i++) {
+                    matrix.addElement(0, 0, 0.5);
+                    matrix.addElement(5 - i % 6, i % 6, 1);
+                }
+            };
+            ThreadingOperations<double>::executeParallelJob(addJob, 48, 3);
+            matrix.dataStorage->finalizeElementAssignment();
+            assert(matrix.getElement(0, 0) == 1 + 48 * 0.5);
+            assert(matrix.getElement(2, 3) == 8);
+            assert(matrix.getElement(3, 3) == 0);
+            assert(matrix.dataStorage->getValues()->size() == 7);
+            logTestEnd();
+        }
+
+        static void testAddElementAfterAssignment(){
+            logTestStart("testAddElementAfterAssignment");
+            auto matrix = _edgeAssembledLaplacian(4, 4, 2);
+            matrix->addElement(5, 5, 1);
+            matrix->addElement(0, 15, -2);
+            assert(matrix->getElement(5, 5) == 5);
+            assert(matrix->getElement(0, 15) == -2);
+            logTestEnd();
+        }
+
+        static void testParallelAssemblyPerformanceReport(){
+            logTestStart("testParallelAssemblyPerformanceReport");
+            unsigned nx = 50, ny = 50, nz = 50;
+            unsigned threads = _reportThreads();
+            cout << endl;
+            cout << "  3D 7-point " << nx << "x" << ny << "x" << nz << " (" << nx * ny * nz << " rows)" << endl;
+            cout << "  map setElement                  : " << _time([&] { _sevenPointAssembly(nx, ny, nz, 1, false); }) << " ms" << endl;
+            cout << "  thread buffers addElement 1 / " << threads << " : "
+                 << _time([&] { _sevenPointAssembly(nx, ny, nz, 1, true); }) << " / "
+                 << _time([&] { _sevenPointAssembly(nx, ny, nz, threads, true); }) << " ms ";
+            logTestEnd();
+        }
+
+    private:
+
+        /**
+         * Graph Laplacian of a nx x ny grid with the degree of each node inserted on the diagonal.
+         */
+        static shared_ptr<NumericalMatrix<double>> _insertedLaplacian(unsigned nx, unsigned ny, unsigned availableThreads){
+            auto matrix = make_shared<NumericalMatrix<double>>(nx * ny, nx * ny, CSR, General, availableThreads);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned j = 0; j < ny; j++) {
+                for (unsigned i = 0; i < nx; i++) {
+                    unsigned row = j * nx + i;
+                    double degree = 0;
+                    if (i > 0) { matrix->setElement(row, row - 1, -1); degree++; }
+                    if (i < nx - 1) { matrix->setElement(row, row + 1, -1); degree++; }
+                    if (j > 0) { matrix->setElement(row, row - nx, -1); degree++; }
+                    if (j < ny - 1) { matrix->setElement(row, row + nx, -1); degree++; }
+                    matrix->setElement(row, row, degree);
+                }
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        /**
+         * The same Laplacian assembled concurrently from the 2x2 stiffness matrices of the grid edges.
+         */
+        static shared_ptr<NumericalMatrix<double>> _edgeAssembledLaplacian(unsigned nx, unsigned ny, unsigned availableThreads){
+            auto matrix = make_shared<NumericalMatrix<double>>(nx * ny, nx * ny, CSR, General, availableThreads);
+            matrix->dataStorage->initializeElementAssignment();
+            auto addEdge = [&](unsigned a, unsigned b){
+                matrix->addElement(a, a, 1);
+                matrix->addElement(b, b, 1);
+                matrix->addElement(a, b, -1);
+                matrix->addElement(b, a, -1);
+            };
+            auto assemblyJob = [&](unsigned start, unsigned end){
+                for (unsigned node = start; node < end; node++) {
+                    unsigned i = node % nx, j = node / nx;
+                    if (i < nx - 1) addEdge(node, node + 1);
+                    if (j < ny - 1) addEdge(node, node + nx);
+                }
+            };
+            ThreadingOperations<double>::executeParallelJob(assemblyJob, nx * ny, availableThreads);
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        static void _sevenPointAssembly(unsigned nx, unsigned ny, unsigned nz, unsigned availableThreads, bool threadBuffers){
+            unsigned n = nx * ny * nz;
+            NumericalMatrix<double> matrix(n, n, CSR, General, availableThreads);
+            matrix.dataStorage->initializeElementAssignment();
+            auto assemblyJob = [&](unsigned start, unsigned end){
+                for (unsigned row = start; row < end; row++) {
+                    unsigned i = row % nx, j = (row / nx) % ny, k = row / (nx * ny);
+                    auto assign = [&](unsigned column, double value){
+                        if (threadBuffers) matrix.addElement(row, column, value);
+                        else matrix.setElement(row, column, value);
+                    };
+                    assign(row, 6);
+                    if (i > 0) assign(row - 1, -1);
+                    if (i < nx - 1) assign(row + 1, -1);
+                    if (j > 0) assign(row - nx, -1);
+                    if (j < ny - 1) assign(row + nx, -1);
+                    if (k > 0) assign(row - nx * ny, -1);
+                    if (k < nz - 1) assign(row + nx * ny, -1);
+                }
+            };
+            ThreadingOperations<double>::executeParallelJob(assemblyJob, n, threadBuffers ? availableThreads : 1);
+            matrix.dataStorage->finalizeElementAssignment();
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_PARALLELASSEMBLYTEST_H
@@ -0,0 +1,201 @@
+//
+// Created by hal9000 on 10/30/23.
+//
+
+#ifndef UNTITLED_PIPELINEDCONJUGATEGRADIENTTEST_H
+#define UNTITLED_PIPELINEDCONJUGATEGRADIENTTEST_H
+
+#include <cassert>
+#include <cmath>
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/PipelinedConjugateGradient.h"
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/PreconditionedConjugateGradient.h"
+#include "../LinearAlgebra/Solvers/Preconditioners/IncompleteCholeskyPreconditioner.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class PipelinedConjugateGradientTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testPipelinedMatchesConjugateGradient();
+            testPreconditionedAndMatrixFreePipelines();
+            testStepsPerReduction();
+            testIndefiniteOperatorException();
+            testPipelinedScalingReport();
+        }
+
+        static void testPipelinedMatchesConjugateGradient(){
+            logTestStart("testPipelinedMatchesConjugateGradient");
+            auto matrix = _layeredLaplacian(20, 20, 20, 1, 1);
+            auto rhs = _rhs(matrix->numberOfRows());
+            PreconditionedConjugateGradient<double> reference(1E-9, 1000);
+            NumericalVector<double> referenceSolution(matrix->numberOfRows());
+            reference.solve(matrix, *rhs, referenceSolution);
+            for (unsigned threads : {1u, 3u}) {
+                PipelinedConjugateGradient<double> solver(1E-9, 1000, true, threads);
+                NumericalVector<double> solution(matrix->numberOfRows());
+                solver.solve(matrix, *rhs, solution);
+                assert(solver.hasConverged());
+                //Same Krylov iterates in exact arithmetic
+                assert(solver.getIterations() >= reference.getIterations() - 1 &&
+                       solver.getIterations() <= reference.getIterations() + 2);
+                assert(solver.getResidualNorms()->size() == solver.getIterations() + 1);
+                assert(_relativeResidual(*matrix, *rhs, solution) < 1E-8);
+                //One barrier per iteration on the persistent team
+                assert(solver.getSynchronizations() == (threads > 1 ? solver.getIterations() : 0));
+            }
+            logTestEnd();
+        }
+
+        static void testPreconditionedAndMatrixFreePipelines(){
+            logTestStart("testPreconditionedAndMatrixFreePipelines");
+            //Strongly varying coefficients, where the Jacobi and IC(0) preconditioners pay off
+            auto matrix = _layeredLaplacian(16, 16, 16, 100, 2);
+            unsigned n = matrix->numberOfRows();
+            auto rhs = _rhs(n);
+            PipelinedConjugateGradient<double> unpreconditioned(1E-9, 2000, true, 2);
+            NumericalVector<double> solution(n);
+            unpreconditioned.solve(matrix, *rhs, solution);
+
+            auto jacobi = make_shared<JacobiPreconditioner<double>>();
+            jacobi->setup(matrix);
+            auto incompleteCholesky = make_shared<IncompleteCholeskyPreconditioner<double>>();
+            incompleteCholesky->setup(matrix);
+            for (auto preconditioner : vector<shared_ptr<Preconditioner<double>>>{jacobi, incompleteCholesky}) {
+                PipelinedConjugateGradient<double> solver(1E-9, 2000, true, 2);
+                solver.setPreconditioner(preconditioner);
+                NumericalVector<double> preconditionedSolution(n);
+                solver.solve(matrix, *rhs, preconditionedSolution);
+                assert(solver.hasConverged());
+                assert(solver.getIterations() < unpreconditioned.getIterations());
+                assert(_relativeResidual(*matrix, *rhs, preconditionedSolution) < 1E-8);
+            }
+
+            //Matrix-free operators run the fork/join pipeline
+            FunctionLinearOperator<double> stencil(n, n, [&](NumericalVector<double> &x, NumericalVector<double> &y) {
+                matrix->multiplyVector(x, y);
+            });
+            PipelinedConjugateGradient<double> matrixFree(1E-9, 2000, true, 2);
+            NumericalVector<double> matrixFreeSolution(n);
+            matrixFree.solve(stencil, *rhs, matrixFreeSolution);
+            assert(matrixFree.getIterations() == unpreconditioned.getIterations());
+            assert(matrixFree.getSynchronizations() == 3 * matrixFree.getIterations());
+            assert(_relativeResidual(*matrix, *rhs, matrixFreeSolution) < 1E-8);
+            logTestEnd();
+        }
+
+        static void testStepsPerReduction(){
+            logTestStart("testStepsPerReduction");
+            auto matrix = _layeredLaplacian(20, 20, 20, 1, 2);
+            auto rhs = _rhs(matrix->numberOfRows());
+            PreconditionedConjugateGradient<double> reference(1E-8, 1000, true, 2);
+            NumericalVector<double> referenceSolution(matrix->numberOfRows());
+            reference.solve(matrix, *rhs, referenceSolution);
+            for (unsigned s : {2u, 4u}) {
+                PipelinedConjugateGradient<double> solver(1E-8, 1000, true, 2, s);
+                NumericalVector<double> solution(matrix->numberOfRows());
+                solver.solve(matrix, *rhs, solution);
+                assert(solver.hasConverged());
+                assert(solver.getIterations() % s == 0);
+                assert(solver.getIterations() <= reference.getIterations() + 2 * s);
+                assert(_relativeResidual(*matrix, *rhs, solution) < 1E-7);
+                //s SpMVs and one reduction per s iterations
+                assert(solver.getSynchronizations() < 3 * solver.getIterations());
+            }
+            bool exceptionThrown = false;
+            PipelinedConjugateGradient<double> preconditioned(1E-8, 1000, true, 1, 4);
+            preconditioned.setPreconditioner(make_shared<JacobiPreconditioner<double>>());
+            try {
+                NumericalVector<double> solution(matrix->numberOfRows());
+                preconditioned.solve(matrix, *rhs, solution);
+            }
+            catch (const exception &) {
+                exceptionThrown = true;
+            }
+            assert(exceptionThrown);
+            logTestEnd();
+        }
+
+        static void testIndefiniteOperatorException(){
+            logTestStart("testIndefiniteOperatorException");
+            auto matrix = _layeredLaplacian(8, 8, 8, 1, 1);
+            unsigned n = matrix->numberOfRows();
+            //-A through the persistent team and through the fork/join pipeline
+            auto csr = matrix->dataStorage->getSupplementaryDataPointers();
+            auto values = make_shared<NumericalVector<double>>(csr[1][n]);
+            auto columnIndices = make_shared<NumericalVector<unsigned>>(csr[1][n]);
+            auto rowOffsets = make_shared<NumericalVector<unsigned>>(n + 1);
+            for (unsigned k = 0; k < csr[1][n]; k++) {
+                (*values)[k] = -matrix->dataStorage->getValuesDataPointer()[k];
+                (*columnIndices)[k] = csr[0][k];
+            }
+            for (unsigned row = 0; row <= n; row++)
+                (*rowOffsets)[row] = csr[1][row];
+            auto negative = make_shared<NumericalMatrix<double>>(n, n, make_shared<CSRStorageDataProvider<double>>(
+                    values, columnIndices, rowOffsets, n, n, 2));
+            FunctionLinearOperator<double> negativeFunction(n, n, [&](NumericalVector<double> &x, NumericalVector<double> &y) {
+                negative->multiplyVector(x, y);
+            });
+            auto rhs = _rhs(n);
+            for (unsigned threads : {1u, 2u}) {
+                PipelinedConjugateGradient<double> solver(1E-9, 100, true, threads);
+                for (unsigned path = 0; path < 2; path++) {
+                    bool exceptionThrown = false;
+                    NumericalVector<double> solution(n);
+                    try {
+                        if (path == 0)
+                            solver.solve(negative, *rhs, solution);
+                        else
+                            solver.solve(negativeFunction, *rhs, solution);
+                    }
+                    catch (const runtime_error &) {
+                        exceptionThrown = true;
+                    }
+                    assert(exceptionThrown);
+                }
+            }
+            logTestEnd();
+        }
+
+        static void testPipelinedScalingReport(){
+            logTestStart("testPipelinedScalingReport");
+            unsigned nx = 48;
+            auto matrix = _layeredLaplacian(nx, nx, nx, 1, 1);
+            auto rhs = _rhs(matrix->numberOfRows());
+            unsigned hardwareThreads = _reportThreads();
+            cout << endl << "  3D Laplacian " << nx << "^3 (" << matrix->numberOfRows() << " unknowns) to 1E-8, threads 1 - 64"
+                 << " up to the " << hardwareThreads << " hardware threads" << endl;
+            for (unsigned threads = 1; threads <= 64 && threads <= hardwareThreads; threads *= 2) {
+                vector<shared_ptr<KrylovSolver<double>>> solvers = {
+                        make_shared<PreconditionedConjugateGradient<double>>(1E-8, 5000, true, threads),
+                        make_shared<PipelinedConjugateGradient<double>>(1E-8, 5000, true, threads, 1),
+                        make_shared<PipelinedConjugateGradient<double>>(1E-8, 5000, true, threads, 4)};
+                cout << "    " << threads << " threads" << endl;
+                for (auto &solver : solvers) {
+                    NumericalVector<double> solution(matrix->numberOfRows());
+                    solver->solve(matrix, *rhs, solution);
+                    cout << "      " << solver->getSolverName() << " : " << solver->getIterations() << " iterations, "
+                         << solver->getSolutionTime() << " ms";
+                    auto pipelined = dynamic_pointer_cast<PipelinedConjugateGradient<double>>(solver);
+                    if (pipelined != nullptr)
+                        cout << ", " << pipelined->getSynchronizations() << " synchronizations";
+                    cout << ", true residual " << _relativeResidual(*matrix, *rhs, solution) << endl;
+                }
+            }
+            logTestEnd();
+        }
+
+    private:
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_PIPELINEDCONJUGATEGRADIENTTEST_H
@@ -0,0 +1,268 @@
+//
+// Created by hal9000 on 10/25/23.
+//
+
+#ifndef UNTITLED_PRECONDITIONEDCONJUGATEGRADIENTTEST_H
+#define UNTITLED_PRECONDITIONEDCONJUGATEGRADIENTTEST_H
+
+#include <cassert>
+#include <cmath>
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/PreconditionedConjugateGradient.h"
+#include "../LinearAlgebra/Solvers/Preconditioners/JacobiPreconditioner.h"
+#include "../LinearAlgebra/Solvers/Preconditioners/BlockJacobiPreconditioner.h"
+#include "../LinearAlgebra/Solvers/Preconditioners/SSORPreconditioner.h"
+#include "../LinearAlgebra/Solvers/Preconditioners/IncompleteCholeskyPreconditioner.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class PreconditionedConjugateGradientTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testPreconditionersConvergence();
+            testMatrixFreeOperator();
+            testIncompleteCholeskyExactForTridiagonal();
+            testNonConvergenceException();
+            testPreconditionersPerformanceReport();
+        }
+
+        static void testPreconditionersConvergence(){
+            logTestStart("testPreconditionersConvergence");
+            auto matrix = _stretchedBoundaryLayer(20, 20, 1.2, 2);
+            auto rhs = _rhs(matrix->numberOfRows());
+            unsigned unpreconditionedIterations = 0;
+            for (auto &preconditioner : _preconditioners()) {
+                PreconditionedConjugateGradient<double> solver(1E-10, 1000, true, 2);
+                if (preconditioner != nullptr) {
+                    preconditioner->setup(matrix);
+                    solver.setPreconditioner(preconditioner);
+                }
+                NumericalVector<double> solution(matrix->numberOfRows());
+                solver.solve(matrix, *rhs, solution);
+                assert(solver.hasConverged());
+                assert(solver.getResidualNorms()->size() == solver.getIterations() + 1);
+                assert(_relativeResidual(*matrix, *rhs, solution) < 1E-9);
+                if (preconditioner == nullptr)
+                    unpreconditionedIterations = solver.getIterations();
+                else if (preconditioner->getName() != "Jacobi")
+                    assert(solver.getIterations() < unpreconditionedIterations);
+            }
+            logTestEnd();
+        }
+
+        static void testMatrixFreeOperator(){
+            logTestStart("testMatrixFreeOperator");
+            //-u'' on 200 nodes with a variable coefficient, applied without assembling a matrix
+            unsigned n = 200;
+            auto coefficient = [](unsigned i) { return 1.0 + 0.5 * std::sin(0.1 * i); };
+            FunctionLinearOperator<double> stencil(n, n, [&](NumericalVector<double> &x, NumericalVector<double> &y) {
+                for (unsigned i = 0; i < n; i++) {
+                    double west = coefficient(i), east = coefficient(i + 1);
+                    y[i] = (west + east) * x[i];
+                    if (i > 0) y[i] -= west * x[i - 1];
+                    if (i < n - 1) y[i] -= east * x[i + 1];
+                }
+            });
+            NumericalVector<double> diagonal(n);
+            for (unsigned i = 0; i < n; i++)
+                diagonal[i] = coefficient(i) + coefficient(i + 1);
+            auto jacobi = make_shared<JacobiPreconditioner<double>>();
+            jacobi->setup(diagonal);
+
+            auto rhs = _rhs(n);
+            NumericalVector<double> solution(n), check(n);
+            PreconditionedConjugateGradient<double> solver(1E-10, 1000);
+            solver.setPreconditioner(jacobi);
+            solver.solve(stencil, *rhs, solution);
+            assert(solver.hasConverged());
+            //Exact arithmetic converges in at most n iterations
+            assert(solver.getIterations() <= n);
+            stencil.multiply(solution, check);
+            check.subtractIntoThis(*rhs);
+            assert(std::sqrt(check.dotProduct(check)) / std::sqrt(rhs->dotProduct(*rhs)) < 1E-9);
+            logTestEnd();
+        }
+
+        static void testIncompleteCholeskyExactForTridiagonal(){
+            logTestStart("testIncompleteCholeskyExactForTridiagonal");
+            //The Cholesky factor of a tridiagonal matrix has no fill-in, so IC(0) is the exact factorization
+            unsigned n = 500;
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, 1);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned i = 0; i < n; i++) {
+                matrix->setElement(i, i, 2.0 + 1.0 / (i + 1));
+                if (i > 0) matrix->setElement(i, i - 1, -1);
+                if (i < n - 1) matrix->setElement(i, i + 1, -1);
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            auto incompleteCholesky = make_shared<IncompleteCholeskyPreconditioner<double>>();
+            incompleteCholesky->setup(matrix);
+            assert(incompleteCholesky->getDiagonalShift() == 0);
+
+            auto rhs = _rhs(n);
+            NumericalVector<double> solution(n);
+            PreconditionedConjugateGradient<double> solver(1E-10, 100);
+            solver.setPreconditioner(incompleteCholesky);
+            solver.solve(matrix, *rhs, solution);
+            assert(solver.getIterations() <= 2);
+            assert(_relativeResidual(*matrix, *rhs, solution) < 1E-10);
+            logTestEnd();
+        }
+
+        static void testNonConvergenceException(){
+            logTestStart("testNonConvergenceException");
+            auto matrix = _stretchedBoundaryLayer(30, 30, 1.1, 1);
+            auto rhs = _rhs(matrix->numberOfRows());
+            NumericalVector<double> solution(matrix->numberOfRows());
+            PreconditionedConjugateGradient<double> quietSolver(1E-12, 5, false);
+            quietSolver.solve(matrix, *rhs, solution);
+            assert(!quietSolver.hasConverged() && quietSolver.getIterations() == 5);
+
+            bool exceptionThrown = false;
+            PreconditionedConjugateGradient<double> solver(1E-12, 5, true);
+            try {
+                solver.solve(matrix, *rhs, solution);
+            }
+            catch (const runtime_error &) {
+                exceptionThrown = true;
+            }
+            assert(exceptionThrown);
+
+            exceptionThrown = false;
+            solver.setPreconditioner(make_shared<SSORPreconditioner<double>>());
+            try {
+                solver.solve(matrix, *rhs, solution);
+            }
+            catch (const runtime_error &) {
+                exceptionThrown = true;
+            }
+            assert(exceptionThrown);
+            logTestEnd();
+        }
+
+        static void testPreconditionersPerformanceReport(){
+            logTestStart("testPreconditionersPerformanceReport");
+            unsigned threads = _reportThreads();
+            cout << endl;
+            _report("Half annulus, polar FV 160x160, radial stretching 1.02", _halfAnnulus(160, 160, 1.02, threads), threads);
+            _report("Boundary layer, FV 160x160, wall stretching 1.05", _stretchedBoundaryLayer(160, 160, 1.05, threads), threads);
+            logTestEnd();
+        }
+
+    private:
+
+        static vector<shared_ptr<Preconditioner<double>>> _preconditioners(){
+            return {nullptr,
+                    make_shared<JacobiPreconditioner<double>>(),
+                    make_shared<BlockJacobiPreconditioner<double>>(4),
+                    make_shared<SSORPreconditioner<double>>(1.5),
+                    make_shared<IncompleteCholeskyPreconditioner<double>>()};
+        }
+
+        static void _report(const string &name, const shared_ptr<NumericalMatrix<double>> &matrix, unsigned threads){
+            auto rhs = _rhs(matrix->numberOfRows());
+            cout << "  " << name << " (" << matrix->numberOfRows() << " unknowns, " << threads << " threads)" << endl;
+            for (auto &preconditioner : _preconditioners()) {
+                PreconditionedConjugateGradient<double> solver(1E-8, 20000, true, threads);
+                auto start = std::chrono::high_resolution_clock::now();
+                if (preconditioner != nullptr) {
+                    preconditioner->setup(matrix);
+                    solver.setPreconditioner(preconditioner);
+                }
+                auto end = std::chrono::high_resolution_clock::now();
+                double setupTime = std::chrono::duration<double, std::milli>(end - start).count();
+                NumericalVector<double> solution(matrix->numberOfRows());
+                solver.solve(matrix, *rhs, solution);
+                cout << "    " << (preconditioner == nullptr ? string("None") : preconditioner->getName())
+                     << " : " << solver.getIterations() << " iterations, setup " << setupTime << " ms, solve "
+                     << solver.getSolutionTime() << " ms" << endl;
+            }
+        }
+
+        /**
+         * Finite volume Laplacian of the half annulus 0.5 < r < 1, 0 < θ < π with Dirichlet boundaries. The radial
+         * spacing grows geometrically from the inner radius, so the cells become elongated in θ near r = 0.5.
+         */
+        static shared_ptr<NumericalMatrix<double>> _halfAnnulus(unsigned nr, unsigned nTheta, double stretching, unsigned availableThreads){
+            auto radii = _stretchedNodes(0.5, 1.0, nr + 1, stretching);
+            double dTheta = M_PI / (nTheta + 1);
+            unsigned n = nr * nTheta;
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, availableThreads);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned j = 0; j < nTheta; j++) {
+                for (unsigned i = 0; i < nr; i++) {
+                    //Interior node i has radius radii[i + 1]
+                    double r = radii[i + 1];
+                    double rWest = 0.5 * (radii[i] + r), rEast = 0.5 * (r + radii[i + 2]);
+                    double west = rWest * dTheta / (r - radii[i]);
+                    double east = rEast * dTheta / (radii[i + 2] - r);
+                    double angular = (rEast - rWest) / (r * dTheta);
+                    unsigned row = j * nr + i;
+                    matrix->setElement(row, row, west + east + 2 * angular);
+                    if (i > 0) matrix->setElement(row, row - 1, -west);
+                    if (i < nr - 1) matrix->setElement(row, row + 1, -east);
+                    if (j > 0) matrix->setElement(row, row - nr, -angular);
+                    if (j < nTheta - 1) matrix->setElement(row, row + nr, -angular);
+                }
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        /**
+         * Finite volume Laplacian of the unit square with Dirichlet boundaries, uniform in x and geometrically
+         * refined towards the wall y = 0, as the meshes of wall bounded flows.
+         */
+        static shared_ptr<NumericalMatrix<double>> _stretchedBoundaryLayer(unsigned nx, unsigned ny, double stretching, unsigned availableThreads){
+            auto y = _stretchedNodes(0, 1, ny + 1, stretching);
+            double dx = 1.0 / (nx + 1);
+            unsigned n = nx * ny;
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, availableThreads);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned j = 0; j < ny; j++) {
+                double dySouth = y[j + 1] - y[j], dyNorth = y[j + 2] - y[j + 1];
+                double cellHeight = 0.5 * (dySouth + dyNorth);
+                double horizontal = cellHeight / dx;
+                double south = dx / dySouth, north = dx / dyNorth;
+                for (unsigned i = 0; i < nx; i++) {
+                    unsigned row = j * nx + i;
+                    matrix->setElement(row, row, 2 * horizontal + south + north);
+                    if (i > 0) matrix->setElement(row, row - 1, -horizontal);
+                    if (i < nx - 1) matrix->setElement(row, row + 1, -horizontal);
+                    if (j > 0) matrix->setElement(row, row - nx, -south);
+                    if (j < ny - 1) matrix->setElement(row, row + nx, -north);
+                }
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        /**
+         * Returns intervals + 1 nodes from start to end whose spacing grows by the stretching factor.
+         */
+        static vector<double> _stretchedNodes(double start, double end, unsigned intervals, double stretching){
+            vector<double> nodes(intervals + 1, start);
+            double spacing = 1, total = 0;
+            for (unsigned i = 0; i < intervals; i++) {
+                nodes[i + 1] = nodes[i] + spacing;
+                total += spacing;
+                spacing *= stretching;
+            }
+            for (auto &node : nodes)
+                node = start + (node - start) / total * (end - start);
+            nodes[intervals] = end;
+            return nodes;
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_PRECONDITIONEDCONJUGATEGRADIENTTEST_H
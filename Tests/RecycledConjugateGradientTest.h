@@ -0,0 +1,198 @@
+//
+// Created by hal9000 on 11/5/23.
+//
+
+#ifndef UNTITLED_RECYCLEDCONJUGATEGRADIENTTEST_H
+#define UNTITLED_RECYCLEDCONJUGATEGRADIENTTEST_H
+
+#include <cassert>
+#include <chrono>
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/RecycledConjugateGradient.h"
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/PreconditionedConjugateGradient.h"
+#include "../LinearAlgebra/Solvers/Preconditioners/JacobiPreconditioner.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class RecycledConjugateGradientTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testRitzValues();
+            testRecyclingSequence();
+            testRecyclingReport();
+        }
+
+        static void testRitzValues(){
+            logTestStart("testRitzValues");
+            //Constant coefficients: the eigenvalues of the 5-point Laplacian are known
+            unsigned grid = 30;
+            auto matrix = _diffusion(grid, 0, 0, 2);
+            unsigned n = matrix->numberOfRows();
+            RecycledConjugateGradient<double> solver(1E-10, 1000, true, 2, 4, 30);
+            //Every cycle refines the recycled space
+            solver.setHarvestCycles(0);
+            PreconditionedConjugateGradient<double> single(1E-10, 1000, true, 2);
+            for (unsigned step = 0; step < 4; step++) {
+                auto rhs = _rhs(n, 1.7 * step);
+                NumericalVector<double> solution(n), reference(n);
+                solver.solve(matrix, *rhs, solution);
+                single.solve(matrix, *rhs, reference);
+                assert(_relativeResidual(*matrix, *rhs, solution) < 1E-9);
+                //k + 1 products more than the iterations, fewer iterations than PCG once W is recycled
+                assert(solver.getMatrixVectorProducts() == solver.getIterations() + 1 + (step == 0 ? 0 : 4));
+                if (step == 0)
+                    assert(solver.getIterations() == single.getIterations());
+                else
+                    assert(solver.getIterations() < single.getIterations());
+            }
+            assert(solver.getRecycledDimension() == 4);
+            double h = M_PI / (grid + 1);
+            double smallest = 4 - 4 * std::cos(h);
+            double second = 4 - 2 * std::cos(h) - 2 * std::cos(2 * h);
+            auto &ritzValues = solver.getRitzValues();
+            assert(std::abs(ritzValues[0] - smallest) < 1E-5 * smallest);
+            assert(std::abs(ritzValues[1] - second) < 1E-3 * second);
+            assert(ritzValues[1] <= ritzValues[2] && ritzValues[2] <= ritzValues[3]);
+
+            //A system of another size clears the recycled space
+            auto small = _diffusion(10, 0, 0, 1);
+            auto rhs = _rhs(100, 0);
+            NumericalVector<double> solution(100);
+            solver.solve(small, *rhs, solution);
+            assert(solver.getMatrixVectorProducts() == solver.getIterations() + 1);
+            solver.clearRecycledSpace();
+            assert(solver.getRecycledDimension() == 0);
+            logTestEnd();
+        }
+
+        static void testRecyclingSequence(){
+            logTestStart("testRecyclingSequence");
+            //Slowly varying coefficients and right hand sides, Jacobi preconditioner, warm start
+            unsigned grid = 40, systems = 12;
+            unsigned n = grid * grid;
+            RecycledConjugateGradient<double> solver(1E-9, 1000, true, 2, 6, 20);
+            solver.setWarmStart(true);
+            PreconditionedConjugateGradient<double> single(1E-9, 1000, true, 2);
+            unsigned recycledIterations = 0, singleIterations = 0;
+            NumericalVector<double> solution(n);
+            for (unsigned step = 0; step < systems; step++) {
+                auto matrix = _diffusion(grid, 0.5, 0.05 * step, 2);
+                auto jacobi = make_shared<JacobiPreconditioner<double>>();
+                jacobi->setup(matrix);
+                solver.setPreconditioner(jacobi);
+                single.setPreconditioner(jacobi);
+                auto rhs = _rhs(n, 0.05 * step);
+                //The vector passed in is ignored after the first solve
+                std::fill(solution.getDataPointer(), solution.getDataPointer() + n, step == 0 ? 0.0 : 1E3);
+                solver.solve(matrix, *rhs, solution);
+                assert(_relativeResidual(*matrix, *rhs, solution) < 1E-8);
+                NumericalVector<double> reference(n);
+                single.solve(matrix, *rhs, reference);
+                recycledIterations += solver.getIterations();
+                singleIterations += single.getIterations();
+            }
+            assert(5 * recycledIterations < 4 * singleIterations);
+            logTestEnd();
+        }
+
+        static void testRecyclingReport(){
+            logTestStart("testRecyclingReport");
+            unsigned threads = _reportThreads();
+            unsigned grid = 80, systems = 100;
+            unsigned n = grid * grid;
+            cout << endl << "  " << systems << " variable coefficient diffusion systems on a " << grid << " x " << grid
+                 << " grid, coefficients and right hand side drift with t, Jacobi preconditioner, " << threads
+                 << " threads, to 1E-8" << endl;
+            PreconditionedConjugateGradient<double> single(1E-8, 5000, true, threads);
+            //k = 8 recycled vectors, harvested from the first cycle of s = 20 directions or from all the cycles
+            RecycledConjugateGradient<double> firstCycle(1E-8, 5000, true, threads, 8, 20);
+            RecycledConjugateGradient<double> allCycles(1E-8, 5000, true, threads, 8, 20);
+            allCycles.setHarvestCycles(0);
+            vector<RecycledConjugateGradient<double>*> recycled = {&firstCycle, &allCycles};
+            vector<unsigned> iterations(4, 0), products(4, 0);
+            vector<double> times(4, 0);
+            NumericalVector<double> cold(n), warm(n), solution(n);
+            for (auto solver : recycled)
+                solver->setWarmStart(true);
+            for (unsigned step = 0; step < systems; step++) {
+                auto matrix = _diffusion(grid, 0.5, 0.02 * step, threads);
+                auto jacobi = make_shared<JacobiPreconditioner<double>>();
+                jacobi->setup(matrix);
+                auto rhs = _rhs(n, 0.02 * step);
+                single.setPreconditioner(jacobi);
+                std::fill(cold.getDataPointer(), cold.getDataPointer() + n, 0.0);
+                single.solve(matrix, *rhs, cold);
+                iterations[0] += single.getIterations();
+                products[0] += single.getIterations() + 1;
+                times[0] += single.getSolutionTime();
+                single.solve(matrix, *rhs, warm);
+                iterations[1] += single.getIterations();
+                products[1] += single.getIterations() + 1;
+                times[1] += single.getSolutionTime();
+                for (unsigned i = 0; i < 2; i++) {
+                    recycled[i]->setPreconditioner(jacobi);
+                    recycled[i]->solve(matrix, *rhs, solution);
+                    iterations[i + 2] += recycled[i]->getIterations();
+                    products[i + 2] += recycled[i]->getMatrixVectorProducts();
+                    times[i + 2] += recycled[i]->getSolutionTime();
+                }
+            }
+            vector<string> labels = {"PCG from zero", "PCG warm start", "Recycled CG k = 8, s = 20, first cycle",
+                                     "Recycled CG k = 8, s = 20, all cycles"};
+            for (unsigned i = 0; i < 4; i++)
+                cout << "    " << labels[i] << " : " << iterations[i] << " iterations ("
+                     << 100.0 * (static_cast<double>(iterations[0]) - iterations[i]) / iterations[0] << "% saved), "
+                     << products[i] << " matrix products, " << times[i] << " ms" << endl;
+            assert(iterations[3] < iterations[2] && iterations[2] < iterations[1] && iterations[1] < iterations[0]);
+            logTestEnd();
+        }
+
+    private:
+
+        /**
+         * 5-point finite volume -∇·(a ∇u) on the internal nodes of a uniform grid x grid mesh of the unit square with
+         * Dirichlet walls, a = 1 + amplitude sin(2π x + t) cos(2π y) evaluated at the faces.
+         */
+        static shared_ptr<NumericalMatrix<double>> _diffusion(unsigned grid, double amplitude, double time,
+                                                              unsigned availableThreads){
+            unsigned n = grid * grid;
+            double h = 1.0 / (grid + 1);
+            auto coefficient = [&](double x, double y) {
+                return 1 + amplitude * std::sin(2 * M_PI * x + time) * std::cos(2 * M_PI * y);
+            };
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, availableThreads);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned row = 0; row < n; row++) {
+                unsigned i = row % grid, j = row / grid;
+                double x = (i + 1) * h, y = (j + 1) * h;
+                double west = coefficient(x - h / 2, y), east = coefficient(x + h / 2, y);
+                double south = coefficient(x, y - h / 2), north = coefficient(x, y + h / 2);
+                matrix->setElement(row, row, west + east + south + north);
+                if (i > 0) matrix->setElement(row, row - 1, -west);
+                if (i + 1 < grid) matrix->setElement(row, row + 1, -east);
+                if (j > 0) matrix->setElement(row, row - grid, -south);
+                if (j + 1 < grid) matrix->setElement(row, row + grid, -north);
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        static shared_ptr<NumericalVector<double>> _rhs(unsigned n, double time){
+            auto rhs = make_shared<NumericalVector<double>>(n);
+            for (unsigned i = 0; i < n; i++)
+                (*rhs)[i] = 1.0 + std::sin(0.37 * i + time) + 0.5 * std::cos(0.011 * i - 2 * time);
+            return rhs;
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_RECYCLEDCONJUGATEGRADIENTTEST_H
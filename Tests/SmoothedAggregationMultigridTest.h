@@ -0,0 +1,305 @@
+//
+// Created by hal9000 on 10/28/23.
+//
+
+#ifndef UNTITLED_SMOOTHEDAGGREGATIONMULTIGRIDTEST_H
+#define UNTITLED_SMOOTHEDAGGREGATIONMULTIGRIDTEST_H
+
+#include <cassert>
+#include <random>
+#include "../LinearAlgebra/Solvers/Multigrid/SmoothedAggregationMultigrid.h"
+#include "../LinearAlgebra/Solvers/Multigrid/GeometricMultigrid.h"
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/PreconditionedConjugateGradient.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class SmoothedAggregationMultigridTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testAggregation();
+            testParallelAggregation();
+            testAlgebraicMultigridSolve();
+            testAnisotropicAndEliminatedSystems();
+            testUpdateValuesReusesAggregates();
+            testStalledCoarsening();
+            testAlgebraicMultigridPerformanceReport();
+        }
+
+        static void testAggregation(){
+            logTestStart("testAggregation");
+            unsigned nx = 40, ny = 40;
+            auto matrix = _diffusion(nx, ny, 1, {}, 2);
+            SmoothedAggregationMultigrid<double> amg;
+            amg.setup(matrix);
+            assert(amg.getNumberOfLevels() >= 3);
+            auto &aggregates = amg.getAggregates(0);
+            unsigned numberOfAggregates = amg.getLevelMatrix(1)->numberOfRows();
+            vector<unsigned> sizes(numberOfAggregates, 0);
+            for (auto aggregate : aggregates) {
+                assert(aggregate < numberOfAggregates);
+                sizes[aggregate]++;
+            }
+            for (auto size : sizes)
+                assert(size > 0);
+            //3x3 aggregates in the interior of the 5-point stencil
+            assert(numberOfAggregates < nx * ny / 5);
+            auto &P = *amg.getProlongation(0);
+            assert(P.numberOfRows() == nx * ny && P.numberOfColumns() == numberOfAggregates);
+            //Galerkin operators of symmetric matrices are symmetric
+            auto &coarse = *amg.getLevelMatrix(1);
+            for (unsigned i = 0; i < 50; i++)
+                for (unsigned j = 0; j < 50; j++)
+                    assert(std::abs(coarse.getElement(i, j) - coarse.getElement(j, i)) < 1E-12);
+            logTestEnd();
+        }
+
+        static void testParallelAggregation(){
+            logTestStart("testParallelAggregation");
+            //Rows of 4 threads: the aggregates of every thread are fixed up across the boundaries of its range
+            auto holes = _randomHoles(90, 90, 0.1, 7);
+            auto serialMatrix = _diffusion(90, 90, 1, holes, 1);
+            auto parallelMatrix = _diffusion(90, 90, 1, holes, 4);
+            SmoothedAggregationMultigrid<double> serial;
+            serial.setup(serialMatrix);
+            auto parallel = make_shared<SmoothedAggregationMultigrid<double>>();
+            parallel->setup(parallelMatrix);
+            auto &aggregates = parallel->getAggregates(0);
+            unsigned numberOfAggregates = parallel->getLevelMatrix(1)->numberOfRows();
+            vector<unsigned> sizes(numberOfAggregates, 0);
+            for (unsigned row = 0; row < aggregates.size(); row++) {
+                assert(aggregates[row] < numberOfAggregates || aggregates[row] == SmoothedAggregationMultigrid<double>::unaggregated);
+                assert((aggregates[row] == SmoothedAggregationMultigrid<double>::unaggregated) ==
+                       (serial.getAggregates(0)[row] == SmoothedAggregationMultigrid<double>::unaggregated));
+                if (aggregates[row] < numberOfAggregates)
+                    sizes[aggregates[row]]++;
+            }
+            for (auto size : sizes)
+                assert(size > 0);
+            unsigned serialAggregates = serial.getLevelMatrix(1)->numberOfRows();
+            assert(numberOfAggregates * 10 <= serialAggregates * 11);
+
+            auto rhs = _rhs(parallelMatrix->numberOfRows());
+            PreconditionedConjugateGradient<double> solver(1E-10, 200, true, 4);
+            solver.setPreconditioner(parallel);
+            NumericalVector<double> solution(parallelMatrix->numberOfRows());
+            solver.solve(parallelMatrix, *rhs, solution);
+            assert(solver.getIterations() <= 25);
+            assert(_relativeResidual(*parallelMatrix, *rhs, solution) <= 1E-9);
+            logTestEnd();
+        }
+
+        static void testAlgebraicMultigridSolve(){
+            logTestStart("testAlgebraicMultigridSolve");
+            auto matrix = _diffusion(100, 100, 1, {}, 2);
+            auto rhs = _rhs(matrix->numberOfRows());
+            for (auto smoother : {DampedJacobiSmoother, ColoredGaussSeidelSmoother}) {
+                auto amg = make_shared<SmoothedAggregationMultigrid<double>>(0.08, VCycle, smoother);
+                amg->setup(matrix);
+                NumericalVector<double> solution(matrix->numberOfRows());
+                unsigned cycles = amg->solve(*rhs, solution, 1E-8, 100);
+                assert(cycles <= 60);
+                assert(_relativeResidual(*matrix, *rhs, solution) <= 1E-8);
+
+                PreconditionedConjugateGradient<double> solver(1E-10, 200, true, 2);
+                solver.setPreconditioner(amg);
+                NumericalVector<double> pcgSolution(matrix->numberOfRows());
+                solver.solve(matrix, *rhs, pcgSolution);
+                assert(solver.getIterations() <= 25);
+                assert(_relativeResidual(*matrix, *rhs, pcgSolution) <= 1E-9);
+            }
+            logTestEnd();
+        }
+
+        static void testAnisotropicAndEliminatedSystems(){
+            logTestStart("testAnisotropicAndEliminatedSystems");
+            vector<shared_ptr<NumericalMatrix<double>>> matrices = {
+                    _diffusion(100, 100, 1E-3, {}, 2),
+                    _diffusion(100, 100, 1, _randomHoles(100, 100, 0.1, 5), 2)};
+            for (auto &matrix : matrices) {
+                auto rhs = _rhs(matrix->numberOfRows());
+                auto amg = make_shared<SmoothedAggregationMultigrid<double>>();
+                amg->setup(matrix);
+                PreconditionedConjugateGradient<double> solver(1E-10, 500, true, 2);
+                solver.setPreconditioner(amg);
+                NumericalVector<double> solution(matrix->numberOfRows());
+                solver.solve(matrix, *rhs, solution);
+                assert(solver.getIterations() <= 30);
+                assert(_relativeResidual(*matrix, *rhs, solution) <= 1E-9);
+            }
+            logTestEnd();
+        }
+
+        static void testUpdateValuesReusesAggregates(){
+            logTestStart("testUpdateValuesReusesAggregates");
+            auto matrix = _diffusion(80, 80, 1, {}, 2);
+            auto scaled = _diffusion(80, 80, 1, {}, 2, [](double x, double y) { return 1 + 10 * x * y; });
+            auto amg = make_shared<SmoothedAggregationMultigrid<double>>();
+            amg->setup(matrix);
+            auto aggregates = amg->getAggregates(0);
+            unsigned levels = amg->getNumberOfLevels();
+
+            amg->updateValues(scaled);
+            assert(amg->getNumberOfLevels() == levels && amg->getAggregates(0) == aggregates);
+            //The coarse operators are those of the new matrix
+            auto rebuilt = make_shared<SmoothedAggregationMultigrid<double>>();
+            rebuilt->setup(scaled);
+            if (rebuilt->getAggregates(0) == aggregates)
+                assert(*rebuilt->getLevelMatrix(1)->dataStorage->getValues() == *amg->getLevelMatrix(1)->dataStorage->getValues());
+
+            auto rhs = _rhs(scaled->numberOfRows());
+            PreconditionedConjugateGradient<double> solver(1E-10, 200, true, 2);
+            solver.setPreconditioner(amg);
+            NumericalVector<double> solution(scaled->numberOfRows());
+            solver.solve(scaled, *rhs, solution);
+            assert(solver.getIterations() <= 25);
+            assert(_relativeResidual(*scaled, *rhs, solution) <= 1E-9);
+
+            bool exceptionThrown = false;
+            try {
+                amg->updateValues(_diffusion(10, 10, 1, {}, 1));
+            }
+            catch (const invalid_argument &) {
+                exceptionThrown = true;
+            }
+            assert(exceptionThrown);
+            logTestEnd();
+        }
+
+        static void testStalledCoarsening(){
+            logTestStart("testStalledCoarsening");
+            //No off-diagonal couplings, no aggregates: the single level is too large to factorize densely
+            unsigned n = 20000;
+            auto diagonal = make_shared<NumericalMatrix<double>>(n, n, CSR, General, 2);
+            diagonal->dataStorage->initializeElementAssignment();
+            for (unsigned i = 0; i < n; i++)
+                diagonal->setElement(i, i, 1 + i % 3);
+            diagonal->dataStorage->finalizeElementAssignment();
+            auto rhs = _rhs(n);
+            SmoothedAggregationMultigrid<double> amg;
+            amg.setup(diagonal);
+            assert(amg.getNumberOfLevels() == 1 && amg.isCoarsestSmoothed());
+            NumericalVector<double> solution(n);
+            amg.solve(*rhs, solution, 1E-10, 30);
+            assert(_relativeResidual(*diagonal, *rhs, solution) <= 1E-10);
+
+            //Coarsening cut off above the dense limit: the smoothed coarsest level still preconditions PCG
+            auto matrix = _laplacian(30, 30, 1, 2);
+            rhs = _rhs(matrix->numberOfRows());
+            auto truncated = make_shared<SmoothedAggregationMultigrid<double>>();
+            truncated->setMaximumLevels(2);
+            truncated->setMaximumDirectCoarsestUnknowns(16);
+            truncated->setup(matrix);
+            assert(truncated->getNumberOfLevels() == 2 && truncated->isCoarsestSmoothed());
+            PreconditionedConjugateGradient<double> solver(1E-10, 500, true, 2);
+            solver.setPreconditioner(truncated);
+            NumericalVector<double> pcgSolution(matrix->numberOfRows());
+            solver.solve(matrix, *rhs, pcgSolution);
+            assert(solver.hasConverged() && _relativeResidual(*matrix, *rhs, pcgSolution) <= 1E-9);
+            logTestEnd();
+        }
+
+        static void testAlgebraicMultigridPerformanceReport(){
+            logTestStart("testAlgebraicMultigridPerformanceReport");
+            unsigned threads = _reportThreads();
+            cout << endl << "  SA-AMG V(1,1) Jacobi preconditioned CG to 1E-8 (" << threads << " threads)" << endl;
+            for (unsigned n : {100u, 200u, 400u})
+                _report("Poisson " + to_string(n) + "x" + to_string(n), _diffusion(n, n, 1, {}, threads), threads, false);
+            _report("Anisotropic ε = 1E-3 200x200", _diffusion(200, 200, 1E-3, {}, threads), threads, true);
+            _report("Poisson 200x200, 10% nodes eliminated", _diffusion(200, 200, 1, _randomHoles(200, 200, 0.1, 9), threads), threads, false);
+            logTestEnd();
+        }
+
+    private:
+
+        static void _report(const string &name, const shared_ptr<NumericalMatrix<double>> &matrix, unsigned threads, bool compareGeometric){
+            auto rhs = _rhs(matrix->numberOfRows());
+            auto amg = make_shared<SmoothedAggregationMultigrid<double>>();
+            auto start = std::chrono::high_resolution_clock::now();
+            amg->setup(matrix);
+            auto end = std::chrono::high_resolution_clock::now();
+            double setupTime = std::chrono::duration<double, std::milli>(end - start).count();
+            start = std::chrono::high_resolution_clock::now();
+            amg->updateValues(matrix);
+            end = std::chrono::high_resolution_clock::now();
+            double updateTime = std::chrono::duration<double, std::milli>(end - start).count();
+
+            PreconditionedConjugateGradient<double> solver(1E-8, 2000, true, threads);
+            solver.setPreconditioner(amg);
+            NumericalVector<double> solution(matrix->numberOfRows());
+            solver.solve(matrix, *rhs, solution);
+            cout << "    " << name << " (" << matrix->numberOfRows() << " unknowns) : " << amg->getNumberOfLevels()
+                 << " levels, operator complexity " << amg->operatorComplexity() << ", setup / update " << setupTime
+                 << " / " << updateTime << " ms, " << solver.getIterations() << " iterations, solve "
+                 << solver.getSolutionTime() << " ms" << endl;
+            if (compareGeometric) {
+                unsigned n = static_cast<unsigned>(std::lround(std::sqrt(matrix->numberOfRows())));
+                map<PositioningInSpace::Direction, unsigned> unknowns = {{PositioningInSpace::One, n}, {PositioningInSpace::Two, n}};
+                auto gmg = make_shared<GeometricMultigrid<double>>(unknowns, VCycle, DampedJacobiSmoother, 1, 1);
+                gmg->setup(matrix);
+                solver.setPreconditioner(gmg);
+                std::fill(solution.getDataPointer(), solution.getDataPointer() + solution.size(), 0.0);
+                solver.solve(matrix, *rhs, solution);
+                cout << "      " << gmg->getName() << " on the same system : " << solver.getIterations()
+                     << " iterations, solve " << solver.getSolutionTime() << " ms" << endl;
+            }
+        }
+
+        /**
+         * Returns the nodes of a nx x ny grid that are eliminated, e.g. by internal Dirichlet constraints.
+         */
+        static vector<bool> _randomHoles(unsigned nx, unsigned ny, double fraction, unsigned seed){
+            std::mt19937 generator(seed);
+            std::uniform_real_distribution<double> distribution(0, 1);
+            vector<bool> eliminated(nx * ny);
+            for (unsigned i = 0; i < nx * ny; i++)
+                eliminated[i] = distribution(generator) < fraction;
+            return eliminated;
+        }
+
+        /**
+         * Finite difference -ε k u_xx - k u_yy on the internal nodes of the unit square with Dirichlet boundaries,
+         * scaled by h². Eliminated nodes are removed from the system and act as Dirichlet nodes.
+         */
+        static shared_ptr<NumericalMatrix<double>> _diffusion(unsigned nx, unsigned ny, double epsilon, const vector<bool> &eliminated,
+                                                              unsigned availableThreads,
+                                                              const function<double(double, double)> &k = [](double, double) { return 1.0; }){
+            vector<unsigned> index(nx * ny);
+            unsigned n = 0;
+            for (unsigned node = 0; node < nx * ny; node++)
+                index[node] = eliminated.empty() || !eliminated[node] ? n++ : numeric_limits<unsigned>::max();
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, availableThreads);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned j = 0; j < ny; j++) {
+                for (unsigned i = 0; i < nx; i++) {
+                    unsigned row = index[j * nx + i];
+                    if (row == numeric_limits<unsigned>::max())
+                        continue;
+                    double coefficient = k((i + 1.0) / (nx + 1), (j + 1.0) / (ny + 1));
+                    matrix->setElement(row, row, coefficient * (2 * epsilon + 2));
+                    auto couple = [&](unsigned neighbour, double value) {
+                        if (index[neighbour] != numeric_limits<unsigned>::max())
+                            matrix->setElement(row, index[neighbour], -coefficient * value);
+                    };
+                    if (i > 0) couple(j * nx + i - 1, epsilon);
+                    if (i < nx - 1) couple(j * nx + i + 1, epsilon);
+                    if (j > 0) couple((j - 1) * nx + i, 1);
+                    if (j < ny - 1) couple((j + 1) * nx + i, 1);
+                }
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_SMOOTHEDAGGREGATIONMULTIGRIDTEST_H
@@ -0,0 +1,256 @@
+//
+// Created by hal9000 on 11/10/23.
+//
+
+#ifndef UNTITLED_SOLVERSELECTIONTEST_H
+#define UNTITLED_SOLVERSELECTIONTEST_H
+
+#include <cassert>
+#include "../LinearAlgebra/Solvers/Selection/AutomaticSolver.h"
+#include "../LinearAlgebra/Solvers/Iterative/GradientBasedIterative/ConjugateGradientSolver.h"
+#include "../StructuredMeshGeneration/MeshFactory.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class SolverSelectionTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testMatrixProperties();
+            testSelection();
+            testFallback();
+            testAutomaticSolver();
+            testMeshFactory();
+        }
+
+        static void testMatrixProperties(){
+            logTestStart("testMatrixProperties");
+            SolverSelector<double> selector(1E-9, 1000, 2);
+            unsigned grid = 20;
+            auto properties = selector.analyze(_fivePointStencil(grid, grid, 4, -1, -1, -1, -1, 2));
+            assert(properties.numberOfRows == grid * grid && properties.numberOfNonZeros == 5 * grid * grid - 4 * grid);
+            assert(properties.lowerBandwidth == grid && properties.upperBandwidth == grid);
+            assert(properties.symmetric && properties.structurallySymmetric && properties.positiveDiagonal);
+            assert(properties.diagonallyDominant && properties.dominantRowFraction == 1);
+            //The Ritz values bound the condition number of D^-1 A from below
+            double cosine = std::cos(M_PI / (grid + 1)), exact = (1 + cosine) / (1 - cosine);
+            assert(properties.positiveDefinite && properties.conditionEstimate <= exact * (1 + 1E-10));
+            assert(properties.conditionEstimate > 0.5 * exact && !properties.negativeDefinite);
+
+            //The Laplacian assembled with a negative diagonal: -A is estimated, D^-1 A has the same spectrum
+            auto negativeProperties = selector.analyze(_fivePointStencil(grid, grid, -4, 1, 1, 1, 1, 2));
+            assert(negativeProperties.symmetric && negativeProperties.negativeDiagonal && !negativeProperties.positiveDiagonal);
+            assert(negativeProperties.negativeDefinite && !negativeProperties.positiveDefinite);
+            assert(std::abs(negativeProperties.conditionEstimate - properties.conditionEstimate) < 1E-6 * exact);
+
+            //Upwind convection: non-symmetric values on a symmetric pattern, weakly dominant, no estimate
+            properties = selector.analyze(_fivePointStencil(grid, grid, 5, -1.5, -1, -1, -1, 2));
+            assert(!properties.symmetric && properties.structurallySymmetric && properties.diagonallyDominant);
+            assert(!properties.positiveDefinite && properties.conditionEstimate == 0);
+
+            //Shifted below the smallest eigenvalue: symmetric with a positive diagonal but indefinite
+            properties = selector.analyze(_fivePointStencil(grid, grid, 3.5, -1, -1, -1, -1, 2));
+            assert(properties.symmetric && properties.positiveDiagonal && !properties.diagonallyDominant);
+            assert(!properties.positiveDefinite && properties.dominantRowFraction < 0.5);
+
+            properties = selector.analyze(_saddlePoint(10));
+            assert(properties.symmetric && !properties.nonZeroDiagonal && !properties.positiveDiagonal);
+
+            properties = selector.analyze(_upperBidiagonal(10));
+            assert(!properties.structurallySymmetric && properties.lowerBandwidth == 0 && properties.upperBandwidth == 1);
+            logTestEnd();
+        }
+
+        static void testSelection(){
+            logTestStart("testSelection");
+            //Small SPD: the factorization is cheaper than the iterations
+            auto laplacian = _fivePointStencil(20, 20, 4, -1, -1, -1, -1, 2);
+            _check(laplacian, SupernodalCholeskySelection, NoPreconditionerSelection, 1E300);
+            //Negative definite: the selection solves -A x = -b
+            auto negativeLaplacian = _fivePointStencil(20, 20, -4, 1, 1, 1, 1, 2);
+            _check(negativeLaplacian, SupernodalCholeskySelection, NoPreconditionerSelection, 1E300);
+            _check(negativeLaplacian, ConjugateGradientSelection, IncompleteCholeskySelection, 0);
+
+            //Without direct solvers
+            _check(_fivePointStencil(20, 20, 8, -1, -1, -1, -1, 2), ConjugateGradientSelection, JacobiSelection, 0);
+            auto largerLaplacian = _fivePointStencil(40, 40, 4, -1, -1, -1, -1, 2);
+            _check(largerLaplacian, ConjugateGradientSelection, IncompleteCholeskySelection, 0);
+            _check(largerLaplacian, ConjugateGradientSelection, AlgebraicMultigridSelection, 0, 1000);
+            _check(_fivePointStencil(40, 40, 5, -1.5, -1, -1, -1, 2), BiCGStabSelection, IncompleteLUSelection, 0);
+            //Central convection, cell Péclet number 2: not dominant
+            _check(_fivePointStencil(40, 40, 4, -3, 1, -1, -1, 2), GMRESSelection, IncompleteLUSelection, 0);
+            _check(_fivePointStencil(20, 20, 3.5, -1, -1, -1, -1, 2), GMRESSelection, IncompleteLUSelection, 0);
+            //ILU(0) and Jacobi need the diagonal
+            _check(_saddlePoint(50), BandedLUSelection, NoPreconditionerSelection, 1E300);
+            //...and banded LU above the limits throws with the reasons
+            bool thrown = false;
+            SolverSelector<double> limited;
+            limited.setDirectFlopLimit(0);
+            try { limited.select(_saddlePoint(50)); }
+            catch (runtime_error &exception) {
+                thrown = string(exception.what()).find("zero diagonal elements") != string::npos;
+            }
+            assert(thrown);
+
+            //Non-symmetric and cheap to factorize
+            _check(_fivePointStencil(20, 20, 5, -1.5, -1, -1, -1, 2), BandedLUSelection, NoPreconditionerSelection, 1E300);
+
+            thrown = false;
+            SolverSelector<double> selector;
+            NumericalVector<double> rhs(4), solution(4);
+            try { selector.solve(rhs, solution); } catch (runtime_error &) { thrown = true; }
+            assert(thrown);
+            logTestEnd();
+        }
+
+        static void testFallback(){
+            logTestStart("testFallback");
+            //Well conditioned: Jacobi PCG is estimated cheaper than Cholesky
+            auto matrix = _fivePointStencil(40, 40, 10, -1, -1, -1, -1, 2);
+            unsigned n = matrix->numberOfRows();
+            auto rhs = _rhs(n);
+            SolverSelector<double> selector(1E-9, 2, 2);
+            selector.select(matrix);
+            assert(selector.getSelection().solver == ConjugateGradientSelection);
+            unsigned reasons = static_cast<unsigned>(selector.getSelection().reasons.size());
+            //PCG and GMRES stop after 2 iterations, banded LU solves
+            NumericalVector<double> solution(n);
+            selector.solve(*rhs, solution);
+            auto &selection = selector.getSelection();
+            assert(selection.fallbacks == 2 && selection.solver == BandedLUSelection && selection.reasons.size() == reasons + 2);
+            assert(selection.reasons.back().find("did not converge") != string::npos);
+            assert(_relativeResidual(*matrix, *rhs, solution) < 1E-12);
+
+            //Banded LU above the flop limit: the fallback throws with the reasons
+            SolverSelector<double> limited(1E-9, 2, 2);
+            limited.setDirectFlopLimit(1E5);
+            assert(limited.select(matrix).solver == ConjugateGradientSelection);
+            NumericalVector<double> initialGuess(n);
+            bool thrown = false;
+            try { limited.solve(*rhs, initialGuess); }
+            catch (runtime_error &exception) {
+                thrown = string(exception.what()).find("did not converge") != string::npos;
+            }
+            assert(thrown);
+            logTestEnd();
+        }
+
+        static void testAutomaticSolver(){
+            logTestStart("testAutomaticSolver");
+            unsigned grid = 10, n = grid * grid;
+            auto csr = _fivePointStencil(grid, grid, 4, -1, -1, -1, -1, 1);
+            auto exact = _rhs(n);
+            NumericalVector<double> product(n);
+            csr->multiplyVector(*exact, product);
+            for (unsigned directFlopLimit : {1000000000u, 0u}) {
+                auto matrix = make_shared<Array<double>>(n, n);
+                auto supplementaryDataPointers = csr->dataStorage->getSupplementaryDataPointers();
+                for (unsigned i = 0; i < n; i++)
+                    for (unsigned k = supplementaryDataPointers[1][i]; k < supplementaryDataPointers[1][i + 1]; k++)
+                        (*matrix)(i, supplementaryDataPointers[0][k]) = csr->dataStorage->getValuesDataPointer()[k];
+                auto rhs = make_shared<vector<double>>(product.getDataPointer(), product.getDataPointer() + n);
+                AutomaticSolver solver(1E-12, 1000, false, 2);
+                solver.getSelector()->setDirectFlopLimit(directFlopLimit);
+                auto linearSystem = make_shared<LinearSystem>(matrix, rhs);
+                solver.setLinearSystem(linearSystem);
+                solver.solve();
+                auto &selection = solver.getSelector()->getSelection();
+                assert(selection.solver == (directFlopLimit > 0 ? SupernodalCholeskySelection : ConjugateGradientSelection));
+                assert(solver.type() == (directFlopLimit > 0 ? Direct : PreconditionedIterative));
+                for (unsigned i = 0; i < n; i++)
+                    assert(std::abs(linearSystem->solution->at(i) - (*exact)[i]) < 1E-10);
+                assert(solver.getSelector()->report().find(SolverSelector<double>::name(selection.solver)) != string::npos);
+            }
+            logTestEnd();
+        }
+
+        static void testMeshFactory(){
+            logTestStart("testMeshFactory");
+            //The default automatic solver against the CG that buildMesh used before
+            map<Direction, unsigned> nodesPerDirection = {{One, 7}, {Two, 7}};
+            vector<vector<double>> coordinates[2];
+            for (auto useConjugateGradient : {false, true}) {
+                auto specs = make_shared<MeshSpecs>(nodesPerDirection, 1, 1, 0, 0, 0);
+                //Kept alive like the other mesh builders: ~Mesh2D deletes the nodes twice
+                auto meshFactory = new MeshFactory(specs);
+                auto boundaries = make_shared<DomainBoundaryFactory>(meshFactory->mesh)->annulus_ripGewrgiou(nodesPerDirection, 0.5, 1, 0, 180);
+                shared_ptr<Solver> solver;
+                if (useConjugateGradient)
+                    solver = make_shared<ConjugateGradientSolver>(VectorNormType::L2, 1E-12, 1E4, true, MultiThread);
+                meshFactory->buildMesh(2, boundaries, solver);
+                for (auto &node : *meshFactory->mesh->totalNodesVector)
+                    coordinates[useConjugateGradient].push_back(node->coordinates.positionVector());
+            }
+            assert(coordinates[0].size() == 49 && coordinates[1].size() == coordinates[0].size());
+            double meanRadius = 0;
+            for (unsigned i = 0; i < coordinates[0].size(); i++) {
+                assert(coordinates[0][i].size() == 2 && coordinates[1][i].size() == 2);
+                for (unsigned d = 0; d < 2; d++)
+                    assert(std::abs(coordinates[0][i][d] - coordinates[1][i][d]) < 1E-8);
+                meanRadius += std::sqrt(coordinates[0][i][0] * coordinates[0][i][0] + coordinates[0][i][1] * coordinates[0][i][1]) / 49;
+            }
+            assert(meanRadius > 0.5 && meanRadius < 1);
+            logTestEnd();
+        }
+
+    private:
+        /**
+        * Selects for a matrix, checks the choice and solves to the tolerance.
+        */
+        static void _check(const shared_ptr<NumericalMatrix<double>> &matrix, SelectedSolver solver, SelectedPreconditioner preconditioner,
+                           double directFlopLimit, unsigned multigridRowLimit = 50000){
+            SolverSelector<double> selector(1E-9, 2000, 2);
+            selector.setDirectFlopLimit(directFlopLimit);
+            selector.setMultigridRowLimit(multigridRowLimit);
+            auto &selection = selector.select(matrix);
+            assert(selection.solver == solver && (selection.isDirect() || selection.preconditioner == preconditioner));
+            assert(selection.reasons.size() >= 2);
+            unsigned n = matrix->numberOfRows();
+            auto rhs = _rhs(n);
+            NumericalVector<double> solution(n);
+            selector.solve(*rhs, solution);
+            assert(selector.getSelection().fallbacks == 0);
+            assert(_relativeResidual(*matrix, *rhs, solution) <= (selection.isDirect() ? 1E-12 : 1E-9));
+        }
+
+        /**
+        * [[2 I + T, I], [I, 0]] with T the 1D Laplacian of m unknowns: symmetric, zero diagonal in the constraint block.
+        */
+        static shared_ptr<NumericalMatrix<double>> _saddlePoint(unsigned m){
+            unsigned n = 2 * m;
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, 1);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned i = 0; i < m; i++) {
+                matrix->setElement(i, i, 4);
+                if (i > 0) matrix->setElement(i, i - 1, -1);
+                if (i + 1 < m) matrix->setElement(i, i + 1, -1);
+                matrix->setElement(i, m + i, 1);
+                matrix->setElement(m + i, i, 1);
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        static shared_ptr<NumericalMatrix<double>> _upperBidiagonal(unsigned n){
+            auto matrix = make_shared<NumericalMatrix<double>>(n, n, CSR, General, 1);
+            matrix->dataStorage->initializeElementAssignment();
+            for (unsigned i = 0; i < n; i++) {
+                matrix->setElement(i, i, 2);
+                if (i + 1 < n) matrix->setElement(i, i + 1, -1);
+            }
+            matrix->dataStorage->finalizeElementAssignment();
+            return matrix;
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_SOLVERSELECTIONTEST_H
@@ -0,0 +1,248 @@
+//
+// Created by hal9000 on 11/6/23.
+//
+
+#ifndef UNTITLED_SOLVERTELEMETRYTEST_H
+#define UNTITLED_SOLVERTELEMETRYTEST_H
+
+#include <cassert>
+#include <sstream>
+#include <thread>
+#include "../LinearAlgebra/Solvers/Telemetry/TelemetrySinks.h"
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/PreconditionedConjugateGradient.h"
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/PipelinedConjugateGradient.h"
+#include "../LinearAlgebra/Solvers/Iterative/GradientBasedIterative/ConjugateGradientSolver.h"
+#include "../LinearAlgebra/EigenDecomposition/QR/IterationQR.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class SolverTelemetryTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testRingBuffer();
+            testConcurrentSnapshots();
+            testKrylovCounters();
+            testSinks();
+            testQuietLegacySolvers();
+        }
+
+        static void testRingBuffer(){
+            logTestStart("testRingBuffer");
+            SolverTelemetry telemetry(4);
+            telemetry.begin("ring");
+            for (unsigned i = 0; i < 10; i++) {
+                telemetry.countMatrixVectorProducts();
+                telemetry.countReductions(2);
+                telemetry.record(i, 1.0 / (i + 1));
+            }
+            //The last 4 records are kept, oldest first, with the cumulative counters
+            auto records = telemetry.records();
+            assert(records.size() == 4 && telemetry.droppedRecords() == 6 && telemetry.recordedIterations() == 10);
+            for (unsigned i = 0; i < 4; i++) {
+                assert(records[i].iteration == 6 + i);
+                assert(records[i].matrixVectorProducts == 7 + i && records[i].reductions == 2 * (7 + i));
+                assert(i == 0 || records[i].elapsedTime >= records[i - 1].elapsedTime);
+            }
+            telemetry.end(9, 0.1, false);
+            assert(telemetry.getSummary().solverName == "ring" && telemetry.getSummary().droppedRecords == 6);
+            assert(telemetry.getSummary().matrixVectorProducts == 10 && telemetry.getSummary().reductions == 20);
+
+            //begin() clears, a capacity of 0 keeps the counters only
+            telemetry.begin("again");
+            assert(telemetry.records().empty() && telemetry.getMatrixVectorProducts() == 0);
+            SolverTelemetry countersOnly(0);
+            countersOnly.begin("counters");
+            countersOnly.countReductions();
+            countersOnly.record(0, 1);
+            assert(countersOnly.records().empty() && countersOnly.recordedIterations() == 1 && countersOnly.getReductions() == 1);
+
+            bool thrown = false;
+            try { telemetry.attachSink(nullptr); } catch (invalid_argument &) { thrown = true; }
+            assert(thrown);
+            logTestEnd();
+        }
+
+        static void testConcurrentSnapshots(){
+            logTestStart("testConcurrentSnapshots");
+            //A small buffer lapped continuously: every snapshot holds complete, consecutive records
+            SolverTelemetry telemetry(8);
+            telemetry.begin("concurrent");
+            atomic<bool> done(false);
+            thread producer([&]() {
+                for (unsigned i = 0; i < 200000; i++) {
+                    telemetry.countMatrixVectorProducts();
+                    telemetry.record(i, static_cast<double>(i));
+                }
+                done = true;
+            });
+            unsigned long snapshots = 0;
+            while (!done || snapshots == 0) {
+                auto records = telemetry.records();
+                assert(records.size() <= 8);
+                for (unsigned k = 0; k < records.size(); k++) {
+                    assert(records[k].residual == records[k].iteration && records[k].matrixVectorProducts == records[k].iteration + 1);
+                    assert(k == 0 || records[k].iteration == records[k - 1].iteration + 1);
+                }
+                snapshots++;
+            }
+            producer.join();
+            auto records = telemetry.records();
+            assert(records.size() == 8 && records.back().iteration == 199999);
+            logTestEnd();
+        }
+
+        static void testKrylovCounters(){
+            logTestStart("testKrylovCounters");
+            auto matrix = _laplacian(30, 30, 1, 2);
+            unsigned n = matrix->numberOfRows();
+            auto rhs = _rhs(n);
+            PreconditionedConjugateGradient<double> pcg(1E-8, 1000, true, 2);
+            NumericalVector<double> solution(n);
+            pcg.solve(matrix, *rhs, solution);
+            auto &summary = pcg.getTelemetry()->getSummary();
+            unsigned iterations = pcg.getIterations();
+            //A x0 and A p per iteration. ||b||, ||r0||, (r0, z0), then (p, A p) and ||r|| per iteration and (r, z)
+            //except for the last one
+            assert(summary.converged && summary.iterations == iterations && summary.exitNorm == pcg.getExitNorm());
+            assert(summary.matrixVectorProducts == iterations + 1);
+            assert(summary.reductions == 3 * iterations + 2);
+            auto records = pcg.getTelemetry()->records();
+            assert(records.size() == pcg.getResidualNorms()->size());
+            assert(records.back().residual == pcg.getExitNorm() && records.back().iteration == iterations);
+
+            //The pipelined recurrences fuse the three reductions of an iteration into one
+            PipelinedConjugateGradient<double> pipelined(1E-8, 1000, true, 2);
+            NumericalVector<double> pipelinedSolution(n);
+            pipelined.solve(matrix, *rhs, pipelinedSolution);
+            auto &pipelinedSummary = pipelined.getTelemetry()->getSummary();
+            assert(pipelinedSummary.matrixVectorProducts == pipelined.getIterations() + 2);
+            assert(pipelinedSummary.reductions == pipelined.getIterations() + 4);
+            assert(pipelinedSummary.reductions * iterations < summary.reductions * pipelined.getIterations());
+            logTestEnd();
+        }
+
+        static void testSinks(){
+            logTestStart("testSinks");
+            auto matrix = _laplacian(10, 10, 1, 1);
+            unsigned n = matrix->numberOfRows();
+            auto rhs = _rhs(n);
+            PreconditionedConjugateGradient<double> pcg(1E-8, 1000, true, 1);
+            auto memory = make_shared<MemoryTelemetrySink>();
+            ostringstream csv, json;
+            pcg.getTelemetry()->attachSink(memory);
+            pcg.getTelemetry()->attachSink(make_shared<CSVTelemetrySink>(csv));
+            pcg.getTelemetry()->attachSink(make_shared<JSONTelemetrySink>(json));
+            for (unsigned solve = 0; solve < 2; solve++) {
+                NumericalVector<double> solution(n);
+                pcg.solve(matrix, *rhs, solution);
+            }
+            unsigned records = pcg.getIterations() + 1;
+
+            //One run per solve
+            auto &runs = memory->getRuns();
+            assert(runs.size() == 2 && runs[1].records.size() == records);
+            assert(runs[1].summary.solverName == pcg.getSolverName() && runs[1].records.back().residual == pcg.getExitNorm());
+
+            //One header and one row per record
+            string line;
+            vector<string> rows;
+            istringstream csvLines(csv.str());
+            while (getline(csvLines, line))
+                rows.push_back(line);
+            assert(rows.size() == 1 + 2 * records);
+            assert(rows[0] == "solver,iteration,residual,time_ms,matrix_vector_products,reductions");
+            assert(rows[1].find(pcg.getSolverName() + ",0,") == 0);
+            //The rows round trip the residuals
+            auto lastRow = rows.back();
+            for (unsigned field = 0; field < 2; field++)
+                lastRow = lastRow.substr(lastRow.find(',') + 1);
+            assert(std::stod(lastRow.substr(0, lastRow.find(','))) == pcg.getExitNorm());
+
+            //One object per solve and line
+            vector<string> objects;
+            istringstream jsonLines(json.str());
+            while (getline(jsonLines, line))
+                objects.push_back(line);
+            assert(objects.size() == 2);
+            assert(objects[0].find("{\"solver\":\"" + pcg.getSolverName() + "\",\"converged\":true,\"iterations\":"
+                                   + to_string(pcg.getIterations()) + ",") == 0);
+            assert(objects[0].find("\"records\":[{\"iteration\":0,") != string::npos);
+            assert(objects[0].substr(objects[0].size() - 3) == "}]}");
+            size_t count = 0;
+            for (size_t position = objects[0].find("{\"iteration\""); position != string::npos;
+                 position = objects[0].find("{\"iteration\"", position + 1))
+                count++;
+            assert(count == records);
+            //The borrowed stream keeps its precision
+            assert(csv.precision() == 6 && json.precision() == 6);
+            logTestEnd();
+        }
+
+        static void testQuietLegacySolvers(){
+            logTestStart("testQuietLegacySolvers");
+            unsigned n = 50;
+            auto matrix = make_shared<Array<double>>(n, n);
+            auto rhs = make_shared<vector<double>>(n, 1.0);
+            for (unsigned i = 0; i < n; i++) {
+                matrix->at(i, i) = 2;
+                if (i > 0) matrix->at(i, i - 1) = -1;
+                if (i + 1 < n) matrix->at(i, i + 1) = -1;
+            }
+            ConjugateGradientSolver solver(L2, 1E-10, 1000, true, MultiThread);
+            solver.getTelemetry()->setQuiet(true);
+            auto memory = make_shared<MemoryTelemetrySink>();
+            solver.getTelemetry()->attachSink(memory);
+            solver.getTelemetry()->attachSink(make_shared<ConsoleTelemetrySink>(1));
+            solver.setLinearSystem(make_shared<LinearSystem>(matrix, rhs));
+
+            //Nothing is written to the console in quiet mode, the sinks still receive the solve
+            ostringstream console;
+            auto consoleBuffer = cout.rdbuf(console.rdbuf());
+            solver.solve();
+            cout.rdbuf(consoleBuffer);
+            assert(console.str().empty());
+            assert(memory->getRuns().size() == 1);
+            auto &run = memory->getRuns()[0];
+            assert(run.summary.converged && run.summary.solverName == "Conjugate Gradient");
+            //CG converges in n / 2 iterations for the symmetric right hand side, one product per iteration
+            assert(run.records.size() == run.summary.iterations + 1 && run.summary.iterations <= n / 2);
+            assert(run.summary.matrixVectorProducts == run.summary.iterations + 2);
+
+            //QR iterations stop at the exit error instead of printing Q and R
+            auto symmetric = make_shared<Array<double>>(4, 4);
+            double values[4][4] = {{4, 1, 2, 3}, {1, 3, 1, 2}, {2, 1, 6, 1}, {3, 2, 1, 5}};
+            for (unsigned i = 0; i < 4; i++)
+                for (unsigned j = 0; j < 4; j++)
+                    symmetric->at(i, j) = values[i][j];
+            IterationQR qr(200, 1E-6, Householder, SingleThread, true);
+            console.str("");
+            cout.rdbuf(console.rdbuf());
+            qr.setMatrix(symmetric);
+            qr.calculateEigenvalues();
+            cout.rdbuf(consoleBuffer);
+            assert(console.str().empty());
+            auto &qrSummary = qr.getTelemetry()->getSummary();
+            assert(qrSummary.converged && qrSummary.iterations < 200 && qrSummary.exitNorm <= 1E-6);
+            auto eigenvalues = qr.getSortedEigenvalues();
+            double trace = 0;
+            for (auto eigenvalue : *eigenvalues)
+                trace += eigenvalue;
+            assert(std::abs(trace - 18) < 1E-8 && (*eigenvalues)[0] > (*eigenvalues)[3]);
+            logTestEnd();
+        }
+
+    private:
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_SOLVERTELEMETRYTEST_H
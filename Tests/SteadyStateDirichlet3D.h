@@ -10,6 +10,7 @@
 #include "../StructuredMeshGeneration/DomainBoundaryFactory.h"
 #include "../LinearAlgebra/Solvers/Direct/SolverLUP.h"
 #include "../LinearAlgebra/Solvers/Iterative/StationaryIterative/SORSolver.h"
+#include "../LinearAlgebra/Solvers/Selection/AutomaticSolver.h"
 #include "../LinearAlgebra/Solvers/Iterative/GradientBasedIterative/ConjugateGradientSolver.h"
 
 
@@ -0,0 +1,330 @@
+//
+// Created by hal9000 on 10/31/23.
+//
+
+#ifndef UNTITLED_SUPERNODALCHOLESKYTEST_H
+#define UNTITLED_SUPERNODALCHOLESKYTEST_H
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include "../LinearAlgebra/Solvers/Direct/SupernodalCholesky.h"
+#include "../LinearAlgebra/Solvers/Iterative/KrylovSubspace/PreconditionedConjugateGradient.h"
+#include "../LinearAlgebra/Solvers/Preconditioners/IncompleteCholeskyPreconditioner.h"
+#include "LinearSystemTestFixtures.h"
+
+namespace Tests {
+
+    class SupernodalCholeskyTest : public LinearSystemTestFixtures {
+    public:
+        static void runTests(){
+            testFillReducingOrderings();
+            testFactorizationAccuracy();
+            testRelaxedAmalgamation();
+            testMultipleRightHandSides();
+            testRefactorizationAndErrors();
+            testExactPreconditioner();
+            testSparseDirectReport();
+        }
+
+        static void testFillReducingOrderings(){
+            logTestStart("testFillReducingOrderings");
+            auto matrix = _layeredLaplacian(40, 40, 1, 1, 1);
+            unsigned n = matrix->numberOfRows();
+            auto csr = matrix->dataStorage->getSupplementaryDataPointers();
+            auto graph = SparsityGraph::symmetric(csr[1], csr[0], n);
+            assert(graph.degree(0) == 2 && graph.degree(41) == 4);
+            size_t naturalFill = 0;
+            for (auto ordering : {NaturalOrdering, ApproximateMinimumDegreeOrdering, NestedDissectionOrdering}) {
+                assert(FillReducingOrdering::isPermutation(FillReducingOrdering::order(graph, ordering), n));
+                SupernodalCholesky<double> cholesky(ordering);
+                cholesky.analyze(matrix);
+                assert(FillReducingOrdering::isPermutation(cholesky.getPermutation(), n));
+                if (ordering == NaturalOrdering) {
+                    //Banded factor: the 40 columns of the bandwidth below every diagonal element
+                    naturalFill = cholesky.numberOfFactorNonZeros();
+                    assert(naturalFill > 40 * (n - 40));
+                }
+                else
+                    assert(2 * cholesky.numberOfFactorNonZeros() < naturalFill);
+            }
+            //Two disconnected grids
+            auto blocks = _layeredLaplacian(20, 20, 2, 1, 1);
+            auto blockCsr = blocks->dataStorage->getSupplementaryDataPointers();
+            vector<unsigned> rowOffsets = {0}, columnIndices;
+            for (unsigned row = 0; row < 800; row++) {
+                for (unsigned k = blockCsr[1][row]; k < blockCsr[1][row + 1]; k++)
+                    if (blockCsr[0][k] / 400 == row / 400)
+                        columnIndices.push_back(blockCsr[0][k]);
+                rowOffsets.push_back(static_cast<unsigned>(columnIndices.size()));
+            }
+            auto disconnected = SparsityGraph::symmetric(rowOffsets.data(), columnIndices.data(), 800);
+            assert(FillReducingOrdering::isPermutation(FillReducingOrdering::nestedDissection(disconnected), 800));
+            logTestEnd();
+        }
+
+        static void testFactorizationAccuracy(){
+            logTestStart("testFactorizationAccuracy");
+            for (unsigned threads : {1u, 3u}) {
+                auto matrix = _layeredLaplacian(12, 12, 12, 100, threads);
+                unsigned n = matrix->numberOfRows();
+                auto rhs = _rhs(n);
+                for (auto ordering : {NaturalOrdering, ApproximateMinimumDegreeOrdering, NestedDissectionOrdering}) {
+                    SupernodalCholesky<double> cholesky(ordering);
+                    cholesky.setup(matrix);
+                    assert(cholesky.isSetUp());
+                    assert(cholesky.numberOfSupernodes() > 0 && cholesky.numberOfSupernodes() < n);
+                    NumericalVector<double> solution(n);
+                    cholesky.solve(*rhs, solution);
+                    assert(_relativeResidual(*matrix, *rhs, solution) < 1E-12);
+                }
+            }
+            logTestEnd();
+        }
+
+        static void testRelaxedAmalgamation(){
+            logTestStart("testRelaxedAmalgamation");
+            auto matrix = _layeredLaplacian(30, 30, 1, 10, 2);
+            unsigned n = matrix->numberOfRows();
+            auto rhs = _rhs(n);
+            NumericalVector<double> solutions[2] = {NumericalVector<double>(n), NumericalVector<double>(n)};
+            unsigned supernodes[2];
+            for (unsigned relaxed = 0; relaxed < 2; relaxed++) {
+                SupernodalCholesky<double> cholesky(NestedDissectionOrdering, relaxed == 0 ? 0 : 64);
+                cholesky.setup(matrix);
+                cholesky.solve(*rhs, solutions[relaxed]);
+                assert(_relativeResidual(*matrix, *rhs, solutions[relaxed]) < 1E-12);
+                supernodes[relaxed] = cholesky.numberOfSupernodes();
+                assert(std::abs(cholesky.getMeanSupernodeWidth() * supernodes[relaxed] - n) < 1E-9 * n);
+                //Fundamental supernodes store no zeros; every merge adds at most 64 of them
+                if (relaxed == 0)
+                    assert(cholesky.numberOfAmalgamationZeros() == 0);
+                else
+                    assert(cholesky.numberOfAmalgamationZeros() > 0 &&
+                           cholesky.numberOfAmalgamationZeros() <= 64 * static_cast<size_t>(supernodes[0] - supernodes[1]));
+            }
+            assert(supernodes[1] < supernodes[0]);
+            for (unsigned i = 0; i < n; i++)
+                assert(std::abs(solutions[0][i] - solutions[1][i]) < 1E-12 * (1 + std::abs(solutions[0][i])));
+            logTestEnd();
+        }
+
+        static void testMultipleRightHandSides(){
+            logTestStart("testMultipleRightHandSides");
+            auto matrix = _layeredLaplacian(30, 30, 3, 10, 3);
+            unsigned n = matrix->numberOfRows();
+            SupernodalCholesky<double> cholesky;
+            cholesky.setup(matrix);
+            vector<shared_ptr<NumericalVector<double>>> rhs, solutions;
+            for (unsigned column = 0; column < 10; column++) {
+                rhs.push_back(make_shared<NumericalVector<double>>(n));
+                for (unsigned i = 0; i < n; i++)
+                    (*rhs.back())[i] = std::cos(0.11 * (column + 1) * i);
+                solutions.push_back(make_shared<NumericalVector<double>>(n));
+            }
+            cholesky.solve(rhs, solutions);
+            for (unsigned column = 0; column < 10; column++) {
+                NumericalVector<double> single(n);
+                cholesky.solve(*rhs[column], single);
+                for (unsigned i = 0; i < n; i++)
+                    assert(std::abs(single[i] - (*solutions[column])[i]) < 1E-12);
+                assert(_relativeResidual(*matrix, *rhs[column], *solutions[column]) < 1E-12);
+            }
+            //In place solve
+            NumericalVector<double> inPlace(n);
+            std::copy(rhs[0]->getDataPointer(), rhs[0]->getDataPointer() + n, inPlace.getDataPointer());
+            cholesky.solve(inPlace, inPlace);
+            assert(_relativeResidual(*matrix, *rhs[0], inPlace) < 1E-12);
+            logTestEnd();
+        }
+
+        static void testRefactorizationAndErrors(){
+            logTestStart("testRefactorizationAndErrors");
+            auto matrix = _layeredLaplacian(10, 10, 10, 1, 2);
+            unsigned n = matrix->numberOfRows();
+            auto rhs = _rhs(n);
+            SupernodalCholesky<double> cholesky;
+            bool exceptionThrown = false;
+            try {
+                NumericalVector<double> solution(n);
+                cholesky.solve(*rhs, solution);
+            }
+            catch (const runtime_error &) {
+                exceptionThrown = true;
+            }
+            assert(exceptionThrown);
+
+            //The ordering alone gives the costs of the full analysis, but cannot be factorized
+            cholesky.analyzeOrdering(matrix);
+            auto flops = cholesky.getFactorizationFlops();
+            auto orderedNonZeros = cholesky.numberOfFactorNonZeros();
+            assert(cholesky.numberOfSupernodes() == 0 && flops > 0);
+            exceptionThrown = false;
+            try {
+                cholesky.factorize(matrix);
+            }
+            catch (const invalid_argument &) {
+                exceptionThrown = true;
+            }
+            assert(exceptionThrown);
+
+            cholesky.setup(matrix);
+            auto nonZeros = cholesky.numberOfFactorNonZeros();
+            assert(nonZeros == orderedNonZeros && cholesky.getFactorizationFlops() == flops);
+            //Same pattern with new values reuses the symbolic analysis
+            auto contrast = _layeredLaplacian(10, 10, 10, 1000, 2);
+            cholesky.factorize(contrast);
+            assert(cholesky.numberOfFactorNonZeros() == nonZeros);
+            NumericalVector<double> solution(n);
+            cholesky.solve(*rhs, solution);
+            assert(_relativeResidual(*contrast, *rhs, solution) < 1E-12);
+
+            exceptionThrown = false;
+            try {
+                cholesky.factorize(_layeredLaplacian(9, 10, 10, 1, 2));
+            }
+            catch (const invalid_argument &) {
+                exceptionThrown = true;
+            }
+            assert(exceptionThrown);
+
+            //Same size and number of non-zeros, the last coupling of row 0 moved from column 100 to 99
+            auto pattern = matrix->dataStorage->getSupplementaryDataPointers();
+            auto movedValues = make_shared<NumericalVector<double>>(pattern[1][n]);
+            auto movedColumns = make_shared<NumericalVector<unsigned>>(pattern[1][n]);
+            auto movedOffsets = make_shared<NumericalVector<unsigned>>(n + 1);
+            for (unsigned k = 0; k < pattern[1][n]; k++) {
+                (*movedValues)[k] = matrix->dataStorage->getValuesDataPointer()[k];
+                (*movedColumns)[k] = pattern[0][k];
+            }
+            for (unsigned row = 0; row <= n; row++)
+                (*movedOffsets)[row] = pattern[1][row];
+            assert((*movedColumns)[pattern[1][1] - 1] == 100);
+            (*movedColumns)[pattern[1][1] - 1] = 99;
+            auto moved = make_shared<NumericalMatrix<double>>(n, n, make_shared<CSRStorageDataProvider<double>>(
+                    movedValues, movedColumns, movedOffsets, n, n, 2));
+            exceptionThrown = false;
+            try {
+                cholesky.factorize(moved);
+            }
+            catch (const invalid_argument &) {
+                exceptionThrown = true;
+            }
+            assert(exceptionThrown);
+
+            //Indefinite: -A
+            auto csr = matrix->dataStorage->getSupplementaryDataPointers();
+            auto values = make_shared<NumericalVector<double>>(csr[1][n]);
+            auto columnIndices = make_shared<NumericalVector<unsigned>>(csr[1][n]);
+            auto rowOffsets = make_shared<NumericalVector<unsigned>>(n + 1);
+            for (unsigned k = 0; k < csr[1][n]; k++) {
+                (*values)[k] = -matrix->dataStorage->getValuesDataPointer()[k];
+                (*columnIndices)[k] = csr[0][k];
+            }
+            for (unsigned row = 0; row <= n; row++)
+                (*rowOffsets)[row] = csr[1][row];
+            auto negative = make_shared<NumericalMatrix<double>>(n, n, make_shared<CSRStorageDataProvider<double>>(
+                    values, columnIndices, rowOffsets, n, n, 2));
+            exceptionThrown = false;
+            try {
+                cholesky.factorize(negative);
+            }
+            catch (const runtime_error &) {
+                exceptionThrown = true;
+            }
+            assert(exceptionThrown);
+            assert(!cholesky.isSetUp());
+            logTestEnd();
+        }
+
+        static void testExactPreconditioner(){
+            logTestStart("testExactPreconditioner");
+            auto matrix = _layeredLaplacian(16, 16, 16, 100, 2);
+            auto rhs = _rhs(matrix->numberOfRows());
+            auto cholesky = make_shared<SupernodalCholesky<double>>(ApproximateMinimumDegreeOrdering);
+            cholesky->setup(matrix);
+            PreconditionedConjugateGradient<double> solver(1E-10, 100, true, 2);
+            solver.setPreconditioner(cholesky);
+            NumericalVector<double> solution(matrix->numberOfRows());
+            solver.solve(matrix, *rhs, solution);
+            assert(solver.hasConverged());
+            assert(solver.getIterations() <= 1);
+            logTestEnd();
+        }
+
+        static void testSparseDirectReport(){
+            logTestStart("testSparseDirectReport");
+            unsigned threads = std::min(8u, _reportThreads());
+            unsigned numberOfRightHandSides = 32;
+            cout << endl << "  Supernodal Cholesky vs PCG + IC(0) to 1E-10, " << numberOfRightHandSides
+                 << " right-hand sides, " << threads << " threads" << endl;
+            for (auto dimensions : vector<vector<unsigned>>{{250, 250, 1}, {24, 24, 24}}) {
+                auto matrix = _layeredLaplacian(dimensions[0], dimensions[1], dimensions[2], 100, threads);
+                unsigned n = matrix->numberOfRows();
+                vector<shared_ptr<NumericalVector<double>>> rhs, solutions;
+                for (unsigned column = 0; column < numberOfRightHandSides; column++) {
+                    rhs.push_back(make_shared<NumericalVector<double>>(n));
+                    for (unsigned i = 0; i < n; i++)
+                        (*rhs.back())[i] = std::sin(0.01 * (column + 1) * i) + 1;
+                    solutions.push_back(make_shared<NumericalVector<double>>(n));
+                }
+                cout << "    " << dimensions[0] << " x " << dimensions[1] << " x " << dimensions[2] << " (" << n
+                     << " unknowns, nnz(A) " << matrix->dataStorage->getSupplementaryDataPointers()[1][n] << ")" << endl;
+                for (auto ordering : {ApproximateMinimumDegreeOrdering, NestedDissectionOrdering}) {
+                    SupernodalCholesky<double> cholesky(ordering);
+                    auto start = chrono::high_resolution_clock::now();
+                    cholesky.analyze(matrix);
+                    auto analyzed = chrono::high_resolution_clock::now();
+                    cholesky.factorize(matrix);
+                    auto factorized = chrono::high_resolution_clock::now();
+                    cholesky.solve(rhs, solutions);
+                    auto solved = chrono::high_resolution_clock::now();
+                    double worstResidual = 0;
+                    for (unsigned column = 0; column < numberOfRightHandSides; column++)
+                        worstResidual = std::max(worstResidual, _relativeResidual(*matrix, *rhs[column], *solutions[column]));
+                    cout << "      " << cholesky.getName() << " : nnz(L) " << cholesky.numberOfFactorNonZeros() << ", "
+                         << cholesky.numberOfSupernodes() << " supernodes (mean width " << cholesky.getMeanSupernodeWidth()
+                         << ", " << cholesky.numberOfAmalgamationZeros() << " explicit zeros) in " << cholesky.numberOfTreeLevels()
+                         << " levels, analysis " << _milliseconds(start, analyzed) << " ms, factorization "
+                         << _milliseconds(analyzed, factorized) << " ms, solve "
+                         << _milliseconds(factorized, solved) / numberOfRightHandSides << " ms per right-hand side, "
+                         << "worst residual " << worstResidual << endl;
+                    assert(worstResidual < 1E-10);
+                }
+                auto incompleteCholesky = make_shared<IncompleteCholeskyPreconditioner<double>>();
+                auto start = chrono::high_resolution_clock::now();
+                incompleteCholesky->setup(matrix);
+                PreconditionedConjugateGradient<double> solver(1E-10, 5000, true, threads);
+                solver.setPreconditioner(incompleteCholesky);
+                unsigned iterations = 0;
+                for (unsigned column = 0; column < 4; column++) {
+                    NumericalVector<double> solution(n);
+                    solver.solve(matrix, *rhs[column], solution);
+                    iterations += solver.getIterations();
+                }
+                auto solved = chrono::high_resolution_clock::now();
+                cout << "      PCG + IC(0) : " << iterations / 4 << " iterations, " << _milliseconds(start, solved) / 4
+                     << " ms per right-hand side" << endl;
+            }
+            logTestEnd();
+        }
+
+    private:
+
+        static double _milliseconds(chrono::high_resolution_clock::time_point start,
+                                    chrono::high_resolution_clock::time_point end){
+            return chrono::duration<double, milli>(end - start).count();
+        }
+
+        static void logTestStart(const std::string& testName) {
+            std::cout << "Running " << testName << "... ";
+        }
+
+        static void logTestEnd() {
+            std::cout << "\033[1;32m[PASSED]\033[0m\n";
+        }
+    };
+
+} // Tests
+
+#endif //UNTITLED_SUPERNODALCHOLESKYTEST_H
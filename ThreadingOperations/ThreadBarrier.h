@@ -0,0 +1,49 @@
+//
+// Created by hal9000 on 10/30/23.
+//
+
+#ifndef UNTITLED_THREADBARRIER_H
+#define UNTITLED_THREADBARRIER_H
+
+#include <atomic>
+#include <thread>
+
+/**
+* @brief Reusable barrier for a fixed team of threads.
+*
+* The last thread that arrives starts a new generation and releases the others. The waiting threads spin on the
+* generation counter and yield the core after a short spin, so oversubscribed teams still make progress. Everything
+* a thread writes before wait() is visible to all the threads after it.
+*/
+class ThreadBarrier {
+public:
+    explicit ThreadBarrier(unsigned numberOfThreads) : _numberOfThreads(numberOfThreads), _arrived(0), _generation(0) { }
+
+    ThreadBarrier(const ThreadBarrier &) = delete;
+
+    ThreadBarrier &operator=(const ThreadBarrier &) = delete;
+
+    void wait() {
+        unsigned generation = _generation.load(std::memory_order_acquire);
+        if (_arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == _numberOfThreads) {
+            _arrived.store(0, std::memory_order_relaxed);
+            _generation.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        unsigned spins = 0;
+        while (_generation.load(std::memory_order_acquire) == generation)
+            if (++spins > _spinsBeforeYield)
+                std::this_thread::yield();
+    }
+
+private:
+    const unsigned _numberOfThreads;
+
+    std::atomic<unsigned> _arrived;
+
+    std::atomic<unsigned> _generation;
+
+    static constexpr unsigned _spinsBeforeYield = 2048;
+};
+
+#endif //UNTITLED_THREADBARRIER_H
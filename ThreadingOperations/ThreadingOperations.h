@@ -10,6 +10,7 @@
 #include <memory>
 #include <thread>
 #include "../LinearAlgebra/ParallelizationMethods.h"
+#include "ThreadBarrier.h"
 using namespace LinearAlgebra;
 using namespace std;
 
@@ -24,6 +25,13 @@ public:
     static void executeParallelJob(ThreadJob task, size_t size, unsigned availableThreads, unsigned cacheLineSize = 64) {
         unsigned doublesPerCacheLine = cacheLineSize / sizeof(T);
         unsigned int numThreads = std::min(availableThreads, static_cast<unsigned>(size));
+        if (size == 0)
+            return;
+        //No thread is spawned for serial jobs, e.g. the vector operations of single threaded solvers
+        if (numThreads <= 1) {
+            task(0u, static_cast<unsigned>(size));
+            return;
+        }
 
         unsigned blockSize = (size + numThreads - 1) / numThreads;
         blockSize = (blockSize + doublesPerCacheLine - 1) / doublesPerCacheLine * doublesPerCacheLine;
@@ -42,6 +50,46 @@ public:
         }
     }
 
+    /**
+    * \brief Executes a long-running task once per thread of a team that synchronizes with a shared barrier.
+    *
+    * The range [0, size) is split in the same cache line aligned blocks as executeParallelJob(), but the threads are
+    * created once and every thread runs task(threadIndex, start, end, barrier) to completion, so iterative kernels
+    * can replace a fork/join per operation with barrier.wait(). All the threads must call wait() the same number of
+    * times. With one thread the task runs on the calling thread.
+    *
+    * \return The number of threads of the team.
+    */
+    template<typename TeamJob>
+    static unsigned executeParallelTeamJob(TeamJob task, size_t size, unsigned availableThreads, unsigned cacheLineSize = 64) {
+        unsigned doublesPerCacheLine = cacheLineSize / sizeof(T);
+        unsigned int numThreads = std::max(1u, std::min(availableThreads, static_cast<unsigned>(size)));
+        unsigned blockSize = (size + numThreads - 1) / numThreads;
+        blockSize = (blockSize + doublesPerCacheLine - 1) / doublesPerCacheLine * doublesPerCacheLine;
+        //Every thread of the team must own a non-empty block, otherwise the barrier would wait for it
+        if (blockSize > 0)
+            numThreads = std::min(numThreads, static_cast<unsigned>((size + blockSize - 1) / blockSize));
+        numThreads = std::max(1u, numThreads);
+        ThreadBarrier barrier(numThreads);
+        if (numThreads == 1) {
+            task(0u, 0u, static_cast<unsigned>(size), barrier);
+            return 1;
+        }
+        vector<thread> threads;
+        for (unsigned int i = 1; i < numThreads; ++i) {
+            unsigned start = i * blockSize;
+            unsigned end = std::min(start + blockSize, static_cast<unsigned>(size));
+            threads.push_back(thread([&task, &barrier](unsigned index, unsigned start, unsigned end) {
+                task(index, start, end, barrier);
+            }, i, start, end));
+        }
+        task(0u, 0u, std::min(blockSize, static_cast<unsigned>(size)), barrier);
+        for (auto &thread: threads) {
+            thread.join();
+        }
+        return numThreads;
+    }
+
     /**
     * \brief Executes the provided task in parallel across multiple threads with a reduction step.
     * 
@@ -63,6 +111,10 @@ public:
     static T executeParallelJobWithReduction(ThreadJob task, size_t size, unsigned availableThreads, unsigned cacheLineSize = 64) {
         unsigned doublesPerCacheLine = cacheLineSize / sizeof(T);
         unsigned int numThreads = std::min(availableThreads, static_cast<unsigned>(size));
+        if (size == 0)
+            return 0;
+        if (numThreads <= 1)
+            return task(0u, static_cast<unsigned>(size));
 
         unsigned blockSize = (size + numThreads - 1) / numThreads;
         blockSize = (blockSize + doublesPerCacheLine - 1) / doublesPerCacheLine * doublesPerCacheLine;
@@ -9,6 +9,31 @@
 #include "Tests/OperationsCUDA.h"
 #include "Tests/VectorOperationsTest.h"
 #include "Tests/NumericalMatrixTest.h"
+#include "Tests/NumericalMatrixReorderingTest.h"
+#include "Tests/NumericalMatrixColoringTest.h"
+#include "Tests/NumericalMatrixIOTest.h"
+#include "Tests/CompressedIndexCSRTest.h"
+#include "Tests/NumericalMatrixSparseProductsTest.h"
+#include "Tests/ParallelAssemblyTest.h"
+#include "Tests/DIAStorageTest.h"
+#include "Tests/MergePathSpMVTest.h"
+#include "Tests/PreconditionedConjugateGradientTest.h"
+#include "Tests/IncompleteLUPreconditionerTest.h"
+#include "Tests/GeometricMultigridTest.h"
+#include "Tests/SmoothedAggregationMultigridTest.h"
+#include "Tests/NonSymmetricKrylovSolversTest.h"
+#include "Tests/PipelinedConjugateGradientTest.h"
+#include "Tests/SupernodalCholeskyTest.h"
+#include "Tests/BlockedLUTest.h"
+#include "Tests/BandedSolversTest.h"
+#include "Tests/FastPoissonSolverTest.h"
+#include "Tests/BlockKrylovTest.h"
+#include "Tests/RecycledConjugateGradientTest.h"
+#include "Tests/SolverTelemetryTest.h"
+#include "Tests/MixedPrecisionLUTest.h"
+#include "Tests/ChebyshevTest.h"
+#include "Tests/AdditiveSchwarzTest.h"
+#include "Tests/SolverSelectionTest.h"
 #include "StructuredMeshGeneration/MeshTest2D.h"
 #include "BoundaryConditions/DomainBoundaryConditions.h"
 #include "DegreesOfFreedom/DegreeOfFreedomTypes.h"
@@ -36,6 +61,31 @@ int main() {
     auto vectorTest = new NumericalVectorTest();
     vectorTest->runTests();
  Tests::NumericalMatrixTest::runTests();
+ Tests::NumericalMatrixReorderingTest::runTests();
+ Tests::NumericalMatrixColoringTest::runTests();
+ Tests::NumericalMatrixIOTest::runTests();
+ Tests::CompressedIndexCSRTest::runTests();
+ Tests::NumericalMatrixSparseProductsTest::runTests();
+ Tests::ParallelAssemblyTest::runTests();
+ Tests::DIAStorageTest::runTests();
+ Tests::MergePathSpMVTest::runTests();
+ Tests::PreconditionedConjugateGradientTest::runTests();
+ Tests::IncompleteLUPreconditionerTest::runTests();
+ Tests::GeometricMultigridTest::runTests();
+ Tests::SmoothedAggregationMultigridTest::runTests();
+ Tests::NonSymmetricKrylovSolversTest::runTests();
+ Tests::PipelinedConjugateGradientTest::runTests();
+ Tests::SupernodalCholeskyTest::runTests();
+ Tests::BlockedLUTest::runTests();
+ Tests::BandedSolversTest::runTests();
+ Tests::FastPoissonSolverTest::runTests();
+ Tests::BlockKrylovTest::runTests();
+ Tests::RecycledConjugateGradientTest::runTests();
+ Tests::SolverTelemetryTest::runTests();
+ Tests::MixedPrecisionLUTest::runTests();
+ Tests::ChebyshevTest::runTests();
+ Tests::AdditiveSchwarzTest::runTests();
+ Tests::SolverSelectionTest::runTests();
 
  
  